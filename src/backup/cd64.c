@@ -193,14 +193,14 @@ static void
 cd64_port_print_info (void)
 {
 #ifdef  USE_PPDEV
-  printf ("Using parallel port device: %s\n", ucon64.parport_dev);
+  printf ("Using parallel port device: %s\n", ucon64_settings.parport_dev);
 #elif   defined AMIGA
-  printf ("Using parallel port device: %s, port %u\n", ucon64.parport_dev, ucon64.parport);
+  printf ("Using parallel port device: %s, port %u\n", ucon64_settings.parport_dev, ucon64_settings.parport);
 #elif   defined USE_PARALLEL
   printf ("Using I/O port base: 0x%hx; I/O port Extended Control register: 0x%hx\n",
-          ucon64.parport, (unsigned short) (ucon64.parport + ucon64.ecr_offset));
+          ucon64_settings.parport, (unsigned short) (ucon64_settings.parport + ucon64_settings.ecr_offset));
 #else
-  printf ("Using I/O port base: 0x%hx\n", ucon64.parport);
+  printf ("Using I/O port base: 0x%hx\n", ucon64_settings.parport);
 #endif
 }
 
@@ -210,10 +210,10 @@ cd64_init (void)
 {
   struct cd64_t *cd64;
 #ifdef  USE_PPDEV
-  uint16_t port = strtol (&ucon64.parport_dev[strlen (ucon64.parport_dev) - 1], NULL, 10);
+  uint16_t port = strtol (&ucon64_settings.parport_dev[strlen (ucon64_settings.parport_dev) - 1], NULL, 10);
   method_t method = PPDEV;
 #else
-  uint16_t port = ucon64.parport;
+  uint16_t port = ucon64_settings.parport;
   method_t method = RAWIO;
 #endif
   int is_parallel = 1;
@@ -225,7 +225,7 @@ cd64_init (void)
     }
 
 #ifndef USE_PPDEV
-  if (ucon64.parport == (uint16_t) UCON64_UNKNOWN) // PARPORT_UNKNOWN depends on USE_PARALLEL
+  if (ucon64_settings.parport == (uint16_t) UCON64_UNKNOWN) // PARPORT_UNKNOWN depends on USE_PARALLEL
     {
       fputs ("ERROR: No port or invalid port specified\n"
              "TIP:   Specify one with " OPTION_LONG_S "port or in the configuration file\n", stderr);
@@ -245,8 +245,8 @@ cd64_init (void)
   */
   if (is_parallel)
     {
-      port = parport_open (ucon64.parport);
-      ucon64.parport_mode = parport_setup (port, ucon64.parport_mode);
+      port = parport_open (ucon64_settings.parport);
+      ucon64_settings.parport_mode = parport_setup (port, ucon64_settings.parport_mode);
       parport_close ();
     }
 #endif
@@ -266,7 +266,7 @@ cd64_init (void)
   cd64->tell_callback = ftell_wrapper;
   cd64->seek_callback = fseek_wrapper;
   cd64->progress_callback = cd64_progress;
-  strcpy (cd64->io_driver_dir, ucon64.configdir);
+  strcpy (cd64->io_driver_dir, ucon64_settings.configdir);
 
   if (!cd64->devopen (cd64))
     {
@@ -431,7 +431,7 @@ check_exit (void)
 {
   int temp;
 
-  if (ucon64.frontend)
+  if (ucon64_settings.frontend)
     return 0;
   if (!kbhit ())
     return 0;
@@ -635,7 +635,7 @@ cyan_test_copier (int test, int speed, unsigned short parport)
       printf ("                                                                          P %2d",
               count);
       fflush (stdout);
-      if (ucon64.frontend)
+      if (ucon64_settings.frontend)
         fputc ('\n', stdout);
       buffer1 = cyan_read_rom (speed, parport, NULL);
       if (!buffer1)                             // user abort
@@ -660,7 +660,7 @@ cyan_test_copier (int test, int speed, unsigned short parport)
           printf ("                                                                          P %2d",
                   count);
           fflush (stdout);
-          if (ucon64.frontend)
+          if (ucon64_settings.frontend)
             fputc ('\n', stdout);
           buffer2 = cyan_read_rom (speed, parport, buffer2);
           if (!buffer2)
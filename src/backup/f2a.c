@@ -381,7 +381,7 @@ f2a_init_usb (void)
   if (rm.data[0] == 0)
     {
       char iclientu_fname[FILENAME_MAX];
-      const char *p = get_property (ucon64.configfile, "iclientu",
+      const char *p = get_property (ucon64_settings.configfile, "iclientu",
                                     PROPERTY_MODE_FILENAME);
       size_t len;
 
@@ -421,7 +421,7 @@ f2a_connect_usb (void)
             {
               unsigned char f2afirmware[F2A_FIRM_SIZE];
               char f2afirmware_fname[FILENAME_MAX];
-              const char *p = get_property (ucon64.configfile, "f2afirmware",
+              const char *p = get_property (ucon64_settings.configfile, "f2afirmware",
                                             PROPERTY_MODE_FILENAME);
               size_t len;
 #ifdef  __linux__
@@ -462,12 +462,12 @@ f2a_connect_usb (void)
                   device_path[160 - 1] = '\0';
                   exitstatus = exec ("/sbin/fxload", 7, "-D", device_path, "-I",
                                      f2afirmware_fname, "-t", "an21",
-                                     ucon64.quiet < 0 ? "-vv" : "-v");
+                                     ucon64_settings.quiet < 0 ? "-vv" : "-v");
                   if (WEXITSTATUS (exitstatus))
                     {
                       char cmd[10 * 80];
 
-                      snprintf (cmd, 10 * 80, ucon64.quiet < 0 ?
+                      snprintf (cmd, 10 * 80, ucon64_settings.quiet < 0 ?
                                   "/sbin/fxload -D %s -I %s -t an21 -vv" :
                                   "/sbin/fxload -D %s -I %s -t an21 -v",
                                 device_path, f2afirmware_fname);
@@ -509,7 +509,7 @@ f2a_connect_usb (void)
                           else
                             w = 0;
                         }
-                      if (w && ucon64.quiet < 0)
+                      if (w && ucon64_settings.quiet < 0)
                         printf ("Wrote %d bytes (%d-%d of %d) to "EZDEV"\n",
                                 w, wrote, wrote + w, F2A_FIRM_SIZE);
                     }
@@ -593,7 +593,7 @@ f2a_info (f2a_recvmsg_t *rm)
     for (i = 0; i < (sizeof (f2a_sendmsg_t) / 4); i++)
       printf ("%-2x %08X\n", i, *(((unsigned int *) (&sm)) + i));
 
-    if (ucon64.quiet < 0)
+    if (ucon64_settings.quiet < 0)
       {
         fputs ("info:", stdout);
         for (i = 0; i < (sizeof (f2a_sendmsg_t) / 4); i++)
@@ -642,7 +642,7 @@ f2a_boot_usb (const char *ilclient_fname)
   if (usbport_read (f2a_handle, EP_READ, (char *) ack, 16 * 4, TIMEOUT) == -1)
     return -1;
 
-  if (ucon64.quiet < 0)
+  if (ucon64_settings.quiet < 0)
     {
       unsigned int i;
 
@@ -717,7 +717,7 @@ f2a_write_usb (int n_files, char **files, int address)
     {
       char loader_fname[FILENAME_MAX];
       unsigned char loader[LOADER_SIZE];
-      const char *p = get_property (ucon64.configfile, "gbaloader",
+      const char *p = get_property (ucon64_settings.configfile, "gbaloader",
                                     PROPERTY_MODE_FILENAME);
       size_t len;
 
@@ -820,7 +820,7 @@ static int
 f2a_init_par (unsigned short parport, int parport_delay)
 {
   char iclientp_fname[FILENAME_MAX], ilogo_fname[FILENAME_MAX];
-  const char *p = get_property (ucon64.configfile, "iclientp",
+  const char *p = get_property (ucon64_settings.configfile, "iclientp",
                                 PROPERTY_MODE_FILENAME);
   size_t len;
 
@@ -831,7 +831,7 @@ f2a_init_par (unsigned short parport, int parport_delay)
   len = strnlen (p, sizeof iclientp_fname - 1);
   strncpy (iclientp_fname, p, len)[len] = '\0';
 
-  p = get_property (ucon64.configfile, "ilogo", PROPERTY_MODE_FILENAME);
+  p = get_property (ucon64_settings.configfile, "ilogo", PROPERTY_MODE_FILENAME);
   if (!p)
     p = "";
   len = strnlen (p, sizeof ilogo_fname - 1);
@@ -1070,7 +1070,7 @@ f2a_write_par (int n_files, char **files, unsigned int address)
     {
       char loader_fname[FILENAME_MAX];
       unsigned char loader[LOADER_SIZE];
-      const char *p = get_property (ucon64.configfile, "gbaloader",
+      const char *p = get_property (ucon64_settings.configfile, "gbaloader",
                                     PROPERTY_MODE_FILENAME);
       size_t len;
 
@@ -1563,7 +1563,7 @@ f2a_read_rom (const char *filename, int size)
 
   starttime = time (NULL);
 #ifdef  USE_USB
-  if (ucon64.usbport)
+  if (ucon64_settings.usbport)
     {
       f2a_init_usb ();
       f2a_read_usb (0x8000000 + offset * MBIT, size * MBIT, filename);
@@ -1579,7 +1579,7 @@ f2a_read_rom (const char *filename, int size)
 #endif
 #ifdef  USE_PARALLEL
     {
-      f2a_init_par (ucon64.parport, 10);
+      f2a_init_par (ucon64_settings.parport, 10);
       f2a_read_par (0x08000000 + offset * MBIT, size * MBIT, filename);
     }
 #endif
@@ -1651,7 +1651,7 @@ f2a_write_rom (const char *filename, int size)
 
   starttime = time (NULL);
 #ifdef  USE_USB
-  if (ucon64.usbport)
+  if (ucon64_settings.usbport)
     {
       f2a_init_usb ();
       f2a_write_usb (n_files, files, 0x8000000);
@@ -1667,7 +1667,7 @@ f2a_write_rom (const char *filename, int size)
 #endif
 #ifdef  USE_PARALLEL
     {
-      f2a_init_par (ucon64.parport, 10);
+      f2a_init_par (ucon64_settings.parport, 10);
 //      f2a_erase_par (0x08000000, size * MBIT);
       f2a_write_par (n_files, files, 0x8000000);
     }
@@ -1703,7 +1703,7 @@ f2a_read_sram (const char *filename, int bank)
 
   starttime = time (NULL);
 #ifdef  USE_USB
-  if (ucon64.usbport)
+  if (ucon64_settings.usbport)
     {
       f2a_init_usb ();
       f2a_read_usb (0xe000000 + bank * 64 * 1024, size, filename);
@@ -1719,7 +1719,7 @@ f2a_read_sram (const char *filename, int bank)
 #endif
 #ifdef  USE_PARALLEL
     {
-      f2a_init_par (ucon64.parport, 10);
+      f2a_init_par (ucon64_settings.parport, 10);
       f2a_read_par (0xe000000 + bank * 64 * 1024, size, filename);
     }
 #endif
@@ -1746,7 +1746,7 @@ f2a_write_sram (const char *filename, int bank)
 
   starttime = time (NULL);
 #ifdef  USE_USB
-  if (ucon64.usbport)
+  if (ucon64_settings.usbport)
     {
       f2a_init_usb ();
       f2a_write_usb (1, files, 0xe000000 + bank * 64 * 1024);
@@ -1762,7 +1762,7 @@ f2a_write_sram (const char *filename, int bank)
 #endif
 #ifdef  USE_PARALLEL
     {
-      f2a_init_par (ucon64.parport, 10);
+      f2a_init_par (ucon64_settings.parport, 10);
 //      f2a_erase_par (0xe000000, size * MBIT);
       f2a_write_par (1, files, 0xe000000 + bank * 64 * 1024);
     }
@@ -561,7 +561,7 @@ LinkerInit (void)               // 4027c4
   if (!linker_found)
     {
       // Look for linker in SPP mode.
-      ucon64.parport_mode = parport_setup (SPPDataPort, PPMODE_SPP);
+      ucon64_settings.parport_mode = parport_setup (SPPDataPort, PPMODE_SPP);
 
       EPPMode = 0;
       if (LookForLinker ())
@@ -1542,7 +1542,7 @@ fal_args (unsigned int parport)
   sprintf (parport_str, "%u", parport); // don't use %x, as Jeff Frohwein uses atoi()
   fal_argv[fal_argc++] = parport_str;
 
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     fal_argv[fal_argc++] = "-m";
 }
 
@@ -308,7 +308,7 @@ ffe_wait_for_ready (void)
 void
 ffe_checkabort (int status)
 {
-  if ((!ucon64.frontend ? kbhit () : 0) && getch () == 'q')
+  if ((!ucon64_settings.frontend ? kbhit () : 0) && getch () == 'q')
     {
 //      ffe_send_command (5, 0, 0);               // VGS: when sending/receiving a SNES ROM
       puts ("\nProgram aborted");
@@ -373,7 +373,7 @@ fig_read_rom (const char *filename, unsigned short parport)
   memset (&rominfo, 0, sizeof (st_ucon64_nfo_t));
 
   fflush (file);
-  snes_init (&rominfo);
+  snes_init (&ucon64, &rominfo);
   snes_set_fig_header ((st_fig_header_t *) buffer, rominfo.backup_header_len);
   fseek (file, 0, SEEK_SET);
   fwrite (buffer, 1, FIG_HEADER_LEN, file);     // write correct header
@@ -414,7 +414,7 @@ fig_write_rom (const char *filename, unsigned short parport)
   ffe_send_command0 (0xc008, 0);
   fread_checked (buffer, 1, FIG_HEADER_LEN, file);
 
-  if (snes_get_copier_type () == SWC)
+  if (snes_get_copier_type (&ucon64) == SWC)
     handle_swc_header (buffer);
   emu_mode_select = buffer[2];                  // this byte is needed later
 
@@ -422,7 +422,7 @@ fig_write_rom (const char *filename, unsigned short parport)
   ffe_send_block (0x400, buffer, FIG_HEADER_LEN); // send header
   bytessent = FIG_HEADER_LEN;
 
-  hirom = snes_get_snes_hirom ();
+  hirom = snes_get_snes_hirom (&ucon64);
   if (hirom)
     ffe_send_command0 (0xe00f, 0);              // seems to enable HiROM mode,
                                                 //  value doesn't seem to matter
@@ -231,7 +231,7 @@ static void
 set_ai (unsigned char ai)
 {
   set_data_write
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     spp_set_ai (ai);
   else
     epp_set_ai (ai);
@@ -241,7 +241,7 @@ set_ai (unsigned char ai)
 static void
 set_ai_data (unsigned char ai, unsigned char data)
 {
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     spp_set_ai_data (ai, data);                 // SPP mode
   else
     epp_set_ai_data (ai, data);                 // EPP mode
@@ -251,7 +251,7 @@ set_ai_data (unsigned char ai, unsigned char data)
 static void
 write_data (unsigned char data)
 {
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     spp_write_data (data);                      // SPP write data
   else
     outportb (port_c, data);                    // EPP write data
@@ -261,7 +261,7 @@ write_data (unsigned char data)
 static unsigned char
 read_data (void)
 {
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     return spp_read_data ();                    // SPP read data
   else
     return inportb (port_c);                    // EPP read data
@@ -495,7 +495,7 @@ wait_status (void)
 
   while ((temp & 0xfc) != 0x80)
     {
-      if ((temp & 0x20) == 0x20 && ucon64.parport_mode != PPMODE_EPP)
+      if ((temp & 0x20) == 0x20 && ucon64_settings.parport_mode != PPMODE_EPP)
         {
           fputs ("\nERROR: Erase failed\n", stderr);
           return -1;
@@ -1340,7 +1340,7 @@ check_port (void)
 {
   if (check_port_mode ())
     {
-      ucon64.parport_mode = parport_setup (port_8, PPMODE_SPP);
+      ucon64_settings.parport_mode = parport_setup (port_8, PPMODE_SPP);
       if (check_port_mode ())
         return 1;
       else
@@ -1348,7 +1348,7 @@ check_port (void)
     }
 
   // If we get here, a GBX was detected
-  if (ucon64.parport_mode == PPMODE_EPP)
+  if (ucon64_settings.parport_mode == PPMODE_EPP)
     puts ("GBX found. EPP found");
   else
     puts ("GBX found. EPP not found or not enabled - SPP used");
@@ -164,7 +164,7 @@ init_io (unsigned short port)
 
   parport_print_info ();
 
-  gd6_send_byte_delay = get_property_int (ucon64.configfile, "gd6_send_byte_delay");
+  gd6_send_byte_delay = get_property_int (ucon64_settings.configfile, "gd6_send_byte_delay");
 }
 
 
@@ -195,7 +195,7 @@ io_error (const char *func_name)
 static void
 gd_checkabort (int status)
 {
-  if ((!ucon64.frontend ? kbhit () : 0) && getch () == 'q')
+  if ((!ucon64_settings.frontend ? kbhit () : 0) && getch () == 'q')
     {
       puts ("\nProgram aborted");
       exit (status);
@@ -803,7 +803,7 @@ gd_write_rom (const char *filename, unsigned short parport, st_ucon64_nfo_t *rom
   char *names[GD3_MAX_UNITS], names_mem[GD3_MAX_UNITS][12] = { { 0 } },
        *filenames[GD3_MAX_UNITS], dir[FILENAME_MAX];
   unsigned int part_sizes[GD3_MAX_UNITS], num_units, i,
-               hirom = snes_get_snes_hirom (), filename_len,
+               hirom = snes_get_snes_hirom (&ucon64), filename_len,
                gd6_protocol = !memcmp (prolog_str, GD6_READ_PROLOG_STRING, 4);
   st_add_filename_data_t add_filename_data = { 0, NULL };
 
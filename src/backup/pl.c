@@ -122,7 +122,7 @@ static void
 write_data (unsigned char data)
 {
   ai_value[current_ai] = data;
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     spp_write_data (data);
   else
     epp_write_data (data);
@@ -154,7 +154,7 @@ spp_read_data (void)
 static unsigned char
 read_data (void)
 {
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     return spp_read_data ();
   else
     return epp_read_data ();
@@ -182,7 +182,7 @@ spp_set_ai (unsigned char ai)
 static void
 set_ai (unsigned char ai)
 {
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     spp_set_ai (ai);
   else
     epp_set_ai (ai);
@@ -208,7 +208,7 @@ spp_set_ai_data (unsigned char ai, unsigned char data)
 static void
 set_ai_data (unsigned char ai, unsigned char data)
 {
-  if (ucon64.parport_mode != PPMODE_EPP)
+  if (ucon64_settings.parport_mode != PPMODE_EPP)
     spp_set_ai_data (ai, data);
   else
     epp_set_ai_data (ai, data);
@@ -477,7 +477,7 @@ init_io (unsigned short port)
 
   if (!detect_linker ())
     {
-      ucon64.parport_mode = parport_setup (port_8, PPMODE_SPP);
+      ucon64_settings.parport_mode = parport_setup (port_8, PPMODE_SPP);
       if (!detect_linker ())
         {
           fputs ("ERROR: Pocket Linker not found or not turned on\n", stderr);
@@ -487,7 +487,7 @@ init_io (unsigned short port)
     }
 
   // If we get here, a Pocket Linker was detected
-  if (ucon64.parport_mode == PPMODE_EPP)
+  if (ucon64_settings.parport_mode == PPMODE_EPP)
     puts ("Pocket Linker found. EPP found");
   else
     puts ("Pocket Linker found. EPP not found or not enabled - SPP used");
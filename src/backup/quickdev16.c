@@ -93,7 +93,7 @@ const st_getopt2_t quickdev16_usage[] =
 static int
 check_quit (void)
 {
-  return (!ucon64.frontend ? kbhit () : 0) && getch () == 'q';
+  return (!ucon64_settings.frontend ? kbhit () : 0) && getch () == 'q';
 }
 
 
@@ -156,7 +156,7 @@ quickdev16_write_rom (const char *filename)
       exit (1);
     }
 
-  if (snes_get_snes_hirom ())
+  if (snes_get_snes_hirom (&ucon64))
     {
       bank_shift = SNES_HIROM_SHIFT;
       bank_size = 1 << SNES_HIROM_SHIFT;
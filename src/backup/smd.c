@@ -33,6 +33,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "misc/archive.h"
 #include "misc/file.h"
 #include "misc/misc.h"
+#include "misc/xform.h"
 #include "ucon64.h"
 #include "ucon64_misc.h"
 #include "backup/ffe.h"
@@ -77,17 +78,15 @@ void
 smd_interleave (unsigned char *buffer, size_t size)
 // Convert binary data to the SMD interleaved format
 {
-  size_t count, offset;
+  size_t count;
   unsigned char block[16384];
 
   for (count = 0; count < size / 16384; count++)
     {
-      memcpy (block, &buffer[count * 16384], 16384);
-      for (offset = 0; offset < 8192; offset++)
-        {
-          buffer[(count * 16384) + 8192 + offset] = block[offset << 1];
-          buffer[(count * 16384) + offset] = block[(offset << 1) + 1];
-        }
+      unsigned char *p = buffer + count * 16384;
+
+      memcpy (block, p, 16384);
+      mem_split16 (p + 8192, p, block, 16384);
     }
 }
 
@@ -95,17 +94,15 @@ smd_interleave (unsigned char *buffer, size_t size)
 void
 smd_deinterleave (unsigned char *buffer, size_t size)
 {
-  size_t count, offset;
+  size_t count;
   unsigned char block[16384];
 
   for (count = 0; count < size / 16384; count++)
     {
-      memcpy (block, &buffer[count * 16384], 16384);
-      for (offset = 0; offset < 8192; offset++)
-        {
-          buffer[(count * 16384) + (offset << 1)] = block[offset + 8192];
-          buffer[(count * 16384) + (offset << 1) + 1] = block[offset];
-        }
+      unsigned char *p = buffer + count * 16384;
+
+      memcpy (block, p, 16384);
+      mem_merge16 (p, block + 8192, block, 16384);
     }
 }
 
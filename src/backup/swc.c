@@ -862,7 +862,7 @@ swc_write_rom (const char *filename, unsigned short parport, unsigned short enab
   ffe_send_command0 (0xc008, 0);
   fread_checked (buffer, 1, SWC_HEADER_LEN, file);
 
-  if (snes_get_copier_type () == FIG)
+  if (snes_get_copier_type (&ucon64) == FIG)
     handle_fig_header (buffer);
 #if 1
   /*
@@ -121,7 +121,7 @@ send_data (usb_dev_handle *handle, int interface_number,
 static int
 check_quit (void)
 {
-  return (!ucon64.frontend ? kbhit () : 0) && getch () == 'q';
+  return (!ucon64_settings.frontend ? kbhit () : 0) && getch () == 'q';
 }
 
 
@@ -78,7 +78,14 @@ typedef struct
 #pragma warning(pop)
 #endif
 
-static st_atari_rominfo_t atari_rominfo;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_atari_rominfo_t info;
+  char backup_usage[80];
+} st_atari_data_t;
+#define atari_data(p) ((st_atari_data_t *) \
+  ucon64_console_data (p, UCON64_ATA, sizeof (st_atari_data_t)))
 
 enum
 {
@@ -318,13 +325,13 @@ is_probably_3f (const unsigned char *image, unsigned int size)
 
 
 int
-atari_init (st_ucon64_nfo_t * rominfo)
+atari_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_atari_data_t *cd = atari_data (p);
   int bsmode;
-  unsigned int i, size = (unsigned int) ucon64.fsize, crc32;
-  static char backup_usage[80];
+  unsigned int i, size = (unsigned int) p->fsize, crc32 = 0;
   unsigned char image[ATARI_ROM_SIZE], buffer[0x200];
-  char md5[32];
+  char md5[33];
 
   if (size > ATARI_ROM_SIZE)
     return -1;
@@ -334,8 +341,8 @@ atari_init (st_ucon64_nfo_t * rominfo)
       size != 0x8000 && size != 0x10000 && size != 0x20000)
     return -1;
 
-  ucon64_fread (image, 0, size, ucon64.fname);
-  ucon64_chksum (NULL, md5, &crc32, ucon64.fname, size, 0);
+  ucon64_fread (image, 0, size, p->fname);
+  ucon64_chksum (NULL, md5, NULL, &crc32, p->fname, size, 0, p->settings->chksum_flags);
 
   bsmode = get_game_bsmode_by_crc (crc32);
   if (bsmode == -1)
@@ -395,51 +402,51 @@ atari_init (st_ucon64_nfo_t * rominfo)
     {
       st_atari_bsmode_t *bsmode_data;
 
-      memset (&atari_rominfo, 0, sizeof (st_atari_rominfo_t));
+      memset (&cd->info, 0, sizeof (st_atari_rominfo_t));
 
-      atari_rominfo.bsm = bsmode;
+      cd->info.bsm = bsmode;
 
       // set game_page_count and empty_page[]
       for (i = 0; i < size / 0x100; i++)
         {
           unsigned int j;
 
-          ucon64_fread (buffer, i * 0x100, 0x100, ucon64.fname);
-          atari_rominfo.empty_page[i] = 1;
+          ucon64_fread (buffer, i * 0x100, 0x100, p->fname);
+          cd->info.empty_page[i] = 1;
 
           for (j = 0; j < 0x100 - 1; j++)
             if (buffer[j] != buffer[j + 1])
               {
-                atari_rominfo.empty_page[i] = 0;
-                atari_rominfo.game_page_count++;
+                cd->info.empty_page[i] = 0;
+                cd->info.game_page_count++;
                 break;
               }
         }
 
-      atari_rominfo.speed_hi = (unsigned char) (atari_rominfo.game_page_count / 21 + 1);
-      atari_rominfo.speed_low = (unsigned char) (atari_rominfo.game_page_count *
-                                0x100 / 21 - (atari_rominfo.speed_hi - 1) * 0x100);
+      cd->info.speed_hi = (unsigned char) (cd->info.game_page_count / 21 + 1);
+      cd->info.speed_low = (unsigned char) (cd->info.game_page_count *
+                                0x100 / 21 - (cd->info.speed_hi - 1) * 0x100);
 
-      bsmode_data = get_bsmode_by_id (atari_rominfo.bsm);
+      bsmode_data = get_bsmode_by_id (cd->info.bsm);
       if (bsmode_data)
         {
-          atari_rominfo.ctrl_byte = bsmode_data->ctrl_byte;
+          cd->info.ctrl_byte = bsmode_data->ctrl_byte;
 
           // the first two bytes of data indicate the beginning address of the code
-          if (atari_rominfo.bsm != BSM_3F)
+          if (cd->info.bsm != BSM_3F)
             {
-              ucon64_fread (buffer, bsmode_data->start_page * 0x100, 0x100, ucon64.fname);
-              atari_rominfo.start_low = buffer[0xfc];
-              atari_rominfo.start_hi = buffer[0xfd];
+              ucon64_fread (buffer, bsmode_data->start_page * 0x100, 0x100, p->fname);
+              cd->info.start_low = buffer[0xfc];
+              cd->info.start_hi = buffer[0xfd];
             }
         }
 
       rominfo->console_usage = atari_usage[0].help;
       // "Cuttle Card (2)/Starpath) Supercharger/YOKO backup unit"
-      snprintf (backup_usage, 80, "%s/%s/%s", cc2_usage[0].help,
+      snprintf (cd->backup_usage, 80, "%s/%s/%s", cc2_usage[0].help,
                 spsc_usage[0].help, yoko_usage[0].help);
-      backup_usage[80 - 1] = '\0';
-      rominfo->backup_usage = backup_usage;
+      cd->backup_usage[80 - 1] = '\0';
+      rominfo->backup_usage = cd->backup_usage;
 
       {
         char *bankswitch_type;
@@ -464,13 +471,13 @@ atari_init (st_ucon64_nfo_t * rominfo)
                  "Blank pages: %u\n"
                  "Start page: %u",
                  bankswitch_type,
-                 atari_rominfo.start_hi,
-                 atari_rominfo.start_low,
-                 atari_rominfo.speed_hi,
-                 atari_rominfo.speed_low,
-                 atari_rominfo.ctrl_byte,
-                 atari_rominfo.game_page_count,
-                 size / 0x100 - atari_rominfo.game_page_count,
+                 cd->info.start_hi,
+                 cd->info.start_low,
+                 cd->info.speed_hi,
+                 cd->info.speed_low,
+                 cd->info.ctrl_byte,
+                 cd->info.game_page_count,
+                 size / 0x100 - cd->info.game_page_count,
                  (unsigned int) start_page);
       }
       return 0;
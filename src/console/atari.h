@@ -33,7 +33,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 extern const st_getopt2_t atari_usage[];
 
-extern int atari_init (st_ucon64_nfo_t *rominfo);
+extern int atari_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 #ifdef  USE_LIB_MATH
 extern int atari_cc2 (const char *filename, int bsm);
 #endif
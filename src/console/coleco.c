@@ -105,48 +105,56 @@ typedef struct st_coleco_header
 #define COLECO_HEADER_START 0
 #define COLECO_HEADER_LEN (sizeof (st_coleco_header_t))
 
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_coleco_header_t header;
+} st_coleco_data_t;
+#define coleco_data(p) ((st_coleco_data_t *) \
+  ucon64_console_data (p, UCON64_COLECO, sizeof (st_coleco_data_t)))
+
 
 int
-coleco_init (st_ucon64_nfo_t *rominfo)
+coleco_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_coleco_data_t *cd = coleco_data (p);
   int result = -1;
-  static st_coleco_header_t coleco_header;
 
-  coleco_header.type = 0;
+  cd->header.type = 0;
   rominfo->console_usage = coleco_usage[0].help;
   rominfo->backup_usage = unknown_backup_usage[0].help;
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  ucon64_fread (&coleco_header, ucon64.backup_header_len, COLECO_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->header, p->backup_header_len, COLECO_HEADER_LEN, p->fname);
 
-  if (coleco_header.type == 0xaa55 ||           // Coleco
-      coleco_header.type == 0x55aa)             // ColecoVision
+  if (cd->header.type == 0xaa55 ||              // Coleco
+      cd->header.type == 0x55aa)                // ColecoVision
     result = 0;
   else
     result = -1;
-  if (ucon64.fsize > 1024 * 1024)
+  if (p->fsize > 1024 * 1024)
     result = -1;
 
-  if (ucon64.console == UCON64_COLECO)
+  if (p->console == UCON64_COLECO)
     result = 0;
 
-  if (coleco_header.type == 0xaa55 || coleco_header.type == 0x55aa)
+  if (cd->header.type == 0xaa55 || cd->header.type == 0x55aa)
     {
       rominfo->header_start = COLECO_HEADER_START;
       rominfo->header_len = COLECO_HEADER_LEN;
-      rominfo->header = &coleco_header;
+      rominfo->header = &cd->header;
 
       // internal ROM name
-      strcpy (rominfo->name, coleco_header.name);
+      strcpy (rominfo->name, cd->header.name);
 
       // misc stuff
       sprintf (rominfo->misc,
                "Start address: %04x\n"
                "Type: %s",
-               coleco_header.start,
-               coleco_header.type == 0xaa55 ? "Coleco" : "ColecoVision");
+               cd->header.start,
+               cd->header.type == 0xaa55 ? "Coleco" : "ColecoVision");
     }
 
   return result;
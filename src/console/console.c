@@ -36,12 +36,12 @@ const st_getopt2_t unknown_console_usage[] =
 
 
 int
-unknown_console_init (st_ucon64_nfo_t *rominfo)
+unknown_console_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
-  ucon64.nfo = rominfo;
-  ucon64.dat = NULL;
+  p->nfo = rominfo;
+  p->dat = NULL;
 #ifdef  USE_DISCMAGE
-  ucon64.image = NULL;
+  p->image = NULL;
 #endif
 
   return 0;
@@ -30,7 +30,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 extern const st_getopt2_t unknown_console_usage[];
 
-extern int unknown_console_init (st_ucon64_nfo_t *rominfo);
+extern int unknown_console_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 
 
 /*
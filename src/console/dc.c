@@ -285,10 +285,11 @@ static const uint8_t nstrsave_bin[1024] = {
 
 
 int
-dc_init (st_ucon64_nfo_t *rominfo)
+dc_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   int result = -1;
 
+  (void) p;
   rominfo->console_usage = dc_usage[0].help;
 
   return result;
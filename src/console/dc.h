@@ -27,7 +27,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 extern const st_getopt2_t dc_usage[];
 
-extern int dc_init (st_ucon64_nfo_t *rominfo);
+extern int dc_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int dc_parse (const char *template_file);
 extern int dc_mkip (void);
 extern int dc_scramble (void);
@@ -155,7 +155,6 @@ typedef struct st_gb_header
   unsigned char checksum_low;                   // 0x4f
 } st_gb_header_t;
 
-static st_gb_header_t gb_header;
 const unsigned char gb_logodata[] =             // NOTE: not a static variable
   {
     0xce, 0xed, 0x66, 0x66, 0xcc, 0x0d, 0x00, 0x0b,
@@ -188,20 +187,29 @@ typedef struct st_gb_chksum
 #pragma warning(pop)
 #endif
 
-static st_gb_chksum_t checksum;
-static st_gb_chksum_t gb_chksum (st_ucon64_nfo_t *rominfo);
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_gb_header_t header;
+  st_gb_chksum_t checksum;                      // calculated by gb_chksum()
+} st_gb_data_t;
+#define gb_data(p) ((st_gb_data_t *) \
+  ucon64_console_data (p, UCON64_GB, sizeof (st_gb_data_t)))
+
+static st_gb_chksum_t gb_chksum (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 
 
 int
 gb_logo (st_ucon64_nfo_t *rominfo)
 {
+  st_gb_data_t *cd = gb_data (&ucon64);
   char dest_name[FILENAME_MAX];
 
   strcpy (dest_name, ucon64.fname);
   ucon64_file_handler (dest_name, NULL, 0);
   fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb");
   ucon64_fwrite ((unsigned char *)
-                   ((gb_header.rom_type >= 0x97 && gb_header.rom_type <= 0x99) ?
+                   (cd->header.rom_type >= 0x97 && cd->header.rom_type <= 0x99 ?
                      rocket_logodata : gb_logodata),
                  rominfo->backup_header_len + GB_HEADER_START + 4,
                  GB_LOGODATA_LEN, dest_name, "r+b");
@@ -389,9 +397,10 @@ gb_sgb (st_ucon64_nfo_t *rominfo)
 int
 gb_n (st_ucon64_nfo_t *rominfo, const char *name)
 {
+  st_gb_data_t *cd = gb_data (&ucon64);
   char buf[GB_NAME_LEN + 1], dest_name[FILENAME_MAX];
   int gb_name_len =
-    (gb_header.gb_type == 0x80 || gb_header.gb_type == 0xc0) ?
+    (cd->header.gb_type == 0x80 || cd->header.gb_type == 0xc0) ?
       GB_NAME_LEN : GB_NAME_LEN + 1;
 
   strncpy (buf, name, gb_name_len);
@@ -409,13 +418,14 @@ gb_n (st_ucon64_nfo_t *rominfo, const char *name)
 int
 gb_chk (st_ucon64_nfo_t *rominfo)
 {
+  st_gb_data_t *cd = gb_data (&ucon64);
   char buf[4], dest_name[FILENAME_MAX];
 
   strcpy (dest_name, ucon64.fname);
   ucon64_file_handler (dest_name, NULL, 0);
   fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb");
 
-  buf[0] = checksum.header;
+  buf[0] = cd->checksum.header;
   buf[1] = (char) (rominfo->current_internal_crc >> 8);
   buf[2] = (char) rominfo->current_internal_crc;
   ucon64_fwrite (buf, rominfo->backup_header_len + GB_HEADER_START + 0x4d, 3,
@@ -639,8 +649,8 @@ gb_gp2bmp (void)
                           ((unsigned int) (gp_data[n + 1] << 8) | gp_data[n]) ==
                             (m & 0xffff) ?
 #ifdef  USE_ANSI_COLOR
-                            ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                            ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
+                            ucon64_settings.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                            ucon64_settings.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
 #else
                             "OK" : "Bad");
 #endif
@@ -668,58 +678,59 @@ gb_gp2bmp (void)
 
 
 int
-gb_init (st_ucon64_nfo_t *rominfo)
+gb_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_gb_data_t *cd = gb_data (p);
   int result = -1, value, x;
   unsigned int pos = (unsigned int) strlen (rominfo->misc);
   const char *str;
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  if (ucon64.fsize < rominfo->backup_header_len + GB_HEADER_START + GB_HEADER_LEN)
+  if (p->fsize < rominfo->backup_header_len + GB_HEADER_START + GB_HEADER_LEN)
     return -1;                                  // Don't continue if it makes no sense
 
-  ucon64_fread (&gb_header, rominfo->backup_header_len + GB_HEADER_START,
-                GB_HEADER_LEN, ucon64.fname);
-  if (gb_header.opcode1 == 0x00 && gb_header.opcode2 == 0xc3)
+  ucon64_fread (&cd->header, rominfo->backup_header_len + GB_HEADER_START,
+                GB_HEADER_LEN, p->fname);
+  if (cd->header.opcode1 == 0x00 && cd->header.opcode2 == 0xc3)
     result = 0;
   else
     {
-      rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                     ucon64.backup_header_len : SSC_HEADER_LEN;
+      rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                     p->backup_header_len : SSC_HEADER_LEN;
 
-      ucon64_fread (&gb_header, rominfo->backup_header_len + GB_HEADER_START,
-                    GB_HEADER_LEN, ucon64.fname);
-      if (gb_header.opcode1 == 0x00 && gb_header.opcode2 == 0xc3)
+      ucon64_fread (&cd->header, rominfo->backup_header_len + GB_HEADER_START,
+                    GB_HEADER_LEN, p->fname);
+      if (cd->header.opcode1 == 0x00 && cd->header.opcode2 == 0xc3)
         result = 0;
       else
         result = -1;
     }
-  if (ucon64.console == UCON64_GB)
+  if (p->console == UCON64_GB)
     result = 0;
 
   rominfo->header_start = GB_HEADER_START;
   rominfo->header_len = GB_HEADER_LEN;
-  rominfo->header = &gb_header;
+  rominfo->header = &cd->header;
 
   // internal ROM name
-  x = (gb_header.gb_type == 0x80 || gb_header.gb_type == 0xc0) ?
+  x = (cd->header.gb_type == 0x80 || cd->header.gb_type == 0xc0) ?
          GB_NAME_LEN : GB_NAME_LEN + 1;
-  strncpy (rominfo->name, (char *) gb_header.name, x);
+  strncpy (rominfo->name, (char *) cd->header.name, x);
   rominfo->name[x] = '\0';                      // terminate string
 
   // ROM maker
-  if (gb_header.maker == 0x33)
+  if (cd->header.maker == 0x33)
     {
-      int ih = gb_header.maker_high <= '9' ?
-                 gb_header.maker_high - '0' : gb_header.maker_high - 'A' + 10,
-          il = gb_header.maker_low <= '9' ?
-                 gb_header.maker_low - '0' : gb_header.maker_low - 'A' + 10;
+      int ih = cd->header.maker_high <= '9' ?
+                 cd->header.maker_high - '0' : cd->header.maker_high - 'A' + 10,
+          il = cd->header.maker_low <= '9' ?
+                 cd->header.maker_low - '0' : cd->header.maker_low - 'A' + 10;
       x = ih * 36 + il;
     }
   else
-    x = (gb_header.maker >> 4) * 36 + (gb_header.maker & 0x0f);
+    x = (cd->header.maker >> 4) * 36 + (cd->header.maker & 0x0f);
 
   /*
     I added the first if statement, because I didn't want to expand
@@ -734,14 +745,14 @@ gb_init (st_ucon64_nfo_t *rominfo)
   rominfo->maker = NULL_TO_UNKNOWN_S (nintendo_maker[x]);
 
   // ROM country
-  rominfo->country = gb_header.country == 0 ? "Japan" : "U.S.A. & Europe";
+  rominfo->country = cd->header.country == 0 ? "Japan" : "U.S.A. & Europe";
 
   // misc stuff
-  // don't move division by 4 to shift parameter (gb_header.rom_size can be < 2)
+  // don't move division by 4 to shift parameter (header.rom_size can be < 2)
   pos += sprintf (rominfo->misc + pos, "Internal size: %.4f Mb\n",
-                  (1 << gb_header.rom_size) / 4.0f);
+                  (1 << cd->header.rom_size) / 4.0f);
 
-  if (gb_header.rom_type <= 0x1f)
+  if (cd->header.rom_type <= 0x1f)
     {
       const char *gb_romtype1[0x20] =
         {
@@ -778,9 +789,9 @@ gb_init (st_ucon64_nfo_t *rominfo)
           "ROM + MBC5 + SRAM + Battery + Rumble",
           "Nintendo Pocket Camera"
         };
-      str = NULL_TO_UNKNOWN_S (gb_romtype1[gb_header.rom_type]);
+      str = NULL_TO_UNKNOWN_S (gb_romtype1[cd->header.rom_type]);
     }
-  else if (gb_header.rom_type >= 0x97 && gb_header.rom_type <= 0x99)
+  else if (cd->header.rom_type >= 0x97 && cd->header.rom_type <= 0x99)
     {
       const char *gb_romtype2[3] =
         {
@@ -788,9 +799,9 @@ gb_init (st_ucon64_nfo_t *rominfo)
           NULL,
           "Rocket Games 2-in-1"
         };
-      str = NULL_TO_UNKNOWN_S (gb_romtype2[gb_header.rom_type - 0x97]);
+      str = NULL_TO_UNKNOWN_S (gb_romtype2[cd->header.rom_type - 0x97]);
     }
-  else if (gb_header.rom_type >= 0xfd)
+  else if (cd->header.rom_type >= 0xfd)
     {
       const char *gb_romtype3[3] =
         {
@@ -798,80 +809,80 @@ gb_init (st_ucon64_nfo_t *rominfo)
           "Hudson HuC-3",
           "Hudson HuC-1"
         };
-      str = gb_romtype3[gb_header.rom_type - 0xfd];
+      str = gb_romtype3[cd->header.rom_type - 0xfd];
     }
   else
     str = "Unknown";
   pos += sprintf (rominfo->misc + pos, "ROM type: %s\n", str);
 
-  if (!gb_header.sram_size)
+  if (!cd->header.sram_size)
     pos += sprintf (rominfo->misc + pos, "Save RAM: No\n");
   else
     {
-      value = (gb_header.sram_size & 7) << 1; // 0/1/2/4/5
+      value = (cd->header.sram_size & 7) << 1; // 0/1/2/4/5
       if (value)
         value = 1 << (value - 1);
 
       pos += sprintf (rominfo->misc + pos, "Save RAM: Yes, %d kBytes\n", value);
     }
 
-  pos += sprintf (rominfo->misc + pos, "Version: 1.%u\n", gb_header.version);
+  pos += sprintf (rominfo->misc + pos, "Version: 1.%u\n", cd->header.version);
 
-  if (gb_header.gb_type == 0x80)
+  if (cd->header.gb_type == 0x80)
     {
-      if (gb_header.sgb_features == 3)
+      if (cd->header.sgb_features == 3)
         str = "Game Boy/Super Game Boy (SGB features present)/Game Boy Color";
       else
         str = "Game Boy/Super Game Boy/Game Boy Color";
     }
-  else if (gb_header.gb_type == 0xc0)
+  else if (cd->header.gb_type == 0xc0)
     str = "Game Boy Color";                     // GBC _only_
   else
     {
-      if (gb_header.sgb_features == 3)
+      if (cd->header.sgb_features == 3)
         str = "Game Boy/Super Game Boy (SGB features present)";
       else
         str = "Game Boy/Super Game Boy";
     }
   pos += sprintf (rominfo->misc + pos, "Game type: %s\n", str);
 
-  value = gb_header.start_high << 8;
-  value += gb_header.start_low;
+  value = cd->header.start_high << 8;
+  value += cd->header.start_low;
   pos += sprintf (rominfo->misc + pos, "Start address: 0x%04x\n", value);
 
   sprintf (rominfo->misc + pos, "Logo data: %s",
-           memcmp (gb_header.logo,
-                   (gb_header.rom_type >= 0x97 && gb_header.rom_type <= 0x99) ?
+           memcmp (cd->header.logo,
+                   cd->header.rom_type >= 0x97 && cd->header.rom_type <= 0x99 ?
                      rocket_logodata : gb_logodata,
                    GB_LOGODATA_LEN) == 0 ?
 #ifdef  USE_ANSI_COLOR
-             ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-             ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
+             p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+             p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
 #else
              "OK" : "Bad");
 #endif
 
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
       rominfo->has_internal_crc = 1;
       rominfo->internal_crc_len = 2;
-      checksum = gb_chksum (rominfo);
-      rominfo->current_internal_crc = checksum.value;
+      cd->checksum = gb_chksum (p, rominfo);
+      rominfo->current_internal_crc = cd->checksum.value;
 
-      rominfo->internal_crc = (gb_header.checksum_high << 8) +
-                              gb_header.checksum_low;
+      rominfo->internal_crc = (cd->header.checksum_high << 8) +
+                              cd->header.checksum_low;
 
-      x = gb_header.header_checksum;
+      x = cd->header.header_checksum;
       sprintf (rominfo->internal_crc2,
                "Header checksum: %s, 0x%02x (calculated) %c= 0x%02x (internal)",
-               checksum.header == x ?
+               cd->checksum.header == x ?
 #ifdef  USE_ANSI_COLOR
-                 ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                 ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
+                 p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                 p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
 #else
                  "OK" : "Bad",
 #endif
-               checksum.header, checksum.header == x ? '=' : '!', x);
+               cd->checksum.header, cd->checksum.header == x ? '=' : '!', x);
     }
 
   rominfo->console_usage = gb_usage[0].help;
@@ -882,10 +893,10 @@ gb_init (st_ucon64_nfo_t *rominfo)
 
 
 st_gb_chksum_t
-gb_chksum (st_ucon64_nfo_t *rominfo)
+gb_chksum (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   st_gb_chksum_t sum = { 0, 0 };
-  unsigned int size = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
+  unsigned int size = (unsigned int) p->fsize - rominfo->backup_header_len;
 
   if (size > GB_HEADER_START + 0x4f)
     {
@@ -897,7 +908,7 @@ gb_chksum (st_ucon64_nfo_t *rominfo)
           fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
           return sum;
         }
-      ucon64_fread (rom_buffer, rominfo->backup_header_len, size, ucon64.fname);
+      ucon64_fread (rom_buffer, rominfo->backup_header_len, size, p->fname);
 
       for (i = GB_HEADER_START + 0x34; i < GB_HEADER_START + 0x4d; i++)
         sum.header += ~rom_buffer[i];
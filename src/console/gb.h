@@ -40,7 +40,7 @@ extern int gb_n (st_ucon64_nfo_t *rominfo, const char *name);
 extern int gb_n2gb (st_ucon64_nfo_t *rominfo, const char *emu_rom);
 extern int gb_sgb (st_ucon64_nfo_t *rominfo);
 extern int gb_ssc (st_ucon64_nfo_t *rominfo);
-extern int gb_init (st_ucon64_nfo_t *rominfo);
+extern int gb_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int gb_logo (st_ucon64_nfo_t *rominfo);
 
 #endif
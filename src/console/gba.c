@@ -62,7 +62,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define GBA_SAV_TEMPLATE_SIZE 65536
 #define GBA_SCI_TEMPLATE_SIZE 458752
 
-static int gba_chksum (void);
+static int gba_chksum (st_ucon64_t *p);
 
 
 static st_ucon64_obj_t gba_obj[] =
@@ -246,7 +246,14 @@ typedef struct st_gba_header
   unsigned char pad3[2];
 } st_gba_header_t;
 
-static st_gba_header_t gba_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_gba_header_t header;
+} st_gba_data_t;
+#define gba_data(p) ((st_gba_data_t *) \
+  ucon64_console_data (p, UCON64_GBA, sizeof (st_gba_data_t)))
+
 const unsigned char gba_logodata[] =            // NOTE: not a static variable
   {
                             0x24, 0xff, 0xae, 0x51,
@@ -458,7 +465,7 @@ gba_sram (void)
   major = ptr[8] - '0';
   minor = ptr[9] - '0';
   micro = ptr[10] - '0';
-  if (ucon64.quiet < 0)
+  if (ucon64_settings.quiet < 0)
     printf ("version: %u.%u.%u; offset: 0x%08x\n",
             major, minor, micro, (int) (ptr - buffer));
   if (minor - 1 >= 2)
@@ -478,7 +485,7 @@ gba_sram (void)
       fclose (destfile);
       return -1;
     }
-  if (ucon64.quiet < 0)
+  if (ucon64_settings.quiet < 0)
     printf ("fl offset: 0x%08x\n", (int) (ptr - buffer));
   fseek (destfile, (long) (ptr - buffer), SEEK_SET);
   fwrite (fl_repl[minor - 1], 1, sizeof fl_repl[minor - 1], destfile);
@@ -490,7 +497,7 @@ gba_sram (void)
   while (*ptr == value && ptr - buffer > 0);
 
   p_off = (ptr - buffer + 0xff) & ~0xff;        // align at 256 byte boundary
-  if (ucon64.quiet < 0)
+  if (ucon64_settings.quiet < 0)
     printf ("p_off: 0x%08x\n", p_off);
   // if the SRAM function won't fit at the end of the ROM, abort
   if ((minor == 1 && (int) (fsize - 188) < p_off) ||
@@ -512,7 +519,7 @@ gba_sram (void)
       return -1;
     }
   st_off = (int) (ptr - buffer);
-  if (ucon64.quiet < 0)
+  if (ucon64_settings.quiet < 0)
     printf ("st offset: 0x%08x\n", st_off);
 
   bufferptr = buffer + p_off;
@@ -621,50 +628,51 @@ gba_crp (st_ucon64_nfo_t *rominfo, const char *value)
 
 
 int
-gba_init (st_ucon64_nfo_t *rominfo)
+gba_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_gba_data_t *cd = gba_data (p);
   int result = -1, value;
   unsigned int pos = (unsigned int) strlen (rominfo->misc);
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  ucon64_fread (&gba_header, GBA_HEADER_START +
-                rominfo->backup_header_len, GBA_HEADER_LEN, ucon64.fname);
-  if (/*gba_header.game_id_prefix == 'A' && */ // 'B' in Mario vs. Donkey Kong
-      gba_header.start[3] == 0xea && gba_header.pad1 == 0x96 && gba_header.gba_type == 0)
+  ucon64_fread (&cd->header, GBA_HEADER_START +
+                rominfo->backup_header_len, GBA_HEADER_LEN, p->fname);
+  if (/*cd->header.game_id_prefix == 'A' && */ // 'B' in Mario vs. Donkey Kong
+      cd->header.start[3] == 0xea && cd->header.pad1 == 0x96 && cd->header.gba_type == 0)
     result = 0;
   else
     {
 #if 0 // AFAIK (dbjh) GBA ROMs never have a header
-      rominfo->backup_header_len = UCON64_ISSET (ucon64.backup_header_len, unsigned int) ?
-                                     ucon64.backup_header_len : UNKNOWN_HEADER_LEN;
+      rominfo->backup_header_len = UCON64_ISSET (p->backup_header_len, unsigned int) ?
+                                     p->backup_header_len : UNKNOWN_HEADER_LEN;
 
-      ucon64_fread (&gba_header, GBA_HEADER_START +
-                    rominfo->backup_header_len, GBA_HEADER_LEN, ucon64.fname);
-      if (gba_header.game_id_prefix == 'A' && gba_header.gba_type == 0)
+      ucon64_fread (&cd->header, GBA_HEADER_START +
+                    rominfo->backup_header_len, GBA_HEADER_LEN, p->fname);
+      if (cd->header.game_id_prefix == 'A' && cd->header.gba_type == 0)
         result = 0;
       else
 #endif
         result = -1;
     }
-  if (ucon64.console == UCON64_GBA)
+  if (p->console == UCON64_GBA)
     result = 0;
 
   rominfo->header_start = GBA_HEADER_START;
   rominfo->header_len = GBA_HEADER_LEN;
-  rominfo->header = &gba_header;
+  rominfo->header = &cd->header;
 
   // internal ROM name
-  strncpy (rominfo->name, (char *) gba_header.name, GBA_NAME_LEN);
+  strncpy (rominfo->name, (char *) cd->header.name, GBA_NAME_LEN);
   rominfo->name[GBA_NAME_LEN] = '\0';
 
   // ROM maker
   {
-    int ih = gba_header.maker_high <= '9' ?
-               gba_header.maker_high - '0' : gba_header.maker_high - 'A' + 10,
-        il = gba_header.maker_low <= '9' ?
-               gba_header.maker_low - '0' : gba_header.maker_low - 'A' + 10;
+    int ih = cd->header.maker_high <= '9' ?
+               cd->header.maker_high - '0' : cd->header.maker_high - 'A' + 10,
+        il = cd->header.maker_low <= '9' ?
+               cd->header.maker_low - '0' : cd->header.maker_low - 'A' + 10;
     value = ih * 36 + il;
   }
   if (value < 0 || value >= NINTENDO_MAKER_LEN)
@@ -673,40 +681,40 @@ gba_init (st_ucon64_nfo_t *rominfo)
 
   // ROM country
   rominfo->country =
-    (gba_header.game_id_country == 'J') ? "Japan/Asia" :
-    (gba_header.game_id_country == 'E') ? "U.S.A." :
-    (gba_header.game_id_country == 'P') ? "Europe, Australia and Africa" :
+    (cd->header.game_id_country == 'J') ? "Japan/Asia" :
+    (cd->header.game_id_country == 'E') ? "U.S.A." :
+    (cd->header.game_id_country == 'P') ? "Europe, Australia and Africa" :
     "Unknown country";
 
   // misc stuff
-  pos += sprintf (rominfo->misc + pos, "Version: 1.%u\n", gba_header.version);
-  pos += sprintf (rominfo->misc + pos, "Device type: 0x%02x\n", gba_header.device_type);
+  pos += sprintf (rominfo->misc + pos, "Version: 1.%u\n", cd->header.version);
+  pos += sprintf (rominfo->misc + pos, "Device type: 0x%02x\n", cd->header.device_type);
 
   /*
     start address = current address + (parameter of B instruction * 4) + 8
-    gba_header.start[3] is opcode of B instruction (0xea)
+    cd->header.start[3] is opcode of B instruction (0xea)
   */
   value = 0x8000008 +
-          (gba_header.start[2] << 18 | gba_header.start[1] << 10 | gba_header.start[0] << 2);
+          (cd->header.start[2] << 18 | cd->header.start[1] << 10 | cd->header.start[0] << 2);
   pos += sprintf (rominfo->misc + pos, "Start address: 0x%08x\n", value);
 
   sprintf (rominfo->misc + pos, "Logo data: %s",
-           memcmp (gba_header.logo, gba_logodata, GBA_LOGODATA_LEN) == 0 ?
+           memcmp (cd->header.logo, gba_logodata, GBA_LOGODATA_LEN) == 0 ?
 #ifdef  USE_ANSI_COLOR
-             ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-             ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
+             p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+             p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
 #else
              "OK" : "Bad");
 #endif
 
   // internal ROM crc
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
       rominfo->has_internal_crc = 1;
       rominfo->internal_crc_len = 1;
-      rominfo->current_internal_crc = gba_chksum ();
+      rominfo->current_internal_crc = gba_chksum (p);
 
-      rominfo->internal_crc = gba_header.checksum;
+      rominfo->internal_crc = cd->header.checksum;
       rominfo->internal_crc2[0] = 0;
     }
 
@@ -719,12 +727,13 @@ gba_init (st_ucon64_nfo_t *rominfo)
 
 
 int
-gba_chksum (void)
+gba_chksum (st_ucon64_t *p)
 // Note that this function only calculates the checksum of the internal header
 {
-  unsigned char sum = 0x19, *ptr = (unsigned char *) &gba_header + 0xa0;
+  st_gba_data_t *cd = gba_data (p);
+  unsigned char sum = 0x19, *ptr = (unsigned char *) &cd->header + 0xa0;
 
-  while (ptr < (unsigned char *) &gba_header + 0xbd)
+  while (ptr < (unsigned char *) &cd->header + 0xbd)
     sum += *ptr++;
   sum = -sum;
 
@@ -795,7 +804,7 @@ gba_multi (unsigned int truncate_size, char *multi_fname)
             {
               size_t len;
 
-              p = get_property (ucon64.configfile, "gbaloader", PROPERTY_MODE_FILENAME);
+              p = get_property (ucon64_settings.configfile, "gbaloader", PROPERTY_MODE_FILENAME);
               if (!p)
                 p = "loader.bin";
               len = strnlen (p, sizeof fname - 1);
@@ -987,7 +996,7 @@ gba_saver_patch (FILE *destfile, unsigned char *buffer, unsigned int fsize)
                                          saver_patch_orig, 38, 0)) != NULL;
        ptr++)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", (int) (ptr - buffer));
       fseek (destfile, (long) (ptr - buffer), SEEK_SET);
       fwrite (saver_patch_repl, 1, 38, destfile);
@@ -999,7 +1008,7 @@ gba_saver_patch (FILE *destfile, unsigned char *buffer, unsigned int fsize)
                                          saver_patch2_orig, 38, 0)) != NULL;
        ptr++)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", (int) (ptr - buffer));
       fseek (destfile, (long) (ptr - buffer), SEEK_SET);
       fwrite (saver_patch2_repl, 1, 38, destfile);
@@ -1011,7 +1020,7 @@ gba_saver_patch (FILE *destfile, unsigned char *buffer, unsigned int fsize)
                                          saver_patch3_orig, 38, MEMMEM2_WCARD (0x3f))) != NULL;
        ptr++)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", (int) (ptr - buffer));
       fseek (destfile, (long) (ptr - buffer), SEEK_SET);
       fwrite (saver_patch3_repl, 1, 38, destfile);
@@ -1023,7 +1032,7 @@ gba_saver_patch (FILE *destfile, unsigned char *buffer, unsigned int fsize)
                                          saver_patch4_orig, 40, MEMMEM2_WCARD (0x3f))) != NULL;
        ptr++)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", (int) (ptr - buffer));
       fseek (destfile, (long) (ptr - buffer), SEEK_SET);
       fwrite (saver_patch4_repl, 1, 40, destfile);
@@ -1035,7 +1044,7 @@ gba_saver_patch (FILE *destfile, unsigned char *buffer, unsigned int fsize)
                                          saver_patch5_orig, 42, 0)) != NULL;
        ptr++)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", (int) (ptr - buffer));
       fseek (destfile, (long) (ptr - buffer), SEEK_SET);
       fwrite (saver_patch5_repl, 1, 42, destfile);
@@ -1195,7 +1204,7 @@ gba_sc (void)
     for (x = 0; x < 15; x++)
       if (!memcmp (ptr, sc_orig[x], 6))         // Do the last 2 bytes match?
         {
-          if (ucon64.quiet < 0)
+          if (ucon64_settings.quiet < 0)
             printf ("offset: 0x%08x\n", (int) (ptr - buffer));
           fseek (destfile, (long) (ptr - buffer), SEEK_SET);
           fwrite (sc_repl, 1, 4, destfile);
@@ -1209,7 +1218,7 @@ gba_sc (void)
                                                 // AGB KIRBY DX (< 10223428) 128Mb
        ptr++)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", (int) (ptr - buffer));
       fseek (destfile, (long) (ptr - buffer), SEEK_SET);
       fputc (sc2_repl, destfile);
@@ -1217,7 +1226,7 @@ gba_sc (void)
 
   if (!memcmp (buffer + 0xee, &sc3_orig, 92))
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("offset: 0x%08x\n", 0xee);
       fseek (destfile, 0xee, SEEK_SET);
       fwrite (sc3_repl, 1, 92, destfile);
@@ -1258,7 +1267,7 @@ gba_sc (void)
     0x00, 0x00, 0x00, 0x00,
   */
   // write the menu (the formulas will NOT be optimized)
-  p = get_property (ucon64.configfile, "gbaloader_sc", PROPERTY_MODE_FILENAME);
+  p = get_property (ucon64_settings.configfile, "gbaloader_sc", PROPERTY_MODE_FILENAME);
   if (!p)
     p = "sc_menu.bin";
   {
@@ -32,7 +32,7 @@ extern const unsigned char gba_logodata[];
 
 extern int gba_chk (st_ucon64_nfo_t *rominfo);
 extern int gba_crp (st_ucon64_nfo_t *rominfo, const char *value);
-extern int gba_init (st_ucon64_nfo_t *rominfo);
+extern int gba_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int gba_logo (st_ucon64_nfo_t *rominfo);
 extern int gba_n (st_ucon64_nfo_t *rominfo, const char *name);
 extern int gba_sram (void);
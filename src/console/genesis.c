@@ -50,6 +50,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "misc/chksum.h"
 #include "misc/file.h"
 #include "misc/misc.h"
+#include "misc/xform.h"
 #include "ucon64_misc.h"
 #include "console/genesis.h"
 #include "backup/md-pro.h"
@@ -62,8 +63,10 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define GENESIS_HEADER_LEN (sizeof (st_genesis_header_t))
 #define GENESIS_NAME_LEN 48
 
-static int genesis_chksum (unsigned char *rom_buffer);
-static unsigned char *load_rom (st_ucon64_nfo_t *rominfo, const char *name,
+static int genesis_chksum (const st_block_view_t *view, unsigned int rom_size);
+static int view_rom (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                     st_block_view_t *view, unsigned char **buffer);
+static unsigned char *load_rom (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, const char *name,
                                 unsigned char *rom_buffer);
 static void save_rom (st_ucon64_nfo_t *rominfo, const char *name,
                       unsigned char **buffer, unsigned int size);
@@ -241,31 +244,39 @@ typedef struct st_genesis_header
   char pad[256];
 } st_genesis_header_t;
 
-static st_genesis_header_t genesis_header;
-static genesis_copier_t copier_type;
-static unsigned int genesis_rom_size, genesis_has_ram, genesis_tv_standard,
-                    genesis_japanese;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_genesis_header_t header;
+  genesis_copier_t copier_type;
+  unsigned int rom_size, has_ram, tv_standard, japanese;
+  char maker[9];
+  char country[200];                            // enough for 5 country names
+} st_genesis_data_t;
+#define genesis_data(p) ((st_genesis_data_t *) \
+  ucon64_console_data (p, UCON64_GEN, sizeof (st_genesis_data_t)))
 
 
 genesis_copier_t
-genesis_get_copier_type (void)
+genesis_get_copier_type (st_ucon64_t *p)
 {
-  return copier_type;
+  return genesis_data (p)->copier_type;
 }
 
 
 int
 genesis_smd (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   st_smd_header_t header;
   char dest_name[FILENAME_MAX];
   unsigned char *rom_buffer = NULL;
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
   memset (&header, 0, SMD_HEADER_LEN);
-  header.size = (unsigned char) (genesis_rom_size / 16384);
+  header.size = (unsigned char) (cd->rom_size / 16384);
   header.id0 = 3;
   header.id1 = 0xaa;
   header.id2 = 0xbb;
@@ -276,8 +287,8 @@ genesis_smd (st_ucon64_nfo_t *rominfo)
   ucon64_file_handler (dest_name, NULL, 0);
 
   ucon64_fwrite (&header, 0, SMD_HEADER_LEN, dest_name, "wb");
-  smd_interleave (rom_buffer, genesis_rom_size);
-  ucon64_fwrite (rom_buffer, SMD_HEADER_LEN, genesis_rom_size, dest_name, "ab");
+  smd_interleave (rom_buffer, cd->rom_size);
+  ucon64_fwrite (rom_buffer, SMD_HEADER_LEN, cd->rom_size, dest_name, "ab");
 
   free (rom_buffer);
   printf (ucon64_msg[WROTE], dest_name);
@@ -316,17 +327,18 @@ genesis_smds (void)
 int
 genesis_bin (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   char dest_name[FILENAME_MAX];
   unsigned char *rom_buffer = NULL;
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
   strcpy (dest_name, ucon64.fname);
   set_suffix (dest_name, ".bin");
   ucon64_file_handler (dest_name, NULL, 0);
 
-  ucon64_fwrite (rom_buffer, 0, genesis_rom_size, dest_name, "wb");
+  ucon64_fwrite (rom_buffer, 0, cd->rom_size, dest_name, "wb");
 
   free (rom_buffer);
   printf (ucon64_msg[WROTE], dest_name);
@@ -338,35 +350,36 @@ genesis_bin (st_ucon64_nfo_t *rominfo)
 int
 genesis_mgd (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   unsigned char *rom_buffer = NULL;
   char dest_name[FILENAME_MAX];
 
   // pad the file to the next valid MGD2 size if it doesn't have a valid size
-  if (genesis_rom_size <= 1 * MBIT)
-    genesis_rom_size = 1 * MBIT;
-  else if (genesis_rom_size <= 2 * MBIT)
-    genesis_rom_size = 2 * MBIT;
-  else if (genesis_rom_size <= 4 * MBIT)
-    genesis_rom_size = 4 * MBIT;
-  else if (genesis_rom_size <= 8 * MBIT)
-    genesis_rom_size = 8 * MBIT;
-  else if (genesis_rom_size <= 16 * MBIT)
-    genesis_rom_size = 16 * MBIT;
-  else if (genesis_rom_size <= 20 * MBIT)
-    genesis_rom_size = 20 * MBIT;
-  else if (genesis_rom_size <= 24 * MBIT)
-    genesis_rom_size = 24 * MBIT;
+  if (cd->rom_size <= 1 * MBIT)
+    cd->rom_size = 1 * MBIT;
+  else if (cd->rom_size <= 2 * MBIT)
+    cd->rom_size = 2 * MBIT;
+  else if (cd->rom_size <= 4 * MBIT)
+    cd->rom_size = 4 * MBIT;
+  else if (cd->rom_size <= 8 * MBIT)
+    cd->rom_size = 8 * MBIT;
+  else if (cd->rom_size <= 16 * MBIT)
+    cd->rom_size = 16 * MBIT;
+  else if (cd->rom_size <= 20 * MBIT)
+    cd->rom_size = 20 * MBIT;
+  else if (cd->rom_size <= 24 * MBIT)
+    cd->rom_size = 24 * MBIT;
   else
-    genesis_rom_size = 32 * MBIT;
+    cd->rom_size = 32 * MBIT;
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
-  mgd_make_name (ucon64.fname, UCON64_GEN, genesis_rom_size, dest_name);
+  mgd_make_name (ucon64.fname, UCON64_GEN, cd->rom_size, dest_name);
   ucon64_file_handler (dest_name, NULL, OF_FORCE_BASENAME);
 
-  mgd_interleave (&rom_buffer, genesis_rom_size);
-  ucon64_fwrite (rom_buffer, 0, genesis_rom_size, dest_name, "wb");
+  mgd_interleave (&rom_buffer, cd->rom_size);
+  ucon64_fwrite (rom_buffer, 0, cd->rom_size, dest_name, "wb");
 
   printf (ucon64_msg[WROTE], dest_name);
   free (rom_buffer);
@@ -533,17 +546,18 @@ write_mgh_name_file (st_ucon64_nfo_t *rominfo, const char *dest_name)
 int
 genesis_mgh (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   unsigned char *rom_buffer = NULL;
   char dest_name[FILENAME_MAX];
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
-  mgh_make_name (ucon64.fname, UCON64_GEN, genesis_rom_size, dest_name);
+  mgh_make_name (ucon64.fname, UCON64_GEN, cd->rom_size, dest_name);
   ucon64_file_handler (dest_name, NULL, OF_FORCE_BASENAME);
 
-  mgd_interleave (&rom_buffer, genesis_rom_size);
-  ucon64_fwrite (rom_buffer, 0, genesis_rom_size, dest_name, "wb");
+  mgd_interleave (&rom_buffer, cd->rom_size);
+  ucon64_fwrite (rom_buffer, 0, cd->rom_size, dest_name, "wb");
 
   printf (ucon64_msg[WROTE], dest_name);
   free (rom_buffer);
@@ -557,6 +571,7 @@ genesis_mgh (st_ucon64_nfo_t *rominfo)
 int
 genesis_s (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   st_smd_header_t smd_header;
   char dest_name[FILENAME_MAX], *p;
   unsigned int x, nparts, surplus, part_size,
@@ -575,7 +590,7 @@ genesis_s (st_ucon64_nfo_t *rominfo)
     }
   else
     {
-      if (copier_type == SMD)
+      if (cd->copier_type == SMD)
         part_size = 4 * MBIT;                   // SMD uses 4 Mb parts
       else
         part_size = 8 * MBIT;                   // MGD2 and Magicom ("BIN") use
@@ -591,7 +606,7 @@ genesis_s (st_ucon64_nfo_t *rominfo)
   nparts = size / part_size;
   surplus = size % part_size;
 
-  if (copier_type == SMD)
+  if (cd->copier_type == SMD)
     {
       ucon64_fread (&smd_header, 0, SMD_HEADER_LEN, ucon64.fname);
 
@@ -628,7 +643,7 @@ genesis_s (st_ucon64_nfo_t *rominfo)
           printf (ucon64_msg[WROTE], dest_name);
         }
     }
-  else if (copier_type == MGD_GEN)
+  else if (cd->copier_type == MGD_GEN)
     {
       char *names[8], names_mem[8][9] = { { 0 } };
       const char *p0;
@@ -648,7 +663,7 @@ genesis_s (st_ucon64_nfo_t *rominfo)
       for (n = 0; n < sizeof names / sizeof names[0]; n++)
         names[n] = names_mem[n];
 
-      mgd_make_name (ucon64.fname, UCON64_GEN, genesis_rom_size, dest_name);
+      mgd_make_name (ucon64.fname, UCON64_GEN, cd->rom_size, dest_name);
       ucon64_output_fname (dest_name, OF_FORCE_BASENAME);
       p0 = basename2 (dest_name);
       p = strrchr (p0, '.') - 1;
@@ -709,6 +724,7 @@ genesis_s (st_ucon64_nfo_t *rominfo)
 int
 genesis_smgh (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   const char *p0;
   char dest_name[FILENAME_MAX], *p, *suffix;
   unsigned int n, x, nparts, surplus, part_size,
@@ -741,7 +757,7 @@ genesis_smgh (st_ucon64_nfo_t *rominfo)
   if (surplus)
     nparts++;
 
-  mgh_make_name (ucon64.fname, UCON64_GEN, genesis_rom_size, dest_name);
+  mgh_make_name (ucon64.fname, UCON64_GEN, cd->rom_size, dest_name);
   ucon64_output_fname (dest_name, OF_FORCE_BASENAME);
   p0 = basename2 (dest_name);
   p = strrchr (p0, '.');
@@ -788,10 +804,11 @@ genesis_smgh (st_ucon64_nfo_t *rominfo)
 int
 genesis_j (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], *p;
   unsigned int block_size;
 
-  if (copier_type == SMD)
+  if (cd->copier_type == SMD)
     {
       unsigned int total_size = 0;
 
@@ -828,7 +845,7 @@ genesis_j (st_ucon64_nfo_t *rominfo)
 
       printf (ucon64_msg[WROTE], dest_name);
     }
-  else if (copier_type == MGD_GEN)
+  else if (cd->copier_type == MGD_GEN)
     {
       /*
         file1 file2 file3 file4
@@ -866,7 +883,7 @@ genesis_j (st_ucon64_nfo_t *rominfo)
 
       printf (ucon64_msg[WROTE], dest_name);
     }
-  else if (copier_type == BIN)
+  else if (cd->copier_type == BIN)
     {
       int tried_r00 = 0;
 
@@ -905,10 +922,11 @@ genesis_j (st_ucon64_nfo_t *rominfo)
 static int
 genesis_name (st_ucon64_nfo_t *rominfo, const char *name1, const char *name2)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   unsigned char *rom_buffer = NULL;
   char buf[FILENAME_MAX];
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
   if (name1)
@@ -933,7 +951,7 @@ genesis_name (st_ucon64_nfo_t *rominfo, const char *name1, const char *name2)
 
   strcpy (buf, ucon64.fname);
   ucon64_file_handler (buf, NULL, 0);
-  save_rom (rominfo, buf, &rom_buffer, genesis_rom_size);
+  save_rom (rominfo, buf, &rom_buffer, cd->rom_size);
 
   free (rom_buffer);
   printf (ucon64_msg[WROTE], buf);
@@ -965,10 +983,11 @@ genesis_1991 (st_ucon64_nfo_t *rominfo)
 int
 genesis_chk (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   unsigned char *rom_buffer = NULL;
   char dest_name[FILENAME_MAX];
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
   rom_buffer[GENESIS_HEADER_START + 143] =
@@ -981,7 +1000,7 @@ genesis_chk (st_ucon64_nfo_t *rominfo)
 
   strcpy (dest_name, ucon64.fname);
   ucon64_file_handler (dest_name, NULL, 0);
-  save_rom (rominfo, dest_name, &rom_buffer, genesis_rom_size);
+  save_rom (rominfo, dest_name, &rom_buffer, cd->rom_size);
 
   free (rom_buffer);
   printf (ucon64_msg[WROTE], dest_name);
@@ -994,17 +1013,19 @@ genesis_fix_pal_protection (st_ucon64_nfo_t *rominfo)
 // This function searches for PAL protection codes. If it finds one it will
 //  fix the code so that the game will run on a Genesis (NTSC).
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   char fname[FILENAME_MAX];
   unsigned char *rom_buffer = NULL;
   int offset = 0, n = 0, n_extra_patterns, n2;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   strcpy (fname, "genpal.txt");
   // first try the current directory, then the configuration directory
   if (access (fname, F_OK | R_OK) == -1)
     {
       snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "genpal.txt",
-                ucon64.configdir);
+                ucon64_settings.configdir);
       fname[FILENAME_MAX - 1] = '\0';
     }
   n_extra_patterns = build_cm_patterns (&patterns, fname);
@@ -1014,29 +1035,24 @@ genesis_fix_pal_protection (st_ucon64_nfo_t *rominfo)
 
   puts ("Attempting to fix PAL protection code...");
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_extra_patterns);
   while ((n2 = (int) ucon64.fsize - offset) > 0)
     {
       int block_size = n2 >= 16 * 1024 ? 16 * 1024 : n2;
-      for (n2 = 0; n2 < n_extra_patterns; n2++)
-        n += change_mem2 ((char *) rom_buffer + offset, block_size,
-                          patterns[n2].search,
-                          patterns[n2].search_size,
-                          patterns[n2].wildcard,
-                          patterns[n2].escape,
-                          patterns[n2].replace,
-                          patterns[n2].replace_size,
-                          patterns[n2].offset,
-                          patterns[n2].sets);
+      n += change_mem_patterns ((char *) rom_buffer + offset, block_size,
+                                &automaton);
       offset += 16 * 1024;
     }
+  cleanup_cm_automaton (&automaton);
   cleanup_cm_patterns (&patterns, n_extra_patterns);
 
   strcpy (fname, ucon64.fname);
   ucon64_file_handler (fname, NULL, 0);
-  save_rom (rominfo, fname, &rom_buffer, genesis_rom_size);
+  save_rom (rominfo, fname, &rom_buffer, cd->rom_size);
 
   free (rom_buffer);
   printf ("Found %d pattern%s\n", n, n != 1 ? "s" : "");
@@ -1050,17 +1066,19 @@ genesis_fix_ntsc_protection (st_ucon64_nfo_t *rominfo)
 // This function searches for NTSC protection codes. If it finds one it will
 //  fix the code so that the game will run on a Mega Drive (PAL).
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   char fname[FILENAME_MAX];
   unsigned char *rom_buffer = NULL;
   int offset = 0, n = 0, n_extra_patterns, n2;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   strcpy (fname, "mdntsc.txt");
   // first try the current directory, then the configuration directory
   if (access (fname, F_OK | R_OK) == -1)
     {
       snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "mdntsc.txt",
-                ucon64.configdir);
+                ucon64_settings.configdir);
       fname[FILENAME_MAX - 1] = '\0';
     }
   n_extra_patterns = build_cm_patterns (&patterns, fname);
@@ -1070,29 +1088,24 @@ genesis_fix_ntsc_protection (st_ucon64_nfo_t *rominfo)
 
   puts ("Attempting to fix NTSC protection code...");
 
-  if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+  if ((rom_buffer = load_rom (&ucon64, rominfo, ucon64.fname, rom_buffer)) == NULL)
     return -1;
 
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_extra_patterns);
   while ((n2 = (int) ucon64.fsize - offset) > 0)
     {
       int block_size = n2 >= 16 * 1024 ? 16 * 1024 : n2;
-      for (n2 = 0; n2 < n_extra_patterns; n2++)
-        n += change_mem2 ((char *) rom_buffer + offset, block_size,
-                          patterns[n2].search,
-                          patterns[n2].search_size,
-                          patterns[n2].wildcard,
-                          patterns[n2].escape,
-                          patterns[n2].replace,
-                          patterns[n2].replace_size,
-                          patterns[n2].offset,
-                          patterns[n2].sets);
+      n += change_mem_patterns ((char *) rom_buffer + offset, block_size,
+                                &automaton);
       offset += 16 * 1024;
     }
+  cleanup_cm_automaton (&automaton);
   cleanup_cm_patterns (&patterns, n_extra_patterns);
 
   strcpy (fname, ucon64.fname);
   ucon64_file_handler (fname, NULL, 0);
-  save_rom (rominfo, fname, &rom_buffer, genesis_rom_size);
+  save_rom (rominfo, fname, &rom_buffer, cd->rom_size);
 
   free (rom_buffer);
   printf ("Found %d pattern%s\n", n, n != 1 ? "s" : "");
@@ -1104,13 +1117,15 @@ genesis_fix_ntsc_protection (st_ucon64_nfo_t *rominfo)
 int
 genesis_f (st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
+
   /*
     In the Philipines the television standard is NTSC, but do games made
     for the Philipines exist?
     Just like with SNES we don't guarantee anything for files that needn't be
     fixed/cracked/patched.
   */
-  if (genesis_tv_standard == 0)                 // NTSC (Japan, U.S.A. or Brazil ('4'))
+  if (cd->tv_standard == 0)                     // NTSC (Japan, U.S.A. or Brazil ('4'))
     return genesis_fix_ntsc_protection (rominfo);
   else
     return genesis_fix_pal_protection (rominfo);
@@ -1118,48 +1133,107 @@ genesis_f (st_ucon64_nfo_t *rominfo)
 
 
 static unsigned char *
-load_rom (st_ucon64_nfo_t *rominfo, const char *name, unsigned char *rom_buffer)
+load_rom (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, const char *name, unsigned char *rom_buffer)
 {
+  st_genesis_data_t *cd = genesis_data (p);
   FILE *file;
   size_t bytesread;
 
   if ((file = fopen (name, "rb")) == NULL)
     return NULL;
-  if ((rom_buffer = (unsigned char *) malloc (genesis_rom_size)) == NULL)
+  if ((rom_buffer = (unsigned char *) malloc (cd->rom_size)) == NULL)
     {
-      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], genesis_rom_size);
+      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], cd->rom_size);
       fclose (file);
       return NULL;
     }
   fseek (file, rominfo->backup_header_len, SEEK_SET); // don't do this only for SMD!
-  bytesread = fread (rom_buffer, 1, genesis_rom_size, file);
-  if (bytesread < genesis_rom_size)
-    memset (rom_buffer + bytesread, 0, genesis_rom_size - bytesread);
+  bytesread = fread (rom_buffer, 1, cd->rom_size, file);
+  if (bytesread < cd->rom_size)
+    memset (rom_buffer + bytesread, 0, cd->rom_size - bytesread);
 
-  if (copier_type != BIN)
+  if (cd->copier_type != BIN)
     {
-      if (ucon64.fcrc32 == 0)
-        ucon64.fcrc32 = crc32 (ucon64.fcrc32, rom_buffer, genesis_rom_size);
+      if (p->fcrc32 == 0)
+        p->fcrc32 = crc32 (p->fcrc32, rom_buffer, cd->rom_size);
 
-      if (copier_type == SMD)
+      if (cd->copier_type == SMD)
         smd_deinterleave (rom_buffer, bytesread);
       else // copier_type == MGD_GEN
-        mgd_deinterleave (&rom_buffer, bytesread, genesis_rom_size);
+        mgd_deinterleave (&rom_buffer, bytesread, cd->rom_size);
     }
 
-  if (ucon64.crc32 == 0)                        // calculate the CRC32 only once
-    ucon64.crc32 = crc32 (0, rom_buffer, (unsigned int) bytesread);
+  if (p->crc32 == 0)                            // calculate the CRC32 only once
+    p->crc32 = crc32 (0, rom_buffer, (unsigned int) bytesread);
 
   fclose (file);
   return rom_buffer;
 }
 
 
+static int
+view_rom (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, st_block_view_t *view,
+          unsigned char **buffer)
+/*
+  Make view present the data of p->fname as load_rom() would return it. The
+  data is not copied or deinterleaved if ucon64 has an image of the file.
+  Otherwise it is read into *buffer, which the caller has to free.
+*/
+{
+  st_genesis_data_t *cd = genesis_data (p);
+  const unsigned char *image;
+  uint64_t image_size;
+  size_t size;
+
+  *buffer = NULL;
+  if ((image = quick_io_ctx_data (p->fname, &image_size)) != NULL &&
+      rominfo->backup_header_len < image_size)
+    {
+      size = (size_t) MIN (image_size - rominfo->backup_header_len,
+                           cd->rom_size);
+      block_view_init (view, image + rominfo->backup_header_len, size);
+    }
+  else
+    {
+      FILE *file;
+
+      if ((file = fopen (p->fname, "rb")) == NULL)
+        return -1;
+      if ((*buffer = (unsigned char *) malloc (cd->rom_size)) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], cd->rom_size);
+          fclose (file);
+          return -1;
+        }
+      fseek (file, rominfo->backup_header_len, SEEK_SET);
+      size = fread (*buffer, 1, cd->rom_size, file);
+      fclose (file);
+      block_view_init (view, *buffer, size);
+    }
+
+  if (cd->copier_type == SMD)
+    {
+      view->block_size = 16384;
+      view->nblocks = size / 16384;
+      view->split16 = 1;
+    }
+  else if (cd->copier_type == MGD_GEN)          // one block of the whole ROM
+    {
+      view->block_size = size & ~(size_t) 1;
+      view->nblocks = view->block_size ? 1 : 0;
+      view->split16 = 1;
+    }
+  return 0;
+}
+
+
 static void
 save_rom (st_ucon64_nfo_t *rominfo, const char *name, unsigned char **buffer,
           unsigned int size)
 {
-  if (copier_type == SMD)
+  st_genesis_data_t *cd = genesis_data (&ucon64);
+
+  if (cd->copier_type == SMD)
     {
       /*
         Copy the complete backup unit header length, no matter how strange or
@@ -1175,7 +1249,7 @@ save_rom (st_ucon64_nfo_t *rominfo, const char *name, unsigned char **buffer,
       if ((uint64_t) size < ucon64.fsize - rominfo->backup_header_len)
         truncate2 (name, rominfo->backup_header_len + size);
     }
-  else if (copier_type == MGD_GEN)
+  else if (cd->copier_type == MGD_GEN)
     {
       mgd_interleave (buffer, size);            // allocates new buffer
       ucon64_fwrite (*buffer, 0, size, name, "wb");
@@ -1189,6 +1263,7 @@ static void
 write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
                         size_t totalsize, unsigned int size)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   long int fpos = ftell (destfile);             // save file pointer
   int n;
   unsigned char name[0x1c], flags = 0;          // SRAM/region flags: F, D (reserved), E, P, V, T, S1, S0
@@ -1212,7 +1287,7 @@ write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
   fputc ((int) (totalsize / (2 * MBIT)), destfile); // 0x1e = bank code
 
   flags = 0x80;                                 // set F (?, default)
-  if (genesis_has_ram)
+  if (cd->has_ram)
     {
       static int sram_page = 0, file_no_sram = 0;
 
@@ -1244,9 +1319,9 @@ write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
   */
   if (UCON64_ISSET (ucon64.region))
     {
-      if (!genesis_japanese)
+      if (!cd->japanese)
         flags |= 0x20;                          // set E(urope)
-      if (genesis_tv_standard == 1)
+      if (cd->tv_standard == 1)
         flags |= 0x10;                          // set P(AL)
 
       flags |= 8;                               // set V (enable region function)
@@ -1260,6 +1335,7 @@ write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
 int
 genesis_multi (unsigned int truncate_size)
 {
+  st_genesis_data_t *cd = genesis_data (&ucon64);
   unsigned int n, n_files, file_no, done, truncated = 0, size,
                org_do_not_calc_crc = ucon64.do_not_calc_crc;
   size_t bytestowrite, byteswritten, totalsize = 0;
@@ -1320,7 +1396,7 @@ genesis_multi (unsigned int truncate_size)
       ucon64.fsize = fsizeof (ucon64.fname);
       // DON'T use fstate.st_size, because file could be compressed
       ucon64.do_not_calc_crc = 1;
-      if (genesis_init (ucon64.nfo) != 0)
+      if (genesis_init (&ucon64, ucon64.nfo) != 0)
         printf ("WARNING: %s does not appear to be a Genesis ROM\n", ucon64.fname);
       /*
         NOTE: This is NOT the place to mess with ucon64.console. When this
@@ -1332,16 +1408,16 @@ genesis_multi (unsigned int truncate_size)
         switch (ucon64.region)
           {
           case 0:                               // NTSC/Japan
-            genesis_tv_standard = 0;
-            genesis_japanese = 1;
+            cd->tv_standard = 0;
+            cd->japanese = 1;
             break;
           case 1:                               // NTSC/U.S.A.
-            genesis_tv_standard = 0;
-            genesis_japanese = 0;
+            cd->tv_standard = 0;
+            cd->japanese = 0;
             break;
           case 2:                               // PAL
-            genesis_tv_standard = 1;
-            genesis_japanese = 0;
+            cd->tv_standard = 1;
+            cd->japanese = 0;
             break;
           case 256:
             // Do nothing. Use whatever values we found for genesis_tv_standard and
@@ -1445,12 +1521,12 @@ genesis_multi (unsigned int truncate_size)
 
 
 static int
-genesis_testinterleaved (st_ucon64_nfo_t *rominfo)
+genesis_testinterleaved (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   unsigned char buf[16384] = { 0 };
 
   ucon64_fread (buf, rominfo->backup_header_len,
-                8192 + (GENESIS_HEADER_START + 4) / 2, ucon64.fname);
+                8192 + (GENESIS_HEADER_START + 4) / 2, p->fname);
   if (!memcmp (buf + GENESIS_HEADER_START, "SEGA", 4))
     return 0;
 
@@ -1459,7 +1535,7 @@ genesis_testinterleaved (st_ucon64_nfo_t *rominfo)
     return 1;
 
   q_fread_mgd (buf, rominfo->backup_header_len + GENESIS_HEADER_START, 4,
-               ucon64.fname);
+               p->fname);
   if (!memcmp (buf, "SEGA", 4))
     return 2;
 
@@ -1479,13 +1555,13 @@ check_split (const char *filename, void *cb_data)
 
 
 int
-genesis_init (st_ucon64_nfo_t *rominfo)
+genesis_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_genesis_data_t *cd = genesis_data (p);
   int result = -1, value = 0, y;
   size_t x;
   unsigned int pos = (unsigned int) strlen (rominfo->misc);
   unsigned char *rom_buffer = NULL, buf[MAXBUFSIZE], name[GENESIS_NAME_LEN + 1];
-  static char maker[9], country[200]; // 200 characters should be enough for 5 country names
 #define GENESIS_IO_MAX 0x58
   static const char *genesis_io[GENESIS_IO_MAX] =
     {
@@ -1509,10 +1585,10 @@ genesis_init (st_ucon64_nfo_t *rominfo)
       NULL, "Paddle Controller", NULL
     };
 
-  ucon64_fread (buf, 0, 11, ucon64.fname);
+  ucon64_fread (buf, 0, 11, p->fname);
   if (buf[8] == 0xaa && buf[9] == 0xbb && (buf[10] == 6 || buf[10] == 7))
     {
-      copier_type = SMD;
+      cd->copier_type = SMD;
       rominfo->backup_header_len = SMD_HEADER_LEN;
       if (buf[10] == 7)
         {
@@ -1523,74 +1599,74 @@ genesis_init (st_ucon64_nfo_t *rominfo)
           rominfo->country = "Country: N/A";
           rominfo->has_internal_crc = 0;
           sprintf (rominfo->misc + pos, "Type: Super Magic Drive SRAM file\n");
-          ucon64.split = 0;                     // SRAM files are never split
+          p->split = 0;                         // SRAM files are never split
           return 0;                             // rest is nonsense for SRAM file
         }
     }
 
-  if (UCON64_ISSET2 (ucon64.backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
-    rominfo->backup_header_len = ucon64.backup_header_len;
+  if (UCON64_ISSET2 (p->backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
+    rominfo->backup_header_len = p->backup_header_len;
 
-  rominfo->interleaved = UCON64_ISSET (ucon64.interleaved) ?
-                           ucon64.interleaved : genesis_testinterleaved (rominfo);
+  rominfo->interleaved = UCON64_ISSET (p->interleaved) ?
+                           p->interleaved : genesis_testinterleaved (p, rominfo);
 
   if (rominfo->interleaved == 0)
-    copier_type = BIN;
+    cd->copier_type = BIN;
   else if (rominfo->interleaved == 1)
-    copier_type = SMD;
+    cd->copier_type = SMD;
   else if (rominfo->interleaved == 2)
-    copier_type = MGD_GEN;
+    cd->copier_type = MGD_GEN;
 
-  if (copier_type == SMD)
+  if (cd->copier_type == SMD)
     {
-      genesis_rom_size = (((unsigned int) ucon64.fsize - rominfo->backup_header_len) /
+      cd->rom_size = (((unsigned int) p->fsize - rominfo->backup_header_len) /
                             16384) * 16384;
-      if (genesis_rom_size != ucon64.fsize - rominfo->backup_header_len)
-        rominfo->data_size = genesis_rom_size;
+      if (cd->rom_size != p->fsize - rominfo->backup_header_len)
+        rominfo->data_size = cd->rom_size;
 
       memset (buf, 0, 16384);
       ucon64_fread (buf, rominfo->backup_header_len,
                     8192 + (GENESIS_HEADER_START + GENESIS_HEADER_LEN) / 2,
-                    ucon64.fname);
+                    p->fname);
       smd_deinterleave (buf, 16384);            // buf will contain the deinterleaved data
-      memcpy (&genesis_header, buf + GENESIS_HEADER_START, GENESIS_HEADER_LEN);
+      memcpy (&cd->header, buf + GENESIS_HEADER_START, GENESIS_HEADER_LEN);
     }
-  else if (copier_type == MGD_GEN)
+  else if (cd->copier_type == MGD_GEN)
     {
       // We use rominfo->backup_header_len to make it user definable. Normally it
       //  should be 0 for MGD_GEN.
-      genesis_rom_size = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
-      q_fread_mgd (&genesis_header, rominfo->backup_header_len +
-                   GENESIS_HEADER_START, GENESIS_HEADER_LEN, ucon64.fname);
+      cd->rom_size = (unsigned int) p->fsize - rominfo->backup_header_len;
+      q_fread_mgd (&cd->header, rominfo->backup_header_len +
+                   GENESIS_HEADER_START, GENESIS_HEADER_LEN, p->fname);
     }
   else // copier_type == BIN
     {
       // We use rominfo->backup_header_len to make it user definable.
-      genesis_rom_size = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
-      ucon64_fread (&genesis_header, rominfo->backup_header_len +
-                    GENESIS_HEADER_START, GENESIS_HEADER_LEN, ucon64.fname);
+      cd->rom_size = (unsigned int) p->fsize - rominfo->backup_header_len;
+      ucon64_fread (&cd->header, rominfo->backup_header_len +
+                    GENESIS_HEADER_START, GENESIS_HEADER_LEN, p->fname);
     }
 
-  if (!UCON64_ISSET (ucon64.split))
+  if (!UCON64_ISSET (p->split))
     {
-      if (copier_type == SMD)
+      if (cd->copier_type == SMD)
         {
           int nsplit = 0,
-              nparts = ucon64_testsplit (ucon64.fname, check_split, &nsplit);
-          // force displayed info to be correct if not split (see ucon64.c)
-          ucon64.split = nparts == nsplit + 1 ? nparts : 0;
+              nparts = ucon64_testsplit (p->fname, check_split, &nsplit);
+          // force displayed info to be correct if not split (see p->c)
+          p->split = nparts == nsplit + 1 ? nparts : 0;
         }
-      else if (copier_type == BIN)
+      else if (cd->copier_type == BIN)
         {
           // this code isn't fool-proof, but it's not that important
-          const char *ptr = get_suffix (ucon64.fname);
+          const char *ptr = get_suffix (p->fname);
           if (strlen (ptr) == 4 && ptr[1] == 'r' &&
               ptr[2] >= '0' && ptr[2] <= '9' && ptr[3] >= '0' && ptr[3] <= '9')
             {
               int n_parts = 0;
               char fname[FILENAME_MAX], *digits;
 
-              strcpy (fname, ucon64.fname);
+              strcpy (fname, p->fname);
               digits = fname + strlen (fname) - 2;
               do
                 {
@@ -1603,28 +1679,28 @@ genesis_init (st_ucon64_nfo_t *rominfo)
               while (n_parts < 100);
 
               if (n_parts > 1)
-                ucon64.split = n_parts;
+                p->split = n_parts;
             }
         }
     }
 
-  if (!memcmp (&OFFSET (genesis_header, 0), "SEGA", 4) ||
-      ucon64.console == UCON64_GEN)
+  if (!memcmp (&OFFSET (cd->header, 0), "SEGA", 4) ||
+      p->console == UCON64_GEN)
     result = 0;
   else
     result = -1;
 
   rominfo->header_start = GENESIS_HEADER_START;
   rominfo->header_len = GENESIS_HEADER_LEN;
-  rominfo->header = &genesis_header;
+  rominfo->header = &cd->header;
 
   // internal ROM name
-  memcpy (rominfo->name, &OFFSET (genesis_header, 80), GENESIS_NAME_LEN);
+  memcpy (rominfo->name, &OFFSET (cd->header, 80), GENESIS_NAME_LEN);
   rominfo->name[GENESIS_NAME_LEN] = '\0';
 
   // ROM maker
-  memcpy (maker, &OFFSET (genesis_header, 16), 8);
-  if (maker[3] == 'T' && maker[4] == '-')
+  memcpy (cd->maker, &OFFSET (cd->header, 16), 8);
+  if (cd->maker[3] == 'T' && cd->maker[4] == '-')
     {
       static const char *genesis_maker[0x100] =
         {
@@ -1683,7 +1759,7 @@ genesis_init (st_ucon64_nfo_t *rominfo)
           NULL
         };
 
-      sscanf (&maker[5], "%03d", &value);
+      sscanf (&cd->maker[5], "%03d", &value);
       rominfo->maker = NULL_TO_UNKNOWN_S (genesis_maker[value & 0xff]);
     }
   else
@@ -1691,32 +1767,32 @@ genesis_init (st_ucon64_nfo_t *rominfo)
       // Don't use genesis_maker here. If it would be corrected/updated an
       //  incorrect publisher name would be displayed.
       rominfo->maker =
-        (!strncmp (maker, "(C)ACLD", 7)) ? "Ballistic" :
-        (!strncmp (maker, "(C)AESI", 7)) ? "ASCII" :
-        (!strncmp (maker, "(C)ASCI", 7)) ? "ASCII" :
-        (!strncmp (maker, "(C)KANEKO", 9)) ? "Kaneko" :
-        (!strncmp (maker, "(C)PPP", 6)) ? "Gametek" :
-        (!strncmp (maker, "(C)RSI", 6)) ? "Razorsoft" : // or is it "(C)1RSI"?
-        (!strncmp (maker, "(C)SEGA", 7)) ? "Sega" :
-        (!strncmp (maker, "(C)TREC", 7)) ? "Treco" :
-        (!strncmp (maker, "(C)VRGN", 7)) ? "Virgin Games" :
-        (!strncmp (maker, "(C)WADN", 7)) ? "Parker Brothers" :
-        (!strncmp (maker, "(C)WSTN", 7)) ? "Westone" : NULL;
+        (!strncmp (cd->maker, "(C)ACLD", 7)) ? "Ballistic" :
+        (!strncmp (cd->maker, "(C)AESI", 7)) ? "ASCII" :
+        (!strncmp (cd->maker, "(C)ASCI", 7)) ? "ASCII" :
+        (!strncmp (cd->maker, "(C)KANEKO", 9)) ? "Kaneko" :
+        (!strncmp (cd->maker, "(C)PPP", 6)) ? "Gametek" :
+        (!strncmp (cd->maker, "(C)RSI", 6)) ? "Razorsoft" : // or "(C)1RSI"?
+        (!strncmp (cd->maker, "(C)SEGA", 7)) ? "Sega" :
+        (!strncmp (cd->maker, "(C)TREC", 7)) ? "Treco" :
+        (!strncmp (cd->maker, "(C)VRGN", 7)) ? "Virgin Games" :
+        (!strncmp (cd->maker, "(C)WADN", 7)) ? "Parker Brothers" :
+        (!strncmp (cd->maker, "(C)WSTN", 7)) ? "Westone" : NULL;
       if (!rominfo->maker)
         {
-          maker[8] = '\0';
-          rominfo->maker = maker;
+          cd->maker[8] = '\0';
+          rominfo->maker = cd->maker;
         }
     }
 
-  genesis_tv_standard = 1;              // default to PAL; NTSC has higher precedence
-  genesis_japanese = 0;
+  cd->tv_standard = 1;              // default to PAL; NTSC has higher precedence
+  cd->japanese = 0;
 
-  country[0] = '\0';
+  cd->country[0] = '\0';
   // ROM country
   for (x = 0; x < 5; x++)
     {
-      int country_code = OFFSET (genesis_header, 240 + x);
+      int country_code = OFFSET (cd->header, 240 + x);
 #define GENESIS_COUNTRY_MAX 0x57
       const char *genesis_country[GENESIS_COUNTRY_MAX] =
         {
@@ -1743,51 +1819,51 @@ genesis_init (st_ucon64_nfo_t *rominfo)
       if ((x > 0 && country_code == 0) || country_code == ' ')
         continue;
       if (country_code == 'J')
-        genesis_japanese = 1;
-      if (genesis_japanese || country_code == 'U' || country_code == '4')
-        genesis_tv_standard = 0;        // Japan, the U.S.A. and Brazil ('4') use NTSC
-      strcat (country, NULL_TO_UNKNOWN_S
+        cd->japanese = 1;
+      if (cd->japanese || country_code == 'U' || country_code == '4')
+        cd->tv_standard = 0;        // Japan, the U.S.A. and Brazil ('4') use NTSC
+      strcat (cd->country, NULL_TO_UNKNOWN_S
                 (genesis_country[MIN (country_code, GENESIS_COUNTRY_MAX - 1)]));
-      strcat (country, ", ");
+      strcat (cd->country, ", ");
     }
-  x = strlen (country);
-  if (x >= 2 && country[x - 2] == ',' && country[x - 1] == ' ')
-    country[x - 2] = '\0';
-  rominfo->country = country;
+  x = strlen (cd->country);
+  if (x >= 2 && cd->country[x - 2] == ',' && cd->country[x - 1] == ' ')
+    cd->country[x - 2] = '\0';
+  rominfo->country = cd->country;
 
   // misc stuff
-  memcpy (name, &OFFSET (genesis_header, 32), GENESIS_NAME_LEN);
+  memcpy (name, &OFFSET (cd->header, 32), GENESIS_NAME_LEN);
   name[GENESIS_NAME_LEN] = '\0';
   pos += sprintf (rominfo->misc + pos, "Japanese game name: %s\n", name);
-  pos += sprintf (rominfo->misc + pos, "Date: %.8s\n", &OFFSET (genesis_header, 24));
-
-  x = (OFFSET (genesis_header, 160) << 24) +
-      (OFFSET (genesis_header, 161) << 16) +
-      (OFFSET (genesis_header, 162) << 8) +
-       OFFSET (genesis_header, 163);
-  y = (OFFSET (genesis_header, 164) << 24) +
-      (OFFSET (genesis_header, 165) << 16) +
-      (OFFSET (genesis_header, 166) << 8) +
-       OFFSET (genesis_header, 167);
+  pos += sprintf (rominfo->misc + pos, "Date: %.8s\n", &OFFSET (cd->header, 24));
+
+  x = (OFFSET (cd->header, 160) << 24) +
+      (OFFSET (cd->header, 161) << 16) +
+      (OFFSET (cd->header, 162) << 8) +
+       OFFSET (cd->header, 163);
+  y = (OFFSET (cd->header, 164) << 24) +
+      (OFFSET (cd->header, 165) << 16) +
+      (OFFSET (cd->header, 166) << 8) +
+       OFFSET (cd->header, 167);
   pos += sprintf (rominfo->misc + pos, "Internal size: %.4f Mb\n", (float) (y - x + 1) / MBIT);
   pos += sprintf (rominfo->misc + pos, "ROM start: %08x\n", (int) x);
   pos += sprintf (rominfo->misc + pos, "ROM end: %08x\n", y);
 
-  genesis_has_ram = OFFSET (genesis_header, 176) == 'R' &&
-                    OFFSET (genesis_header, 177) == 'A';
-  if (genesis_has_ram)
-    {
-      x = (OFFSET (genesis_header, 180) << 24) +
-          (OFFSET (genesis_header, 181) << 16) +
-          (OFFSET (genesis_header, 182) << 8) +
-           OFFSET (genesis_header, 183);
-      y = (OFFSET (genesis_header, 184) << 24) +
-          (OFFSET (genesis_header, 185) << 16) +
-          (OFFSET (genesis_header, 186) << 8) +
-           OFFSET (genesis_header, 187);
+  cd->has_ram = OFFSET (cd->header, 176) == 'R' &&
+                    OFFSET (cd->header, 177) == 'A';
+  if (cd->has_ram)
+    {
+      x = (OFFSET (cd->header, 180) << 24) +
+          (OFFSET (cd->header, 181) << 16) +
+          (OFFSET (cd->header, 182) << 8) +
+           OFFSET (cd->header, 183);
+      y = (OFFSET (cd->header, 184) << 24) +
+          (OFFSET (cd->header, 185) << 16) +
+          (OFFSET (cd->header, 186) << 8) +
+           OFFSET (cd->header, 187);
       pos += sprintf (rominfo->misc + pos, "Cartridge RAM: Yes, %d kBytes (%s)\n",
                       (int) ((y - x + 1) >> 10),
-                      OFFSET (genesis_header, 178) & 0x40 ? "backup" : "non-backup");
+                      OFFSET (cd->header, 178) & 0x40 ? "backup" : "non-backup");
 
       pos += sprintf (rominfo->misc + pos, "RAM start: %08x\n", (int) x);
       pos += sprintf (rominfo->misc + pos, "RAM end: %08x\n", y);
@@ -1798,13 +1874,13 @@ genesis_init (st_ucon64_nfo_t *rominfo)
   // Only checking for 'G' seems to give better results than checking for "GM".
   //  "Officially" "GM" indicates it's a game and "Al" that it's educational.
   pos += sprintf (rominfo->misc + pos, "Product type: %s\n",
-                  (OFFSET (genesis_header, 128) == 'G') ? "Game" : "Educational");
+                  (OFFSET (cd->header, 128) == 'G') ? "Game" : "Educational");
   pos += sprintf (rominfo->misc + pos, "I/O device(s): %s",
-                  NULL_TO_UNKNOWN_S (genesis_io[MIN ((int) OFFSET (genesis_header, 144),
+                  NULL_TO_UNKNOWN_S (genesis_io[MIN ((int) OFFSET (cd->header, 144),
                                        GENESIS_IO_MAX - 1)]));
   for (x = 0; x < 3; x++)
     {
-      const char *io_device = genesis_io[MIN (OFFSET (genesis_header, 145 + x),
+      const char *io_device = genesis_io[MIN (OFFSET (cd->header, 145 + x),
                                 GENESIS_IO_MAX - 1)];
       if (!io_device)
         continue;
@@ -1812,38 +1888,48 @@ genesis_init (st_ucon64_nfo_t *rominfo)
     }
   pos += sprintf (rominfo->misc + pos, "\n");
 
-  pos += sprintf (rominfo->misc + pos, "Modem data: %.10s\n", &OFFSET (genesis_header, 188));
-  pos += sprintf (rominfo->misc + pos, "Memo: %.40s\n", &OFFSET (genesis_header, 200));
-  pos += sprintf (rominfo->misc + pos, "Product code: %.8s\n", &OFFSET (genesis_header, 131));
-  sprintf (rominfo->misc + pos, "Version: 1.%c%c", OFFSET (genesis_header, 140),
-           OFFSET (genesis_header, 141));
+  pos += sprintf (rominfo->misc + pos, "Modem data: %.10s\n", &OFFSET (cd->header, 188));
+  pos += sprintf (rominfo->misc + pos, "Memo: %.40s\n", &OFFSET (cd->header, 200));
+  pos += sprintf (rominfo->misc + pos, "Product code: %.8s\n", &OFFSET (cd->header, 131));
+  sprintf (rominfo->misc + pos, "Version: 1.%c%c", OFFSET (cd->header, 140),
+           OFFSET (cd->header, 141));
 
-  // We can be stricter here than in ucon64.c/ucon64_rom_nfo(), because we know
-  //  we shouldn't have ANSI escape sequences (which ucon64.c/toprint() allows).
+  // We can be stricter here than in p->c/ucon64_rom_nfo(), because we know
+  //  we shouldn't have ANSI escape sequences (which p->c/toprint() allows).
   for (x = 0; rominfo->misc[x] != '\0'; x++)
     if (rominfo->misc[x] != '\n' && !isprint ((int) rominfo->misc[x]))
       rominfo->misc[x] = '.';
 
   // internal ROM crc
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
-      if ((rom_buffer = load_rom (rominfo, ucon64.fname, rom_buffer)) == NULL)
+      st_block_view_t view, raw_view;
+
+      if (view_rom (p, rominfo, &view, &rom_buffer) == -1)
         return -1;
+      // same CRC32 values as load_rom() calculates, without deinterleaving
+      if (cd->copier_type != BIN && p->fcrc32 == 0)
+        {
+          block_view_init (&raw_view, view.data, view.size);
+          p->fcrc32 = ucon64_view_crc32 (0, &raw_view, cd->rom_size);
+        }
+      if (p->crc32 == 0)
+        p->crc32 = ucon64_view_crc32 (0, &view, view.size);
 
       rominfo->has_internal_crc = 1;
       rominfo->internal_crc_len = 2;
 
-      rominfo->current_internal_crc = genesis_chksum (rom_buffer);
-      rominfo->internal_crc = OFFSET (genesis_header, 143);          // low byte of checksum
-      rominfo->internal_crc += (OFFSET (genesis_header, 142)) << 8;  // high byte of checksum
+      rominfo->current_internal_crc = genesis_chksum (&view, cd->rom_size);
+      rominfo->internal_crc = OFFSET (cd->header, 143);          // low byte of checksum
+      rominfo->internal_crc += (OFFSET (cd->header, 142)) << 8;  // high byte of checksum
 
       rominfo->internal_crc2[0] = 0;
       free (rom_buffer);
     }
   rominfo->console_usage = genesis_usage[0].help;
-  if (copier_type == SMD)
+  if (cd->copier_type == SMD)
     rominfo->backup_usage = smd_usage[0].help;
-  else if (copier_type == MGD_GEN)
+  else if (cd->copier_type == MGD_GEN)
     rominfo->backup_usage = mgd_usage[0].help;
   else // copier_type == BIN
     rominfo->backup_usage = bin_usage[0].help;
@@ -1853,13 +1939,26 @@ genesis_init (st_ucon64_nfo_t *rominfo)
 
 
 static int
-genesis_chksum (unsigned char *rom_buffer)
+genesis_chksum (const st_block_view_t *view, unsigned int rom_size)
 {
-  int i, len = genesis_rom_size - 2;
+  unsigned char scratch[MAXBUFSIZE];
+  size_t pos, n, end = rom_size & ~1U;
   unsigned short checksum = 0;
 
-  for (i = 512; i <= len; i += 2)
-    checksum += (rom_buffer[i] << 8) + (rom_buffer[i + 1]);
+  for (pos = 512; pos < end; pos += n)
+    {
+      const unsigned char *ptr;
+      size_t i = 0;
+
+      n = end - pos;
+      ptr = block_view_data (view, pos, &n, scratch, sizeof scratch);
+      if (pos & 1)                              // continue a word of the
+        checksum += ptr[i++];                   //  previous piece
+      for (; i + 1 < n; i += 2)
+        checksum += (ptr[i] << 8) + ptr[i + 1];
+      if (i < n)
+        checksum += ptr[i] << 8;
+    }
 
   return checksum;
 }
@@ -30,7 +30,7 @@ typedef enum { SMD = 1, BIN, MGD_GEN } genesis_copier_t;
 
 extern const st_getopt2_t genesis_usage[];
 
-extern genesis_copier_t genesis_get_copier_type (void);
+extern genesis_copier_t genesis_get_copier_type (st_ucon64_t *p);
 extern int genesis_1991 (st_ucon64_nfo_t *rominfo);
 extern int genesis_chk (st_ucon64_nfo_t *rominfo);
 extern int genesis_j (st_ucon64_nfo_t *rominfo);
@@ -44,7 +44,7 @@ extern int genesis_bin (st_ucon64_nfo_t *rominfo);
 extern int genesis_mgd (st_ucon64_nfo_t *rominfo);
 extern int genesis_mgh (st_ucon64_nfo_t *rominfo);
 extern int genesis_multi (unsigned int truncate_size);
-extern int genesis_init (st_ucon64_nfo_t *rominfo);
+extern int genesis_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int genesis_f (st_ucon64_nfo_t *rominfo);
 
 #endif
@@ -53,46 +53,53 @@ typedef struct st_jaguar
 #define JAGUAR_HEADER_START 0x400
 #define JAGUAR_HEADER_LEN (sizeof (st_jaguar_t))
 
-static st_jaguar_t jaguar_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_jaguar_t header;
+} st_jaguar_data_t;
+#define jaguar_data(p) ((st_jaguar_data_t *) \
+  ucon64_console_data (p, UCON64_JAG, sizeof (st_jaguar_data_t)))
 
 
 int
-jaguar_init (st_ucon64_nfo_t *rominfo)
+jaguar_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_jaguar_data_t *cd = jaguar_data (p);
   int result = -1, x, value;
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  ucon64_fread (&jaguar_header, JAGUAR_HEADER_START +
-                  rominfo->backup_header_len, JAGUAR_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->header, JAGUAR_HEADER_START +
+                  rominfo->backup_header_len, JAGUAR_HEADER_LEN, p->fname);
   value = 0;
   for (x = 0; x < 12; x++)
-    value += OFFSET (jaguar_header, x);
+    value += OFFSET (cd->header, x);
   if (value == 0xb0)
     result = 0;
   else
     {
-      rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                     ucon64.backup_header_len : UNKNOWN_BACKUP_HEADER_LEN;
+      rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                     p->backup_header_len : UNKNOWN_BACKUP_HEADER_LEN;
 
-      ucon64_fread (&jaguar_header, JAGUAR_HEADER_START +
-                      rominfo->backup_header_len, JAGUAR_HEADER_LEN, ucon64.fname);
+      ucon64_fread (&cd->header, JAGUAR_HEADER_START +
+                      rominfo->backup_header_len, JAGUAR_HEADER_LEN, p->fname);
       value = 0;
       for (x = 0; x < 12; x++)
-        value += OFFSET (jaguar_header, x);
+        value += OFFSET (cd->header, x);
 
       if (value == 0xb0)
         result = 0;
       else
         result = -1;
     }
-  if (ucon64.console == UCON64_JAG)
+  if (p->console == UCON64_JAG)
     result = 0;
 
   rominfo->header_start = JAGUAR_HEADER_START;
   rominfo->header_len = JAGUAR_HEADER_LEN;
-  rominfo->header = &jaguar_header;
+  rominfo->header = &cd->header;
 
   rominfo->console_usage = jaguar_usage[0].help;
   rominfo->backup_usage = unknown_backup_usage[0].help;
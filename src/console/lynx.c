@@ -102,7 +102,13 @@ const st_getopt2_t lynx_usage[] =
 #define LNX_HEADER_START 0
 #define LNX_HEADER_LEN (sizeof (st_lnx_header_t))
 
-static st_lnx_header_t lnx_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_lnx_header_t header;
+} st_lynx_data_t;
+#define lynx_data(p) ((st_lynx_data_t *) \
+  ucon64_console_data (p, UCON64_LYNX, sizeof (st_lynx_data_t)))
 
 
 int
@@ -298,46 +304,47 @@ lynx_b1 (st_ucon64_nfo_t *rominfo, const char *value)
 
 
 int
-lynx_init (st_ucon64_nfo_t *rominfo)
+lynx_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_lynx_data_t *cd = lynx_data (p);
   int result = -1;
 
   rominfo->console_usage = lynx_usage[0].help;
   rominfo->backup_usage = unknown_backup_usage[0].help;
 
-  ucon64_fread (&lnx_header, 0, LNX_HEADER_LEN, ucon64.fname);
-  if (!strncmp (lnx_header.magic, "LYNX", 4))
+  ucon64_fread (&cd->header, 0, LNX_HEADER_LEN, p->fname);
+  if (!strncmp (cd->header.magic, "LYNX", 4))
     result = 0;
   else
     result = -1;
-  if (ucon64.console == UCON64_LYNX)
+  if (p->console == UCON64_LYNX)
     result = 0;
 
-  if (!strncmp (lnx_header.magic, "LYNX", 4))
+  if (!strncmp (cd->header.magic, "LYNX", 4))
     {
-      rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                     ucon64.backup_header_len : LNX_HEADER_LEN;
+      rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                     p->backup_header_len : LNX_HEADER_LEN;
 
-      if (UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) &&
-          !ucon64.backup_header_len)
-        return ucon64.console == UCON64_LYNX ? 0 : result;
+      if (UCON64_ISSET2 (p->backup_header_len, unsigned int) &&
+          !p->backup_header_len)
+        return p->console == UCON64_LYNX ? 0 : result;
 
-      ucon64_fread (&lnx_header, 0, LNX_HEADER_LEN, ucon64.fname);
-      rominfo->backup_header = &lnx_header;
+      ucon64_fread (&cd->header, 0, LNX_HEADER_LEN, p->fname);
+      rominfo->backup_header = &cd->header;
 
       // internal ROM name
 #if     defined __GNUC__ && __GNUC__ >= 8
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstringop-truncation"
 #endif
-      strncpy (rominfo->name, lnx_header.cartname, sizeof lnx_header.cartname - 1)
-        [sizeof lnx_header.cartname - 1] = '\0';
+      strncpy (rominfo->name, cd->header.cartname, sizeof cd->header.cartname - 1)
+        [sizeof cd->header.cartname - 1] = '\0';
 #if     defined __GNUC__ && __GNUC__ >= 8
 #pragma GCC diagnostic pop
 #endif
 
       // ROM maker
-      rominfo->maker = lnx_header.manufname;
+      rominfo->maker = cd->header.manufname;
 
       // misc stuff
       sprintf (rominfo->misc,
@@ -346,20 +353,20 @@ lynx_init (st_ucon64_nfo_t *rominfo)
                "Version: %hd\n"
                "Rotation: %s",
 #ifdef  WORDS_BIGENDIAN
-               (short) (bswap_16 (lnx_header.page_size_bank0) * 256),
-               TOMBIT_F (bswap_16 (lnx_header.page_size_bank0) * 256),
-               (short) (bswap_16 (lnx_header.page_size_bank1) * 256),
-               TOMBIT_F (bswap_16 (lnx_header.page_size_bank1) * 256),
-               bswap_16 (lnx_header.version),
+               (short) (bswap_16 (cd->header.page_size_bank0) * 256),
+               TOMBIT_F (bswap_16 (cd->header.page_size_bank0) * 256),
+               (short) (bswap_16 (cd->header.page_size_bank1) * 256),
+               TOMBIT_F (bswap_16 (cd->header.page_size_bank1) * 256),
+               bswap_16 (cd->header.version),
 #else
-               (short) (lnx_header.page_size_bank0 * 256),
-               TOMBIT_F (lnx_header.page_size_bank0 * 256),
-               (short) (lnx_header.page_size_bank1 * 256),
-               TOMBIT_F (lnx_header.page_size_bank1 * 256),
-               lnx_header.version,
+               (short) (cd->header.page_size_bank0 * 256),
+               TOMBIT_F (cd->header.page_size_bank0 * 256),
+               (short) (cd->header.page_size_bank1 * 256),
+               TOMBIT_F (cd->header.page_size_bank1 * 256),
+               cd->header.version,
 #endif
-               !lnx_header.rotation ?
-                 "No" : lnx_header.rotation == 1 ?
+               !cd->header.rotation ?
+                 "No" : cd->header.rotation == 1 ?
                    "Left" : "Right");
     }
 
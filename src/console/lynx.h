@@ -48,6 +48,6 @@ extern int lynx_n (st_ucon64_nfo_t *rominfo, const char *name);
 extern int lynx_nrot (st_ucon64_nfo_t *rominfo);
 extern int lynx_rotl (st_ucon64_nfo_t *rominfo);
 extern int lynx_rotr (st_ucon64_nfo_t *rominfo);
-extern int lynx_init (st_ucon64_nfo_t *rominfo);
+extern int lynx_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 
 #endif // LYNX_H
@@ -41,6 +41,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "misc/chksum.h"
 #include "misc/file.h"
 #include "misc/misc.h"
+#include "misc/xform.h"
 #include "ucon64_misc.h"
 #include "console/n64.h"
 #include "backup/backup.h"
@@ -102,6 +103,11 @@ const st_getopt2_t n64_usage[] =
       NULL, "convert to Mr. Backup Z64 (not interleaved)",
       &n64_obj[4]
     },
+    {
+      "n64le", 0, 0, UCON64_N64LE,
+      NULL, "convert to little-endian .n64 format (4321)",
+      &n64_obj[4]
+    },
     {
       "dint", 0, 0, UCON64_DINT,
       NULL, "convert ROM to (non-)interleaved format (1234 <-> 2143)",
@@ -184,49 +190,188 @@ typedef struct st_n64_header
 #endif
 } st_n64_header_t;
 
-static st_n64_header_t n64_header;
-
 typedef struct st_n64_chksum
 {
   unsigned int crc1;
   unsigned int crc2;
 } st_n64_chksum_t;
 
-static st_n64_chksum_t n64crc;
-static int n64_chksum (st_ucon64_nfo_t *rominfo, const char *filename);
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_n64_header_t header;
+  st_n64_chksum_t crc;                          // calculated by n64_chksum()
+} st_n64_data_t;
+#define n64_data(p) ((st_n64_data_t *) \
+  ucon64_console_data (p, UCON64_N64, sizeof (st_n64_data_t)))
+
+/*
+  Byte orders of N64 ROM data. The values are masks that are XOR'ed with the
+  offset of a byte in a big-endian 32-bit word to get its offset in the layout.
+*/
+#define N64_Z64 0                               // 1234, not interleaved
+#define N64_V64 1                               // 2143, interleaved
+#define N64_N64 3                               // 4321, little-endian .n64
 
+#define N64_BLOCK_SIZE (1024 * 1024)
 
-int
-n64_v64 (st_ucon64_nfo_t *rominfo)
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct st_n64_chksum_ctx
 {
-  char dest_name[FILENAME_MAX];
+  unsigned int t1, t2, t3, t4, t5, t6;          // CIC checksum lanes
+  unsigned int bootcode;
+  unsigned int fcrc32, scrc32;                  // file CRC32 & search CRC32
+  int layout;                                   // layout of the ROM data
+  int dat_layout;                               // layout of the DAT files
+  unsigned char bootcode_buf[N64_BC_SIZE];
+} st_n64_chksum_ctx_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+static int n64_chksum (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, const char *filename);
+static void n64_chksum_update (st_n64_chksum_ctx_t *ctx, unsigned char *buf,
+                               size_t n, uint64_t pos);
 
+
+static void
+n64_convert_layout (unsigned char *buf, size_t n, int from, int to)
+{
+  switch (from ^ to)
+    {
+    case 1:                                     // 1234 <-> 2143
+      mem_bswap16 (buf, n);
+      break;
+    case 2:                                     // 1234 <-> 3412
+      mem_wswap32 (buf, n);
+      break;
+    case 3:                                     // 1234 <-> 4321
+      mem_bswap32 (buf, n);
+      break;
+    }
+}
+
+
+static int
+n64_process (const char *filename, uint64_t start, uint64_t len, int layout,
+             st_n64_chksum_ctx_t *ctx, FILE *destfile, int dest_layout)
+/*
+  Read len bytes of the ROM data in filename from offset start, in blocks of
+  N64_BLOCK_SIZE bytes. The data in the file has byte order layout. Every block
+  is read only once: it is passed to ctx (if not NULL) and then written to
+  destfile (if not NULL) in byte order dest_layout. The data is taken from the
+  image of the file if ucon64 has one.
+*/
+{
+  const unsigned char *image;
+  unsigned char *buf;
+  uint64_t image_size, pos;
+  FILE *file = NULL;
+  int result = 0;
+
+  if ((buf = (unsigned char *) malloc (N64_BLOCK_SIZE)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], N64_BLOCK_SIZE);
+      return -1;
+    }
+  if ((image = quick_io_ctx_data (filename, &image_size)) != NULL)
+    len = start < image_size ? MIN (len, image_size - start) : 0;
+  else if ((file = fopen (filename, "rb")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], filename);
+      free (buf);
+      return -1;
+    }
+  else
+    fseek (file, (long) start, SEEK_SET);
+
+  for (pos = 0; pos < len; pos += N64_BLOCK_SIZE)
+    {
+      size_t n = (size_t) MIN (len - pos, N64_BLOCK_SIZE);
+      int block_layout = layout;
+
+      if (image)
+        memcpy (buf, image + start + pos, n);
+      else if ((n = fread (buf, 1, n, file)) == 0)
+        break;
+
+      if (ctx)
+        {
+          n64_chksum_update (ctx, buf, n, pos);
+          block_layout = N64_Z64;
+        }
+      if (destfile)
+        {
+          n64_convert_layout (buf, n, block_layout, dest_layout);
+          if (fwrite (buf, 1, n, destfile) != n)
+            {
+              result = -1;                      // caller reports the error
+              break;
+            }
+        }
+      if (n < N64_BLOCK_SIZE)
+        break;
+    }
+
+  if (file)
+    fclose (file);
+  free (buf);
+  return result;
+}
+
+
+static int
+n64_convert (st_ucon64_nfo_t *rominfo, const char *suffix, int dest_layout)
+{
+  char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
+  FILE *destfile;
+  int result;
+
+  strcpy (src_name, ucon64.fname);
   strcpy (dest_name, ucon64.fname);
-  set_suffix (dest_name, ".v64");
-  ucon64_file_handler (dest_name, NULL, 0);
-  fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb");
-  if (!rominfo->interleaved)
-    ucon64_fbswap16 (dest_name, 0, ucon64.fsize);
+  set_suffix (dest_name, suffix);
+  ucon64_file_handler (dest_name, src_name, 0);
+  if ((destfile = fopen (dest_name, "wb")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], dest_name);
+      return -1;
+    }
+  // the whole file is converted in one pass, as the original code did
+  result = n64_process (src_name, 0, ucon64.fsize,
+                        rominfo->interleaved ? N64_V64 : N64_Z64, NULL,
+                        destfile, dest_layout);
+  if (ferror (destfile))
+    fprintf (stderr, ucon64_msg[WRITE_ERROR], dest_name);
+  fclose (destfile);
+
+  if (result == 0)
+    printf (ucon64_msg[WROTE], dest_name);
+  remove_temp_file ();
+  return result;
+}
 
-  printf (ucon64_msg[WROTE], dest_name);
-  return 0;
+
+int
+n64_v64 (st_ucon64_nfo_t *rominfo)
+{
+  return n64_convert (rominfo, ".v64", N64_V64);
 }
 
 
 int
 n64_z64 (st_ucon64_nfo_t *rominfo)
 {
-  char dest_name[FILENAME_MAX];
+  return n64_convert (rominfo, ".z64", N64_Z64);
+}
 
-  strcpy (dest_name, ucon64.fname);
-  set_suffix (dest_name, ".z64");
-  ucon64_file_handler (dest_name, NULL, 0);
-  fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb");
-  if (rominfo->interleaved)
-    ucon64_fbswap16 (dest_name, 0, ucon64.fsize);
 
-  printf (ucon64_msg[WROTE], dest_name);
-  return 0;
+int
+n64_n64le (st_ucon64_nfo_t *rominfo)
+{
+  return n64_convert (rominfo, ".n64", N64_N64);
 }
 
 
@@ -266,11 +411,12 @@ n64_f (st_ucon64_nfo_t *rominfo)
 static void
 n64_update_chksum (st_ucon64_nfo_t *rominfo, const char *filename, char *buf)
 {
+  st_n64_data_t *cd = n64_data (&ucon64);
   uint64_t crc;
   int x;
 
-  // n64crc is set by n64_chksum() when called from n64_init()
-  crc = (((uint64_t) n64crc.crc1) << 32) | n64crc.crc2;
+  // cd->crc is set by n64_chksum() when called from n64_init()
+  crc = (((uint64_t) cd->crc.crc1) << 32) | cd->crc.crc2;
   for (x = 0; x < 8; x++)
     {
       buf[x] = (char) (crc >> 56);
@@ -328,7 +474,7 @@ n64_sram (st_ucon64_nfo_t *rominfo, const char *sramfile)
   ucon64_file_handler (dest_name, NULL, 0);
   fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb");
   ucon64_fwrite (sram, 0x286c0, N64_SRAM_SIZE, dest_name, "r+b");
-  if (n64_chksum (rominfo, dest_name) == 0)     // calculate the checksum of the modified file
+  if (n64_chksum (&ucon64, rominfo, dest_name) == 0) // calculate the checksum of the modified file
     n64_update_chksum (rominfo, dest_name, buf);
 
   printf (ucon64_msg[WROTE], dest_name);
@@ -419,8 +565,9 @@ n64_usms (st_ucon64_nfo_t *rominfo, const char *smsrom)
 
 
 int
-n64_init (st_ucon64_nfo_t *rominfo)
+n64_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_n64_data_t *cd = n64_data (p);
   int result = -1;
   unsigned int value = 0;
 #define N64_MAKER_MAX 0x50
@@ -466,15 +613,15 @@ n64_init (st_ucon64_nfo_t *rominfo)
       "Australia", NULL, NULL, "France, Germany, The Netherlands", NULL // Holland is an incorrect name for The Netherlands
     };
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  ucon64_fread (&n64_header, rominfo->backup_header_len, N64_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->header, rominfo->backup_header_len, N64_HEADER_LEN, p->fname);
 
-  value = OFFSET (n64_header, 0);
-  value += OFFSET (n64_header, 1) << 8;
-  value += OFFSET (n64_header, 2) << 16;
-  value += OFFSET (n64_header, 3) << 24;
+  value = OFFSET (cd->header, 0);
+  value += OFFSET (cd->header, 1) << 8;
+  value += OFFSET (cd->header, 2) << 16;
+  value += OFFSET (cd->header, 3) << 24;
   /*
     0x41123780 and 0x12418037 can be found in te following files:
     2 Blokes & An Armchair - Nintendo 64 Remix Remix (PD)
@@ -494,63 +641,67 @@ n64_init (st_ucon64_nfo_t *rominfo)
   else
     result = -1;
 
-  if (UCON64_ISSET (ucon64.interleaved))
-    rominfo->interleaved = ucon64.interleaved;
-  if (ucon64.console == UCON64_N64)
+  if (UCON64_ISSET (p->interleaved))
+    rominfo->interleaved = p->interleaved;
+  if (p->console == UCON64_N64)
     result = 0;
 
   // internal ROM header
   rominfo->header_start = 0;
   rominfo->header_len = N64_HEADER_LEN;
-  rominfo->header = &n64_header;
+  rominfo->header = &cd->header;
 
   // internal ROM name
-  strncpy (rominfo->name, (char *) &OFFSET (n64_header, 32), N64_NAME_LEN);
+  strncpy (rominfo->name, (char *) &OFFSET (cd->header, 32), N64_NAME_LEN);
   if (rominfo->interleaved)
     ucon64_bswap16_n (rominfo->name, N64_NAME_LEN);
   rominfo->name[N64_NAME_LEN] = '\0';
 
   // ROM maker
   rominfo->maker = NULL_TO_UNKNOWN_S (n64_maker[MIN (OFFSET
-    (n64_header, 59 ^ rominfo->interleaved), N64_MAKER_MAX - 1)]);
+    (cd->header, 59 ^ rominfo->interleaved), N64_MAKER_MAX - 1)]);
 
   // ROM country
   rominfo->country = NULL_TO_UNKNOWN_S (n64_country[MIN (OFFSET
-    (n64_header, 63 ^ (!rominfo->interleaved)), N64_COUNTRY_MAX - 1)]);
+    (cd->header, 63 ^ (!rominfo->interleaved)), N64_COUNTRY_MAX - 1)]);
 
   // CRC stuff
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
       int x;
 
       rominfo->has_internal_crc = 1;
       rominfo->internal_crc_len = 4;
 
-      if (n64_chksum (rominfo, ucon64.fname) == 0)
-        rominfo->current_internal_crc = n64crc.crc1;
+      if (n64_chksum (p, rominfo, p->fname) == 0)
+        rominfo->current_internal_crc = cd->crc.crc1;
       else
-        rominfo->current_internal_crc = 0;
+        {
+          // don't show the 2nd checksum of the previous file
+          cd->crc.crc1 = cd->crc.crc2 = 0;
+          rominfo->current_internal_crc = 0;
+        }
 
       value = 0;
       for (x = 0; x < 4; x++)
         {
           rominfo->internal_crc <<= 8;
-          rominfo->internal_crc += OFFSET (n64_header, 16 + (x ^ rominfo->interleaved));
+          rominfo->internal_crc += OFFSET (cd->header, 16 + (x ^ rominfo->interleaved));
           value <<= 8;
-          value += OFFSET (n64_header, 20 + (x ^ rominfo->interleaved));
+          value += OFFSET (cd->header, 20 + (x ^ rominfo->interleaved));
         }
 
       sprintf (rominfo->internal_crc2,
                "2nd Checksum: %s, 0x%08x (calculated) %c= 0x%08x (internal)",
-               n64crc.crc2 == value ?
+               cd->crc.crc2 == value ?
 #ifdef  USE_ANSI_COLOR
-                 ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                 ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
+                 p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                 p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
 #else
                  "OK" : "Bad",
 #endif
-               n64crc.crc2,
-               (n64crc.crc2 == value) ? '=' : '!', value);
+               cd->crc.crc2,
+               (cd->crc.crc2 == value) ? '=' : '!', value);
     }
 
   rominfo->console_usage = n64_usage[0].help;
@@ -567,10 +718,7 @@ n64_init (st_ucon64_nfo_t *rominfo)
   Nintendo 64 ROMs.
 */
 #define ROL(i, b) (((i) << (b)) | ((i) >> (32 - (b))))
-#define BYTES2LONG(b, s) ( (b)[0 ^ (s)] << 24 | \
-                           (b)[1 ^ (s)] << 16 | \
-                           (b)[2 ^ (s)] <<  8 | \
-                           (b)[3 ^ (s)] )
+#define BYTES2LONG(b) ((b)[0] << 24 | (b)[1] << 16 | (b)[2] << 8 | (b)[3])
 
 #define CHECKSUM_START   0x1000 //(N64_HEADER_LEN + N64_BC_SIZE)
 #define CHECKSUM_LENGTH  0x100000
@@ -578,186 +726,139 @@ n64_init (st_ucon64_nfo_t *rominfo)
 #define CHECKSUM_CIC6103 0xa3886759
 #define CHECKSUM_CIC6105 0xdf26f436
 #define CHECKSUM_CIC6106 0x1fea617a
-#define CALC_CRC32                              // see this as a marker, don't disable
 
-static int
-n64_chksum (st_ucon64_nfo_t *rominfo, const char *filename)
+static void
+n64_chksum_begin (st_n64_chksum_ctx_t *ctx, int layout, int dat_layout)
 {
-  unsigned char bootcode_buf[N64_BC_SIZE], chunk[MAXBUFSIZE & ~3]; // size must be a multiple of 4
-  unsigned int i, c1, k1, k2, t1, t2, t3, t4, t5, t6, bootcode,
-               clen = CHECKSUM_LENGTH, // using ucon64.fsize is OK for n64_init() & n64_sram()
-               rlen = (unsigned int) ucon64.fsize - rominfo->backup_header_len,
-               n = rlen;
-  FILE *file;
-#ifdef  CALC_CRC32
-  unsigned int scrc32 = 0, fcrc32 = 0;          // search CRC32 & file CRC32
-  int swap_data = ucon64.n64_dat_v64 ? !rominfo->interleaved : rominfo->interleaved;
-#endif
+  memset (ctx, 0, sizeof (st_n64_chksum_ctx_t));
+  ctx->layout = layout;
+  ctx->dat_layout = dat_layout;
+}
 
-  rlen -= MIN (rlen, CHECKSUM_START);
-  if (rlen < CHECKSUM_LENGTH)
-    {
-#ifdef  CALC_CRC32
-      unsigned char *crc32_mem;
 
-      if ((crc32_mem = (unsigned char *) malloc (n)) == NULL)
-        {
-          fprintf (stderr, ucon64_msg[BUFFER_ERROR], n);
-          return -1;
-        }
-      ucon64_fread (crc32_mem, rominfo->backup_header_len, n, filename);
-      if (swap_data)
-        {
-          ucon64.fcrc32 = crc32 (0, crc32_mem, n);
-          ucon64_bswap16_n (crc32_mem, n);
-        }
-      ucon64.crc32 = crc32 (0, crc32_mem, n);
-      free (crc32_mem);
-#endif
-      return -1;                                // ROM is too small
-    }
-
-  if ((file = fopen (filename, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], filename);
-      return -1;
-    }
+static void
+n64_chksum_update (st_n64_chksum_ctx_t *ctx, unsigned char *buf, size_t n,
+                   uint64_t pos)
+/*
+  Process the n bytes of ROM data in buf, which start at offset pos of the ROM
+  data. The blocks must be passed in order, pos must be a multiple of 4 and the
+  first block must contain the header and the boot code. buf is converted to
+  the Z64 layout.
+*/
+{
+  int layout = ctx->layout;
+  uint64_t start, end;
+  unsigned int i, c1, k1, k2;
 
-#ifdef  CALC_CRC32
-  fseek (file, rominfo->backup_header_len, SEEK_SET);
-  n = (unsigned int) fread (chunk, 1, N64_HEADER_LEN + N64_BC_SIZE, file);
-  if (n < N64_HEADER_LEN + N64_BC_SIZE)
-    {
-      fprintf (stderr, ucon64_msg[READ_ERROR], filename);
-      return -1;
-    }
-  memcpy (bootcode_buf, chunk + N64_HEADER_LEN, N64_BC_SIZE);
-  if (swap_data)
-    {
-      fcrc32 = crc32 (0, chunk, n);
-      ucon64_bswap16_n (chunk, n);
-    }
-  scrc32 = crc32 (0, chunk, n);
-#endif
-  if (rominfo->interleaved)
-    ucon64_bswap16_n (bootcode_buf, N64_BC_SIZE);
-  n = crc32 (0, bootcode_buf, N64_BC_SIZE);
-  if (n == 0x0b050ee0)
-    {
-      bootcode = 6103;
-      i = CHECKSUM_CIC6103;
-    }
-  else if (n == 0x98bc2c86)
-    {
-      bootcode = 6105;
-      i = CHECKSUM_CIC6105;
-    }
-  else if (n == 0xacc8580a)
-    {
-      bootcode = 6106;
-      i = CHECKSUM_CIC6106;
-    }
+  // the search CRC32 is calculated over the layout of the DAT files
+  if (layout == ctx->dat_layout)
+    ctx->scrc32 = crc32 (ctx->scrc32, buf, n);
   else
     {
-      bootcode = 0;                             // everything else
-      i = CHECKSUM_CIC6102;
+      ctx->fcrc32 = crc32 (ctx->fcrc32, buf, n);
+      n64_convert_layout (buf, n, layout, ctx->dat_layout);
+      layout = ctx->dat_layout;
+      ctx->scrc32 = crc32 (ctx->scrc32, buf, n);
     }
+  n64_convert_layout (buf, n, layout, N64_Z64);
 
-  t1 = i;
-  t2 = i;
-  t3 = i;
-  t4 = i;
-  t5 = i;
-  t6 = i;
-
-  for (;;)
+  if (pos == 0 && n >= CHECKSUM_START)
     {
-      if (rlen > 0)
+      memcpy (ctx->bootcode_buf, buf + N64_HEADER_LEN, N64_BC_SIZE);
+      i = crc32 (0, ctx->bootcode_buf, N64_BC_SIZE);
+      if (i == 0x0b050ee0)
         {
-          if ((n = (unsigned int) fread (chunk, 1,
-                                         MIN (sizeof chunk, clen), file)) != 0)
-            {
-#ifdef  CALC_CRC32
-              if (swap_data)
-                {
-                  fcrc32 = crc32 (fcrc32, chunk, n);
-                  ucon64_bswap16_n (chunk, n);
-                }
-              scrc32 = crc32 (scrc32, chunk, n);
-#endif
-            }
+          ctx->bootcode = 6103;
+          i = CHECKSUM_CIC6103;
+        }
+      else if (i == 0x98bc2c86)
+        {
+          ctx->bootcode = 6105;
+          i = CHECKSUM_CIC6105;
+        }
+      else if (i == 0xacc8580a)
+        {
+          ctx->bootcode = 6106;
+          i = CHECKSUM_CIC6106;
         }
       else
-        n = MIN (sizeof chunk, clen);
-
-      n &= ~3;
-      if (n == 0)
-        break;
-      for (i = 0; i < n; i += 4)
         {
-          c1 = BYTES2LONG (&chunk[i], rominfo->interleaved ^ swap_data);
-          k1 = t6 + c1;
-          if (k1 < t6)
-            t4++;
-          t6 = k1;
-          t3 ^= c1;
-          k2 = c1 & 0x1f;
-          k1 = k2 > 0 ? ROL (c1, k2) : c1;
-          t5 += k1;
-          if (c1 < t2)
-            t2 ^= k1;
-          else
-            t2 ^= t6 ^ c1;
-
-          if (bootcode == 6105)
-            {
-              k1 = 0x710 + (i & 0xff);
-              t1 += ((bootcode_buf[k1] << 24) | (bootcode_buf[k1 + 1] << 16) |
-                     (bootcode_buf[k1 + 2] <<  8) | bootcode_buf[k1 + 3]) ^ c1;
-            }
-          else
-            t1 += c1 ^ t5;
+          ctx->bootcode = 0;                    // everything else
+          i = CHECKSUM_CIC6102;
         }
-      if (rlen > 0)
+      ctx->t1 = ctx->t2 = ctx->t3 = ctx->t4 = ctx->t5 = ctx->t6 = i;
+    }
+
+  start = MAX (pos, CHECKSUM_START);
+  end = MIN (pos + n, CHECKSUM_START + CHECKSUM_LENGTH) & ~(uint64_t) 3;
+  for (; start < end; start += 4)
+    {
+      c1 = BYTES2LONG (&buf[start - pos]);
+      k1 = ctx->t6 + c1;
+      if (k1 < ctx->t6)
+        ctx->t4++;
+      ctx->t6 = k1;
+      ctx->t3 ^= c1;
+      k2 = c1 & 0x1f;
+      k1 = k2 > 0 ? ROL (c1, k2) : c1;
+      ctx->t5 += k1;
+      if (c1 < ctx->t2)
+        ctx->t2 ^= k1;
+      else
+        ctx->t2 ^= ctx->t6 ^ c1;
+
+      if (ctx->bootcode == 6105)
         {
-          rlen -= MIN (rlen, n);
-          if (rlen == 0)
-            memset (chunk, 0, sizeof chunk);
+          k1 = 0x710 + ((unsigned int) start & 0xff);
+          ctx->t1 += BYTES2LONG (&ctx->bootcode_buf[k1]) ^ c1;
         }
-      clen -= n;
+      else
+        ctx->t1 += c1 ^ ctx->t5;
     }
-  if (bootcode == 6103)
+}
+
+
+static void
+n64_chksum_end (st_n64_chksum_ctx_t *ctx, st_n64_chksum_t *crc)
+{
+  if (ctx->bootcode == 6103)
     {
-      n64crc.crc1 = (t6 ^ t4) + t3;
-      n64crc.crc2 = (t5 ^ t2) + t1;
+      crc->crc1 = (ctx->t6 ^ ctx->t4) + ctx->t3;
+      crc->crc2 = (ctx->t5 ^ ctx->t2) + ctx->t1;
     }
-  else if (bootcode == 6106)
+  else if (ctx->bootcode == 6106)
     {
-      n64crc.crc1 = t6 * t4 + t3;
-      n64crc.crc2 = t5 * t2 + t1;
+      crc->crc1 = ctx->t6 * ctx->t4 + ctx->t3;
+      crc->crc2 = ctx->t5 * ctx->t2 + ctx->t1;
     }
   else
     {
-      n64crc.crc1 = t6 ^ t4 ^ t3;
-      n64crc.crc2 = t5 ^ t2 ^ t1;
-    }
-
-#ifdef  CALC_CRC32
-  while ((n = (unsigned int) fread (chunk, 1, sizeof chunk, file)) != 0)
-    {
-      if (swap_data)
-        {
-          fcrc32 = crc32 (fcrc32, chunk, n);
-          ucon64_bswap16_n (chunk, n);
-        }
-      scrc32 = crc32 (scrc32, chunk, n);
+      crc->crc1 = ctx->t6 ^ ctx->t4 ^ ctx->t3;
+      crc->crc2 = ctx->t5 ^ ctx->t2 ^ ctx->t1;
     }
+}
 
-  ucon64.crc32 = scrc32;
-  if (swap_data)
-    ucon64.fcrc32 = fcrc32;
-#endif
 
-  fclose (file);
+static int
+n64_chksum (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, const char *filename)
+{
+  st_n64_data_t *cd = n64_data (p);
+  st_n64_chksum_ctx_t ctx;
+  // using p->fsize is OK for n64_init() & n64_sram()
+  uint64_t len = p->fsize - rominfo->backup_header_len;
+
+  n64_chksum_begin (&ctx, rominfo->interleaved ? N64_V64 : N64_Z64,
+                    p->settings->n64_dat_v64 ? N64_V64 : N64_Z64);
+  if (n64_process (filename, rominfo->backup_header_len, len, ctx.layout,
+                   &ctx, NULL, N64_Z64) == -1)
+    return -1;
+
+  p->crc32 = ctx.scrc32;
+  if (ctx.layout != ctx.dat_layout)
+    p->fcrc32 = ctx.fcrc32;
+
+  if (len < CHECKSUM_START + CHECKSUM_LENGTH)
+    return -1;                                  // ROM is too small
+  n64_chksum_end (&ctx, &cd->crc);
   return 0;
 }
@@ -30,8 +30,9 @@ extern const st_getopt2_t n64_usage[];
 extern int n64_bot (st_ucon64_nfo_t *rominfo, const char *bootfile);
 extern int n64_chk (st_ucon64_nfo_t *rominfo);
 extern int n64_f (st_ucon64_nfo_t *rominfo);
-extern int n64_init (st_ucon64_nfo_t *rominfo);
+extern int n64_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int n64_n (st_ucon64_nfo_t *rominfo, const char *name);
+extern int n64_n64le (st_ucon64_nfo_t *rominfo);
 extern int n64_sram (st_ucon64_nfo_t *rominfo, const char *sramfile);
 extern int n64_usms (st_ucon64_nfo_t *rominfo, const char *smsrom);
 extern int n64_v64 (st_ucon64_nfo_t *rominfo);
@@ -38,7 +38,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define NDS_HEADER_LEN (sizeof (st_nds_header_t))
 #define NDS_LOGODATA_LEN 156
 
-static int nds_chksum (void);
+static int nds_chksum (st_ucon64_t *p);
 
 
 static st_ucon64_obj_t nds_obj[] =
@@ -122,7 +122,13 @@ typedef struct st_nds_header
   unsigned char zero[144];
 } st_nds_header_t;
 
-static st_nds_header_t nds_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_nds_header_t header;
+} st_nds_data_t;
+#define nds_data(p) ((st_nds_data_t *) \
+  ucon64_console_data (p, UCON64_NDS, sizeof (st_nds_data_t)))
 
 static const unsigned char nds_logodata[NDS_LOGODATA_LEN] =
   {
@@ -211,46 +217,47 @@ nds_chk (st_ucon64_nfo_t *rominfo)
 
 
 int
-nds_init (st_ucon64_nfo_t *rominfo)
+nds_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_nds_data_t *cd = nds_data (p);
   int result = -1, value;
   unsigned int pos = (unsigned int) strlen (rominfo->misc);
   char buf[144];
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  if (ucon64.fsize - rominfo->backup_header_len <
+  if (p->fsize - rominfo->backup_header_len <
         NDS_HEADER_START + NDS_HEADER_LEN)
     return -1;
 
-  ucon64_fread (&nds_header, NDS_HEADER_START + rominfo->backup_header_len,
-                NDS_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->header, NDS_HEADER_START + rominfo->backup_header_len,
+                NDS_HEADER_LEN, p->fname);
 
   // identify the ROM by the zero area
   memset (&buf, 0, 144);
-  if (!memcmp (nds_header.zero, buf, 144) &&
-      nds_header.application_end_offset > 0)
+  if (!memcmp (cd->header.zero, buf, 144) &&
+      cd->header.application_end_offset > 0)
     result = 0;
   else
     result = -1;
-  if (ucon64.console == UCON64_NDS)
+  if (p->console == UCON64_NDS)
     result = 0;
 
   rominfo->header_start = NDS_HEADER_START;
   rominfo->header_len = NDS_HEADER_LEN;
-  rominfo->header = &nds_header;
+  rominfo->header = &cd->header;
 
   // internal ROM name
-  strncpy (rominfo->name, nds_header.title, NDS_NAME_LEN);
+  strncpy (rominfo->name, cd->header.title, NDS_NAME_LEN);
   rominfo->name[NDS_NAME_LEN] = '\0';
 
   // ROM maker
   {
-    int ih = nds_header.maker_high <= '9' ?
-               nds_header.maker_high - '0' : nds_header.maker_high - 'A' + 10,
-        il = nds_header.maker_low <= '9' ?
-               nds_header.maker_low - '0' : nds_header.maker_low - 'A' + 10;
+    int ih = cd->header.maker_high <= '9' ?
+               cd->header.maker_high - '0' : cd->header.maker_high - 'A' + 10,
+        il = cd->header.maker_low <= '9' ?
+               cd->header.maker_low - '0' : cd->header.maker_low - 'A' + 10;
     value = ih * 36 + il;
   }
   if (value < 0 || value >= NINTENDO_MAKER_LEN)
@@ -259,38 +266,38 @@ nds_init (st_ucon64_nfo_t *rominfo)
 
   // ROM country
   rominfo->country =
-    (nds_header.game_id_country == 'J') ? "Japan/Asia" :
-    (nds_header.game_id_country == 'E') ? "U.S.A." :
-    (nds_header.game_id_country == 'P') ? "Europe, Australia and Africa" :
+    (cd->header.game_id_country == 'J') ? "Japan/Asia" :
+    (cd->header.game_id_country == 'E') ? "U.S.A." :
+    (cd->header.game_id_country == 'P') ? "Europe, Australia and Africa" :
     "Unknown country";
 
   // misc stuff
   pos += sprintf (rominfo->misc + pos, "Version: 1.%u\n",
-                  nds_header.romversion);
+                  cd->header.romversion);
   pos += sprintf (rominfo->misc + pos, "Unit code: 0x%02x\n",
-                  nds_header.unitcode);
+                  cd->header.unitcode);
   pos += sprintf (rominfo->misc + pos, "Device type: 0x%02x\n",
-                  nds_header.devicetype);
+                  cd->header.devicetype);
   pos += sprintf (rominfo->misc + pos, "Device capacity: %d Mb\n",
-                  1 << nds_header.devicecap);
+                  1 << cd->header.devicecap);
 
   sprintf (rominfo->misc + pos, "Logo data: %s",
-           memcmp (nds_header.logo, nds_logodata, NDS_LOGODATA_LEN) == 0 ?
+           memcmp (cd->header.logo, nds_logodata, NDS_LOGODATA_LEN) == 0 ?
 #ifdef  USE_ANSI_COLOR
-             ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-             ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
+             p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+             p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad");
 #else
              "OK" : "Bad");
 #endif
 
   // internal ROM crc
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
       rominfo->has_internal_crc = 1;
       rominfo->internal_crc_len = 2;
-      rominfo->current_internal_crc = nds_chksum ();
+      rominfo->current_internal_crc = nds_chksum (p);
 
-      rominfo->internal_crc = nds_header.header_crc;
+      rominfo->internal_crc = cd->header.header_crc;
       rominfo->internal_crc2[0] = 0;
     }
 
@@ -303,8 +310,8 @@ nds_init (st_ucon64_nfo_t *rominfo)
 
 
 static int
-nds_chksum (void)
+nds_chksum (st_ucon64_t *p)
 // Note that this function only calculates the checksum of the internal header
 {
-  return (~chksum_crc16 (0, &nds_header, 0x15e)) & 0xffff;
+  return (~chksum_crc16 (0, &nds_data (p)->header, 0x15e)) & 0xffff;
 }
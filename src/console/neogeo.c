@@ -255,10 +255,11 @@ neogeo_s (void)
 
 
 int
-neogeo_init (st_ucon64_nfo_t *rominfo)
+neogeo_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   int result = -1;
 
+  (void) p;
   rominfo->console_usage = neogeo_usage[0].help;
   rominfo->backup_usage = unknown_backup_usage[0].help;
 
@@ -28,7 +28,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 extern const st_getopt2_t neogeo_usage[];
 
 extern int neogeo_bios (const char *fname);
-extern int neogeo_init (st_ucon64_nfo_t *rominfo);
+extern int neogeo_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int neogeo_mgd (void);
 extern int neogeo_mvs (void);
 extern int neogeo_s (void);
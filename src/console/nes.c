@@ -5076,8 +5076,6 @@ static const st_nes_data_t nes_data[] =
     { 0xffef86c8, 126, 0, 0 }
   };
 
-static nes_file_t type;
-
 static const st_getopt2_t ines_usage[] =
   {
     {NULL, 0, 0, 0, NULL, "iNES header", NULL},
@@ -5102,9 +5100,18 @@ static const st_getopt2_t fds_usage[] =
     {NULL, 0, 0, 0, NULL, NULL, NULL}
   };
 
-static st_ines_header_t ines_header;
-static st_unif_header_t unif_header;
-static st_smc_header_t ffe_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  nes_file_t type;
+  st_ines_header_t ines_header;
+  st_unif_header_t unif_header;
+  st_smc_header_t ffe_header;
+  const char *internal_name;                    // set by nes_n()
+  unsigned int chunk_pos;                       // read position of read_chunk()
+} st_nes_state_t;
+#define nes_state(p) ((st_nes_state_t *) \
+  ucon64_console_data (p, UCON64_NES, sizeof (st_nes_state_t)))
 
 #if     UNIF_REVISION > 7
 static const char unif_ucon64_sig[] =
@@ -5130,7 +5137,6 @@ static const uint32_t unif_cck_ids[] = { CCK0_ID, CCK1_ID, CCK2_ID, CCK3_ID,
                                          CCKC_ID, CCKD_ID, CCKE_ID, CCKF_ID };
 
 static char nes_destfname[FILENAME_MAX] = "";
-static const char *internal_name;
 static FILE *nes_destfile;
 
 
@@ -5149,9 +5155,9 @@ nes_compare (const void *key, const void *found)
 
 
 nes_file_t
-nes_get_file_type (void)
+nes_get_file_type (st_ucon64_t *p)
 {
-  return type;
+  return nes_state (p)->type;
 }
 
 
@@ -5192,7 +5198,7 @@ read_block (unsigned char **data, unsigned int size, FILE *file,
 
 
 static st_unif_chunk_t *
-read_chunk (uint32_t id, unsigned char *rom_buffer, int cont)
+read_chunk (st_ucon64_t *p, uint32_t id, unsigned char *rom_buffer, int cont)
 /*
   The caller is responsible for freeing the memory for the allocated
   st_unif_chunk_t. It should do that by calling free() with the pointer to
@@ -5210,11 +5216,8 @@ read_chunk (uint32_t id, unsigned char *rom_buffer, int cont)
     uint32_t length;                            // data length, in little endian format
   } chunk_header = { 0, 0 };
   st_unif_chunk_t *unif_chunk;
-  static unsigned int pos = 0;
-  unsigned int rom_size = (unsigned int) ucon64.fsize - UNIF_HEADER_LEN;
-
-  if (!cont)
-    pos = 0;
+  unsigned int pos = cont ? nes_state (p)->chunk_pos : 0,
+               rom_size = (unsigned int) p->fsize - UNIF_HEADER_LEN;
 
 #ifdef  WORDS_BIGENDIAN
   id = bswap_32 (id);                           // swap id once instead of chunk_header.id often
@@ -5245,6 +5248,7 @@ read_chunk (uint32_t id, unsigned char *rom_buffer, int cont)
     }
   while (chunk_header.id != id);
 
+  nes_state (p)->chunk_pos = pos;
   if (chunk_header.id != id || pos + chunk_header.length > rom_size)
     {
 #ifdef  DEBUG_READ_CHUNK
@@ -5265,7 +5269,7 @@ read_chunk (uint32_t id, unsigned char *rom_buffer, int cont)
   unif_chunk->data = &((unsigned char *) unif_chunk)[sizeof (st_unif_chunk_t)];
 
   memcpy (unif_chunk->data, rom_buffer + pos, chunk_header.length);
-  pos += chunk_header.length;
+  nes_state (p)->chunk_pos = pos + chunk_header.length;
 #ifdef  DEBUG_READ_CHUNK
   puts ("exit2");
 #endif
@@ -5374,29 +5378,30 @@ parse_info_file (st_dumper_info_t *info, const char *fname)
 static int
 nes_ines_unif (FILE *srcfile, FILE *destfile)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   unsigned int prg_size, chr_size;
   uint32_t x;
   unsigned char *prg_data = NULL, *chr_data = NULL, b;
   st_unif_chunk_t unif_chunk;
 
   // read iNES file
-  fread_checked (&ines_header, 1, INES_HEADER_LEN, srcfile);
-  if (ines_header.ctrl1 & INES_TRAINER)
+  fread_checked (&cd->ines_header, 1, INES_HEADER_LEN, srcfile);
+  if (cd->ines_header.ctrl1 & INES_TRAINER)
     fseek (srcfile, 512, SEEK_CUR);             // discard trainer data (lib_unif does the same)
 
-  prg_size = ines_header.prg_size << 14;
+  prg_size = cd->ines_header.prg_size << 14;
   prg_size = read_block (&prg_data, prg_size, srcfile,
                          "ERROR: Not enough memory for PRG buffer (%u bytes)\n", prg_size);
-  chr_size = ines_header.chr_size << 13;
+  chr_size = cd->ines_header.chr_size << 13;
   if (chr_size > 0)
     chr_size = read_block (&chr_data, chr_size, srcfile,
                            "ERROR: Not enough memory for CHR buffer (%u bytes)\n", chr_size);
 
   // write UNIF file
-  memset (&unif_header, 0, UNIF_HEADER_LEN);
-  memcpy (&unif_header.signature, UNIF_SIG_S, 4);
-  unif_header.revision = me2le_32 (UNIF_REVISION);
-  fwrite (&unif_header, 1, UNIF_HEADER_LEN, destfile);
+  memset (&cd->unif_header, 0, UNIF_HEADER_LEN);
+  memcpy (&cd->unif_header.signature, UNIF_SIG_S, 4);
+  cd->unif_header.revision = me2le_32 (UNIF_REVISION);
+  fwrite (&cd->unif_header, 1, UNIF_HEADER_LEN, destfile);
 
   unif_chunk.id = MAPR_ID;
   if (ucon64.mapr == NULL || ucon64.mapr[0] == '\0')
@@ -5433,7 +5438,7 @@ nes_ines_unif (FILE *srcfile, FILE *destfile)
   if (UCON64_ISSET (ucon64.tv_standard))
     b = (unsigned char) ucon64.tv_standard;     // necessary for big endian machines
   else
-    b = ines_header.ctrl3 & INES_TVID;
+    b = cd->ines_header.ctrl3 & INES_TVID;
   unif_chunk.id = TVCI_ID;
   unif_chunk.length = 1;
   unif_chunk.data = &b;
@@ -5513,7 +5518,7 @@ nes_ines_unif (FILE *srcfile, FILE *destfile)
       if (ucon64.battery)
         write_chunk (&unif_chunk, destfile);
     }
-  else if (ines_header.ctrl1 & INES_SRAM)
+  else if (cd->ines_header.ctrl1 & INES_SRAM)
     write_chunk (&unif_chunk, destfile);
 
   if (UCON64_ISSET (ucon64.vram))
@@ -5540,9 +5545,9 @@ nes_ines_unif (FILE *srcfile, FILE *destfile)
       unif_chunk.data = &b;
       write_chunk (&unif_chunk, destfile);
     }
-  else if (ines_header.ctrl1 & (INES_MIRROR | INES_4SCREEN))
+  else if (cd->ines_header.ctrl1 & (INES_MIRROR | INES_4SCREEN))
     {
-      if (ines_header.ctrl1 & INES_MIRROR)
+      if (cd->ines_header.ctrl1 & INES_MIRROR)
         b = 1;
       else                                      // it must be INES_4SCREEN
         b = 4;
@@ -5559,22 +5564,23 @@ nes_ines_unif (FILE *srcfile, FILE *destfile)
 static int
 nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   int n;
   st_unif_chunk_t *unif_chunk1, unif_chunk2, *unif_chunk3;
   unsigned char b;
 
   {
-    uint32_t x = me2le_32 (unif_header.revision);
+    uint32_t x = me2le_32 (cd->unif_header.revision);
     if (x > UNIF_REVISION)
       printf ("WARNING: The UNIF file is of a revision later than %u (%u), but uCON64\n"
               "         does not support that revision yet. Some chunks may be discarded.\n",
               UNIF_REVISION, x);
   }
-  unif_header.revision = me2le_32 (UNIF_REVISION);
-  memcpy (&unif_header.signature, UNIF_SIG_S, 4);
-  fwrite (&unif_header, 1, UNIF_HEADER_LEN, destfile);
+  cd->unif_header.revision = me2le_32 (UNIF_REVISION);
+  memcpy (&cd->unif_header.signature, UNIF_SIG_S, 4);
+  fwrite (&cd->unif_header, 1, UNIF_HEADER_LEN, destfile);
 
-  if ((unif_chunk1 = read_chunk (MAPR_ID, rom_buffer, 0)) == NULL || // no MAPR chunk
+  if ((unif_chunk1 = read_chunk (&ucon64, MAPR_ID, rom_buffer, 0)) == NULL || // no MAPR chunk
       (ucon64.mapr != NULL && ucon64.mapr[0] != '\0'))               // MAPR, but has to change
     {
       unif_chunk2.id = MAPR_ID;
@@ -5605,13 +5611,13 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
       unif_chunk2.data = (void *) ucon64.comment;
       write_chunk (&unif_chunk2, destfile);
     }
-  else if ((unif_chunk1 = read_chunk (READ_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, READ_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
     }
 
-  if ((unif_chunk1 = read_chunk (WRTR_ID, rom_buffer, 0)) == NULL)
+  if ((unif_chunk1 = read_chunk (&ucon64, WRTR_ID, rom_buffer, 0)) == NULL)
     {
       unif_chunk2.id = WRTR_ID;
       unif_chunk2.length = (uint32_t) strlen (unif_ucon64_sig) + 1;
@@ -5636,7 +5642,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
           write_chunk (unif_chunk1, destfile);
           free (unif_chunk1);
         }
-      while ((unif_chunk1 = read_chunk (WRTR_ID, rom_buffer, 1)) != NULL);
+      while ((unif_chunk1 = read_chunk (&ucon64, WRTR_ID, rom_buffer, 1)) != NULL);
 
       if (!sig_added)
         {
@@ -5647,7 +5653,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
         }
     }
 #else
-  if ((unif_chunk1 = read_chunk (READ_ID, rom_buffer, 0)) == NULL)
+  if ((unif_chunk1 = read_chunk (&ucon64, READ_ID, rom_buffer, 0)) == NULL)
     {
       unif_chunk2.id = READ_ID;
       unif_chunk2.length = (uint32_t) strlen (unif_ucon64_sig) + 1;
@@ -5668,14 +5674,14 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
     }
 #endif
 
-  if (internal_name != NULL)
+  if (cd->internal_name != NULL)
     {
       unif_chunk2.id = NAME_ID;
-      unif_chunk2.length = (uint32_t) strlen (internal_name) + 1;
-      unif_chunk2.data = (char *) internal_name;
+      unif_chunk2.length = (uint32_t) strlen (cd->internal_name) + 1;
+      unif_chunk2.data = (char *) cd->internal_name;
       write_chunk (&unif_chunk2, destfile);     // assume ASCII-z (spec is not clear)
     }
-  else if ((unif_chunk1 = read_chunk (NAME_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, NAME_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5689,7 +5695,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
       unif_chunk2.data = &b;
       write_chunk (&unif_chunk2, destfile);
     }
-  else if ((unif_chunk1 = read_chunk (TVCI_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, TVCI_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5728,7 +5734,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
       else                                      // Is this a warning or an error?
         puts ("WARNING: No dumper info file was specified, chunk will not be written");
     }
-  else if ((unif_chunk1 = read_chunk (DINF_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, DINF_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5742,7 +5748,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
       unif_chunk2.data = &b;
       write_chunk (&unif_chunk2, destfile);
     }
-  else if ((unif_chunk1 = read_chunk (CTRL_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, CTRL_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5750,9 +5756,9 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
 
   // copy PRG chunks
   for (n = 0; n < 16; n++)
-    if ((unif_chunk1 = read_chunk (unif_prg_ids[n], rom_buffer, 0)) != NULL)
+    if ((unif_chunk1 = read_chunk (&ucon64, unif_prg_ids[n], rom_buffer, 0)) != NULL)
       {
-        if ((unif_chunk3 = read_chunk (unif_pck_ids[n], rom_buffer, 0)) == NULL)
+        if ((unif_chunk3 = read_chunk (&ucon64, unif_pck_ids[n], rom_buffer, 0)) == NULL)
           {
             uint32_t x = crc32 (0, (unsigned char *) unif_chunk1->data, unif_chunk1->length);
             unif_chunk2.id = unif_pck_ids[n];
@@ -5782,9 +5788,9 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
 
   // copy CHR chunks
   for (n = 0; n < 16; n++)
-    if ((unif_chunk1 = read_chunk (unif_chr_ids[n], rom_buffer, 0)) != NULL)
+    if ((unif_chunk1 = read_chunk (&ucon64, unif_chr_ids[n], rom_buffer, 0)) != NULL)
       {
-        if ((unif_chunk3 = read_chunk (unif_cck_ids[n], rom_buffer, 0)) == NULL)
+        if ((unif_chunk3 = read_chunk (&ucon64, unif_cck_ids[n], rom_buffer, 0)) == NULL)
           {
             uint32_t x = crc32 (0, (unsigned char *) unif_chunk1->data, unif_chunk1->length);
             unif_chunk2.id = unif_cck_ids[n];
@@ -5823,7 +5829,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
           write_chunk (&unif_chunk2, destfile);
         }
     }
-  else if ((unif_chunk1 = read_chunk (BATR_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, BATR_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5840,7 +5846,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
           write_chunk (&unif_chunk2, destfile);
         }
     }
-  else if ((unif_chunk1 = read_chunk (VROR_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, VROR_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5860,7 +5866,7 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
       unif_chunk2.data = &b;
       write_chunk (&unif_chunk2, destfile);
     }
-  else if ((unif_chunk1 = read_chunk (MIRR_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk1 = read_chunk (&ucon64, MIRR_ID, rom_buffer, 0)) != NULL)
     {
       write_chunk (unif_chunk1, destfile);
       free (unif_chunk1);
@@ -5873,16 +5879,17 @@ nes_unif_unif (unsigned char *rom_buffer, FILE *destfile)
 int
 nes_unif (void)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   FILE *destfile;
 
-  if (type != INES && type != UNIF)
+  if (cd->type != INES && cd->type != UNIF)
     {
-      if (type == PASOFAMI)
+      if (cd->type == PASOFAMI)
         fputs ("ERROR: Pasofami -> UNIF is currently not supported\n", stderr);
-      else if (type == FFE)
+      else if (cd->type == FFE)
         fputs ("ERROR: FFE -> UNIF is currently not supported\n", stderr);
-      else if (type == FDS || type == FAM)
+      else if (cd->type == FDS || cd->type == FAM)
         fputs ("ERROR: FDS/FAM -> UNIF is currently not supported\n", stderr);
       return -1;
     }
@@ -5905,7 +5912,7 @@ nes_unif (void)
   register_func (remove_destfile);
   // Converting from UNIF to UNIF should be allowed, because the user might
   //  want to change some parameters.
-  if (type == INES)
+  if (cd->type == INES)
     {
       FILE *srcfile;
 
@@ -5931,7 +5938,7 @@ nes_unif (void)
 
       fclose (srcfile);
     }
-  else if (type == UNIF)
+  else if (cd->type == UNIF)
     {
       unsigned int rom_size = (unsigned int) ucon64.fsize - UNIF_HEADER_LEN;
       unsigned char *rom_buffer;
@@ -5990,21 +5997,22 @@ set_mapper (st_ines_header_t *header, unsigned int mapper)
 static int
 nes_ines_ines (FILE *srcfile, FILE *destfile, int deinterleave)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   unsigned int prg_size, chr_size;
   unsigned char *prg_data = NULL, *chr_data = NULL;
 
   // read iNES file
-  fread_checked (&ines_header, 1, INES_HEADER_LEN, srcfile);
-  if (ines_header.ctrl1 & INES_TRAINER)
+  fread_checked (&cd->ines_header, 1, INES_HEADER_LEN, srcfile);
+  if (cd->ines_header.ctrl1 & INES_TRAINER)
     {
       fseek (srcfile, 512, SEEK_CUR);           // discard trainer data
-      ines_header.ctrl1 &= ~INES_TRAINER;       // clear trainer bit
+      cd->ines_header.ctrl1 &= ~INES_TRAINER;   // clear trainer bit
     }
 
-  prg_size = ines_header.prg_size << 14;
+  prg_size = cd->ines_header.prg_size << 14;
   prg_size = read_block (&prg_data, prg_size, srcfile,
                          "ERROR: Not enough memory for PRG buffer (%u bytes)\n", prg_size);
-  chr_size = ines_header.chr_size << 13;
+  chr_size = cd->ines_header.chr_size << 13;
   if (chr_size > 0)
     chr_size = read_block (&chr_data, chr_size, srcfile,
                            "ERROR: Not enough memory for CHR buffer (%u bytes)\n", chr_size);
@@ -6060,43 +6068,43 @@ nes_ines_ines (FILE *srcfile, FILE *destfile, int deinterleave)
   if (ucon64.mapr == NULL || ucon64.mapr[0] == '\0')
     puts ("WARNING: No mapper number specified, using old value");
   else                                          // mapper specified
-    set_mapper (&ines_header, strtol (ucon64.mapr, NULL, 10));
-  memcpy (&ines_header.signature, INES_SIG_S, 4);
-  ines_header.prg_size = (unsigned char) (prg_size >> 14);
-  ines_header.chr_size = (unsigned char) (chr_size >> 13);
+    set_mapper (&cd->ines_header, strtol (ucon64.mapr, NULL, 10));
+  memcpy (&cd->ines_header.signature, INES_SIG_S, 4);
+  cd->ines_header.prg_size = (unsigned char) (prg_size >> 14);
+  cd->ines_header.chr_size = (unsigned char) (chr_size >> 13);
 
-  ines_header.ctrl3 &= INES_TVID;               // clear undefined bits
+  cd->ines_header.ctrl3 &= INES_TVID;           // clear undefined bits
   if (UCON64_ISSET (ucon64.tv_standard))
     {
       if (ucon64.tv_standard == 1)              // value can be 0, 1 or 2
-        ines_header.ctrl3 |= INES_TVID;
+        cd->ines_header.ctrl3 |= INES_TVID;
       else
-        ines_header.ctrl3 &= ~INES_TVID;
+        cd->ines_header.ctrl3 &= ~INES_TVID;
     }
 
   if (UCON64_ISSET (ucon64.battery))
     {
       if (ucon64.battery)
-        ines_header.ctrl1 |= INES_SRAM;
+        cd->ines_header.ctrl1 |= INES_SRAM;
       else
-        ines_header.ctrl1 &= ~INES_SRAM;
+        cd->ines_header.ctrl1 &= ~INES_SRAM;
     }
 
   if (UCON64_ISSET (ucon64.mirror))
     {
-      ines_header.ctrl1 &= ~(INES_MIRROR | INES_4SCREEN); // clear bits
+      cd->ines_header.ctrl1 &= ~(INES_MIRROR | INES_4SCREEN); // clear bits
       if (ucon64.mirror == 0)
         ;                                       // default value in ctrl1 (0) is OK
       else if (ucon64.mirror == 1)
-        ines_header.ctrl1 |= INES_MIRROR;
+        cd->ines_header.ctrl1 |= INES_MIRROR;
       else if (ucon64.mirror == 4)
-        ines_header.ctrl1 |= INES_4SCREEN;
+        cd->ines_header.ctrl1 |= INES_4SCREEN;
       else
         puts ("WARNING: Invalid mirroring type specified, using \"0\"");
     }
 
-  memset (ines_header.reserved, 0, sizeof (ines_header.reserved));
-  fwrite (&ines_header, 1, INES_HEADER_LEN, destfile);
+  memset (cd->ines_header.reserved, 0, sizeof (cd->ines_header.reserved));
+  fwrite (&cd->ines_header, 1, INES_HEADER_LEN, destfile);
   fwrite (prg_data, 1, prg_size, destfile);
   fwrite (chr_data, 1, chr_size, destfile);
 
@@ -6173,23 +6181,24 @@ nes_mapper_number (const char *board_name, unsigned int board_name_len)
 static int
 nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   int n, prg_size = 0, chr_size = 0;
   uint32_t x;
   st_unif_chunk_t *unif_chunk;
 
-  x = me2le_32 (unif_header.revision);
+  x = me2le_32 (cd->unif_header.revision);
   if (x > UNIF_REVISION)
     printf ("WARNING: The UNIF file is of a revision later than %u (%u), but uCON64\n"
             "         does not support that revision yet. Some chunks may be discarded.\n",
             UNIF_REVISION, x);
 
   // build iNES header
-  memset (&ines_header, 0, INES_HEADER_LEN);
-  memcpy (&ines_header.signature, INES_SIG_S, 4);
+  memset (&cd->ines_header, 0, INES_HEADER_LEN);
+  memcpy (&cd->ines_header.signature, INES_SIG_S, 4);
 
   if (ucon64.mapr == NULL || ucon64.mapr[0] == '\0')
     {                                           // no mapper specified, try autodetection
-      if ((unif_chunk = read_chunk (MAPR_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (&ucon64, MAPR_ID, rom_buffer, 0)) != NULL)
         {
           int mapper = nes_mapper_number ((char *) unif_chunk->data,
                                           unif_chunk->length);
@@ -6198,7 +6207,7 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
               puts ("WARNING: Could not determine mapper number, writing \"0\"");
               mapper = 0;
             }
-          set_mapper (&ines_header, mapper);
+          set_mapper (&cd->ines_header, mapper);
           free (unif_chunk);
         }
       else                                      // no MAPR chunk
@@ -6208,30 +6217,30 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
         }
     }
   else                                          // mapper specified
-    set_mapper (&ines_header, strtol (ucon64.mapr, NULL, 10));
+    set_mapper (&cd->ines_header, strtol (ucon64.mapr, NULL, 10));
 
   if (UCON64_ISSET (ucon64.tv_standard))
     {
       if (ucon64.tv_standard == 1)              // value can be 0, 1 or 2
-        ines_header.ctrl3 |= INES_TVID;
+        cd->ines_header.ctrl3 |= INES_TVID;
     }
-  else if ((unif_chunk = read_chunk (TVCI_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk = read_chunk (&ucon64, TVCI_ID, rom_buffer, 0)) != NULL)
     {
-      ines_header.ctrl3 |= *((unsigned char *) unif_chunk->data) == INES_TVID ?
-        INES_TVID : 0;
+      cd->ines_header.ctrl3 |=
+        *((unsigned char *) unif_chunk->data) == INES_TVID ? INES_TVID : 0;
       free (unif_chunk);
     }
 
   if (UCON64_ISSET (ucon64.battery))
     {
       if (ucon64.battery)
-        ines_header.ctrl1 |= INES_SRAM;
+        cd->ines_header.ctrl1 |= INES_SRAM;
       else
-        ines_header.ctrl1 &= ~INES_SRAM;
+        cd->ines_header.ctrl1 &= ~INES_SRAM;
     }
-  else if ((unif_chunk = read_chunk (BATR_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk = read_chunk (&ucon64, BATR_ID, rom_buffer, 0)) != NULL)
     {
-      ines_header.ctrl1 |= INES_SRAM;
+      cd->ines_header.ctrl1 |= INES_SRAM;
       free (unif_chunk);
     }
 
@@ -6240,13 +6249,13 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
       if (ucon64.mirror == 0)
         ;                                       // default value in ctrl1 (0) is OK
       else if (ucon64.mirror == 1)
-        ines_header.ctrl1 |= INES_MIRROR;
+        cd->ines_header.ctrl1 |= INES_MIRROR;
       else if (ucon64.mirror == 4)
-        ines_header.ctrl1 |= INES_4SCREEN;
+        cd->ines_header.ctrl1 |= INES_4SCREEN;
       else
         puts ("WARNING: Invalid mirroring type specified, using \"0\"");
     }
-  else if ((unif_chunk = read_chunk (MIRR_ID, rom_buffer, 0)) != NULL)
+  else if ((unif_chunk = read_chunk (&ucon64, MIRR_ID, rom_buffer, 0)) != NULL)
     {
       switch (*((unsigned char *) unif_chunk->data))
         {
@@ -6256,10 +6265,10 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
         case 5:                                 // idem
           break;
         case 1:
-          ines_header.ctrl1 |= INES_MIRROR;
+          cd->ines_header.ctrl1 |= INES_MIRROR;
           break;
         case 4:
-          ines_header.ctrl1 |= INES_4SCREEN;
+          cd->ines_header.ctrl1 |= INES_4SCREEN;
           break;
         default:
           puts ("WARNING: Unsupported value in MIRR chunk");
@@ -6277,12 +6286,12 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
   */
   for (n = 0; n < 16; n++)
     {
-      if ((unif_chunk = read_chunk (unif_prg_ids[n], rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (&ucon64, unif_prg_ids[n], rom_buffer, 0)) != NULL)
         {
           prg_size += unif_chunk->length;
           free (unif_chunk);
         }
-      if ((unif_chunk = read_chunk (unif_chr_ids[n], rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (&ucon64, unif_chr_ids[n], rom_buffer, 0)) != NULL)
         {
           chr_size += unif_chunk->length;
           free (unif_chunk);
@@ -6290,13 +6299,13 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
     }
 
   // write header
-  ines_header.prg_size = (unsigned char) (prg_size >> 14); // # 16 kB banks
-  ines_header.chr_size = (unsigned char) (chr_size >> 13); // # 8 kB banks
-  fwrite (&ines_header, 1, INES_HEADER_LEN, destfile);
+  cd->ines_header.prg_size = (unsigned char) (prg_size >> 14); // # 16 kB banks
+  cd->ines_header.chr_size = (unsigned char) (chr_size >> 13); // # 8 kB banks
+  fwrite (&cd->ines_header, 1, INES_HEADER_LEN, destfile);
 
   // copy PRG data
   for (n = 0; n < 16; n++)
-    if ((unif_chunk = read_chunk (unif_prg_ids[n], rom_buffer, 0)) != NULL)
+    if ((unif_chunk = read_chunk (&ucon64, unif_prg_ids[n], rom_buffer, 0)) != NULL)
       {
         fwrite (unif_chunk->data, 1, unif_chunk->length, destfile);
         free (unif_chunk);
@@ -6304,7 +6313,7 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
 
   // copy CHR data
   for (n = 0; n < 16; n++)
-    if ((unif_chunk = read_chunk (unif_chr_ids[n], rom_buffer, 0)) != NULL)
+    if ((unif_chunk = read_chunk (&ucon64, unif_chr_ids[n], rom_buffer, 0)) != NULL)
       {
         fwrite (unif_chunk->data, 1, unif_chunk->length, destfile);
         free (unif_chunk);
@@ -6317,23 +6326,24 @@ nes_unif_ines (unsigned char *rom_buffer, FILE *destfile)
 int
 nes_ines (void)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   FILE *destfile;
 
-  if (type == FFE)
+  if (cd->type == FFE)
     {
       fputs ("ERROR: FFE -> iNES is currently not supported\n", stderr);
       return -1;
     }
-  else if (type == FDS || type == FAM)
+  else if (cd->type == FDS || cd->type == FAM)
     {
       fputs ("ERROR: FDS/FAM -> iNES is not possible\n", stderr);
       return -1;
     }
 
   // Pasofami doesn't fit well in the source -> destination "paradigm"
-  if (type == PASOFAMI)
-    return nes_j (NULL);
+  if (cd->type == PASOFAMI)
+    return nes_j (&ucon64, NULL);
 
   strcpy (dest_name, ucon64.fname);
   set_suffix (dest_name, ".nes");
@@ -6349,7 +6359,7 @@ nes_ines (void)
   strcpy (nes_destfname, dest_name);
   nes_destfile = destfile;
   register_func (remove_destfile);
-  if (type == INES)
+  if (cd->type == INES)
     {
       FILE *srcfile;
 
@@ -6375,7 +6385,7 @@ nes_ines (void)
 
       fclose (srcfile);
     }
-  else if (type == UNIF)
+  else if (cd->type == UNIF)
     {
       unsigned int rom_size = (unsigned int) ucon64.fsize - UNIF_HEADER_LEN;
       unsigned char *rom_buffer;
@@ -6420,25 +6430,26 @@ nes_pasofami (void)
 int
 nes_ffe (st_ucon64_nfo_t *rominfo)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   st_smc_header_t smc_header;
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   unsigned int size = (unsigned int) ucon64.fsize - rominfo->backup_header_len,
                       mapper, prg_size, chr_size;
   int new_prg_size = -1;
 
-  if (type != INES)
+  if (cd->type != INES)
     {
       fputs ("ERROR: Currently only iNES -> FFE is supported\n", stderr);
       return -1;
     }
 
-  ucon64_fread (&ines_header, 0, INES_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->ines_header, 0, INES_HEADER_LEN, ucon64.fname);
 
-  mapper = ines_header.ctrl1 >> 4 | (ines_header.ctrl2 & 0xf0);
-  prg_size = ines_header.prg_size << 14;
+  mapper = cd->ines_header.ctrl1 >> 4 | (cd->ines_header.ctrl2 & 0xf0);
+  prg_size = cd->ines_header.prg_size << 14;
   if (prg_size > size)
     prg_size = size;
-  chr_size = ines_header.chr_size << 13;
+  chr_size = cd->ines_header.chr_size << 13;
 
   memset (&smc_header, 0, SMC_HEADER_LEN);
 
@@ -6526,7 +6537,7 @@ nes_ffe (st_ucon64_nfo_t *rominfo)
       break;
     }
 
-  if (ines_header.ctrl1 & INES_TRAINER)
+  if (cd->ines_header.ctrl1 & INES_TRAINER)
     smc_header.emulation1 |= SMC_TRAINER;
 
   smc_header.id1 = 0xaa;
@@ -6562,7 +6573,7 @@ nes_ffe (st_ucon64_nfo_t *rominfo)
       ucon64_fwrite (&smc_header, 0, SMC_HEADER_LEN, dest_name, "wb");
 
       // copy trainer data if present
-      if (ines_header.ctrl1 & INES_TRAINER)
+      if (cd->ines_header.ctrl1 & INES_TRAINER)
         {
           fcopy (src_name, rominfo->backup_header_len, 512, dest_name, "ab");
           offset = 512;
@@ -6589,9 +6600,10 @@ nes_ffe (st_ucon64_nfo_t *rominfo)
 int
 nes_ineshd (st_ucon64_nfo_t *rominfo)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   char dest_name[FILENAME_MAX];
 
-  if (type != INES)
+  if (cd->type != INES)
     {
       fputs ("ERROR: This option is only meaningful for iNES files\n", stderr);
       return -1;
@@ -6610,10 +6622,11 @@ nes_ineshd (st_ucon64_nfo_t *rominfo)
 int
 nes_dint (void)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   FILE *srcfile, *destfile;
 
-  if (type != INES)
+  if (cd->type != INES)
     {
       // Do interleaved UNIF or Pasofami images exist?
       fputs ("ERROR: Currently only iNES images can be deinterleaved\n", stderr);
@@ -6721,7 +6734,7 @@ parse_prm (st_ines_header_t *header, const char *fname)
 
 
 int
-nes_j (unsigned char **mem_image)
+nes_j (st_ucon64_t *p, unsigned char **mem_image)
 /*
   The Pasofami format consists of several files:
   - .PRM: header (uCON64 treats it as optional in order to support RAW images)
@@ -6730,11 +6743,12 @@ nes_j (unsigned char **mem_image)
   - .CHR: VROM data (optional)
 */
 {
+  st_nes_state_t *cd = nes_state (p);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   unsigned char *buffer;
   int prg_size = 0, chr_size = 0, write_file = 0, size, bytes_read = 0, nparts = 0;
 
-  if (type != PASOFAMI)
+  if (cd->type != PASOFAMI)
     {
       fputs ("ERROR: Only Pasofami files can be joined (for NES)\n", stderr);
       return -1;
@@ -6743,52 +6757,52 @@ nes_j (unsigned char **mem_image)
   if (mem_image == NULL)
     write_file = 1;
 
-  strcpy (dest_name, ucon64.fname);
+  strcpy (dest_name, p->fname);
   set_suffix (dest_name, ".nes");
   if (write_file)
     ucon64_file_handler (dest_name, NULL, 0);
 
   // build iNES header
-  memset (&ines_header, 0, INES_HEADER_LEN);
-  memcpy (&ines_header.signature, INES_SIG_S, 4);
+  memset (&cd->ines_header, 0, INES_HEADER_LEN);
+  memcpy (&cd->ines_header.signature, INES_SIG_S, 4);
 
-  strcpy (src_name, ucon64.fname);
+  strcpy (src_name, p->fname);
   set_suffix (src_name, ".prm");
   if (access (src_name, F_OK) == 0)
     {
-      parse_prm (&ines_header, src_name);
+      parse_prm (&cd->ines_header, src_name);
       nparts++;
     }
   else if (write_file)                          // don't print this from nes_init()
     printf ("WARNING: No %s, using default values\n", src_name);
 
   // don't do this in parse_prm(), because there might be no .PRM file available
-  if (UCON64_ISSET (ucon64.battery))
+  if (UCON64_ISSET (p->battery))
     {
-      if (ucon64.battery)
-        ines_header.ctrl1 |= INES_SRAM;
+      if (p->battery)
+        cd->ines_header.ctrl1 |= INES_SRAM;
       else
-        ines_header.ctrl1 &= ~INES_SRAM;
+        cd->ines_header.ctrl1 &= ~INES_SRAM;
     }
 
-  if (UCON64_ISSET (ucon64.mirror))
+  if (UCON64_ISSET (p->mirror))
     {
-      ines_header.ctrl1 &= ~(INES_MIRROR | INES_4SCREEN); // clear bits
-      if (ucon64.mirror == 0)
+      cd->ines_header.ctrl1 &= ~(INES_MIRROR | INES_4SCREEN); // clear bits
+      if (p->mirror == 0)
         ;                                       // default value in ctrl1 (0) is OK
-      else if (ucon64.mirror == 1)
-        ines_header.ctrl1 |= INES_MIRROR;
-      else if (ucon64.mirror == 4)
-        ines_header.ctrl1 |= INES_4SCREEN;
+      else if (p->mirror == 1)
+        cd->ines_header.ctrl1 |= INES_MIRROR;
+      else if (p->mirror == 4)
+        cd->ines_header.ctrl1 |= INES_4SCREEN;
       else
         puts ("WARNING: Invalid mirroring type specified, using \"0\"");
     }
 
-  strcpy (src_name, ucon64.fname);
+  strcpy (src_name, p->fname);
   set_suffix (src_name, ".700");
   if (access (src_name, F_OK) == 0 && fsizeof (src_name) >= 512)
     {
-      ines_header.ctrl1 |= INES_TRAINER;
+      cd->ines_header.ctrl1 |= INES_TRAINER;
       nparts++;
     }
 
@@ -6806,7 +6820,7 @@ nes_j (unsigned char **mem_image)
       prg_size = (int) fsizeof (src_name);
       nparts++;
     }
-  ines_header.prg_size = (unsigned char) (prg_size >> 14);
+  cd->ines_header.prg_size = (unsigned char) (prg_size >> 14);
 
   set_suffix (src_name, ".chr");
   if (access (src_name, F_OK) == 0)
@@ -6814,25 +6828,27 @@ nes_j (unsigned char **mem_image)
       chr_size = (int) fsizeof (src_name);
       nparts++;
     }
-  ines_header.chr_size = (unsigned char) (chr_size >> 13);
+  cd->ines_header.chr_size = (unsigned char) (chr_size >> 13);
 
-  if (ucon64.mapr == NULL || ucon64.mapr[0] == '\0')
+  if (p->mapr == NULL || p->mapr[0] == '\0')
     {                                           // maybe .PRM contained mapper
       if (write_file)                           // don't print this from nes_init()
         printf ("WARNING: No mapper number specified, writing \"%d\"\n",
-                (ines_header.ctrl1 >> 4) | (ines_header.ctrl2 & 0xf0));
+                (cd->ines_header.ctrl1 >> 4) |
+                  (cd->ines_header.ctrl2 & 0xf0));
     }
   else // mapper specified (override unreliable value from .PRM file)
-    set_mapper (&ines_header, strtol (ucon64.mapr, NULL, 10));
+    set_mapper (&cd->ines_header, strtol (p->mapr, NULL, 10));
 
-  size = prg_size + chr_size + ((ines_header.ctrl1 & INES_TRAINER) ? 512 : 0);
+  size = prg_size + chr_size +
+           ((cd->ines_header.ctrl1 & INES_TRAINER) ? 512 : 0);
   if ((buffer = (unsigned char *) malloc (size)) == NULL)
     {
       fprintf (stderr, ucon64_msg[BUFFER_ERROR], size);
       return -1;
     }
 
-  if (ines_header.ctrl1 & INES_TRAINER)
+  if (cd->ines_header.ctrl1 & INES_TRAINER)
     {
       set_suffix (src_name, ".700");
       ucon64_fread (buffer, 0, 512, src_name);  // use 512 bytes at max
@@ -6854,7 +6870,7 @@ nes_j (unsigned char **mem_image)
 
   if (write_file)
     {
-      ucon64_fwrite (&ines_header, 0, INES_HEADER_LEN, dest_name, "wb");
+      ucon64_fwrite (&cd->ines_header, 0, INES_HEADER_LEN, dest_name, "wb");
       ucon64_fwrite (buffer, INES_HEADER_LEN, size, dest_name, "ab");
       printf (ucon64_msg[WROTE], dest_name);
       free (buffer);
@@ -6862,8 +6878,8 @@ nes_j (unsigned char **mem_image)
   else
     *mem_image = buffer;
 
-  if (!UCON64_ISSET (ucon64.split))
-    ucon64.split = nparts;
+  if (!UCON64_ISSET (p->split))
+    p->split = nparts;
 
   return 0;
 }
@@ -6938,12 +6954,13 @@ write_prm (st_ines_header_t *header, const char *fname)
 int
 nes_s (void)
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   char dest_name[FILENAME_MAX];
   unsigned char *trainer_data = NULL, *prg_data = NULL, *chr_data = NULL;
   unsigned int prg_size = 0, chr_size = 0;
   FILE *srcfile;
 
-  if (type != INES)
+  if (cd->type != INES)
     {
       fputs ("ERROR: Currently only iNES -> Pasofami is supported\n", stderr);
       return -1;
@@ -6956,8 +6973,8 @@ nes_s (void)
     }
 
   // read iNES file
-  fread_checked (&ines_header, 1, INES_HEADER_LEN, srcfile);
-  if (ines_header.ctrl1 & INES_TRAINER)
+  fread_checked (&cd->ines_header, 1, INES_HEADER_LEN, srcfile);
+  if (cd->ines_header.ctrl1 & INES_TRAINER)
     {
       if (read_block (&trainer_data, 512, srcfile,
                       "ERROR: Not enough memory for trainer buffer (%u bytes)\n", 512) != 512)
@@ -6968,10 +6985,10 @@ nes_s (void)
           return -1;
         }
     }
-  prg_size = ines_header.prg_size << 14;
+  prg_size = cd->ines_header.prg_size << 14;
   prg_size = read_block (&prg_data, prg_size, srcfile,
                          "ERROR: Not enough memory for PRG buffer (%u bytes)\n", prg_size);
-  chr_size = ines_header.chr_size << 13;
+  chr_size = cd->ines_header.chr_size << 13;
   if (chr_size > 0)
     chr_size = read_block (&chr_data, chr_size, srcfile,
                            "ERROR: Not enough memory for CHR buffer (%u bytes)\n", chr_size);
@@ -6980,7 +6997,7 @@ nes_s (void)
     {
       int x = strtol (ucon64.mapr, NULL, 10);
       if (x == 0 || x == 2 || x == 4)
-        set_mapper (&ines_header, x);
+        set_mapper (&cd->ines_header, x);
       else
         puts ("WARNING: Pasofami can only store mapper numbers 0, 2 or 4; using old value");
     }
@@ -6988,9 +7005,9 @@ nes_s (void)
   strcpy (dest_name, ucon64.fname);
   set_suffix (dest_name, ".prm");
   ucon64_output_fname (dest_name, 0);
-  write_prm (&ines_header, dest_name);
+  write_prm (&cd->ines_header, dest_name);
 
-  if (ines_header.ctrl1 & INES_TRAINER)
+  if (cd->ines_header.ctrl1 & INES_TRAINER)
     {
       set_suffix (dest_name, ".700");
       // don't write backups of parts, because one name is used
@@ -7033,24 +7050,27 @@ nes_s (void)
 int
 nes_n (const char *name)
 {
-  if (type != UNIF)
+  st_nes_state_t *cd = nes_state (&ucon64);
+
+  if (cd->type != UNIF)
     {
       fputs ("ERROR: This option is only meaningful for UNIF files\n", stderr);
       return -1;
     }
 
   if (name != NULL && name[0] != '\0')
-    internal_name = name;
+    cd->internal_name = name;
   else
-    internal_name = NULL;
+    cd->internal_name = NULL;
 
   return nes_unif ();                           // will call nes_unif_unif()
 }
 
 
 int
-nes_init (st_ucon64_nfo_t *rominfo)
+nes_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_nes_state_t *cd = nes_state (p);
   unsigned char magic[15], *rom_buffer;
   int result = -1, n;
   uint32_t x;
@@ -7059,10 +7079,10 @@ nes_init (st_ucon64_nfo_t *rominfo)
   st_unif_chunk_t *unif_chunk, *unif_chunk2;
   st_nes_data_t *info, key;
 
-  internal_name = NULL;                         // reset this var, see nes_n()
-  type = PASOFAMI;                              // reset type, see below
+  cd->internal_name = NULL;                     // reset this var, see nes_n()
+  cd->type = PASOFAMI;                          // reset type, see below
 
-  ucon64_fread (magic, 0, 15, ucon64.fname);
+  ucon64_fread (magic, 0, 15, p->fname);
   if (memcmp (magic, INES_SIG_S, 4) == 0 ||
       memcmp (magic, "NES\x19", 4) == 0 || memcmp (magic, "NES\x1b", 4) == 0)
     /*
@@ -7071,118 +7091,120 @@ nes_init (st_ucon64_nfo_t *rominfo)
       "Linus Music Demo (PD)" (magic: "NES\x1b")
     */
     {
-      type = INES;
+      cd->type = INES;
       result = 0;
     }
   else if (memcmp (magic, UNIF_SIG_S, 4) == 0)
     {
-      type = UNIF;
+      cd->type = UNIF;
       result = 0;
     }
   else if (memcmp (magic, FDS_SIG_S, 4) == 0)
     {
-      type = FDS;
+      cd->type = FDS;
       result = 0;
 
       rominfo->backup_header_start = 0;
       rominfo->backup_header_len = FDS_HEADER_LEN;
       // we use ffe_header to save some space in the exe
-      ucon64_fread (&ffe_header, 0, FDS_HEADER_LEN, ucon64.fname);
-      rominfo->backup_header = &ffe_header;
+      ucon64_fread (&cd->ffe_header, 0, FDS_HEADER_LEN, p->fname);
+      rominfo->backup_header = &cd->ffe_header;
     }
   else if (memcmp (magic, "\x01*NINTENDO-HVC*", 15) == 0) // "headerless" FDS/FAM file
     {
-      if (ucon64.fsize % 65500 == 192)
-        type = FAM;
+      if (p->fsize % 65500 == 192)
+        cd->type = FAM;
       else
-        type = FDS;
+        cd->type = FDS;
       result = 0;
     }
 
-  if (type == PASOFAMI)                         // INES, UNIF, FDS and FAM are much
+  if (cd->type == PASOFAMI)                     // INES, UNIF, FDS & FAM are
     {                                           //  more reliable than stricmp()s
-      str = get_suffix (ucon64.fname);
+      str = get_suffix (p->fname);
       if (!stricmp (str, ".prm") ||
           !stricmp (str, ".700") ||
           !stricmp (str, ".prg") ||
           !stricmp (str, ".chr"))
         {
-          type = PASOFAMI;
+          cd->type = PASOFAMI;
           result = 0;
         }
       else if (magic[8] == 0xaa && magic[9] == 0xbb)
         {                                       // TODO: finding a reliable means
-          type = FFE;                           //  for detecting FFE images
+          cd->type = FFE;                       //  for detecting FFE images
           result = 0;
         }
     }
-  if (ucon64.console == UCON64_NES)
+  if (p->console == UCON64_NES)
     result = 0;
 
-  switch (type)
+  switch (cd->type)
     {
     case INES:
       rominfo->backup_usage = ines_usage[0].help;
       rominfo->backup_header_start = 0;
       rominfo->backup_header_len = INES_HEADER_LEN;
-      ucon64_fread (&ines_header, 0, INES_HEADER_LEN, ucon64.fname);
-      rominfo->backup_header = &ines_header;
-      ucon64.split = 0;                         // iNES files are never split
+      ucon64_fread (&cd->ines_header, 0, INES_HEADER_LEN, p->fname);
+      rominfo->backup_header = &cd->ines_header;
+      p->split = 0;                             // iNES files are never split
 
       pos += sprintf (rominfo->misc + pos, "Internal size: %.4f Mb\n",
-                      TOMBIT_F ((ines_header.prg_size << 14) + (ines_header.chr_size << 13)));
+                      TOMBIT_F ((cd->ines_header.prg_size << 14) +
+                                (cd->ines_header.chr_size << 13)));
       pos += sprintf (rominfo->misc + pos, "Internal PRG size: %.4f Mb\n", // ROM
-                      TOMBIT_F (ines_header.prg_size << 14));
+                      TOMBIT_F (cd->ines_header.prg_size << 14));
       pos += sprintf (rominfo->misc + pos, "Internal CHR size: %.4f Mb\n", // VROM
-                      TOMBIT_F (ines_header.chr_size << 13));
+                      TOMBIT_F (cd->ines_header.chr_size << 13));
 
-      x = (ines_header.ctrl1 >> 4) | (ines_header.ctrl2 & 0xf0);
-      if (ines_header.ctrl2 & 0xf)
+      x = (cd->ines_header.ctrl1 >> 4) | (cd->ines_header.ctrl2 & 0xf0);
+      if (cd->ines_header.ctrl2 & 0xf)
         pos += sprintf (rominfo->misc + pos, "Memory mapper (iNES): %u (%u)\n", x,
-                        x | ((ines_header.ctrl2 & 0xf) << 8));
+                        x | ((cd->ines_header.ctrl2 & 0xf) << 8));
       else
         pos += sprintf (rominfo->misc + pos, "Memory mapper (iNES): %u\n", x);
 
       pos += sprintf (rominfo->misc + pos, "Television standard: %s\n",
-                      ines_header.ctrl3 & INES_TVID ? "PAL" : "NTSC");
+                      cd->ines_header.ctrl3 & INES_TVID ? "PAL" : "NTSC");
 
-      if (ines_header.ctrl1 & INES_MIRROR)
+      if (cd->ines_header.ctrl1 & INES_MIRROR)
         str = "Vertical";
-      else if (ines_header.ctrl1 & INES_4SCREEN)
+      else if (cd->ines_header.ctrl1 & INES_4SCREEN)
         str = "Four screens of VRAM";
       else
         str = "Horizontal";
       pos += sprintf (rominfo->misc + pos, "Mirroring: %s\n", str);
 
       pos += sprintf (rominfo->misc + pos, "Cartridge RAM: %d kBytes\n",
-                      ines_header.ram_size ? ines_header.ram_size * 8 : 8);
+                      cd->ines_header.ram_size ?
+                        cd->ines_header.ram_size * 8 : 8);
       pos += sprintf (rominfo->misc + pos, "Save RAM: %s\n",
-                      (ines_header.ctrl1 & INES_SRAM) ? "Yes" : "No");
+                      (cd->ines_header.ctrl1 & INES_SRAM) ? "Yes" : "No");
       pos += sprintf (rominfo->misc + pos, "512-byte trainer: %s\n",
-                      (ines_header.ctrl1 & INES_TRAINER) ? "Yes" : "No");
+                      (cd->ines_header.ctrl1 & INES_TRAINER) ? "Yes" : "No");
       pos += sprintf (rominfo->misc + pos, "VS-System: %s",
-                      (ines_header.ctrl2 & 0x01) ? "Yes" : "No");
+                      (cd->ines_header.ctrl2 & 0x01) ? "Yes" : "No");
       break;
     case UNIF:
       rominfo->backup_usage = unif_usage[0].help;
       rominfo->backup_header_start = 0;
       rominfo->backup_header_len = UNIF_HEADER_LEN;
-      ucon64_fread (&unif_header, 0, UNIF_HEADER_LEN, ucon64.fname);
-      rominfo->backup_header = &unif_header;
+      ucon64_fread (&cd->unif_header, 0, UNIF_HEADER_LEN, p->fname);
+      rominfo->backup_header = &cd->unif_header;
 
-      rom_size = (unsigned int) ucon64.fsize - UNIF_HEADER_LEN;
+      rom_size = (unsigned int) p->fsize - UNIF_HEADER_LEN;
       if ((rom_buffer = (unsigned char *) malloc (rom_size)) == NULL)
         {
           fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], rom_size);
           return -1; //exit (1); please don't use exit() in init()
         }
-      ucon64_fread (rom_buffer, UNIF_HEADER_LEN, rom_size, ucon64.fname);
-      ucon64.split = 0;                         // UNIF files are never split
+      ucon64_fread (rom_buffer, UNIF_HEADER_LEN, rom_size, p->fname);
+      p->split = 0;                             // UNIF files are never split
 
-      x = me2le_32 (unif_header.revision);      // don't modify header data
+      x = me2le_32 (cd->unif_header.revision);  // don't modify header data
       pos += sprintf (rominfo->misc + pos, "UNIF revision: %u\n", x);
 
-      if ((unif_chunk = read_chunk (READ_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, READ_ID, rom_buffer, 0)) != NULL)
         {
           uint32_t length = unif_chunk->length < 4000 ? unif_chunk->length : 4000;
           // properly handle string that is not null-terminated
@@ -7191,7 +7213,7 @@ nes_init (st_ucon64_nfo_t *rominfo)
           free (unif_chunk);
         }
 #if     UNIF_REVISION > 7
-      if ((unif_chunk = read_chunk (WRTR_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, WRTR_ID, rom_buffer, 0)) != NULL)
         {
           char ucon64_name[] = "uCON64";
           uint32_t ucon64_name_len = (uint32_t) strlen (ucon64_name), y = 0;
@@ -7236,11 +7258,11 @@ nes_init (st_ucon64_nfo_t *rominfo)
               y = 1;
               free (unif_chunk);
             }
-          while ((unif_chunk = read_chunk (WRTR_ID, rom_buffer, 1)) != NULL);
+          while ((unif_chunk = read_chunk (p, WRTR_ID, rom_buffer, 1)) != NULL);
           pos += sprintf (rominfo->misc + pos, "\n");
         }
 #endif
-      if ((unif_chunk = read_chunk (DINF_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, DINF_ID, rom_buffer, 0)) != NULL)
         {
           st_dumper_info_t *dumper_info = (st_dumper_info_t *) unif_chunk->data;
           if (unif_chunk->length == sizeof (st_dumper_info_t))
@@ -7258,11 +7280,11 @@ nes_init (st_ucon64_nfo_t *rominfo)
       rominfo->data_size = 0;
       // PRG chunk info
       for (n = 0; n < 16; n++)
-        if ((unif_chunk = read_chunk (unif_prg_ids[n], rom_buffer, 0)) != NULL)
+        if ((unif_chunk = read_chunk (p, unif_prg_ids[n], rom_buffer, 0)) != NULL)
           {
             crc = crc32 (crc, (unsigned char *) unif_chunk->data, unif_chunk->length);
             rominfo->data_size += unif_chunk->length;
-            if ((unif_chunk2 = read_chunk (unif_pck_ids[n], rom_buffer, 0)) == NULL)
+            if ((unif_chunk2 = read_chunk (p, unif_pck_ids[n], rom_buffer, 0)) == NULL)
               str = "not available";
             else
               {
@@ -7272,8 +7294,8 @@ nes_init (st_ucon64_nfo_t *rominfo)
 #endif
                 str = unif_chunk2->length == 4 && x == *((uint32_t *) unif_chunk2->data) ?
 #ifdef  USE_ANSI_COLOR
-                        ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                        ucon64.ansi_color ? "\x1b[01;31mbad\x1b[0m" : "bad";
+                        p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                        p->settings->ansi_color ? "\x1b[01;31mbad\x1b[0m" : "bad";
 #else
                         "OK" : "bad";
 #endif
@@ -7286,11 +7308,11 @@ nes_init (st_ucon64_nfo_t *rominfo)
 
       // CHR chunk info
       for (n = 0; n < 16; n++)
-        if ((unif_chunk = read_chunk (unif_chr_ids[n], rom_buffer, 0)) != NULL)
+        if ((unif_chunk = read_chunk (p, unif_chr_ids[n], rom_buffer, 0)) != NULL)
           {
             crc = crc32 (crc, (unsigned char *) unif_chunk->data, unif_chunk->length);
             rominfo->data_size += unif_chunk->length;
-            if ((unif_chunk2 = read_chunk (unif_cck_ids[n], rom_buffer, 0)) == NULL)
+            if ((unif_chunk2 = read_chunk (p, unif_cck_ids[n], rom_buffer, 0)) == NULL)
               str = "not available";
             else
               {
@@ -7300,8 +7322,8 @@ nes_init (st_ucon64_nfo_t *rominfo)
 #endif
                 str = unif_chunk2->length == 4 && x == *((uint32_t *) unif_chunk2->data) ?
 #ifdef  USE_ANSI_COLOR
-                        ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                        ucon64.ansi_color ? "\x1b[01;31mbad\x1b[0m" : "bad";
+                        p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                        p->settings->ansi_color ? "\x1b[01;31mbad\x1b[0m" : "bad";
 #else
                         "OK" : "bad";
 #endif
@@ -7311,12 +7333,12 @@ nes_init (st_ucon64_nfo_t *rominfo)
                             TOMBIT_F (unif_chunk->length), str);
             free (unif_chunk);
           }
-      ucon64.crc32 = crc;
+      p->crc32 = crc;
       // don't introduce extra code just to make this line be printed above
       //  the previous two line types (PRG & CHR)
       pos += sprintf (rominfo->misc + pos, "Size: %.4f Mb\n", TOMBIT_F (rominfo->data_size));
 
-      if ((unif_chunk = read_chunk (MAPR_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, MAPR_ID, rom_buffer, 0)) != NULL)
         {
           uint32_t length = unif_chunk->length < BOARDNAME_MAXLEN ?
                               unif_chunk->length : BOARDNAME_MAXLEN;
@@ -7325,7 +7347,7 @@ nes_init (st_ucon64_nfo_t *rominfo)
                           length, (char *) unif_chunk->data);
           free (unif_chunk);
         }
-      if ((unif_chunk = read_chunk (NAME_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, NAME_ID, rom_buffer, 0)) != NULL)
         {
 #if 0
           // properly handle string that is not null-terminated
@@ -7337,7 +7359,7 @@ nes_init (st_ucon64_nfo_t *rominfo)
                     sizeof rominfo->name : unif_chunk->length);
           free (unif_chunk);
         }
-      if ((unif_chunk = read_chunk (TVCI_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, TVCI_ID, rom_buffer, 0)) != NULL)
         {
           str_list[0] = "NTSC";
           str_list[1] = "PAL";
@@ -7347,7 +7369,7 @@ nes_init (st_ucon64_nfo_t *rominfo)
                           x > 2 ? "Unknown" : str_list[x]);
           free (unif_chunk);
         }
-      if ((unif_chunk = read_chunk (MIRR_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, MIRR_ID, rom_buffer, 0)) != NULL)
         {
           str_list[0] = "Horizontal (hard wired)";
           str_list[1] = "Vertical (hard wired)";
@@ -7362,14 +7384,14 @@ nes_init (st_ucon64_nfo_t *rominfo)
         }
 
       x = 0;
-      if ((unif_chunk = read_chunk (BATR_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, BATR_ID, rom_buffer, 0)) != NULL)
         {
           x = 1;
           free (unif_chunk);
         }
       pos += sprintf (rominfo->misc + pos, "Save RAM: %s\n", x ? "Yes" : "No");
 
-      if ((unif_chunk = read_chunk (CTRL_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, CTRL_ID, rom_buffer, 0)) != NULL)
         {
           // currently 92 bytes is enough for ctrl_str, but extra space avoids
           //  introducing bugs when controller type text would be changed
@@ -7397,7 +7419,7 @@ nes_init (st_ucon64_nfo_t *rominfo)
         }
 
       x = 0;
-      if ((unif_chunk = read_chunk (VROR_ID, rom_buffer, 0)) != NULL)
+      if ((unif_chunk = read_chunk (p, VROR_ID, rom_buffer, 0)) != NULL)
         {
           x = 1;
           free (unif_chunk);
@@ -7414,14 +7436,15 @@ nes_init (st_ucon64_nfo_t *rominfo)
 
         rominfo->backup_usage = pasofami_usage[0].help;
         rominfo->backup_header_start = 0;
-        strcpy (prm_fname, ucon64.fname);
+        strcpy (prm_fname, p->fname);
         set_suffix (prm_fname, ".prm");
         if (access (prm_fname, F_OK) == 0)
           {
             rominfo->backup_header_len = (unsigned int) fsizeof (prm_fname);
             // we use ffe_header to save some space
-            ucon64_fread (&ffe_header, 0, rominfo->backup_header_len, prm_fname);
-            rominfo->backup_header = &ffe_header;
+            ucon64_fread (&cd->ffe_header, 0, rominfo->backup_header_len,
+                          prm_fname);
+            rominfo->backup_header = &cd->ffe_header;
           }
         else
           rominfo->backup_header_len = 0;
@@ -7436,29 +7459,33 @@ nes_init (st_ucon64_nfo_t *rominfo)
         Note that nes_j() wouldn't be much different if ucon64_chksum() would be
         used. This function wouldn't be much different either.
       */
-      n = nes_j (&rom_buffer);
-      rominfo->data_size = (ines_header.prg_size << 14) + (ines_header.chr_size << 13) +
-                             ((ines_header.ctrl1 & INES_TRAINER) ? 512 : 0);
+      n = nes_j (p, &rom_buffer);
+      rominfo->data_size = (cd->ines_header.prg_size << 14) +
+                             (cd->ines_header.chr_size << 13) +
+                             ((cd->ines_header.ctrl1 & INES_TRAINER) ? 512 : 0);
       if (n == 0)
         {                                       // use buf only if it could be allocated
-          ucon64.crc32 = crc32 (0, rom_buffer, (unsigned int) rominfo->data_size);
+          p->crc32 = crc32 (0, rom_buffer, (unsigned int) rominfo->data_size);
           free (rom_buffer);
         }
 
       pos += sprintf (rominfo->misc + pos, "Size: %.4f Mb\n",
                       TOMBIT_F (rominfo->data_size));
-      pos += sprintf (rominfo->misc + pos, "PRG size: %.4f Mb\n", // ROM, don't say internal,
-                      TOMBIT_F (ines_header.prg_size << 14));     //  because it's not
+      // ROM, don't say internal, because it's not
+      pos += sprintf (rominfo->misc + pos, "PRG size: %.4f Mb\n",
+                      TOMBIT_F (cd->ines_header.prg_size << 14));
       pos += sprintf (rominfo->misc + pos, "CHR size: %.4f Mb\n", // VROM
-                      TOMBIT_F (ines_header.chr_size << 13));
+                      TOMBIT_F (cd->ines_header.chr_size << 13));
       pos += sprintf (rominfo->misc + pos, "Memory mapper (iNES): %d\n",
-                      (ines_header.ctrl1 >> 4) | (ines_header.ctrl2 & 0xf0));
+                      (cd->ines_header.ctrl1 >> 4) |
+                        (cd->ines_header.ctrl2 & 0xf0));
       pos += sprintf (rominfo->misc + pos, "Mirroring: %s\n",
-                      (ines_header.ctrl1 & INES_MIRROR) ? "Vertical" : "Horizontal");
+                      (cd->ines_header.ctrl1 & INES_MIRROR) ?
+                        "Vertical" : "Horizontal");
       pos += sprintf (rominfo->misc + pos, "Save RAM: %s\n",
-                      (ines_header.ctrl1 & INES_SRAM) ? "Yes" : "No");
+                      (cd->ines_header.ctrl1 & INES_SRAM) ? "Yes" : "No");
       pos += sprintf (rominfo->misc + pos, "512-byte trainer: %s",
-                      (ines_header.ctrl1 & INES_TRAINER) ? "Yes" : "No");
+                      (cd->ines_header.ctrl1 & INES_TRAINER) ? "Yes" : "No");
       break;
     case FFE:
       if (magic[10] == 1)
@@ -7470,7 +7497,7 @@ nes_init (st_ucon64_nfo_t *rominfo)
           rominfo->maker = "Publisher: N/A";
           rominfo->country = "Country: N/A";
           rominfo->has_internal_crc = 0;
-          ucon64.split = 0;                     // RTS files are never split
+          p->split = 0;                         // RTS files are never split
           sprintf (rominfo->misc + pos, "Type: Super Magic Card RTS file\n");
           return 0;                             // rest is nonsense for RTS file
         }
@@ -7488,53 +7515,54 @@ nes_init (st_ucon64_nfo_t *rominfo)
       rominfo->backup_usage = smc_usage[0].help;
       rominfo->backup_header_start = 0;
       rominfo->backup_header_len = SMC_HEADER_LEN;
-      ucon64_fread (&ffe_header, 0, SMC_HEADER_LEN, ucon64.fname);
-      rominfo->backup_header = &ffe_header;
+      ucon64_fread (&cd->ffe_header, 0, SMC_HEADER_LEN, p->fname);
+      rominfo->backup_header = &cd->ffe_header;
 
       pos += sprintf (rominfo->misc + pos, "512-byte trainer: %s",
-                      (ffe_header.emulation1 & SMC_TRAINER) ? "Yes" : "No");
+                      (cd->ffe_header.emulation1 & SMC_TRAINER) ? "Yes" : "No");
       break;
     case FDS:
       rominfo->backup_usage = fds_usage[0].help;
       rominfo->country = "Japan";
       pos += sprintf (rominfo->misc + pos, "\n");
-      nes_fdsl (rominfo, rominfo->misc);        // will also fill in rominfo->name
+      nes_fdsl (p, rominfo, rominfo->misc);     // will also fill in rominfo->name
       break;
     case FAM:
       rominfo->backup_usage = fds_usage[0].help;
       rominfo->country = "Japan";
 
       // FAM files don't have a header. Instead they seem to have a 192 byte trailer.
-      rominfo->backup_header_start = (int) ucon64.fsize - FAM_HEADER_LEN;
+      rominfo->backup_header_start = (int) p->fsize - FAM_HEADER_LEN;
       rominfo->backup_header_len = FAM_HEADER_LEN;
 
       // we use ffe_header to save some space
-      ucon64_fread (&ffe_header, rominfo->backup_header_start, FAM_HEADER_LEN, ucon64.fname);
-      rominfo->backup_header = &ffe_header;
+      ucon64_fread (&cd->ffe_header, rominfo->backup_header_start,
+                    FAM_HEADER_LEN, p->fname);
+      rominfo->backup_header = &cd->ffe_header;
       pos += sprintf (rominfo->misc + pos, "\n");
-      nes_fdsl (rominfo, rominfo->misc);        // will also fill in rominfo->name
+      nes_fdsl (p, rominfo, rominfo->misc);     // will also fill in rominfo->name
 
-      rom_size = (unsigned int) ucon64.fsize - FAM_HEADER_LEN;
+      rom_size = (unsigned int) p->fsize - FAM_HEADER_LEN;
       if ((rom_buffer = (unsigned char *) malloc (rom_size)) == NULL)
         {
           fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], rom_size);
           return -1;
         }
-      ucon64_fread (rom_buffer, 0, rom_size, ucon64.fname);
-      ucon64.crc32 = crc32 (0, rom_buffer, rom_size);
+      ucon64_fread (rom_buffer, 0, rom_size, p->fname);
+      p->crc32 = crc32 (0, rom_buffer, rom_size);
       free (rom_buffer);
       break;
     }
 
-  if (UCON64_ISSET2 (ucon64.backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
-    rominfo->backup_header_len = ucon64.backup_header_len;
+  if (UCON64_ISSET2 (p->backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
+    rominfo->backup_header_len = p->backup_header_len;
 
-  if (ucon64.crc32 == 0)
-    ucon64_chksum (NULL, NULL, &ucon64.crc32, ucon64.fname,
-                   (int) ucon64.fsize, rominfo->backup_header_len);
+  if (p->crc32 == 0)
+    ucon64_chksum (NULL, NULL, NULL, &p->crc32, p->fname,
+                   (int) p->fsize, rominfo->backup_header_len, p->settings->chksum_flags);
 
   // additional info
-  key.crc32 = ucon64.crc32;
+  key.crc32 = p->crc32;
   info = (st_nes_data_t *) bsearch (&key, nes_data, sizeof nes_data / sizeof (st_nes_data_t),
                                     sizeof (st_nes_data_t), nes_compare);
   if (info)
@@ -7590,13 +7618,14 @@ fdsl_toprint (int c)
 
 
 int
-nes_fdsl (st_ucon64_nfo_t *rominfo, char *output_str)
+nes_fdsl (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, char *output_str)
 /*
   Note that NES people prefer $ to signify hexadecimal numbers (not 0x).
   However we will print only addresses that way.
   This code is based on Marat Fayzullin's FDSLIST.
 */
 {
+  st_nes_state_t *cd = nes_state (p);
   FILE *srcfile;
   unsigned char buffer[58];
   char name[16], str_list_mem[6], *str_list[4], info_mem[MAXBUFSIZE], *info;
@@ -7612,21 +7641,21 @@ nes_fdsl (st_ucon64_nfo_t *rominfo, char *output_str)
     info = output_str;
   info_pos = (unsigned int) strlen (info);
 
-  if ((srcfile = fopen (ucon64.fname, "rb")) == NULL)
+  if ((srcfile = fopen (p->fname, "rb")) == NULL)
     {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ucon64.fname);
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], p->fname);
       return -1;
     }
 
-  n_disks = ((int) ucon64.fsize - rominfo->backup_header_len) / 65500;
-  x = (ucon64.fsize - rominfo->backup_header_len) % 65500;
+  n_disks = ((int) p->fsize - rominfo->backup_header_len) / 65500;
+  x = (p->fsize - rominfo->backup_header_len) % 65500;
   if (x)
     info_pos += sprintf (info + info_pos, "WARNING: %d excessive bytes\n", x);
 
-  if (type == FDS)
+  if (cd->type == FDS)
     header_len = rominfo->backup_header_len;
-  else if (type == FAM)                         // if type == FAM rominfo->backup_header_len
-    header_len = 0;                             //  contains the length of the trailer
+  else if (cd->type == FAM)                     // FAM: backup_header_len is
+    header_len = 0;                             //  the length of the trailer
   for (disk = 0; disk < n_disks; disk++)
     {
       int file = 0, n_files;
@@ -7719,10 +7748,11 @@ nes_fds (void)
   The "algorithm" comes from Marat Fayzullin's FAM2FDS.
 */
 {
+  st_nes_state_t *cd = nes_state (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], *buffer;
   int n;
 
-  if (type != FAM)
+  if (cd->type != FAM)
     {
       fprintf (stderr, "ERROR: %s is not a FAM file\n", ucon64.fname);
       return -1;
@@ -63,47 +63,54 @@ typedef struct st_ngp_header
 #define NGP_HEADER_START 0
 #define NGP_HEADER_LEN (sizeof (st_ngp_header_t))
 
-static st_ngp_header_t ngp_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_ngp_header_t header;
+} st_ngp_data_t;
+#define ngp_data(p) ((st_ngp_data_t *) \
+  ucon64_console_data (p, UCON64_NGP, sizeof (st_ngp_data_t)))
 
 
 int
-ngp_init (st_ucon64_nfo_t *rominfo)
+ngp_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_ngp_data_t *cd = ngp_data (p);
   int result = -1;
   unsigned int pos = (unsigned int) strlen (rominfo->misc);
   char *snk_code = "COPYRIGHT BY SNK CORPORATION",
        *third_code = " LICENSED BY SNK CORPORATION";
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  ucon64_fread (&ngp_header, NGP_HEADER_START + rominfo->backup_header_len,
-                NGP_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->header, NGP_HEADER_START + rominfo->backup_header_len,
+                NGP_HEADER_LEN, p->fname);
 
-  if (!strcmp ((char *) &OFFSET (ngp_header, 0), snk_code) ||
-      !strcmp ((char *) &OFFSET (ngp_header, 0), third_code))
+  if (!strcmp ((char *) &OFFSET (cd->header, 0), snk_code) ||
+      !strcmp ((char *) &OFFSET (cd->header, 0), third_code))
     result = 0;
   else
     result = -1;
-  if (ucon64.console == UCON64_NGP)
+  if (p->console == UCON64_NGP)
     result = 0;
 
   rominfo->header_start = NGP_HEADER_START;
   rominfo->header_len = NGP_HEADER_LEN;
-  rominfo->header = &ngp_header;
+  rominfo->header = &cd->header;
 
   // internal ROM name
-  strncpy (rominfo->name, (char *) &OFFSET (ngp_header, 0x24), 12);
+  strncpy (rominfo->name, (char *) &OFFSET (cd->header, 0x24), 12);
   rominfo->name[12] = '\0';
 
   // ROM maker
-  rominfo->maker = !strcmp ((char *) &OFFSET (ngp_header, 0), snk_code) ?
+  rominfo->maker = !strcmp ((char *) &OFFSET (cd->header, 0), snk_code) ?
                      "SNK" : "Third party";
 
   // misc stuff
   sprintf (rominfo->misc + pos, "Mode: %s",
-           (OFFSET (ngp_header, 0x23) == 0x00) ? "Mono" :
-           (OFFSET (ngp_header, 0x23) == 0x10) ? "Color" :
+           (OFFSET (cd->header, 0x23) == 0x00) ? "Mono" :
+           (OFFSET (cd->header, 0x23) == 0x10) ? "Color" :
            "Unknown");
 
   rominfo->console_usage = ngp_usage[0].help;
@@ -27,6 +27,6 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 extern const st_getopt2_t ngp_usage[];
 
-extern int ngp_init (st_ucon64_nfo_t *rominfo);
+extern int ngp_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 
 #endif
@@ -51,6 +51,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "misc/file.h"
 #include "misc/misc.h"
 #include "misc/string.h"
+#include "misc/xform.h"
 #include "ucon64_misc.h"
 #include "console/pce.h"
 #include "backup/mgd.h"
@@ -658,23 +659,6 @@ pce_compare (const void *key, const void *found)
 }
 
 
-static void
-swapbits (unsigned char *buffer, int size)
-{
-  int n;
-
-  for (n = 0; n < size; n++)
-    {
-      unsigned char byte = 0, bit;
-
-      for (bit = 0; bit < 8; bit++)
-        if (buffer[n] & (1 << bit))
-          byte |= 1 << (7 - bit);
-      buffer[n] = byte;
-    }
-}
-
-
 // header format is specified in src/backup/ffe.h
 int
 pce_msg (st_ucon64_nfo_t *rominfo)
@@ -708,7 +692,7 @@ pce_msg (st_ucon64_nfo_t *rominfo)
     {
       // Magic Super Griffin files should not be "interleaved"
       ucon64_fread (rom_buffer, rominfo->backup_header_len, size, src_name);
-      swapbits (rom_buffer, size);
+      mem_bitrev (rom_buffer, size);
       ucon64_fwrite (rom_buffer, MSG_HEADER_LEN, size, dest_name, "ab");
       free (rom_buffer);
     }
@@ -745,7 +729,7 @@ pce_mgd (st_ucon64_nfo_t *rominfo)
   if (!rominfo->interleaved)
     {
       ucon64_fread (rom_buffer, rominfo->backup_header_len, size, src_name);
-      swapbits (rom_buffer, size);
+      mem_bitrev (rom_buffer, size);
       ucon64_fwrite (rom_buffer, 0, size, dest_name, "wb");
       free (rom_buffer);
     }
@@ -781,7 +765,7 @@ pce_swap (st_ucon64_nfo_t *rominfo)
     fcopy (src_name, 0, rominfo->backup_header_len, dest_name, "wb");
 
   ucon64_fread (rom_buffer, rominfo->backup_header_len, size, src_name);
-  swapbits (rom_buffer, size);
+  mem_bitrev (rom_buffer, size);
   ucon64_fwrite (rom_buffer, rominfo->backup_header_len, size, dest_name,
                  rominfo->backup_header_len ? "ab" : "wb");
   free (rom_buffer);
@@ -907,7 +891,7 @@ pce_multi (unsigned int truncate_size)
       ucon64.fsize = fsizeof (ucon64.fname);
       // DON'T use fstate.st_size, because file could be compressed
       ucon64.do_not_calc_crc = 1;
-      if (pce_init (ucon64.nfo) != 0)
+      if (pce_init (&ucon64, ucon64.nfo) != 0)
         printf ("WARNING: %s does not appear to be a PC-Engine ROM\n", ucon64.fname);
 
       if ((srcfile = fopen (ucon64.fname, "rb")) == NULL)
@@ -1065,23 +1049,23 @@ pce_check (unsigned char *buf, unsigned int len)
 
 
 int
-pce_init (st_ucon64_nfo_t *rominfo)
+pce_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   int result = -1, swapped;
   unsigned int size, x, pos = (unsigned int) strlen (rominfo->misc);
   unsigned char *rom_buffer;
 
-  x = ucon64.fsize % (16 * 1024);
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : ucon64.fsize > x ? x : 0;
+  x = p->fsize % (16 * 1024);
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : p->fsize > x ? x : 0;
 
-  size = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
+  size = (unsigned int) p->fsize - rominfo->backup_header_len;
   if ((rom_buffer = (unsigned char *) malloc (size)) == NULL)
     {
       fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
       return -1;
     }
-  ucon64_fread (rom_buffer, rominfo->backup_header_len, size, ucon64.fname);
+  ucon64_fread (rom_buffer, rominfo->backup_header_len, size, p->fname);
 
   if (pce_check (rom_buffer, size) == 1)
     result = 0;
@@ -1107,14 +1091,14 @@ pce_init (st_ucon64_nfo_t *rominfo)
        memmem2 (rom_buffer, x, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26, 0) == 0 &&
        memcmp (rom_buffer, "HESM", 4))
     swapped = 1;
-  if (UCON64_ISSET (ucon64.interleaved))
-    swapped = ucon64.interleaved;
+  if (UCON64_ISSET (p->interleaved))
+    swapped = p->interleaved;
 
   if ((result == -1 && swapped != 0) || swapped == 1)
     {                                   // don't swap the bits if -nint is specified
-      if (!UCON64_ISSET (ucon64.do_not_calc_crc) || swapped == 1)
-        ucon64.fcrc32 = crc32 (0, rom_buffer, size);
-      swapbits (rom_buffer, size);
+      if (!UCON64_ISSET (p->do_not_calc_crc) || swapped == 1)
+        p->fcrc32 = crc32 (0, rom_buffer, size);
+      mem_bitrev (rom_buffer, size);
       if (pce_check (rom_buffer, size) == 1)
         {
           swapped = 1;
@@ -1122,14 +1106,14 @@ pce_init (st_ucon64_nfo_t *rominfo)
         }
       if (swapped != 1)
         {
-          ucon64.crc32 = ucon64.fcrc32;
-          ucon64.fcrc32 = 0;
+          p->crc32 = p->fcrc32;
+          p->fcrc32 = 0;
         }
     }
   if (swapped != -1)
     rominfo->interleaved = swapped;
 
-  if (ucon64.console == UCON64_PCE)
+  if (p->console == UCON64_PCE)
     result = 0;
 
   rominfo->header_start = PCE_HEADER_START;
@@ -1137,14 +1121,14 @@ pce_init (st_ucon64_nfo_t *rominfo)
   rominfo->console_usage = pce_usage[0].help;
   rominfo->backup_usage = rominfo->backup_header_len ? msg_usage[0].help : mgd_usage[0].help;
 
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
       st_pce_data_t *info, key;
 
-      if (!ucon64.crc32)
-        ucon64.crc32 = crc32 (0, rom_buffer, size);
+      if (!p->crc32)
+        p->crc32 = crc32 (0, rom_buffer, size);
       // additional info
-      key.crc32 = ucon64.crc32;
+      key.crc32 = p->crc32;
       info = (st_pce_data_t *) bsearch (&key, pce_data,
                                         sizeof pce_data / sizeof (st_pce_data_t),
                                         sizeof (st_pce_data_t), pce_compare);
@@ -28,7 +28,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 extern const st_getopt2_t pce_usage[];
 
-extern int pce_init (st_ucon64_nfo_t *rominfo);
+extern int pce_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int pce_mgd (st_ucon64_nfo_t *rominfo);
 extern int pce_msg (st_ucon64_nfo_t *rominfo);
 extern int pce_swap (st_ucon64_nfo_t *rominfo);
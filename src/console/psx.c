@@ -43,10 +43,11 @@ const st_getopt2_t psx_usage[] =
 
 
 int
-psx_init (st_ucon64_nfo_t *rominfo)
+psx_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   int result = -1;
 
+  (void) p;
   rominfo->console_usage = psx_usage[0].help;
 //  rominfo->backup_usage = cdrw_usage[0].help;
 
@@ -62,7 +62,8 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define SMS_HEADER_START 0x7ff0
 #define SMS_HEADER_LEN (sizeof (st_sms_header_t))
 
-static int sms_chksum (unsigned char *rom_buffer, unsigned int rom_size);
+static int sms_chksum (st_ucon64_t *p, unsigned char *rom_buffer,
+                       unsigned int rom_size);
 
 
 static st_ucon64_obj_t sms_obj[] =
@@ -144,8 +145,14 @@ typedef struct st_sms_header
   unsigned char checksum_range;                 // 15, and country info
 } st_sms_header_t;
 
-static st_sms_header_t sms_header;
-static int is_gamegear;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_sms_header_t header;
+  int is_gamegear;
+} st_sms_data_t;
+#define sms_data(p) ((st_sms_data_t *) \
+  ucon64_console_data (p, UCON64_SMS, sizeof (st_sms_data_t)))
 
 
 // see src/backup/mgd.h for the file naming scheme
@@ -253,10 +260,11 @@ sms_smds (void)
 int
 sms_chk (st_ucon64_nfo_t *rominfo)
 {
+  st_sms_data_t *cd = sms_data (&ucon64);
   char buf[2], dest_name[FILENAME_MAX];
   int offset = rominfo->header_start + 10;
 
-  if (is_gamegear)
+  if (cd->is_gamegear)
     {
       fputs ("ERROR: This option works only for SMS (not Game Gear) files\n", stderr);
       return -1;
@@ -334,6 +342,7 @@ write_game_table_entry (FILE *destfile, int file_no, size_t totalsize,
 int
 sms_multi (unsigned int truncate_size)
 {
+  st_sms_data_t *cd = sms_data (&ucon64);
   unsigned int n, n_files, file_no, done, truncated = 0, size,
                org_do_not_calc_crc = ucon64.do_not_calc_crc;
   size_t bytestowrite, byteswritten, totalsize = 0;
@@ -387,7 +396,7 @@ sms_multi (unsigned int truncate_size)
       ucon64.fsize = fsizeof (ucon64.fname);
       // DON'T use fstate.st_size, because file could be compressed
       ucon64.do_not_calc_crc = 1;
-      if (sms_init (ucon64.nfo) != 0)
+      if (sms_init (&ucon64, ucon64.nfo) != 0)
         printf ("WARNING: %s does not appear to be an SMS/GG ROM\n", ucon64.fname);
 
       if ((srcfile = fopen (ucon64.fname, "rb")) == NULL)
@@ -482,8 +491,8 @@ sms_multi (unsigned int truncate_size)
   fseek (destfile, 0, SEEK_SET);
   n = (unsigned int) fread (buffer, 1, 0x20000, destfile); // 0x0f => checksum range = 0x20000
   buffer[SMS_HEADER_START + 15] |= 0x0f;        // overwrite checksum range byte
-  sms_header.checksum_range = 0x0f;             // sms_chksum() uses this variable
-  n = sms_chksum (buffer, n);
+  cd->header.checksum_range = 0x0f;             // sms_chksum() uses this variable
+  n = sms_chksum (&ucon64, buffer, n);
 
   buffer[SMS_HEADER_START + 10] = (unsigned char) n; // low byte
   buffer[SMS_HEADER_START + 11] = (unsigned char) (n >> 8); // high byte
@@ -502,12 +511,12 @@ sms_multi (unsigned int truncate_size)
 
 
 static int
-sms_testinterleaved (st_ucon64_nfo_t *rominfo)
+sms_testinterleaved (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
   unsigned char buf[0x4000] = { 0 };
 
   ucon64_fread (buf, rominfo->backup_header_len + 0x4000, // header in 2nd 16 kB block
-                0x2000 + (SMS_HEADER_START - 0x4000 + 8) / 2, ucon64.fname);
+                0x2000 + (SMS_HEADER_START - 0x4000 + 8) / 2, p->fname);
   if (!(memcmp (buf + SMS_HEADER_START - 0x4000, "TMR SEGA", 8) &&
         memcmp (buf + SMS_HEADER_START - 0x4000, "TMR ALVS", 8) && // SMS
         memcmp (buf + SMS_HEADER_START - 0x4000, "TMR SMSC", 8) && // SMS (unofficial)
@@ -529,7 +538,7 @@ sms_testinterleaved (st_ucon64_nfo_t *rominfo)
 #define MAX_ID_OFFSET 0x31a
 #define SEARCHBUFSIZE (256 + 16 * 1024 + MAX_ID_OFFSET + 12) // max detected "header" is 16 kB
 static unsigned int
-sms_header_len (int *signature_found)
+sms_header_len (st_ucon64_t *p, int *signature_found)
 /*
   At first sight it seems reasonable to also determine whether the file is
   interleaved in this function. However, we run into a chicken-and-egg problem:
@@ -543,9 +552,9 @@ sms_header_len (int *signature_found)
 {
   *signature_found = 0;
   // first two hacks for Majesco Game Gear BIOS (U) [!]
-  if (ucon64.fsize == 1024)
+  if (p->fsize == 1024)
     return 0;
-  else if (ucon64.fsize == 1024 + SMD_HEADER_LEN)
+  else if (p->fsize == 1024 + SMD_HEADER_LEN)
     return SMD_HEADER_LEN;
   else
     {
@@ -553,7 +562,7 @@ sms_header_len (int *signature_found)
                     search_str[][9] = { "TMR SEGA", "TMR ALVS", "TMR SMSC", "TMG SEGA" };
       unsigned int n;
 
-      ucon64_fread (buffer, SMS_HEADER_START - 256, SEARCHBUFSIZE, ucon64.fname);
+      ucon64_fread (buffer, SMS_HEADER_START - 256, SEARCHBUFSIZE, p->fname);
 
       for (n = 0; n < sizeof search_str / sizeof search_str[0]; n++)
         {
@@ -589,8 +598,8 @@ sms_header_len (int *signature_found)
             }
         }
 
-      n = ucon64.fsize % (16 * 1024);           // SMD_HEADER_LEN
-      if (ucon64.fsize > n)
+      n = p->fsize % (16 * 1024);               // SMD_HEADER_LEN
+      if (p->fsize > n)
         return n;
       else
         return 0;
@@ -601,56 +610,57 @@ sms_header_len (int *signature_found)
 
 
 int
-sms_init (st_ucon64_nfo_t *rominfo)
+sms_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_sms_data_t *cd = sms_data (p);
   int result = -1, x = 0;
   unsigned int pos = (unsigned int) strlen (rominfo->misc);
   unsigned char buf[16384] = { 0 };
 
-  is_gamegear = 0;
-  memset (&sms_header, 0, SMS_HEADER_LEN);
+  cd->is_gamegear = 0;
+  memset (&cd->header, 0, SMS_HEADER_LEN);
 
-  if (UCON64_ISSET2 (ucon64.backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
-    rominfo->backup_header_len = ucon64.backup_header_len;
+  if (UCON64_ISSET2 (p->backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
+    rominfo->backup_header_len = p->backup_header_len;
   else
-    rominfo->backup_header_len = sms_header_len (&x);
+    rominfo->backup_header_len = sms_header_len (p, &x);
 
-  rominfo->interleaved = UCON64_ISSET (ucon64.interleaved) ?
-                           ucon64.interleaved : sms_testinterleaved (rominfo);
+  rominfo->interleaved = UCON64_ISSET (p->interleaved) ?
+                           p->interleaved : sms_testinterleaved (p, rominfo);
 
   if (rominfo->interleaved)
     {
       ucon64_fread (buf, rominfo->backup_header_len + 0x4000, // header in 2nd 16 kB block
                     0x2000 + (SMS_HEADER_START - 0x4000 + SMS_HEADER_LEN) / 2,
-                    ucon64.fname);
+                    p->fname);
       smd_deinterleave (buf, 0x4000);
-      memcpy (&sms_header, buf + SMS_HEADER_START - 0x4000, SMS_HEADER_LEN);
+      memcpy (&cd->header, buf + SMS_HEADER_START - 0x4000, SMS_HEADER_LEN);
     }
   else
-    ucon64_fread (&sms_header, rominfo->backup_header_len + SMS_HEADER_START,
-                  SMS_HEADER_LEN, ucon64.fname);
+    ucon64_fread (&cd->header, rominfo->backup_header_len + SMS_HEADER_START,
+                  SMS_HEADER_LEN, p->fname);
 
   rominfo->header_start = SMS_HEADER_START;
   rominfo->header_len = SMS_HEADER_LEN;
-  rominfo->header = &sms_header;
+  rominfo->header = &cd->header;
 
-  ucon64_fread (buf, 0, 11, ucon64.fname);
+  ucon64_fread (buf, 0, 11, p->fname);
   // Note that the identification bytes are the same as for Genesis SMD files.
   //  The init function for Genesis files is called before this function so it
   //  is alright to set result to 0.
-  if (ucon64.console == UCON64_SMS || x ||
+  if (p->console == UCON64_SMS || x ||
       (buf[8] == 0xaa && buf[9] == 0xbb && buf[10] == 6) ||
-      !(memcmp (sms_header.signature, "TMR SEGA", 8) &&  // SMS or GG
-        memcmp (sms_header.signature, "TMR ALVS", 8) &&  // SMS
-        memcmp (sms_header.signature, "TMR SMSC", 8) &&  // SMS (unofficial)
-        memcmp (sms_header.signature, "TMG SEGA", 8)))   // GG
+      !(memcmp (cd->header.signature, "TMR SEGA", 8) &&  // SMS or GG
+        memcmp (cd->header.signature, "TMR ALVS", 8) &&  // SMS
+        memcmp (cd->header.signature, "TMR SMSC", 8) &&  // SMS (unofficial)
+        memcmp (cd->header.signature, "TMG SEGA", 8)))   // GG
     result = 0;
   else
     result = -1;
 
-  x = sms_header.checksum_range & 0xf0;
+  x = cd->header.checksum_range & 0xf0;
   if (x == 0x50 || x == 0x60 || x == 0x70)
-    is_gamegear = 1;
+    cd->is_gamegear = 1;
 
   switch (x)
     {
@@ -670,9 +680,9 @@ sms_init (st_ucon64_nfo_t *rominfo)
       break;
     }
 
-  if (!UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0)
+  if (!UCON64_ISSET (p->do_not_calc_crc) && result == 0)
     {
-      unsigned int size = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
+      unsigned int size = (unsigned int) p->fsize - rominfo->backup_header_len;
       unsigned char *rom_buffer;
 
       if ((rom_buffer = (unsigned char *) malloc (size)) == NULL)
@@ -680,31 +690,31 @@ sms_init (st_ucon64_nfo_t *rominfo)
           fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
           return -1;
         }
-      ucon64_fread (rom_buffer, rominfo->backup_header_len, size, ucon64.fname);
+      ucon64_fread (rom_buffer, rominfo->backup_header_len, size, p->fname);
 
       if (rominfo->interleaved)
         {
-          ucon64.fcrc32 = crc32 (0, rom_buffer, size);
+          p->fcrc32 = crc32 (0, rom_buffer, size);
           smd_deinterleave (rom_buffer, size);
         }
-      ucon64.crc32 = crc32 (0, rom_buffer, size);
+      p->crc32 = crc32 (0, rom_buffer, size);
 
-      if (!is_gamegear)
+      if (!cd->is_gamegear)
         {
           rominfo->has_internal_crc = 1;
           rominfo->internal_crc_len = 2;
-          rominfo->current_internal_crc = sms_chksum (rom_buffer, size);
-          rominfo->internal_crc = sms_header.checksum_low;
-          rominfo->internal_crc += sms_header.checksum_high << 8;
+          rominfo->current_internal_crc = sms_chksum (p, rom_buffer, size);
+          rominfo->internal_crc = cd->header.checksum_low;
+          rominfo->internal_crc += cd->header.checksum_high << 8;
         }
 
       free (rom_buffer);
     }
 
   pos += sprintf (rominfo->misc + pos, "Part number: 0x%04x\n",
-                  sms_header.partno_low + (sms_header.partno_high << 8) +
-                    ((sms_header.version & 0xf0) << 12));
-  sprintf (rominfo->misc + pos, "Version: %d", sms_header.version & 0xf);
+                  cd->header.partno_low + (cd->header.partno_high << 8) +
+                    ((cd->header.version & 0xf0) << 12));
+  sprintf (rominfo->misc + pos, "Version: %d", cd->header.version & 0xf);
 
   rominfo->console_usage = sms_usage[0].help;
   rominfo->backup_usage = !rominfo->backup_header_len ?
@@ -715,12 +725,13 @@ sms_init (st_ucon64_nfo_t *rominfo)
 
 
 static int
-sms_chksum (unsigned char *rom_buffer, unsigned int rom_size)
+sms_chksum (st_ucon64_t *p, unsigned char *rom_buffer, unsigned int rom_size)
 {
+  st_sms_data_t *cd = sms_data (p);
   unsigned short int sum;
   unsigned int i, i_end;
 
-  switch (sms_header.checksum_range & 0xf)
+  switch (cd->header.checksum_range & 0xf)
     {
     case 0xc:
       i_end = 0x7ff0;
@@ -31,7 +31,7 @@ extern const st_getopt2_t sms_usage[];
 extern int sms_gg (st_ucon64_nfo_t *rominfo);
 extern int sms_ggd (st_ucon64_nfo_t *rominfo);
 extern int sms_gge (st_ucon64_nfo_t *rominfo);
-extern int sms_init (st_ucon64_nfo_t *rominfo);
+extern int sms_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int sms_mgd (st_ucon64_nfo_t *rominfo, int console);
 extern int sms_smd (st_ucon64_nfo_t *rominfo);
 extern int sms_smds (void);
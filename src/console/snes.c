@@ -51,6 +51,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "misc/misc.h"
 #include "misc/string.h"
 #include "misc/term.h"
+#include "misc/xform.h"
 #include "ucon64_misc.h"
 #include "console/console.h"
 #include "console/snes.h"
@@ -66,6 +67,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #define SNES_HEADER_LEN (sizeof (st_snes_header_t))
 #define SNES_NAME_LEN 21
+#define SNES_BANKTYPE_LEN 0x4e                  // # bytes check_banktype() reads
 #define GD3_HEADER_MAPSIZE 0x18
 #define NSRT_HEADER_VERSION 22                  // version 2.2 header
 #define DETECT_NOTGOOD_DUMPS                    // makes _a_ complete GoodSNES 0.999.5 set detected
@@ -80,17 +82,21 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define DEFAULT_MAX_BLOCK_SIZE 0x280
 #define MIN_BLOCK_SIZE 0xff
 
-static int snes_chksum (st_ucon64_nfo_t *rominfo, unsigned char *rom_buffer,
-                        unsigned int rom_size);
+static int snes_chksum (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                        const st_block_view_t *view, unsigned int rom_size);
+static int snes_deinterleave_map (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                                  uint16_t *blocks, unsigned int rom_size);
 static int snes_deinterleave (st_ucon64_nfo_t *rominfo, unsigned char **rom_buffer,
                               unsigned int rom_size);
-static unsigned int snes_check_bs (void);
-static unsigned int check_banktype (unsigned char *rom_buffer, unsigned int header_offset);
+static unsigned int snes_check_bs (st_ucon64_t *p);
+static unsigned int check_banktype (st_ucon64_t *p, const unsigned char *header,
+                                    unsigned int header_offset);
 static void reset_header (void *header);
 static void set_nsrt_info (st_ucon64_nfo_t *rominfo, unsigned char *header);
-static void get_nsrt_info (unsigned char *rom_buffer, int header_start,
-                           unsigned char *backup_header);
-static void handle_nsrt_header (st_ucon64_nfo_t *rominfo, unsigned char *header,
+static void get_nsrt_info (st_ucon64_t *p, unsigned char *rom_buffer,
+                           int header_start, unsigned char *backup_header);
+static void handle_nsrt_header (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                                unsigned char *header,
                                 const char **snes_country);
 
 
@@ -467,7 +473,7 @@ typedef struct st_split_info
   int nparts;
   struct st_part
   {
-    char *fname;
+    char fname[FILENAME_MAX];
     unsigned int size;
   } parts[2];
 } st_split_info_t;
@@ -495,57 +501,68 @@ typedef struct st_ustar_header
   char pad[12];
 } st_ustar_header_t;
 
-static st_snes_header_t snes_header;
-static unsigned int snes_sram_size, snes_sfx_sram_size, snes_header_base,
-                    snes_hirom, snes_hirom_ok, nsrt_header, bs_dump, st_dump;
-static snes_copier_t copier_type;
-static st_split_info_t split_info = { 0, { { 0, 0 }, { 0, 0 } } };
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_snes_header_t header;
+  unsigned int sram_size, sfx_sram_size, header_base, hirom, hirom_ok,
+               nsrt_header, bs_dump, st_dump;
+  snes_copier_t copier_type;
+  st_split_info_t split_info;
+} st_snes_data_t;
+#define snes_data(p) ((st_snes_data_t *) \
+  ucon64_console_data (p, UCON64_SNES, sizeof (st_snes_data_t)))
 
 
 unsigned int
-snes_get_snes_hirom (void)
+snes_get_snes_hirom (st_ucon64_t *p)
 {
-  return snes_hirom;
+  return snes_data (p)->hirom;
 }
 
 
 snes_copier_t
-snes_get_copier_type (void)
+snes_get_copier_type (st_ucon64_t *p)
 {
-  return copier_type;
+  return snes_data (p)->copier_type;
 }
 
 
 static unsigned char
-get_internal_size (void)
+get_internal_size (st_ucon64_t *p)
 {
-  unsigned int size = !bs_dump ?
-                        (1 << snes_header.rom_size) >> 7 :
-                        8 - ((snes_header.bs_type & 0x20) >> 3);
+  st_snes_data_t *cd = snes_data (p);
+  unsigned int size = !cd->bs_dump ?
+                        (1 << cd->header.rom_size) >> 7 :
+                        8 - ((cd->header.bs_type & 0x20) >> 3);
   return size <= 128 ? (unsigned char) size : 128;
 }
 
 
 static unsigned int
-get_rom_data_size (unsigned int backup_header_len)
+get_rom_data_size (st_ucon64_t *p, unsigned int backup_header_len)
 {
-  return copier_type != IC2 ?
-           (unsigned int) ucon64.fsize - backup_header_len :
-           2 * (split_info.parts[1].size - backup_header_len);
+  st_snes_data_t *cd = snes_data (p);
+
+  return cd->copier_type != IC2 ?
+           (unsigned int) p->fsize - backup_header_len :
+           2 * (cd->split_info.parts[1].size - backup_header_len);
 }
 
 
 static void
-read_rom_data (unsigned char *buffer, unsigned int start, unsigned int length,
-               const char *filename)
+read_rom_data (st_ucon64_t *p, unsigned char *buffer, unsigned int start,
+               unsigned int length, const char *filename)
 {
-  if (copier_type != IC2)
+  st_snes_data_t *cd = snes_data (p);
+
+  if (cd->copier_type != IC2)
     ucon64_fread (buffer, start, length, filename);
   else
     {
       ucon64_fread (buffer, start, length / 2, filename);
       ucon64_fread (buffer + length / 2, start, length / 2,
-                    split_info.parts[1].fname);
+                    cd->split_info.parts[1].fname);
     }
 }
 
@@ -553,13 +570,14 @@ read_rom_data (unsigned char *buffer, unsigned int start, unsigned int length,
 static unsigned int
 get_header_start (st_ucon64_nfo_t *rominfo, unsigned int size)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned int header_start;
 
   if (rominfo->interleaved)
-    header_start = SNES_HEADER_START + (snes_hirom ?
-                     (copier_type == UFO ? snes_header_base / 2 : 0) :
+    header_start = SNES_HEADER_START + (cd->hirom ?
+                     (cd->copier_type == UFO ? cd->header_base / 2 : 0) :
                      size / 2);                 // (Ext.) HiROM : LoROM
-  else if (st_dump)                             // ignore interleaved ST dumps
+  else if (cd->st_dump)                         // ignore interleaved ST dumps
     header_start = 8 * MBIT;
   else
     header_start = rominfo->header_start;
@@ -571,6 +589,7 @@ static unsigned int
 update_chksum (st_ucon64_nfo_t *rominfo, unsigned char *sum, unsigned int size,
                const char *dest_name)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned int header_start = get_header_start (rominfo, size);
 
   /*
@@ -580,10 +599,10 @@ update_chksum (st_ucon64_nfo_t *rominfo, unsigned char *sum, unsigned int size,
     (one's complement)), but they may have been corrupted. We account for that.
     Otherwise we would have to run uCON64 on the ROM twice.
   */
-  rominfo->current_internal_crc += -(snes_header.inverse_checksum_low +
-                                     snes_header.inverse_checksum_high +
-                                     snes_header.checksum_low +
-                                     snes_header.checksum_high) +
+  rominfo->current_internal_crc += -(cd->header.inverse_checksum_low +
+                                     cd->header.inverse_checksum_high +
+                                     cd->header.checksum_low +
+                                     cd->header.checksum_high) +
                                    2 * 0xff; // + 2 * 0;
   // change inverse checksum
   sum[0] = (unsigned char) ~rominfo->current_internal_crc; // low byte
@@ -1018,13 +1037,13 @@ display_ustar_header (const st_ustar_header_t *header)
 
 
 static int
-set_smini_chksum_range (unsigned int *base, unsigned int *size,
+set_smini_chksum_range (st_ucon64_t *p, unsigned int *base, unsigned int *size,
                         unsigned int sram_data_size, int check_block_size)
 {
-  int range_start_set = UCON64_ISSET (ucon64.range_start),
-      range_length_set = UCON64_ISSET2 (ucon64.range_length, size_t);
-  *base = range_start_set ? ucon64.range_start : 0;
-  *size = range_length_set ? (unsigned int) ucon64.range_length : sram_data_size - *base;
+  int range_start_set = UCON64_ISSET (p->range_start),
+      range_length_set = UCON64_ISSET2 (p->range_length, size_t);
+  *base = range_start_set ? p->range_start : 0;
+  *size = range_length_set ? (unsigned int) p->range_length : sram_data_size - *base;
 
   // largest valid offset is sram_data_size - 1
   if (sram_data_size && *base >= sram_data_size)
@@ -1081,7 +1100,7 @@ snes_sminis (st_ucon64_nfo_t *rominfo, const char *id)
       free (buffer);
       return -1;
     }
-  if (set_smini_chksum_range (&base, &size, sram_data_size, 1))
+  if (set_smini_chksum_range (&ucon64, &base, &size, sram_data_size, 1))
     {
       free (buffer);
       return -1;
@@ -1152,13 +1171,13 @@ snes_sminis (st_ucon64_nfo_t *rominfo, const char *id)
 
 
 static int
-get_smini_sram_data (const char *src_name, unsigned char *sram_data,
+get_smini_sram_data (st_ucon64_t *p, const char *src_name, unsigned char *sram_data,
                      unsigned int max_sram_data_size, unsigned char *sram_chksum)
 {
   FILE *srcfile;
   size_t file_pos = 0, sram_data_size = 0;
 
-  if (ucon64.fsize < 3 * sizeof (st_ustar_header_t))
+  if (p->fsize < 3 * sizeof (st_ustar_header_t))
     return 0;
 
   if ((srcfile = fopen (src_name, "rb")) == NULL)
@@ -1172,7 +1191,7 @@ get_smini_sram_data (const char *src_name, unsigned char *sram_data,
       st_ustar_header_t header;
       unsigned int file_size;
       size_t bytesread = fread (&header, 1, sizeof header, srcfile);
-      char *p;
+      char *ptr;
 
       file_pos += bytesread;
       if (bytesread < sizeof header)
@@ -1187,7 +1206,7 @@ get_smini_sram_data (const char *src_name, unsigned char *sram_data,
 
       file_size = (unsigned int) strtol (header.file_size, NULL, 8);
       header.name[sizeof header.name - 1] = '\0';
-      p = strrchr (header.name, '/');
+      ptr = strrchr (header.name, '/');
       /*
         header->name is 100 bytes large, but should also store the string
         terminator, which leaves 99 bytes for the name. There should be enough
@@ -1195,21 +1214,21 @@ get_smini_sram_data (const char *src_name, unsigned char *sram_data,
         bytes). We are comparing offsets, so subtract 1 more (the highest valid
         offset for a character is 98), hence > instead of >=.
       */
-      if (p != NULL && sizeof header.name - 1 - (p - header.name) > 19)
+      if (ptr != NULL && sizeof header.name - 1 - (ptr - header.name) > 19)
         {
-          if (!strcmp (p + 1, "cartridge.sram"))
+          if (!strcmp (ptr + 1, "cartridge.sram"))
             sram_data_size = fread (sram_data, 1,
                                     file_size > max_sram_data_size ?
                                       max_sram_data_size : file_size,
                                     srcfile);
-          else if (sram_chksum && !strcmp (p + 1, "cartridge.sram.hash"))
+          else if (sram_chksum && !strcmp (ptr + 1, "cartridge.sram.hash"))
             fread_checked (sram_chksum, 1, file_size > 20 ?
                              20 : file_size, srcfile);
         }
 
       // align on 512-byte boundary (size of st_ustar_header_t)
       file_pos = (file_pos + file_size + 0x1ff) & ~0x1ff;
-      if (file_pos >= ucon64.fsize - 2 * sizeof (st_ustar_header_t))
+      if (file_pos >= p->fsize - 2 * sizeof (st_ustar_header_t))
         break;
       fseek (srcfile, (long) file_pos, SEEK_SET);
     }
@@ -1231,7 +1250,7 @@ snes_smini2srm (void)
       exit (1);
     }
 
-  sram_data_size = get_smini_sram_data (ucon64.fname, buffer, 128 * 1024 + 20,
+  sram_data_size = get_smini_sram_data (&ucon64, ucon64.fname, buffer, 128 * 1024 + 20,
                                         NULL);
   if (sram_data_size > 20)
     {
@@ -1268,14 +1287,14 @@ write_deinterleaved_data (st_ucon64_nfo_t *rominfo, const char *src_name,
 {
   // backup_header_len is the backup unit header length of the destination file
   unsigned char *buffer;
-  unsigned int size = get_rom_data_size (rominfo->backup_header_len);
+  unsigned int size = get_rom_data_size (&ucon64, rominfo->backup_header_len);
 
   if ((buffer = (unsigned char *) malloc (size)) == NULL)
     {
       fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
       exit (1);
     }
-  read_rom_data (buffer, rominfo->backup_header_len, size, src_name);
+  read_rom_data (&ucon64, buffer, rominfo->backup_header_len, size, src_name);
   snes_deinterleave (rominfo, &buffer, size);
   ucon64_fwrite (buffer, backup_header_len, size, dest_name,
                  backup_header_len ? "ab" : "wb");
@@ -1311,8 +1330,9 @@ snes_dint (st_ucon64_nfo_t *rominfo)
 static int
 snes_ffe (st_ucon64_nfo_t *rominfo, char *suffix)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   st_swc_header_t header;
-  unsigned int size = get_rom_data_size (rominfo->backup_header_len);
+  unsigned int size = get_rom_data_size (&ucon64, rominfo->backup_header_len);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
 
   ucon64_fread (&header, 0, rominfo->backup_header_len > SWC_HEADER_LEN ?
@@ -1321,13 +1341,13 @@ snes_ffe (st_ucon64_nfo_t *rominfo, char *suffix)
   header.size_low = (unsigned char) (size / 8192);
   header.size_high = (unsigned char) (size / 8192 >> 8);
 
-  header.emulation = snes_hirom ? 0x30 : 0;
+  header.emulation = cd->hirom ? 0x30 : 0;
   // bit 3 & 2 are already OK for 32 kB SRAM size
-  if (snes_sram_size == 8 * 1024)
+  if (cd->sram_size == 8 * 1024)
     header.emulation |= 0x04;
-  else if (snes_sram_size == 2 * 1024)
+  else if (cd->sram_size == 2 * 1024)
     header.emulation |= 0x08;
-  else if (snes_sram_size == 0)
+  else if (cd->sram_size == 0)
     header.emulation |= 0x0c;
 
   header.id1 = 0xaa;
@@ -1357,7 +1377,9 @@ snes_ffe (st_ucon64_nfo_t *rominfo, char *suffix)
 int
 snes_smc (st_ucon64_nfo_t *rominfo)
 {
-  if ((bs_dump ? snes_header.bs_map_type : snes_header.map_type) & 0x10)
+  st_snes_data_t *cd = snes_data (&ucon64);
+
+  if ((cd->bs_dump ? cd->header.bs_map_type : cd->header.map_type) & 0x10)
     puts ("NOTE: This game may not work with a Super Magicom because it is a FastROM game");
 
   return snes_ffe (rominfo, ".smc");
@@ -1376,43 +1398,44 @@ snes_swc (st_ucon64_nfo_t *rominfo)
 void
 snes_set_fig_header (st_fig_header_t *header, unsigned int backup_header_len)
 {
-  unsigned int size = get_rom_data_size (backup_header_len);
+  st_snes_data_t *cd = snes_data (&ucon64);
+  unsigned int size = get_rom_data_size (&ucon64, backup_header_len);
 
   reset_header (header);
   header->size_low = (unsigned char) (size / 8192);
   header->size_high = (unsigned char) (size / 8192 >> 8);
-  header->hirom = snes_hirom ? 0x80 : 0;
+  header->hirom = cd->hirom ? 0x80 : 0;
 
-  if ((snes_header.rom_type & 0xf0) == 0x10)    // uses FX(2) chip
+  if ((cd->header.rom_type & 0xf0) == 0x10)     // uses FX(2) chip
     {
       header->emulation1 = 0x11;
       header->emulation2 = 0x02;
     }
   else
     {
-      int uses_DSP = snes_header.rom_type == 3 || snes_header.rom_type == 5 ||
-                     snes_header.rom_type == 0xf6;
+      int uses_DSP = cd->header.rom_type == 3 || cd->header.rom_type == 5 ||
+                     cd->header.rom_type == 0xf6;
 
 #if 0                                           // reset_header() set all fields to 0
       header->emulation1 = 0;                   // default value for LoROM dumps
-      if (snes_sram_size == 32 * 1024)
+      if (cd->sram_size == 32 * 1024)
         header->emulation2 = 0;
       else
 #endif
-      if (snes_sram_size == 8 * 1024 || snes_sram_size == 2 * 1024)
+      if (cd->sram_size == 8 * 1024 || cd->sram_size == 2 * 1024)
         header->emulation2 = 0x80;
-      else if (snes_sram_size == 0)
+      else if (cd->sram_size == 0)
         {
           header->emulation1 = 0x77;
           header->emulation2 = 0x83;
         }
 
-      if (snes_hirom)
+      if (cd->hirom)
         {
           header->emulation2 |= 2;
           if (uses_DSP)
             header->emulation1 |= 0xf0;
-          if (snes_sram_size)
+          if (cd->sram_size)
             header->emulation1 |= 0xdd;
         }
       else if (uses_DSP)                        // LoROM
@@ -1596,17 +1619,19 @@ gd_make_name (const char *filename, unsigned int backup_header_len, char *name,
 static void
 snes_set_gd3_header (unsigned int total4Mbparts, unsigned char *header)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
+
   reset_header (header);
   memcpy (header, "GAME DOCTOR SF 3", 0x10);
 
-  if (snes_sram_size == 8 * 1024)
+  if (cd->sram_size == 8 * 1024)
     header[0x10] = 0x81;                        // 64 kb
-  else if (snes_sram_size == 2 * 1024)
+  else if (cd->sram_size == 2 * 1024)
     header[0x10] = 0x82;                        // 16 kb
   else
     header[0x10] = 0x80;                        // 0 kb or 256 kb
 
-  if (snes_hirom)
+  if (cd->hirom)
     {
       unsigned char map_8mb[GD3_HEADER_MAPSIZE] =
         {
@@ -1670,11 +1695,11 @@ snes_set_gd3_header (unsigned int total4Mbparts, unsigned char *header)
       else
         memcpy (&header[0x11], map_64mb, GD3_HEADER_MAPSIZE);
 
-      if (snes_sram_size)
+      if (cd->sram_size)
         {
-          int is_top = !memcmp (&snes_header.maker_high, "AFATV", 5); // Namco & Tales of Phantasia (J)
-          if (snes_header_base == SNES_EROM && snes_header.maker == 0x33 &&
-              (is_top || !memcmp (&snes_header.maker_high, "18AE6", 5))) // Hudson Soft & Dai Kaiju Monogatari 2 (J)
+          int is_top = !memcmp (&cd->header.maker_high, "AFATV", 5); // Namco & Tales of Phantasia (J)
+          if (cd->header_base == SNES_EROM && cd->header.maker == 0x33 &&
+              (is_top || !memcmp (&cd->header.maker_high, "18AE6", 5))) // Hudson Soft & Dai Kaiju Monogatari 2 (J)
             {
               if (is_top)
                 {
@@ -1742,14 +1767,14 @@ snes_set_gd3_header (unsigned int total4Mbparts, unsigned char *header)
       else
         memcpy (&header[0x11], map_64mb, GD3_HEADER_MAPSIZE);
 
-      if (snes_header.rom_type == 3 || snes_header.rom_type == 5 || // DSP
-          snes_header.rom_type == 0xf6)         // Seta DSP
+      if (cd->header.rom_type == 3 || cd->header.rom_type == 5 || // DSP
+          cd->header.rom_type == 0xf6)          // Seta DSP
         {
           header[0x14] = 0x60;
           header[0x1c] = 0x60;
         }
 
-      if (snes_sram_size)
+      if (cd->sram_size)
         {
           header[0x24] = 0x40;
           header[0x28] = 0x40;
@@ -1765,8 +1790,9 @@ snes_convert_to_gd (st_ucon64_nfo_t *rominfo,
                                         unsigned int newsize,
                                         unsigned int total4Mbparts))
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned char *srcbuf, *dstbuf;
-  unsigned int size = get_rom_data_size (rominfo->backup_header_len), newsize,
+  unsigned int size = get_rom_data_size (&ucon64, rominfo->backup_header_len), newsize,
                n4Mbparts = size / (4 * MBIT), surplus4Mb = size % (4 * MBIT),
                total4Mbparts = n4Mbparts + (surplus4Mb > 0 ? 1 : 0);
 
@@ -1775,11 +1801,12 @@ snes_convert_to_gd (st_ucon64_nfo_t *rominfo,
       fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
       exit (1);
     }
-  read_rom_data (srcbuf, rominfo->backup_header_len, size, ucon64.fname);
+  read_rom_data (&ucon64, srcbuf, rominfo->backup_header_len, size,
+                 ucon64.fname);
   if (rominfo->interleaved)
     snes_deinterleave (rominfo, &srcbuf, size);
 
-  if (snes_hirom)
+  if (cd->hirom)
     {
       unsigned int pad;
 
@@ -1793,7 +1820,7 @@ snes_convert_to_gd (st_ucon64_nfo_t *rominfo,
           free (srcbuf);
           return -1;
         }
-      else if (total4Mbparts > 8 && snes_header_base != SNES_EROM)
+      else if (total4Mbparts > 8 && cd->header_base != SNES_EROM)
         {
           fputs ("ERROR: Normal ROM > 32 Mbit -- conversion not yet implemented\n", stderr);
           free (srcbuf);
@@ -1843,7 +1870,7 @@ snes_convert_to_gd (st_ucon64_nfo_t *rominfo,
           memset (dstbuf + size, 0, newsize - size);
         }
 
-      if (snes_header_base == SNES_EROM)
+      if (cd->header_base == SNES_EROM)
         {
           unsigned int size2 = newsize - 32 * MBIT; // size of second ROM (16 Mbit if ToP)
           // interleave the 32 Mbit ROM
@@ -1884,7 +1911,7 @@ snes_convert_to_gd (st_ucon64_nfo_t *rominfo,
     }
   else
     {
-      if (total4Mbparts > 8 && snes_header_base != SNES_EROM)
+      if (total4Mbparts > 8 && cd->header_base != SNES_EROM)
         {
           fputs ("ERROR: LoROM > 32 Mbit -- cannot convert\n", stderr);
           free (srcbuf);
@@ -1898,7 +1925,7 @@ snes_convert_to_gd (st_ucon64_nfo_t *rominfo,
   write_file (rominfo, dstbuf, newsize, total4Mbparts);
 
   free (srcbuf);
-  if (snes_hirom)
+  if (cd->hirom)
     free (dstbuf);
 
   return 0;
@@ -1909,6 +1936,7 @@ static void
 write_gd3_file (st_ucon64_nfo_t *rominfo, unsigned char *buffer,
                 unsigned int newsize, unsigned int total4Mbparts)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned char header[GD_HEADER_LEN];
   char dest_name[FILENAME_MAX];
 
@@ -1925,7 +1953,7 @@ write_gd3_file (st_ucon64_nfo_t *rominfo, unsigned char *buffer,
 
   printf (ucon64_msg[WROTE], dest_name);
 
-  if (snes_hirom)
+  if (cd->hirom)
     puts ("NOTE: This ROM has to be split with " OPTION_S "s in order to work with a Game Doctor,\n"
           "      unless it is transferred over a parallel port connection");
 }
@@ -1985,6 +2013,7 @@ static void
 write_mgh_files (st_ucon64_nfo_t *rominfo, unsigned char *buffer,
                  unsigned int newsize, unsigned int total4Mbparts)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   char dest_name[FILENAME_MAX];
 
   (void) total4Mbparts;
@@ -1997,7 +2026,7 @@ write_mgh_files (st_ucon64_nfo_t *rominfo, unsigned char *buffer,
   set_suffix (dest_name, ".MGH");
   write_mgh_name_file (rominfo, dest_name);
 
-  if (snes_hirom)
+  if (cd->hirom)
     puts ("NOTE: This ROM has to be split with " OPTION_LONG_S "smgh in order to work with an MGH");
 }
 
@@ -2013,28 +2042,29 @@ snes_mgh (st_ucon64_nfo_t *rominfo)
 int
 snes_ufo (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   st_ufo_header_t header;
-  unsigned int size = get_rom_data_size (rominfo->backup_header_len);
+  unsigned int size = get_rom_data_size (&ucon64, rominfo->backup_header_len);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
 
   ucon64_fread (&header, 0, rominfo->backup_header_len > UFO_HEADER_LEN ?
                   UFO_HEADER_LEN : rominfo->backup_header_len, ucon64.fname);
   reset_header (&header);
   memcpy (header.id, "SUPERUFO", 8);
-  header.uses_sram = snes_sram_size ? 1 : 0;
-  header.banktype = snes_hirom ? 0 : 1;
+  header.uses_sram = cd->sram_size ? 1 : 0;
+  header.banktype = cd->hirom ? 0 : 1;
 
-  if (snes_sram_size > 32 * 1024)
+  if (cd->sram_size > 32 * 1024)
     header.sram_size = 8;
-  else if (snes_sram_size > 8 * 1024)           // 64 kb < size <= 256 kb
+  else if (cd->sram_size > 8 * 1024)            // 64 kb < size <= 256 kb
     header.sram_size = 3;
-  else if (snes_sram_size > 2 * 1024)           // 16 kb < size <= 64 kb
+  else if (cd->sram_size > 2 * 1024)            // 16 kb < size <= 64 kb
     header.sram_size = 2;
-  else if (snes_sram_size > 0)                  // 1 - 16 kb
+  else if (cd->sram_size > 0)                   // 1 - 16 kb
     header.sram_size = 1;
   // header.sram_size is already OK for snes_sram_size == 0
 
-  header.sram_type = snes_hirom ? 0 : 3;
+  header.sram_type = cd->hirom ? 0 : 3;
 
   set_nsrt_info (rominfo, (unsigned char *) &header);
 
@@ -2043,7 +2073,7 @@ snes_ufo (st_ucon64_nfo_t *rominfo)
   set_suffix (dest_name, ".ufo");
   ucon64_file_handler (dest_name, src_name, 0);
 
-  if (snes_hirom)
+  if (cd->hirom)
     {
       unsigned char *srcbuf, *dstbuf;
       unsigned int newsize = size >= 10 * MBIT && size <= 12 * MBIT ?
@@ -2054,7 +2084,7 @@ snes_ufo (st_ucon64_nfo_t *rominfo)
       header.size_high = (unsigned char) (newsize / 8192 >> 8);
       header.size = (unsigned char) (newsize / MBIT);
 
-      if (snes_sram_size)
+      if (cd->sram_size)
         header.sram_a20_a21 = 0x0c;             // try 3 if game gives protection message
       header.sram_a22_a23 = 2;
       // Tales of Phantasia (J) & Dai Kaiju Monogatari 2 (J) [14-17]: 0 0x0e 0 0
@@ -2070,7 +2100,8 @@ snes_ufo (st_ucon64_nfo_t *rominfo)
           exit (1);
         }
 
-      read_rom_data (srcbuf, rominfo->backup_header_len, size, src_name);
+      read_rom_data (&ucon64, srcbuf, rominfo->backup_header_len, size,
+                     src_name);
       if (rominfo->interleaved)
         snes_deinterleave (rominfo, &srcbuf, size);
       if (newsize > size)
@@ -2098,11 +2129,11 @@ snes_ufo (st_ucon64_nfo_t *rominfo)
       header.size_high = (unsigned char) (size / 8192 >> 8);
       header.size = (unsigned char) (size / MBIT);
 
-      if (snes_sram_size == 0)
+      if (cd->sram_size == 0)
         {
           // check if the game uses a DSP chip
-          if (snes_header.rom_type == 3 || snes_header.rom_type == 5 ||
-              snes_header.rom_type == 0xf6)
+          if (cd->header.rom_type == 3 || cd->header.rom_type == 5 ||
+              cd->header.rom_type == 0xf6)
             {
               header.sram_a15 = 1;
               header.sram_a20_a21 = 0x0c;
@@ -2130,7 +2161,7 @@ snes_ufo (st_ucon64_nfo_t *rominfo)
   printf (ucon64_msg[WROTE], dest_name);
   remove_temp_file ();
 
-  if (snes_hirom)
+  if (cd->hirom)
     puts ("NOTE: This ROM has to be split with " OPTION_S "s in order to work with a UFO Super Drive");
 
   return 0;
@@ -2141,8 +2172,9 @@ snes_ufo (st_ucon64_nfo_t *rominfo)
 int
 snes_ufosd (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   st_ufosd_header_t header;
-  unsigned int size = get_rom_data_size (rominfo->backup_header_len),
+  unsigned int size = get_rom_data_size (&ucon64, rominfo->backup_header_len),
                ufosd_size = 0, n, rom_sizes[] =
                  { 4 * MBIT,  8 * MBIT, 10 * MBIT, 12 * MBIT,
                   16 * MBIT, 20 * MBIT, 24 * MBIT, 32 * MBIT };
@@ -2165,41 +2197,41 @@ snes_ufosd (st_ucon64_nfo_t *rominfo)
                   UFOSD_HEADER_LEN : rominfo->backup_header_len, ucon64.fname);
   reset_header (&header);
   header.size = (unsigned char) (ufosd_size / MBIT);
-  header.banktype_copy = snes_hirom ? 0 : 1;
+  header.banktype_copy = cd->hirom ? 0 : 1;
   memcpy (header.id, "SFCUFOSD", 8);
-  header.internal_size = get_internal_size ();
-
-  if (snes_header.rom_type == 3 || snes_header.rom_type == 5 || // DSP
-      snes_header.rom_type == 0x13 ||           // SRAM + Super FX (Mario Chip 1)
-      snes_header.rom_type == 0x1a ||           // Super FX
-      snes_header.rom_type == 0x14 || snes_header.rom_type == 0x15 || // Super FX (2)
-      snes_header.rom_type == 0x25 ||           // OBC1
-      snes_header.rom_type == 0x34 || snes_header.rom_type == 0x35 || // SA-1
-      snes_header.rom_type == 0x43 || snes_header.rom_type == 0x45 || // S-DD1
-      snes_header.rom_type == 0x55 ||           // S-RTC
-      snes_header.rom_type == 0xe3 ||           // Game Boy data
-      snes_header.rom_type == 0xf3 ||           // C4
-      snes_header.rom_type == 0xf5 ||           // Seta RISC / SPC7110
-      snes_header.rom_type == 0xf6 ||           // Seta DSP
-      snes_header.rom_type == 0xf9)             // SPC7110 + RTC
+  header.internal_size = get_internal_size (&ucon64);
+
+  if (cd->header.rom_type == 3 || cd->header.rom_type == 5 || // DSP
+      cd->header.rom_type == 0x13 ||            // SRAM + Super FX (Mario Chip 1)
+      cd->header.rom_type == 0x1a ||            // Super FX
+      cd->header.rom_type == 0x14 || cd->header.rom_type == 0x15 || // Super FX (2)
+      cd->header.rom_type == 0x25 ||            // OBC1
+      cd->header.rom_type == 0x34 || cd->header.rom_type == 0x35 || // SA-1
+      cd->header.rom_type == 0x43 || cd->header.rom_type == 0x45 || // S-DD1
+      cd->header.rom_type == 0x55 ||            // S-RTC
+      cd->header.rom_type == 0xe3 ||            // Game Boy data
+      cd->header.rom_type == 0xf3 ||            // C4
+      cd->header.rom_type == 0xf5 ||            // Seta RISC / SPC7110
+      cd->header.rom_type == 0xf6 ||            // Seta DSP
+      cd->header.rom_type == 0xf9)              // SPC7110 + RTC
     header.special_chip = 0xff;
 
   if (header.special_chip == 0 ||
-      snes_header.rom_type == 3 || snes_header.rom_type == 5 || // DSP
-      snes_header.rom_type == 0xf6)             // Seta DSP
+      cd->header.rom_type == 3 || cd->header.rom_type == 5 || // DSP
+      cd->header.rom_type == 0xf6)              // Seta DSP
     {
-      if (snes_sram_size > 32 * 1024)
+      if (cd->sram_size > 32 * 1024)
         header.sram_size = 7;
-      else if (snes_sram_size > 8 * 1024)       // 64 kb < size <= 256 kb
+      else if (cd->sram_size > 8 * 1024)        // 64 kb < size <= 256 kb
         header.sram_size = 3;
-      else if (snes_sram_size > 2 * 1024)       // 16 kb < size <= 64 kb
+      else if (cd->sram_size > 2 * 1024)        // 16 kb < size <= 64 kb
         header.sram_size = 2;
-      else if (snes_sram_size > 0)              // 1 - 16 kb
+      else if (cd->sram_size > 0)               // 1 - 16 kb
         header.sram_size = 1;
       // header.sram_size is already OK for snes_sram_size == 0
     }
 
-  if (snes_hirom)
+  if (cd->hirom)
     {
       switch (ufosd_size)
         {
@@ -2226,7 +2258,7 @@ snes_ufosd (st_ucon64_nfo_t *rominfo)
           memcpy (header.map_control, "\x55\x00\x80", 3);
           break;
         }
-      header.map_control[3] = snes_sram_size ? 0x2c : 0;
+      header.map_control[3] = cd->sram_size ? 0x2c : 0;
     }
   else
     {
@@ -2248,7 +2280,7 @@ snes_ufosd (st_ucon64_nfo_t *rominfo)
           header.map_control[0] = 0x55;
           break;
         }
-      if (snes_sram_size)
+      if (cd->sram_size)
         {
 #if 0
           switch (ufosd_size)
@@ -2259,13 +2291,13 @@ snes_ufosd (st_ucon64_nfo_t *rominfo)
             case 8 * MBIT:
               if (!header.special_chip)
                 {
-                  if (snes_sram_size == 2 * 1024)
+                  if (cd->sram_size == 2 * 1024)
                     memcpy (&header.map_control[2], "\x20\x3f", 2);
                   else
                     memcpy (header.map_control, "\x55\x00\x50\xbf", 4);
                 }
-              else if ((snes_sfx_sram_size ?
-                          snes_sfx_sram_size : snes_sram_size) == 32 * 1024)
+              else if ((cd->sfx_sram_size ?
+                          cd->sfx_sram_size : cd->sram_size) == 32 * 1024)
                 memcpy (header.map_control, "\x55\x00\x40\x00", 4);
               break;
             case 10 * MBIT:
@@ -2283,18 +2315,18 @@ snes_ufosd (st_ucon64_nfo_t *rominfo)
             }
 #else
           header.map_control[2] = ufosd_size > 16 * MBIT ?
-                                    0x60 : snes_sram_size <= 32 * 1024 ?
+                                    0x60 : cd->sram_size <= 32 * 1024 ?
                                       0x10 : 0x20;
           header.map_control[3] = 0x3f;
 #endif
         }
     }
 
-  header.banktype = snes_hirom ? 0 : 1;
-  header.tvtype = snes_header.country == 0 || snes_header.country == 1 ? 0 : 2;
+  header.banktype = cd->hirom ? 0 : 1;
+  header.tvtype = cd->header.country == 0 || cd->header.country == 1 ? 0 : 2;
   // copy last 32 bytes of internal header to backup unit header
   memcpy (header.internal_header_data,
-          ((char *) &snes_header) + sizeof snes_header - 32, 32);
+          ((char *) &cd->header) + sizeof cd->header - 32, 32);
 
   set_nsrt_info (rominfo, (unsigned char *) &header);
 
@@ -2340,12 +2372,13 @@ snes_ufosd (st_ucon64_nfo_t *rominfo)
 int
 snes_ic2 (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   st_swc_header_t header;
   unsigned char *buffer;
-  unsigned int size = get_rom_data_size (rominfo->backup_header_len), n;
+  unsigned int size = get_rom_data_size (&ucon64, rominfo->backup_header_len), n;
   char dest_name[2][FILENAME_MAX], suffix[] = ".1";
 
-  if (!snes_hirom)
+  if (!cd->hirom)
     {
       fputs ("ERROR: ROM is not HiROM -- cannot convert\n", stderr);
       return -1;
@@ -2381,7 +2414,8 @@ snes_ic2 (st_ucon64_nfo_t *rominfo)
       fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
       exit (1);
     }
-  read_rom_data (buffer, rominfo->backup_header_len, size, ucon64.fname);
+  read_rom_data (&ucon64, buffer, rominfo->backup_header_len, size,
+                 ucon64.fname);
 
   ucon64_fwrite (&header, 0, SWC_HEADER_LEN, dest_name[0], "wb");
 
@@ -2429,6 +2463,7 @@ int
 snes_gd_make_names (const char *filename, unsigned int backup_header_len,
                     char **names)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   char dest_name[FILENAME_MAX];
   // don't use PARTSIZE here, because the Game Doctor doesn't support
   //  arbitrary part sizes
@@ -2441,7 +2476,7 @@ snes_gd_make_names (const char *filename, unsigned int backup_header_len,
   dest_name[7] = 'A';
   dest_name[8] = '\0';
 
-  if (snes_hirom && size <= 16 * MBIT)
+  if (cd->hirom && size <= 16 * MBIT)
     {
       // 8 Mbit or less HiROMs, X is used to pad filename to 8 (SF4###XA)
       if (size < 10 * MBIT)
@@ -2472,6 +2507,7 @@ snes_gd_make_names (const char *filename, unsigned int backup_header_len,
 static void
 snes_split_gd3 (unsigned int backup_header_len, unsigned int size)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   char dest_name[FILENAME_MAX], *names[GD3_MAX_UNITS],
        names_mem[GD3_MAX_UNITS][9] = { { 0 } };
   // don't use ucon64.part_size here, because the Game Doctor doesn't support
@@ -2485,7 +2521,7 @@ snes_split_gd3 (unsigned int backup_header_len, unsigned int size)
   // we don't want to malloc() ridiculously small chunks (of 9 bytes)
   for (n = 0; n < sizeof names / sizeof names[0]; n++)
     names[n] = names_mem[n];
-  if (!(snes_hirom && size <= 16 * MBIT) &&
+  if (!(cd->hirom && size <= 16 * MBIT) &&
       nparts + (surplus ? 1 : 0) > sizeof names / sizeof names[0])
     {
       fprintf (stderr,
@@ -2497,7 +2533,7 @@ snes_split_gd3 (unsigned int backup_header_len, unsigned int size)
     }
   snes_gd_make_names (ucon64.fname, backup_header_len, (char **) names);
 
-  if (snes_hirom && size <= 16 * MBIT)
+  if (cd->hirom && size <= 16 * MBIT)
     {
       unsigned int half_size = size / 2;
 
@@ -2546,11 +2582,12 @@ static void
 snes_split_ufo (unsigned int backup_header_len, unsigned int size,
                 unsigned int part_size)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   st_ufo_header_t header;
   char dest_name[FILENAME_MAX], *p;
   unsigned int nparts = 0, surplus = 0, n, nbytesdone;
 
-  if (snes_hirom)
+  if (cd->hirom)
     {
       if (size > 32 * MBIT)
         {
@@ -2583,7 +2620,7 @@ snes_split_ufo (unsigned int backup_header_len, unsigned int size,
 
   ucon64_fread (&header, 0, UFO_HEADER_LEN, ucon64.fname);
 
-  if (snes_hirom)
+  if (cd->hirom)
     {
       typedef struct
       {
@@ -2750,12 +2787,13 @@ snes_split_smc (unsigned int backup_header_len, unsigned int size,
 int
 snes_s (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned int size = (unsigned int) ucon64.fsize - rominfo->backup_header_len,
                       part_size;
 
   if (UCON64_ISSET (ucon64.part_size) &&
-      !(copier_type == GD3 || (copier_type == UFO && snes_hirom) ||
-        copier_type == UFOSD || copier_type == IC2))
+      !(cd->copier_type == GD3 || (cd->copier_type == UFO && cd->hirom) ||
+        cd->copier_type == UFOSD || cd->copier_type == IC2))
     {
       part_size = ucon64.part_size;
       /*
@@ -2779,7 +2817,7 @@ snes_s (st_ucon64_nfo_t *rominfo)
   else
     part_size = PARTSIZE;
 
-  if (copier_type == GD3)
+  if (cd->copier_type == GD3)
     // part_size is ignored for Game Doctor
     {
       if (size < 4 * MBIT && size != 2 * MBIT)
@@ -2788,7 +2826,7 @@ snes_s (st_ucon64_nfo_t *rominfo)
           return -1;
         }
     }
-  else if (copier_type == UFO && snes_hirom)
+  else if (cd->copier_type == UFO && cd->hirom)
     {
       if (size < 2 * MBIT)
         {
@@ -2796,12 +2834,12 @@ snes_s (st_ucon64_nfo_t *rominfo)
           return -1;
         }
     }
-  else if (copier_type == UFOSD)
+  else if (cd->copier_type == UFOSD)
     {
       fputs ("ERROR: ROM is in Super UFO Pro 8 SD format -- will not be split\n", stderr);
       return -1;
     }
-  else if (copier_type == IC2)
+  else if (cd->copier_type == IC2)
     {
       fputs ("ERROR: ROM is in Super Magicom IC2 format -- already split\n", stderr);
       return -1;
@@ -2814,9 +2852,9 @@ snes_s (st_ucon64_nfo_t *rominfo)
       return -1;
     }
 
-  if (!rominfo->backup_header_len || copier_type == GD3) // GD3 format
+  if (!rominfo->backup_header_len || cd->copier_type == GD3) // GD3 format
     snes_split_gd3 (rominfo->backup_header_len, size);
-  else if (copier_type == UFO)
+  else if (cd->copier_type == UFO)
     snes_split_ufo (rominfo->backup_header_len, size, part_size);
   else
     snes_split_smc (rominfo->backup_header_len, size, part_size);
@@ -2828,12 +2866,13 @@ snes_s (st_ucon64_nfo_t *rominfo)
 int
 snes_smgh (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned int size = (unsigned int) ucon64.fsize - rominfo->backup_header_len,
                part_size, nparts, surplus, n;
   const char *p0;
   char dest_name[FILENAME_MAX], *p, *suffix;
 
-  if (copier_type == IC2)
+  if (cd->copier_type == IC2)
     {
       fputs ("ERROR: ROM is in Super Magicom IC2 format -- already split", stderr);
       return -1;
@@ -2853,7 +2892,7 @@ snes_smgh (st_ucon64_nfo_t *rominfo)
   else
     part_size = PARTSIZE;
 
-  if (size <= part_size && !(snes_hirom && size <= 16 * MBIT))
+  if (size <= part_size && !(cd->hirom && size <= 16 * MBIT))
     {
       fprintf (stderr,
                "ERROR: ROM size is smaller than or equal to %u Mbit -- will not be split\n",
@@ -2882,7 +2921,7 @@ snes_smgh (st_ucon64_nfo_t *rominfo)
   set_suffix (dest_name, suffix);
   free (suffix);
 
-  if (snes_hirom && size <= 16 * MBIT)
+  if (cd->hirom && size <= 16 * MBIT)
     {
       unsigned int half_size = size / 2;
 
@@ -2928,10 +2967,11 @@ snes_smgh (st_ucon64_nfo_t *rominfo)
 int
 snes_j (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], *p;
   unsigned int block_size, total_size = 0, header_len = rominfo->backup_header_len;
 
-  if (copier_type == IC2 && get_rom_data_size (rominfo->backup_header_len) < 16 * MBIT)
+  if (cd->copier_type == IC2 && get_rom_data_size (&ucon64, rominfo->backup_header_len) < 16 * MBIT)
     {
       fputs ("ERROR: ROM < 16 Mbit and in Super Magicom IC2 format -- resulting file would\n"
              "       be corrupt. Use a regular conversion option, like " OPTION_LONG_S "swc\n",
@@ -2950,7 +2990,7 @@ snes_j (st_ucon64_nfo_t *rominfo)
   if (p == NULL)                                // filename doesn't contain a period
     p = src_name + strlen (src_name) - 1;
   else
-    (copier_type == GD3 || copier_type == MGD_SNES) ? p-- : p++;
+    (cd->copier_type == GD3 || cd->copier_type == MGD_SNES) ? p-- : p++;
 
   // split GD3 files don't have a header _except_ the first one
   block_size = (unsigned int) fsizeof (src_name) - rominfo->backup_header_len;
@@ -2960,18 +3000,18 @@ snes_j (st_ucon64_nfo_t *rominfo)
       total_size += block_size;
       (*p)++;
 
-      if (copier_type == GD3)
+      if (cd->copier_type == GD3)
         header_len = 0;
       block_size = (unsigned int) fsizeof (src_name) - header_len;
     }
 
-  if (rominfo->backup_header_len && copier_type != GD3)
+  if (rominfo->backup_header_len && cd->copier_type != GD3)
     {                                           // fix header
       unsigned char buffer[3];
       buffer[0] = (unsigned char) (total_size / 8192); // # 8K blocks low byte
       buffer[1] = (unsigned char) (total_size / 8192 >> 8); // # 8K blocks high byte
       buffer[2] = ucon64_fgetc (dest_name, 2) & // last file => clear bit 6
-                    ~(copier_type == UFO ? 0x50 : 0x40);
+                    ~(cd->copier_type == UFO ? 0x50 : 0x40);
       ucon64_fwrite (buffer, 0, sizeof buffer, dest_name, "r+b");
     }
 
@@ -2980,6 +3020,82 @@ snes_j (st_ucon64_nfo_t *rominfo)
 }
 
 
+// '!' == ASCII 33 (\x21), '*' == 42 (\x2a)
+static st_cm_set_t snes_k_sets1[] = {{"\x8f\x9f", 2}, {"\xcf\xdf", 2}},
+                   snes_k_sets2[] = {{"\x8f\x9f", 2}, {"\x30\x31\x32\x33", 4},
+                                     {"\xcf\xdf", 2}, {"\x30\x31\x32\x33", 4}},
+                   snes_k_sets3[] = {{"\x8f\x9f", 2}, {"\x57\x59", 2}, {"\x60\x68", 2},
+                                     {"\x30\x31\x32\x33", 4}, {"\xcf\xdf", 2},
+                                     {"\x57\x59", 2}, {"\x30\x31\x32\x33", 4}},
+                   snes_k_sets4[] = {{"\x8f\xaf", 2}},
+                   snes_k_sets5[] = {{"\x8f\x9f", 2}, {"\x30\x31\x32\x33", 4},
+                                     {"\x30\x31\x32\x33", 4}},
+                   snes_k_sets6[] = {{"\xaf\xbf", 2}, {"\x30\x31\x32\x33", 4},
+                                     {"\xcf\xdf", 2}, {"\x30\x31\x32\x33", 4}},
+                   snes_k_sets7[] = {{"\xaf\xbf", 2}, {"\xcf\xdf", 2}},
+                   snes_k_sets8[] = {{"\xaf\xbf", 2}, {"\x80\xc0", 2}, {"\xcf\xdf", 2}};
+
+// SRAM, 8 kB == 64 kb
+static const st_cm_pattern_t snes_k_sram8k_patterns[] =
+  {
+    {"!**\x70!**\x70\xd0", '*', '!', "\xea\xea", 9, 2, 2, 0, snes_k_sets1},
+    // actually Kirby's Dream Course, Lufia II - Rise of the Sinistrals
+    {"!**\x70!**\x70\xf0", '*', '!', "\x80", 9, 1, 2, 0, snes_k_sets1},
+#if 1 // TODO: check which games really need this
+    {"!**!!**!\xf0", '*', '!', "\x80", 9, 1, 4, 0, snes_k_sets2}
+#endif
+  };
+
+// SRAM, other sizes
+static const st_cm_pattern_t snes_k_sram_patterns[] =
+  {
+    {"!**\x70!**\x70\xd0", '*', '!', "\x80", 9, 1, 2, 0, snes_k_sets1},
+    // Mega Man X
+    {"!**\x70!**\x70\xf0", '*', '!', "\xea\xea", 9, 2, 2, 0, snes_k_sets1},
+    {"!**!!**!\xf0", '*', '!', "\xea\xea", 9, 2, 4, 0, snes_k_sets2}
+  };
+
+static const st_cm_pattern_t snes_k_patterns[] =
+  {
+    {"\x8f**\x77\xe2*\xaf**\x77\xc9*\xf0", '*', '!', "\x80", 13, 1, 0, 0, NULL},
+    {"!!!!!!\x60!\xd0", '*', '!', "\xea\xea", 9, 2, 7, 0, snes_k_sets3},
+
+    {"!**!!**!\xd0", '*', '!', "\x80", 9, 1, 4, 0, snes_k_sets2},
+    {"!**\xb0\xcf**\xb1\xd0", '*', '!', "\xea\xea", 9, 2, 1, 0, snes_k_sets4},
+    {"!**!\xaf**!\xc9**\xd0", '*', '!', "\x80", 12, 1, 3, 0, snes_k_sets5},
+    {"\xa9\x00\x00\xa2\xfe\x1f\xdf\x00\x00\x70\xd0", '*', '!', "\xea\xea", 11, 2, 0, 0, NULL},
+    {"\x8f**\x70\xaf**\x70\xc9**\xd0", '*', '!', "\x80", 12, 1, 0, 0, NULL},
+    {"!**!!**!\xf0", '*', '!', "\x80", 9, 1, 4, 0, snes_k_sets6},
+
+    // mirroring
+    {"!*\x80\x00!*\x80\x40\xf0", '*', '!', "\x80", 9, 1, 2, 0, snes_k_sets7},
+    {"!*\xff!!*\xff\x40\xf0", '*', '!', "\x80", 9, 1, 3, 0, snes_k_sets8},
+
+    // game specific
+    {"\x5c\x7f\xd0\x83\x18\xfb\x78\xc2\x30", '*', '!',
+       "\xea\xea\xea\xea\xea\xea\xea\xea\xea", 9, 9, 0, -8, NULL},
+
+    {"KONG\x00\xf8\xf7", '*', '!', "\xf8", 7, 1, 0, 0, NULL},
+    {"\x26\x38\xe9\x48\x12\xc9\xaf\x71\xf0", '*', '!', "\x80", 9, 1, 0, 0, NULL},
+    {"\xa0\x5c\x2f\x77\x32\xe9\xc7\x04\xf0", '*', '!', "\x80", 9, 1, 0, 0, NULL},
+
+    {"\x22\x08\x5c\x10\xb0\x28", '*', '!', "\xea\xea\xea\xea\xea\xea", 6, 6, 0, -5, NULL},
+    {"\xda\xe2\x30\xc9\x01\xf0\x18\xc9\x02", '*', '!', "\x09\xf0\x18\xc9\x07", 9, 5, 0, -4, NULL},
+    {"\x29\xff\x00\xc9\x07\x00\x90\x16", '*', '!', "\x00", 8, 1, 0, -3, NULL},
+
+    {"\xca\x10\xf8\x38\xef\x1a\x80\x81\x8d", '*', '!', "\x9c", 9, 1, 0, 0, NULL},
+    {"\x81\xca\x10\xf8\xcf\x39\x80\x87\xf0", '*', '!', "\x80", 9, 1, 0, 0, NULL},
+
+    {"\x84\x26\xad\x39\xb5\xd0\x1a", '*', '!', "\xea\xea", 7, 2, 0, -1, NULL},
+    {"\x10\xf8\x38\xef\xef\xff\xc1", '*', '!', "\xea\xa9\x00\x00", 7, 4, 0, -3, NULL},
+    {"\x10\xf8\x38\xef\xf2\xfd\xc3\xf0", '*', '!', "\xea\xa9\x00\x00\x80", 8, 5, 0, -4, NULL},
+
+    {"\xc2\x30\xad\xfc\x1f\xc9\x50\x44\xd0", '*', '!', "\x4c\xd1\x80", 9, 3, 0, -6, NULL},
+    {"\xa9\xc3\x80\xdd\xff\xff\xf0\x6c", '*', '!', "\xf0\xcc\xff\xff\x80\x7d", 8, 6, 0, -5, NULL},
+    {"\xd0\xf4\xab\xcf\xae\xff\x00\xd0\x01", '*', '!', "\x00", 9, 1, 0, 0, NULL}
+  };
+
+
 int
 snes_k (st_ucon64_nfo_t *rominfo)
 /*
@@ -3128,18 +3244,20 @@ Modification protection. Not needed to play the game on an NTSC SNES. Needed
 when it has been patched with -f.
 */
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], buffer[32 * 1024];
   FILE *srcfile, *destfile;
   size_t bytesread;
-  int n = 0, n_extra_patterns, n2;
+  int n = 0, n_extra_patterns;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   strcpy (src_name, "snescopy.txt");
   // first try the current directory, then the configuration directory
   if (access (src_name, F_OK | R_OK) == -1)
     {
       snprintf (src_name, FILENAME_MAX, "%s" DIR_SEPARATOR_S "snescopy.txt",
-                ucon64.configdir);
+                ucon64_settings.configdir);
       src_name[FILENAME_MAX - 1] = '\0';
     }
   n_extra_patterns = build_cm_patterns (&patterns, src_name);
@@ -3173,98 +3291,27 @@ when it has been patched with -f.
       fwrite (header, 1, SWC_HEADER_LEN, destfile);
     }
 
-  while ((bytesread = fread (buffer, 1, 32 * 1024, srcfile)) != 0)
-    {                                           // '!' == ASCII 33 (\x21), '*' == 42 (\x2a)
-      // first use the extra patterns, so that their precedence is higher than
-      //  the built-in patterns
-      for (n2 = 0; n2 < n_extra_patterns; n2++)
-        n += change_mem2 (buffer, bytesread,
-                          patterns[n2].search,
-                          patterns[n2].search_size,
-                          patterns[n2].wildcard,
-                          patterns[n2].escape,
-                          patterns[n2].replace,
-                          patterns[n2].replace_size,
-                          patterns[n2].offset,
-                          patterns[n2].sets);
-
-      // SRAM
-      if (snes_sram_size == 8 * 1024)           // 8 kB == 64 kb
-        {
-          n += change_mem (buffer, bytesread, "!**\x70!**\x70\xd0", 9, '*', '!', "\xea\xea", 2, 0,
-                           "\x8f\x9f", 2, "\xcf\xdf", 2);
-          // actually Kirby's Dream Course, Lufia II - Rise of the Sinistrals
-          n += change_mem (buffer, bytesread, "!**\x70!**\x70\xf0", 9, '*', '!', "\x80", 1, 0,
-                           "\x8f\x9f", 2, "\xcf\xdf", 2);
-#if 1 // TODO: check which games really need this
-          n += change_mem (buffer, bytesread, "!**!!**!\xf0", 9, '*', '!', "\x80", 1, 0,
-                           "\x8f\x9f", 2, "\x30\x31\x32\x33", 4, "\xcf\xdf", 2, "\x30\x31\x32\x33", 4);
-#endif
-        }
-      else
-        {
-          n += change_mem (buffer, bytesread, "!**\x70!**\x70\xd0", 9, '*', '!', "\x80", 1, 0,
-                           "\x8f\x9f", 2, "\xcf\xdf", 2);
-          // Mega Man X
-          n += change_mem (buffer, bytesread, "!**\x70!**\x70\xf0", 9, '*', '!', "\xea\xea", 2, 0,
-                           "\x8f\x9f", 2, "\xcf\xdf", 2);
-          n += change_mem (buffer, bytesread, "!**!!**!\xf0", 9, '*', '!', "\xea\xea", 2, 0,
-                           "\x8f\x9f", 2, "\x30\x31\x32\x33", 4, "\xcf\xdf", 2, "\x30\x31\x32\x33", 4);
-        }
-
-      n += change_mem (buffer, bytesread, "\x8f**\x77\xe2*\xaf**\x77\xc9*\xf0", 13, '*', '!', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "!!!!!!\x60!\xd0", 9, '*', '!', "\xea\xea", 2, 0,
-                       "\x8f\x9f", 2, "\x57\x59", 2, "\x60\x68", 2, "\x30\x31\x32\x33", 4,
-                       "\xcf\xdf", 2, "\x57\x59", 2, "\x30\x31\x32\x33", 4);
-
-      n += change_mem (buffer, bytesread, "!**!!**!\xd0", 9, '*', '!', "\x80", 1, 0,
-                       "\x8f\x9f", 2, "\x30\x31\x32\x33", 4, "\xcf\xdf", 2, "\x30\x31\x32\x33", 4);
-      n += change_mem (buffer, bytesread, "!**\xb0\xcf**\xb1\xd0", 9, '*', '!', "\xea\xea", 2, 0,
-                       "\x8f\xaf", 2);
-      n += change_mem (buffer, bytesread, "!**!\xaf**!\xc9**\xd0", 12, '*', '!', "\x80", 1, 0,
-                       "\x8f\x9f", 2, "\x30\x31\x32\x33", 4, "\x30\x31\x32\x33", 4);
-      n += change_mem (buffer, bytesread, "\xa9\x00\x00\xa2\xfe\x1f\xdf\x00\x00\x70\xd0", 11, '*', '!', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\x8f**\x70\xaf**\x70\xc9**\xd0", 12, '*', '!', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "!**!!**!\xf0", 9, '*', '!', "\x80", 1, 0,
-                       "\xaf\xbf", 2, "\x30\x31\x32\x33", 4, "\xcf\xdf", 2, "\x30\x31\x32\x33", 4);
-
-      // mirroring
-      n += change_mem (buffer, bytesread, "!*\x80\x00!*\x80\x40\xf0", 9, '*', '!', "\x80", 1, 0,
-                       "\xaf\xbf", 2, "\xcf\xdf", 2);
-      n += change_mem (buffer, bytesread, "!*\xff!!*\xff\x40\xf0", 9, '*', '!', "\x80", 1, 0,
-                       "\xaf\xbf", 2, "\x80\xc0", 2, "\xcf\xdf", 2);
-
-      // game specific
-      n += change_mem (buffer, bytesread, "\x5c\x7f\xd0\x83\x18\xfb\x78\xc2\x30", 9, '*', '!',
-                                          "\xea\xea\xea\xea\xea\xea\xea\xea\xea", 9, -8);
-
-      n += change_mem (buffer, bytesread, "KONG\x00\xf8\xf7", 7, '*', '!', "\xf8", 1, 0);
-      n += change_mem (buffer, bytesread, "\x26\x38\xe9\x48\x12\xc9\xaf\x71\xf0", 9, '*', '!', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xa0\x5c\x2f\x77\x32\xe9\xc7\x04\xf0", 9, '*', '!', "\x80", 1, 0);
-
-      n += change_mem (buffer, bytesread, "\x22\x08\x5c\x10\xb0\x28", 6, '*', '!',
-                                          "\xea\xea\xea\xea\xea\xea", 6, -5);
-      n += change_mem (buffer, bytesread, "\xda\xe2\x30\xc9\x01\xf0\x18\xc9\x02", 9, '*', '!',
-                                          "\x09\xf0\x18\xc9\x07", 5, -4);
-      n += change_mem (buffer, bytesread, "\x29\xff\x00\xc9\x07\x00\x90\x16", 8, '*', '!', "\x00", 1, -3);
-
-      n += change_mem (buffer, bytesread, "\xca\x10\xf8\x38\xef\x1a\x80\x81\x8d", 9, '*', '!', "\x9c", 1, 0);
-      n += change_mem (buffer, bytesread, "\x81\xca\x10\xf8\xcf\x39\x80\x87\xf0", 9, '*', '!', "\x80", 1, 0);
-
-      n += change_mem (buffer, bytesread, "\x84\x26\xad\x39\xb5\xd0\x1a", 7, '*', '!', "\xea\xea", 2, -1);
-      n += change_mem (buffer, bytesread, "\x10\xf8\x38\xef\xef\xff\xc1", 7, '*', '!',
-                                                      "\xea\xa9\x00\x00", 4, -3);
-      n += change_mem (buffer, bytesread, "\x10\xf8\x38\xef\xf2\xfd\xc3\xf0", 8, '*', '!',
-                                                      "\xea\xa9\x00\x00\x80", 5, -4);
-
-      n += change_mem (buffer, bytesread, "\xc2\x30\xad\xfc\x1f\xc9\x50\x44\xd0", 9, '*', '!', "\x4c\xd1\x80", 3, -6);
-      n += change_mem (buffer, bytesread, "\xa9\xc3\x80\xdd\xff\xff\xf0\x6c", 8, '*', '!', "\xf0\xcc\xff\xff\x80\x7d", 6, -5);
-      n += change_mem (buffer, bytesread, "\xd0\xf4\xab\xcf\xae\xff\x00\xd0\x01", 9, '*', '!', "\x00", 1, 0);
+  // first use the extra patterns, so that their precedence is higher than
+  //  the built-in patterns
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_extra_patterns);
+  if (cd->sram_size == 8 * 1024)                // 8 kB == 64 kb
+    add_cm_patterns (&automaton, snes_k_sram8k_patterns,
+                     sizeof snes_k_sram8k_patterns / sizeof snes_k_sram8k_patterns[0]);
+  else
+    add_cm_patterns (&automaton, snes_k_sram_patterns,
+                     sizeof snes_k_sram_patterns / sizeof snes_k_sram_patterns[0]);
+  add_cm_patterns (&automaton, snes_k_patterns,
+                   sizeof snes_k_patterns / sizeof snes_k_patterns[0]);
 
+  while ((bytesread = fread (buffer, 1, 32 * 1024, srcfile)) != 0)
+    {
+      n += change_mem_patterns (buffer, bytesread, &automaton);
       fwrite (buffer, 1, bytesread, destfile);
     }
   fclose (srcfile);
   fclose (destfile);
+  cleanup_cm_automaton (&automaton);
   cleanup_cm_patterns (&patterns, n_extra_patterns);
 
   printf ("Found %d pattern%s\n", n, n != 1 ? "s" : "");
@@ -3274,6 +3321,21 @@ when it has been patched with -f.
 }
 
 
+static const st_cm_pattern_t snes_pal_patterns[] =
+  {
+    {"\xad\x3f\x21\x89\x10\xd0", '\x01', '\x02', "\x80", 6, 1, 0, 0, NULL},
+    {"\xad\x3f\x21\x89\x10\xf0", '\x01', '\x02', "\xea\xea", 6, 2, 0, 0, NULL},
+    {"\xad\x3f\x21\x29\x10\x00\xd0", '\x01', '\x02', "\x80", 7, 1, 0, 0, NULL},
+    {"\xad\x3f\x21\x89\x10\x00\xd0", '\x01', '\x02', "\xa9\x10\x00", 7, 3, 0, -6, NULL},
+    {"\xad\x3f\x21\x89\x10\xc2\x01\xf0", '\x01', '\x02', "\xea\xea", 8, 2, 0, 0, NULL},
+    {"\xad\x3f\x21\x29\x10\xcf\xbd\xff\x01\xf0", '\x01', '\x02', "\x80", 10, 1, 0, 0, NULL},
+    {"\xaf\x3f\x21\x00\x29\x10\xd0", '\x01', '\x02', "\x80", 7, 1, 0, 0, NULL},
+    {"\xaf\x3f\x21\x00\x29\x10\x00\xd0", '\x01', '\x02', "\xea\xea", 8, 2, 0, 0, NULL},
+    {"\xaf\x3f\x21\x00\x29\x01\xc9\x01\xf0", '\x01', '\x02', "\x80", 9, 1, 0, 0, NULL},
+    {"\xa2\x18\x01\xbd\x27\x20\x89\x10\x00\xf0\x01", '*', '!', "\xea\xea", 11, 2, 0, -1, NULL}
+  };
+
+
 static int
 snes_fix_pal_protection (st_ucon64_nfo_t *rominfo)
 /*
@@ -3297,15 +3359,16 @@ a2 18 01 bd 27 20 89 10 00 f0 01      a2 18 01 bd 27 20 89 10 00 ea ea - Donkey
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], buffer[32 * 1024];
   FILE *srcfile, *destfile;
   size_t bytesread;
-  int n = 0, n_extra_patterns, n2;
+  int n = 0, n_extra_patterns;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   strcpy (src_name, "snespal.txt");
   // first try the current directory, then the configuration directory
   if (access (src_name, F_OK | R_OK) == -1)
     {
       snprintf (src_name, FILENAME_MAX, "%s" DIR_SEPARATOR_S "snespal.txt",
-                ucon64.configdir);
+                ucon64_settings.configdir);
       src_name[FILENAME_MAX - 1] = '\0';
     }
   n_extra_patterns = build_cm_patterns (&patterns, src_name);
@@ -3339,36 +3402,21 @@ a2 18 01 bd 27 20 89 10 00 f0 01      a2 18 01 bd 27 20 89 10 00 ea ea - Donkey
       fwrite (header, 1, SWC_HEADER_LEN, destfile);
     }
 
+  // first use the extra patterns, so that their precedence is higher than
+  //  the built-in patterns
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_extra_patterns);
+  add_cm_patterns (&automaton, snes_pal_patterns,
+                   sizeof snes_pal_patterns / sizeof snes_pal_patterns[0]);
+
   while ((bytesread = fread (buffer, 1, 32 * 1024, srcfile)) != 0)
     {
-      // first use the extra patterns, so that their precedence is higher than
-      //  the built-in patterns
-      for (n2 = 0; n2 < n_extra_patterns; n2++)
-        n += change_mem2 (buffer, bytesread,
-                          patterns[n2].search,
-                          patterns[n2].search_size,
-                          patterns[n2].wildcard,
-                          patterns[n2].escape,
-                          patterns[n2].replace,
-                          patterns[n2].replace_size,
-                          patterns[n2].offset,
-                          patterns[n2].sets);
-
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x89\x10\xd0", 6, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x89\x10\xf0", 6, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x29\x10\x00\xd0", 7, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x89\x10\x00\xd0", 7, '\x01', '\x02', "\xa9\x10\x00", 3, -6);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x89\x10\xc2\x01\xf0", 8, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x29\x10\xcf\xbd\xff\x01\xf0", 10, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x29\x10\xd0", 7, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x29\x10\x00\xd0", 8, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x29\x01\xc9\x01\xf0", 9, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xa2\x18\x01\xbd\x27\x20\x89\x10\x00\xf0\x01", 11, '*', '!', "\xea\xea", 2, -1);
-
+      n += change_mem_patterns (buffer, bytesread, &automaton);
       fwrite (buffer, 1, bytesread, destfile);
     }
   fclose (srcfile);
   fclose (destfile);
+  cleanup_cm_automaton (&automaton);
   cleanup_cm_patterns (&patterns, n_extra_patterns);
 
   printf ("Found %d pattern%s\n", n, n != 1 ? "s" : "");
@@ -3378,6 +3426,41 @@ a2 18 01 bd 27 20 89 10 00 f0 01      a2 18 01 bd 27 20 89 10 00 ea ea - Donkey
 }
 
 
+static st_cm_set_t snes_ntsc_sets[] = {{"\x29\x89", 2}};
+
+static const st_cm_pattern_t snes_ntsc_patterns[] =
+  {
+    {"\x3f\x21\x02\x10\xf0", '\x01', '\x02', "\x80", 5, 1, 1, 0, snes_ntsc_sets},
+    {"\xad\x3f\x21\x29\x10\xd0", '\x01', '\x02', "\xea\xea", 6, 2, 0, 0, NULL},
+    {"\xad\x3f\x21\x89\x10\xd0", '\x01', '\x02', "\xea\xea", 6, 2, 0, 0, NULL},
+// The next entry could be the alternative for the previous one. Leave it
+//  disabled until we find a game that needs it.
+//    {"\xad\x3f\x21\x89\x10\xd0", '\x01', '\x02', "\x80", 6, 1, 0, 0, NULL},
+    {"\x3f\x21\x02\x10\x00\xf0", '\x01', '\x02', "\x80", 6, 1, 1, 0, snes_ntsc_sets},
+    {"\x3f\x21\x02\x10\x00\xd0", '\x01', '\x02', "\xea\xea", 6, 2, 1, 0, snes_ntsc_sets},
+    {"\x3f\x21\x89\x10\xc2\x01\xf0", '\x01', '\x02', "\x80", 7, 1, 0, 0, NULL},
+    {"\x3f\x21\x89\x10\xc2\x01\xd0", '\x01', '\x02', "\xea\xea", 7, 2, 0, 0, NULL},
+    {"\x3f\x21\x02\x10\xc9\x10\xf0", '\x01', '\x02', "\x80", 7, 1, 1, 0, snes_ntsc_sets},
+    {"\xad\x3f\x21\x29\x10\xc9\x00\xf0", '\x01', '\x02', "\xea\xea", 8, 2, 0, 0, NULL},
+    {"\xad\x3f\x21\x29\x10\xc9\x00\xd0", '\x01', '\x02', "\x80", 8, 1, 0, 0, NULL},
+    {"\xad\x3f\x21\x29\x10\xc9\x10\xd0", '\x01', '\x02', "\xea\xea", 8, 2, 0, 0, NULL},
+    {"\x3f\x21\x29\x10\xcf\x01\x01\x80\xf0", '\x01', '\x02', "\x80", 9, 1, 0, 0, NULL},
+    {"\xad\x3f\x21\x8d\x01\x01\x29\x10\x8d", '\x01', '\x02', "\x00", 9, 1, 0, -1, NULL},
+    {"\x3f\x21\x00\x02\x10\xf0", '\x01', '\x02', "\x80", 6, 1, 1, 0, snes_ntsc_sets},
+    {"\xaf\x3f\x21\x00\x02\x10\xd0", '\x01', '\x02', "\xea\xea", 7, 2, 1, 0, snes_ntsc_sets},
+    {"\xaf\x3f\x21\x00\x02\x10\x00\xf0", '\x01', '\x02', "\x80", 8, 1, 1, 0, snes_ntsc_sets},
+    {"\xaf\x3f\x21\x00\x29\x01\xc9\x01\xf0", '\x01', '\x02', "\x80", 9, 1, 0, 0, NULL},
+    {"\xaf\x3f\x21\x00\x29\x10\x80\x2d\x00\x1b", '\x01', '\x02', "\x00", 10, 1, 0, -4, NULL},
+    {"\x3f\x21\x00\x89\x10\xc2\x01\xf0", '\x01', '\x02', "\x80", 8, 1, 0, 0, NULL},
+    {"\xaf\x3f\x21\x00\x01\x01\x29\x10\x00\xd0", '\x01', '\x02', "\xea\xea", 10, 2, 0, 0, NULL},
+    {"\x3f\x21\xc2\x01\x29\x10\x00\xf0", '\x01', '\x02', "\x80", 8, 1, 0, 0, NULL},
+    {"\x3f\x21\xc2\x01\x29\x10\x00\xd0", '\x01', '\x02', "\xea\xea", 8, 2, 0, 0, NULL},
+    {"\xaf\x3f\x21\xea\x89\x10\x00\xd0", '\x01', '\x02', "\xa9\x00\x00", 8, 3, 0, -7, NULL},
+    {"\xa2\x18\x01\xbd\x27\x20\x89\x10\x00\xd0\x01", '*', '!', "\xea\xea", 11, 2, 0, -1, NULL},
+    {"\x29\x10\x00\xa2\x00\x00\xc9\x10\x00\xd0", '\x01', '\x02', "\x80", 10, 1, 0, 0, NULL}
+  };
+
+
 static int
 snes_fix_ntsc_protection (st_ucon64_nfo_t *rominfo)
 /*
@@ -3416,15 +3499,16 @@ a2 18 01 bd 27 20 89 10 00 d0 01      a2 18 01 bd 27 20 89 10 00 ea ea - Donkey
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], buffer[32 * 1024];
   FILE *srcfile, *destfile;
   size_t bytesread;
-  int n = 0, n_extra_patterns, n2;
+  int n = 0, n_extra_patterns;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   strcpy (src_name, "snesntsc.txt");
   // first try the current directory, then the configuration directory
   if (access (src_name, F_OK | R_OK) == -1)
     {
       snprintf (src_name, FILENAME_MAX, "%s" DIR_SEPARATOR_S "snesntsc.txt",
-                ucon64.configdir);
+                ucon64_settings.configdir);
       src_name[FILENAME_MAX - 1] = '\0';
     }
   n_extra_patterns = build_cm_patterns (&patterns, src_name);
@@ -3458,61 +3542,21 @@ a2 18 01 bd 27 20 89 10 00 d0 01      a2 18 01 bd 27 20 89 10 00 ea ea - Donkey
       fwrite (header, 1, SWC_HEADER_LEN, destfile);
     }
 
+  // first use the extra patterns, so that their precedence is higher than
+  //  the built-in patterns
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_extra_patterns);
+  add_cm_patterns (&automaton, snes_ntsc_patterns,
+                   sizeof snes_ntsc_patterns / sizeof snes_ntsc_patterns[0]);
+
   while ((bytesread = fread (buffer, 1, 32 * 1024, srcfile)) != 0)
     {
-      // first use the extra patterns, so that their precedence is higher than
-      //  the built-in patterns
-      for (n2 = 0; n2 < n_extra_patterns; n2++)
-        n += change_mem2 (buffer, bytesread,
-                          patterns[n2].search,
-                          patterns[n2].search_size,
-                          patterns[n2].wildcard,
-                          patterns[n2].escape,
-                          patterns[n2].replace,
-                          patterns[n2].replace_size,
-                          patterns[n2].offset,
-                          patterns[n2].sets);
-
-      n += change_mem (buffer, bytesread, "\x3f\x21\x02\x10\xf0", 5, '\x01', '\x02', "\x80", 1, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x29\x10\xd0", 6, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x89\x10\xd0", 6, '\x01', '\x02', "\xea\xea", 2, 0);
-// The next statement could be the alternative for the previous one. Leave it
-//  disabled until we find a game that needs it.
-//      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x89\x10\xd0", 6, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x02\x10\x00\xf0", 6, '\x01', '\x02', "\x80", 1, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x02\x10\x00\xd0", 6, '\x01', '\x02', "\xea\xea", 2, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x89\x10\xc2\x01\xf0", 7, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x89\x10\xc2\x01\xd0", 7, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x02\x10\xc9\x10\xf0", 7, '\x01', '\x02', "\x80", 1, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x29\x10\xc9\x00\xf0", 8, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x29\x10\xc9\x00\xd0", 8, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x29\x10\xc9\x10\xd0", 8, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x29\x10\xcf\x01\x01\x80\xf0", 9, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xad\x3f\x21\x8d\x01\x01\x29\x10\x8d", 9, '\x01', '\x02', "\x00", 1, -1);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x00\x02\x10\xf0", 6, '\x01', '\x02', "\x80", 1, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x02\x10\xd0", 7, '\x01', '\x02', "\xea\xea", 2, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x02\x10\x00\xf0", 8, '\x01', '\x02', "\x80", 1, 0,
-                       "\x29\x89", 2);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x29\x01\xc9\x01\xf0", 9, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x29\x10\x80\x2d\x00\x1b", 10, '\x01', '\x02', "\x00", 1, -4);
-      n += change_mem (buffer, bytesread, "\x3f\x21\x00\x89\x10\xc2\x01\xf0", 8, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\x00\x01\x01\x29\x10\x00\xd0", 10, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\x3f\x21\xc2\x01\x29\x10\x00\xf0", 8, '\x01', '\x02', "\x80", 1, 0);
-      n += change_mem (buffer, bytesread, "\x3f\x21\xc2\x01\x29\x10\x00\xd0", 8, '\x01', '\x02', "\xea\xea", 2, 0);
-      n += change_mem (buffer, bytesread, "\xaf\x3f\x21\xea\x89\x10\x00\xd0", 8, '\x01', '\x02', "\xa9\x00\x00", 3, -7);
-      n += change_mem (buffer, bytesread, "\xa2\x18\x01\xbd\x27\x20\x89\x10\x00\xd0\x01", 11, '*', '!', "\xea\xea", 2, -1);
-      n += change_mem (buffer, bytesread, "\x29\x10\x00\xa2\x00\x00\xc9\x10\x00\xd0", 10, '\x01', '\x02', "\x80", 1, 0);
-
+      n += change_mem_patterns (buffer, bytesread, &automaton);
       fwrite (buffer, 1, bytesread, destfile);
     }
   fclose (srcfile);
   fclose (destfile);
+  cleanup_cm_automaton (&automaton);
   cleanup_cm_patterns (&patterns, n_extra_patterns);
 
   printf ("Found %d pattern%s\n", n, n != 1 ? "s" : "");
@@ -3526,7 +3570,9 @@ int
 snes_f (st_ucon64_nfo_t *rominfo)
 // See the document "src/backup/NTSC-PAL notes.txt".
 {
-  switch (snes_header.country)
+  st_snes_data_t *cd = snes_data (&ucon64);
+
+  switch (cd->header.country)
     {
     // In the Philipines the television standard is NTSC, but do games made
     //  for the Philipines exist?
@@ -3539,6 +3585,24 @@ snes_f (st_ucon64_nfo_t *rominfo)
 }
 
 
+static st_cm_set_t snes_l_sets1[] = {{"\x8c\x8d\x8e\x8f", 4}},
+                   snes_l_sets2[] = {{"\xa9\xa2", 2}, {"\x8d\x8e", 2}};
+
+static const st_cm_pattern_t snes_l_patterns[] =
+  {
+    {"!\x0d\x42", '*', '!', "\x9c", 3, 1, 1, -2, snes_l_sets1},
+    {"\x01\x0d\x42", '*', '!', "\x00", 3, 1, 0, -2, NULL},
+    {"\xa9\x01\x85\x0d", '*', '!', "\x00", 4, 1, 0, -2, NULL},
+    {"\xa2\x01\x86\x0d", '*', '!', "\x00", 4, 1, 0, -2, NULL},
+    {"\xa0\x01\x84\x0d", '*', '!', "\x00", 4, 1, 0, -2, NULL},
+
+    // original uCON
+    {"!\x01!\x0d\x42", '*', '!', "\x00", 5, 1, 2, -3, snes_l_sets2},
+    {"\xa9\x01\x00\x8d\x0d\x42", '*', '!', "\x00", 6, 1, 0, -4, NULL},
+    {"\xa9\x01\x8f\x0d\x42\x00", '*', '!', "\x00", 6, 1, 0, -4, NULL}
+  };
+
+
 int
 snes_l (st_ucon64_nfo_t *rominfo)
 /*
@@ -3561,15 +3625,16 @@ a9 01 8f 0d 42 00               a9 00 8f 0d 42 00
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX], buffer[32 * 1024];
   FILE *srcfile, *destfile;
   size_t bytesread;
-  int n = 0, n_extra_patterns, n2;
+  int n = 0, n_extra_patterns;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   strcpy (src_name, "snesslow.txt");
   // first try the current directory, then the configuration directory
   if (access (src_name, F_OK | R_OK) == -1)
     {
       snprintf (src_name, FILENAME_MAX, "%s" DIR_SEPARATOR_S "snesslow.txt",
-                ucon64.configdir);
+                ucon64_settings.configdir);
       src_name[FILENAME_MAX - 1] = '\0';
     }
   n_extra_patterns = build_cm_patterns (&patterns, src_name);
@@ -3603,38 +3668,21 @@ a9 01 8f 0d 42 00               a9 00 8f 0d 42 00
       fwrite (header, 1, SWC_HEADER_LEN, destfile);
     }
 
-  while ((bytesread = fread (buffer, 1, 32 * 1024, srcfile)) != 0)
-    {                                           // '!' == ASCII 33 (\x21), '*' == 42 (\x2a)
-      // first use the extra patterns, so that their precedence is higher than
-      //  the built-in patterns
-      for (n2 = 0; n2 < n_extra_patterns; n2++)
-        n += change_mem2 (buffer, bytesread,
-                          patterns[n2].search,
-                          patterns[n2].search_size,
-                          patterns[n2].wildcard,
-                          patterns[n2].escape,
-                          patterns[n2].replace,
-                          patterns[n2].replace_size,
-                          patterns[n2].offset,
-                          patterns[n2].sets);
-
-      n += change_mem (buffer, bytesread, "!\x0d\x42", 3, '*', '!', "\x9c", 1, -2,
-                       "\x8c\x8d\x8e\x8f", 4);
-      n += change_mem (buffer, bytesread, "\x01\x0d\x42", 3, '*', '!', "\x00", 1, -2);
-      n += change_mem (buffer, bytesread, "\xa9\x01\x85\x0d", 4, '*', '!', "\x00", 1, -2);
-      n += change_mem (buffer, bytesread, "\xa2\x01\x86\x0d", 4, '*', '!', "\x00", 1, -2);
-      n += change_mem (buffer, bytesread, "\xa0\x01\x84\x0d", 4, '*', '!', "\x00", 1, -2);
-
-      // original uCON
-      n += change_mem (buffer, bytesread, "!\x01!\x0d\x42", 5, '*', '!', "\x00", 1, -3,
-                       "\xa9\xa2", 2, "\x8d\x8e", 2);
-      n += change_mem (buffer, bytesread, "\xa9\x01\x00\x8d\x0d\x42", 6, '*', '!', "\x00", 1, -4);
-      n += change_mem (buffer, bytesread, "\xa9\x01\x8f\x0d\x42\x00", 6, '*', '!', "\x00", 1, -4);
+  // first use the extra patterns, so that their precedence is higher than
+  //  the built-in patterns
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_extra_patterns);
+  add_cm_patterns (&automaton, snes_l_patterns,
+                   sizeof snes_l_patterns / sizeof snes_l_patterns[0]);
 
+  while ((bytesread = fread (buffer, 1, 32 * 1024, srcfile)) != 0)
+    {
+      n += change_mem_patterns (buffer, bytesread, &automaton);
       fwrite (buffer, 1, bytesread, destfile);
     }
   fclose (srcfile);
   fclose (destfile);
+  cleanup_cm_automaton (&automaton);
   cleanup_cm_patterns (&patterns, n_extra_patterns);
 
   printf ("Found %d pattern%s\n", n, n != 1 ? "s" : "");
@@ -3647,8 +3695,9 @@ a9 01 8f 0d 42 00               a9 00 8f 0d 42 00
 int
 snes_n (st_ucon64_nfo_t *rominfo, const char *name)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   char buf[SNES_NAME_LEN], dest_name[FILENAME_MAX];
-  size_t name_len = (bs_dump || st_dump) ? 16 : SNES_NAME_LEN,
+  size_t name_len = (cd->bs_dump || cd->st_dump) ? 16 : SNES_NAME_LEN,
          len = strnlen (name, name_len);
 
   if (len < name_len)                           // warning remover
@@ -3691,7 +3740,7 @@ snes_chk (st_ucon64_nfo_t *rominfo)
 
 
 static int
-snes_check_interleaved (unsigned char *rom_buffer, unsigned int size,
+snes_check_interleaved (st_ucon64_t *p, unsigned char *rom_buffer, unsigned int size,
                         unsigned int banktype_score)
 /*
   The only way to determine whether a HiROM dump is interleaved or not seems to
@@ -3706,6 +3755,7 @@ snes_check_interleaved (unsigned char *rom_buffer, unsigned int size,
   copier, but by incorrect ROM tools...
 */
 {
+  st_snes_data_t *cd = snes_data (p);
   int interleaved = 0, check_map_type = 1;
   unsigned int crc;
 
@@ -3817,21 +3867,21 @@ snes_check_interleaved (unsigned char *rom_buffer, unsigned int size,
           )
     {
       interleaved = 1;
-      snes_hirom = 0;
-      snes_hirom_ok = 1;
+      cd->hirom = 0;
+      cd->hirom_ok = 1;
       check_map_type = 0;                       // interleaved
     }
   // WARNING: st_dump won't be set if it's an interleaved dump
-  else if (st_dump)
+  else if (cd->st_dump)
     check_map_type = 0;
   else
     {
 #ifdef  DETECT_SMC_COM_FUCKED_UP_LOROM
-      if (check_banktype (rom_buffer, size / 2) > banktype_score)
+      if (check_banktype (p, rom_buffer + SNES_HEADER_START + size / 2, size / 2) > banktype_score)
         {
           interleaved = 1;
-          snes_hirom = 0;
-          snes_hirom_ok = 1;                    // keep snes_deinterleave()
+          cd->hirom = 0;
+          cd->hirom_ok = 1;                     // keep snes_deinterleave()
           check_map_type = 0;                   //  from changing snes_hirom
         }
 #endif
@@ -3847,35 +3897,35 @@ snes_check_interleaved (unsigned char *rom_buffer, unsigned int size,
         Super Mario All-Stars & World (E) [!]
       */
       if (!interleaved && size == 24 * MBIT &&
-          check_banktype (rom_buffer, 16 * MBIT) > banktype_score)
+          check_banktype (p, rom_buffer + SNES_HEADER_START + 16 * MBIT, 16 * MBIT) > banktype_score)
         {
           interleaved = 1;
-          snes_hirom = 0;
-          snes_hirom_ok = 2;                    // fix for snes_deinterleave()
+          cd->hirom = 0;
+          cd->hirom_ok = 2;                     // fix for snes_deinterleave()
           check_map_type = 0;
         }
 #endif
     }
-  if (check_map_type && !snes_hirom)
+  if (check_map_type && !cd->hirom)
     {
       // first check if it's an interleaved Extended HiROM dump
-      if (ucon64.fsize >= SNES_HEADER_START + SNES_EROM + SNES_HEADER_LEN)
+      if (p->fsize >= SNES_HEADER_START + SNES_EROM + SNES_HEADER_LEN)
         {
           // don't set snes_header_base to SNES_EROM for too small files (split files)
           if (crc == 0xd7470b37 || crc == 0xa2c5fd29 || crc == 0x83c45607) // GD3
-            snes_header_base = SNES_EROM;
+            cd->header_base = SNES_EROM;
           else if (crc == 0x9f1d6284 || crc == 0xfe536fc9) // UFO
             {
-              snes_header_base = SNES_EROM;
+              cd->header_base = SNES_EROM;
               // update map_type with the correct (Extended ROM) value
-              snes_header.map_type = rom_buffer[SNES_HEADER_START + SNES_EROM / 2 +
-                                                ((char *) &snes_header.map_type -
-                                                 (char *) &snes_header)];
+              cd->header.map_type = rom_buffer[SNES_HEADER_START + SNES_EROM / 2 +
+                                                ((char *) &cd->header.map_type -
+                                                 (char *) &cd->header)];
             }
         }
-      if (snes_header.map_type == 0x21 || snes_header.map_type == 0x31 ||
-          snes_header.map_type == 0x35 || snes_header.map_type == 0x3a ||
-          snes_header.bs_map_type == 0x21 || snes_header.bs_map_type == 0x31)
+      if (cd->header.map_type == 0x21 || cd->header.map_type == 0x31 ||
+          cd->header.map_type == 0x35 || cd->header.map_type == 0x3a ||
+          cd->header.bs_map_type == 0x21 || cd->header.bs_map_type == 0x31)
         interleaved = 1;
     }
 
@@ -3884,11 +3934,16 @@ snes_check_interleaved (unsigned char *rom_buffer, unsigned int size,
 
 
 static int
-snes_deinterleave (st_ucon64_nfo_t *rominfo, unsigned char **rom_buffer,
-                   unsigned int rom_size)
+snes_deinterleave_map (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                       uint16_t *blocks, unsigned int rom_size)
+/*
+  Fill blocks (512 entries) with the number of the 32 kB block in the
+  interleaved data for every 32 kB block of the deinterleaved data. Returns the
+  number of blocks or -1 if the ROM cannot be deinterleaved.
+*/
 {
-  uint16_t blocks[512] = { 0 }, i, nblocks = rom_size >> 16; // # 32 kB blocks / 2
-  unsigned char *rom_buffer2;
+  st_snes_data_t *cd = snes_data (p);
+  uint16_t i, nblocks = rom_size >> 16;         // # 32 kB blocks / 2
 
   if (nblocks * 2 > 512)
     return -1;                                  // file > 16 MB
@@ -3911,16 +3966,16 @@ snes_deinterleave (st_ucon64_nfo_t *rominfo, unsigned char **rom_buffer,
     {
       int blocksset = 0;
 
-      if (!snes_hirom_ok)
+      if (!cd->hirom_ok)
         {
-          snes_hirom = SNES_HIROM;
-          snes_hirom_ok = 1;
+          cd->hirom = SNES_HIROM;
+          cd->hirom_ok = 1;
         }
 
-      if (copier_type == GD3 || rominfo->backup_header_len == 0)
+      if (cd->copier_type == GD3 || rominfo->backup_header_len == 0)
         {
           // deinterleaving schemes specific for the Game Doctor
-          if ((snes_hirom || snes_hirom_ok == 2) && rom_size == 24 * MBIT)
+          if ((cd->hirom || cd->hirom_ok == 2) && rom_size == 24 * MBIT)
             {
               for (i = 0; i < nblocks; i++)
                 {
@@ -3929,7 +3984,7 @@ snes_deinterleave (st_ucon64_nfo_t *rominfo, unsigned char **rom_buffer,
                 }
               blocksset = 1;
             }
-          else if (snes_header_base == SNES_EROM)
+          else if (cd->header_base == SNES_EROM)
             {
               unsigned int size2 = rom_size - 32 * MBIT; // size of second ROM
               uint16_t j = 32 * MBIT >> 16;
@@ -3955,12 +4010,27 @@ snes_deinterleave (st_ucon64_nfo_t *rominfo, unsigned char **rom_buffer,
           }
     }
 
+  return nblocks * 2;
+}
+
+
+static int
+snes_deinterleave (st_ucon64_nfo_t *rominfo, unsigned char **rom_buffer,
+                   unsigned int rom_size)
+{
+  uint16_t blocks[512] = { 0 };
+  int i, nblocks;
+  unsigned char *rom_buffer2;
+
+  if ((nblocks = snes_deinterleave_map (&ucon64, rominfo, blocks,
+                                        rom_size)) == -1)
+    return -1;
   if ((rom_buffer2 = (unsigned char *) malloc (rom_size)) == NULL)
     {
       fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], rom_size);
       exit (1);
     }
-  for (i = 0; i < nblocks * 2; i++)
+  for (i = 0; i < nblocks; i++)
     memcpy (rom_buffer2 + i * 0x8000, *rom_buffer + blocks[i] * 0x8000, 0x8000);
 
   free (*rom_buffer);
@@ -3974,8 +4044,8 @@ matches_deviates (int equal)
 {
   return equal ?
 #ifdef  USE_ANSI_COLOR
-    ucon64.ansi_color ? "\x1b[01;32mMatches\x1b[0m" : "Matches" :
-    ucon64.ansi_color ? "\x1b[01;33mDeviates\x1b[0m" : "Deviates";
+    ucon64_settings.ansi_color ? "\x1b[01;32mMatches\x1b[0m" : "Matches" :
+    ucon64_settings.ansi_color ? "\x1b[01;33mDeviates\x1b[0m" : "Deviates";
 #else
     "Matches" : "Deviates";
 #endif
@@ -3986,9 +4056,10 @@ int
 snes_backup_header_info (st_ucon64_nfo_t *rominfo)
 // -dbuh
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned char header[512] = { 0 };
   unsigned int x = 0, y;
-  snes_copier_t org_copier_type = copier_type;
+  snes_copier_t org_copier_type = cd->copier_type;
 
   if (rominfo->backup_header_len == 0)          // copier_type == MGD_SNES
     {
@@ -3998,30 +4069,30 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
   else
     {
       printf ("Backup unit header info (%s)\n\n",
-              copier_type == SWC ? "SWC" :
-              copier_type == IC2 ? "IC2" :
-              copier_type == FIG ? "FIG" :
-              copier_type == GD3 ? "GD3" :
-              copier_type == UFO ? "UFO" :
-              copier_type == UFOSD ? "UFOSD" :
+              cd->copier_type == SWC ? "SWC" :
+              cd->copier_type == IC2 ? "IC2" :
+              cd->copier_type == FIG ? "FIG" :
+              cd->copier_type == GD3 ? "GD3" :
+              cd->copier_type == UFO ? "UFO" :
+              cd->copier_type == UFOSD ? "UFOSD" :
               "unknown header type, but interpreted as SWC");
-      if (copier_type == SMC)
-        copier_type = SWC;
+      if (cd->copier_type == SMC)
+        cd->copier_type = SWC;
     }
 
   ucon64_fread (header, 0, 512, ucon64.fname);
   dumper (stdout, header, 64, 0, DUMPER_HEX);   // show only the part that is
   fputc ('\n', stdout);                         //  interpreted by copier
 
-  if (copier_type == SWC || copier_type == IC2 || copier_type == FIG ||
-      copier_type == UFO)
+  if (cd->copier_type == SWC || cd->copier_type == IC2 ||
+      cd->copier_type == FIG || cd->copier_type == UFO)
     {
       x = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
       y = (header[0] + (header[1] << 8)) * 8 * 1024;
       printf ("[0-1]    File size: %u Bytes (%.4f Mb) => %s\n",
               y, TOMBIT_F (y), matches_deviates (x == y));
     }
-  else if (copier_type == UFOSD)
+  else if (cd->copier_type == UFOSD)
     {
       x = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
       y = header[0] * MBIT;
@@ -4029,7 +4100,7 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
               y, TOMBIT_F (y), matches_deviates (x == y));
     }
 
-  switch (copier_type)
+  switch (cd->copier_type)
     {
     case SWC:
     case SMC:
@@ -4056,7 +4127,7 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
         printf ("[2:6]    Split: %s => %s\n",
                 y ? "Yes" : "No", matches_deviates ((ucon64.split ? 1U : 0U) == y));
 
-        x = snes_hirom ? 1 : 0;
+        x = cd->hirom ? 1 : 0;
         y = swc_header->emulation & 0x20 ? 1 : 0;
         printf ("[2:5]    SRAM mapping mode: %s => %s\n",
                 y ? "HiROM" : "LoROM", matches_deviates (x == y));
@@ -4067,7 +4138,7 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
 
         y = sram_sizes[(~swc_header->emulation & 0x0c) >> 2]; // 32 => 12, 8 => 8, 2 => 4, 0 => 0
         printf ("[2:3-2]  SRAM size: %u kB => %s\n",
-                y, matches_deviates (snes_sram_size == y * 1024));
+                y, matches_deviates (cd->sram_size == y * 1024));
 
         printf ("[2:1]    Run program in mode: %u", z);
         if (z == 0)
@@ -4100,9 +4171,9 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
 
         y = fig_header->hirom & 0x80 ? 1 : 0;
         printf ("[3]      Memory mapping mode: %s => %s\n",
-                y ? "HiROM" : "LoROM", matches_deviates ((snes_hirom ? 1U : 0U) == y));
+                y ? "HiROM" : "LoROM", matches_deviates ((cd->hirom ? 1U : 0U) == y));
 
-        if (snes_hirom)
+        if (cd->hirom)
           {
             if ((fig_header->emulation1 == 0x77 || fig_header->emulation1 == 0xf7) &&
                 fig_header->emulation2 == 0x83)
@@ -4129,11 +4200,11 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
 
         if (y == 8)
           printf ("[4-5]    SRAM size: 2 kB / 8 kB => %s\n",
-                  matches_deviates (snes_sram_size == 2 * 1024 ||
-                                    snes_sram_size == 8 * 1024));
+                  matches_deviates (cd->sram_size == 2 * 1024 ||
+                                    cd->sram_size == 8 * 1024));
         else
           printf ("[4-5]    SRAM size: %u kB => %s\n",
-                  y, matches_deviates (snes_sram_size == y * 1024));
+                  y, matches_deviates (cd->sram_size == y * 1024));
       }
       break;
     case UFO:
@@ -4150,7 +4221,7 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
         y = ufo_header->uses_sram;
         printf ("[10]     SRAM: %s => %s\n",
                 y == 1 ? "Yes" : y == 0 ? "No" : "Unknown",
-                matches_deviates ((snes_sram_size ? 1U : 0U) == y));
+                matches_deviates ((cd->sram_size ? 1U : 0U) == y));
 
         printf ("[11]     ROM size: %u Mb => %s\n",
                 ufo_header->size, matches_deviates (x == ufo_header->size * MBIT));
@@ -4158,11 +4229,11 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
         y = ufo_header->banktype;
         printf ("[12]     DRAM mapping mode: %s => %s\n",
                 y == 1 ? "LoROM" : y == 0 ? "HiROM" : "Unknown",
-                matches_deviates ((snes_hirom ? 0U : 1U) == y));
+                matches_deviates ((cd->hirom ? 0U : 1U) == y));
 
         y = ufo_header->sram_size <= 3 ? sram_sizes[ufo_header->sram_size] : 128;
         printf ("[13]     SRAM size: %u kB => %s\n",
-                y, matches_deviates (snes_sram_size == y * 1024));
+                y, matches_deviates (cd->sram_size == y * 1024));
 
         y = ufo_header->sram_a15;
         if (y)
@@ -4190,7 +4261,7 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
         y = ufo_header->sram_type;
         printf ("[17]     SRAM mapping mode: %s => %s\n",
                 y == 3 ? "LoROM" : y == 0 ? "HiROM" : "Unknown",
-                matches_deviates ((snes_hirom ? 0U : 3U) == y));
+                matches_deviates ((cd->hirom ? 0U : 3U) == y));
       }
       break;
     case UFOSD:
@@ -4201,15 +4272,15 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
         y = ufosd_header->banktype_copy;
         printf ("[2]      DRAM mapping mode: %s => %s\n",
                 y == 1 ? "LoROM" : y == 0 ? "HiROM" : "Unknown",
-                matches_deviates ((snes_hirom ? 0U : 1U) == y));
+                matches_deviates ((cd->hirom ? 0U : 1U) == y));
 
         y = ufosd_header->internal_size;
         printf ("[11]     Internal size: %u Mb => %s\n",
-                y, matches_deviates (get_internal_size () == y));
+                y, matches_deviates (get_internal_size (&ucon64) == y));
 
         y = ufosd_header->sram_size <= 3 ? sram_sizes[ufosd_header->sram_size] : 128;
         printf ("[12]     SRAM size: %u kB => %s\n",
-                y, matches_deviates (snes_sram_size == y * 1024));
+                y, matches_deviates (cd->sram_size == y * 1024));
 
         y = ufosd_header->map_control[2];
         if (y == 0 || y == 0x10 || y == 0x20 || y == 0x30)
@@ -4232,17 +4303,17 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
         y = ufosd_header->banktype;
         printf ("[17]     DRAM mapping mode: %s => %s\n",
                 y == 1 ? "LoROM" : y == 0 ? "HiROM" : "Unknown",
-                matches_deviates ((snes_hirom ? 0U : 1U) == y));
+                matches_deviates ((cd->hirom ? 0U : 1U) == y));
 
         y = ufosd_header->tvtype;
         printf ("[18]     Television standard: %s => %s\n",
                 y == 0 ? "NTSC" : y == 2 ? "PAL" : "Unknown",
                 matches_deviates (
-                  (snes_header.country == 0 || snes_header.country == 1 ? 0U : 2U) == y));
+                  (cd->header.country == 0 || cd->header.country == 1 ? 0U : 2U) == y));
 
         printf ("[20-3f]  Copy of last 32 bytes of internal header => %s\n",
                 matches_deviates (
-                  memcmp (((char *) &snes_header) + sizeof snes_header - 32,
+                  memcmp (((char *) &cd->header) + sizeof cd->header - 32,
                           ufosd_header->internal_header_data, 32) == 0));
       }
       break;
@@ -4259,10 +4330,10 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
           y = 32 * 1024; // or 0
         if (y == 32 * 1024)
           printf ("[10]     SRAM size: 0 kB / 32 kB => %s\n",
-                  matches_deviates (snes_sram_size == 0 || snes_sram_size == 32 * 1024));
+                  matches_deviates (cd->sram_size == 0 || cd->sram_size == 32 * 1024));
         else
           printf ("[10]     SRAM size: %u kB => %s\n",
-                  y / 1024, matches_deviates (snes_sram_size == y));
+                  y / 1024, matches_deviates (cd->sram_size == y));
 
         y = 0;
         for (x = 0; x < 24; x++)
@@ -4285,8 +4356,8 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
             else if (mapping == 0x40)
               // extended ROM check to match the (tested) header of Tales of Phantasia...
               printf ("SRAM (LoROM) => %s\n",
-                      matches_deviates (snes_sram_size &&
-                                        (!snes_hirom || snes_header_base == SNES_EROM)));
+                      matches_deviates (cd->sram_size &&
+                                        (!cd->hirom || cd->header_base == SNES_EROM)));
             else if (mapping < 0x40 && mapping >= 0x20)
               {
                 unsigned int offset = (mapping - 0x20) * 4 * MBIT,
@@ -4319,14 +4390,14 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
                 bank_str[pos - 1] = '\0';
                 printf ("[%x]     SRAM (HiROM) mapped to %s:0x6000-0x7fff => %s\n",
                         0x29 + y, bank_str,
-                        matches_deviates (snes_sram_size && snes_hirom));
+                        matches_deviates (cd->sram_size && cd->hirom));
               }
             else
               // stating that the value matches with what snes_init() found
               //  actually applies to the combination of header[0x29] and header[0x2a]
               printf ("[%x]     no SRAM (HiROM) mapped to 0x%xx-0x%xx:0x6000-0x7fff => %s\n",
                       0x29 + y, y * 8, y * 8 + 7,
-                      matches_deviates (!snes_sram_size || !snes_hirom ||
+                      matches_deviates (!cd->sram_size || !cd->hirom ||
                                         (header[0x29] | header[0x2a])));
           }
       }
@@ -4336,14 +4407,14 @@ snes_backup_header_info (st_ucon64_nfo_t *rominfo)
       break;
     }
 
-  copier_type = org_copier_type;
+  cd->copier_type = org_copier_type;
 
   return 0;
 }
 
 
 static unsigned short int
-get_internal_sums (unsigned int backup_header_len)
+get_internal_sums (st_ucon64_t *p, unsigned int backup_header_len)
 /*
   Returns the sum of the internal checksum and the internal inverse checksum if
   the values for snes_hirom and backup_header_len are correct. If the values
@@ -4352,77 +4423,79 @@ get_internal_sums (unsigned int backup_header_len)
   doesn't do anything with the real, i.e. calculated, checksum.
 */
 {
-  unsigned int internal_header = SNES_HEADER_START + snes_header_base +
-                                   snes_hirom + backup_header_len;
+  st_snes_data_t *cd = snes_data (p);
+  unsigned int internal_header = SNES_HEADER_START + cd->header_base +
+                                   cd->hirom + backup_header_len;
   // don't use rominfo->header_start here!
   unsigned char buf[4];
 
-  ucon64_fread (buf, internal_header + 44, 4, ucon64.fname);
+  ucon64_fread (buf, internal_header + 44, 4, p->fname);
   return (buf[0] | (buf[1] << 8)) + (buf[2] | (buf[3] << 8));
 }
 
 
 static void
-snes_handle_backup_header (st_ucon64_nfo_t *rominfo, st_unknown_backup_header_t *header)
+snes_handle_backup_header (st_ucon64_t *p, st_ucon64_nfo_t *rominfo, st_unknown_backup_header_t *header)
 /*
   Determine the size of a possible backup unit header. This function also tries
   to determine the bank type in the process. However, snes_set_hirom() has the
   final word about that.
 */
 {
+  st_snes_data_t *cd = snes_data (p);
   unsigned short int x = 0;
   /*
     Check for "Extended" ROM dumps first, because at least one of them
     (Tales of Phantasia (J)) has two headers; an incorrect one at the normal
     location and a correct one at the Extended HiROM location.
   */
-  if (ucon64.fsize >= SNES_HEADER_START + SNES_EROM + SNES_HEADER_LEN)
+  if (p->fsize >= SNES_HEADER_START + SNES_EROM + SNES_HEADER_LEN)
     {
-      snes_header_base = SNES_EROM;
-      snes_hirom = SNES_HIROM;
+      cd->header_base = SNES_EROM;
+      cd->hirom = SNES_HIROM;
       rominfo->backup_header_len = 0;
-      if ((x = get_internal_sums (rominfo->backup_header_len)) != 0xffff)
+      if ((x = get_internal_sums (p, rominfo->backup_header_len)) != 0xffff)
         {
           rominfo->backup_header_len = SWC_HEADER_LEN;
-          if ((x = get_internal_sums (rominfo->backup_header_len)) != 0xffff)
+          if ((x = get_internal_sums (p, rominfo->backup_header_len)) != 0xffff)
             {
-              snes_hirom = 0;
-              if ((x = get_internal_sums (rominfo->backup_header_len)) != 0xffff)
+              cd->hirom = 0;
+              if ((x = get_internal_sums (p, rominfo->backup_header_len)) != 0xffff)
                 {
                   rominfo->backup_header_len = 0;
-                  x = get_internal_sums (rominfo->backup_header_len);
+                  x = get_internal_sums (p, rominfo->backup_header_len);
                 }
             }
         }
     }
   if (x != 0xffff)
     {
-      snes_header_base = 0;
-      snes_hirom = 0;
+      cd->header_base = 0;
+      cd->hirom = 0;
       rominfo->backup_header_len = 0;
-      if ((x = get_internal_sums (rominfo->backup_header_len)) != 0xffff)
+      if ((x = get_internal_sums (p, rominfo->backup_header_len)) != 0xffff)
         {
           rominfo->backup_header_len = SWC_HEADER_LEN;
-          if ((x = get_internal_sums (rominfo->backup_header_len)) != 0xffff)
+          if ((x = get_internal_sums (p, rominfo->backup_header_len)) != 0xffff)
             {
-              snes_hirom = SNES_HIROM;
-              if ((x = get_internal_sums (rominfo->backup_header_len)) != 0xffff)
+              cd->hirom = SNES_HIROM;
+              if ((x = get_internal_sums (p, rominfo->backup_header_len)) != 0xffff)
                 {
                   rominfo->backup_header_len = 0;
-                  x = get_internal_sums (rominfo->backup_header_len);
+                  x = get_internal_sums (p, rominfo->backup_header_len);
                 }
             }
         }
       }
 
   if (header->id1 == 0xaa && header->id2 == 0xbb && header->type == 4)
-    copier_type = SWC;
+    cd->copier_type = SWC;
   else if (!strncmp ((char *) header, "GAME DOCTOR SF 3", 16))
-    copier_type = GD3;
+    cd->copier_type = GD3;
   else if (!strncmp ((char *) header + 8, "SUPERUFO", 8))
-    copier_type = UFO;
+    cd->copier_type = UFO;
   else if (!strncmp ((char *) header + 8, "SFCUFOSD", 8))
-    copier_type = UFOSD;
+    cd->copier_type = UFOSD;
   else if ((header->hirom == 0x80 &&            // HiROM
              (((header->emulation1 == 0x77 || header->emulation1 == 0xf7) &&
                 header->emulation2 == 0x83) ||
@@ -4440,9 +4513,9 @@ snes_handle_backup_header (st_ucon64_nfo_t *rominfo, st_unknown_backup_header_t
                 (header->emulation2 == 0x80 || header->emulation2 == 0x00)) ||
               (header->emulation1 == 0x11 && header->emulation2 == 0x02)))
           )
-    copier_type = FIG;
+    cd->copier_type = FIG;
   else if (rominfo->backup_header_len == 0 && x == 0xffff)
-    copier_type = MGD_SNES;
+    cd->copier_type = MGD_SNES;
 
   /*
     x can be better trusted than copier_type == FIG, but x being 0xffff is
@@ -4451,21 +4524,21 @@ snes_handle_backup_header (st_ucon64_nfo_t *rominfo, st_unknown_backup_header_t
     Fortune (U)).
   */
 #if 0
-  if (copier_type != MGD_SNES) // don't do "&& copier_type != SMC" or we'll miss a lot of PD ROMs
+  if (cd->copier_type != MGD_SNES) // don't do "&& copier_type != SMC" or we'll miss a lot of PD ROMs
 #endif
     {
       unsigned int size = ((header->size_high << 8) + header->size_low) * 8 * 1024;
       size += SWC_HEADER_LEN;                   // if SWC-like header => hdr[1] high byte,
-      if (size == ucon64.fsize)                 //  hdr[0] low byte of # 8 kB blocks in ROM
+      if (size == p->fsize)                     //  hdr[0] low byte of # 8 kB blocks in ROM
         rominfo->backup_header_len = SWC_HEADER_LEN;
       else
         {
-          unsigned int surplus = ucon64.fsize % 32768;
+          unsigned int surplus = p->fsize % 32768;
           if (surplus == 0)
             // most likely we guessed the copier type wrong
             {
               rominfo->backup_header_len = 0;
-              copier_type = MGD_SNES;
+              cd->copier_type = MGD_SNES;
             }
           /*
             Check for surplus being smaller than 31232 instead of MAXBUFSIZE
@@ -4478,66 +4551,72 @@ snes_handle_backup_header (st_ucon64_nfo_t *rominfo, st_unknown_backup_header_t
           */
           else if (surplus % SWC_HEADER_LEN == 0 &&
                    surplus < 15 * SWC_HEADER_LEN &&
-                   ucon64.fsize > surplus)
+                   p->fsize > surplus)
             rominfo->backup_header_len = surplus;
           // Special case for Infinity Demo (PD)... (has odd size, but SWC
           //  header). Don't add "|| copier_type == FIG" as it is too unreliable.
-          else if (copier_type == SWC || copier_type == GD3 ||
-                   copier_type == UFO || copier_type == UFOSD)
+          else if (cd->copier_type == SWC || cd->copier_type == GD3 ||
+                   cd->copier_type == UFO || cd->copier_type == UFOSD)
             rominfo->backup_header_len = SWC_HEADER_LEN;
         }
     }
-  if (UCON64_ISSET2 (ucon64.backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
-    rominfo->backup_header_len = ucon64.backup_header_len;
-  if (copier_type == MGD_SNES && rominfo->backup_header_len)
-    copier_type = SMC;
+  if (UCON64_ISSET2 (p->backup_header_len, unsigned int)) // -hd, -nhd or -hdn switch was specified
+    rominfo->backup_header_len = p->backup_header_len;
+  if (cd->copier_type == MGD_SNES && rominfo->backup_header_len)
+    cd->copier_type = SMC;
 
   if (rominfo->backup_header_len && !memcmp ((unsigned char *) header + 0x1e8, "NSRT", 4))
-    nsrt_header = 1;
+    cd->nsrt_header = 1;
   else
-    nsrt_header = 0;
+    cd->nsrt_header = 0;
 }
 
 
 static unsigned int
-snes_set_hirom (unsigned char *rom_buffer, unsigned int size)
+snes_set_hirom (st_ucon64_t *p, const st_block_view_t *view, unsigned int size)
 /*
   This function tries to determine if the ROM dump is LoROM or HiROM. It returns
   the highest value that check_banktype() returns. A higher value means a higher
   chance the bank type is correct.
 */
 {
+  st_snes_data_t *cd = snes_data (p);
   unsigned int x, score_hi = 0, score_lo = 0;
+  unsigned char header[SNES_BANKTYPE_LEN];
 
+  block_view_read (view, header, SNES_HEADER_START, SNES_BANKTYPE_LEN);
   if (size >= 8 * MBIT + SNES_HEADER_START + SNES_HIROM + SNES_HEADER_LEN &&
-      !strncmp ((char *) rom_buffer + SNES_HEADER_START + 16, "ADD-ON BASE CASSETE", 19))
+      !strncmp ((char *) header + 16, "ADD-ON BASE CASSETE", 19))
     { // A Sufami Turbo dump contains 4 copies of the ST BIOS, which is 2 Mbit.
       //  After the BIOS comes the game data.
-      st_dump = 1;
-      snes_header_base = 8 * MBIT;
+      cd->st_dump = 1;
+      cd->header_base = 8 * MBIT;
       x = 8 * MBIT + SNES_HIROM;
     }
-  else if (snes_header_base == SNES_EROM)
+  else if (cd->header_base == SNES_EROM)
     x = SNES_EROM + SNES_HIROM;
   else
     {
-      snes_header_base = 0;
+      cd->header_base = 0;
       x = SNES_HIROM;
     }
 
   if (size > SNES_HEADER_START + SNES_HIROM + 0x4d)
     {
-      score_hi = check_banktype (rom_buffer, x);
-      score_lo = check_banktype (rom_buffer, snes_header_base);
+      block_view_read (view, header, SNES_HEADER_START + x, SNES_BANKTYPE_LEN);
+      score_hi = check_banktype (p, header, x);
+      block_view_read (view, header, SNES_HEADER_START + cd->header_base,
+                       SNES_BANKTYPE_LEN);
+      score_lo = check_banktype (p, header, cd->header_base);
     }
   if (score_hi > score_lo)                      // yes, a preference for LoROM
     {                                           //  (">" vs. ">=")
-      snes_hirom = SNES_HIROM;
+      cd->hirom = SNES_HIROM;
       x = score_hi;
     }
   else
     {
-      snes_hirom = 0;
+      cd->hirom = 0;
       x = score_lo;
     }
   /*
@@ -4550,21 +4629,21 @@ snes_set_hirom (unsigned char *rom_buffer, unsigned int size)
   */
 
   // step 3.
-  if (UCON64_ISSET (ucon64.snes_hirom))         // -hi or -nhi switch was specified
+  if (UCON64_ISSET (p->snes_hirom))             // -hi or -nhi switch was specified
     {
-      snes_hirom = ucon64.snes_hirom;
+      cd->hirom = p->snes_hirom;
       // keep snes_deinterleave() from changing snes_hirom
-      snes_hirom_ok = 1;
+      cd->hirom_ok = 1;
       if (size < SNES_HEADER_START + SNES_HIROM + SNES_HEADER_LEN)
-        snes_hirom = 0;
+        cd->hirom = 0;
     }
 
-  if (UCON64_ISSET (ucon64.snes_header_base))   // -erom switch was specified
+  if (UCON64_ISSET (p->snes_header_base))       // -erom switch was specified
     {
-      snes_header_base = ucon64.snes_header_base;
-      if (snes_header_base &&
-          size < snes_header_base + SNES_HEADER_START + snes_hirom + SNES_HEADER_LEN)
-        snes_header_base = 0;                   // don't let -erom crash on a too small ROM
+      cd->header_base = p->snes_header_base;
+      if (cd->header_base &&
+          size < cd->header_base + SNES_HEADER_START + cd->hirom + SNES_HEADER_LEN)
+        cd->header_base = 0;                    // don't let -erom crash on a too small ROM
     }
 
   return x;
@@ -4572,55 +4651,101 @@ snes_set_hirom (unsigned char *rom_buffer, unsigned int size)
 
 
 static void
-snes_set_bs_dump (st_ucon64_nfo_t *rominfo, unsigned char *rom_buffer,
-                  unsigned int size)
+snes_set_bs_dump (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                  const st_block_view_t *view, unsigned int size)
 {
-  bs_dump = snes_check_bs ();
+  st_snes_data_t *cd = snes_data (p);
+
+  cd->bs_dump = snes_check_bs (p);
   /*
-    Do the following check before checking for ucon64.bs_dump. Then it's
+    Do the following check before checking for p->bs_dump. Then it's
     possible to specify both -erom and -bs with effect, for what it's worth ;-)
     The main reason to test this case is to display correct info for "SD Gundam
     G-NEXT + Rom Pack Collection (J) [!]". Note that testing for SNES_EROM
     causes the code to be skipped for Sufami Turbo dumps.
   */
-  if (bs_dump &&
-      snes_header_base == SNES_EROM && !UCON64_ISSET (ucon64.snes_header_base))
+  if (cd->bs_dump &&
+      cd->header_base == SNES_EROM && !UCON64_ISSET (p->snes_header_base))
+    {
+      cd->bs_dump = 0;
+      cd->header_base = 0;
+      snes_set_hirom (p, view, size);
+      rominfo->header_start = cd->header_base + SNES_HEADER_START + cd->hirom;
+      block_view_read (view, &cd->header, rominfo->header_start,
+                       rominfo->header_len);
+    }
+  if (UCON64_ISSET (p->bs_dump))                // -bs or -nbs switch was specified
+    {
+      cd->bs_dump = p->bs_dump;
+      if (cd->bs_dump && cd->header_base == SNES_EROM)
+        cd->bs_dump = 2;                        // Extended ROM => must be add-on cart
+    }
+}
+
+
+static unsigned char *
+snes_own_rom_buffer (unsigned char *rom_buffer, unsigned int size, int *mapped)
+// returns a modifiable copy of rom_buffer if it points to the read-only image
+//  of the ROM file, otherwise rom_buffer itself
+{
+  unsigned char *buffer;
+
+  if (!*mapped)
+    return rom_buffer;
+  if ((buffer = (unsigned char *) malloc (size)) == NULL)
     {
-      bs_dump = 0;
-      snes_header_base = 0;
-      snes_set_hirom (rom_buffer, size);
-      rominfo->header_start = snes_header_base + SNES_HEADER_START + snes_hirom;
-      memcpy (&snes_header, rom_buffer + rominfo->header_start, rominfo->header_len);
+      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
+      return NULL;
     }
-  if (UCON64_ISSET (ucon64.bs_dump))            // -bs or -nbs switch was specified
+  memcpy (buffer, rom_buffer, size);
+  *mapped = 0;
+  return buffer;
+}
+
+
+static unsigned char *
+snes_view_buffer (const st_block_view_t *view, unsigned char *rom_buffer,
+                  unsigned int size, int *mapped)
+// returns a modifiable buffer with the first size bytes of view, which is
+//  rom_buffer itself if it already is such a buffer
+{
+  unsigned char *buffer;
+
+  if (!*mapped && view->nblocks == 0)
+    return rom_buffer;
+  if ((buffer = (unsigned char *) malloc (size)) == NULL)
     {
-      bs_dump = ucon64.bs_dump;
-      if (bs_dump && snes_header_base == SNES_EROM)
-        bs_dump = 2;                            // Extended ROM => must be add-on cart
+      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
+      return NULL;
     }
+  block_view_read (view, buffer, 0, size);
+  if (!*mapped)
+    free (rom_buffer);
+  *mapped = 0;
+  return buffer;
 }
 
 
 static int
-check_ufosd_sram (unsigned int *sram_size)
+check_ufosd_sram (st_ucon64_t *p, unsigned int *sram_size)
 {
   int result = 0;
   FILE *file;
   char buffer[32 * 1024], pattern[128];
 
-  if (ucon64.fsize != MBIT)
+  if (p->fsize != MBIT)
     return result;
 
-  if ((file = fopen (ucon64.fname, "rb")) == NULL)
+  if ((file = fopen (p->fname, "rb")) == NULL)
     {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ucon64.fname);
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], p->fname);
       return -1;
     }
 
   *sram_size = 0;
   set_ufosd_sram_pattern (pattern, sizeof pattern);
 
-  fseek (file, (long) ucon64.fsize - 64 * 1024, SEEK_SET);
+  fseek (file, (long) p->fsize - 64 * 1024, SEEK_SET);
   fread_checked (buffer, 1, sizeof pattern, file);
   if (memcmp (buffer, pattern, sizeof pattern) == 0) // pattern at 64 kB?
     {
@@ -4671,14 +4796,14 @@ check_ufosd_sram (unsigned int *sram_size)
 
 
 static int
-check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
+check_smini_save (st_ucon64_t *p, unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
 {
   st_ustar_header_t header;
   unsigned char *buffer, sram_checksum[20] = { 0 };
   int result, sram_data_size = 0;
 
-  if (ucon64.fsize < sizeof header ||
-      ucon64_fread (&header, 0, sizeof header, ucon64.fname) < sizeof header)
+  if (p->fsize < sizeof header ||
+      ucon64_fread (&header, 0, sizeof header, p->fname) < sizeof header)
     {
       *sram_size = 0;
       return 0; // not necessarily an error, just not a .clvs file
@@ -4691,28 +4816,28 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
       exit (1);
     }
 
-  sram_data_size = get_smini_sram_data (ucon64.fname, buffer, 128 * 1024 + 20,
+  sram_data_size = get_smini_sram_data (p, p->fname, buffer, 128 * 1024 + 20,
                                         sram_checksum);
   if (sram_data_size >= 20) // some .clvs files contain a 20 byte cartridge.sram
     {
       s_sha1_ctx_t sha1_ctx;
       unsigned char calculated_hash[20];
       char calculated_hash_str[41], internal_hash_str[41],
-           internal_hash2_str[41], *p;
+           internal_hash2_str[41], *ptr;
       unsigned int i = 0;
 
       // get the game ID and put it in rominfo->name
       strcpy (rominfo->name, header.name);
-      p = strchr (rominfo->name, '/');
-      if (p)
-        *p = '\0';
+      ptr = strchr (rominfo->name, '/');
+      if (ptr)
+        *ptr = '\0';
 
       *sram_size = sram_data_size - 20;
 
       {
         unsigned int base, size;
 
-        if (set_smini_chksum_range (&base, &size, *sram_size, 0) == 0)
+        if (set_smini_chksum_range (p, &base, &size, *sram_size, 0) == 0)
           {
             sha1_begin (&sha1_ctx);
             sha1 (&sha1_ctx, buffer + base, size);
@@ -4721,8 +4846,8 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
         else
           memset (calculated_hash, 0, sizeof calculated_hash);
       }
-      if (!(UCON64_ISSET (ucon64.range_start) &&
-            UCON64_ISSET2 (ucon64.range_length, size_t)) &&
+      if (!(UCON64_ISSET (p->range_start) &&
+            UCON64_ISSET2 (p->range_length, size_t)) &&
           *sram_size > 0 && memcmp (calculated_hash, buffer + *sram_size, 20))
         {
           unsigned int max_block_size = INITIAL_MAX_BLOCK_SIZE; // Super Mario RPG is an exception
@@ -4732,7 +4857,7 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
               unsigned int j, j_max = i + max_block_size < *sram_size ?
                              i + max_block_size : *sram_size, match_found = 0;
 
-              if (ucon64.quiet < 1)
+              if (p->settings->quiet < 1)
                 {
                   printf ("\rScanning SNES Classic Mini SRAM data, base 0x%04x", i);
                   fflush (stdout);
@@ -4753,7 +4878,7 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
                       // Super Mario World 2 - Yoshi's Island: --range=7c00:7e7b
                       // Hoshi no Kirby Super Deluxe (J)(/Kirby Super Star (U)/Kirby's Fun Pak (E)): --range=1f00:1ffe
                       // Star Fox 2: --range=3912:3a45
-                      if (ucon64.quiet < 1)
+                      if (p->settings->quiet < 1)
                         printf (", block size 0x%04x bytes\n"
                                 "Found block with matching checksum. Use "
                                 OPTION_LONG_S "range" OPTARG_S "%04x:%04x with "
@@ -4776,21 +4901,21 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
               else
                 i += 0x100 - i % 0x100;
             }
-          if (ucon64.quiet < 1)
+          if (p->settings->quiet < 1)
             puts ("\n");
         }
 
-      p = calculated_hash_str;
-      for (i = 0; i < 20; i++, p = strchr (p, 0))
-        sprintf (p, "%02x", calculated_hash[i]);
+      ptr = calculated_hash_str;
+      for (i = 0; i < 20; i++, ptr = strchr (ptr, 0))
+        sprintf (ptr, "%02x", calculated_hash[i]);
 
-      p = internal_hash_str;
-      for (i = 0; i < 20; i++, p = strchr (p, 0))
-        sprintf (p, "%02x", (buffer + *sram_size)[i]);
+      ptr = internal_hash_str;
+      for (i = 0; i < 20; i++, ptr = strchr (ptr, 0))
+        sprintf (ptr, "%02x", (buffer + *sram_size)[i]);
 
-      p = internal_hash2_str;
-      for (i = 0; i < 20; i++, p = strchr (p, 0))
-        sprintf (p, "%02x", sram_checksum[i]);
+      ptr = internal_hash2_str;
+      for (i = 0; i < 20; i++, ptr = strchr (ptr, 0))
+        sprintf (ptr, "%02x", sram_checksum[i]);
 
       i = !memcmp (calculated_hash, buffer + *sram_size, 20);
       sprintf (rominfo->internal_crc2,
@@ -4799,8 +4924,8 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
                "Checksum file:     %s0x%s",
                i ?
 #ifdef  USE_ANSI_COLOR
-                 ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                 ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
+                 p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                 p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
 #else
                  "OK" : "Bad",
 #endif
@@ -4818,13 +4943,13 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
           (unsigned int) strtol (header.header_checksum, NULL, 8) ==
             ustar_chksum (&header))
         {
-          char *p;
+          char *ptr;
 
           // get the game ID and put it in rominfo->name
           strcpy (rominfo->name, header.name);
-          p = strchr (rominfo->name, '/');
-          if (p)
-            *p = '\0';
+          ptr = strchr (rominfo->name, '/');
+          if (ptr)
+            *ptr = '\0';
 
           result = SMINI;
         }
@@ -4840,7 +4965,8 @@ check_smini_save (unsigned int *sram_size, st_ucon64_nfo_t *rominfo)
 static void
 check_split (const char *filename, void *cb_data)
 {
-  st_split_info_t *info = (st_split_info_t *) cb_data;
+  st_snes_data_t *cd = (st_snes_data_t *) cb_data;
+  st_split_info_t *info = &cd->split_info;
   unsigned char multi_magic[9] = { '\0' };
 
   if (ucon64_fread (&multi_magic, 2, 9, filename) == 9)
@@ -4848,18 +4974,12 @@ check_split (const char *filename, void *cb_data)
       if (info->nparts < 2 &&
           multi_magic[6] == 0xaa && multi_magic[7] == 0xbb && multi_magic[8] == 4)
         {
-          char **fname = &info->parts[info->nparts].fname;
-          if (*fname == NULL &&
-              (*fname = (char *) malloc (FILENAME_MAX)) == NULL)
-            {
-              fprintf (stderr, ucon64_msg[BUFFER_ERROR], FILENAME_MAX);
-              return;
-            }
-          snprintf (*fname, FILENAME_MAX, "%s", filename);
-          (*fname)[FILENAME_MAX - 1] = '\0';
+          char *fname = info->parts[info->nparts].fname;
+          snprintf (fname, FILENAME_MAX, "%s", filename);
+          fname[FILENAME_MAX - 1] = '\0';
         }
       // byte at offset 2 is for SWC header "emulation", for FIG/UFO header "multi"
-      if (multi_magic[0] & 0x40 || (copier_type == UFO && multi_magic[0] & 0x10))
+      if (multi_magic[0] & 0x40 || (cd->copier_type == UFO && multi_magic[0] & 0x10))
         info->nparts++;
     }
 }
@@ -4868,7 +4988,7 @@ check_split (const char *filename, void *cb_data)
 static int
 check_smc_ic2_rom (int nparts, st_split_info_t *info, unsigned int backup_header_len)
 {
-  if (nparts == 2 && info->parts[0].fname && info->parts[1].fname)
+  if (nparts == 2 && info->parts[0].fname[0] && info->parts[1].fname[0])
     {
       info->parts[0].size = (unsigned int) fsizeof (info->parts[0].fname);
       info->parts[1].size = (unsigned int) fsizeof (info->parts[1].fname);
@@ -4913,11 +5033,17 @@ check_smc_ic2_rom (int nparts, st_split_info_t *info, unsigned int backup_header
 
 
 int
-snes_init (st_ucon64_nfo_t *rominfo)
+snes_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (p);
   int result = -1;                              // it's no SNES ROM dump until detected otherwise
   unsigned int x = 0, y = 0, size, calc_checksums, pos = (unsigned int) strlen (rominfo->misc);
   unsigned char *rom_buffer;
+  const unsigned char *rom_image;
+  uint64_t image_size;
+  int rom_buffer_mapped = 0, nblocks;
+  uint16_t blocks[512] = { 0 };
+  st_block_view_t view;
   st_unknown_backup_header_t header = { 0, 0, 0, 0, 0, 0, { 0 }, 0, 0, 0, { 0 } };
 #define SNES_COUNTRY_MAX 0xe
   static const char *snes_country[SNES_COUNTRY_MAX] =
@@ -4938,32 +5064,31 @@ snes_init (st_ucon64_nfo_t *rominfo)
       "South Korea"
     };
 
-  snes_hirom_ok = 0;                            // init these vars here, for -lsv
-  snes_sram_size = 0;                           // idem
-  copier_type = SMC;                            // idem, SMC indicates unknown copier type
-  bs_dump = 0;                                  // for -lsv, but also just to init it
-  st_dump = 0;                                  // idem
+  cd->hirom_ok = 0;                             // init these vars here, for -lsv
+  cd->sram_size = 0;                            // idem
+  cd->copier_type = SMC;                        // idem, SMC indicates unknown copier type
+  cd->bs_dump = 0;                              // for -lsv, but also just to init it
+  cd->st_dump = 0;                              // idem
 
-  split_info.nparts = 0;
+  cd->split_info.nparts = 0;
   for (x = 0; x < 2; x++)
     {
-      if (split_info.parts[x].fname)
-        split_info.parts[x].fname[0] = '\0';
-      split_info.parts[x].size = 0;
+      cd->split_info.parts[x].fname[0] = '\0';
+      cd->split_info.parts[x].size = 0;
     }
 
-  ucon64_fread (&header, 0, UNKNOWN_BACKUP_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&header, 0, UNKNOWN_BACKUP_HEADER_LEN, p->fname);
   if (header.id1 == 0xaa && header.id2 == 0xbb)
     x = SWC;
   else if (!strncmp ((char *) &header + 8, "SUPERUFO", 8))
     x = UFO;
-  else if ((x = check_ufosd_sram (&y)) != 0)
+  else if ((x = check_ufosd_sram (p, &y)) != 0)
     {
       if ((int) x < 0)
         return -1;
     }
   else
-    x = check_smini_save (&y, rominfo);
+    x = check_smini_save (p, &y, rominfo);
 
   if ((x == SWC && (header.type == 5 || header.type == 8)) ||
       (x == UFO && OFFSET (header, 0x11) == 0) ||
@@ -4976,13 +5101,13 @@ snes_init (st_ucon64_nfo_t *rominfo)
       rominfo->maker = "Publisher: N/A";
       rominfo->country = "Country: N/A";
       rominfo->has_internal_crc = 0;
-      ucon64.split = 0;                         // SRAM & RTS files are never split
+      p->split = 0;                             // SRAM & RTS files are never split
       switch (x)
         {
         case SWC:
           rominfo->backup_header_len = SWC_HEADER_LEN;
           rominfo->backup_usage = swc_usage[0].help;
-          copier_type = SWC;
+          cd->copier_type = SWC;
           if (header.type == 5)
             sprintf (rominfo->misc + pos, "Type: Super Wild Card SRAM file");
           else if (header.type == 8)
@@ -4991,13 +5116,13 @@ snes_init (st_ucon64_nfo_t *rominfo)
         case UFO:
           rominfo->backup_header_len = UFO_HEADER_LEN;
           rominfo->backup_usage = ufo_usage[0].help;
-          copier_type = UFO;
+          cd->copier_type = UFO;
           sprintf (rominfo->misc + pos, "Type: Super UFO SRAM file");
           break;
         case UFOSD:
           rominfo->backup_header_len = 0;
           rominfo->backup_usage = ufosd_usage[0].help;
-          copier_type = UFOSD;
+          cd->copier_type = UFOSD;
           sprintf (rominfo->misc + pos, "Type: Super UFO Pro 8 SD SRAM file\n"
                                         "SRAM size: %u kBytes", y / 1024);
           break;
@@ -5006,7 +5131,7 @@ snes_init (st_ucon64_nfo_t *rominfo)
 //          memcpy (rominfo->name, "Game ID: ", 9);
           rominfo->backup_header_len = 0;
           rominfo->backup_usage = "SNES/Super Famicom Classic Mini";
-          copier_type = SMINI;
+          cd->copier_type = SMINI;
           sprintf (rominfo->misc + pos, "Type: SNES/Super Famicom Classic Mini SRAM/save state file\n"
                                         "SRAM size: %u kBytes", y / 1024);
           break;
@@ -5027,73 +5152,91 @@ snes_init (st_ucon64_nfo_t *rominfo)
     4. - snes_check_interleaved()
   */
 
-  snes_handle_backup_header (rominfo, &header); // step 1. & first part of step 2.
+  snes_handle_backup_header (p, rominfo, &header); // step 1. & first part of step 2.
 
-  if (!UCON64_ISSET (ucon64.split))
+  if (!UCON64_ISSET (p->split))
     {
-      if (copier_type == UFOSD)
-        ucon64.split = 0;                       // UFO SD ROMs cannot be split
+      if (cd->copier_type == UFOSD)
+        p->split = 0;                           // UFO SD ROMs cannot be split
       else
         {
-          if (copier_type == SWC || copier_type == FIG || copier_type == UFO)
+          if (cd->copier_type == SWC || cd->copier_type == FIG ||
+              cd->copier_type == UFO)
             {
-              int nparts = ucon64_testsplit (ucon64.fname, check_split, &split_info);
-              // force displayed info to be correct if not split (see ucon64.c)
-              ucon64.split = nparts == split_info.nparts + 1 ? nparts : 0;
-              if (check_smc_ic2_rom (ucon64.split, &split_info,
+              int nparts = ucon64_testsplit (p->fname, check_split, cd);
+              // force displayed info to be correct if not split (see p->c)
+              p->split = nparts == cd->split_info.nparts + 1 ? nparts : 0;
+              if (check_smc_ic2_rom (p->split, &cd->split_info,
                                      rominfo->backup_header_len))
-                copier_type = IC2;
+                cd->copier_type = IC2;
             }
           else
-            ucon64.split = ucon64_testsplit (ucon64.fname, NULL, NULL);
+            p->split = ucon64_testsplit (p->fname, NULL, NULL);
         }
     }
 
-  size = get_rom_data_size (rominfo->backup_header_len);
+  size = get_rom_data_size (p, rominfo->backup_header_len);
   if (size < SNES_HEADER_START + SNES_HEADER_LEN)
     {
-      snes_hirom = 0;
-      if (UCON64_ISSET (ucon64.snes_hirom))     // see snes_set_hirom()
-        snes_hirom = ucon64.snes_hirom;
-      snes_hirom_ok = 1;
+      cd->hirom = 0;
+      if (UCON64_ISSET (p->snes_hirom))         // see snes_set_hirom()
+        cd->hirom = p->snes_hirom;
+      cd->hirom_ok = 1;
 
       rominfo->interleaved = 0;
-      if (UCON64_ISSET (ucon64.interleaved))
-        rominfo->interleaved = ucon64.interleaved;
+      if (UCON64_ISSET (p->interleaved))
+        rominfo->interleaved = p->interleaved;
       return -1;                                // don't continue (seg faults!)
     }
-  if (ucon64.console == UCON64_SNES ||
-      (copier_type != SMC && size <= 16 * 1024 * 1024))
+  if (p->console == UCON64_SNES ||
+      (cd->copier_type != SMC && size <= 16 * 1024 * 1024))
     result = 0;                                 // it seems to be a SNES ROM dump
 
-  if ((rom_buffer = (unsigned char *) malloc (size)) == NULL)
+  // use the read-only image of the file if there is one, so that we don't have
+  //  to copy the data of large ROMs just to probe them
+  if (cd->copier_type != IC2 &&
+      (rom_image = quick_io_ctx_data (p->fname, &image_size)) != NULL &&
+      rominfo->backup_header_len + (uint64_t) size <= image_size)
     {
-      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
-      return -1;                                // don't exit(), we might've been
-    }                                           //  called with -lsv
-  read_rom_data (rom_buffer, rominfo->backup_header_len, size, ucon64.fname);
+      rom_buffer = (unsigned char *) rom_image + rominfo->backup_header_len;
+      rom_buffer_mapped = 1;
+    }
+  else
+    {
+      if ((rom_buffer = (unsigned char *) malloc (size)) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], size);
+          return -1;                            // don't exit(), we might've been
+        }                                       //  called with -lsv
+      read_rom_data (p, rom_buffer, rominfo->backup_header_len, size, p->fname);
+    }
 
-  x = snes_set_hirom (rom_buffer, size);        // second part of step 2. & step 3.
+  block_view_init (&view, rom_buffer, size);
+  x = snes_set_hirom (p, &view, size);          // second part of step 2. & step 3.
 
-  rominfo->header_start = snes_header_base + SNES_HEADER_START + snes_hirom;
+  rominfo->header_start = cd->header_base + SNES_HEADER_START + cd->hirom;
   rominfo->header_len = SNES_HEADER_LEN;
   // set snes_header before calling snes_check_interleaved()
-  memcpy (&snes_header, rom_buffer + rominfo->header_start, rominfo->header_len);
-  rominfo->header = &snes_header;
+  memcpy (&cd->header, rom_buffer + rominfo->header_start, rominfo->header_len);
+  rominfo->header = &cd->header;
 
   // step 4.
-  rominfo->interleaved = UCON64_ISSET (ucon64.interleaved) ?
-    ucon64.interleaved : snes_check_interleaved (rom_buffer, size, x);
+  rominfo->interleaved = UCON64_ISSET (p->interleaved) ?
+    p->interleaved : snes_check_interleaved (p, rom_buffer, size, x);
 
-  // check_smc_ic2_rom() sets split_info.parts[n].size only if ucon64.split is 2
+  // check_smc_ic2_rom() sets split_info.parts[n].size only if p->split is 2
   if (rominfo->interleaved &&
-      split_info.parts[0].size == 8 * MBIT + rominfo->backup_header_len &&
-      split_info.parts[1].size == 8 * MBIT + rominfo->backup_header_len)
+      cd->split_info.parts[0].size == 8 * MBIT + rominfo->backup_header_len &&
+      cd->split_info.parts[1].size == 8 * MBIT + rominfo->backup_header_len)
     {
       // first part turns out to be interleaved => 16 Mbit ROM in SMC IC2 format
-      unsigned int size2 = split_info.parts[1].size - rominfo->backup_header_len;
-      unsigned char *rom_buffer0 = rom_buffer;
-      copier_type = IC2;
+      unsigned int size2 = cd->split_info.parts[1].size - rominfo->backup_header_len;
+      unsigned char *rom_buffer0;
+
+      if ((rom_buffer = snes_own_rom_buffer (rom_buffer, size, &rom_buffer_mapped)) == NULL)
+        return -1;
+      rom_buffer0 = rom_buffer;
+      cd->copier_type = IC2;
       size = 2 * size2;
       if ((rom_buffer = (unsigned char *) realloc (rom_buffer0, size)) == NULL)
         {
@@ -5102,34 +5245,44 @@ snes_init (st_ucon64_nfo_t *rominfo)
           return -1;
         }
       ucon64_fread (rom_buffer + size2, rominfo->backup_header_len, size2,
-                    split_info.parts[1].fname);
+                    cd->split_info.parts[1].fname);
+      block_view_init (&view, rom_buffer, size);
     }
 
-  calc_checksums = !UCON64_ISSET (ucon64.do_not_calc_crc) && result == 0;
+  calc_checksums = !UCON64_ISSET (p->do_not_calc_crc) && result == 0;
   // we want the CRC32 of the "raw" data (too)
   if (calc_checksums)
-    ucon64.fcrc32 = crc32 (0, rom_buffer, size);
-  if (copier_type == IC2)
+    p->fcrc32 = crc32 (0, rom_buffer, size);
+  if (cd->copier_type == IC2)
     rominfo->data_size = size;
 
   // bs_dump has to be set before calling snes_chksum(), but snes_check_bs()
   //  needs snes_header to be filled with the correct data
   if (rominfo->interleaved)
     {
-      snes_deinterleave (rominfo, &rom_buffer, size);
-      snes_set_hirom (rom_buffer, size);
-      rominfo->header_start = snes_header_base + SNES_HEADER_START + snes_hirom;
-      memcpy (&snes_header, rom_buffer + rominfo->header_start, rominfo->header_len);
+      // look at the data in deinterleaved order without copying it (data
+      //  after the last complete block is not part of the deinterleaved ROM)
+      if ((nblocks = snes_deinterleave_map (p, rominfo, blocks, size)) != -1)
+        {
+          view.size = nblocks * 0x8000;
+          view.block_size = 0x8000;
+          view.nblocks = nblocks;
+          view.blocks = blocks;
+        }
+      snes_set_hirom (p, &view, size);
+      rominfo->header_start = cd->header_base + SNES_HEADER_START + cd->hirom;
+      block_view_read (&view, &cd->header, rominfo->header_start,
+                       rominfo->header_len);
     }
 
-  snes_set_bs_dump (rominfo, rom_buffer, size);
+  snes_set_bs_dump (p, rominfo, &view, size);
 
   // internal ROM name
-  if (!bs_dump && st_dump)
-    memcpy (rominfo->name, rom_buffer + 8 * MBIT + 16, SNES_NAME_LEN);
+  if (!cd->bs_dump && cd->st_dump)
+    block_view_read (&view, rominfo->name, 8 * MBIT + 16, SNES_NAME_LEN);
   else
-    memcpy (rominfo->name, snes_header.name, SNES_NAME_LEN);
-  rominfo->name[(bs_dump || st_dump) ? 16 : SNES_NAME_LEN] = '\0';
+    memcpy (rominfo->name, cd->header.name, SNES_NAME_LEN);
+  rominfo->name[(cd->bs_dump || cd->st_dump) ? 16 : SNES_NAME_LEN] = '\0';
   // terminate string (at 1st byte _after_ string)
 
   if (calc_checksums)
@@ -5137,26 +5290,31 @@ snes_init (st_ucon64_nfo_t *rominfo)
       // internal ROM crc
       rominfo->has_internal_crc = 1;
       rominfo->internal_crc_len = 2;
-      rominfo->current_internal_crc = snes_chksum (rominfo, rom_buffer, size);
-      rominfo->internal_crc = snes_header.checksum_low;
-      rominfo->internal_crc |= snes_header.checksum_high << 8;
-      x = snes_header.inverse_checksum_low;
-      x |= snes_header.inverse_checksum_high << 8;
+      rominfo->current_internal_crc = snes_chksum (p, rominfo, &view, size);
+      rominfo->internal_crc = cd->header.checksum_low;
+      rominfo->internal_crc |= cd->header.checksum_high << 8;
+      x = cd->header.inverse_checksum_low;
+      x |= cd->header.inverse_checksum_high << 8;
       y = ~rominfo->current_internal_crc & 0xffff;
       sprintf (rominfo->internal_crc2,
                "Inverse checksum: %s, 0x%04x (calculated) %c= 0x%04x (internal)",
                y == x ?
 #ifdef  USE_ANSI_COLOR
-                 ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                 ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
+                 p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                 p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
 #else
                  "OK" : "Bad",
 #endif
                y, y == x ? '=' : '!', x);
-      if (bs_dump == 1)                         // bs_dump == 2 for BS add-on dumps
+      // the data only has to be copied if the header has to be modified
+      if ((cd->bs_dump == 1 || cd->nsrt_header) &&
+          (rom_buffer = snes_view_buffer (&view, rom_buffer, size,
+                                          &rom_buffer_mapped)) == NULL)
+        return -1;
+      if (cd->bs_dump == 1)                     // bs_dump == 2 for BS add-on dumps
         {
           unsigned short int *bs_date_ptr = (unsigned short int *)
-            (rom_buffer + snes_header_base + SNES_HEADER_START + snes_hirom + 38);
+            (rom_buffer + cd->header_base + SNES_HEADER_START + cd->hirom + 38);
           /*
             We follow the "uCONSRT standard" for calculating the CRC32 of BS
             dumps. At the time of this writing (20 June 2003) the uCONSRT
@@ -5169,18 +5327,20 @@ snes_init (st_ucon64_nfo_t *rominfo)
             Why 42? It's the answer to life, the universe and everything :-)
           */
           *bs_date_ptr = me2le_16 (0x0042);
-          get_nsrt_info (rom_buffer, rominfo->header_start, (unsigned char *) &header);
-          ucon64.crc32 = crc32 (0, rom_buffer, size);
+          get_nsrt_info (p, rom_buffer, rominfo->header_start, (unsigned char *) &header);
+          p->crc32 = crc32 (0, rom_buffer, size);
         }
-      else if (rominfo->interleaved || nsrt_header)
+      else if (cd->nsrt_header)
         {
-          get_nsrt_info (rom_buffer, rominfo->header_start, (unsigned char *) &header);
-          ucon64.crc32 = crc32 (0, rom_buffer, size);
+          get_nsrt_info (p, rom_buffer, rominfo->header_start, (unsigned char *) &header);
+          p->crc32 = crc32 (0, rom_buffer, size);
         }
+      else if (rominfo->interleaved)
+        p->crc32 = ucon64_view_crc32 (0, &view, size);
       else
         {
-          ucon64.crc32 = ucon64.fcrc32;
-          ucon64.fcrc32 = 0;
+          p->crc32 = p->fcrc32;
+          p->fcrc32 = 0;
         }
     }
 
@@ -5189,7 +5349,7 @@ snes_init (st_ucon64_nfo_t *rominfo)
     rominfo->backup_usage = mgd_usage[0].help;
   else
     {
-      switch (copier_type)
+      switch (cd->copier_type)
         {
         case GD3:
           rominfo->backup_usage = gd_usage[0].help;
@@ -5221,25 +5381,25 @@ snes_init (st_ucon64_nfo_t *rominfo)
     }
 
   // ROM maker
-  if (snes_header.maker == 0x33 || bs_dump)
+  if (cd->header.maker == 0x33 || cd->bs_dump)
     {
-      unsigned int ih = snes_header.maker_high <= '9' ?
-                          snes_header.maker_high - '0' : snes_header.maker_high - 'A' + 10,
-                   il = snes_header.maker_low <= '9' ?
-                          snes_header.maker_low - '0' : snes_header.maker_low - 'A' + 10;
+      unsigned int ih = cd->header.maker_high <= '9' ?
+                          cd->header.maker_high - '0' : cd->header.maker_high - 'A' + 10,
+                   il = cd->header.maker_low <= '9' ?
+                          cd->header.maker_low - '0' : cd->header.maker_low - 'A' + 10;
       x = ih * 36 + il;
     }
-  else if (snes_header.maker != 0)
-    x = (snes_header.maker >> 4) * 36 + (snes_header.maker & 0x0f);
+  else if (cd->header.maker != 0)
+    x = (cd->header.maker >> 4) * 36 + (cd->header.maker & 0x0f);
   else
     x = 0;                                      // warning remover
 
   if (x >= NINTENDO_MAKER_LEN)
     x = 0;
-  rominfo->maker = snes_header.maker == 0 ? "Demo or Beta ROM?" :
+  rominfo->maker = cd->header.maker == 0 ? "Demo or Beta ROM?" :
     NULL_TO_UNKNOWN_S (nintendo_maker[x]);
 
-  if (!bs_dump)
+  if (!cd->bs_dump)
     {
       const char *snes_rom_type[3] =
         {
@@ -5249,19 +5409,19 @@ snes_init (st_ucon64_nfo_t *rominfo)
         };
 
       // ROM country
-      rominfo->country = NULL_TO_UNKNOWN_S (snes_country[MIN (snes_header.country, SNES_COUNTRY_MAX - 1)]);
+      rominfo->country = NULL_TO_UNKNOWN_S (snes_country[MIN (cd->header.country, SNES_COUNTRY_MAX - 1)]);
 
       // misc stuff
-      pos += sprintf (rominfo->misc + pos, "HiROM: %s\n", snes_hirom ? "Yes" : "No");
-      pos += sprintf (rominfo->misc + pos, "Internal size: %u Mb\n", get_internal_size ());
+      pos += sprintf (rominfo->misc + pos, "HiROM: %s\n", cd->hirom ? "Yes" : "No");
+      pos += sprintf (rominfo->misc + pos, "Internal size: %u Mb\n", get_internal_size (p));
 //      pos += sprintf (rominfo->misc + pos, "Map type: %x\n", snes_header.map_type);
-      pos += sprintf (rominfo->misc + pos, "ROM type: (%x) %s", snes_header.rom_type,
-                      snes_rom_type[(snes_header.rom_type & 7) % 3]);
-      if ((snes_header.rom_type & 0xf) >= 3)
+      pos += sprintf (rominfo->misc + pos, "ROM type: (%x) %s", cd->header.rom_type,
+                      snes_rom_type[(cd->header.rom_type & 7) % 3]);
+      if ((cd->header.rom_type & 0xf) >= 3)
         {
           char *str;
 
-          switch (snes_header.rom_type)
+          switch (cd->header.rom_type)
             {
             case 3:
             case 5:
@@ -5275,7 +5435,7 @@ snes_init (st_ucon64_nfo_t *rominfo)
               break;
             case 0x14:
             case 0x15:
-              if (snes_header.rom_size > 10)
+              if (cd->header.rom_size > 10)
                 str = "Super FX 2";             // larger than 8 Mbit
               else
                 str = "Super FX";
@@ -5301,7 +5461,7 @@ snes_init (st_ucon64_nfo_t *rominfo)
               str = "C4";
               break;
             case 0xf5:
-              if (snes_header.map_type == 0x30)
+              if (cd->header.map_type == 0x30)
                 str = "Seta RISC";
               else
                 str = "SPC7110";
@@ -5321,28 +5481,28 @@ snes_init (st_ucon64_nfo_t *rominfo)
       pos += sprintf (rominfo->misc + pos, "\n");
 
       pos += sprintf (rominfo->misc + pos, "ROM speed: %s\n",
-                      snes_header.map_type & 0x10 ? "120 ns (FastROM)" : "200 ns (SlowROM)");
+                      cd->header.map_type & 0x10 ? "120 ns (FastROM)" : "200 ns (SlowROM)");
 
-      if (snes_header.rom_type == 0x13 || snes_header.rom_type == 0x1a ||
-          snes_header.rom_type == 0x14 || snes_header.rom_type == 0x15)
+      if (cd->header.rom_type == 0x13 || cd->header.rom_type == 0x1a ||
+          cd->header.rom_type == 0x14 || cd->header.rom_type == 0x15)
         {
-          snes_sram_size = 32 * 1024;
-          if (snes_header.maker == 0x33)
-            snes_sfx_sram_size = snes_header.sfx_sram_size ? 1 << (snes_header.sfx_sram_size + 10) : 0;
+          cd->sram_size = 32 * 1024;
+          if (cd->header.maker == 0x33)
+            cd->sfx_sram_size = cd->header.sfx_sram_size ? 1 << (cd->header.sfx_sram_size + 10) : 0;
           else
-            snes_sfx_sram_size = 32 * 1024;
+            cd->sfx_sram_size = 32 * 1024;
         }
       else
         {
-          snes_sram_size = snes_header.sram_size ? 1 << (snes_header.sram_size + 10) : 0;
-          snes_sfx_sram_size = 0;
+          cd->sram_size = cd->header.sram_size ? 1 << (cd->header.sram_size + 10) : 0;
+          cd->sfx_sram_size = 0;
         }
 
-      if (!snes_sram_size && !snes_sfx_sram_size)
+      if (!cd->sram_size && !cd->sfx_sram_size)
         pos += sprintf (rominfo->misc + pos, "SRAM: No\n");
       else
         pos += sprintf (rominfo->misc + pos, "SRAM: Yes, %u kBytes\n",
-                        (snes_sfx_sram_size ? snes_sfx_sram_size : snes_sram_size) / 1024);
+                        (cd->sfx_sram_size ? cd->sfx_sram_size : cd->sram_size) / 1024);
     }
   else                                          // BS info
     {
@@ -5357,22 +5517,22 @@ snes_init (st_ucon64_nfo_t *rominfo)
       // ROM country
       rominfo->country = "Japan";
       // misc stuff
-      if (bs_dump == 2)
+      if (cd->bs_dump == 2)
         pos += sprintf (rominfo->misc + pos, "\nBroadcast Satellaview add-on cartridge dump\n");
       else
         pos += sprintf (rominfo->misc + pos, "\nBroadcast Satellaview dump\n"); // new line is intentional
 
       pos += sprintf (rominfo->misc + pos, "Dumping date: %d/%d\n",
-                      snes_header.bs_day & 4 ?
-                        0 /* incorrect data */ : snes_header.bs_day >> 3,
-                      snes_header.bs_month >> 4);
-      pos += sprintf (rominfo->misc + pos, "HiROM: %s\n", snes_hirom ? "Yes" : "No");
+                      cd->header.bs_day & 4 ?
+                        0 /* incorrect data */ : cd->header.bs_day >> 3,
+                      cd->header.bs_month >> 4);
+      pos += sprintf (rominfo->misc + pos, "HiROM: %s\n", cd->hirom ? "Yes" : "No");
 
       // misc stuff
-      pos += sprintf (rominfo->misc + pos, "Internal size: %u Mb\n", get_internal_size ());
+      pos += sprintf (rominfo->misc + pos, "Internal size: %u Mb\n", get_internal_size (p));
 //      pos += sprintf (rominfo->misc + pos, "Map type: %x\n", snes_header.bs_map_type);
-      x = snes_header.bs_type >> 4;
-      pos += sprintf (rominfo->misc + pos, "ROM type: (%x) %s\n", snes_header.bs_type,
+      x = cd->header.bs_type >> 4;
+      pos += sprintf (rominfo->misc + pos, "ROM type: (%x) %s\n", cd->header.bs_type,
                       x > 3 ? "Unknown" : snes_bs_type[x]);
 
       /*
@@ -5381,33 +5541,36 @@ snes_init (st_ucon64_nfo_t *rominfo)
         "(snes_header.bs_map_type >> 4) > 2".
       */
       pos += sprintf (rominfo->misc + pos, "ROM speed: %s\n",
-                      snes_header.bs_map_type & 0x10 ? "120 ns (FastROM)" : "200 ns (SlowROM)");
+                      cd->header.bs_map_type & 0x10 ? "120 ns (FastROM)" : "200 ns (SlowROM)");
     }
 
-  sprintf (rominfo->misc + pos, "Version: 1.%u", snes_header.version);
+  sprintf (rominfo->misc + pos, "Version: 1.%u", cd->header.version);
 
-  if (nsrt_header)
-    handle_nsrt_header (rominfo, (unsigned char *) &header, snes_country);
+  if (cd->nsrt_header)
+    handle_nsrt_header (p, rominfo, (unsigned char *) &header, snes_country);
 
-  free (rom_buffer);
+  if (!rom_buffer_mapped)
+    free (rom_buffer);
   return result;
 }
 
 
 #if 1
 static unsigned int
-snes_check_bs (void)
+snes_check_bs (st_ucon64_t *p)
 {
-  if ((snes_header.maker == 0x33 || snes_header.maker == 0xff) &&
-      (snes_header.map_type == 0 || (snes_header.map_type & 0x83) == 0x80))
+  st_snes_data_t *cd = snes_data (p);
+
+  if ((cd->header.maker == 0x33 || cd->header.maker == 0xff) &&
+      (cd->header.map_type == 0 || (cd->header.map_type & 0x83) == 0x80))
     {
-      int date = (snes_header.bs_day << 8) | snes_header.bs_month;
+      int date = (cd->header.bs_day << 8) | cd->header.bs_month;
 
       if (date == 0)
         return 2;                               // BS add-on cartridge dump
       else if (date == 0xffff ||
-               ((snes_header.bs_month & 0xf) == 0 &&
-                ((unsigned int) ((snes_header.bs_month >> 4) - 1)) < 12))
+               ((cd->header.bs_month & 0xf) == 0 &&
+                ((unsigned int) ((cd->header.bs_month >> 4) - 1)) < 12))
         return 1;                               // BS dump (via BSX)
     }
   return 0;
@@ -5427,17 +5590,18 @@ check_char (unsigned char c)
 
 
 static unsigned int
-snes_bs_name (void)
+snes_bs_name (st_ucon64_t *p)
 {
+  st_snes_data_t *cd = snes_data (p);
   unsigned char value;
   unsigned int n, n_valid = 0;
 
   for (n = 0; n < 16; n++)
     {
-      value = snes_header.name[n];
+      value = cd->header.name[n];
       if (check_char (value) != 0)
         {
-          value = snes_header.name[n + 1];
+          value = cd->header.name[n + 1];
           if (value < 0x20 && (n_valid != 11 || value != 0)) // Dr. Mario Hack
             break;
           n_valid++;
@@ -5462,17 +5626,18 @@ snes_bs_name (void)
 
 
 static unsigned int
-snes_check_bs (void)
+snes_check_bs (st_ucon64_t *p)
 {
+  st_snes_data_t *cd = snes_data (p);
   unsigned int value;
 
-  if (snes_header.bs_type & 0x4f)
+  if (cd->header.bs_type & 0x4f)
     return 0;
 
-  if (snes_header.maker != 0x33 && snes_header.maker != 0xff)
+  if (cd->header.maker != 0x33 && cd->header.maker != 0xff)
     return 0;
 
-  value = (snes_header.bs_day << 8) | snes_header.bs_month;
+  value = (cd->header.bs_day << 8) | cd->header.bs_month;
   if (value != 0x0000 && value != 0xffff)
     {
       if ((value & 0x040f) != 0)
@@ -5481,26 +5646,49 @@ snes_check_bs (void)
         return 0;
     }
 
-  if (snes_header.bs_map_type & 0xce || ((snes_header.bs_map_type & 0x30) == 0))
+  if (cd->header.bs_map_type & 0xce || ((cd->header.bs_map_type & 0x30) == 0))
     return 0;
 
-  if ((snes_header.map_type & 0x03) != 0)
+  if ((cd->header.map_type & 0x03) != 0)
     return 0;
 
-  value = ((unsigned char *) &snes_header)[35];
+  value = ((unsigned char *) &cd->header)[35];
   if (value != 0 && value != 0xff)
     return 0;
 
-  if (((unsigned char *) &snes_header)[36] != 0)
+  if (((unsigned char *) &cd->header)[36] != 0)
     return 0;
 
-  return snes_bs_name ();
+  return snes_bs_name (p);
 }
 #endif
 
 
+static unsigned short int
+snes_sum (const st_block_view_t *view, unsigned int start, unsigned int end)
+// return the 16-bit sum of the bytes [start, end) of view
+{
+  unsigned char scratch[MAXBUFSIZE];
+  unsigned short int sum = 0;
+  size_t n;
+
+  for (; start < end; start += (unsigned int) n)
+    {
+      const unsigned char *p;
+      size_t i;
+
+      n = end - start;
+      p = block_view_data (view, start, &n, scratch, sizeof scratch);
+      for (i = 0; i < n; i++)
+        sum += p[i];
+    }
+  return sum;
+}
+
+
 static int
-snes_chksum (st_ucon64_nfo_t *rominfo, unsigned char *rom_buffer, unsigned int rom_size)
+snes_chksum (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+             const st_block_view_t *view, unsigned int rom_size)
 #if 0
 /*
   Calculate the checksum of a SNES ROM. A big difference between this version of
@@ -5521,41 +5709,37 @@ snes_chksum (st_ucon64_nfo_t *rominfo, unsigned char *rom_buffer, unsigned int r
   - Wild Guns (J) (Sample) (NG-Dump Known) [h1]
 */
 {
-  unsigned int i;
-  unsigned short int sum = 0;
+  st_snes_data_t *cd = snes_data (p);
+  unsigned short int sum;
 
-  if ((snes_header.rom_type == 0xf5 && snes_header.map_type != 0x30) ||
-      snes_header.rom_type == 0xf9 || bs_dump)
+  if ((cd->header.rom_type == 0xf5 && cd->header.map_type != 0x30) ||
+      cd->header.rom_type == 0xf9 || cd->bs_dump)
     {
-      for (i = 0; i < rom_size; i++)
-        sum += rom_buffer[i];                   // Far East of Eden Zero (J)
+      sum = snes_sum (view, 0, rom_size);       // Far East of Eden Zero (J)
 
       if (rom_size == 24 * MBIT)
         sum *= 2;                               // Momotaro Dentetsu Happy (J)
 
-      if (bs_dump)                              // Broadcast Satellaview "ROM"
-        for (i = rominfo->header_start;
-             i < rominfo->header_start + SNES_HEADER_LEN; i++)
-          sum -= rom_buffer[i];
+      if (cd->bs_dump)                          // Broadcast Satellaview "ROM"
+        sum -= snes_sum (view, rominfo->header_start,
+                         rominfo->header_start + SNES_HEADER_LEN);
     }
   else
     {
       // largest known cart size is 48 Mbit (internal size 64 Mbit)
       unsigned int internal_rom_size =
-                     snes_header.rom_size > 0 && snes_header.rom_size <= 13 ?
-                       1U << (snes_header.rom_size + 10) : st_dump ?
+                     cd->header.rom_size > 0 && cd->header.rom_size <= 13 ?
+                       1U << (cd->header.rom_size + 10) : cd->st_dump ?
                          rom_size - 8 * MBIT : rom_size,
                    half_internal_rom_size = internal_rom_size >> 1,
-                   i_start = st_dump ? 8 * MBIT : 0,
+                   i_start = cd->st_dump ? 8 * MBIT : 0,
                    i_end = i_start + (half_internal_rom_size > rom_size ?
                              rom_size : half_internal_rom_size),
                    remainder = rom_size - i_start - half_internal_rom_size;
-      unsigned short int sum2 = 0;
+      unsigned short int sum2;
 
-      for (i = i_start; i < i_end; i++)         // normal ROM
-        sum += rom_buffer[i];
-      for (i = i_start + half_internal_rom_size; i < rom_size; i++)
-        sum2 += rom_buffer[i];
+      sum = snes_sum (view, i_start, i_end);    // normal ROM
+      sum2 = snes_sum (view, i_start + half_internal_rom_size, rom_size);
 
       if (!remainder)                           // don't divide by zero below
         remainder = half_internal_rom_size;
@@ -5567,41 +5751,38 @@ snes_chksum (st_ucon64_nfo_t *rominfo, unsigned char *rom_buffer, unsigned int r
 #else
 // Calculate the checksum of a SNES ROM.
 {
+  st_snes_data_t *cd = snes_data (p);
+
   // largest known cart size is 48 Mbit (internal size 64 Mbit)
   unsigned int internal_rom_size =
-                 snes_header.rom_size > 0 && snes_header.rom_size <= 13 ?
-                   1U << (snes_header.rom_size + 10) : st_dump ?
+                 cd->header.rom_size > 0 && cd->header.rom_size <= 13 ?
+                   1U << (cd->header.rom_size + 10) : cd->st_dump ?
                      rom_size - 8 * MBIT : rom_size,
                diff_size = internal_rom_size - rom_size <= rom_size ?
                              internal_rom_size - rom_size : 0,
-               i, i_end = (snes_header.rom_type == 0xf5 &&
-                           snes_header.map_type == 0x3a &&
-                           rom_size == 24 * MBIT) ||
-                          bs_dump ||
-                          snes_header.rom_type == 0xf9 || // Far East of Eden Zero (J)
-                          internal_rom_size <= rom_size ?
-                            rom_size : rom_size - ((diff_size % (6 * MBIT)) ?
-                                                     diff_size : diff_size / 3);
-  unsigned short int sum = 0;
-
-  for (i = st_dump ? 8 * MBIT : 0; i < i_end; i++)
-    sum += rom_buffer[i];
-  if (snes_header.rom_type == 0xf5 && snes_header.map_type == 0x3a &&
+               i_end = (cd->header.rom_type == 0xf5 &&
+                        cd->header.map_type == 0x3a &&
+                        rom_size == 24 * MBIT) ||
+                       cd->bs_dump ||
+                       cd->header.rom_type == 0xf9 || // Far East of Eden Zero (J)
+                       internal_rom_size <= rom_size ?
+                         rom_size : rom_size - ((diff_size % (6 * MBIT)) ?
+                                                  diff_size : diff_size / 3);
+  unsigned short int sum = snes_sum (view, cd->st_dump ? 8 * MBIT : 0, i_end);
+
+  if (cd->header.rom_type == 0xf5 && cd->header.map_type == 0x3a &&
       rom_size == 24 * MBIT)                    // Momotaro Dentetsu Happy (J)
     sum *= 2;
-  else if (bs_dump)                             // Broadcast Satellaview "ROM"
-    for (i = rominfo->header_start;
-         i < rominfo->header_start + SNES_HEADER_LEN; i++)
-      sum -= rom_buffer[i];
+  else if (cd->bs_dump)                         // Broadcast Satellaview "ROM"
+    sum -= snes_sum (view, rominfo->header_start,
+                     rominfo->header_start + SNES_HEADER_LEN);
   else if (i_end < rom_size)
     {
-      unsigned short int sum2 = 0;
+      unsigned short int sum2 = snes_sum (view, i_end, rom_size);
       // diff_size >= internal_rom_size / 4 to match the snes_chksum() above (28 Mbit ROMs)
       unsigned char factor = diff_size % (6 * MBIT) == 0 ? // 6(16-10),12(32-20),24(64-40)
                                4 : diff_size >= internal_rom_size / 4 ?
                                  2 : 1;
-      for (i = i_end; i < rom_size; i++)
-        sum2 += rom_buffer[i];
       sum += sum2 * factor;
     }
 
@@ -5626,76 +5807,79 @@ snes_isprint (char *s, int len)
 
 
 static unsigned int
-check_banktype (unsigned char *rom_buffer, unsigned int header_offset)
+check_banktype (st_ucon64_t *p, const unsigned char *header,
+                unsigned int header_offset)
 /*
   This function is used to check if the value of header_offset is a good guess
   for the location of the internal SNES header (and thus of the bank type
   (LoROM, HiROM or Extended HiROM)). The higher the returned value, the higher
-  the chance the guess was correct.
+  the chance the guess was correct. header must point to the (first
+  SNES_BANKTYPE_LEN bytes of the) data at SNES_HEADER_START + header_offset.
 */
 {
+  st_snes_data_t *cd = snes_data (p);
   unsigned int score = 0, x, y;
 
-//  dumper (stdout, (char *) rom_buffer + SNES_HEADER_START + header_offset,
-//           SNES_HEADER_LEN, SNES_HEADER_START + header_offset, DUMPER_HEX);
+//  dumper (stdout, (char *) header, SNES_HEADER_LEN,
+//          SNES_HEADER_START + header_offset, DUMPER_HEX);
 
   // game ID info (many games don't have useful info here)
-  if (snes_isprint ((char *) rom_buffer + SNES_HEADER_START + header_offset + 2, 4))
+  if (snes_isprint ((char *) header + 2, 4))
     score += 1;
 
-  if (!bs_dump)
+  if (!cd->bs_dump)
     {
-      if (snes_isprint ((char *) rom_buffer + SNES_HEADER_START + header_offset + 16,
+      if (snes_isprint ((char *) header + 16,
                         SNES_NAME_LEN))
         score += 1;
 
       // map type
-      x = rom_buffer[SNES_HEADER_START + header_offset + 37];
+      x = header[37];
       if ((x & 0xf) < 4)
         score += 2;
-      y = rom_buffer[SNES_HEADER_START + header_offset + 38];
-      if (snes_hirom_ok && !(y == 0x34 || y == 0x35)) // ROM type for SA-1
+      y = header[38];
+      if (cd->hirom_ok && !(y == 0x34 || y == 0x35)) // ROM type for SA-1
         // map type, HiROM flag (only if we're sure about value of snes_hirom)
-        if ((x & 1) == ((header_offset >= snes_header_base + SNES_HIROM) ? 1U : 0U))
+        if ((x & 1) == ((header_offset >= cd->header_base + SNES_HIROM) ? 1U : 0U))
           score += 1;
 
       // ROM size
-      if (1 << (rom_buffer[SNES_HEADER_START + header_offset + 39] - 7) <= 64)
+      if (1 << (header[39] - 7) <= 64)
         score += 1;
 
       // SRAM size
-      if (1 << rom_buffer[SNES_HEADER_START + header_offset + 40] <= 256)
+      if (1 << header[40] <= 256)
         score += 1;
 
       // country
-      if (rom_buffer[SNES_HEADER_START + header_offset + 41] <= 13)
+      if (header[41] <= 13)
         score += 1;
     }
   else
     {
       // map type, HiROM flag
-      if (snes_hirom_ok &&
-          (rom_buffer[SNES_HEADER_START + header_offset + 40] & 1) ==
-            (header_offset >= snes_header_base + SNES_HIROM ? 1 : 0))
+      if (cd->hirom_ok &&
+          (header[40] & 1) ==
+            (header_offset >= cd->header_base + SNES_HIROM ? 1 : 0))
         score += 1;
     }
 
   // publisher "escape code"
-  if (rom_buffer[SNES_HEADER_START + header_offset + 42] == 0x33)
+  if (header[42] == 0x33)
     score += 2;
   else // publisher code
-    if (snes_isprint ((char *) rom_buffer + SNES_HEADER_START + header_offset, 2))
+    if (snes_isprint ((char *) header, 2))
       score += 2;
 
   // version
-  if (rom_buffer[SNES_HEADER_START + header_offset + 43] <= 2)
+  if (header[43] <= 2)
     score += 2;
 
   // checksum bytes
-  x = rom_buffer[SNES_HEADER_START + header_offset + 44] |
-      (rom_buffer[SNES_HEADER_START + header_offset + 45] << 8);
-  y = rom_buffer[SNES_HEADER_START + header_offset + 46] |
-      (rom_buffer[SNES_HEADER_START + header_offset + 47] << 8);
+  x = header[44] |
+      (header[45] << 8);
+  y = header[46] |
+      (header[47] << 8);
   if (x + y == 0xffff)
     {
       if (x == 0xffff || y == 0xffff)
@@ -5705,7 +5889,7 @@ check_banktype (unsigned char *rom_buffer, unsigned int header_offset)
     }
 
   // reset vector
-  if (rom_buffer[SNES_HEADER_START + header_offset + 0x4d] & 0x80)
+  if (header[0x4d] & 0x80)
     score += 3;
 
   return score;
@@ -5744,7 +5928,7 @@ snes_demirror (st_ucon64_nfo_t *rominfo)        // nice verb :-)
       if (memcmp (buffer + size - mirror_size, buffer + size - 2 * mirror_size,
                   mirror_size) == 0)
         {
-          if (ucon64.quiet < 0)
+          if (ucon64_settings.quiet < 0)
             printf ("Mirrored: %u - %u == %u - %u\n",
                     (size - 2 * mirror_size) / MBIT,
                     (size - mirror_size) / MBIT,
@@ -5757,7 +5941,7 @@ snes_demirror (st_ucon64_nfo_t *rominfo)        // nice verb :-)
 
   if (!fixed)
     {
-      if (ucon64.quiet < 1)
+      if (ucon64_settings.quiet < 1)
         puts ("NOTE: Did not detect a mirrored block -- no file has been written");
       free (buffer);
       return 1;
@@ -5781,12 +5965,13 @@ static void
 write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
                         unsigned int size)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   int n, uses_DSP;
   unsigned char name[0x1c], flags1, flags2;
   static int slot = 0;
 
-  uses_DSP = snes_header.rom_type == 3 || snes_header.rom_type == 5 ||
-             snes_header.rom_type == 0xf6;
+  uses_DSP = cd->header.rom_type == 3 || cd->header.rom_type == 5 ||
+             cd->header.rom_type == 0xf6;
 
   fseek (destfile, 0x4000 + (file_no - 1) * 0x20, SEEK_SET);
   fputc (0xff, destfile);                       // 0x0 = 0xff
@@ -5797,13 +5982,13 @@ write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
   memset (name + n, ' ', 0x1c - n);
   fwrite (name, 1, 0x1c, destfile);             // 0x1 - 0x1c = name
 
-  if (snes_sram_size)
+  if (cd->sram_size)
     {
-      if (snes_sram_size == 2 * 1024)
+      if (cd->sram_size == 2 * 1024)
         flags2 = 0x00;
-      else if (snes_sram_size == 8 * 1024)
+      else if (cd->sram_size == 8 * 1024)
         flags2 = 0x10;
-      else if (snes_sram_size == 32 * 1024)
+      else if (cd->sram_size == 32 * 1024)
         flags2 = 0x20;
       else // if (snes_sram_size == 128 * 1024) // default to 1024 kbit SRAM
         flags2 = 0x30;
@@ -5811,12 +5996,12 @@ write_game_table_entry (FILE *destfile, int file_no, st_ucon64_nfo_t *rominfo,
   else
     flags2 = 0x40;
 
-  if (snes_header_base == SNES_EROM)            // enable Extended Map for >32 Mbit ROMs
+  if (cd->header_base == SNES_EROM)             // enable Extended Map for >32 Mbit ROMs
     flags2 |= 0x80;
 
-  flags1 = snes_hirom ? 0x10 : 0x00;
+  flags1 = cd->hirom ? 0x10 : 0x00;
 
-  if (!snes_hirom && uses_DSP)                  // set LoROM DSP flag if necessary
+  if (!cd->hirom && uses_DSP)                   // set LoROM DSP flag if necessary
     flags1 |= 0x01;
 
   if (slot == 0)
@@ -5886,7 +6071,7 @@ snes_multi (unsigned int truncate_size)
       ucon64.fsize = fsizeof (ucon64.fname);
       // DON'T use fstate.st_size, because file could be compressed
       ucon64.do_not_calc_crc = 1;
-      if (snes_init (ucon64.nfo) != 0)
+      if (snes_init (&ucon64, ucon64.nfo) != 0)
         printf ("WARNING: %s does not appear to be a SNES ROM\n", ucon64.fname);
       else if (ucon64.nfo->interleaved)
         printf ("WARNING: %s appears to be interleaved\n", ucon64.fname);
@@ -5976,13 +6161,14 @@ snes_multi (unsigned int truncate_size)
 int
 snes_densrt (st_ucon64_nfo_t *rominfo)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   unsigned int size = (unsigned int) ucon64.fsize - rominfo->backup_header_len;
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   unsigned char backup_header[512] = { 0 }, *buffer;
 
-  if (!nsrt_header)
+  if (!cd->nsrt_header)
     {
-      if (ucon64.quiet < 1)
+      if (ucon64_settings.quiet < 1)
         puts ("NOTE: ROM has no NSRT header -- no file has been written");
       return 1;
     }
@@ -5995,7 +6181,8 @@ snes_densrt (st_ucon64_nfo_t *rominfo)
     }
   ucon64_fread (buffer, rominfo->backup_header_len, size, ucon64.fname);
 
-  get_nsrt_info (buffer, get_header_start (rominfo, size), backup_header);
+  get_nsrt_info (&ucon64, buffer, get_header_start (rominfo, size),
+                 backup_header);
   memset (backup_header + 0x1d0, 0, 32);        // remove NSRT header
 
   strcpy (src_name, ucon64.fname);
@@ -6066,10 +6253,11 @@ set_nsrt_info (st_ucon64_nfo_t *rominfo, unsigned char *header)
   0x1ef                 inverse NSRT header checksum
 */
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
   int x;
 
   if ((UCON64_ISSET (ucon64.controller) || UCON64_ISSET (ucon64.controller2)) &&
-      !nsrt_header)                             // don't overwrite these values
+      !cd->nsrt_header)                         // don't overwrite these values
     {
       if (rominfo->current_internal_crc != rominfo->internal_crc)
         {
@@ -6077,18 +6265,18 @@ set_nsrt_info (st_ucon64_nfo_t *rominfo, unsigned char *header)
           return;
         }
 
-      header[0x1d0] = bs_dump ? 0 : snes_header.country;
+      header[0x1d0] = cd->bs_dump ? 0 : cd->header.country;
       if (rominfo->header_start == SNES_EROM + SNES_HEADER_START + SNES_HIROM)
         header[0x1d0] |= 0x30;                  // NOTE: Extended LoROM is not supported
       else
-        header[0x1d0] |= snes_hirom ? 0x20 : 0x10;
+        header[0x1d0] |= cd->hirom ? 0x20 : 0x10;
 
-      if (!bs_dump && st_dump)
+      if (!cd->bs_dump && cd->st_dump)
         memcpy (header + 0x1d1, rominfo->name, 16);
       else // for ST dumps, rominfo->name may be used
-        memcpy (header + 0x1d1, &snes_header.name, SNES_NAME_LEN);
-      header[0x1e6] = snes_header.checksum_low;
-      header[0x1e7] = snes_header.checksum_high;
+        memcpy (header + 0x1d1, &cd->header.name, SNES_NAME_LEN);
+      header[0x1e6] = cd->header.checksum_low;
+      header[0x1e7] = cd->header.checksum_high;
       memcpy (header + 0x1e8, "NSRT", 4);
       header[0x1ec] = NSRT_HEADER_VERSION;
     }
@@ -6125,14 +6313,17 @@ set_nsrt_info (st_ucon64_nfo_t *rominfo, unsigned char *header)
 
 
 static void
-get_nsrt_info (unsigned char *rom_buffer, int header_start, unsigned char *backup_header)
+get_nsrt_info (st_ucon64_t *p, unsigned char *rom_buffer, int header_start,
+               unsigned char *backup_header)
 {
-  if (nsrt_header)
+  st_snes_data_t *cd = snes_data (p);
+
+  if (cd->nsrt_header)
     {
-      memcpy (rom_buffer + header_start + 16 - (st_dump ? SNES_HEADER_START : 0),
-              backup_header + 0x1d1, (bs_dump || st_dump) ? 16 : SNES_NAME_LEN); // name
+      memcpy (rom_buffer + header_start + 16 - (cd->st_dump ? SNES_HEADER_START : 0),
+              backup_header + 0x1d1, (cd->bs_dump || cd->st_dump) ? 16 : SNES_NAME_LEN); // name
       // we ignore interleaved ST dumps
-      if (!bs_dump)
+      if (!cd->bs_dump)
         {
           // According to the NSRT specification, the region byte should be set
           //  to 0 for BS dumps.
@@ -6152,8 +6343,10 @@ get_nsrt_info (unsigned char *rom_buffer, int header_start, unsigned char *backu
 static void
 reset_header (void *header)
 {
+  st_snes_data_t *cd = snes_data (&ucon64);
+
   // preserve possible NSRT header
-  if (nsrt_header)
+  if (cd->nsrt_header)
     {
       memset (header, 0, 0x1d0);
       memset ((unsigned char *) header + 0x1f0, 0, 16);
@@ -6166,9 +6359,10 @@ reset_header (void *header)
 
 
 static void
-handle_nsrt_header (st_ucon64_nfo_t *rominfo, unsigned char *header,
-                    const char **snes_country)
+handle_nsrt_header (st_ucon64_t *p, st_ucon64_nfo_t *rominfo,
+                    unsigned char *header, const char **snes_country)
 {
+  st_snes_data_t *cd = snes_data (p);
   char name[SNES_NAME_LEN + 1], *str_list[9] =
     {
       "Gamepad", "Mouse", "Mouse / Gamepad", "Super Scope",
@@ -6176,7 +6370,7 @@ handle_nsrt_header (st_ucon64_nfo_t *rominfo, unsigned char *header,
       "Mouse / Super Scope / Gamepad", "Unknown"
     };
   int x = header[0x1ed], ctrl1 = x >> 4, ctrl2 = x & 0xf,
-      name_len = (bs_dump || st_dump) ? 16 : SNES_NAME_LEN;
+      name_len = (cd->bs_dump || cd->st_dump) ? 16 : SNES_NAME_LEN;
 
   memcpy (name, header + 0x1d1, name_len);
   name[name_len] = '\0';
@@ -6208,14 +6402,15 @@ handle_nsrt_header (st_ucon64_nfo_t *rominfo, unsigned char *header,
 int
 snes_create_sram (void)
 {
-  unsigned int size = snes_sram_size > 256 * 1024 ? 256 * 1024 : snes_sram_size;
+  st_snes_data_t *cd = snes_data (&ucon64);
+  unsigned int size = cd->sram_size > 256 * 1024 ? 256 * 1024 : cd->sram_size;
   char dest_name[FILENAME_MAX];
   FILE *destfile;
   unsigned char *buffer;
 
   if (size == 0)
     {
-      if (ucon64.quiet < 1)
+      if (ucon64_settings.quiet < 1)
         puts ("NOTE: ROM does not use SRAM -- no file has been written");
       return 1;
     }
@@ -50,10 +50,10 @@ extern int snes_gd_make_names (const char *filename,
                                unsigned int backup_header_len, char **names);
 extern int snes_gd3 (st_ucon64_nfo_t *rominfo);
 extern int snes_gd3s (st_ucon64_nfo_t *rominfo);
-extern snes_copier_t snes_get_copier_type (void);
-extern unsigned int snes_get_snes_hirom (void);
+extern snes_copier_t snes_get_copier_type (st_ucon64_t *p);
+extern unsigned int snes_get_snes_hirom (st_ucon64_t *p);
 extern int snes_ic2 (st_ucon64_nfo_t *rominfo);
-extern int snes_init (st_ucon64_nfo_t *rominfo);
+extern int snes_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int snes_j (st_ucon64_nfo_t *rominfo);
 extern int snes_k (st_ucon64_nfo_t *rominfo);
 extern int snes_l (st_ucon64_nfo_t *rominfo);
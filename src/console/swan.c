@@ -34,7 +34,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "backup/backup.h"
 
 
-static int swan_chksum (unsigned char *rom_buffer);
+static int swan_chksum (st_ucon64_t *p, unsigned char *rom_buffer);
 
 static st_ucon64_obj_t swan_obj[] =
   {
@@ -68,11 +68,17 @@ typedef struct st_swan_header
   char pad[10];
 } st_swan_header_t;
 
-#define SWAN_HEADER_START (ucon64.fsize - 10)
+#define SWAN_HEADER_START(fsize) ((fsize) - 10)
 #define SWAN_HEADER_LEN (sizeof (st_swan_header_t))
 
 
-static st_swan_header_t swan_header;
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_swan_header_t header;
+} st_swan_data_t;
+#define swan_data(p) ((st_swan_data_t *) \
+  ucon64_console_data (p, UCON64_SWAN, sizeof (st_swan_data_t)))
 
 
 int
@@ -84,11 +90,13 @@ swan_chk (st_ucon64_nfo_t *rominfo)
   ucon64_file_handler (dest_name, NULL, 0);
   fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb");
 
-  ucon64_fputc (dest_name, SWAN_HEADER_START + 8, rominfo->current_internal_crc, "r+b"); // low byte
-  ucon64_fputc (dest_name, SWAN_HEADER_START + 9, rominfo->current_internal_crc >> 8, "r+b"); // high byte
+  ucon64_fputc (dest_name, SWAN_HEADER_START (ucon64.fsize) + 8,
+                rominfo->current_internal_crc, "r+b"); // low byte
+  ucon64_fputc (dest_name, SWAN_HEADER_START (ucon64.fsize) + 9,
+                rominfo->current_internal_crc >> 8, "r+b"); // high byte
 
-  ucon64_fread (buf, SWAN_HEADER_START + 8, 2, dest_name);
-  dumper (stdout, buf, 2, SWAN_HEADER_START + 8, DUMPER_HEX);
+  ucon64_fread (buf, SWAN_HEADER_START (ucon64.fsize) + 8, 2, dest_name);
+  dumper (stdout, buf, 2, SWAN_HEADER_START (ucon64.fsize) + 8, DUMPER_HEX);
 
   printf (ucon64_msg[WROTE], dest_name);
   return 0;
@@ -129,8 +137,9 @@ swan_chk (st_ucon64_nfo_t *rominfo)
   10 - ?? (SUN003)
 */
 int
-swan_init (st_ucon64_nfo_t *rominfo)
+swan_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_swan_data_t *cd = swan_data (p);
   int result = -1;
   unsigned char *rom_buffer, buf[MAXBUFSIZE];
 #define SWAN_MAKER_MAX 0x30
@@ -148,46 +157,47 @@ swan_init (st_ucon64_nfo_t *rominfo)
       "NMC", NULL, NULL
     };
 
-  rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                 ucon64.backup_header_len : 0;
+  rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                 p->backup_header_len : 0;
 
-  ucon64_fread (&swan_header, SWAN_HEADER_START + rominfo->backup_header_len,
-                SWAN_HEADER_LEN, ucon64.fname);
+  ucon64_fread (&cd->header,
+                SWAN_HEADER_START (p->fsize) + rominfo->backup_header_len,
+                SWAN_HEADER_LEN, p->fname);
 
-  rominfo->header = &swan_header;
-  rominfo->header_start = (int) SWAN_HEADER_START;
+  rominfo->header = &cd->header;
+  rominfo->header_start = (int) SWAN_HEADER_START (p->fsize);
   rominfo->header_len = SWAN_HEADER_LEN;
 
   // ROM maker
-  rominfo->maker = NULL_TO_UNKNOWN_S (swan_maker[MIN (OFFSET (swan_header, 0),
+  rominfo->maker = NULL_TO_UNKNOWN_S (swan_maker[MIN (OFFSET (cd->header, 0),
                                       SWAN_MAKER_MAX - 1)]);
 
   // misc stuff
   sprintf ((char *) buf, "Minimum supported system: %s",
-           (!OFFSET (swan_header, 1) ? "WS Monochrome" : "WS Color"));
+           (!OFFSET (cd->header, 1) ? "WS Monochrome" : "WS Color"));
   strcat (rominfo->misc, (char *) buf);
 
-  if ((rom_buffer = (unsigned char *) malloc ((size_t) ucon64.fsize)) == NULL)
+  if ((rom_buffer = (unsigned char *) malloc ((size_t) p->fsize)) == NULL)
     {
-      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], (unsigned) ucon64.fsize);
+      fprintf (stderr, ucon64_msg[ROM_BUFFER_ERROR], (unsigned) p->fsize);
       return -1;
     }
-  ucon64_fread (rom_buffer, 0, (size_t) ucon64.fsize, ucon64.fname);
+  ucon64_fread (rom_buffer, 0, (size_t) p->fsize, p->fname);
 
   rominfo->has_internal_crc = 1;
   rominfo->internal_crc_len = 2;
 
-  if (ucon64.fsize > 10)                        // header itself is already 10 bytes
+  if (p->fsize > 10)                            // header itself is already 10 bytes
     {
-      rominfo->current_internal_crc = swan_chksum (rom_buffer);
-      rominfo->internal_crc = OFFSET (swan_header, 8);          // low byte of checksum
-      rominfo->internal_crc += OFFSET (swan_header, 9) << 8;    // high byte of checksum
+      rominfo->current_internal_crc = swan_chksum (p, rom_buffer);
+      rominfo->internal_crc = OFFSET (cd->header, 8);          // low byte of checksum
+      rominfo->internal_crc += OFFSET (cd->header, 9) << 8;    // high byte of checksum
       if (rominfo->current_internal_crc == rominfo->internal_crc)
         result = 0;
       else
         result = -1;
     }
-  if (ucon64.console == UCON64_SWAN)
+  if (p->console == UCON64_SWAN)
     result = 0;
 
   rominfo->console_usage = swan_usage[0].help;
@@ -199,14 +209,14 @@ swan_init (st_ucon64_nfo_t *rominfo)
 
 
 static int
-swan_chksum (unsigned char *ptr)
+swan_chksum (st_ucon64_t *p, unsigned char *ptr)
 {
   unsigned int csum = 0, t;
 
-  if (ucon64.fsize % 4)
+  if (p->fsize % 4)
     return -1;
 
-  t = (unsigned int) ucon64.fsize - 2;
+  t = (unsigned int) p->fsize - 2;
   while (t-- > 0)
     csum += *ptr++;
 
@@ -27,7 +27,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 extern const st_getopt2_t swan_usage[];
 
-extern int swan_init (st_ucon64_nfo_t *rominfo);
+extern int swan_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo);
 extern int swan_chk (st_ucon64_nfo_t *rominfo);
 
 #endif
@@ -69,48 +69,58 @@ typedef struct st_vboy_header
 } st_vboy_header_t;
 
 #define VBOY_HEADER_LEN (sizeof (st_vboy_header_t))
-#define VBOY_HEADER_START (ucon64.fsize - (VBOY_HEADER_LEN + 512))
+#define VBOY_HEADER_START(fsize) ((fsize) - (VBOY_HEADER_LEN + 512))
+
+// per-ROM state of this file, one per st_ucon64_t (see ucon64_console_data())
+typedef struct
+{
+  st_vboy_header_t header;
+} st_vboy_data_t;
+#define vboy_data(p) ((st_vboy_data_t *) \
+  ucon64_console_data (p, UCON64_VBOY, sizeof (st_vboy_data_t)))
 
 
 int
-vboy_init (st_ucon64_nfo_t *rominfo)
+vboy_init (st_ucon64_t *p, st_ucon64_nfo_t *rominfo)
 {
+  st_vboy_data_t *cd = vboy_data (p);
   int result = -1;
-  static st_vboy_header_t vboy_header;
 
   rominfo->console_usage = vboy_usage[0].help;
   rominfo->backup_usage = unknown_backup_usage[0].help;
 
   // It's correct to use VBOY_HEADER_START (a macro, not a constant), because
   //  the header is located at a constant offset relative to the end of the file
-  //  (no need to use ucon64.backup_header_len).
-  ucon64_fread (&vboy_header, VBOY_HEADER_START, VBOY_HEADER_LEN, ucon64.fname);
+  //  (no need to use p->backup_header_len).
+  ucon64_fread (&cd->header, VBOY_HEADER_START (p->fsize), VBOY_HEADER_LEN,
+                p->fname);
 
-  if (ucon64.console == UCON64_VBOY)
+  if (p->console == UCON64_VBOY)
     {
       int value = 0;
 
       result = 0;
 
-      rominfo->backup_header_len = UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
-                                     ucon64.backup_header_len : 0;
+      rominfo->backup_header_len = UCON64_ISSET2 (p->backup_header_len, unsigned int) ?
+                                     p->backup_header_len : 0;
 
-      rominfo->header_start = (int) (VBOY_HEADER_START - rominfo->backup_header_len);
+      rominfo->header_start = (int) (VBOY_HEADER_START (p->fsize) -
+                                      rominfo->backup_header_len);
       if (rominfo->header_start < 0)
         rominfo->header_start = 0;
       rominfo->header_len = VBOY_HEADER_LEN;
-      rominfo->header = &vboy_header;
+      rominfo->header = &cd->header;
 
       // internal ROM name
-      strncpy (rominfo->name, vboy_header.name, VBOY_NAME_LEN);
+      strncpy (rominfo->name, cd->header.name, VBOY_NAME_LEN);
       rominfo->name[VBOY_NAME_LEN] = '\0';
 
       // ROM maker
       {
-        int ih = vboy_header.maker_high <= '9' ?
-                   vboy_header.maker_high - '0' : vboy_header.maker_high - 'A' + 10,
-            il = vboy_header.maker_low <= '9' ?
-                   vboy_header.maker_low - '0' : vboy_header.maker_low - 'A' + 10;
+        int ih = cd->header.maker_high <= '9' ?
+                   cd->header.maker_high - '0' : cd->header.maker_high - 'A' + 10,
+            il = cd->header.maker_low <= '9' ?
+                   cd->header.maker_low - '0' : cd->header.maker_low - 'A' + 10;
         value = ih * 36 + il;
       }
       if (value < 0 || value >= NINTENDO_MAKER_LEN)
@@ -119,24 +129,24 @@ vboy_init (st_ucon64_nfo_t *rominfo)
 
       // ROM country
       rominfo->country =
-        (vboy_header.game_id_country == 'J') ? "Japan/Asia" :
-        (vboy_header.game_id_country == 'E') ? "U.S.A." :
-        (vboy_header.game_id_country == 'P') ? "Europe, Australia and Africa" :
+        (cd->header.game_id_country == 'J') ? "Japan/Asia" :
+        (cd->header.game_id_country == 'E') ? "U.S.A." :
+        (cd->header.game_id_country == 'P') ? "Europe, Australia and Africa" :
         "Unknown country";
 
       // misc stuff
       {
         size_t n;
 
-        for (n = 0; n < sizeof vboy_header.id; n++)
-          if (vboy_header.id[n] == '\0')
-            vboy_header.id[n] = '.';
+        for (n = 0; n < sizeof cd->header.id; n++)
+          if (cd->header.id[n] == '\0')
+            cd->header.id[n] = '.';
       }
       sprintf (rominfo->misc,
                "ID: %c%c%c%c\n"
                "Version: v1.%u",
-               vboy_header.id[0], vboy_header.id[1], vboy_header.id[2],
-               vboy_header.game_id_country, vboy_header.version);
+               cd->header.id[0], cd->header.id[1], cd->header.id[2],
+               cd->header.game_id_country, cd->header.version);
     }
 
   return result;
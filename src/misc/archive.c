@@ -53,6 +53,11 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define MAXBUFSIZE 32768
 
 
+typedef enum { FM_NORMAL, FM_GZIP, FM_ZIP, FM_CACHE, FM_UNDEF } fmode2_t;
+
+static int zcache_get_size (const char *filename, fmode2_t fmode, uint64_t *size);
+
+
 uint64_t
 fsizeof (const char *filename)
 // If USE_ZLIB is defined this function is very slow. Please avoid to use
@@ -78,6 +83,11 @@ fsizeof (const char *filename)
   if (magic[0] == 0x1f && magic[1] == 0x8b && magic[2] == 0x08)
     {                                   // ID1, ID2 and CM. gzip uses Compression Method 8
       z_off64_t size;
+      uint64_t cached_size;
+
+      // decompressing the data into the cache makes subsequent reads fast
+      if (!zcache_get_size (filename, FM_GZIP, &cached_size))
+        return cached_size;
 
       // shouldn't fail because we could open it with fopen()
       if ((file = (FILE *) gzopen (filename, "rb")) == NULL)
@@ -166,20 +176,66 @@ fsizeof (const char *filename)
 */
 static st_map_t *fh_map = NULL;                 // associative array: file handle -> file mode
 
-typedef enum { FM_NORMAL, FM_GZIP, FM_ZIP, FM_UNDEF } fmode2_t;
-
 typedef struct st_finfo
 {
   fmode2_t fmode;
   int compressed;
 } st_finfo_t;
 
-static st_finfo_t finfo_list[6] = { {FM_NORMAL, 0},
+static st_finfo_t finfo_list[8] = { {FM_NORMAL, 0},
                                     {FM_NORMAL, 1},     // should never be used
                                     {FM_GZIP, 0},
                                     {FM_GZIP, 1},
                                     {FM_ZIP, 0},        // should never be used
-                                    {FM_ZIP, 1} };
+                                    {FM_ZIP, 1},
+                                    {FM_CACHE, 0},      // should never be used
+                                    {FM_CACHE, 1} };
+
+/*
+  Cache of decompressed archive entries. Reading from a gzip or zip file
+  through zlib is sequential, so every backward seek means inflating the data
+  from the start again and SEEK_END means inflating everything. The <console>_
+  init() functions do many small reads at various offsets, which made probing
+  a compressed ROM very slow. So, when a compressed file is opened for reading
+  we inflate the requested entry once and serve all subsequent fopen2() calls
+  on the same (archive, entry) pair from memory. An entry is invalidated when
+  the modification time or size of the archive changes or when the archive is
+  opened for writing. The total size of the cache is limited to
+  ZCACHE_MAX_SIZE bytes. Entries that don't fit are read the old way.
+*/
+#define ZCACHE_MAX_SIZE (128 * 1024 * 1024)
+
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct st_zcache_entry
+{
+  char *fname;                                  // name of the archive
+  ZPOS64_T file_nr;                             // entry in the archive (always 0 for gzip)
+  time_t mtime;                                 // modification time of the archive
+  int64_t archive_size;                         // (compressed) size of the archive
+  unsigned char *data;                          // decompressed data
+  uint64_t size;                                // size of the decompressed data
+  int refs;                                     // number of open handles
+  int stale;                                    // free when refs drops to 0
+  unsigned long last_use;
+  struct st_zcache_entry *next;
+} st_zcache_entry_t;
+
+typedef struct st_zcache_file
+{
+  st_zcache_entry_t *entry;
+  uint64_t pos;
+  int eof;
+} st_zcache_file_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+static st_zcache_entry_t *zcache = NULL;
+static uint64_t zcache_size = 0;
+static unsigned long zcache_clock = 0, zcache_hits = 0, zcache_misses = 0;
 
 ZPOS64_T unzip_current_file_nr = 0;
 
@@ -292,6 +348,300 @@ unzip_seek_helper (FILE *file, ZPOS64_T offset)
 }
 
 
+static int
+zcache_stat (const char *filename, time_t *mtime, int64_t *size)
+{
+#ifdef  _WIN32
+  struct _stati64 fstate;
+  if (_stati64 (filename, &fstate))
+#else
+  struct stat fstate;
+  if (stat (filename, &fstate))
+#endif
+    return -1;
+  *mtime = fstate.st_mtime;
+  *size = fstate.st_size;
+  return 0;
+}
+
+
+static void
+zcache_free_entry (st_zcache_entry_t *entry)
+{
+  zcache_size -= entry->size;
+  free (entry->data);
+  free (entry->fname);
+  free (entry);
+}
+
+
+static void
+zcache_unlink (st_zcache_entry_t *entry)
+// removes entry from the cache list and frees it if it is not in use
+{
+  st_zcache_entry_t **p = &zcache;
+
+  while (*p && *p != entry)
+    p = &(*p)->next;
+  if (*p)
+    *p = entry->next;
+  if (entry->refs == 0)
+    zcache_free_entry (entry);
+  else
+    entry->stale = 1;
+}
+
+
+static void
+zcache_invalidate (const char *filename)
+{
+  st_zcache_entry_t *entry = zcache, *next;
+
+  for (; entry; entry = next)
+    {
+      next = entry->next;
+      if (!strcmp (entry->fname, filename))
+        zcache_unlink (entry);
+    }
+}
+
+
+static int
+zcache_make_room (uint64_t size)
+// evicts least recently used entries that are not in use until size bytes fit
+{
+  while (zcache_size + size > ZCACHE_MAX_SIZE)
+    {
+      st_zcache_entry_t *entry = zcache, *lru = NULL;
+
+      for (; entry; entry = entry->next)
+        if (entry->refs == 0 && (lru == NULL || entry->last_use < lru->last_use))
+          lru = entry;
+      if (lru == NULL)
+        return -1;
+      zcache_unlink (lru);
+    }
+  return 0;
+}
+
+
+static unsigned char *
+zcache_inflate_gzip (const char *filename, uint64_t *size)
+{
+  FILE *file;
+  unsigned char *data = NULL, trailer[4];
+  uint64_t alloc_size = MAXBUFSIZE, len = 0;
+  int n;
+
+#undef  fopen
+#undef  fseek
+#undef  fread
+#undef  fclose
+  // ISIZE (the last 4 bytes of a gzip file) is the size of the uncompressed
+  //  data modulo 2^32, which is a good estimate of how much to allocate
+  if ((file = fopen (filename, "rb")) != NULL)
+    {
+      if (!fseek (file, -4, SEEK_END) && fread (trailer, 1, 4, file) == 4)
+        alloc_size = trailer[0] | trailer[1] << 8 | trailer[2] << 16 |
+                     (uint64_t) trailer[3] << 24;
+      fclose (file);
+    }
+#define fopen   fopen2
+#define fseek   fseek2
+#define fclose  fclose2
+#define fread   fread2
+  if (alloc_size > ZCACHE_MAX_SIZE)
+    return NULL;
+  alloc_size += MAXBUFSIZE;                     // avoids a realloc() at the end
+
+  if ((file = (FILE *) gzopen (filename, "rb")) == NULL)
+    return NULL;
+  if ((data = (unsigned char *) malloc ((size_t) alloc_size)) == NULL)
+    {
+      gzclose ((gzFile) file);
+      return NULL;
+    }
+  while ((n = gzread ((gzFile) file, data + len, (unsigned int)
+                        (alloc_size - len > MAXBUFSIZE ? MAXBUFSIZE : alloc_size - len))) > 0)
+    {
+      len += n;
+      if (len == alloc_size)
+        {
+          unsigned char *tmp;
+
+          alloc_size *= 2;
+          if (alloc_size > ZCACHE_MAX_SIZE ||
+              (tmp = (unsigned char *) realloc (data, (size_t) alloc_size)) == NULL)
+            {
+              n = -1;
+              break;
+            }
+          data = tmp;
+        }
+    }
+  gzclose ((gzFile) file);
+  if (n < 0)
+    {
+      free (data);
+      return NULL;
+    }
+  *size = len;
+  return data;
+}
+
+
+static unsigned char *
+zcache_inflate_zip (const char *filename, uint64_t *size)
+{
+  unzFile file;
+  unz_file_info64 info;
+  unsigned char *data;
+  uint64_t len = 0;
+  int n = 0;
+
+  if ((file = unzOpen (filename)) == NULL)
+    return NULL;
+  if (unzip_goto_file (file, unzip_current_file_nr) != UNZ_OK ||
+      unzGetCurrentFileInfo64 (file, &info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK ||
+      info.uncompressed_size > ZCACHE_MAX_SIZE ||
+      unzOpenCurrentFile (file) != UNZ_OK)
+    {
+      unzClose (file);
+      return NULL;
+    }
+  // allocate at least 1 byte, so that empty entries can be cached as well
+  if ((data = (unsigned char *) malloc ((size_t) info.uncompressed_size + 1)) == NULL)
+    {
+      unzCloseCurrentFile (file);
+      unzClose (file);
+      return NULL;
+    }
+  while (len < info.uncompressed_size &&
+         (n = unzReadCurrentFile (file, data + len, (unsigned int)
+                (info.uncompressed_size - len > MAXBUFSIZE ?
+                   MAXBUFSIZE : info.uncompressed_size - len))) > 0)
+    len += n;
+  if (unzCloseCurrentFile (file) != UNZ_OK) // checks the CRC32 of the entry
+    n = -1;
+  unzClose (file);
+  if (n < 0 || len != info.uncompressed_size)
+    {
+      free (data);
+      return NULL;
+    }
+  *size = len;
+  return data;
+}
+
+
+static st_zcache_entry_t *
+zcache_get (const char *filename, fmode2_t fmode)
+/*
+  Returns the cache entry of the current entry of archive filename. The data is
+  decompressed if it is not (or no longer) present. Returns NULL if the data
+  could not be decompressed or does not fit in the cache.
+*/
+{
+  st_zcache_entry_t *entry, *next;
+  ZPOS64_T file_nr = fmode == FM_ZIP ? unzip_current_file_nr : 0;
+  time_t mtime;
+  int64_t archive_size;
+  uint64_t size;
+  unsigned char *data;
+
+  if (zcache_stat (filename, &mtime, &archive_size))
+    return NULL;
+
+  for (entry = zcache; entry; entry = next)
+    {
+      next = entry->next;
+      if (entry->file_nr == file_nr && !strcmp (entry->fname, filename))
+        {
+          if (entry->mtime == mtime && entry->archive_size == archive_size)
+            {
+              zcache_hits++;
+              entry->last_use = ++zcache_clock;
+              return entry;
+            }
+          zcache_unlink (entry);                // archive was modified
+        }
+    }
+
+  zcache_misses++;
+  data = fmode == FM_ZIP ?
+           zcache_inflate_zip (filename, &size) : zcache_inflate_gzip (filename, &size);
+  if (data == NULL)
+    return NULL;
+  if (zcache_make_room (size) ||
+      (entry = (st_zcache_entry_t *) malloc (sizeof (st_zcache_entry_t))) == NULL)
+    {
+      free (data);
+      return NULL;
+    }
+  if ((entry->fname = strdup (filename)) == NULL)
+    {
+      free (entry);
+      free (data);
+      return NULL;
+    }
+  entry->file_nr = file_nr;
+  entry->mtime = mtime;
+  entry->archive_size = archive_size;
+  entry->data = data;
+  entry->size = size;
+  entry->refs = 0;
+  entry->stale = 0;
+  entry->last_use = ++zcache_clock;
+  entry->next = zcache;
+  zcache = entry;
+  zcache_size += size;
+  return entry;
+}
+
+
+static int
+zcache_get_size (const char *filename, fmode2_t fmode, uint64_t *size)
+{
+  st_zcache_entry_t *entry = zcache_get (filename, fmode);
+
+  if (entry == NULL)
+    return -1;
+  *size = entry->size;
+  return 0;
+}
+
+
+const unsigned char *
+archive_get_data (FILE *file, uint64_t *size)
+{
+  st_zcache_file_t *cfile;
+
+  if (get_finfo (file)->fmode != FM_CACHE)
+    return NULL;
+  cfile = (st_zcache_file_t *) file;
+  *size = cfile->entry->size;
+  return cfile->entry->data;
+}
+
+
+void
+archive_cache_stats (FILE *output)
+{
+  fprintf (output, "Archive cache: %lu hit%s, %lu miss%s, %u bytes in use\n",
+           zcache_hits, zcache_hits != 1 ? "s" : "",
+           zcache_misses, zcache_misses != 1 ? "es" : "",
+           (unsigned int) zcache_size);
+}
+
+
+void
+archive_cache_flush (void)
+{
+  while (zcache)
+    zcache_unlink (zcache);
+}
+
+
 FILE *
 fopen2 (const char *filename, const char *mode)
 {
@@ -371,7 +721,28 @@ fopen2 (const char *filename, const char *mode)
 #define fclose  fclose2
     }
 
-  if (fmode == FM_GZIP)
+  if (compressed)
+    {
+      st_zcache_entry_t *entry;
+      st_zcache_file_t *cfile;
+
+      if ((entry = zcache_get (filename, fmode)) != NULL &&
+          (cfile = (st_zcache_file_t *) malloc (sizeof (st_zcache_file_t))) != NULL)
+        {
+          entry->refs++;
+          cfile->entry = entry;
+          cfile->pos = 0;
+          cfile->eof = 0;
+          file = (FILE *) cfile;
+          fmode = FM_CACHE;
+        }
+    }
+  else
+    zcache_invalidate (filename);               // file will be (over)written
+
+  if (fmode == FM_CACHE)
+    ;
+  else if (fmode == FM_GZIP)
     file = (FILE *) gzopen (filename, mode);
   else if (fmode == FM_ZIP)
     {
@@ -421,6 +792,15 @@ fclose2 (FILE *file)
       unzCloseCurrentFile (file);
       return unzClose (file);
     }
+  else if (fmode == FM_CACHE)
+    {
+      st_zcache_entry_t *entry = ((st_zcache_file_t *) file)->entry;
+
+      if (--entry->refs == 0 && entry->stale)
+        zcache_free_entry (entry);
+      free (file);
+      return 0;
+    }
   else
     return EOF;
 #define fclose  fclose2
@@ -502,6 +882,31 @@ fseeko2 (FILE *file, int64_t offset, int mode)
         }
       return unzip_seek_helper (file, base + offset);
     }
+  else if (fmode == FM_CACHE)
+    {
+      st_zcache_file_t *cfile = (st_zcache_file_t *) file;
+      int64_t base;
+
+      if (mode == SEEK_SET)
+        base = 0;
+      else if (mode == SEEK_CUR)
+        base = cfile->pos;
+      else if (mode == SEEK_END)
+        base = cfile->entry->size;
+      else
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      if (base + offset < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      cfile->pos = base + offset;
+      cfile->eof = 0;
+      return 0;
+    }
   return -1;
 }
 
@@ -531,6 +936,20 @@ fread2 (void *buffer, size_t size, size_t number, FILE *file)
         n = 0;
       return n / size;
     }
+  else if (fmode == FM_CACHE)
+    {
+      st_zcache_file_t *cfile = (st_zcache_file_t *) file;
+      uint64_t n = cfile->pos < cfile->entry->size ?
+                     cfile->entry->size - cfile->pos : 0;
+
+      if (n >= number * size)
+        n = number * size;
+      else
+        cfile->eof = 1;
+      memcpy (buffer, cfile->entry->data + cfile->pos, (size_t) n);
+      cfile->pos += n;
+      return (size_t) n / size;
+    }
   return 0;
 #define fread   fread2
 }
@@ -552,6 +971,17 @@ fgetc2 (FILE *file)
       return unzReadCurrentFile (file, &c, 1) <= 0 ?
                EOF : c & 0xff;                  // avoid sign bit extension
     }
+  else if (fmode == FM_CACHE)
+    {
+      st_zcache_file_t *cfile = (st_zcache_file_t *) file;
+
+      if (cfile->pos >= cfile->entry->size)
+        {
+          cfile->eof = 1;
+          return EOF;
+        }
+      return cfile->entry->data[cfile->pos++];
+    }
   else
     return EOF;
 #define fgetc   fgetc2
@@ -571,7 +1001,7 @@ fgets2 (char *buffer, int maxlength, FILE *file)
       char *retval = gzgets ((gzFile) file, buffer, maxlength);
       return retval == Z_NULL ? NULL : retval;
     }
-  else if (fmode == FM_ZIP)
+  else if (fmode == FM_ZIP || fmode == FM_CACHE)
     {
       int n = 0, c = 0;
       while (n < maxlength - 1 && (c = fgetc (file)) != EOF)
@@ -606,6 +1036,8 @@ feof2 (FILE *file)
     return gzeof ((gzFile) file);
   else if (fmode == FM_ZIP)
     return unzeof (file);
+  else if (fmode == FM_CACHE)
+    return ((st_zcache_file_t *) file)->eof;
   else
     return -1;
 #define feof    feof2
@@ -680,6 +1112,8 @@ ftello2 (FILE *file)
 #endif
   else if (fmode == FM_ZIP)
     return unztell64 (file);                    // returns file position of the "current file"
+  else if (fmode == FM_CACHE)
+    return ((st_zcache_file_t *) file)->pos;
   else
     return -1;
 }
@@ -93,6 +93,18 @@ extern uint64_t fsizeof (const char *filename);
 extern ZPOS64_T unzip_get_number_entries (const char *filename);
 extern int unzip_goto_file (unzFile file, ZPOS64_T file_index);
 extern ZPOS64_T unzip_current_file_nr;
+
+/*
+  archive_get_data()    returns the decompressed data of file if it was opened
+                          from the cache, otherwise NULL. The data stays valid
+                          until file is closed
+  archive_cache_stats() display the number of hits and misses of the cache of
+                          decompressed archive entries
+  archive_cache_flush() free all (unused) entries of the cache
+*/
+extern const unsigned char *archive_get_data (FILE *file, uint64_t *size);
+extern void archive_cache_stats (FILE *output);
+extern void archive_cache_flush (void);
 #endif // USE_ZLIB
 
 #ifdef  __cplusplus
@@ -35,10 +35,25 @@ MD5  - Copyright (C) 1990, RSA Data Security, Inc. All rights reserved.
 #pragma warning(push)
 #pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
 #endif
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
+#ifdef  USE_ZLIB
+#include <zlib.h>
+#endif
+#if     defined __GNUC__ && (__GNUC__ >= 5 || defined __clang__) && \
+        (defined __x86_64__ || defined __i386__)
+#define CHKSUM_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#ifndef USE_ZLIB
+#define CRC32_PCLMUL 1
+#endif
+#endif
 #include "misc/bswap.h"
 #include "misc/chksum.h"
 #include "misc/misc.h"
@@ -82,12 +97,27 @@ MD5  - Copyright (C) 1990, RSA Data Security, Inc. All rights reserved.
 
 
 #define ROTL32(x,n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
 
 #define SHA1_BLOCK_SIZE  64
 #define SHA1_DIGEST_SIZE 20
 #define SHA2_GOOD         0
 #define SHA2_BAD          1
 #define SHA1_MASK (SHA1_BLOCK_SIZE - 1)
+#define SHA256_BLOCK_SIZE  64
+#define SHA256_DIGEST_SIZE 32
+
+
+/*
+  The block functions of SHA1 and SHA-256 are chosen once, by
+  chksum_select_kernels(). On x86 CPUs with the SHA extensions these are
+  sha1_blocks_shani() and sha256_blocks_shani(), else the portable C code.
+*/
+static void (*sha1_blocks) (s_sha1_ctx_t ctx[1], const unsigned char *data,
+                            size_t n) = NULL;
+static void (*sha256_blocks) (s_sha256_ctx_t ctx[1], const unsigned char *data,
+                              size_t n) = NULL;
+static void chksum_select_kernels (void);
 
 
 void
@@ -142,9 +172,206 @@ sha1_compile (s_sha1_ctx_t ctx[1])
 }
 
 
+static void
+sha1_blocks_c (s_sha1_ctx_t ctx[1], const unsigned char *data, size_t n)
+{
+  for (; n; n--, data += SHA1_BLOCK_SIZE)
+    {
+      memcpy (ctx->wbuf, data, SHA1_BLOCK_SIZE);
+      sha1_compile (ctx);
+    }
+}
+
+
+#ifdef  CHKSUM_X86
+__attribute__ ((target ("sha,ssse3,sse4.1")))
+static void
+sha1_blocks_shani (s_sha1_ctx_t ctx[1], const unsigned char *data, size_t n)
+// Intel SHA extensions, 4 rounds per instruction
+{
+  const __m128i bswap_mask = _mm_set_epi64x (0x0001020304050607LL,
+                                             0x08090a0b0c0d0e0fLL);
+  __m128i abcd, abcd_save, e0, e0_save, e1, msg0, msg1, msg2, msg3;
+
+  abcd = _mm_shuffle_epi32 (_mm_loadu_si128 ((__m128i *) ctx->hash), 0x1b);
+  e0 = _mm_set_epi32 ((int) ctx->hash[4], 0, 0, 0);
+
+  for (; n; n--, data += SHA1_BLOCK_SIZE)
+    {
+      abcd_save = abcd;
+      e0_save = e0;
+
+      // rounds 0-3
+      msg0 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 0)),
+                               bswap_mask);
+      e0 = _mm_add_epi32 (e0, msg0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 0);
+
+      // rounds 4-7
+      msg1 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 16)),
+                               bswap_mask);
+      e1 = _mm_sha1nexte_epu32 (e1, msg1);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 0);
+      msg0 = _mm_sha1msg1_epu32 (msg0, msg1);
+
+      // rounds 8-11
+      msg2 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 32)),
+                               bswap_mask);
+      e0 = _mm_sha1nexte_epu32 (e0, msg2);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 0);
+      msg1 = _mm_sha1msg1_epu32 (msg1, msg2);
+      msg0 = _mm_xor_si128 (msg0, msg2);
+
+      // rounds 12-15
+      msg3 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 48)),
+                               bswap_mask);
+      e1 = _mm_sha1nexte_epu32 (e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32 (msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 0);
+      msg2 = _mm_sha1msg1_epu32 (msg2, msg3);
+      msg1 = _mm_xor_si128 (msg1, msg3);
+
+      // rounds 16-19
+      e0 = _mm_sha1nexte_epu32 (e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32 (msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 0);
+      msg3 = _mm_sha1msg1_epu32 (msg3, msg0);
+      msg2 = _mm_xor_si128 (msg2, msg0);
+
+      // rounds 20-23
+      e1 = _mm_sha1nexte_epu32 (e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32 (msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 1);
+      msg0 = _mm_sha1msg1_epu32 (msg0, msg1);
+      msg3 = _mm_xor_si128 (msg3, msg1);
+
+      // rounds 24-27
+      e0 = _mm_sha1nexte_epu32 (e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32 (msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 1);
+      msg1 = _mm_sha1msg1_epu32 (msg1, msg2);
+      msg0 = _mm_xor_si128 (msg0, msg2);
+
+      // rounds 28-31
+      e1 = _mm_sha1nexte_epu32 (e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32 (msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 1);
+      msg2 = _mm_sha1msg1_epu32 (msg2, msg3);
+      msg1 = _mm_xor_si128 (msg1, msg3);
+
+      // rounds 32-35
+      e0 = _mm_sha1nexte_epu32 (e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32 (msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 1);
+      msg3 = _mm_sha1msg1_epu32 (msg3, msg0);
+      msg2 = _mm_xor_si128 (msg2, msg0);
+
+      // rounds 36-39
+      e1 = _mm_sha1nexte_epu32 (e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32 (msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 1);
+      msg0 = _mm_sha1msg1_epu32 (msg0, msg1);
+      msg3 = _mm_xor_si128 (msg3, msg1);
+
+      // rounds 40-43
+      e0 = _mm_sha1nexte_epu32 (e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32 (msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 2);
+      msg1 = _mm_sha1msg1_epu32 (msg1, msg2);
+      msg0 = _mm_xor_si128 (msg0, msg2);
+
+      // rounds 44-47
+      e1 = _mm_sha1nexte_epu32 (e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32 (msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 2);
+      msg2 = _mm_sha1msg1_epu32 (msg2, msg3);
+      msg1 = _mm_xor_si128 (msg1, msg3);
+
+      // rounds 48-51
+      e0 = _mm_sha1nexte_epu32 (e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32 (msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 2);
+      msg3 = _mm_sha1msg1_epu32 (msg3, msg0);
+      msg2 = _mm_xor_si128 (msg2, msg0);
+
+      // rounds 52-55
+      e1 = _mm_sha1nexte_epu32 (e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32 (msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 2);
+      msg0 = _mm_sha1msg1_epu32 (msg0, msg1);
+      msg3 = _mm_xor_si128 (msg3, msg1);
+
+      // rounds 56-59
+      e0 = _mm_sha1nexte_epu32 (e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32 (msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 2);
+      msg1 = _mm_sha1msg1_epu32 (msg1, msg2);
+      msg0 = _mm_xor_si128 (msg0, msg2);
+
+      // rounds 60-63
+      e1 = _mm_sha1nexte_epu32 (e1, msg3);
+      e0 = abcd;
+      msg0 = _mm_sha1msg2_epu32 (msg0, msg3);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 3);
+      msg2 = _mm_sha1msg1_epu32 (msg2, msg3);
+      msg1 = _mm_xor_si128 (msg1, msg3);
+
+      // rounds 64-67
+      e0 = _mm_sha1nexte_epu32 (e0, msg0);
+      e1 = abcd;
+      msg1 = _mm_sha1msg2_epu32 (msg1, msg0);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 3);
+      msg3 = _mm_sha1msg1_epu32 (msg3, msg0);
+      msg2 = _mm_xor_si128 (msg2, msg0);
+
+      // rounds 68-71
+      e1 = _mm_sha1nexte_epu32 (e1, msg1);
+      e0 = abcd;
+      msg2 = _mm_sha1msg2_epu32 (msg2, msg1);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 3);
+      msg3 = _mm_xor_si128 (msg3, msg1);
+
+      // rounds 72-75
+      e0 = _mm_sha1nexte_epu32 (e0, msg2);
+      e1 = abcd;
+      msg3 = _mm_sha1msg2_epu32 (msg3, msg2);
+      abcd = _mm_sha1rnds4_epu32 (abcd, e0, 3);
+
+      // rounds 76-79
+      e1 = _mm_sha1nexte_epu32 (e1, msg3);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32 (abcd, e1, 3);
+
+      e0 = _mm_sha1nexte_epu32 (e0, e0_save);
+      abcd = _mm_add_epi32 (abcd, abcd_save);
+    }
+
+  _mm_storeu_si128 ((__m128i *) ctx->hash, _mm_shuffle_epi32 (abcd, 0x1b));
+  ctx->hash[4] = (uint32_t) _mm_extract_epi32 (e0, 3);
+}
+#endif // CHKSUM_X86
+
+
 void
 sha1_begin (s_sha1_ctx_t ctx[1])
 {
+  if (!sha1_blocks)
+    chksum_select_kernels ();
   ctx->count[0] = ctx->count[1] = 0;
   ctx->hash[0] = 0x67452301;
   ctx->hash[1] = 0xefcdab89;
@@ -166,6 +393,15 @@ sha1 (s_sha1_ctx_t ctx[1], const unsigned char data[], unsigned int len)
 
   while (len >= space)                  // transfer whole blocks while possible
     {
+      if (pos == 0)                     // hash whole blocks in place
+        {
+          size_t n = len / SHA1_BLOCK_SIZE;
+
+          sha1_blocks (ctx, sp, n);
+          sp += n * SHA1_BLOCK_SIZE;
+          len -= (unsigned int) (n * SHA1_BLOCK_SIZE);
+          break;
+        }
       memcpy (((unsigned char *) ctx->wbuf) + pos, sp, space);
       sp += space;
       len -= space;
@@ -232,6 +468,389 @@ sha1_end (unsigned char hval[], s_sha1_ctx_t ctx[1])
 }
 
 
+static const uint32_t sha256_k[64] =
+  {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+
+
+static void
+sha256_compile (s_sha256_ctx_t ctx[1])
+{
+#define SHA256_S0(x) (ROTR32 (x, 2) ^ ROTR32 (x, 13) ^ ROTR32 (x, 22))
+#define SHA256_S1(x) (ROTR32 (x, 6) ^ ROTR32 (x, 11) ^ ROTR32 (x, 25))
+#define SHA256_G0(x) (ROTR32 (x, 7) ^ ROTR32 (x, 18) ^ ((x) >> 3))
+#define SHA256_G1(x) (ROTR32 (x, 17) ^ ROTR32 (x, 19) ^ ((x) >> 10))
+
+  uint32_t w[64], i, a, b, c, d, e, f, g, h;
+
+  for (i = 0; i < SHA256_BLOCK_SIZE / 4; ++i)
+    w[i] = me2be_32 (ctx->wbuf[i]);
+
+  for (i = SHA256_BLOCK_SIZE / 4; i < 64; ++i)
+    w[i] = SHA256_G1 (w[i - 2]) + w[i - 7] + SHA256_G0 (w[i - 15]) + w[i - 16];
+
+  a = ctx->hash[0];
+  b = ctx->hash[1];
+  c = ctx->hash[2];
+  d = ctx->hash[3];
+  e = ctx->hash[4];
+  f = ctx->hash[5];
+  g = ctx->hash[6];
+  h = ctx->hash[7];
+
+  for (i = 0; i < 64; i++)
+    {
+      uint32_t t1 = h + SHA256_S1 (e) + CH (e, f, g) + sha256_k[i] + w[i],
+               t2 = SHA256_S0 (a) + MAJ (a, b, c);
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+  ctx->hash[0] += a;
+  ctx->hash[1] += b;
+  ctx->hash[2] += c;
+  ctx->hash[3] += d;
+  ctx->hash[4] += e;
+  ctx->hash[5] += f;
+  ctx->hash[6] += g;
+  ctx->hash[7] += h;
+}
+
+
+static void
+sha256_blocks_c (s_sha256_ctx_t ctx[1], const unsigned char *data, size_t n)
+{
+  for (; n; n--, data += SHA256_BLOCK_SIZE)
+    {
+      memcpy (ctx->wbuf, data, SHA256_BLOCK_SIZE);
+      sha256_compile (ctx);
+    }
+}
+
+
+#ifdef  CHKSUM_X86
+__attribute__ ((target ("sha,ssse3,sse4.1")))
+static void
+sha256_blocks_shani (s_sha256_ctx_t ctx[1], const unsigned char *data, size_t n)
+// Intel SHA extensions, 2 rounds per instruction
+{
+  const __m128i bswap_mask = _mm_set_epi64x (0x0c0d0e0f08090a0bLL,
+                                             0x0405060700010203LL);
+  __m128i state0, state1, abef_save, cdgh_save, msg, tmp, msg0, msg1, msg2,
+          msg3;
+
+  tmp = _mm_shuffle_epi32 (_mm_loadu_si128 ((__m128i *) ctx->hash), 0xb1); // CDAB
+  state1 = _mm_shuffle_epi32 (_mm_loadu_si128 ((__m128i *) (ctx->hash + 4)),
+                              0x1b);                                          // EFGH
+  state0 = _mm_alignr_epi8 (tmp, state1, 8);                                 // ABEF
+  state1 = _mm_blend_epi16 (state1, tmp, 0xf0);                              // CDGH
+
+  for (; n; n--, data += SHA256_BLOCK_SIZE)
+    {
+      abef_save = state0;
+      cdgh_save = state1;
+
+      // rounds 0-3
+      msg0 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 0)),
+                               bswap_mask);
+      msg = _mm_add_epi32 (msg0,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 0)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+
+      // rounds 4-7
+      msg1 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 16)),
+                               bswap_mask);
+      msg = _mm_add_epi32 (msg1,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 4)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg0 = _mm_sha256msg1_epu32 (msg0, msg1);
+
+      // rounds 8-11
+      msg2 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 32)),
+                               bswap_mask);
+      msg = _mm_add_epi32 (msg2,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 8)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg1 = _mm_sha256msg1_epu32 (msg1, msg2);
+
+      // rounds 12-15
+      msg3 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 48)),
+                               bswap_mask);
+      msg = _mm_add_epi32 (msg3,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 12)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg3, msg2, 4);
+      msg0 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg0, tmp), msg3);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg2 = _mm_sha256msg1_epu32 (msg2, msg3);
+
+      // rounds 16-19
+      msg = _mm_add_epi32 (msg0,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 16)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg0, msg3, 4);
+      msg1 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg1, tmp), msg0);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg3 = _mm_sha256msg1_epu32 (msg3, msg0);
+
+      // rounds 20-23
+      msg = _mm_add_epi32 (msg1,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 20)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg1, msg0, 4);
+      msg2 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg2, tmp), msg1);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg0 = _mm_sha256msg1_epu32 (msg0, msg1);
+
+      // rounds 24-27
+      msg = _mm_add_epi32 (msg2,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 24)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg2, msg1, 4);
+      msg3 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg3, tmp), msg2);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg1 = _mm_sha256msg1_epu32 (msg1, msg2);
+
+      // rounds 28-31
+      msg = _mm_add_epi32 (msg3,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 28)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg3, msg2, 4);
+      msg0 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg0, tmp), msg3);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg2 = _mm_sha256msg1_epu32 (msg2, msg3);
+
+      // rounds 32-35
+      msg = _mm_add_epi32 (msg0,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 32)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg0, msg3, 4);
+      msg1 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg1, tmp), msg0);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg3 = _mm_sha256msg1_epu32 (msg3, msg0);
+
+      // rounds 36-39
+      msg = _mm_add_epi32 (msg1,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 36)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg1, msg0, 4);
+      msg2 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg2, tmp), msg1);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg0 = _mm_sha256msg1_epu32 (msg0, msg1);
+
+      // rounds 40-43
+      msg = _mm_add_epi32 (msg2,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 40)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg2, msg1, 4);
+      msg3 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg3, tmp), msg2);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg1 = _mm_sha256msg1_epu32 (msg1, msg2);
+
+      // rounds 44-47
+      msg = _mm_add_epi32 (msg3,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 44)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg3, msg2, 4);
+      msg0 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg0, tmp), msg3);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg2 = _mm_sha256msg1_epu32 (msg2, msg3);
+
+      // rounds 48-51
+      msg = _mm_add_epi32 (msg0,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 48)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg0, msg3, 4);
+      msg1 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg1, tmp), msg0);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+      msg3 = _mm_sha256msg1_epu32 (msg3, msg0);
+
+      // rounds 52-55
+      msg = _mm_add_epi32 (msg1,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 52)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg1, msg0, 4);
+      msg2 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg2, tmp), msg1);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+
+      // rounds 56-59
+      msg = _mm_add_epi32 (msg2,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 56)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      tmp = _mm_alignr_epi8 (msg2, msg1, 4);
+      msg3 = _mm_sha256msg2_epu32 (_mm_add_epi32 (msg3, tmp), msg2);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+
+      // rounds 60-63
+      msg = _mm_add_epi32 (msg3,
+                           _mm_loadu_si128 ((const __m128i *) (sha256_k + 60)));
+      state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+      state0 = _mm_sha256rnds2_epu32 (state0, state1,
+                                      _mm_shuffle_epi32 (msg, 0x0e));
+
+      state0 = _mm_add_epi32 (state0, abef_save);
+      state1 = _mm_add_epi32 (state1, cdgh_save);
+    }
+
+  tmp = _mm_shuffle_epi32 (state0, 0x1b);                                    // FEBA
+  state1 = _mm_shuffle_epi32 (state1, 0xb1);                                 // DCHG
+  _mm_storeu_si128 ((__m128i *) ctx->hash,
+                    _mm_blend_epi16 (tmp, state1, 0xf0));                   // DCBA
+  _mm_storeu_si128 ((__m128i *) (ctx->hash + 4),
+                    _mm_alignr_epi8 (state1, tmp, 8));                      // HGFE
+}
+#endif // CHKSUM_X86
+
+
+#ifdef  CHKSUM_X86
+static int
+chksum_have_shani (void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx) ||
+      !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+    return 0;
+  if (__get_cpuid_max (0, NULL) < 7)
+    return 0;
+  __cpuid_count (7, 0, eax, ebx, ecx, edx);
+  return (ebx & bit_SHA) != 0;
+}
+#endif
+
+
+static void
+chksum_select_kernels (void)
+{
+  sha1_blocks = sha1_blocks_c;
+  sha256_blocks = sha256_blocks_c;
+#ifdef  CHKSUM_X86
+  if (chksum_have_shani ())
+    {
+      sha1_blocks = sha1_blocks_shani;
+      sha256_blocks = sha256_blocks_shani;
+    }
+#endif
+}
+
+
+void
+sha256_begin (s_sha256_ctx_t ctx[1])
+{
+  if (!sha256_blocks)
+    chksum_select_kernels ();
+
+  ctx->count[0] = ctx->count[1] = 0;
+  ctx->hash[0] = 0x6a09e667;
+  ctx->hash[1] = 0xbb67ae85;
+  ctx->hash[2] = 0x3c6ef372;
+  ctx->hash[3] = 0xa54ff53a;
+  ctx->hash[4] = 0x510e527f;
+  ctx->hash[5] = 0x9b05688c;
+  ctx->hash[6] = 0x1f83d9ab;
+  ctx->hash[7] = 0x5be0cd19;
+}
+
+
+void
+sha256 (s_sha256_ctx_t ctx[1], const unsigned char data[], unsigned int len)
+{
+  uint32_t pos = (uint32_t) (ctx->count[0] & (SHA256_BLOCK_SIZE - 1));
+  unsigned char *wbuf = (unsigned char *) ctx->wbuf;
+
+  if ((ctx->count[0] += len) < len)
+    ++(ctx->count[1]);
+
+  if (pos)
+    {
+      uint32_t n = MIN (SHA256_BLOCK_SIZE - pos, len);
+
+      memcpy (wbuf + pos, data, n);
+      data += n;
+      len -= n;
+      if (pos + n < SHA256_BLOCK_SIZE)
+        return;
+      sha256_compile (ctx);
+    }
+
+  if (len >= SHA256_BLOCK_SIZE)
+    {
+      size_t n = len / SHA256_BLOCK_SIZE;
+
+      sha256_blocks (ctx, data, n);
+      data += n * SHA256_BLOCK_SIZE;
+      len -= (unsigned int) (n * SHA256_BLOCK_SIZE);
+    }
+
+  memcpy (wbuf, data, len);
+}
+
+
+void
+sha256_end (unsigned char hval[], s_sha256_ctx_t ctx[1])
+{
+  uint32_t i = (uint32_t) (ctx->count[0] & (SHA256_BLOCK_SIZE - 1));
+  unsigned char *wbuf = (unsigned char *) ctx->wbuf;
+
+  // same padding as SHA1: 0x80, zeroes and the bit count in big-endian format
+  wbuf[i++] = 0x80;
+  if (i > SHA256_BLOCK_SIZE - 8)
+    {
+      memset (wbuf + i, 0, SHA256_BLOCK_SIZE - i);
+      sha256_compile (ctx);
+      i = 0;
+    }
+  memset (wbuf + i, 0, SHA256_BLOCK_SIZE - 8 - i);
+  ctx->wbuf[14] = me2be_32 ((ctx->count[1] << 3) | (ctx->count[0] >> 29));
+  ctx->wbuf[15] = me2be_32 (ctx->count[0] << 3);
+
+  sha256_compile (ctx);
+
+  for (i = 0; i < SHA256_DIGEST_SIZE; ++i)
+    hval[i] = (unsigned char) (ctx->hash[i >> 2] >> 8 * (~i & 3));
+}
+
+
 // MD5
 static void md5_transform (uint32_t *buf, uint32_t *in);
 
@@ -396,10 +1015,26 @@ md5_update (s_md5_ctx_t *mdContext, unsigned char *inBuf, unsigned int inLen)
   mdContext->i[0] += ((uint32_t) inLen << 3);
   mdContext->i[1] += ((uint32_t) inLen >> 29);
 
-  while (inLen--)
+  while (inLen)
     {
+      if (mdi == 0 && inLen >= 0x40)
+        {
+          // Transform whole blocks straight from the input
+          for (i = 0, ii = 0; i < 16; i++, ii += 4)
+            in[i] = (((uint32_t) inBuf[ii + 3]) << 24) |
+              (((uint32_t) inBuf[ii + 2]) << 16) |
+              (((uint32_t) inBuf[ii + 1]) << 8) |
+              ((uint32_t) inBuf[ii]);
+
+          md5_transform (mdContext->buf, in);
+          inBuf += 0x40;
+          inLen -= 0x40;
+          continue;
+        }
+
       // Add new character to buffer, increment mdi
       mdContext->in[mdi++] = *inBuf++;
+      inLen--;
 
       // Transform if necessary
       if (mdi == 0x40)
@@ -517,7 +1152,21 @@ chksum_crc16 (unsigned short crc, const void *buffer, unsigned int size)
 
 // CRC32
 #ifndef USE_ZLIB
-static unsigned int *crc32_table = NULL;
+/*
+  crc32() processes its input with the fastest kernel the CPU supports. The
+  kernel is chosen once, on the first call. All kernels produce the same
+  results as the byte-at-a-time loop (crc32_bytewise()).
+  crc32_bytewise() uses 1 table of 256 entries
+  crc32_slice8()   uses 8 tables and handles 8 bytes per iteration
+  crc32_pclmul()   folds 64 bytes per iteration with carry-less multiplication
+                     (x86 with PCLMULQDQ only)
+  The kernels work on the inverted CRC value.
+*/
+typedef uint32_t (*crc32_kernel_t) (uint32_t crc, const unsigned char *p,
+                                    size_t size);
+
+static uint32_t (*crc32_table)[256] = NULL;
+static crc32_kernel_t crc32_kernel = NULL;
 
 
 static void
@@ -525,24 +1174,252 @@ free_crc32_table (void)
 {
   free (crc32_table);
   crc32_table = NULL;
+  crc32_kernel = NULL;
+}
+
+
+static uint32_t
+crc32_bytewise (uint32_t crc, const unsigned char *p, size_t size)
+{
+  while (size--)
+    crc = (crc >> 8) ^ crc32_table[0][(crc ^ *p++) & 0xff];
+  return crc;
+}
+
+
+static uint32_t
+crc32_slice8 (uint32_t crc, const unsigned char *p, size_t size)
+{
+  for (; size >= 8; size -= 8, p += 8)
+    {
+      // reading the bytes separately keeps this independent of the byte order
+      //  (and of alignment); compilers turn this into a single load
+      uint32_t hi = (uint32_t) p[4] | (uint32_t) p[5] << 8 |
+                    (uint32_t) p[6] << 16 | (uint32_t) p[7] << 24;
+
+      crc ^= (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 |
+             (uint32_t) p[3] << 24;
+      crc = crc32_table[7][crc & 0xff] ^ crc32_table[6][(crc >> 8) & 0xff] ^
+            crc32_table[5][(crc >> 16) & 0xff] ^ crc32_table[4][crc >> 24] ^
+            crc32_table[3][hi & 0xff] ^ crc32_table[2][(hi >> 8) & 0xff] ^
+            crc32_table[1][(hi >> 16) & 0xff] ^ crc32_table[0][hi >> 24];
+    }
+  return crc32_bytewise (crc, p, size);
+}
+
+
+#ifdef  CRC32_PCLMUL
+#define CRC32_FOLD(x, k, data) \
+  x = _mm_xor_si128 (_mm_xor_si128 (_mm_clmulepi64_si128 (x, k, 0x00), \
+                                    _mm_clmulepi64_si128 (x, k, 0x11)), data)
+
+
+__attribute__ ((target ("sse2,pclmul")))
+static uint32_t
+crc32_pclmul (uint32_t crc, const unsigned char *p, size_t size)
+// Folding constants are (x^n mod P(x)) bit-reflected, see Intel's "Fast CRC
+//  Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+{
+  const __m128i k1k2 = _mm_set_epi64x (0x1c6e41596LL, 0x154442bd4LL),
+                k3k4 = _mm_set_epi64x (0x0ccaa009eLL, 0x1751997d0LL),
+                k5 = _mm_set_epi64x (0, 0x163cd6124LL),
+                poly_mu = _mm_set_epi64x (0x1f7011641LL, 0x1db710641LL),
+                mask32 = _mm_set_epi32 (0, 0, 0, -1);
+  __m128i x1, x2, x3, x4;
+
+  if (size < 64)
+    return crc32_slice8 (crc, p, size);
+
+  x1 = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) p),
+                      _mm_cvtsi32_si128 ((int) crc));
+  x2 = _mm_loadu_si128 ((const __m128i *) (p + 16));
+  x3 = _mm_loadu_si128 ((const __m128i *) (p + 32));
+  x4 = _mm_loadu_si128 ((const __m128i *) (p + 48));
+  for (p += 64, size -= 64; size >= 64; p += 64, size -= 64)
+    {
+      CRC32_FOLD (x1, k1k2, _mm_loadu_si128 ((const __m128i *) p));
+      CRC32_FOLD (x2, k1k2, _mm_loadu_si128 ((const __m128i *) (p + 16)));
+      CRC32_FOLD (x3, k1k2, _mm_loadu_si128 ((const __m128i *) (p + 32)));
+      CRC32_FOLD (x4, k1k2, _mm_loadu_si128 ((const __m128i *) (p + 48)));
+    }
+
+  // fold the 4 accumulators into 1 and then the remaining 16-byte blocks
+  CRC32_FOLD (x1, k3k4, x2);
+  CRC32_FOLD (x1, k3k4, x3);
+  CRC32_FOLD (x1, k3k4, x4);
+  for (; size >= 16; p += 16, size -= 16)
+    CRC32_FOLD (x1, k3k4, _mm_loadu_si128 ((const __m128i *) p));
+
+  // 128 -> 64 bits (appending 32 zero bits)
+  x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8),
+                      _mm_clmulepi64_si128 (x1, k3k4, 0x10));
+  // 64 -> 32 bits
+  x2 = _mm_srli_si128 (x1, 4);
+  x1 = _mm_xor_si128 (_mm_clmulepi64_si128 (_mm_and_si128 (x1, mask32), k5,
+                                            0x00), x2);
+  // Barrett reduction
+  x2 = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask32), poly_mu, 0x10);
+  x2 = _mm_clmulepi64_si128 (_mm_and_si128 (x2, mask32), poly_mu, 0x00);
+  crc = (uint32_t) _mm_cvtsi128_si32 (_mm_srli_si128 (_mm_xor_si128 (x1, x2),
+                                                      4));
+
+  return crc32_slice8 (crc, p, size);
+}
+#undef  CRC32_FOLD
+
+
+static int
+crc32_have_pclmul (void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+    return 0;
+  return (ecx & bit_PCLMUL) && (edx & bit_SSE2);
+}
+#endif // CRC32_PCLMUL
+
+
+static void
+crc32_init (void)
+{
+  unsigned int i, j;
+
+  crc32_table = (uint32_t (*)[256]) malloc (8 * 256 * sizeof (uint32_t));
+  register_func (free_crc32_table);
+  init_crc_table (crc32_table[0], CRC32_POLYNOMIAL);
+  for (i = 0; i < 256; i++)
+    for (j = 1; j < 8; j++)
+      crc32_table[j][i] = (crc32_table[j - 1][i] >> 8) ^
+                          crc32_table[0][crc32_table[j - 1][i] & 0xff];
+
+  crc32_kernel = crc32_slice8;
+#ifdef  CRC32_PCLMUL
+  if (crc32_have_pclmul ())
+    crc32_kernel = crc32_pclmul;
+#endif
 }
 
 
 unsigned int
 crc32 (unsigned int crc, const void *buffer, unsigned int size)
 {
-  unsigned char *p = (unsigned char *) buffer;
+  if (!crc32_table)
+    crc32_init ();
+
+  return ~crc32_kernel (~crc, (const unsigned char *) buffer, size);
+}
+
 
+#ifdef  TEST
+void
+crc32_benchmark (void)
+{
+  static const struct
+  {
+    const char *name;
+    crc32_kernel_t func;
+  } kernels[] =
+    {
+      {"bytewise", crc32_bytewise},
+      {"slice-by-8", crc32_slice8},
+#ifdef  CRC32_PCLMUL
+      {"pclmul", NULL},
+#endif
+      {NULL, NULL}
+    };
+  const size_t size = 16 * 1024 * 1024;
+  unsigned char *buffer = (unsigned char *) malloc (size);
+  uint32_t reference = 0;
+  int i;
+
+  if (!buffer)
+    return;
   if (!crc32_table)
+    crc32_init ();
+  for (i = 0; (size_t) i < size; i++)
+    buffer[i] = (unsigned char) (i * 2654435761U >> 24);
+
+  for (i = 0; kernels[i].name; i++)
     {
-      crc32_table = (unsigned int *) malloc (256 * 4);
-      register_func (free_crc32_table);
-      init_crc_table (crc32_table, CRC32_POLYNOMIAL);
+      crc32_kernel_t func = kernels[i].func;
+      uint32_t crc;
+      clock_t start;
+      double secs;
+
+#ifdef  CRC32_PCLMUL
+      if (!func)
+        {
+          if (!crc32_have_pclmul ())
+            continue;
+          func = crc32_pclmul;
+        }
+#endif
+      start = clock ();
+      crc = ~func (~0U, buffer, size);
+      secs = (double) (clock () - start) / CLOCKS_PER_SEC;
+      if (i == 0)
+        reference = crc;
+      printf ("crc32 %-10s 0x%08x %8.1f MB/s%s%s\n", kernels[i].name,
+              (unsigned int) crc, secs > 0 ? size / (secs * 1024 * 1024) : 0.0,
+              crc == reference ? "" : " MISMATCH",
+              func == crc32_kernel ? " (selected)" : "");
     }
 
-  crc = ~crc;
-  while (size--)
-    crc = (crc >> 8) ^ crc32_table[(crc ^ *p++) & 0xff];
-  return ~crc;
+  free (buffer);
+}
+#endif // TEST
+#endif // USE_ZLIB
+
+
+// fused checksum engine
+#define CHKSUM_SLICE 8192                       // keep slices in the L1 cache
+
+
+void
+chksum_begin (s_chksum_ctx_t *ctx, unsigned int flags)
+{
+  ctx->flags = flags;
+  ctx->crc32 = 0;
+  if (flags & CHKSUM_MD5)
+    md5_init (&ctx->md5, 0);
+  if (flags & CHKSUM_SHA1)
+    sha1_begin (&ctx->sha1);
+  if (flags & CHKSUM_SHA256)
+    sha256_begin (&ctx->sha256);
+}
+
+
+void
+chksum_update (s_chksum_ctx_t *ctx, const void *buffer, size_t size)
+{
+  const unsigned char *p = (const unsigned char *) buffer;
+
+  while (size)
+    {
+      unsigned int n = (unsigned int) MIN (size, CHKSUM_SLICE);
+
+      if (ctx->flags & CHKSUM_CRC32)
+        ctx->crc32 = crc32 (ctx->crc32, p, n);
+      if (ctx->flags & CHKSUM_MD5)
+        md5_update (&ctx->md5, (unsigned char *) p, n);
+      if (ctx->flags & CHKSUM_SHA1)
+        sha1 (&ctx->sha1, p, n);
+      if (ctx->flags & CHKSUM_SHA256)
+        sha256 (&ctx->sha256, p, n);
+      p += n;
+      size -= n;
+    }
+}
+
+
+void
+chksum_end (s_chksum_ctx_t *ctx)
+{
+  if (ctx->flags & CHKSUM_MD5)
+    md5_final (&ctx->md5);
+  if (ctx->flags & CHKSUM_SHA1)
+    sha1_end (ctx->sha1_digest, &ctx->sha1);
+  if (ctx->flags & CHKSUM_SHA256)
+    sha256_end (ctx->sha256_digest, &ctx->sha256);
 }
-#endif
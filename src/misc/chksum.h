@@ -35,6 +35,7 @@ MD5  - Copyright (C) 1990, RSA Data Security, Inc. All rights reserved.
 #ifdef  HAVE_CONFIG_H
 #include "config.h"                             // USE_ZLIB
 #endif
+#include <stddef.h>                             // size_t
 #include "misc/itypes.h"
 
 
@@ -48,6 +49,11 @@ extern "C" {
   sha1()       process data
   sha1_end()   stop sha1
 
+  s_sha256_ctx_t
+  sha256_begin() start sha256
+  sha256()       process data
+  sha256_end()   stop sha256
+
   s_md5_ctx_t
   md5_init()   start md5
   md5_update() process data
@@ -59,6 +65,15 @@ extern "C" {
                  use zlib's crc32() if USE_ZLIB is defined...
                  ... but make it possible to link against a library
                  that uses zlib while this code does not use it
+               picks a slice-by-8 or (x86) PCLMULQDQ kernel at run-time
+  crc32_benchmark() compare the speed of the crc32() kernels (TEST only)
+
+  s_chksum_ctx_t
+  chksum_begin()  start any combination of CHKSUM_* checksums
+  chksum_update() process data; all checksums are updated in one pass
+  chksum_end()    stop; the results are in the context
+
+  SHA1 and SHA-256 use the Intel SHA extensions if the CPU has them.
 */
 typedef struct
 {
@@ -72,6 +87,18 @@ extern void sha1 (s_sha1_ctx_t ctx[1], const unsigned char data[], unsigned int
 extern void sha1_end (unsigned char hval[], s_sha1_ctx_t ctx[1]);
 
 
+typedef struct
+{
+  uint32_t count[2];
+  uint32_t hash[8];
+  uint32_t wbuf[16];
+} s_sha256_ctx_t;
+
+extern void sha256_begin (s_sha256_ctx_t ctx[1]);
+extern void sha256 (s_sha256_ctx_t ctx[1], const unsigned char data[], unsigned int len);
+extern void sha256_end (unsigned char hval[], s_sha256_ctx_t ctx[1]);
+
+
 // data structure for MD5 (Message Digest) computation
 typedef struct
 {
@@ -91,7 +118,31 @@ extern unsigned short chksum_crc16 (unsigned short crc, const void *buffer, unsi
 
 #ifndef  USE_ZLIB
 extern unsigned int crc32 (unsigned int crc, const void *buffer, unsigned int size);
+#ifdef  TEST
+extern void crc32_benchmark (void);
 #endif
+#endif
+
+
+#define CHKSUM_CRC32  1
+#define CHKSUM_MD5    2
+#define CHKSUM_SHA1   4
+#define CHKSUM_SHA256 8
+
+typedef struct
+{
+  unsigned int flags;                   // CHKSUM_* checksums to compute
+  unsigned int crc32;
+  s_md5_ctx_t md5;                      // result in md5.digest
+  s_sha1_ctx_t sha1;
+  s_sha256_ctx_t sha256;
+  unsigned char sha1_digest[20];
+  unsigned char sha256_digest[32];
+} s_chksum_ctx_t;
+
+extern void chksum_begin (s_chksum_ctx_t *ctx, unsigned int flags);
+extern void chksum_update (s_chksum_ctx_t *ctx, const void *buffer, size_t size);
+extern void chksum_end (s_chksum_ctx_t *ctx);
 
 
 #ifdef  __cplusplus
@@ -44,6 +44,9 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
+#if     defined HAVE_MMAP && defined HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #ifdef  _WIN32
 #ifdef  _MSC_VER
@@ -1011,6 +1014,170 @@ ftello2 (FILE *file)
 #endif
 
 
+/*
+  The per-file I/O context. The caller owns its storage (uCON64 keeps one in
+  the st_ucon64_t of each file) and quick_io_ctx_open() makes it the context
+  that the quick_io*() functions use. While it is active, read-only calls to quick_io(),
+  quick_io_c() and quick_io_func() for the file it was opened for share one
+  file handle, so that a series of small reads (like the ones the
+  <console>_init() functions do) doesn't result in a series of open(), seek()
+  and close() calls. If possible the whole file is made available as one
+  read-only image, either by mapping it into memory with mmap() or by using
+  the decompressed data of the archive cache. Reads are then served from that
+  image. A call that writes to the file closes the shared handle (and image),
+  so that subsequent reads see the new data.
+*/
+static st_quick_io_ctx_t *quick_io_ctx = NULL;  // context used by quick_io*()
+
+
+void
+quick_io_ctx_open (st_quick_io_ctx_t *ctx, const char *filename)
+{
+  size_t len = strnlen (filename, sizeof ctx->fname - 1);
+
+  if (ctx->active)
+    quick_io_ctx_close (ctx, NULL);
+  memset (ctx, 0, sizeof (st_quick_io_ctx_t));
+  strncpy (ctx->fname, filename, len)[len] = '\0';
+  ctx->active = 1;
+  quick_io_ctx = ctx;
+}
+
+
+static void
+quick_io_ctx_release (st_quick_io_ctx_t *ctx)
+{
+#if     defined HAVE_MMAP && defined HAVE_SYS_MMAN_H
+  if (ctx->mapped)
+    munmap ((void *) ctx->data, (size_t) ctx->size);
+#endif
+  ctx->data = NULL;
+  ctx->size = 0;
+  ctx->mapped = 0;
+  if (ctx->fh)
+    {
+      fclose (ctx->fh);
+      ctx->fh = NULL;
+    }
+}
+
+
+void
+quick_io_ctx_close (st_quick_io_ctx_t *ctx, st_quick_io_stats_t *stats)
+{
+  quick_io_ctx_release (ctx);
+  ctx->active = 0;
+  if (quick_io_ctx == ctx)
+    quick_io_ctx = NULL;
+  if (stats)
+    *stats = ctx->stats;
+}
+
+
+static int
+quick_io_ctx_load (st_quick_io_ctx_t *ctx)
+// opens the shared file handle and creates the image of the file if possible
+{
+  if (ctx->fh)
+    return 0;
+  if ((ctx->fh = fopen (ctx->fname, "rb")) == NULL)
+    return -1;
+  ctx->stats.opens++;
+  ctx->pos = 0;
+
+#ifdef  USE_ZLIB
+  if ((ctx->data = archive_get_data (ctx->fh, &ctx->size)) != NULL)
+    return 0;
+#endif
+#if     defined HAVE_MMAP && defined HAVE_SYS_MMAN_H
+  {
+    struct stat fstate;
+    int fd = fileno (ctx->fh);
+
+    if (!fstat (fd, &fstate) && S_ISREG (fstate.st_mode) && fstate.st_size > 0 &&
+        (uint64_t) fstate.st_size <= (size_t) -1)
+      {
+        void *data = mmap (NULL, (size_t) fstate.st_size, PROT_READ, MAP_PRIVATE,
+                           fd, 0);
+        if (data != MAP_FAILED)
+          {
+            ctx->data = (const unsigned char *) data;
+            ctx->size = fstate.st_size;
+            ctx->mapped = 1;
+          }
+      }
+  }
+#endif
+  return 0;
+}
+
+
+static int
+quick_io_ctx_get (st_quick_io_ctx_t *ctx, const char *filename, const char *mode,
+                  uint64_t start)
+// returns 0 if the context can be used for filename and mode, after setting the
+//  read position to start, or -1 if it cannot be used
+{
+  if (!ctx || !ctx->active || strcmp (filename, ctx->fname))
+    return -1;
+
+  if (*mode != 'r' || mode[1] == '+')           // will we write to it?
+    {
+      quick_io_ctx_release (ctx);
+      return -1;
+    }
+
+  ctx->stats.calls++;
+  if (quick_io_ctx_load (ctx))
+    return -1;
+  if (ctx->pos != start)
+    {
+      if (!ctx->data)
+        {
+          ctx->stats.seeks++;
+          if (fseeko2 (ctx->fh, start, SEEK_SET))
+            {
+              quick_io_ctx_release (ctx);
+              return -1;
+            }
+        }
+      ctx->pos = start;
+    }
+  return 0;
+}
+
+
+static size_t
+quick_io_ctx_read (st_quick_io_ctx_t *ctx, void *buffer, size_t len)
+{
+  size_t n;
+
+  if (ctx->data)
+    {
+      n = ctx->pos < ctx->size ? (size_t) MIN (len, ctx->size - ctx->pos) : 0;
+      memcpy (buffer, ctx->data + ctx->pos, n);
+    }
+  else
+    n = fread (buffer, 1, len, ctx->fh);
+  ctx->pos += n;
+  ctx->stats.bytes_read += n;
+  return n;
+}
+
+
+const unsigned char *
+quick_io_ctx_data (const char *filename, uint64_t *size)
+{
+  st_quick_io_ctx_t *ctx = quick_io_ctx;
+
+  if (!ctx || !ctx->active || strcmp (filename, ctx->fname) ||
+      quick_io_ctx_load (ctx))
+    return NULL;
+  *size = ctx->size;
+  return ctx->data;
+}
+
+
 static FILE *
 quick_io_open (const char *filename, const char *mode)
 {
@@ -1055,6 +1222,12 @@ quick_io_c (int value, uint64_t pos, const char *filename, const char *mode)
   int result;
   FILE *fh;
 
+  if (!quick_io_ctx_get (quick_io_ctx, filename, mode, pos))
+    {
+      unsigned char c;
+      return quick_io_ctx_read (quick_io_ctx, &c, 1) == 1 ? c : EOF;
+    }
+
   if ((fh = quick_io_open (filename, mode)) == NULL)
     return -1;
 
@@ -1081,6 +1254,9 @@ quick_io (void *buffer, uint64_t start, size_t len, const char *filename,
   size_t result;
   FILE *fh;
 
+  if (!quick_io_ctx_get (quick_io_ctx, filename, mode, start))
+    return quick_io_ctx_read (quick_io_ctx, buffer, len);
+
   if ((fh = quick_io_open (filename, mode)) == NULL)
     return 0;
 
@@ -1134,18 +1310,24 @@ quick_io_func (size_t (*func) (void *, size_t, void *), size_t func_maxlen, void
   uint64_t len_done;
   size_t buffer_len;
   FILE *fh;
+  int shared = 0;
 
   errno = 0;
 
   if ((buffer = malloc (func_maxlen)) == NULL)
     return 0;
-  if ((fh = quick_io_open (filename, mode)) == NULL)
+  if (!quick_io_ctx_get (quick_io_ctx, filename, mode, start))
+    {
+      fh = NULL;
+      shared = 1;
+    }
+  else if ((fh = quick_io_open (filename, mode)) == NULL)
     {
       free (buffer);
       return 0;
     }
 
-  if (fseeko2 (fh, start, SEEK_SET))
+  if (!shared && fseeko2 (fh, start, SEEK_SET))
     {
       fclose (fh);
       free (buffer);
@@ -1158,7 +1340,9 @@ quick_io_func (size_t (*func) (void *, size_t, void *), size_t func_maxlen, void
 
       if (len_done + func_maxlen > len)
         func_maxlen = (size_t) (len - len_done);
-      if ((buffer_len = fread (buffer, 1, func_maxlen, fh)) == 0)
+      if ((buffer_len = shared ?
+             quick_io_ctx_read (quick_io_ctx, buffer, func_maxlen) :
+             fread (buffer, 1, func_maxlen, fh)) == 0)
         break;
 
       func_len = quick_io_func_inline (func, func_maxlen, object, buffer, buffer_len);
@@ -1182,7 +1366,8 @@ quick_io_func (size_t (*func) (void *, size_t, void *), size_t func_maxlen, void
         }
     }
 
-  fclose (fh);
+  if (!shared)
+    fclose (fh);
   free (buffer);
   // return total number of bytes processed
   return len_done;
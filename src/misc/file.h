@@ -96,6 +96,16 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
                 mode: "a.." or "w.."
                 func() must always return the exact number of bytes (size_t) or
                 the buffer won't be written
+  quick_io_ctx_open() make quick_io(), quick_io_c() and quick_io_func() keep
+                filename open for reading in ctx until quick_io_ctx_close() is
+                called. ctx must be zeroed before its first use
+  quick_io_ctx_close() close the file opened by quick_io_ctx_open() in ctx and
+                store the I/O statistics for it in stats (if stats is not NULL)
+  quick_io_ctx_data() returns a read-only image of the whole file if filename
+                is the file of the open context and such an image could be
+                created, otherwise NULL. The image stays valid until quick_io_ctx_close()
+                is called or until the file is written to with one of the
+                quick_io*() functions
 */
 extern int isfname (int c);
 extern int tofname (int c);
@@ -128,6 +138,34 @@ extern int quick_io_c (int value, uint64_t pos, const char *fname, const char *m
 extern uint64_t quick_io_func (size_t (*callback_func) (void *, size_t, void *),
                                size_t func_maxlen, void *object, uint64_t start,
                                uint64_t len, const char *fname, const char *mode);
+typedef struct
+{
+  unsigned long calls;                          // number of reads via the context
+  unsigned long opens;
+  unsigned long seeks;
+  uint64_t bytes_read;
+} st_quick_io_stats_t;
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  int active;
+  char fname[FILENAME_MAX];
+  FILE *fh;
+  uint64_t pos;                                 // file position of fh
+  const unsigned char *data;                    // image of the file (or NULL)
+  uint64_t size;                                // size of image
+  int mapped;                                   // image was created by mmap()
+  st_quick_io_stats_t stats;
+} st_quick_io_ctx_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+extern void quick_io_ctx_open (st_quick_io_ctx_t *ctx, const char *fname);
+extern void quick_io_ctx_close (st_quick_io_ctx_t *ctx, st_quick_io_stats_t *stats);
+extern const unsigned char *quick_io_ctx_data (const char *fname, uint64_t *size);
 
 
 /*
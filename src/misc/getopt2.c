@@ -33,6 +33,14 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifdef  HAVE_DIRENT_H
 #include <dirent.h>
 #endif
+#include <errno.h>
+#if     defined HAVE_FSTATAT && defined HAVE_FDOPENDIR && !defined _WIN32
+#define GETOPT2_USE_OPENAT
+#include <fcntl.h>
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+#endif
 #include <stdio.h>
 #include <string.h>
 #ifdef  _MSC_VER
@@ -386,38 +394,21 @@ getopt2_short (char *short_option, const st_getopt2_t *option, int n)
 }
 
 
-static int
-getopt2_file_recursion (const char *fname, int (*callback_func) (const char *),
-                        int *calls, int flags)
-{
-  char path[FILENAME_MAX];
-#ifdef  _WIN32
-  struct _stati64 fstate;
-#else
-  struct stat fstate;
-#endif
+static void getopt2_file_dir (const char *path, int dir_fd, const char *name,
+                              int (*callback_func) (const char *,
+                                                    const st_getopt2_stat_t *),
+                              int *calls, int flags);
 
-  realpath2 (fname, path);
-
-  /*
-    Try to get file status information only if the file with name fname exists.
-    If the file does not exist I set st_mode to 0 instead of __S_IFREG, because I
-    don't know if the latter is portable. - dbjh
-  */
-  if (access (path, F_OK) == 0)
-    {
-#ifdef  _WIN32
-      if (_stati64 (path, &fstate))
-#else
-      if (stat (path, &fstate))
-#endif
-        return 0;
-    }
-  else
-    fstate.st_mode = 0;
 
+static int
+getopt2_file_entry (const char *path, const st_getopt2_stat_t *fstate,
+                    int dir_fd, const char *name,
+                    int (*callback_func) (const char *, const st_getopt2_stat_t *),
+                    int *calls, int flags)
+// handle path with status fstate (NULL if the file does not exist)
+{
   /*
-    We test whether fname is a directory, because we handle directories
+    We test whether path is a directory, because we handle directories
     differently. The callback function should test whether its argument is a
     regular file, a character special file, a block special file, a FIFO
     special file, a symbolic link or a socket. If the flags
@@ -425,7 +416,7 @@ getopt2_file_recursion (const char *fname, int (*callback_func) (const char *),
     GETOPT2_FILE_RECURSIVE_ONCE were not used by the calling function, it may
     also have to test whether the argument is a directory.
   */
-  if (S_ISDIR (fstate.st_mode) ?
+  if (fstate && S_ISDIR (fstate->st_mode) ?
         !(flags & (GETOPT2_FILE_FILES_ONLY |
                    GETOPT2_FILE_RECURSIVE |
                    GETOPT2_FILE_RECURSIVE_ONCE)) :
@@ -438,7 +429,7 @@ getopt2_file_recursion (const char *fname, int (*callback_func) (const char *),
       fflush (stdout);
 #endif
 
-      result = callback_func (path);
+      result = callback_func (path, fstate);
 
       if (!result)
         (*calls)++;
@@ -446,75 +437,166 @@ getopt2_file_recursion (const char *fname, int (*callback_func) (const char *),
       return result;
     }
 
-  if (S_ISDIR (fstate.st_mode) &&
-      (flags & (GETOPT2_FILE_RECURSIVE | GETOPT2_FILE_RECURSIVE_ONCE)))
-    {
-#ifndef _WIN32
-      struct dirent *ep;
-      DIR *dp;
+  if (flags & (GETOPT2_FILE_RECURSIVE | GETOPT2_FILE_RECURSIVE_ONCE))
+    getopt2_file_dir (path, dir_fd, name, callback_func, calls,
+                      flags & ~GETOPT2_FILE_RECURSIVE_ONCE);
+
+  return 0;
+}
+
+
+static int
+getopt2_file_recursion (const char *fname,
+                        int (*callback_func) (const char *,
+                                              const st_getopt2_stat_t *),
+                        int *calls, int flags)
+{
+  char path[FILENAME_MAX];
+  st_getopt2_stat_t fstate;
+
+  realpath2 (fname, path);
+
+  // the callback function gets NULL as status if the file does not exist
+#ifdef  _WIN32
+  if (_stati64 (path, &fstate))
 #else
-      char search_pattern[FILENAME_MAX];
-      WIN32_FIND_DATA find_data;
-      HANDLE dp;
+  if (stat (path, &fstate))
 #endif
-      char *p;
+    return access (path, F_OK) == 0 ?
+             0 : getopt2_file_entry (path, NULL, -1, NULL, callback_func,
+                                     calls, flags);
 
-#if     defined __MSDOS__ || defined _WIN32 || defined __CYGWIN__
-      char c = (char) toupper ((int) path[0]);
-      if (path[strlen (path) - 1] == DIR_SEPARATOR ||
-          (c >= 'A' && c <= 'Z' && path[1] == ':' && path[2] == '\0'))
+  return getopt2_file_entry (path, &fstate, -1, NULL, callback_func, calls,
+                             flags);
+}
+
+
+static void
+getopt2_file_dir (const char *path, int dir_fd, const char *name,
+                  int (*callback_func) (const char *, const st_getopt2_stat_t *),
+                  int *calls, int flags)
+/*
+  Pass the entries of directory path to the callback function. If dir_fd is not
+  -1, name is the name of the directory relative to the directory dir_fd.
+
+  With openat() and fstatat() entries are looked up relative to their
+  directory and a regular entry costs one fstatat() call. realpath2() would
+  look up every component of the path again, but it is only necessary for
+  symbolic links, because path is already the realpath() of the directory.
+  Directories that we enter or skip anyway are recognized by d_type without
+  any look-up.
+*/
+{
+  char buf[FILENAME_MAX];
+  const char *p;
+#ifdef  GETOPT2_USE_OPENAT
+  struct dirent *ep;
+  DIR *dp;
+  int fd;
+#elif   !defined _WIN32
+  struct dirent *ep;
+  DIR *dp;
 #else
-      if (path[strlen (path) - 1] == DIR_SEPARATOR)
+  char search_pattern[FILENAME_MAX];
+  WIN32_FIND_DATA find_data;
+  HANDLE dp;
 #endif
-        p = "";
-      else
-        p = DIR_SEPARATOR_S;
 
-#ifndef _WIN32
-      if ((dp = opendir (path)))
-        {
-          while ((ep = readdir (dp)))
-            if (strcmp (ep->d_name, ".") && strcmp (ep->d_name, ".."))
-              {
-                char buf[FILENAME_MAX];
-
-                snprintf (buf, FILENAME_MAX, "%s%s%s", path, p, ep->d_name);
-                buf[FILENAME_MAX - 1] = '\0';
-                if (getopt2_file_recursion (buf, callback_func, calls,
-                                            flags & ~GETOPT2_FILE_RECURSIVE_ONCE) != 0)
-                  break;
-              }
-          closedir (dp);
-        }
+#if     defined __MSDOS__ || defined _WIN32 || defined __CYGWIN__
+  char c = (char) toupper ((int) path[0]);
+  if (path[strlen (path) - 1] == DIR_SEPARATOR ||
+      (c >= 'A' && c <= 'Z' && path[1] == ':' && path[2] == '\0'))
 #else
-      snprintf (search_pattern, FILENAME_MAX, "%s%s*", path, p);
-      search_pattern[FILENAME_MAX - 1] = '\0';
-      if ((dp = FindFirstFile (search_pattern, &find_data)) != INVALID_HANDLE_VALUE)
-        {
-          do
-            if (strcmp (find_data.cFileName, ".") &&
-                strcmp (find_data.cFileName, ".."))
-              {
-                char buf[FILENAME_MAX];
+  if (path[strlen (path) - 1] == DIR_SEPARATOR)
+#endif
+    p = "";
+  else
+    p = DIR_SEPARATOR_S;
 
-                snprintf (buf, FILENAME_MAX, "%s%s%s", path, p, find_data.cFileName);
-                buf[FILENAME_MAX - 1] = '\0';
-                if (getopt2_file_recursion (buf, callback_func, calls,
-                                            flags & ~GETOPT2_FILE_RECURSIVE_ONCE) != 0)
-                  break;
-              }
-          while (FindNextFile (dp, &find_data));
-          FindClose (dp);
-        }
+#ifdef  GETOPT2_USE_OPENAT
+  if ((fd = dir_fd != -1 ? openat (dir_fd, name, O_RDONLY | O_DIRECTORY) :
+                           open (path, O_RDONLY | O_DIRECTORY)) == -1)
+    return;
+  if ((dp = fdopendir (fd)) == NULL)
+    {
+      close (fd);
+      return;
+    }
+  while ((ep = readdir (dp)))
+    if (strcmp (ep->d_name, ".") && strcmp (ep->d_name, ".."))
+      {
+        st_getopt2_stat_t fstate;
+        int result;
+
+        snprintf (buf, FILENAME_MAX, "%s%s%s", path, p, ep->d_name);
+        buf[FILENAME_MAX - 1] = '\0';
+#ifdef  DT_DIR
+        if (ep->d_type == DT_DIR &&
+            (flags & (GETOPT2_FILE_FILES_ONLY | GETOPT2_FILE_RECURSIVE)))
+          {
+            if (flags & GETOPT2_FILE_RECURSIVE)
+              getopt2_file_dir (buf, fd, ep->d_name, callback_func, calls, flags);
+            continue;
+          }
+        if (ep->d_type == DT_LNK)
+          result = getopt2_file_recursion (buf, callback_func, calls, flags);
+        else
 #endif
+        if (fstatat (fd, ep->d_name, &fstate, AT_SYMLINK_NOFOLLOW))
+          result = errno == ENOENT ?
+                     getopt2_file_entry (buf, NULL, -1, NULL, callback_func,
+                                         calls, flags) : 0;
+        else if (S_ISLNK (fstate.st_mode))
+          result = getopt2_file_recursion (buf, callback_func, calls, flags);
+        else
+          result = getopt2_file_entry (buf, &fstate, fd, ep->d_name,
+                                       callback_func, calls, flags);
+        if (result != 0)
+          break;
+      }
+  closedir (dp);
+#elif   !defined _WIN32
+  (void) dir_fd;
+  (void) name;
+  if ((dp = opendir (path)))
+    {
+      while ((ep = readdir (dp)))
+        if (strcmp (ep->d_name, ".") && strcmp (ep->d_name, ".."))
+          {
+            snprintf (buf, FILENAME_MAX, "%s%s%s", path, p, ep->d_name);
+            buf[FILENAME_MAX - 1] = '\0';
+            if (getopt2_file_recursion (buf, callback_func, calls, flags) != 0)
+              break;
+          }
+      closedir (dp);
     }
-
-  return 0;
+#else
+  (void) dir_fd;
+  (void) name;
+  snprintf (search_pattern, FILENAME_MAX, "%s%s*", path, p);
+  search_pattern[FILENAME_MAX - 1] = '\0';
+  if ((dp = FindFirstFile (search_pattern, &find_data)) != INVALID_HANDLE_VALUE)
+    {
+      do
+        if (strcmp (find_data.cFileName, ".") &&
+            strcmp (find_data.cFileName, ".."))
+          {
+            snprintf (buf, FILENAME_MAX, "%s%s%s", path, p, find_data.cFileName);
+            buf[FILENAME_MAX - 1] = '\0';
+            if (getopt2_file_recursion (buf, callback_func, calls, flags) != 0)
+              break;
+          }
+      while (FindNextFile (dp, &find_data));
+      FindClose (dp);
+    }
+#endif
 }
 
 
 int
-getopt2_file (int argc, char **argv, int (*callback_func) (const char *), int flags)
+getopt2_file (int argc, char **argv,
+              int (*callback_func) (const char *, const st_getopt2_stat_t *),
+              int flags)
 {
   int x = optind, calls = 0;
 
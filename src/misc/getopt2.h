@@ -24,6 +24,14 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifdef  HAVE_CONFIG_H
 #include "config.h"
 #endif
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+#include <sys/stat.h>
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
 #ifndef  __CYGWIN__
 #include "misc/getopt.h"                        // getopt2 needs struct option from getopt1
 #else
@@ -54,6 +62,7 @@ extern "C" {
                 </imperative>
 
   getopt2_file()        runs callback_func with the realpath() of file/dir as string
+                          and its status (NULL if the file does not exist)
                         flags:
   0                           pass all files/dirs with their realpath()
   GETOPT2_FILE_FILES_ONLY     pass only files with their realpath()
@@ -110,11 +119,19 @@ extern int getopt2_short (char *short_option, const st_getopt2_t *option,
 extern const st_getopt2_t *getopt2_get_index_by_val (const st_getopt2_t *option,
                                                      int val);
 
+#ifdef  _WIN32
+typedef struct _stati64 st_getopt2_stat_t;
+#else
+typedef struct stat st_getopt2_stat_t;
+#endif
+
 #define GETOPT2_FILE_FILES_ONLY     1
 #define GETOPT2_FILE_RECURSIVE      (1 << 1)
 #define GETOPT2_FILE_RECURSIVE_ONCE (1 << 2)
 extern int getopt2_file (int argc, char **argv,
-                         int (* callback_func) (const char *), int flags);
+                         int (* callback_func) (const char *,
+                                                const st_getopt2_stat_t *),
+                         int flags);
 
 
 #ifdef  DEBUG
@@ -901,6 +901,289 @@ cleanup_cm_patterns (st_cm_pattern_t **patterns, int n_patterns)
 }
 
 
+static int
+cm_match (const st_cm_pattern_t *pattern, const char *buf)
+// check if pattern matches at buf, the same way as change_mem2() does
+{
+  size_t i;
+  unsigned int setindex = 0;
+
+  for (i = 0; i < pattern->search_size; i++)
+    {
+      char c = pattern->search[i];
+
+      if (c == pattern->escape)
+        {
+          const st_cm_set_t *set;
+
+          if (pattern->sets == NULL)
+            return 1;                           // let change_mem2() report it
+          set = &pattern->sets[setindex++];
+          if (memchr (set->data, buf[i], set->size) == NULL)
+            return 0;
+        }
+      else if (c != pattern->wildcard && c != buf[i])
+        return 0;
+    }
+  return 1;
+}
+
+
+static int
+cm_compile (st_cm_automaton_t *automaton)
+/*
+  Build an Aho-Corasick automaton for the longest run of normal characters
+  (anchor) of each pattern. A state has a transition for every byte value, so
+  searching takes one table lookup per byte. output[state] is the first
+  pattern whose anchor ends in state, dict[state] the nearest state on the
+  chain of failure links that has an output.
+*/
+{
+  int n, n_states = 1, *fail = NULL, *queue = NULL;
+  size_t max_states = 1, head = 0, tail = 0;
+
+  for (n = 0; n < automaton->n_patterns; n++)
+    max_states += automaton->patterns[n]->search_size;
+  if ((automaton->delta = (int *) malloc (max_states * 256 * sizeof (int))) == NULL ||
+      (automaton->output = (int *) malloc (max_states * sizeof (int))) == NULL ||
+      (automaton->dict = (int *) malloc (max_states * sizeof (int))) == NULL ||
+      (automaton->next = (int *) malloc (automaton->n_patterns * sizeof (int) + 1)) == NULL ||
+      (automaton->anchor_end = (size_t *)
+         malloc (automaton->n_patterns * sizeof (size_t) + 1)) == NULL ||
+      (fail = (int *) malloc (max_states * sizeof (int))) == NULL ||
+      (queue = (int *) malloc (max_states * sizeof (int))) == NULL)
+    {
+      fprintf (stderr, "ERROR: Not enough memory for buffer (%u bytes)\n",
+               (unsigned int) (max_states * 256 * sizeof (int)));
+      free (fail);
+      return -1;
+    }
+  memset (automaton->delta, 0, 256 * sizeof (int));
+  automaton->output[0] = -1;
+
+  // build the trie of the anchors
+  for (n = 0; n < automaton->n_patterns; n++)
+    {
+      const st_cm_pattern_t *pattern = automaton->patterns[n];
+      size_t i, start = 0, len = 0, run = 0;
+      int state = 0;
+
+      for (i = 0; i < pattern->search_size; i++)
+        if (pattern->search[i] == pattern->escape ||
+            pattern->search[i] == pattern->wildcard)
+          run = 0;
+        else if (++run > len)
+          {
+            len = run;
+            start = i + 1 - run;
+          }
+      automaton->next[n] = -1;
+      if (len == 0)
+        {
+          automaton->anchor_end[n] = (size_t) -1; // no anchor, always a candidate
+          continue;
+        }
+      automaton->anchor_end[n] = start + len - 1;
+      for (i = start; i < start + len; i++)
+        {
+          int *t = &automaton->delta[state * 256 + (unsigned char) pattern->search[i]];
+
+          if (*t == 0)
+            {
+              *t = n_states;
+              memset (&automaton->delta[n_states * 256], 0, 256 * sizeof (int));
+              automaton->output[n_states] = -1;
+              n_states++;
+            }
+          state = *t;
+        }
+      // append n, so that patterns with the same anchor stay in order
+      if (automaton->output[state] == -1)
+        automaton->output[state] = n;
+      else
+        {
+          int m = automaton->output[state];
+
+          while (automaton->next[m] != -1)
+            m = automaton->next[m];
+          automaton->next[m] = n;
+        }
+    }
+
+  // breadth-first: set the failure links and turn the trie into a DFA
+  fail[0] = automaton->dict[0] = 0;
+  for (n = 0; n < 256; n++)
+    if (automaton->delta[n])
+      {
+        fail[automaton->delta[n]] = automaton->dict[automaton->delta[n]] = 0;
+        queue[tail++] = automaton->delta[n];
+      }
+  while (head < tail)
+    {
+      int state = queue[head++];
+
+      for (n = 0; n < 256; n++)
+        {
+          int *t = &automaton->delta[state * 256 + n],
+              f = automaton->delta[fail[state] * 256 + n];
+
+          if (*t)
+            {
+              fail[*t] = f;
+              automaton->dict[*t] = automaton->output[f] != -1 ? f : automaton->dict[f];
+              queue[tail++] = *t;
+            }
+          else
+            *t = f;
+        }
+    }
+
+  free (queue);
+  free (fail);
+  automaton->n_states = n_states;
+  return 0;
+}
+
+
+int
+add_cm_patterns (st_cm_automaton_t *automaton, const st_cm_pattern_t *patterns,
+                 int n_patterns)
+{
+  int n;
+
+  if (n_patterns <= 0)                          // build_cm_patterns() may return -1
+    return 0;
+  n = automaton->n_patterns + n_patterns;
+  if ((automaton->patterns = (const st_cm_pattern_t **)
+         realloc (automaton->patterns, n * sizeof (st_cm_pattern_t *))) == NULL ||
+      (automaton->n_found = (unsigned int *)
+         realloc (automaton->n_found, n * sizeof (unsigned int))) == NULL ||
+      (automaton->matched = (unsigned char *) realloc (automaton->matched, n)) == NULL)
+    {
+      fprintf (stderr, "ERROR: Not enough memory for buffer (%u bytes)\n",
+               (unsigned int) (n * sizeof (st_cm_pattern_t *)));
+      return -1;
+    }
+  for (; automaton->n_patterns < n; automaton->n_patterns++, patterns++)
+    {
+      automaton->patterns[automaton->n_patterns] = patterns;
+      automaton->n_found[automaton->n_patterns] = 0;
+    }
+
+  // the automaton is built (again) by the next call to find_cm_patterns()
+  free (automaton->delta);
+  automaton->delta = NULL;
+  free (automaton->output);
+  automaton->output = NULL;
+  free (automaton->dict);
+  automaton->dict = NULL;
+  free (automaton->next);
+  automaton->next = NULL;
+  free (automaton->anchor_end);
+  automaton->anchor_end = NULL;
+  return 0;
+}
+
+
+int
+find_cm_patterns (st_cm_automaton_t *automaton, const char *buf, size_t bufsize,
+                  int first)
+{
+  const int *delta, *output, *dict, *next;
+  int n, n_left = 0, state = 0;
+  size_t i;
+
+  if (automaton->delta == NULL && automaton->n_patterns > 0 &&
+      cm_compile (automaton) == -1)
+    exit (1);
+  delta = automaton->delta;
+  output = automaton->output;
+  dict = automaton->dict;
+  next = automaton->next;
+
+  for (n = first; n < automaton->n_patterns; n++)
+    if (automaton->anchor_end[n] == (size_t) -1)
+      automaton->matched[n] = 1;
+    else
+      {
+        automaton->matched[n] = 0;
+        n_left++;
+      }
+
+  for (i = 0; i < bufsize && n_left; i++)
+    {
+      int s;
+
+      state = delta[state * 256 + (unsigned char) buf[i]];
+      for (s = output[state] != -1 ? state : dict[state]; s; s = dict[s])
+        for (n = output[s]; n != -1; n = next[n])
+          {
+            const st_cm_pattern_t *pattern = automaton->patterns[n];
+            size_t start = i - automaton->anchor_end[n];
+
+            if (n >= first && !automaton->matched[n] &&
+                i >= automaton->anchor_end[n] &&
+                start + pattern->search_size <= bufsize &&
+                cm_match (pattern, buf + start))
+              {
+                automaton->matched[n] = 1;
+                n_left--;
+              }
+          }
+    }
+
+  for (n = first, n_left = 0; n < automaton->n_patterns; n++)
+    n_left += automaton->matched[n];
+  return n_left;
+}
+
+
+int
+change_mem_patterns (char *buf, size_t bufsize, st_cm_automaton_t *automaton)
+/*
+  Same as calling change_mem2() for all patterns of automaton in the order in
+  which they were added, but change_mem2() is only called for the patterns
+  that find_cm_patterns() found. The buffer has to be searched again only
+  after a pattern has changed it.
+*/
+{
+  int n, n_matches = 0;
+
+  find_cm_patterns (automaton, buf, bufsize, 0);
+  for (n = 0; n < automaton->n_patterns; n++)
+    if (automaton->matched[n])
+      {
+        const st_cm_pattern_t *pattern = automaton->patterns[n];
+        int n_found = change_mem2 (buf, bufsize, pattern->search,
+                                   pattern->search_size, pattern->wildcard,
+                                   pattern->escape, pattern->replace,
+                                   pattern->replace_size, pattern->offset,
+                                   pattern->sets);
+
+        automaton->n_found[n] += n_found;
+        n_matches += n_found;
+        if (n_found && n + 1 < automaton->n_patterns)
+          find_cm_patterns (automaton, buf, bufsize, n + 1);
+      }
+  return n_matches;
+}
+
+
+void
+cleanup_cm_automaton (st_cm_automaton_t *automaton)
+{
+  free (automaton->patterns);
+  free (automaton->n_found);
+  free (automaton->matched);
+  free (automaton->delta);
+  free (automaton->output);
+  free (automaton->dict);
+  free (automaton->next);
+  free (automaton->anchor_end);
+  memset (automaton, 0, sizeof (st_cm_automaton_t));
+}
+
+
 char *
 getenv2 (const char *variable)
 /*
@@ -164,6 +164,15 @@ extern void dumper (FILE *output, const void *buffer, size_t bufferlen,
                   from a file
   cleanup_cm_patterns() helper function for build_cm_patterns() to free all
                   memory allocated for a (list of) st_pattern_t structure(s)
+  add_cm_patterns() add patterns to an automaton that finds all of them in one
+                  pass; the patterns must stay valid until
+                  cleanup_cm_automaton() is called
+  find_cm_patterns() set matched[n] for every pattern n >= first that occurs in
+                  buf; returns the number of patterns that occur
+  change_mem_patterns() same as calling change_mem2() for every pattern of an
+                  automaton in order, but buf is searched only once (unless
+                  a pattern changes it); n_found counts the matches per pattern
+  cleanup_cm_automaton() free all memory allocated for an automaton
   bytes_per_second() returns bytes per second (useful in combination with
                   gauge())
   misc_percent()  returns percentage of progress (useful in combination with
@@ -201,6 +210,20 @@ typedef struct st_cm_pattern
   int offset;
   st_cm_set_t *sets;
 } st_cm_pattern_t;
+
+typedef struct st_cm_automaton
+{
+  const st_cm_pattern_t **patterns;
+  int n_patterns;
+  unsigned int *n_found;                        // matches per pattern
+  unsigned char *matched;                       // set by find_cm_patterns()
+  int *delta;                                   // transitions (256 per state)
+  int *output;                                  // first pattern ending in state
+  int *dict;                                    // next state with an output
+  int *next;                                    // next pattern with same anchor
+  size_t *anchor_end;                           // last anchor char per pattern
+  int n_states;
+} st_cm_automaton_t;
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
@@ -213,6 +236,13 @@ extern int change_mem2 (char *buf, size_t bufsize, const char *searchstr,
                         size_t newsize, int offset, const st_cm_set_t *sets);
 extern int build_cm_patterns (st_cm_pattern_t **patterns, const char *filename);
 extern void cleanup_cm_patterns (st_cm_pattern_t **patterns, int n_patterns);
+extern int add_cm_patterns (st_cm_automaton_t *automaton,
+                            const st_cm_pattern_t *patterns, int n_patterns);
+extern int find_cm_patterns (st_cm_automaton_t *automaton, const char *buf,
+                             size_t bufsize, int first);
+extern int change_mem_patterns (char *buf, size_t bufsize,
+                                st_cm_automaton_t *automaton);
+extern void cleanup_cm_automaton (st_cm_automaton_t *automaton);
 extern int cm_verbose;
 
 extern unsigned int bytes_per_second (time_t start_time, size_t nbytes);
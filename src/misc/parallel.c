@@ -294,7 +294,7 @@ unsigned char
 inportb (unsigned short port)
 {
 #ifdef  USE_PPDEV
-  int ppreg = port - ucon64.parport;
+  int ppreg = port - ucon64_settings.parport;
   unsigned char byte;
 
   switch (ppreg)
@@ -366,7 +366,7 @@ inportb (unsigned short port)
   if (DoIO ((struct IORequest *) parport_io_req))
     {
       fprintf (stderr, "ERROR: Could not communicate with parallel port (%s, %u)\n",
-               ucon64.parport_dev, ucon64.parport);
+               ucon64_settings.parport_dev, ucon64_settings.parport);
       exit (1);
     }
 
@@ -385,7 +385,7 @@ unsigned short
 inportw (unsigned short port)
 {
 #ifdef  USE_PPDEV
-  int ppreg = port - ucon64.parport;
+  int ppreg = port - ucon64_settings.parport;
   unsigned char buf[2];
 
   switch (ppreg)
@@ -430,7 +430,7 @@ inportw (unsigned short port)
   if (DoIO ((struct IORequest *) parport_io_req))
     {
       fprintf (stderr, "ERROR: Could not communicate with parallel port (%s, %u)\n",
-               ucon64.parport_dev, ucon64.parport);
+               ucon64_settings.parport_dev, ucon64_settings.parport);
       exit (1);
     }
 
@@ -449,7 +449,7 @@ void
 outportb (unsigned short port, unsigned char byte)
 {
 #ifdef  USE_PPDEV
-  int ppreg = port - ucon64.parport;
+  int ppreg = port - ucon64_settings.parport;
 
   switch (ppreg)
     {
@@ -504,7 +504,7 @@ outportb (unsigned short port, unsigned char byte)
   if (DoIO ((struct IORequest *) parport_io_req))
     {
       fprintf (stderr, "ERROR: Could not communicate with parallel port (%s, %u)\n",
-               ucon64.parport_dev, ucon64.parport);
+               ucon64_settings.parport_dev, ucon64_settings.parport);
       exit (1);
     }
 #elif   defined _WIN32 || defined __CYGWIN__
@@ -521,7 +521,7 @@ void
 outportw (unsigned short port, unsigned short word)
 {
 #ifdef  USE_PPDEV
-  int ppreg = port - ucon64.parport;
+  int ppreg = port - ucon64_settings.parport;
   unsigned char buf[2];
 
   // words are written in little endian format
@@ -568,7 +568,7 @@ outportw (unsigned short port, unsigned short word)
   if (DoIO ((struct IORequest *) parport_io_req))
     {
       fprintf (stderr, "ERROR: Could not communicate with parallel port (%s, %u)\n",
-               ucon64.parport_dev, ucon64.parport);
+               ucon64_settings.parport_dev, ucon64_settings.parport);
       exit (1);
     }
 #elif   defined _WIN32 || defined __CYGWIN__
@@ -659,12 +659,12 @@ parport_open (unsigned short port)
   if (port == PARPORT_UNKNOWN)
     port = 0;
 
-  parport_io_fd = open (ucon64.parport_dev, O_RDWR);
+  parport_io_fd = open (ucon64_settings.parport_dev, O_RDWR);
   if (parport_io_fd == -1)
     {
       fprintf (stderr, "ERROR: Could not open parallel port device (%s)\n"
                        "       Check if you have the required privileges\n",
-               ucon64.parport_dev);
+               ucon64_settings.parport_dev);
       exit (1);
     }
 
@@ -673,7 +673,7 @@ parport_open (unsigned short port)
     {
       fprintf (stderr, "ERROR: Could not get exclusive access to parallel port device (%s)\n"
                        "       Check if another module (like lp) uses the module parport\n",
-               ucon64.parport_dev);
+               ucon64_settings.parport_dev);
       exit (1);
     }
 
@@ -721,12 +721,12 @@ parport_open (unsigned short port)
   if (port == PARPORT_UNKNOWN)
     port = 0;
 
-  x = OpenDevice (ucon64.parport_dev, port, (struct IORequest *) parport_io_req,
+  x = OpenDevice (ucon64_settings.parport_dev, port, (struct IORequest *) parport_io_req,
                   (ULONG) 0);
   if (x != 0)
     {
       fprintf (stderr, "ERROR: Could not open parallel port (%s, %u)\n",
-               ucon64.parport_dev, port);
+               ucon64_settings.parport_dev, port);
       DeleteExtIO ((struct IOExtPar *) parport_io_req);
       DeletePort (parport);
       exit (1);
@@ -793,7 +793,7 @@ parport_open (unsigned short port)
 
   io_driver = NULL;
 
-  snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64.configdir,
+  snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64_settings.configdir,
             "dlportio.dll");
   fname[FILENAME_MAX - 1] = '\0';
 #if 0 // we must not do this for Cygwin or access() won't "find" the file
@@ -823,7 +823,7 @@ parport_open (unsigned short port)
 
   if (!driver_found)
     {
-      snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64.configdir,
+      snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64_settings.configdir,
                 "io.dll");
       fname[FILENAME_MAX - 1] = '\0';
       if (access (fname, F_OK) == 0)
@@ -856,7 +856,7 @@ parport_open (unsigned short port)
 
   if (!driver_found)
     {
-      snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64.configdir,
+      snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64_settings.configdir,
                 "inpout32.dll");
       fname[FILENAME_MAX - 1] = '\0';
       if (access (fname, F_OK) == 0)
@@ -1005,18 +1005,18 @@ parport_setup (unsigned short port, parport_mode_t mode)
   ioctl (parport_io_fd, PPSETMODE, &parport_io_mode);
 #elif   defined __i386__ || defined __x86_64__ || defined _WIN32
   {
-    const char *p = get_property (ucon64.configfile, "ecr_offset", PROPERTY_MODE_TEXT);
+    const char *p = get_property (ucon64_settings.configfile, "ecr_offset", PROPERTY_MODE_TEXT);
 
     if (p)
-      sscanf (p, "%hx", &ucon64.ecr_offset);
+      sscanf (p, "%hx", &ucon64_settings.ecr_offset);
     else
-      ucon64.ecr_offset = 0x402;
+      ucon64_settings.ecr_offset = 0x402;
   }
-  if ((uint16_t) (port + ucon64.ecr_offset) < 0x100)
-    ucon64.ecr_offset = 0xffff - port;
+  if ((uint16_t) (port + ucon64_settings.ecr_offset) < 0x100)
+    ucon64_settings.ecr_offset = 0xffff - port;
 /*
-  printf ("ecr_offset: 0x%hx, ECR address: 0x%hx\n", ucon64.ecr_offset,
-          port + ucon64.ecr_offset);
+  printf ("ecr_offset: 0x%hx, ECR address: 0x%hx\n", ucon64_settings.ecr_offset,
+          port + ucon64_settings.ecr_offset);
 //*/
 
   /*
@@ -1029,14 +1029,14 @@ parport_setup (unsigned short port, parport_mode_t mode)
   */
   if (port != 0x3bc) // The ECP registers are not available if port is 0x3bc.
     {
-      unsigned char ecr = inportb (port + ucon64.ecr_offset) & 0x1f;
+      unsigned char ecr = inportb (port + ucon64_settings.ecr_offset) & 0x1f;
 
       if (mode == PPMODE_SPP)
-        outportb (port + ucon64.ecr_offset, ecr);
+        outportb (port + ucon64_settings.ecr_offset, ecr);
       else if (mode == PPMODE_SPP_BIDIR)
-        outportb (port + ucon64.ecr_offset, ecr | 0x20);
+        outportb (port + ucon64_settings.ecr_offset, ecr | 0x20);
       else // if (mode == PPMODE_EPP)
-        outportb (port + ucon64.ecr_offset, ecr | 0x80);
+        outportb (port + ucon64_settings.ecr_offset, ecr | 0x80);
     }
   else if (mode == PPMODE_EPP)
     mode = PPMODE_SPP_BIDIR;
@@ -1135,12 +1135,12 @@ void
 parport_print_info (void)
 {
 #ifdef  USE_PPDEV
-  printf ("Using parallel port device: %s\n", ucon64.parport_dev);
+  printf ("Using parallel port device: %s\n", ucon64_settings.parport_dev);
 #elif   defined AMIGA
-  printf ("Using parallel port device: %s, port %u\n", ucon64.parport_dev, ucon64.parport);
+  printf ("Using parallel port device: %s, port %u\n", ucon64_settings.parport_dev, ucon64_settings.parport);
 #else
   printf ("Using I/O port base: 0x%hx; I/O port Extended Control register: 0x%hx\n",
-          ucon64.parport, (unsigned short) (ucon64.parport + ucon64.ecr_offset));
+          ucon64_settings.parport, (unsigned short) (ucon64_settings.parport + ucon64_settings.ecr_offset));
 #endif
 }
 
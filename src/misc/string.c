@@ -183,20 +183,235 @@ memcmp2 (const void *buffer, const void *search, size_t searchlen, unsigned int
 }
 
 
+#define MEMMEM2_FLAGS (MEMMEM2_WCARD (0xff) | MEMMEM2_REL | MEMMEM2_CASE)
+#define MEMMEM2_NAIVE     0                     // empty or too short search string
+#define MEMMEM2_MEMCHR    1                     // short exact search string
+#define MEMMEM2_HORSPOOL  2
+#define MEMMEM2_SHIFT_AND 3                     // search string with wildcards
+#define MEMMEM2_DELTA     4                     // relative search
+#define MEMMEM2_MEMCHR_MAX 3                    // longer strings use Horspool
+#define MEMMEM2_SMALL_BUFFER 256                // memmem2() won't prepare a search
+
+
+static int
+memmem2_is_wcard (const st_memmem2_t *m, size_t i)
+{
+  return m->flags & MEMMEM2_WCARD (0) && m->search[i] == (m->flags & 0xff);
+}
+
+
+static size_t
+memmem2_variants (const st_memmem2_t *m, size_t i, unsigned char *variants)
+// store the bytes that match byte i of the search string (no wildcard)
+{
+  unsigned char c = m->search[i];
+
+  variants[0] = c;
+  if (m->flags & MEMMEM2_CASE && isalpha (c))
+    {
+      variants[1] = (unsigned char) tolower (c);
+      variants[2] = (unsigned char) toupper (c);
+      return 3;
+    }
+  return 1;
+}
+
+
+void
+memmem2_init (st_memmem2_t *m, const void *search, size_t searchlen,
+              unsigned int flags)
+{
+  size_t i, j, n, max_skip;
+  unsigned char variants[3];
+
+  m->search = (const unsigned char *) search;
+  m->searchlen = searchlen;
+  m->flags = flags & MEMMEM2_FLAGS;
+  m->first = -1;
+  if (searchlen == 0 || (m->flags & MEMMEM2_REL && searchlen < 2))
+    {
+      m->method = MEMMEM2_NAIVE;
+      return;
+    }
+  if (m->flags & MEMMEM2_REL)
+    {
+      /*
+        A relative search is an exact search in the stream of differences
+        between neighbouring bytes, so it can use Horspool too. skip[c] is
+        the distance between the last difference of the search string and
+        the last earlier occurrence of c in its differences. The differences
+        are compared modulo 256, so matches have to be checked with
+        memcmp2().
+      */
+      size_t last = searchlen - 2;              // index of the last difference
+
+      m->method = MEMMEM2_DELTA;
+      for (j = 0; j < 256; j++)
+        m->skip[j] = last + 1;
+      for (i = 0; i < last; i++)
+        m->skip[(unsigned char) (m->search[i] - m->search[i + 1])] = last - i;
+      memset (m->mask, 0, sizeof (m->mask));
+      m->mask[(unsigned char) (m->search[last] - m->search[last + 1])] = 1;
+      return;
+    }
+
+  /*
+    Candidates can be found with memchr() (which libc usually implements with
+    SIMD instructions) if the first byte of the search string matches only
+    itself.
+  */
+  if (!memmem2_is_wcard (m, 0) && memmem2_variants (m, 0, variants) == 1)
+    m->first = m->search[0];
+
+  if (m->flags & MEMMEM2_WCARD (0) && searchlen <= 32)
+    {
+      /*
+        Shift-and (bitap): bit i of mask[c] is set if byte c matches byte i of
+        the search string. Wildcards near the end of the search string don't
+        slow it down, unlike Horspool.
+      */
+      m->method = MEMMEM2_SHIFT_AND;
+      memset (m->mask, 0, sizeof (m->mask));
+      for (i = 0; i < searchlen; i++)
+        if (memmem2_is_wcard (m, i))
+          for (j = 0; j < 256; j++)
+            m->mask[j] |= 1U << i;
+        else
+          for (j = 0, n = memmem2_variants (m, i, variants); j < n; j++)
+            m->mask[variants[j]] |= 1U << i;
+      return;
+    }
+
+  if (m->first != -1 && !m->flags && searchlen <= MEMMEM2_MEMCHR_MAX)
+    {
+      // Horspool cannot skip more than searchlen bytes, so memchr() is faster
+      m->method = MEMMEM2_MEMCHR;
+      return;
+    }
+
+  /*
+    Horspool: skip[c] is the distance between the last byte of the search
+    string and the last earlier occurrence of c in it. A wildcard matches any
+    byte, so it limits the distance for all bytes. mask[c] is non-zero if c
+    matches the last byte.
+  */
+  m->method = MEMMEM2_HORSPOOL;
+  max_skip = searchlen;
+  for (i = 0; i < searchlen - 1; i++)
+    if (memmem2_is_wcard (m, i))
+      max_skip = searchlen - 1 - i;
+  for (j = 0; j < 256; j++)
+    m->skip[j] = max_skip;
+  for (i = 0; i < searchlen - 1; i++)
+    if (!memmem2_is_wcard (m, i) && searchlen - 1 - i < max_skip)
+      for (j = 0, n = memmem2_variants (m, i, variants); j < n; j++)
+        m->skip[variants[j]] = searchlen - 1 - i;
+  memset (m->mask, 0, sizeof (m->mask));
+  if (memmem2_is_wcard (m, searchlen - 1))
+    for (j = 0; j < 256; j++)
+      m->mask[j] = 1;
+  else
+    for (j = 0, n = memmem2_variants (m, searchlen - 1, variants); j < n; j++)
+      m->mask[variants[j]] = 1;
+}
+
+
+const void *
+memmem2_find (const st_memmem2_t *m, const void *buffer, size_t bufferlen)
+{
+  const unsigned char *b = (const unsigned char *) buffer, *end, *s = m->search;
+  size_t len = m->searchlen;
+
+  if (bufferlen < len)
+    return NULL;
+  end = b + bufferlen - len;                    // last possible start of a match
+
+  switch (m->method)
+    {
+    case MEMMEM2_MEMCHR:
+      while ((b = (const unsigned char *)
+                memchr (b, m->first, (size_t) (end - b) + 1)) != NULL)
+        {
+          if (!memcmp (b + 1, s + 1, len - 1))
+            return b;
+          if (b++ == end)
+            break;
+        }
+      return NULL;
+
+    case MEMMEM2_HORSPOOL:
+      while (b <= end)
+        {
+          unsigned char c = b[len - 1];
+
+          if (m->mask[c] &&
+              (m->flags ? !memcmp2 (b, s, len - 1, m->flags) : !memcmp (b, s, len - 1)))
+            return b;
+          b += m->skip[c];
+        }
+      return NULL;
+
+    case MEMMEM2_SHIFT_AND:
+      {
+        const unsigned char *p = b, *p_end = b + bufferlen;
+        unsigned int state = 0, hit = 1U << (len - 1);
+
+        while (p < p_end)
+          {
+            if (state == 0 && m->first != -1)
+              {
+                // no partial match, so skip to the next candidate
+                if ((p = (const unsigned char *)
+                       memchr (p, m->first, (size_t) (p_end - p))) == NULL)
+                  return NULL;
+              }
+            state = ((state << 1) | 1U) & m->mask[*p++];
+            if (state & hit)
+              return p - len;
+          }
+        return NULL;
+      }
+
+    case MEMMEM2_DELTA:
+      while (b <= end)
+        {
+          unsigned char c = (unsigned char) (b[len - 2] - b[len - 1]);
+
+          if (m->mask[c] && !memcmp2 (b, s, len, m->flags))
+            return b;
+          b += m->skip[c];
+        }
+      return NULL;
+
+    default:                                    // MEMMEM2_NAIVE
+      for (; b <= end; b++)
+        if (!memcmp2 (b, s, len, m->flags))
+          return b;
+      return NULL;
+    }
+}
+
+
 const void *
 memmem2 (const void *buffer, size_t bufferlen,
          const void *search, size_t searchlen, unsigned int flags)
 {
-  if (bufferlen >= searchlen)
+  st_memmem2_t m;
+
+  if (bufferlen < searchlen)
+    return NULL;
+  if (bufferlen < MEMMEM2_SMALL_BUFFER)         // preparing takes longer
     {
       size_t i;
 
       for (i = 0; i <= bufferlen - searchlen; i++)
-        if (!memcmp2 ((const unsigned char *) buffer + i, search, searchlen, flags))
+        if (!memcmp2 ((const unsigned char *) buffer + i, search, searchlen,
+                      flags & MEMMEM2_FLAGS))
           return (const unsigned char *) buffer + i;
+      return NULL;
     }
-
-  return NULL;
+  memmem2_init (&m, search, searchlen, flags);
+  return memmem2_find (&m, buffer, bufferlen);
 }
 
 
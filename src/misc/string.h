@@ -60,6 +60,10 @@ extern "C" {
                   look for relative/shifted similarities
                   MEMMEM2_CASE
                   ignore case of isalpha() bytes
+  memmem2_init() prepare a search with the same flags as memmem2() once, so that
+                  memmem2_find() can be called for many buffers; use it
+                  instead of memmem2() for large or repeated searches
+  memmem2_find() find the search string of a st_memmem2_t in buffer
   stristr()     same as strcasestr()
   stricmp()     same as strcasecmp()
   strnicmp()    same as strncasecmp()
@@ -83,6 +87,27 @@ extern int memcmp2 (const void *buffer,
 #define MEMMEM2_CASE      MEMCMP2_CASE
 extern const void *memmem2 (const void *buffer, size_t bufferlen,
                             const void *search, size_t searchlen, unsigned int flags);
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct st_memmem2
+{
+  const unsigned char *search;
+  size_t searchlen;
+  unsigned int flags;                           // only the MEMMEM2_* flags
+  int method;
+  int first;                                    // first byte for memchr() or -1
+  size_t skip[256];                             // Horspool shift per byte
+  unsigned int mask[256];                       // shift-and match bits per byte
+} st_memmem2_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+extern void memmem2_init (st_memmem2_t *m, const void *search, size_t searchlen,
+                          unsigned int flags);
+extern const void *memmem2_find (const st_memmem2_t *m, const void *buffer,
+                                 size_t bufferlen);
 extern char *strcasestr2 (const char *str, const char *search);
 #define stristr strcasestr2
 #ifndef _WIN32
@@ -0,0 +1,523 @@
+/*
+xform.c - byte layout transformations
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifdef  TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+#include <string.h>
+#include "misc/itypes.h"
+#include "misc/xform.h"
+
+
+void
+mem_bswap16 (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer;
+  size_t i;
+
+  for (i = 0; i + 1 < n; i += 2)
+    {
+      unsigned char tmp = p[i];
+      p[i] = p[i + 1];
+      p[i + 1] = tmp;
+    }
+}
+
+
+void
+mem_wswap32 (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer;
+  size_t i;
+
+  for (i = 0; i + 3 < n; i += 4)
+    {
+      uint32_t x;
+
+      // memcpy() keeps this safe for unaligned buffers; compilers turn it
+      //  into a plain load and store
+      memcpy (&x, p + i, 4);
+      x = (x >> 16) | (x << 16);
+      memcpy (p + i, &x, 4);
+    }
+}
+
+
+void
+mem_bswap32 (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer;
+  size_t i;
+
+  for (i = 0; i + 3 < n; i += 4)
+    {
+      unsigned char tmp = p[i];
+      p[i] = p[i + 3];
+      p[i + 3] = tmp;
+      tmp = p[i + 1];
+      p[i + 1] = p[i + 2];
+      p[i + 2] = tmp;
+    }
+}
+
+
+void
+mem_bitrev (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer;
+  size_t i;
+
+  // swap adjacent bits, then pairs of bits, then nibbles (no table lookups,
+  //  so that this vectorizes)
+  for (i = 0; i < n; i++)
+    {
+      unsigned int x = p[i];
+
+      x = ((x & 0x55) << 1) | ((x >> 1) & 0x55);
+      x = ((x & 0x33) << 2) | ((x >> 2) & 0x33);
+      p[i] = (unsigned char) ((x << 4) | (x >> 4));
+    }
+}
+
+
+void
+mem_split16 (void *even, void *odd, const void *src, size_t n)
+{
+  unsigned char *e = (unsigned char *) even, *o = (unsigned char *) odd;
+  const unsigned char *s = (const unsigned char *) src;
+  size_t i;
+
+  n >>= 1;
+  for (i = 0; i < n; i++)
+    {
+      e[i] = s[i << 1];
+      o[i] = s[(i << 1) + 1];
+    }
+}
+
+
+void
+mem_merge16 (void *dest, const void *even, const void *odd, size_t n)
+{
+  unsigned char *d = (unsigned char *) dest;
+  const unsigned char *e = (const unsigned char *) even,
+                      *o = (const unsigned char *) odd;
+  size_t i;
+
+  n >>= 1;
+  for (i = 0; i < n; i++)
+    {
+      d[i << 1] = e[i];
+      d[(i << 1) + 1] = o[i];
+    }
+}
+
+
+void
+block_view_init (st_block_view_t *view, const void *data, size_t size)
+{
+  view->data = (const unsigned char *) data;
+  view->size = size;
+  view->block_size = 0;
+  view->nblocks = 0;
+  view->blocks = NULL;
+  view->split16 = 0;
+}
+
+
+static void
+merge16_range (unsigned char *dest, const unsigned char *block, size_t half,
+               size_t k, size_t n)
+// merge the bytes [k, k + n) of a block in SMD layout into dest
+{
+  if (n && (k & 1))
+    {
+      *dest++ = block[k >> 1];
+      k++;
+      n--;
+    }
+  mem_merge16 (dest, block + half + (k >> 1), block + (k >> 1), n & ~(size_t) 1);
+  if (n & 1)
+    dest[n - 1] = block[half + ((k + n - 1) >> 1)];
+}
+
+
+const unsigned char *
+block_view_data (const st_block_view_t *view, size_t pos, size_t *n,
+                 unsigned char *scratch, size_t scratch_size)
+{
+  if (pos >= view->size)
+    {
+      *n = *n < scratch_size ? *n : scratch_size;
+      memset (scratch, 0, *n);
+      return scratch;
+    }
+  if (pos < view->nblocks * view->block_size)
+    {
+      size_t i = pos / view->block_size, offset = pos % view->block_size,
+             len = view->block_size - offset;
+      const unsigned char *block = view->data +
+        (view->blocks ? view->blocks[i] : i) * view->block_size;
+
+      if (*n > len)
+        *n = len;
+      if (!view->split16)
+        return block + offset;
+      if (*n > scratch_size)
+        *n = scratch_size;
+      merge16_range (scratch, block, view->block_size >> 1, offset, *n);
+      return scratch;
+    }
+  if (*n > view->size - pos)
+    *n = view->size - pos;
+  return view->data + pos;
+}
+
+
+void
+block_view_read (const st_block_view_t *view, void *dest, size_t pos, size_t n)
+{
+  unsigned char *d = (unsigned char *) dest;
+
+  while (n > 0)
+    {
+      size_t len = n;
+      const unsigned char *p = block_view_data (view, pos, &len, d, n);
+
+      if (p != d)
+        memcpy (d, p, len);
+      d += len;
+      pos += len;
+      n -= len;
+    }
+}
+
+
+#ifdef  TEST
+static void
+ref_bswap16 (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer, tmp;
+  size_t i;
+
+  for (i = 0; i < n / 2 * 2; i += 2)
+    {
+      tmp = p[i];
+      p[i] = p[i + 1];
+      p[i + 1] = tmp;
+    }
+}
+
+
+static void
+ref_wswap32 (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer, tmp[2];
+  size_t i;
+
+  for (i = 0; i < n / 4 * 4; i += 4)
+    {
+      memcpy (tmp, p + i, 2);
+      memcpy (p + i, p + i + 2, 2);
+      memcpy (p + i + 2, tmp, 2);
+    }
+}
+
+
+static void
+ref_bswap32 (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer, tmp[4];
+  size_t i;
+
+  for (i = 0; i < n / 4 * 4; i += 4)
+    {
+      tmp[0] = p[i + 3];
+      tmp[1] = p[i + 2];
+      tmp[2] = p[i + 1];
+      tmp[3] = p[i];
+      memcpy (p + i, tmp, 4);
+    }
+}
+
+
+static void
+ref_bitrev (void *buffer, size_t n)
+{
+  unsigned char *p = (unsigned char *) buffer;
+  size_t i;
+  int bit;
+
+  for (i = 0; i < n; i++)
+    {
+      unsigned char x = 0;
+
+      for (bit = 0; bit < 8; bit++)
+        if (p[i] & (1 << bit))
+          x |= (unsigned char) (0x80 >> bit);
+      p[i] = x;
+    }
+}
+
+
+static void
+ref_split16 (void *even, void *odd, const void *src, size_t n)
+{
+  size_t i;
+
+  for (i = 0; i < n / 2; i++)
+    {
+      ((unsigned char *) even)[i] = ((const unsigned char *) src)[2 * i];
+      ((unsigned char *) odd)[i] = ((const unsigned char *) src)[2 * i + 1];
+    }
+}
+
+
+static void
+ref_merge16 (void *dest, const void *even, const void *odd, size_t n)
+{
+  size_t i;
+
+  for (i = 0; i < n / 2; i++)
+    {
+      ((unsigned char *) dest)[2 * i] = ((const unsigned char *) even)[i];
+      ((unsigned char *) dest)[2 * i + 1] = ((const unsigned char *) odd)[i];
+    }
+}
+
+
+static unsigned char
+ref_block_view_byte (const st_block_view_t *view, size_t pos)
+{
+  const unsigned char *block;
+  size_t k;
+
+  if (pos >= view->size)
+    return 0;
+  if (pos >= view->nblocks * view->block_size)
+    return view->data[pos];
+  k = pos % view->block_size;
+  block = view->data + (view->blocks ? view->blocks[pos / view->block_size] :
+                                        pos / view->block_size) * view->block_size;
+  if (!view->split16)
+    return block[k];
+  return k & 1 ? block[k / 2] : block[view->block_size / 2 + k / 2];
+}
+
+
+static void
+xform_fill (unsigned char *buffer, size_t n, unsigned int seed)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    buffer[i] = (unsigned char) ((i + seed) * 2654435761U >> 24);
+}
+
+
+#define XFORM_ROUNDS 16
+
+
+static double
+xform_speed (size_t size, clock_t start)
+{
+  double secs = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  return secs > 0 ? size / (secs * 1024 * 1024) : 0.0;
+}
+
+
+void
+xform_benchmark (void)
+{
+  static const struct
+  {
+    const char *name;
+    void (*func) (void *, size_t);
+    void (*ref) (void *, size_t);
+  } funcs[] =
+    {
+      {"mem_bswap16", mem_bswap16, ref_bswap16},
+      {"mem_wswap32", mem_wswap32, ref_wswap32},
+      {"mem_bswap32", mem_bswap32, ref_bswap32},
+      {"mem_bitrev", mem_bitrev, ref_bitrev},
+      {NULL, NULL, NULL}
+    };
+  static const uint16_t blocks[] = { 2, 0, 3, 1 };
+  const size_t size = 16 * 1024 * 1024;
+  unsigned char buf1[96], buf2[96], buf3[96], buf4[96], scratch[16];
+  unsigned char *buffer = (unsigned char *) malloc (size),
+                *buffer2 = (unsigned char *) malloc (size);
+  size_t align, align2, n, pos;
+  clock_t start;
+  int i, round, split16;
+
+  if (!buffer || !buffer2)
+    {
+      free (buffer);
+      free (buffer2);
+      return;
+    }
+
+  /*
+    Compare every function with its reference for all alignments and lengths
+    (odd ones included) that matter for word-wise code. The whole buffer is
+    compared, so that writes past n are caught as well.
+  */
+  for (i = 0; funcs[i].name; i++)
+    {
+      int errors = 0;
+      double speed, ref_speed;
+
+      for (align = 0; align < 16; align++)
+        for (n = 0; n <= 64 + 7; n++)
+          {
+            xform_fill (buf1, sizeof buf1, (unsigned int) (align + n));
+            memcpy (buf2, buf1, sizeof buf1);
+            funcs[i].func (buf1 + align, n);
+            funcs[i].ref (buf2 + align, n);
+            if (memcmp (buf1, buf2, sizeof buf1))
+              errors++;
+          }
+
+      xform_fill (buffer, size, 0);
+      funcs[i].func (buffer, size);             // warm up
+      start = clock ();
+      for (round = 0; round < XFORM_ROUNDS; round++)
+        funcs[i].func (buffer, size);
+      speed = xform_speed (XFORM_ROUNDS * size, start);
+      start = clock ();
+      for (round = 0; round < XFORM_ROUNDS; round++)
+        funcs[i].ref (buffer, size);
+      ref_speed = xform_speed (XFORM_ROUNDS * size, start);
+      printf ("%-16s %8.1f MB/s (reference %8.1f MB/s)%s\n", funcs[i].name,
+              speed, ref_speed, errors ? " MISMATCH" : "");
+    }
+
+  // mem_split16() and mem_merge16() with independent alignments of source and
+  //  destination
+  {
+    int errors = 0;
+    double speed, ref_speed;
+
+    for (align = 0; align < 8; align++)
+      for (align2 = 0; align2 < 8; align2++)
+        for (n = 0; n <= 64 + 7; n++)
+          {
+            xform_fill (buf1, sizeof buf1, (unsigned int) n);
+            memset (buf2, 0x55, sizeof buf2);
+            memset (buf3, 0x55, sizeof buf3);
+            memset (buf4, 0x55, 2 * 48);
+            mem_split16 (buf2 + align2, buf2 + 48 + align2, buf1 + align, n);
+            ref_split16 (buf4 + align2, buf4 + 48 + align2, buf1 + align, n);
+            if (memcmp (buf2, buf4, sizeof buf2))
+              errors++;
+            mem_merge16 (buf3 + align, buf2 + align2, buf2 + 48 + align2, n);
+            memset (buf4, 0x55, sizeof buf4);
+            ref_merge16 (buf4 + align, buf2 + align2, buf2 + 48 + align2, n);
+            if (memcmp (buf3, buf4, sizeof buf3) ||
+                memcmp (buf3 + align, buf1 + align, n & ~(size_t) 1))
+              errors++;
+          }
+
+    xform_fill (buffer, size, 0);
+    mem_split16 (buffer2, buffer2 + size / 2, buffer, size); // warm up
+    start = clock ();
+    for (round = 0; round < XFORM_ROUNDS; round++)
+      {
+        mem_split16 (buffer2, buffer2 + size / 2, buffer, size);
+        mem_merge16 (buffer, buffer2, buffer2 + size / 2, size);
+      }
+    speed = xform_speed (2 * XFORM_ROUNDS * size, start);
+    start = clock ();
+    for (round = 0; round < XFORM_ROUNDS; round++)
+      {
+        ref_split16 (buffer2, buffer2 + size / 2, buffer, size);
+        ref_merge16 (buffer, buffer2, buffer2 + size / 2, size);
+      }
+    ref_speed = xform_speed (2 * XFORM_ROUNDS * size, start);
+    printf ("%-16s %8.1f MB/s (reference %8.1f MB/s)%s\n",
+            "mem_split/merge16", speed, ref_speed, errors ? " MISMATCH" : "");
+  }
+
+  // block views: reordered blocks and SMD layout, every position and length,
+  //  including reads past the end and scratch buffers that are too small
+  for (split16 = 0; split16 <= 1; split16++)
+    {
+      st_block_view_t view;
+      int errors = 0;
+      double speed, ref_speed;
+      size_t len, k;
+
+      xform_fill (buf1, sizeof buf1, 1);
+      block_view_init (&view, buf1, 4 * 16 + 5);
+      view.block_size = 16;
+      view.nblocks = 4;
+      view.blocks = blocks;
+      view.split16 = split16;
+      for (pos = 0; pos < view.size + 8; pos++)
+        for (len = 0; len <= 40; len++)
+          {
+            block_view_read (&view, buf2, pos, len);
+            for (k = 0; k < len; k++)
+              if (buf2[k] != ref_block_view_byte (&view, pos + k))
+                break;
+            if (k < len)
+              errors++;
+            for (k = 1; k <= sizeof scratch; k++)
+              {
+                size_t m = len;
+                const unsigned char *p =
+                  block_view_data (&view, pos, &m, scratch, k);
+
+                if (m > len || (len && !m) || (p == scratch && m > k) ||
+                    (m && memcmp (p, buf2, m)))
+                  errors++;
+              }
+          }
+
+      xform_fill (buffer, size, 0);
+      block_view_init (&view, buffer, size);
+      view.block_size = 16384;
+      view.nblocks = size / view.block_size;
+      view.split16 = split16;
+      start = clock ();
+      for (round = 0; round < XFORM_ROUNDS; round++)
+        for (pos = 0; pos < size; pos += 65536)
+          block_view_read (&view, buffer2 + pos, pos, 65536);
+      speed = xform_speed (XFORM_ROUNDS * size, start);
+      start = clock ();
+      for (pos = 0; pos < size; pos++)
+        buffer2[pos] = ref_block_view_byte (&view, pos);
+      ref_speed = xform_speed (size, start);
+      printf ("%-16s %8.1f MB/s (reference %8.1f MB/s)%s\n",
+              split16 ? "block_view smd" : "block_view", speed, ref_speed,
+              errors ? " MISMATCH" : "");
+    }
+
+  free (buffer);
+  free (buffer2);
+}
+#endif // TEST
@@ -0,0 +1,111 @@
+/*
+xform.h - byte layout transformations
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifndef MISC_XFORM_H
+#define MISC_XFORM_H
+
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stddef.h>                             // size_t
+#include "misc/itypes.h"
+
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+  The functions below work on plain byte buffers of any alignment. They are
+  written as simple loops without dependencies between iterations, so that
+  the compiler can turn them into vector code for the target CPU.
+
+  mem_bswap16() bswap_16() every 16-bit word of the first n bytes of buffer
+  mem_wswap32() wswap_32() every 32-bit word of the first n bytes of buffer
+  mem_bswap32() bswap_32() every 32-bit word of the first n bytes of buffer
+  mem_bitrev()  reverse the bit order of the first n bytes of buffer
+                  (bit 0 becomes bit 7, bit 1 becomes bit 6, etc.)
+  mem_split16() copy the even bytes of the first n bytes of src to even and
+                  the odd bytes to odd; src may not overlap even or odd
+  mem_merge16() the opposite of mem_split16(); n is the size of dest
+*/
+extern void mem_bswap16 (void *buffer, size_t n);
+extern void mem_wswap32 (void *buffer, size_t n);
+extern void mem_bswap32 (void *buffer, size_t n);
+extern void mem_bitrev (void *buffer, size_t n);
+extern void mem_split16 (void *even, void *odd, const void *src, size_t n);
+extern void mem_merge16 (void *dest, const void *even, const void *odd,
+                         size_t n);
+
+/*
+  A block view presents data in a different block order (and layout) without
+  copying it. Logical block i of the view is physical block blocks[i] of data
+  (block i if blocks is NULL) for the first nblocks blocks. If split16 is set,
+  each of those physical blocks holds the odd bytes of the logical block in its
+  first half and the even bytes in its second half (SMD/MGD layout). The data
+  after the mapped blocks is presented as is and the view reads as zeroes past
+  size.
+
+  block_view_init() initialise view as a view of data as is
+  block_view_data() return a pointer to the data of view at logical offset pos.
+                  On input *n is the maximum number of bytes the caller wants,
+                  on output the number of bytes the pointer is valid for
+                  (at least 1 if *n and scratch_size are not 0). The pointer
+                  points into the data of the view, unless the data had to be
+                  converted. Then it is written to scratch
+  block_view_read() copy n bytes from logical offset pos of view to dest
+
+  xform_benchmark() check the functions above against simple reference code
+                  and compare their speed (TEST only)
+*/
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct st_block_view
+{
+  const unsigned char *data;
+  size_t size;
+  size_t block_size;
+  size_t nblocks;                               // # mapped blocks
+  const uint16_t *blocks;
+  int split16;
+} st_block_view_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+extern void block_view_init (st_block_view_t *view, const void *data,
+                             size_t size);
+extern const unsigned char *block_view_data (const st_block_view_t *view,
+                                             size_t pos, size_t *n,
+                                             unsigned char *scratch,
+                                             size_t scratch_size);
+extern void block_view_read (const st_block_view_t *view, void *dest,
+                             size_t pos, size_t n);
+#ifdef  TEST
+extern void xform_benchmark (void);
+#endif
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif // MISC_XFORM_H
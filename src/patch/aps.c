@@ -41,6 +41,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "ucon64.h"
 #include "ucon64_misc.h"
 #include "patch/aps.h"
+#include "patch/patch.h"
 
 
 #define N64APS_DESCRIPTION_LEN 50
@@ -79,234 +80,192 @@ static FILE *n64aps_apsfile, *n64aps_orgfile, *n64aps_modfile;
 static int n64aps_changefound;
 
 
-static void
-readstdheader (void)
+static int
+readstdheader (st_patch_t *patch)
 {
-  char magic[N64APS_MAGICLENGTH], description[N64APS_DESCRIPTION_LEN + 1];
+  const unsigned char *ptr;
+  char description[N64APS_DESCRIPTION_LEN + 1];
 
-  fread_checked (magic, 1, N64APS_MAGICLENGTH, n64aps_apsfile);
-  if (memcmp (magic, n64aps_magic, N64APS_MAGICLENGTH) != 0)
+  if ((ptr = patch_read (patch, N64APS_MAGICLENGTH + 2 + N64APS_DESCRIPTION_LEN)) == NULL ||
+      memcmp (ptr, n64aps_magic, N64APS_MAGICLENGTH) != 0)
     {
       fputs ("ERROR: Not a valid APS file\n", stderr);
-      fclose (n64aps_modfile);
-      fclose (n64aps_apsfile);
-      exit (1);
+      return -1;
     }
-  n64aps_patchtype = (unsigned char) fgetc (n64aps_apsfile);
+  ptr += N64APS_MAGICLENGTH;
+  n64aps_patchtype = *ptr++;
   if (n64aps_patchtype != 1)                    // N64 patch
     {
       fputs ("ERROR: Could not process patch file\n", stderr);
-      fclose (n64aps_modfile);
-      fclose (n64aps_apsfile);
-      exit (1);
+      return -1;
     }
-  n64aps_encodingmethod = (unsigned char) fgetc (n64aps_apsfile);
+  n64aps_encodingmethod = *ptr++;
   if (n64aps_encodingmethod != 0)               // simple encoding
     {
       fputs ("ERROR: Unknown or new encoding method\n", stderr);
-      fclose (n64aps_modfile);
-      fclose (n64aps_apsfile);
-      exit (1);
+      return -1;
     }
 
-  memset (description, ' ', N64APS_DESCRIPTION_LEN);
-  fread_checked (description, 1, N64APS_DESCRIPTION_LEN, n64aps_apsfile);
+  memcpy (description, ptr, N64APS_DESCRIPTION_LEN);
   description[N64APS_DESCRIPTION_LEN] = '\0';
   printf ("Description: %s\n", description);
+  return 0;
 }
 
 
-static void
-readN64header (void)
+static int
+readN64header (st_patch_t *patch)
 {
   unsigned int n64aps_magictest;
-  unsigned char buffer[8], APSbuffer[8], cartid[2], teritory, APSteritory;
+  unsigned char buffer[8], cartid[2], teritory;
+  const unsigned char *ptr;
 
-  fseek (n64aps_modfile, 0, SEEK_SET);
-  fread_checked (&n64aps_magictest, 4, 1, n64aps_modfile);
-#ifdef  WORDS_BIGENDIAN
-  n64aps_magictest = bswap_32 (n64aps_magictest);
-#endif
-  buffer[0] = (unsigned char) fgetc (n64aps_apsfile); // APS format
-  if (((n64aps_magictest == 0x12408037) && (buffer[0] == 1)) ||
-      ((n64aps_magictest != 0x12408037 && (buffer[0] == 0))))
+  // format (1), cart id (2), teritory (1), CRC (8) and 5 unused bytes
+  if ((ptr = patch_read (patch, 1 + 2 + 1 + 8 + 5)) == NULL || patch->size < 64)
+    {
+      fputs ("ERROR: Image is in the wrong format\n", stderr);
+      return -1;
+    }
+
+  memcpy (&n64aps_magictest, patch->data, 4);
+  n64aps_magictest = le2me_32 (n64aps_magictest);
+  if (((n64aps_magictest == 0x12408037) && (ptr[0] == 1)) ||
+      ((n64aps_magictest != 0x12408037 && (ptr[0] == 0))))
       // 0 for Doctor format, 1 for everything else
     {
       fputs ("ERROR: Image is in the wrong format\n", stderr);
-      fclose (n64aps_modfile);
-      fclose (n64aps_apsfile);
-      exit (1);
+      return -1;
     }
 
-  fseek (n64aps_modfile, 60, SEEK_SET);         // cart id
-  fread_checked (cartid, 1, 2, n64aps_modfile);
-  fread_checked (buffer, 1, 2, n64aps_apsfile);
+  memcpy (cartid, patch->data + 60, 2);         // cart id
   if (n64aps_magictest == 0x12408037)
     {
       unsigned char temp = cartid[0];
       cartid[0] = cartid[1];
       cartid[1] = temp;
     }
-  if ((buffer[0] != cartid[0]) || (buffer[1] != cartid[1]))
+  if ((ptr[1] != cartid[0]) || (ptr[2] != cartid[1]))
     {
       fputs ("ERROR: This patch does not belong to this image\n", stderr);
-      fclose (n64aps_modfile);
-      fclose (n64aps_apsfile);
-      exit (1);
+      return -1;
     }
 
   if (n64aps_magictest == 0x12408037)
-    fseek (n64aps_modfile, 63, SEEK_SET);       // teritory
+    teritory = patch->data[63];
   else
-    fseek (n64aps_modfile, 62, SEEK_SET);
-  teritory = (unsigned char) fgetc (n64aps_modfile);
-  APSteritory = (unsigned char) fgetc (n64aps_apsfile);
-  if (teritory != APSteritory)
+    teritory = patch->data[62];
+  if (teritory != ptr[3])
     {
       puts ("WARNING: Wrong country");
 #if 0
       if (!force)
-        {
-          fclose (n64aps_modfile);
-          fclose (n64aps_apsfile);
-          exit (1);
-        }
+        return -1;
 #endif
     }
 
-  fseek (n64aps_modfile, 16, SEEK_SET);         // CRC header position
-  fread_checked (buffer, 1, 8, n64aps_modfile);
-  fread_checked (APSbuffer, 1, 8, n64aps_apsfile);
+  memcpy (buffer, patch->data + 16, 8);         // CRC header position
   if (n64aps_magictest == 0x12408037)
     ucon64_bswap16_n (buffer, 8);
-  if (memcmp (APSbuffer, buffer, 8))
+  if (memcmp (ptr + 4, buffer, 8))
     {
       puts ("WARNING: Incorrect image");
 #if 0
       if (!force)
-        {
-          fclose (n64aps_modfile);
-          fclose (n64aps_apsfile);
-          exit (1);
-        }
+        return -1;
 #endif
     }
-
-  fseek (n64aps_apsfile, 5, SEEK_CUR);
-  fseek (n64aps_modfile, 0, SEEK_SET);
+  return 0;
 }
 
 
-static void
-readsizeheader (int modsize, const char *modname)
+static int
+readsizeheader (st_patch_t *patch)
 {
-  int orgsize;
+  const unsigned char *ptr;
+  unsigned int orgsize;
 
-  fread_checked (&orgsize, 4, 1, n64aps_apsfile);
-#ifdef  WORDS_BIGENDIAN
-  orgsize = bswap_32 (orgsize);
-#endif
-  if (modsize != orgsize)                       // resize file
+  if ((ptr = patch_read (patch, 4)) == NULL)
     {
-      if (orgsize < modsize)
-        {
-          fclose (n64aps_modfile);
-          if (truncate (modname, orgsize) != 0)
-            fputs ("ERROR: Truncate failed\n", stderr);
-          if ((n64aps_modfile = fopen (modname, "rb")) == NULL)
-            {
-              fprintf (stderr, "ERROR: Could not open %s after truncation\n", modname);
-              exit (1);
-            }
-        }
-      else
-        {
-          int i;
-
-          fseek (n64aps_modfile, 0, SEEK_END);
-          for (i = 0; i < (orgsize - modsize); i++)
-            fputc (0, n64aps_modfile);
-        }
+      fputs ("ERROR: Unexpected end of patch file\n", stderr);
+      return -1;
     }
-//  fseek (n64aps_modfile, 0, SEEK_SET);
+  memcpy (&orgsize, ptr, 4);
+  orgsize = le2me_32 (orgsize);
+  patch_resize (patch, orgsize);                // truncate or pad with zeroes
+  return 0;
 }
 
 
-static void
-readpatch (void)
+static int
+readpatch (st_patch_t *patch)
 {
-  int offset;
-  unsigned char buffer[N64APS_BUFFERSIZE];
+  const unsigned char *ptr;
 
-  while (fread (&offset, 1, 4, n64aps_apsfile) != 0)
+  while ((ptr = patch_read (patch, 4 + 1)) != NULL)
     {
+      int offset;
       unsigned char size;
 
-#ifdef  WORDS_BIGENDIAN
-      offset = bswap_32 (offset);
-#endif
-      if ((size = (unsigned char) fgetc (n64aps_apsfile)) != 0)
+      memcpy (&offset, ptr, 4);
+      offset = le2me_32 (offset);
+      if (offset < 0)
         {
-          fread_checked (buffer, 1, size, n64aps_apsfile);
-          if ((fseek (n64aps_modfile, offset, SEEK_SET)) != 0)
-            {
-              fputs ("ERROR: Seek failed\n", stderr);
-              exit (1);
-            }
-          fwrite (buffer, 1, size, n64aps_modfile);
+          fputs ("ERROR: Seek failed\n", stderr);
+          return -1;
+        }
+      if ((size = ptr[4]) != 0)
+        {
+          if ((ptr = patch_read (patch, size)) == NULL)
+            break;
+          patch_copy (patch, offset, ptr, size);
         }
       else                                      // apply an RLE block
         {
-          unsigned char data, len;
-          int i;
-
-          data = (unsigned char) fgetc (n64aps_apsfile),
-          len = (unsigned char) fgetc (n64aps_apsfile);
-
-          if ((fseek (n64aps_modfile, offset, SEEK_SET)) != 0)
-            {
-              fputs ("ERROR: Seek failed\n", stderr);
-              exit (1);
-            }
-          for (i = 0; i < len; i++)
-            fputc (data, n64aps_modfile);
+          if ((ptr = patch_read (patch, 2)) == NULL)
+            break;
+          patch_fill (patch, offset, ptr[0], ptr[1]);
         }
     }
+  if (patch->pos < patch->patch_size)
+    {
+      fputs ("ERROR: Unexpected end of patch file\n", stderr);
+      return -1;
+    }
+  return 0;
 }
 
 
 // based on source code (version 1.2 981217) by Silo / BlackBag
 int
-aps_apply (const char *mod, const char *apsname)
+aps_patch (st_patch_t *patch, const char *apsname)
 {
-  char modname[FILENAME_MAX];
-  int size = (int) fsizeof (mod);
+  (void) apsname;
+  if (readstdheader (patch) == -1 ||
+      readN64header (patch) == -1 ||
+      readsizeheader (patch) == -1 ||
+      readpatch (patch) == -1)
+    return -1;
+  return 0;
+}
 
-  strcpy (modname, mod);
-  ucon64_file_handler (modname, NULL, 0);
-  fcopy (mod, 0, size, modname, "wb");          // no copy if one file
 
-  if ((n64aps_modfile = fopen (modname, "r+b")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], modname);
-      exit (1);
-    }
-  if ((n64aps_apsfile = fopen (apsname, "rb")) == NULL)
+int
+aps_apply (const char *mod, const char *apsname)
+{
+  st_patch_t patch;
+
+  if (patch_load (&patch, apsname) == -1)
+    exit (1);
+  if (patch_open (&patch, mod) == -1 ||
+      aps_patch (&patch, apsname) == -1 ||
+      patch_write (&patch) == -1)
     {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], apsname);
+      patch_close (&patch);
       exit (1);
     }
+  patch_close (&patch);
 
-  readstdheader ();
-  readN64header ();
-  readsizeheader (size, modname);
-
-  readpatch ();
-
-  fclose (n64aps_modfile);
-  fclose (n64aps_apsfile);
-
-  printf (ucon64_msg[WROTE], modname);
+  printf (ucon64_msg[WROTE], patch.fname);
   return 0;
 }
 
@@ -408,60 +367,27 @@ writesizeheader (int orgsize, int newsize)
 
 
 static void
-writepatch (void)
+writepatch (st_patch_diff_t *diff)
 // currently RLE is not supported
 {
-  size_t newreadlen, filepos, changedstart = 0, changedoffset = 0, i;
-  int changefound = 0;
-  unsigned char changedlen = 0, orgbuffer[N64APS_BUFFERSIZE], newbuffer[N64APS_BUFFERSIZE];
+  const unsigned char *ptr;
+  unsigned int offset, len;
 
-  fseek (n64aps_orgfile, 0, SEEK_SET);
-  fseek (n64aps_modfile, 0, SEEK_SET);
-  filepos = 0;
-  while ((newreadlen = fread (newbuffer, 1, N64APS_BUFFERSIZE, n64aps_modfile)) != 0)
+  while ((ptr = patch_diff_next (diff, &offset, &len)) != NULL)
     {
-      size_t orgreadlen = fread (orgbuffer, 1, N64APS_BUFFERSIZE, n64aps_orgfile);
-      for (i = orgreadlen; i < newreadlen; i++)
-        orgbuffer[i] = 0;
-
-      for (i = 0; i < newreadlen; i++)
+      n64aps_changefound = TRUE;
+      while (len)
         {
-          if (newbuffer[i] != orgbuffer[i])
-            {
-              if (!changefound)
-                {
-                  changedstart = filepos + i;
-                  changedoffset = i;
-                  changedlen = 0;
-                  changefound = TRUE;
-                  n64aps_changefound = TRUE;
-                }
-              changedlen++;
-            }
-          else if (changefound)
-            {
-#ifdef  WORDS_BIGENDIAN
-              changedstart = bswap_32 (changedstart);
-#endif
-              fwrite (&changedstart, 4, 1, n64aps_apsfile);
-              fputc (changedlen, n64aps_apsfile);
-              fwrite (newbuffer + changedoffset, 1, changedlen, n64aps_apsfile);
-              changefound = FALSE;
-            }
-        }
+          unsigned int changedstart = me2le_32 (offset);
+          unsigned char changedlen = (unsigned char) MIN (len, N64APS_BUFFERSIZE);
 
-      if (changefound)
-        {
-#ifdef  WORDS_BIGENDIAN
-          changedstart = bswap_32 (changedstart);
-#endif
           fwrite (&changedstart, 4, 1, n64aps_apsfile);
           fputc (changedlen, n64aps_apsfile);
-          fwrite (newbuffer + changedoffset, 1, changedlen, n64aps_apsfile);
-          changefound = FALSE;
+          fwrite (ptr, 1, changedlen, n64aps_apsfile);
+          ptr += changedlen;
+          offset += changedlen;
+          len -= changedlen;
         }
-
-      filepos += newreadlen;
     }
 }
 
@@ -470,6 +396,7 @@ writepatch (void)
 int
 aps_create (const char *orgname, const char *modname)
 {
+  st_patch_diff_t diff;
   char apsname[FILENAME_MAX];
 
   if ((n64aps_orgfile = fopen (orgname, "rb")) == NULL)
@@ -503,7 +430,11 @@ aps_create (const char *orgname, const char *modname)
 
   fputs ("Searching differences...", stdout);
   fflush (stdout);
-  writepatch ();
+  // bytes past the end of orgname are compared against the padding of aps_apply()
+  if (patch_diff_open (&diff, orgname, modname, 0, 1) == -1)
+    exit (1);
+  writepatch (&diff);
+  patch_diff_close (&diff);
   puts (" done\n");
 
   fclose (n64aps_modfile);
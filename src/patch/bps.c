@@ -0,0 +1,548 @@
+/*
+bps.c - BPS (beat patch format) support for uCON64
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+#endif
+#include <stdlib.h>
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+#include <string.h>
+#include "misc/archive.h"
+#include "misc/bswap.h"
+#include "misc/chksum.h"
+#include "misc/file.h"
+#include "ucon64.h"
+#include "ucon64_misc.h"
+#include "patch/bps.h"
+#include "patch/patch.h"
+
+
+/*
+  BPS file format:
+  "BPS1"
+  number   size of the original (source) file
+  number   size of the modified (target) file
+  number   size of the metadata
+  bytes    metadata
+  actions until 12 bytes before the end of the file:
+    number   ((length - 1) << 2) | action
+    action 0 (SourceRead)  copy length bytes from the source at the current
+                           target offset
+    action 1 (TargetRead)  length bytes follow in the patch
+    action 2 (SourceCopy)  number relative offset followed by copying length
+                           bytes from the source
+    action 3 (TargetCopy)  number relative offset followed by copying length
+                           bytes from the already written part of the target
+    A relative offset is stored as (abs (delta) << 1) | (delta < 0) and
+    applies to the offset after the previous copy of the same kind.
+  uint32   CRC32 of the source file
+  uint32   CRC32 of the target file
+  uint32   CRC32 of the patch file itself (excluding this field)
+  Numbers are stored in the variable-length encoding of patch_read_number().
+  The CRC32 values are little-endian.
+*/
+#define BPS_MAGIC "BPS1"
+#define BPS_FOOTER_LEN 12
+#define BPS_SOURCE_READ 0
+#define BPS_TARGET_READ 1
+#define BPS_SOURCE_COPY 2
+#define BPS_TARGET_COPY 3
+#define BPS_MIN_COPY 6                          // shorter copies cost more than a TargetRead
+#define BPS_GOOD_MATCH 32                       // don't search for copies if a SourceRead is this long
+#define BPS_BUCKET_SIZE 4                       // positions kept per hash value
+#define BPS_HASH_LEN 4                          // bytes per hash key
+
+
+static st_ucon64_obj_t bps_obj[] =
+  {
+    {0, WF_STOP}
+  };
+
+const st_getopt2_t bps_usage[] =
+  {
+    {
+      "bps", 0, 0, UCON64_BPS,
+      NULL, "apply BPS PATCH to ROM",
+      &bps_obj[0]
+    },
+    {
+      "mkbps", 1, 0, UCON64_MKBPS,
+      "ORG_ROM", "create BPS patch; ROM should be the modified ROM",
+      &bps_obj[0]
+    },
+    {NULL, 0, 0, 0, NULL, NULL, NULL}
+  };
+
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  unsigned int *buckets;                        // BPS_BUCKET_SIZE positions + 1 per hash
+  unsigned int bits;
+} st_bps_hash_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+
+static unsigned int
+get_le32 (const unsigned char *ptr)
+{
+  unsigned int value;
+
+  memcpy (&value, ptr, 4);
+  return le2me_32 (value);
+}
+
+
+static void
+append_le32 (st_patch_t *patch, unsigned int value)
+{
+  value = me2le_32 (value);
+  patch_append (patch, &value, 4);
+}
+
+
+static int
+read_offset (st_patch_t *patch, unsigned int *offset, unsigned int limit)
+// applies a relative offset to *offset; returns -1 if it leaves [0, limit)
+{
+  unsigned int value, delta;
+
+  if (patch_read_number (patch, &value) == -1)
+    return -1;
+  delta = value >> 1;
+  if (value & 1)
+    {
+      if (delta > *offset)
+        return -1;
+      *offset -= delta;
+    }
+  else
+    {
+      if (delta >= limit - *offset)
+        return -1;
+      *offset += delta;
+    }
+  return 0;
+}
+
+
+int
+bps_apply (const char *mod, const char *bpsname)
+{
+  st_patch_t patch;
+  const unsigned char *ptr;
+  unsigned char *source;
+  unsigned int source_size, target_size, metadata_size, source_crc, target_crc,
+               end, out = 0, source_offset = 0, target_offset = 0;
+
+  if (patch_load (&patch, bpsname) == -1)
+    exit (1);
+  if (patch.patch_size < 4 + 3 + BPS_FOOTER_LEN ||
+      memcmp (patch.patch, BPS_MAGIC, 4))
+    {
+      fprintf (stderr, "ERROR: %s is not a valid BPS file\n", bpsname);
+      patch_close (&patch);
+      exit (1);
+    }
+  end = patch.patch_size - BPS_FOOTER_LEN;
+  if (crc32 (0, patch.patch, end + 8) != get_le32 (patch.patch + end + 8))
+    {
+      fprintf (stderr, "ERROR: %s is corrupt (checksum mismatch)\n", bpsname);
+      patch_close (&patch);
+      exit (1);
+    }
+  source_crc = get_le32 (patch.patch + end);
+  target_crc = get_le32 (patch.patch + end + 4);
+  patch.pos = 4;
+  if (patch_read_number (&patch, &source_size) == -1 ||
+      patch_read_number (&patch, &target_size) == -1 ||
+      patch_read_number (&patch, &metadata_size) == -1 ||
+      patch_read (&patch, metadata_size) == NULL)
+    {
+      fputs ("ERROR: Unexpected end of patch file\n", stderr);
+      patch_close (&patch);
+      exit (1);
+    }
+
+  if (patch_open (&patch, mod) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  if (patch.size != source_size || crc32 (0, patch.data, patch.size) != source_crc)
+    {
+      fputs ("ERROR: This patch does not belong to this image\n", stderr);
+      patch_close (&patch);
+      exit (1);
+    }
+
+  // the image of mod is the source, build the target in a new image
+  source = patch.data;
+  patch.data = NULL;
+  patch.size = patch.alloc_size = 0;
+  patch_resize (&patch, target_size);
+
+  puts ("Applying BPS patch...");
+  while (patch.pos < end)
+    {
+      unsigned int data, len, action;
+
+      if (patch_read_number (&patch, &data) == -1)
+        break;
+      len = (data >> 2) + 1;
+      action = data & 3;
+      if (len > target_size - out)
+        break;
+
+      if (action == BPS_SOURCE_READ)
+        {
+          if (out + len > source_size)
+            break;
+          memcpy (patch.data + out, source + out, len);
+        }
+      else if (action == BPS_TARGET_READ)
+        {
+          if ((ptr = patch_read (&patch, len)) == NULL)
+            break;
+          memcpy (patch.data + out, ptr, len);
+        }
+      else if (action == BPS_SOURCE_COPY)
+        {
+          if (read_offset (&patch, &source_offset, source_size) == -1 ||
+              len > source_size - source_offset)
+            break;
+          memcpy (patch.data + out, source + source_offset, len);
+          source_offset += len;
+        }
+      else // action == BPS_TARGET_COPY
+        {
+          unsigned int i;
+
+          if (read_offset (&patch, &target_offset, out) == -1)
+            break;
+          for (i = 0; i < len; i++)             // the areas may overlap
+            patch.data[out + i] = patch.data[target_offset + i];
+          target_offset += len;
+        }
+      out += len;
+    }
+  free (source);
+  if (patch.pos != end || out != target_size)
+    {
+      fprintf (stderr, "ERROR: %s is corrupt\n", bpsname);
+      patch_close (&patch);
+      exit (1);
+    }
+
+  if (crc32 (0, patch.data, patch.size) != target_crc)
+    {
+      fputs ("ERROR: The checksum of the patched image is wrong\n", stderr);
+      patch_close (&patch);
+      exit (1);
+    }
+  if (patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_close (&patch);
+
+  puts ("Patching complete\n");
+  printf (ucon64_msg[WROTE], patch.fname);
+  return 0;
+}
+
+
+static int
+bps_hash_init (st_bps_hash_t *hash, unsigned int size)
+{
+  size_t n;
+
+  for (hash->bits = 10; hash->bits < 22 && (1U << hash->bits) < size / 2;
+       hash->bits++)
+    ;
+  n = ((size_t) 1 << hash->bits) * BPS_BUCKET_SIZE;
+  if ((hash->buckets = (unsigned int *) calloc (n, sizeof (unsigned int))) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], (unsigned int) (n * sizeof (unsigned int)));
+      return -1;
+    }
+  return 0;
+}
+
+
+static unsigned int *
+bps_hash_bucket (st_bps_hash_t *hash, const unsigned char *ptr)
+{
+  unsigned int key = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) |
+                     ((unsigned int) ptr[3] << 24);
+
+  return hash->buckets + ((key * 2654435761U) >> (32 - hash->bits)) * BPS_BUCKET_SIZE;
+}
+
+
+static void
+bps_hash_add (st_bps_hash_t *hash, const unsigned char *data, unsigned int pos,
+              int keep_recent)
+/*
+  Positions are stored + 1, so that 0 marks an empty slot. If keep_recent is
+  non-zero the most recent position comes first and the oldest one is
+  dropped (the target, where nearby matches are most likely). Otherwise a full
+  bucket loses a pseudo-randomly chosen position, so that the positions at the
+  start of the source have as much chance to stay in the table as the ones at
+  the end.
+*/
+{
+  unsigned int *bucket = bps_hash_bucket (hash, data + pos), i;
+
+  if (keep_recent)
+    {
+      memmove (bucket + 1, bucket, (BPS_BUCKET_SIZE - 1) * sizeof (unsigned int));
+      bucket[0] = pos + 1;
+      return;
+    }
+  for (i = 0; i < BPS_BUCKET_SIZE; i++)
+    if (bucket[i] == 0)
+      {
+        bucket[i] = pos + 1;
+        return;
+      }
+  bucket[((pos * 2654435761U) >> 16) % BPS_BUCKET_SIZE] = pos + 1;
+}
+
+
+static unsigned int
+match_len (const unsigned char *a, const unsigned char *b, unsigned int max)
+{
+  unsigned int i = 0;
+
+  while (i + 8 <= max && !memcmp (a + i, b + i, 8))
+    i += 8;
+  while (i < max && a[i] == b[i])
+    i++;
+  return i;
+}
+
+
+static void
+append_offset (st_patch_t *patch, unsigned int offset, unsigned int *prev)
+{
+  if (offset < *prev)
+    patch_append_number (patch, ((*prev - offset) << 1) | 1);
+  else
+    patch_append_number (patch, (offset - *prev) << 1);
+}
+
+
+static void
+flush_target_read (st_patch_t *patch, const unsigned char *target,
+                   unsigned int start, unsigned int end)
+{
+  if (end > start)
+    {
+      patch_append_number (patch, ((end - start - 1) << 2) | BPS_TARGET_READ);
+      patch_append (patch, target + start, end - start);
+    }
+}
+
+
+static void
+bps_encode (st_patch_t *patch, const unsigned char *source,
+            unsigned int source_size, const unsigned char *target,
+            unsigned int target_size, st_bps_hash_t *source_hash,
+            st_bps_hash_t *target_hash)
+/*
+  Greedy encoder. At every position of the target it takes the longest of:
+  - a SourceRead (the source has the same bytes at the same offset)
+  - a SourceCopy that continues where the previous SourceCopy left off, as if
+    the bytes in between were only changed (common for translations)
+  - a SourceCopy from the positions in the source with the same hash
+  - a TargetCopy from the earlier positions in the target with the same hash
+  Each hash bucket holds the BPS_BUCKET_SIZE most recent positions, so the
+  amount of work per position is bounded and the encoder runs in linear time.
+  Bytes not covered by a match become TargetRead actions.
+*/
+{
+  unsigned int out = 0, literal = 0, source_offset = 0, target_offset = 0,
+               source_copy_end = 0, i;
+
+  for (i = 0; i + BPS_HASH_LEN <= source_size; i++)
+    bps_hash_add (source_hash, source, i, 0);
+
+  while (out < target_size)
+    {
+      unsigned int best_len = 0, best_action = BPS_SOURCE_READ, best_pos = 0,
+                   left = target_size - out;
+
+      if (out < source_size)
+        best_len = match_len (source + out, target + out, MIN (source_size - out, left));
+      if (source_copy_end && best_len < BPS_GOOD_MATCH)
+        {
+          unsigned int pos = source_offset + (out - source_copy_end), n;
+
+          if (pos < source_size &&
+              (n = match_len (source + pos, target + out,
+                              MIN (source_size - pos, left))) > best_len)
+            {
+              best_len = n;
+              best_action = BPS_SOURCE_COPY;
+              best_pos = pos;
+            }
+        }
+      if (best_len < BPS_GOOD_MATCH && left >= BPS_HASH_LEN)
+        {
+          unsigned int *bucket = bps_hash_bucket (source_hash, target + out), n;
+
+          for (i = 0; i < BPS_BUCKET_SIZE && bucket[i]; i++)
+            {
+              unsigned int pos = bucket[i] - 1;
+
+              n = match_len (source + pos, target + out, MIN (source_size - pos, left));
+              if (n > best_len)
+                {
+                  best_len = n;
+                  best_action = BPS_SOURCE_COPY;
+                  best_pos = pos;
+                }
+            }
+          bucket = bps_hash_bucket (target_hash, target + out);
+          for (i = 0; i < BPS_BUCKET_SIZE && bucket[i]; i++)
+            {
+              unsigned int pos = bucket[i] - 1;
+
+              n = match_len (target + pos, target + out, left);
+              if (n > best_len)
+                {
+                  best_len = n;
+                  best_action = BPS_TARGET_COPY;
+                  best_pos = pos;
+                }
+            }
+        }
+
+      if (best_action == BPS_SOURCE_READ ?
+            best_len >= (out > literal ? 4U : 1U) : best_len >= BPS_MIN_COPY)
+        {
+          flush_target_read (patch, target, literal, out);
+          patch_append_number (patch, ((best_len - 1) << 2) | best_action);
+          if (best_action == BPS_SOURCE_COPY)
+            {
+              append_offset (patch, best_pos, &source_offset);
+              source_offset = best_pos + best_len;
+              source_copy_end = out + best_len;
+            }
+          else if (best_action == BPS_TARGET_COPY)
+            {
+              append_offset (patch, best_pos, &target_offset);
+              target_offset = best_pos + best_len;
+            }
+          for (i = out; i < out + best_len && i + BPS_HASH_LEN <= target_size; i++)
+            bps_hash_add (target_hash, target, i, 1);
+          out += best_len;
+          literal = out;
+        }
+      else
+        {
+          if (left >= BPS_HASH_LEN)
+            bps_hash_add (target_hash, target, out, 1);
+          out++;
+        }
+    }
+  flush_target_read (patch, target, literal, out);
+}
+
+
+int
+bps_create (const char *orgname, const char *modname)
+{
+  st_patch_t patch;
+  st_bps_hash_t source_hash, target_hash;
+  unsigned char *source, *target;
+  unsigned int source_size = (unsigned int) fsizeof (orgname),
+               target_size = (unsigned int) fsizeof (modname);
+
+  if ((source = (unsigned char *) malloc (source_size + 1)) == NULL ||
+      (target = (unsigned char *) malloc (target_size + 1)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], MAX (source_size, target_size));
+      exit (1);
+    }
+  if (ucon64_fread (source, 0, source_size, orgname) != source_size)
+    {
+      fprintf (stderr, ucon64_msg[READ_ERROR], orgname);
+      exit (1);
+    }
+  if (ucon64_fread (target, 0, target_size, modname) != target_size)
+    {
+      fprintf (stderr, ucon64_msg[READ_ERROR], modname);
+      exit (1);
+    }
+  if (source_size == target_size && !memcmp (source, target, source_size))
+    {
+      printf ("%s and %s are identical\n", orgname, modname);
+      free (source);
+      free (target);
+      return -1;
+    }
+  if (bps_hash_init (&source_hash, source_size) == -1 ||
+      bps_hash_init (&target_hash, target_size) == -1)
+    exit (1);
+
+  memset (&patch, 0, sizeof (st_patch_t));
+  strcpy (patch.fname, modname);
+  set_suffix (patch.fname, ".bps");
+  patch_append (&patch, BPS_MAGIC, 4);
+  patch_append_number (&patch, source_size);
+  patch_append_number (&patch, target_size);
+  patch_append_number (&patch, 0);              // no metadata
+
+  puts ("Writing patch data, please wait...");
+  bps_encode (&patch, source, source_size, target, target_size, &source_hash,
+              &target_hash);
+  free (source_hash.buckets);
+  free (target_hash.buckets);
+
+  append_le32 (&patch, crc32 (0, source, source_size));
+  append_le32 (&patch, crc32 (0, target, target_size));
+  append_le32 (&patch, crc32 (0, patch.data, patch.size));
+  free (source);
+  free (target);
+
+  ucon64_file_handler (patch.fname, NULL, 0);
+  if (patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_close (&patch);
+
+  printf (ucon64_msg[WROTE], patch.fname);
+  return 0;
+}
@@ -0,0 +1,32 @@
+/*
+bps.h - BPS (beat patch format) support for uCON64
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifndef BPS_H
+#define BPS_H
+
+#include "misc/getopt2.h"                       // st_getopt2_t
+
+
+extern const st_getopt2_t bps_usage[];
+
+extern int bps_apply (const char *mod, const char *bpsname);
+extern int bps_create (const char *orgname, const char *modname);
+
+#endif
@@ -24,6 +24,8 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #pragma warning(push)
 #pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
 #endif
+#include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 #ifdef  _MSC_VER
 #pragma warning(pop)
@@ -33,6 +35,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "ucon64.h"
 #include "ucon64_misc.h"
 #include "patch/bsl.h"
+#include "patch/patch.h"
 
 
 static st_ucon64_obj_t bsl_obj[] =
@@ -51,89 +54,86 @@ const st_getopt2_t bsl_usage[] =
   };
 
 
-int
-bsl_apply (const char *mod, const char *bslname)
+static int
+bsl_read_int (st_patch_t *patch, int *value)
+// same as fscanf (file, "%d\n", value) on the patch file
 {
-  FILE *modfile, *bslfile;
-  char modname[FILENAME_MAX];
-  int data, nbytes, offset;
+  char *start = (char *) patch->patch + patch->pos, *end;
+  long l;
+
+  l = strtol (start, &end, 10);
+  if (end == start)
+    return -1;
+  while (isspace ((int) *(unsigned char *) end) &&
+         end < (char *) patch->patch + patch->patch_size)
+    end++;
+  patch->pos = (unsigned int) (end - (char *) patch->patch);
+  *value = (int) l;
+  return 0;
+}
 
-  strcpy (modname, mod);
-  ucon64_file_handler (modname, NULL, 0);
-  fcopy (mod, 0, fsizeof (mod), modname, "wb"); // no copy if one file
 
-  if ((modfile = fopen (modname, "r+b")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], modname);
-      return -1;
-    }
-  if ((bslfile = fopen (bslname, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], bslname);
-      fclose (modfile);
-      return -1;
-    }
+int
+bsl_patch (st_patch_t *patch, const char *bslname)
+{
+  int data, nbytes, offset;
 
   puts ("Applying BSL/Baseline patch...");
 
-  while (!feof (bslfile))
+  for (;;)
     {
-      if (fscanf (bslfile, "%d\n", &offset) != 1 ||
-          fscanf (bslfile, "%d\n", &data) != 1)
+      if (bsl_read_int (patch, &offset) == -1 ||
+          bsl_read_int (patch, &data) == -1 || offset < -1)
         {
           fprintf (stderr, ucon64_msg[READ_ERROR], bslname);
-          fclose (bslfile);
-          fclose (modfile);
           return -1;
         }
       if (offset == -1 && data == -1)
         break;
 
-      fseek (modfile, offset, SEEK_SET);
-      fputc (data, modfile);
+      patch_fill (patch, offset, data, 1);
     }
 
-  if (fscanf (bslfile, "%d\n", &offset) != 1 ||
-      fscanf (bslfile, "%d\n", &nbytes) != 1)
+  if (bsl_read_int (patch, &offset) == -1 ||
+      bsl_read_int (patch, &nbytes) == -1 || offset < 0)
     {
       fprintf (stderr, ucon64_msg[READ_ERROR], bslname);
-      fclose (bslfile);
-      fclose (modfile);
       return -1;
     }
-  fseek (modfile, offset, SEEK_SET);
   if (nbytes > 0)
-    {
-      char buf[4096];
+    {                                           // yes, one byte more than the
+      unsigned int n = patch->patch_size - patch->pos; //  _value_ read from the BSL file
 
-      while (nbytes > (int) sizeof buf)
-        {
-          int nbytes2 = (int) fread (buf, 1, sizeof buf, bslfile);
-          nbytes -= nbytes2;
-          if (nbytes2 == 0)
-            {
-              nbytes = -1;
-              break;
-            }
-          fwrite (buf, 1, nbytes2, modfile);
-        }
-      while (nbytes-- >= 0)                     // yes, one byte more than the
-        {                                       //  _value_ read from the BSL file
-          if ((data = fgetc (bslfile)) == EOF)
-            break;
-          fputc (data, modfile);
-        }
+      if ((unsigned int) nbytes + 1 < n)
+        n = nbytes + 1;
+      patch_copy (patch, offset, patch->patch + patch->pos, n);
     }
+  return 0;
+}
+
+
+int
+bsl_apply (const char *mod, const char *bslname)
+{
+  st_patch_t patch;
+
+  if (patch_load (&patch, bslname) == -1)
+    return -1;
+  if (patch_open (&patch, mod) == -1 ||
+      bsl_patch (&patch, bslname) == -1 ||
+      patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      return -1;
+    }
+  patch_close (&patch);
 
   puts ("Patching complete\n");
-  printf (ucon64_msg[WROTE], modname);
+  printf (ucon64_msg[WROTE], patch.fname);
   puts ("\n"
         "NOTE: Sometimes you have to add/strip a 512 bytes header when you patch a ROM\n"
         "      This means you must modify for example a SNES ROM with -swc or -stp or\n"
         "      the patch will not work");
 
-  fclose (bslfile);
-  fclose (modfile);
-
   return 0;
 }
@@ -23,10 +23,12 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define BSL_H
 
 #include "misc/getopt2.h"                       // st_getopt2_t
+#include "patch/patch.h"                        // st_patch_t
 
 
 extern const st_getopt2_t bsl_usage[];
 
 extern int bsl_apply (const char *modname, const char *bslname);
+extern int bsl_patch (st_patch_t *patch, const char *bslname);
 
 #endif
@@ -47,18 +47,27 @@
 Portions copyright (c) 2001 - 2002                    NoisyB
 Portions copyright (c) 2002, 2016 - 2017, 2020 - 2021 dbjh
 */
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
 #ifdef  _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
 #endif
 #include <ctype.h>
+#include <stdlib.h>
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
+#include <string.h>
+#ifdef  HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 #include "misc/archive.h"
 #include "misc/file.h"
 #include "misc/misc.h"
 #include "ucon64_misc.h"
+#include "console/nes.h"
 #include "console/snes.h"
 #include "patch/gg.h"
 
@@ -111,6 +120,8 @@ const st_getopt2_t gg_usage[] =
       "gg", 1, 0, UCON64_GG,
       "GG_CODE", "apply Game Genie code (permanently)\n"
       "example: like above but a ROM is required\n"
+      "GG_CODE can also be a comma separated list of codes or a file\n"
+      "with one code per line; all codes are applied in one pass\n"
       "supported are:\n"
       "Game Boy/(Super GB)/GB Pocket/Color GB/(GB Advance),\n"
       "Sega Master System(II/III)/Game Gear (Handheld),\n"
@@ -123,7 +134,19 @@ const st_getopt2_t gg_usage[] =
   };
 
 
+typedef struct
+{
+  const char *code;
+  unsigned int address;
+  unsigned int value;
+  int check;                                    /* -1 if the code has no compare value */
+  unsigned int index;                           /* position of the code in the list */
+} st_gg_code_t;
+
 static st_ucon64_nfo_t *gg_rominfo;
+static char *gg_codes_arg = NULL, *gg_codes_buf = NULL;
+static const char **gg_codes = NULL;
+static unsigned int gg_n_codes = 0;
 static int CPUaddress;
 static int gg_argc;
 static const char *gg_argv[128];
@@ -931,13 +954,13 @@ gg_main (int argc, const char **argv)
 
 
 static void
-apply_code (FILE *destfile, int offset, char *bufold, char *bufnew, int size)
+apply_code (st_patch_t *patch, unsigned int offset, const unsigned char *bufnew,
+            unsigned int size)
 {
   fputc ('\n', stdout);
-  dumper (stdout, bufold, size, offset, DUMPER_HEX);
+  dumper (stdout, patch->data + offset, size, offset, DUMPER_HEX);
 
-  fseek (destfile, offset, SEEK_SET);
-  fwrite (bufnew, 1, size, destfile);
+  patch_copy (patch, offset, bufnew, size);
 
   dumper (stdout, bufnew, size, offset, DUMPER_HEX);
 }
@@ -988,24 +1011,47 @@ gg_display (st_ucon64_nfo_t *rominfo, const char *code)
 
 
 int
-gg_apply (st_ucon64_nfo_t *rominfo, const char *code)
+gg_check (st_ucon64_nfo_t *rominfo)
 {
-  unsigned int size = (unsigned int) ucon64.fsize -
-                         (rominfo ? rominfo->backup_header_len : 0),
-               offset, address, value, writefile;
-  int check = -1, result = -1;
-  char buf[GAME_GENIE_MAX_STRLEN], buf2[GAME_GENIE_MAX_STRLEN],
-       dest_name[FILENAME_MAX];
-  FILE *destfile;
-
-  if (rominfo && ucon64.fsize > 0)              /* check if rominfo contains valid ROM info */
-    gg_rominfo = rominfo;
-  else
+  switch (ucon64.console)
     {
-      fprintf (stderr, "ERROR: You must specify a ROM to apply the code to\n");
+    case UCON64_GB:
+    case UCON64_GEN:
+    case UCON64_NES:
+    case UCON64_SMS:
+    case UCON64_SNES:
+      /* ROM images for SNES (GD3) and Genesis (SMD) can be interleaved */
+      if (rominfo && rominfo->interleaved)
+        {
+          fputs ("ERROR: This ROM seems to be interleaved, but uCON64 will only apply a Game\n"
+                 "       Genie patch to non-interleaved ROMs. Convert to a non-interleaved\n"
+                 "       format\n", stderr);
+          return -1;
+        }
+      else if (ucon64.console == UCON64_NES &&
+               nes_get_file_type (&ucon64) != INES &&
+               nes_get_file_type (&ucon64) != FFE)
+        {
+          fputs ("ERROR: This NES ROM is in a format that uCON64 cannot apply a Game Genie patch\n"
+                 "       to. Convert to iNES\n", stderr);
+          return -1;
+        }
+      return 0;
+    default:
+      fputs ("ERROR: Cannot apply Game Genie code for this ROM/console\n", stderr);
       return -1;
     }
+}
 
+
+static int
+gg_decode (st_ucon64_nfo_t *rominfo, const char *code, unsigned int size,
+           st_gg_code_t *gg)
+{
+  int result = -1;
+  char buf[GAME_GENIE_MAX_STRLEN];
+
+  gg_rominfo = rominfo;
   CPUaddress = -1;
   switch (ucon64.console)
     {
@@ -1036,100 +1082,272 @@ gg_apply (st_ucon64_nfo_t *rominfo, const char *code)
     printf ("%s = %s (CPU address: %06X)\n", code, buf, CPUaddress);
   else
     printf ("%s = %s\n", code, buf);
-  sscanf (buf, "%x:%x:%x", &address, &value, (unsigned int *) &check);
+  gg->code = code;
+  gg->check = -1;
+  sscanf (buf, "%x:%x:%x", &gg->address, &gg->value, (unsigned int *) &gg->check);
 
-  if (address >= size)
+  if (gg->address >= size ||
+      (ucon64.console == UCON64_GEN && gg->address + 1 >= size))
     {
-      fprintf (stderr, "ERROR: Address is too high for this ROM (%u)\n", address);
+      fprintf (stderr, "ERROR: Address is too high for this ROM (%u)\n", gg->address);
       return -1;
     }
+  return 0;
+}
 
-  strcpy (dest_name, ucon64.fname);
-  writefile = !(ucon64.console == UCON64_NES && check == -1);
 
-  if (writefile)
+static void
+gg_list_nes (st_patch_t *patch, unsigned int header_len, st_gg_code_t *gg)
+/* 6 digit code => display the corresponding 8 digit code(s) */
+{
+  unsigned int offset;
+  char buf[GAME_GENIE_MAX_STRLEN], longcode[9];
+
+  puts ("NOTE: A 6 digit code is too generic. File will not be modified.\n"
+        "      Listing possible 8 digit codes");
+  for (offset = gg->address + header_len; offset < patch->size;
+       offset += 8 * 1024)
     {
-      ucon64_file_handler (dest_name, NULL, 0);
-      fcopy (ucon64.fname, 0, ucon64.fsize, dest_name, "wb"); /* no copy if one file */
+      fputc ('\n', stdout);
+      dumper (stdout, patch->data + offset, 1, offset, DUMPER_HEX);
+
+      sprintf (buf, "%04X:%02X:%02X", (offset - header_len) & 0xffff,
+               gg->value, patch->data[offset]);
+      gameGenieEncodeNES (buf, longcode);
+      printf ("%s = %s\n", buf, longcode);
+    }
+}
+
+
+static int
+gg_code_cmp (const void *a, const void *b)
+{
+  const st_gg_code_t *gg1 = (const st_gg_code_t *) a,
+                     *gg2 = (const st_gg_code_t *) b;
 
-      if ((destfile = fopen (dest_name, "r+b")) == NULL)
+  if (gg1->address != gg2->address)
+    return gg1->address < gg2->address ? -1 : 1;
+  /* keep the order of the list for codes that change the same address */
+  return gg1->index < gg2->index ? -1 : gg1->index > gg2->index ? 1 : 0;
+}
+
+
+int
+gg_patch (st_patch_t *patch, st_ucon64_nfo_t *rominfo, const char **codes,
+          unsigned int n_codes)
+/*
+  Returns 1 if none of the codes changes the image. This is the case for 6 digit
+  NES codes. Those are too generic to apply, so the matching 8 digit codes are
+  listed instead.
+*/
+{
+  st_gg_code_t *gg;
+  unsigned int header_len = rominfo->backup_header_len, i, n = 0;
+  unsigned char buf[2];
+
+  if (n_codes == 0)
+    return 1;
+  if ((gg = (st_gg_code_t *) malloc (n_codes * sizeof (st_gg_code_t))) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+               (unsigned int) (n_codes * sizeof (st_gg_code_t)));
+      return -1;
+    }
+
+  /* all codes are decoded before anything is changed, so that a bad code leaves
+     the image untouched */
+  for (i = 0; i < n_codes; i++)
+    {
+      if (gg_decode (rominfo, codes[i], patch->size - header_len, &gg[n]) == -1)
         {
-          fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], dest_name);
+          free (gg);
           return -1;
         }
+      gg[n].index = i;
+      if (ucon64.console == UCON64_NES && gg[n].check == -1)
+        gg_list_nes (patch, header_len, &gg[n]);
+      else
+        n++;
+    }
+  qsort (gg, n, sizeof (st_gg_code_t), gg_code_cmp);
+
+  if (ucon64.console == UCON64_NES)
+    {
+      unsigned int bank;
+
+      /*
+        An 8 digit code applies to every 8 kB bank that has the compare value
+        at the address. The banks are visited once for all codes instead of
+        once per code.
+      */
+      for (bank = 0; n && gg[0].address + header_len + bank < patch->size;
+           bank += 8 * 1024)
+        for (i = 0; i < n; i++)
+          {
+            unsigned int offset = gg[i].address + header_len + bank;
+
+            if (offset < patch->size &&
+                patch->data[offset] == (unsigned char) gg[i].check)
+              {
+                buf[0] = (unsigned char) gg[i].value;
+                apply_code (patch, offset, buf, 1);
+              }
+          }
+    }
+  else if (ucon64.console == UCON64_GEN)
+    for (i = 0; i < n; i++)
+      {
+        buf[0] = (unsigned char) (gg[i].value >> 8);
+        buf[1] = (unsigned char) gg[i].value;
+        apply_code (patch, gg[i].address + header_len, buf, 2);
+      }
+  else /* UCON64_SNES || UCON64_SMS || UCON64_GB */
+    for (i = 0; i < n; i++)
+      {
+        unsigned int offset = gg[i].address + header_len;
+
+        /* for SNES check is always -1 */
+        if (gg[i].check == -1 || patch->data[offset] == (unsigned char) gg[i].check)
+          {
+            buf[0] = (unsigned char) gg[i].value;
+            apply_code (patch, offset, buf, 1);
+          }
+      }
+
+  free (gg);
+  return n ? 0 : 1;
+}
+
+
+static int
+gg_get_codes (const char *arg)
+/*
+  Split arg into codes. arg is either a comma separated list of codes or the
+  name of a file with one code per line. Text after the code on a line is a
+  description and lines that start with '#' or ';' are comments. The codes are
+  kept for the next ROM, because the option argument is the same for all ROMs.
+*/
+{
+  char *p;
+  unsigned int alloc_codes = 0;
+
+  if (gg_codes_arg && !strcmp (gg_codes_arg, arg))
+    return 0;
+
+  free (gg_codes_arg);
+  free (gg_codes_buf);
+  free (gg_codes);
+  gg_codes_arg = gg_codes_buf = NULL;
+  gg_codes = NULL;
+  gg_n_codes = 0;
+
+  if (access (arg, F_OK) == 0)
+    {
+      unsigned int size = (unsigned int) fsizeof (arg);
+
+      if ((gg_codes_buf = (char *) malloc (size + 1)) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], size + 1);
+          return -1;
+        }
+      if (ucon64_fread (gg_codes_buf, 0, size, arg) != size)
+        {
+          fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], arg);
+          return -1;
+        }
+      gg_codes_buf[size] = '\0';
     }
   else
     {
-      puts ("NOTE: A 6 digit code is too generic. File will not be modified.\n"
-            "      Listing possible 8 digit codes");
-      if ((destfile = fopen (dest_name, "rb")) == NULL)
+      if ((gg_codes_buf = (char *) malloc (strlen (arg) + 1)) == NULL)
         {
-          fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], dest_name);
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], (unsigned int) strlen (arg) + 1);
           return -1;
         }
+      strcpy (gg_codes_buf, arg);
+      for (p = gg_codes_buf; *p; p++)
+        if (*p == ',')
+          *p = '\n';
     }
 
-  offset = address + rominfo->backup_header_len;
-  if (ucon64.console == UCON64_NES)
+  for (p = gg_codes_buf; *p; )
     {
-      while (offset < ucon64.fsize)
+      char *code;
+
+      while (isspace ((int) *(unsigned char *) p))
+        p++;
+      code = p;
+      while (*p && !isspace ((int) *(unsigned char *) p))
+        p++;
+      if (*p && *p != '\n')
         {
-          fseek (destfile, offset, SEEK_SET);
-          buf[0] = (char) fgetc (destfile);
-
-          if (check != -1)
-            { /* 8 digit code */
-              if (buf[0] == (char) check)
-                {
-                  buf2[0] = (char) value;
-                  apply_code (destfile, offset, buf, buf2, 1);
-                }
-            }
-          else
-            { /* 6 digit code => display the corresponding 8 digit code(s) */
-              char longcode[9];
+          *p++ = '\0';
+          while (*p && *p != '\n')              /* skip the description */
+            p++;
+        }
+      if (*p)
+        *p++ = '\0';
+      if (*code == '\0' || *code == '#' || *code == ';')
+        continue;
 
-              fputc ('\n', stdout);
-              dumper (stdout, buf, 1, offset, DUMPER_HEX);
+      if (gg_n_codes == alloc_codes)
+        {
+          const char **codes;
 
-              address = offset - rominfo->backup_header_len;
-              sprintf (buf, "%04X:%02X:%02X", address & 0xffff, value,
-                       (unsigned char) buf[0]);
-              gameGenieEncodeNES (buf, longcode);
-              printf ("%s = %s\n", buf, longcode);
+          alloc_codes = alloc_codes ? alloc_codes * 2 : 64;
+          if ((codes = (const char **) realloc ((void *) gg_codes,
+                                                 alloc_codes * sizeof (char *))) == NULL)
+            {
+              fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                       (unsigned int) (alloc_codes * sizeof (char *)));
+              return -1;
             }
-
-          offset += 8 * 1024;
+          gg_codes = codes;
         }
+      gg_codes[gg_n_codes++] = code;
     }
-  else if (ucon64.console == UCON64_GEN)
+
+  if ((gg_codes_arg = (char *) malloc (strlen (arg) + 1)) != NULL)
+    strcpy (gg_codes_arg, arg);
+  return 0;
+}
+
+
+int
+gg_apply (st_ucon64_nfo_t *rominfo, const char *codes)
+{
+  st_patch_t patch;
+  int result;
+
+  if (!rominfo || ucon64.fsize <= 0)            /* check if rominfo contains valid ROM info */
     {
-      fseek (destfile, offset, SEEK_SET);
-      buf[0] = (char) fgetc (destfile);
-      buf[1] = (char) fgetc (destfile);
+      fprintf (stderr, "ERROR: You must specify a ROM to apply the code to\n");
+      return -1;
+    }
+  if (gg_get_codes (codes) == -1)
+    return -1;
 
-      buf2[0] = (char) (value >> 8);
-      buf2[1] = (char) value;
-      apply_code (destfile, offset, buf, buf2, 2);
+  /* the output file is only determined once it is certain that it will be
+     written, because a 6 digit NES code does not modify the ROM */
+  memset (&patch, 0, sizeof (st_patch_t));
+  if (patch_load_image (&patch, ucon64.fname) == -1 ||
+      (result = gg_patch (&patch, rominfo, gg_codes, gg_n_codes)) == -1)
+    {
+      patch_close (&patch);
+      return -1;
     }
-  else /* UCON64_SNES || UCON64_SMS || UCON64_GB */
+  if (result == 0)
     {
-      fseek (destfile, offset, SEEK_SET);
-      buf[0] = (char) fgetc (destfile);
-
-      /* for SNES check is always -1 */
-      if (check == -1 || buf[0] == (char) check)
+      strcpy (patch.fname, ucon64.fname);
+      ucon64_file_handler (patch.fname, NULL, 0);
+      if (patch_write (&patch) == -1)
         {
-          buf2[0] = (char) value;
-          apply_code (destfile, offset, buf, buf2, 1);
+          patch_close (&patch);
+          return -1;
         }
-    }
-
-  fclose (destfile);
-  if (writefile)
-    {
       fputc ('\n', stdout);
-      printf (ucon64_msg[WROTE], dest_name);
+      printf (ucon64_msg[WROTE], patch.fname);
     }
+  patch_close (&patch);
   return 0;
 }
@@ -23,11 +23,15 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define GG_H
 
 #include "misc/getopt2.h"                       // st_getopt2_t
+#include "patch/patch.h"                        // st_patch_t
 
 
 extern const st_getopt2_t gg_usage[];
 
-extern int gg_apply (st_ucon64_nfo_t *rominfo, const char *code);
+extern int gg_check (st_ucon64_nfo_t *rominfo);
+extern int gg_apply (st_ucon64_nfo_t *rominfo, const char *codes);
+extern int gg_patch (st_patch_t *patch, st_ucon64_nfo_t *rominfo,
+                     const char **codes, unsigned int n_codes);
 extern int gg_display (st_ucon64_nfo_t *rominfo, const char *code);
 
 #endif
@@ -34,9 +34,9 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "ucon64.h"
 #include "ucon64_misc.h"
 #include "patch/ips.h"
+#include "patch/patch.h"
 
 
-#define NO_RLE  256
 // for some strange reason 6 seems to be a general optimum value for RLE_START_THRESHOLD
 #define RLE_START_THRESHOLD 6                   // must be smaller than RLE_RESTART_THRESHOLD!
 #define RLE_RESTART_THRESHOLD 13
@@ -65,27 +65,11 @@ const st_getopt2_t ips_usage[] =
     {NULL, 0, 0, 0, NULL, NULL, NULL}
   };
 
-static FILE *orgfile, *modfile, *ipsfile, *destfile;
-static unsigned int ndiffs = 0, totaldiffs = 0, rle_value = NO_RLE, filepos = 0;
-static int address = -1;
+static FILE *ipsfile, *destfile;
+static unsigned int ndiffs = 0, totaldiffs = 0, address = 0;
 static char destfname[FILENAME_MAX] = "";
 
 
-static unsigned char
-read_byte (FILE *file)
-{
-  int byte;                                     // this must be an int!
-
-  byte = fgetc (file);
-  if (byte == EOF)
-    {
-      fputs ("ERROR: Unexpected end of file\n", stderr);
-      exit (1);
-    }
-  return (unsigned char) byte;
-}
-
-
 static void
 remove_destfile (void)
 {
@@ -101,101 +85,96 @@ remove_destfile (void)
 
 // based on IPS v1.0 for UNIX by madman
 int
-ips_apply (const char *mod, const char *ipsname)
+ips_patch (st_patch_t *patch, const char *ipsname)
 {
-  unsigned char byte, byte2, byte3;
-  char modname[FILENAME_MAX], magic[6] = { 0 };
-  unsigned int length, i;
+  const unsigned char *ptr;
 
-  if ((ipsfile = fopen (ipsname, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ipsname);
-      exit (1);
-    }
-  if (fgets (magic, 6, ipsfile) == NULL || strcmp (magic, "PATCH") != 0)
+  if ((ptr = patch_read (patch, 5)) == NULL || memcmp (ptr, "PATCH", 5) != 0)
     {                                           // perform at least one test for validity
       fprintf (stderr, "ERROR: %s is not a valid IPS file\n", ipsname);
-      fclose (ipsfile);
-      exit (1);
-    }
-
-  strcpy (modname, mod);
-  ucon64_file_handler (modname, NULL, 0);
-  fcopy (mod, 0, fsizeof (mod), modname, "wb"); // no copy if one file
-
-  if ((modfile = fopen (modname, "r+b")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], modname);
-      fclose (ipsfile);
-      exit (1);
+      return -1;
     }
 
-  strcpy (destfname, modname);
-  destfile = modfile;
-  register_func (remove_destfile);
-
   puts ("Applying IPS patch...");
-  while (!feof (ipsfile))
+  for (;;)
     {
-      unsigned int offset;
+      unsigned int offset, length;
 
-      byte = read_byte (ipsfile);
-      byte2 = read_byte (ipsfile);
-      byte3 = read_byte (ipsfile);
-      offset = (byte << 16) + (byte2 << 8) + byte3;
+      if ((ptr = patch_read (patch, 3)) == NULL)
+        break;
+      offset = (ptr[0] << 16) + (ptr[1] << 8) + ptr[2];
       if (offset == 0x454f46)                   // numerical representation of ASCII "EOF"
         break;
-      fseek (modfile, offset, SEEK_SET);
 
-      byte = read_byte (ipsfile);
-      byte2 = read_byte (ipsfile);
-      length = (byte << 8) + byte2;
+      if ((ptr = patch_read (patch, 2)) == NULL)
+        break;
+      length = (ptr[0] << 8) + ptr[1];
       if (length == 0)
         {                                       // code for RLE compressed block
-          byte = read_byte (ipsfile);
-          byte2 = read_byte (ipsfile);
-          length = (byte << 8) + byte2;
-          byte = read_byte (ipsfile);
+          if ((ptr = patch_read (patch, 3)) == NULL)
+            break;
+          length = (ptr[0] << 8) + ptr[1];
 #ifdef  DEBUG_IPS
-          printf ("[%02x] <= %02x (* %d)\n", offset, byte, length);
+          printf ("[%02x] <= %02x (* %d)\n", offset, ptr[2], length);
 #endif
-          for (i = 0; i < length; i++)
-            fputc (byte, modfile);
+          patch_fill (patch, offset, ptr[2], length);
         }
       else
         {                                       // non compressed
-          for (i = 0; i < length; i++)
-            {
-              byte = read_byte (ipsfile);
+          if ((ptr = patch_read (patch, length)) == NULL)
+            break;
 #ifdef  DEBUG_IPS
-              printf ("[%02x] <= %02x\n", offset + i, byte);
+          printf ("[%02x] <= %02x (%d bytes)\n", offset, ptr[0], length);
 #endif
-              fputc (byte, modfile);
-            }
+          patch_copy (patch, offset, ptr, length);
         }
     }
-  fclose (modfile);                             // commit changes before calling truncate2()
+  if (ptr == NULL)
+    {
+      fputs ("ERROR: Unexpected end of file\n", stderr);
+      return -1;
+    }
 
-  byte = (unsigned char) fgetc (ipsfile);       // don't use read_byte() here;
-  if (!feof (ipsfile))                          //  this part is optional
+  if (patch->pos < patch->patch_size)           // this part is optional
     {                                           // IPS2 stuff
-      byte2 = read_byte (ipsfile);
-      byte3 = read_byte (ipsfile);
-      length = (byte << 16) + (byte2 << 8) + byte3;
-      truncate2 (modname, length);
+      unsigned int length;
+
+      if ((ptr = patch_read (patch, 3)) == NULL)
+        {
+          fputs ("ERROR: Unexpected end of file\n", stderr);
+          return -1;
+        }
+      length = (ptr[0] << 16) + (ptr[1] << 8) + ptr[2];
+      patch_resize (patch, length);
       printf ("File truncated to %.4f MBit\n", length / (float) MBIT);
     }
+  return 0;
+}
+
+
+int
+ips_apply (const char *mod, const char *ipsname)
+{
+  st_patch_t patch;
+
+  if (patch_load (&patch, ipsname) == -1)
+    exit (1);
+  if (patch_open (&patch, mod) == -1 ||
+      ips_patch (&patch, ipsname) == -1 ||
+      patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_close (&patch);
 
   puts ("Patching complete\n");
-  printf (ucon64_msg[WROTE], modname);
+  printf (ucon64_msg[WROTE], patch.fname);
   puts ("\n"
         "NOTE: Sometimes you have to add/strip a 512 bytes header when you patch a ROM\n"
         "      This means you must modify for example a SNES ROM with -swc or -stp or\n"
         "      the patch will not work");
 
-  unregister_func (remove_destfile);            // unregister _after_ possible padding
-  fclose (ipsfile);
-
   return 0;
 }
 
@@ -203,16 +182,15 @@ ips_apply (const char *mod, const char *ipsname)
 static void
 write_address (unsigned int new_address)
 {
-  address = new_address;
-  if (address < 16777216)
+  if (new_address < 16777216)
     /*
       16777216 = 2^24. The original code checked for 16711680 (2^24 - 64K), but
       that is an artificial limit.
     */
     {
-      fputc (address >> 16, ipsfile);
-      fputc (address >> 8, ipsfile);
-      fputc (address, ipsfile);
+      fputc (new_address >> 16, ipsfile);
+      fputc (new_address >> 8, ipsfile);
+      fputc (new_address, ipsfile);
     }
   else
     {
@@ -224,170 +202,163 @@ write_address (unsigned int new_address)
 
 
 static void
-write_block (unsigned char *buffer)
+write_record (unsigned int offset, const unsigned char *buffer,
+              unsigned int len, int rle)
 {
-  if (rle_value == NO_RLE)
-    {
-      fputc (ndiffs >> 8, ipsfile);
-      fputc (ndiffs, ipsfile);
-      fwrite (buffer, 1, ndiffs, ipsfile);
-    }
-  else
+  write_address (offset);
+  if (rle)
     {
       fputc (0, ipsfile);
       fputc (0, ipsfile);
-      fputc (ndiffs >> 8, ipsfile);
-      fputc (ndiffs, ipsfile);
-      fputc (rle_value, ipsfile);
+      fputc (len >> 8, ipsfile);
+      fputc (len, ipsfile);
+      fputc (buffer[0], ipsfile);
 #ifdef  DEBUG_IPS
       fputs ("RLE ", stdout);
 #endif
     }
+  else
+    {
+      fputc (len >> 8, ipsfile);
+      fputc (len, ipsfile);
+      fwrite (buffer, 1, len, ipsfile);
+    }
 #ifdef  DEBUG_IPS
-  printf ("length: %u\n", ndiffs);
+  printf ("[%02x] length: %u\n", offset, len);
 #endif
 }
 
 
 static void
-flush_diffs (unsigned char *buffer)
+write_block (const unsigned char *buffer)
+/*
+  Split the block of ndiffs bytes at address in normal and RLE records.
+
+  A run of equal bytes at the start or the end of the block becomes an RLE
+  record if it is longer than RLE_START_THRESHOLD bytes. Values smaller than 7
+  will make the IPS file larger than if no RLE would be used.
+  normal record:
+  i      address high byte
+  i + 1  address medium byte
+  i + 2  address low byte
+  i + 3  length high byte
+  i + 4  length low byte
+  i + 5  new byte
+  ...
+  RLE record:
+  i      address high byte
+  i + 1  address medium byte
+  i + 2  address low byte
+  i + 3  0
+  i + 4  0
+  i + 5  length high byte
+  i + 6  length low byte
+  i + 7  new byte
+  A run in the middle of the block interrupts it, which costs 8 bytes for the
+  RLE record plus 5 bytes for the record of the remaining bytes. So, a run
+  only becomes an RLE record there if it is longer than RLE_RESTART_THRESHOLD
+  bytes.
+*/
 {
-  if (ndiffs)
+  unsigned int i = 0, j = 0;
+
+  while (j < ndiffs)
     {
-      totaldiffs += ndiffs;
-      write_block (buffer);
-      ndiffs = 0;
-      rle_value = NO_RLE;
-      address = -1;
+      unsigned int run = 1, start = j, end;
+
+      while (j + run < ndiffs && buffer[j + run] == buffer[j])
+        run++;
+      end = j + run;
+      // no record may start at offset 0x454f46 (see add_diffs())
+      if (start > i && address + start == 0x454f46)
+        start++;
+      if (end < ndiffs && address + end == 0x454f46)
+        end--;
+      if (end > start &&
+          end - start > (j == 0 || j + run == ndiffs ?
+                           RLE_START_THRESHOLD : RLE_RESTART_THRESHOLD))
+        {
+          if (start > i)
+            write_record (address + i, buffer + i, start - i, 0);
+          write_record (address + start, buffer + start, end - start, 1);
+          i = end;
+        }
+      j += run;
     }
+  if (i < ndiffs)
+    write_record (address + i, buffer + i, ndiffs - i, 0);
 }
 
 
-static int
-rle_end (unsigned int value, unsigned char *buffer)
+static void
+flush_diffs (unsigned char *buffer, unsigned int len)
+// write the first len bytes of the block and keep the rest
 {
-  if (rle_value != NO_RLE && rle_value != value)
+  if (len)
     {
-      flush_diffs (buffer);
-      filepos--;
-      fseek (orgfile, filepos, SEEK_SET);
-      fseek (modfile, filepos, SEEK_SET);
-#ifdef  DEBUG_IPS
-      puts ("->normal");
-#endif
-      return 1;
+      unsigned int n = ndiffs;
+
+      totaldiffs += len;
+      ndiffs = len;
+      write_block (buffer);
+      ndiffs = n - len;
+      memmove (buffer, buffer + len, ndiffs);
+      address += len;
     }
-  return 0;
 }
 
 
-static int
-check_for_rle (unsigned char byte, unsigned char *buf)
+static void
+add_diffs (unsigned char *buffer, unsigned int offset,
+           const unsigned char *data, unsigned int len, const char *modname)
 {
-  int retval = 0;
-
-  if (rle_value == NO_RLE)
+  if (ndiffs && offset != address + ndiffs)     // not adjacent to the block
+    flush_diffs (buffer, ndiffs);
+  if (ndiffs == 0)
     {
-      /*
-        Start with a new block (and stop with the current one) only if there
-        are at least RLE_RESTART_THRESHOLD + 1 equal bytes in a row. Restarting
-        for RLE has some overhead: possibly 5 bytes for the interrupted current
-        block plus 7 bytes for the RLE block. So, values smaller than 11 for
-        RLE_RESTART_THRESHOLD only make the IPS file larger than if no RLE
-        compression would be used.
-      */
-      int use_rle;
-      unsigned int i;
-
-      if (ndiffs > RLE_RESTART_THRESHOLD)
-        {
-          use_rle = 1;
-          for (i = ndiffs - RLE_RESTART_THRESHOLD; i < ndiffs; i++)
-            if (buf[i] != byte)
-              {
-                use_rle = 0;
-                break;
-              }
-          if (use_rle)
-            // we are not using RLE, but we should => start a new block
-            {
-              ndiffs -= RLE_RESTART_THRESHOLD;
-              filepos -= RLE_RESTART_THRESHOLD;
-              fseek (orgfile, filepos, SEEK_SET);
-              fseek (modfile, filepos, SEEK_SET);
-
-              flush_diffs (buf);
-              write_address (filepos);
-              retval = 1;
-#ifdef  DEBUG_IPS
-              printf ("restart (%x)\n", address);
-#endif
-            }
-        }
-      /*
-        Use RLE only if the last RLE_START_THRESHOLD + 1 (or more) bytes were
-        the same. Values smaller than 7 for RLE_START_THRESHOLD will make the
-        IPS file larger than if no RLE would be used (for this block).
-        normal block:
-        i      address high byte
-        i + 1  address medium byte
-        i + 2  address low byte
-        i + 3  length high byte
-        i + 4  length low byte
-        i + 5  new byte
-        ...
-        RLE block:
-        i      address high byte
-        i + 1  address medium byte
-        i + 2  address low byte
-        i + 3  0
-        i + 4  0
-        i + 5  length high byte
-        i + 6  length low byte
-        i + 7  new byte
-        The value 7 for RLE_START_THRESHOLD (instead of 2) is to compensate for
-        normal blocks that immediately follow the RLE block.
-      */
-      else if (ndiffs > RLE_START_THRESHOLD)
+      address = offset;
+      if (offset == 0x454f46)
+        /*
+          We must avoid writing 0x454f46 (4542278) as offset, because it has a
+          special meaning. Offset 0x454f46 is interpreted as EOF marker. It is
+          a numerical representation of the ASCII string "EOF".
+          We solve the problem by starting the block one byte earlier, with
+          the (unchanged) byte of modfile at offset 0x454f45.
+        */
         {
-          use_rle = 1;
-          for (i = 0; i < ndiffs; i++)
-            if (buf[i] != byte)
-              {
-                use_rle = 0;
-                break;
-              }
-          if (use_rle)
-            {
-              rle_value = byte;
-#ifdef  DEBUG_IPS
-              puts ("->RLE");
-#endif
-            }
+          ucon64_fread (buffer, 0x454f46 - 1, 1, modname);
+          address--;
+          ndiffs = 1;
         }
     }
-  return retval;
+
+  while (len)
+    {
+      unsigned int n;
+
+      if (ndiffs == BUFSIZE)
+        // don't let the next block start at offset 0x454f46 either
+        flush_diffs (buffer, address + BUFSIZE == 0x454f46 ? BUFSIZE - 1 : BUFSIZE);
+      n = MIN (len, BUFSIZE - ndiffs);
+      memcpy (buffer + ndiffs, data, n);
+      ndiffs += n;
+      data += n;
+      len -= n;
+    }
 }
 
 
 int
 ips_create (const char *orgname, const char *modname)
 {
-  size_t i;
-  unsigned int orgfilesize, modfilesize;
+  st_patch_diff_t diff;
+  const unsigned char *ptr;
+  unsigned int offset, len;
   char ipsname[FILENAME_MAX];
-  unsigned char byte, byte2, buf[BUFSIZE];
+  unsigned char buf[BUFSIZE];
 
-  if ((orgfile = fopen (orgname, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], orgname);
-      exit (1);
-    }
-  if ((modfile = fopen (modname, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], modname);
-      exit (1);
-    }
+  if (patch_diff_open (&diff, orgname, modname, BRIDGE_LEN, 0) == -1)
+    exit (1);
   strcpy (ipsname, modname);
   set_suffix (ipsname, ".ips");
   ucon64_file_handler (ipsname, NULL, 0);
@@ -401,125 +372,19 @@ ips_create (const char *orgname, const char *modname)
   destfile = ipsfile;
   register_func (remove_destfile);
 
-  orgfilesize = (unsigned int) fsizeof (orgname);
-  modfilesize = (unsigned int) fsizeof (modname);
-
   fputs ("PATCH", ipsfile);
 
-next_byte:
-  for (;;)
-    {
-      byte = (unsigned char) fgetc (orgfile);
-      byte2 = (unsigned char) fgetc (modfile);
-      filepos++;
-      if (feof (modfile))
-        break;
-
-      if (modfilesize > 0x454f46 && filepos == 0x454f46)
-        /*
-          We must avoid writing 0x454f46 (4542278) as offset, because it has a
-          special meaning. Offset 0x454f46 is interpreted as EOF marker. It is
-          a numerical representation of the ASCII string "EOF".
-          We solve the problem by writing 2 patch bytes for offsets 0x454f45
-          and 0x454f46 if at least one of those bytes differs for orgfile and
-          modfile.
-        */
-        {
-          int byte3 = fgetc (orgfile);
-          unsigned char byte4 = read_byte (modfile);
-          filepos++;
-
-          if (byte3 == EOF || byte != byte2 || byte3 != byte4)
-            {
-              if (address < 0 || address + ndiffs != 0x454f46 - 1 ||
-                  ndiffs > BUFSIZE - 2)
-                {
-                  flush_diffs (buf);            // commit any pending data
-                  write_address (0x454f46 - 1);
-                }
-              // write 2 patch bytes (for offsets 0x454f45 and 0x454f46)
-              buf[ndiffs++] = byte2;
-              buf[ndiffs++] = byte4;
-
-#ifdef  DEBUG_IPS
-              printf ("[%02x] => %02x\n"
-                      "[%02x] => %02x\n",
-                      filepos - 2, buf[ndiffs - 2], filepos - 1, buf[ndiffs - 1]);
-#endif
-            }
-          continue;
-        }
-
-      if (byte != byte2 || feof (orgfile))
-        {
-          if (rle_end (byte2, buf))
-            continue;
-
-          if (address < 0)
-            {
-              flush_diffs (buf);                // commit previous block
-              write_address (filepos - 1);
-            }
-
-          buf[ndiffs++] = byte2;
-#ifdef  DEBUG_IPS
-          printf ("[%02x] => %02x%s\n", filepos - 1, byte2,
-                  rle_value != NO_RLE ? " *" : "");
-#endif
-          check_for_rle (byte2, buf);
-        }
-      else if (address >= 0)                    // byte == byte2 && !feof (orgfile)
-        {
-          size_t n, n2, ncompare;
-          unsigned char bridge[BRIDGE_LEN + 1];
-
-          bridge[0] = byte;
-          buf[ndiffs] = byte2;
-          n = fread (bridge + 1, 1, BRIDGE_LEN, orgfile);
-          n2 = fread (buf + ndiffs + 1, 1,
-                      MIN (BRIDGE_LEN, BUFSIZE - 1 - ndiffs), modfile);
-          ncompare = 1 + MIN (n, n2);
-
-          for (i = 1; i < ncompare; i++)        // buf[ndiffs] == bridge[0]
-            if (buf[ndiffs + i] != bridge[i])
-              {
-                for (n = 0; n < i; n++)
-                  {
-                    if (rle_end (buf[ndiffs], buf))
-                      goto next_byte;           // yep, ugly
-#ifdef  DEBUG_IPS
-                    printf ("[%02x] => %02x b%s\n", filepos - 1,
-                            buf[ndiffs], rle_value != NO_RLE ? " *" : "");
-#endif
-                    ndiffs++;
-                    if (check_for_rle (buf[ndiffs - 1], buf))
-                      goto next_byte;           // even uglier
-                    filepos++;
-                  }
-                filepos--;
-//                byte = bridge[n];
-//                byte2 = buf[ndiffs];
-                break;
-              }
-
-          fseek (orgfile, filepos, SEEK_SET);
-          fseek (modfile, filepos, SEEK_SET);
-
-          if (i == ncompare)                    // next few bytes are equal (between the files)
-            address = -1;
-        }
-      if (ndiffs == BUFSIZE)
-        flush_diffs (buf);
-    }
+  ndiffs = totaldiffs = 0;
+  while ((ptr = patch_diff_next (&diff, &offset, &len)) != NULL)
+    add_diffs (buf, offset, ptr, len, modname);
+  flush_diffs (buf, ndiffs);
 
-  flush_diffs (buf);
   fputs ("EOF", ipsfile);
-  if (modfilesize < orgfilesize)
-    write_address (modfilesize);
+  if (diff.mod_size < diff.org_size)
+    write_address (diff.mod_size);
 
   unregister_func (remove_destfile);
-  fclose (orgfile);
-  fclose (modfile);
+  patch_diff_close (&diff);
   fclose (ipsfile);
 
   if (totaldiffs == 0)
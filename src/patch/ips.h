@@ -24,11 +24,13 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define IPS_H
 
 #include "misc/getopt2.h"                       // st_getopt2_t
+#include "patch/patch.h"                        // st_patch_t
 
 
 extern const st_getopt2_t ips_usage[];
 
 extern int ips_apply (const char *destname, const char *ipsname);
+extern int ips_patch (st_patch_t *patch, const char *ipsname);
 extern int ips_create (const char *orgname, const char *modname);
 
 #endif
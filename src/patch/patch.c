@@ -19,15 +19,43 @@ You should have received a copy of the GNU General Public License
 along with this program; if not, write to the Free Software
 Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+#endif
+#include <stdlib.h>
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+#include <string.h>
+#ifdef  HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include "misc/archive.h"
+#include "misc/file.h"
+#include "misc/misc.h"
+#include "misc/string.h"
 #include "ucon64.h"
 #include "ucon64_misc.h"
+#include "patch/aps.h"
+#include "patch/bsl.h"
+#include "patch/gg.h"
+#include "patch/ips.h"
 #include "patch/patch.h"
+#include "patch/ppf.h"
+
+
+#define PATCH_DIFF_BLOCK (1024 * 1024)
 
 
 static st_ucon64_obj_t patch_obj[] =
   {
     {0, WF_SWITCH},
-    {0, WF_INIT | WF_PROBE}
+    {0, WF_INIT | WF_PROBE},
+    {0, WF_INIT | WF_PROBE | WF_STOP}
   };
 
 const st_getopt2_t patch_usage[] =
@@ -61,5 +89,610 @@ const st_getopt2_t patch_usage[] =
                "argument to be the name of the PATCH file",
       &patch_obj[0]
     },
+    {
+      "patch-chain", 1, 0, UCON64_PATCH_CHAIN,
+      "LIST", "apply the patches in LIST in one pass; LIST is a comma\n"
+              "separated list of IPS, APS, PPF and BSL patch files and Game\n"
+              "Genie codes, which are applied in the given order\n"
+              OPTION_LONG_S "patch-chain" OPTARG_S "fix.ips,trans.ips,SXIOPO\n"
+              "overlapping changes of different patches are reported",
+      &patch_obj[2]
+    },
     {NULL, 0, 0, 0, NULL, NULL, NULL}
   };
+
+
+int
+patch_load (st_patch_t *patch, const char *patchname)
+{
+  memset (patch, 0, sizeof (st_patch_t));
+  return patch_next (patch, patchname);
+}
+
+
+int
+patch_next (st_patch_t *patch, const char *patchname)
+{
+  free (patch->patch);
+  patch->pos = 0;
+  patch->patch_size = (unsigned int) fsizeof (patchname);
+  // one extra byte so that text formats can rely on a terminating '\0'
+  if ((patch->patch = (unsigned char *) malloc (patch->patch_size + 1)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], patch->patch_size + 1);
+      patch->patch_size = 0;
+      return -1;
+    }
+  if (ucon64_fread (patch->patch, 0, patch->patch_size, patchname) !=
+        patch->patch_size)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], patchname);
+      free (patch->patch);
+      patch->patch = NULL;
+      patch->patch_size = 0;
+      return -1;
+    }
+  patch->patch[patch->patch_size] = '\0';
+  return 0;
+}
+
+
+const unsigned char *
+patch_read (st_patch_t *patch, unsigned int len)
+{
+  const unsigned char *ptr;
+
+  if (len > patch->patch_size - patch->pos)
+    return NULL;
+  ptr = patch->patch + patch->pos;
+  patch->pos += len;
+  return ptr;
+}
+
+
+static void
+patch_reserve (st_patch_t *patch, unsigned int size)
+{
+  if (size > patch->alloc_size)
+    {
+      unsigned int alloc_size = patch->alloc_size ? patch->alloc_size : 4096;
+      unsigned char *data;
+
+      while (alloc_size < size && alloc_size < 0x80000000)
+        alloc_size *= 2;
+      if (alloc_size < size)
+        alloc_size = size;
+      if ((data = (unsigned char *) realloc (patch->data, alloc_size)) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], alloc_size);
+          exit (1);
+        }
+      patch->data = data;
+      patch->alloc_size = alloc_size;
+    }
+  if (size > patch->size)
+    {
+      memset (patch->data + patch->size, 0, size - patch->size);
+      patch->size = size;
+    }
+}
+
+
+int
+patch_open (st_patch_t *patch, const char *mod)
+{
+  strcpy (patch->fname, mod);
+  ucon64_file_handler (patch->fname, NULL, 0);
+
+  return patch_load_image (patch, mod);
+}
+
+
+int
+patch_load_image (st_patch_t *patch, const char *fname)
+{
+  unsigned int size = (unsigned int) fsizeof (fname);
+
+  patch->size = 0;
+  patch_reserve (patch, size);
+  if (ucon64_fread (patch->data, 0, size, fname) != size)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], fname);
+      return -1;
+    }
+  return 0;
+}
+
+
+static void
+patch_add_change (st_patch_t *patch, unsigned int offset, unsigned int len)
+{
+  if (patch->n_changes + 2 > patch->alloc_changes)
+    {
+      unsigned int alloc_changes = patch->alloc_changes ? patch->alloc_changes * 2 : 256;
+      unsigned int *changes;
+
+      if ((changes = (unsigned int *) realloc (patch->changes,
+             alloc_changes * sizeof (unsigned int))) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                   (unsigned int) (alloc_changes * sizeof (unsigned int)));
+          exit (1);
+        }
+      patch->changes = changes;
+      patch->alloc_changes = alloc_changes;
+    }
+  patch->changes[patch->n_changes++] = offset;
+  patch->changes[patch->n_changes++] = len;
+}
+
+
+void
+patch_copy (st_patch_t *patch, unsigned int offset, const void *src,
+            unsigned int len)
+{
+  if (len == 0)
+    return;
+  if (offset + len > patch->size)
+    patch_reserve (patch, offset + len);
+  memcpy (patch->data + offset, src, len);
+  if (patch->track_changes)
+    patch_add_change (patch, offset, len);
+}
+
+
+void
+patch_fill (st_patch_t *patch, unsigned int offset, int value, unsigned int len)
+{
+  if (len == 0)
+    return;
+  if (offset + len > patch->size)
+    patch_reserve (patch, offset + len);
+  memset (patch->data + offset, value, len);
+  if (patch->track_changes)
+    patch_add_change (patch, offset, len);
+}
+
+
+void
+patch_resize (st_patch_t *patch, unsigned int size)
+{
+  if (size > patch->size)
+    patch_reserve (patch, size);
+  else
+    patch->size = size;
+}
+
+
+int
+patch_write (st_patch_t *patch)
+{
+  FILE *file;
+
+  if ((file = fopen (patch->fname, "wb")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], patch->fname);
+      return -1;
+    }
+  if (patch->size && fwrite (patch->data, 1, patch->size, file) != patch->size)
+    {
+      fprintf (stderr, ucon64_msg[WRITE_ERROR], patch->fname);
+      fclose (file);
+      return -1;
+    }
+  fclose (file);
+  return 0;
+}
+
+
+void
+patch_close (st_patch_t *patch)
+{
+  free (patch->data);
+  free (patch->patch);
+  free (patch->changes);
+  patch->data = NULL;
+  patch->patch = NULL;
+  patch->changes = NULL;
+  patch->size = patch->alloc_size = patch->patch_size = patch->pos = 0;
+  patch->n_changes = patch->alloc_changes = 0;
+}
+
+
+int
+patch_read_number (st_patch_t *patch, unsigned int *value)
+{
+  uint64_t data = 0, shift = 1;
+
+  for (;;)
+    {
+      const unsigned char *ptr = patch_read (patch, 1);
+
+      if (ptr == NULL)
+        return -1;
+      data += (*ptr & 0x7f) * shift;
+      if (*ptr & 0x80)
+        break;
+      shift <<= 7;
+      data += shift;
+      if (shift > 0xffffffff)
+        return -1;
+    }
+  if (data > 0xffffffff)
+    return -1;
+  *value = (unsigned int) data;
+  return 0;
+}
+
+
+void
+patch_append (st_patch_t *patch, const void *src, unsigned int len)
+{
+  patch_copy (patch, patch->size, src, len);
+}
+
+
+void
+patch_append_number (st_patch_t *patch, unsigned int value)
+{
+  unsigned char buffer[8];
+  unsigned int n = 0;
+
+  for (;;)
+    {
+      unsigned char x = (unsigned char) (value & 0x7f);
+
+      value >>= 7;
+      if (value == 0)
+        {
+          buffer[n++] = 0x80 | x;
+          break;
+        }
+      buffer[n++] = x;
+      value--;
+    }
+  patch_append (patch, buffer, n);
+}
+
+
+int
+patch_apply_file (st_patch_t *patch, const char *patchname)
+{
+  if (patch_next (patch, patchname) == -1)
+    return -1;
+  if (patch->patch_size >= 5 && !memcmp (patch->patch, "PATCH", 5))
+    return ips_patch (patch, patchname);
+  if (patch->patch_size >= 5 && !memcmp (patch->patch, "APS10", 5))
+    return aps_patch (patch, patchname);
+  if (patch->patch_size >= 3 && !memcmp (patch->patch, "PPF", 3))
+    return ppf_patch (patch, patchname);
+  if (!stricmp (get_suffix (patchname), ".bsl"))
+    return bsl_patch (patch, patchname);
+  fprintf (stderr, "ERROR: %s is not an IPS, APS, PPF or BSL patch\n", patchname);
+  return -1;
+}
+
+
+static int
+patch_change_cmp (const void *a, const void *b)
+{
+  unsigned int offset1 = *(const unsigned int *) a,
+               offset2 = *(const unsigned int *) b;
+
+  return offset1 < offset2 ? -1 : offset1 > offset2 ? 1 : 0;
+}
+
+
+void
+patch_merge_changes (st_patch_t *patch)
+{
+  unsigned int i, n = 0;
+
+  qsort (patch->changes, patch->n_changes / 2, 2 * sizeof (unsigned int),
+         patch_change_cmp);
+  for (i = 0; i < patch->n_changes; )
+    {
+      unsigned int offset = patch->changes[i], end = offset + patch->changes[i + 1];
+
+      for (i += 2; i < patch->n_changes && patch->changes[i] <= end; i += 2)
+        if (patch->changes[i] + patch->changes[i + 1] > end)
+          end = patch->changes[i] + patch->changes[i + 1];
+      if (offset < end)
+        {
+          patch->changes[n++] = offset;
+          patch->changes[n++] = end - offset;
+        }
+    }
+  patch->n_changes = n;
+}
+
+
+static unsigned int
+patch_chain_overlap (const unsigned int *changes1, unsigned int n1,
+                     const unsigned int *changes2, unsigned int n2)
+// return the number of bytes in both sorted and merged lists of changes
+{
+  unsigned int i = 0, j = 0, n = 0;
+
+  while (i < n1 && j < n2)
+    {
+      unsigned int end1 = changes1[i] + changes1[i + 1],
+                   end2 = changes2[j] + changes2[j + 1],
+                   start = MAX (changes1[i], changes2[j]), end = MIN (end1, end2);
+
+      if (start < end)
+        n += end - start;
+      if (end1 < end2)
+        i += 2;
+      else
+        j += 2;
+    }
+  return n;
+}
+
+
+static int
+patch_chain_is_code (const char *item)
+/*
+  An existing file is a patch. A name with a suffix or a directory is taken to
+  be a patch file that could not be found, so that a mistyped patch name is not
+  reported as an invalid Game Genie code.
+*/
+{
+  if (access (item, F_OK) == 0)
+    return 0;
+  if (*get_suffix (item) || strchr (item, DIR_SEPARATOR) || strchr (item, '/'))
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], item);
+      return -1;
+    }
+  return 1;
+}
+
+
+int
+patch_chain (st_ucon64_nfo_t *rominfo, const char *list)
+{
+  st_patch_t patch;
+  char *buf, *items[UCON64_MAX_ARGS], is_code[UCON64_MAX_ARGS];
+  unsigned int *changes[UCON64_MAX_ARGS], n_changes[UCON64_MAX_ARGS], n_items,
+               n_codes = 0, i, j;
+  int result = 0;
+
+  if ((buf = (char *) malloc (strlen (list) + 1)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], (unsigned int) strlen (list) + 1);
+      return -1;
+    }
+  strcpy (buf, list);
+  if ((n_items = strarg (items, buf, ",", UCON64_MAX_ARGS)) == 0)
+    {
+      fputs ("ERROR: No patches specified\n", stderr);
+      free (buf);
+      return -1;
+    }
+  for (i = 0; i < n_items; i++)
+    {
+      int code = patch_chain_is_code (items[i]);
+
+      if (code == -1)
+        result = -1;
+      else if (code)
+        n_codes++;
+      is_code[i] = (char) code;
+      changes[i] = NULL;
+      n_changes[i] = 0;
+    }
+  if (result == 0 && n_codes)
+    {
+      if (!rominfo || ucon64.fsize <= 0)
+        {
+          fputs ("ERROR: You must specify a ROM to apply Game Genie codes to\n", stderr);
+          result = -1;
+        }
+      else if (gg_check (rominfo) == -1)
+        result = -1;
+    }
+  if (result == -1)
+    {
+      free (buf);
+      return -1;
+    }
+
+  memset (&patch, 0, sizeof (st_patch_t));
+  if (patch_open (&patch, ucon64.fname) == -1)
+    result = -1;
+  patch.track_changes = 1;
+  for (i = 0; i < n_items && result == 0; i++)
+    {
+      printf ("[%u/%u] %s\n", i + 1, n_items, items[i]);
+      if (is_code[i])
+        {
+          if ((result = gg_patch (&patch, rominfo, (const char **) &items[i], 1)) == 1)
+            {
+              fprintf (stderr, "ERROR: %s does not modify the ROM\n", items[i]);
+              result = -1;
+            }
+          fputc ('\n', stdout);
+        }
+      else
+        result = patch_apply_file (&patch, items[i]);
+      if (result == 0 && patch.n_changes)
+        {
+          // keep the writes of each item as a sorted list of ranges
+          patch_merge_changes (&patch);
+          if ((changes[i] = (unsigned int *)
+                 malloc (patch.n_changes * sizeof (unsigned int))) == NULL)
+            {
+              fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                       (unsigned int) (patch.n_changes * sizeof (unsigned int)));
+              exit (1);
+            }
+          memcpy (changes[i], patch.changes, patch.n_changes * sizeof (unsigned int));
+          n_changes[i] = patch.n_changes;
+          patch.n_changes = 0;
+        }
+    }
+
+  if (result == 0)
+    {
+      for (i = 0; i < n_items; i++)
+        for (j = i + 1; j < n_items; j++)
+          {
+            unsigned int n = patch_chain_overlap (changes[i], n_changes[i],
+                                                  changes[j], n_changes[j]);
+            if (n)
+              printf ("WARNING: [%u] %s overwrites %u bytes changed by [%u] %s\n",
+                      j + 1, items[j], n, i + 1, items[i]);
+          }
+      result = patch_write (&patch);
+    }
+  if (result == 0)
+    printf (ucon64_msg[WROTE], patch.fname);
+
+  patch_close (&patch);
+  for (i = 0; i < n_items; i++)
+    free (changes[i]);
+  free (buf);
+  return result;
+}
+
+
+int
+patch_diff_open (st_patch_diff_t *diff, const char *orgname,
+                 const char *modname, unsigned int min_gap, int pad_org)
+{
+  memset (diff, 0, sizeof (st_patch_diff_t));
+  if ((diff->orgfile = fopen (orgname, "rb")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], orgname);
+      return -1;
+    }
+  if ((diff->modfile = fopen (modname, "rb")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], modname);
+      patch_diff_close (diff);
+      return -1;
+    }
+  if ((diff->orgbuf = (unsigned char *) malloc (PATCH_DIFF_BLOCK)) == NULL ||
+      (diff->modbuf = (unsigned char *) malloc (PATCH_DIFF_BLOCK)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], PATCH_DIFF_BLOCK);
+      patch_diff_close (diff);
+      return -1;
+    }
+  diff->org_size = (unsigned int) fsizeof (orgname);
+  diff->mod_size = (unsigned int) fsizeof (modname);
+  diff->min_gap = min_gap;
+  diff->pad_org = pad_org;
+  return 0;
+}
+
+
+static unsigned int
+patch_diff_skip_equal (const unsigned char *org, const unsigned char *mod,
+                       unsigned int len)
+// returns the offset of the first byte that differs or len
+{
+  unsigned int i = 0;
+
+  while (i + 4096 <= len && !memcmp (org + i, mod + i, 4096))
+    i += 4096;
+  while (i + 64 <= len && !memcmp (org + i, mod + i, 64))
+    i += 64;
+  while (i < len && org[i] == mod[i])
+    i++;
+  return i;
+}
+
+
+static int
+patch_diff_read_block (st_patch_diff_t *diff)
+{
+  unsigned int len, org_len = 0;
+
+  diff->block_pos += diff->block_len;
+  diff->block_len = diff->compare_len = diff->pos = 0;
+  if (diff->block_pos >= diff->mod_size)
+    return -1;
+  len = MIN (diff->mod_size - diff->block_pos, PATCH_DIFF_BLOCK);
+  if ((len = (unsigned int) fread (diff->modbuf, 1, len, diff->modfile)) == 0)
+    return -1;
+  if (diff->block_pos < diff->org_size)
+    org_len = (unsigned int) fread (diff->orgbuf, 1,
+                                    MIN (diff->org_size - diff->block_pos, len),
+                                    diff->orgfile);
+  if (diff->pad_org)
+    {
+      memset (diff->orgbuf + org_len, 0, len - org_len);
+      org_len = len;
+    }
+  diff->block_len = len;
+  diff->compare_len = org_len;
+  return 0;
+}
+
+
+const unsigned char *
+patch_diff_next (st_patch_diff_t *diff, unsigned int *offset, unsigned int *len)
+{
+  const unsigned char *org = diff->orgbuf, *mod = diff->modbuf;
+  unsigned int start, end;
+
+  for (;;)
+    {
+      if (diff->pos == diff->block_len && patch_diff_read_block (diff) == -1)
+        return NULL;
+      if (diff->pos >= diff->compare_len)
+        {                                       // data past the end of orgname
+          start = diff->pos;
+          diff->pos = diff->block_len;
+          break;
+        }
+      diff->pos += patch_diff_skip_equal (org + diff->pos, mod + diff->pos,
+                                          diff->compare_len - diff->pos);
+      if (diff->pos < diff->compare_len)
+        {
+          start = end = diff->pos;
+          while (end < diff->compare_len)
+            {
+              unsigned int gap;
+
+              while (end < diff->compare_len && org[end] != mod[end])
+                end++;
+              for (gap = end; gap < diff->compare_len && gap - end <= diff->min_gap &&
+                   org[gap] == mod[gap]; gap++)
+                ;
+              if (gap == diff->compare_len || gap - end > diff->min_gap)
+                break;
+              end = gap;                        // bridge the equal bytes
+            }
+          diff->pos = end;
+          break;
+        }
+    }
+
+  *offset = diff->block_pos + start;
+  *len = diff->pos - start;
+  return mod + start;
+}
+
+
+const unsigned char *
+patch_diff_org (st_patch_diff_t *diff, unsigned int offset)
+{
+  return diff->orgbuf + (offset - diff->block_pos);
+}
+
+
+void
+patch_diff_close (st_patch_diff_t *diff)
+{
+  if (diff->orgfile)
+    fclose (diff->orgfile);
+  if (diff->modfile)
+    fclose (diff->modfile);
+  free (diff->orgbuf);
+  free (diff->modbuf);
+  memset (diff, 0, sizeof (st_patch_diff_t));
+}
@@ -21,9 +21,155 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifndef PATCH_H
 #define PATCH_H
 
+#include <stdio.h>                              // FILENAME_MAX
 #include "misc/getopt2.h"                       // st_getopt2_t
 
 
 extern const st_getopt2_t patch_usage[];
 
+/*
+  patch_chain() apply the IPS, APS, PPF and BSL patches and Game Genie codes in
+                  the comma separated list to the ROM in memory, in order, and
+                  write the result once; writes of one patch that overlap
+                  changes made by an earlier patch are reported; a list
+                  entry that is not a file is taken to be a Game Genie code,
+                  unless it has a suffix or a directory
+*/
+extern int patch_chain (st_ucon64_nfo_t *rominfo, const char *list);
+
+/*
+  In-memory patch engine shared by the IPS, APS, PPF and BSL code
+
+  patch_load()   read the whole patch file into memory; returns -1 on error
+  patch_next()   replace the patch file by patchname, but keep the image, so
+                   that several patches can be applied to one image; returns
+                   -1 on error
+  patch_apply_file() load patchname with patch_next() and apply it to the
+                   image; IPS, APS and PPF patches are recognised by their
+                   contents, BSL patches by their suffix; returns -1 on error
+  patch_read()   returns a pointer to the next len bytes of the patch file and
+                   advances the read position; returns NULL (and leaves the
+                   position alone) if fewer than len bytes are left
+  patch_open()   determine the output name for mod (with ucon64_file_handler())
+                   and read mod into memory; returns -1 on error
+  patch_load_image() read fname into memory without touching the output name;
+                   returns -1 on error
+  patch_copy()   copy len bytes from src to offset in the image
+  patch_fill()   set len bytes at offset in the image to value
+  patch_resize() truncate the image or pad it with zeroes
+  patch_merge_changes() sort changes by offset and merge the writes that
+                   overlap or touch
+  patch_write()  write the image to the output file with a single write;
+                   returns -1 on error
+  patch_close()  free all memory of the patch
+  patch_read_number() read a variable-length number as used by BPS and UPS;
+                   returns -1 if the number is truncated or does not fit
+  patch_append() append len bytes to the image
+  patch_append_number() append a variable-length number to the image
+
+  patch_copy() and patch_fill() grow the image when they write past its end.
+  The gap is filled with zeroes, like seeking past the end of a file does. The
+  output file is only created by patch_write(), so an invalid patch leaves it
+  untouched.
+  If track_changes is non-zero patch_copy() and patch_fill() also store the
+  offset and length of each write in changes (two entries per write).
+  The code that creates patches can use an st_patch_t with only fname set as
+  output buffer for patch_append() and patch_write().
+*/
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  char fname[FILENAME_MAX];                     // name of the output file
+  unsigned char *data;                          // image of the patched file
+  unsigned int size;
+  unsigned int alloc_size;
+  unsigned char *patch;                         // contents of the patch file
+  unsigned int patch_size;
+  unsigned int pos;                             // read position in patch
+  int track_changes;
+  unsigned int *changes;                        // offset/length pairs of the writes
+  unsigned int n_changes;
+  unsigned int alloc_changes;
+} st_patch_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+/*
+  Difference scanner shared by the code that creates patches
+
+  patch_diff_open()  open orgname and modname for patch_diff_next(); equal
+                       runs of at most min_gap bytes between two differences
+                       are made part of the range. If pad_org is non-zero bytes
+                       past the end of orgname are compared against 0,
+                       otherwise they are always reported as different; returns
+                       -1 on error
+  patch_diff_next()  returns a pointer to the bytes of modname of the next range
+                       that differs from orgname and stores its offset and
+                       length in offset and len. The data stay valid until the
+                       next call. Returns NULL after the last range
+  patch_diff_org()   returns a pointer to the bytes of orgname at offset of a
+                       range returned by the last call to patch_diff_next();
+                       only valid for bytes past the end of orgname if pad_org
+                       is non-zero
+  patch_diff_close() close the files and free all memory of the scanner
+
+  Both files are read in large blocks and equal data is skipped with memcmp(),
+  which the C library implements with vector instructions on most platforms.
+  Ranges never cross block boundaries, so a long range can be returned as
+  several adjacent ranges.
+*/
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  FILE *orgfile;
+  FILE *modfile;
+  unsigned int org_size;
+  unsigned int mod_size;
+  unsigned int min_gap;
+  int pad_org;
+  unsigned char *orgbuf;
+  unsigned char *modbuf;
+  unsigned int block_pos;                       // file offset of the current block
+  unsigned int block_len;
+  unsigned int compare_len;                     // part of the block that exists in orgname
+  unsigned int pos;                             // scan position in the current block
+} st_patch_diff_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+extern int patch_load (st_patch_t *patch, const char *patchname);
+extern int patch_next (st_patch_t *patch, const char *patchname);
+extern int patch_apply_file (st_patch_t *patch, const char *patchname);
+extern const unsigned char *patch_read (st_patch_t *patch, unsigned int len);
+extern int patch_open (st_patch_t *patch, const char *mod);
+extern int patch_load_image (st_patch_t *patch, const char *fname);
+extern void patch_copy (st_patch_t *patch, unsigned int offset,
+                        const void *src, unsigned int len);
+extern void patch_fill (st_patch_t *patch, unsigned int offset, int value,
+                        unsigned int len);
+extern void patch_resize (st_patch_t *patch, unsigned int size);
+extern void patch_merge_changes (st_patch_t *patch);
+extern int patch_write (st_patch_t *patch);
+extern void patch_close (st_patch_t *patch);
+extern int patch_read_number (st_patch_t *patch, unsigned int *value);
+extern void patch_append (st_patch_t *patch, const void *src, unsigned int len);
+extern void patch_append_number (st_patch_t *patch, unsigned int value);
+extern int patch_diff_open (st_patch_diff_t *diff, const char *orgname,
+                            const char *modname, unsigned int min_gap,
+                            int pad_org);
+extern const unsigned char *patch_diff_next (st_patch_diff_t *diff,
+                                             unsigned int *offset,
+                                             unsigned int *len);
+extern const unsigned char *patch_diff_org (st_patch_diff_t *diff,
+                                            unsigned int offset);
+extern void patch_diff_close (st_patch_diff_t *diff);
+
 #endif
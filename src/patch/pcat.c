@@ -0,0 +1,458 @@
+/*
+pcat.c - patch catalogue for uCON64
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+#endif
+#include <stdlib.h>
+#include <sys/stat.h>
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+#include <string.h>
+#include "misc/archive.h"
+#include "misc/bswap.h"
+#include "misc/chksum.h"
+#include "misc/file.h"
+#include "ucon64.h"
+#include "ucon64_misc.h"
+#include "patch/patch.h"
+#include "patch/pcat.h"
+
+
+#define PCAT_FNAME "patches.cat"
+#define PCAT_MAGIC "UCPCAT01"
+#define PCAT_MAGIC_LEN 8
+#define PCAT_ENTRY_HEADER_LEN (9 * 4)
+
+/*
+  The patch catalogue stores for each patch that has been added with --pcatadd
+  the CRC32 and size of the ROM it belongs to and the changes it makes to that
+  ROM. --pcat uses it to find the patch for a ROM and applies the changes
+  without reading or parsing the patch file. A ROM that has the wrong size is
+  rejected without reading it.
+
+  File format (all numbers are 32-bit little-endian):
+  "UCPCAT01"
+  for each entry:
+    size of the rest of the entry
+    CRC32 and size of the original ROM
+    CRC32 and size of the patched ROM
+    size and modification time of the patch file
+    number of records
+    length of the name of the patch file, followed by the name (with path)
+    for each record: offset, length, followed by length bytes of patched data
+
+  Records are sorted by offset and do not overlap.
+*/
+
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  unsigned int org_crc;
+  unsigned int org_size;
+  unsigned int mod_crc;
+  unsigned int mod_size;
+  unsigned int patch_size;
+  unsigned int patch_mtime;
+  unsigned int n_records;
+  char name[FILENAME_MAX];
+  const unsigned char *records;
+  unsigned int records_len;
+} st_pcat_entry_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+static st_ucon64_obj_t pcat_obj[] =
+  {
+    {0, WF_STOP}
+  };
+
+const st_getopt2_t pcat_usage[] =
+  {
+    {
+      "pcat", 0, 0, UCON64_PCAT,
+      NULL, "apply the patch from the patch catalogue that belongs to ROM\n"
+            "(by CRC32 and size); use " OPTION_LONG_S "patch to choose one of several\n"
+            "matching patches",
+      &pcat_obj[0]
+    },
+    {
+      "pcatadd", 0, 0, UCON64_PCATADD,
+      NULL, "add PATCH to the patch catalogue; ROM should be the unpatched\n"
+            "ROM (IPS, APS, PPF and BSL patches are supported)",
+      &pcat_obj[0]
+    },
+    {NULL, 0, 0, 0, NULL, NULL, NULL}
+  };
+
+static st_pcat_entry_t *pcat_entries = NULL;
+static unsigned int pcat_n_entries = 0, pcat_alloc_entries = 0;
+static unsigned char *pcat_data = NULL;
+static int pcat_loaded = 0;
+
+
+static unsigned int
+get_le32 (const unsigned char *ptr)
+{
+  unsigned int value;
+
+  memcpy (&value, ptr, 4);
+  return le2me_32 (value);
+}
+
+
+static void
+append_le32 (st_patch_t *patch, unsigned int value)
+{
+  value = me2le_32 (value);
+  patch_append (patch, &value, 4);
+}
+
+
+static void
+pcat_fname (char *fname)
+{
+  snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S PCAT_FNAME,
+            *ucon64_settings.configdir ? ucon64_settings.configdir : ".");
+  fname[FILENAME_MAX - 1] = '\0';
+}
+
+
+static st_pcat_entry_t *
+pcat_new_entry (void)
+{
+  if (pcat_n_entries == pcat_alloc_entries)
+    {
+      unsigned int alloc_entries = pcat_alloc_entries ? pcat_alloc_entries * 2 : 64;
+      st_pcat_entry_t *entries;
+
+      if ((entries = (st_pcat_entry_t *) realloc (pcat_entries,
+             alloc_entries * sizeof (st_pcat_entry_t))) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                   (unsigned int) (alloc_entries * sizeof (st_pcat_entry_t)));
+          exit (1);
+        }
+      pcat_entries = entries;
+      pcat_alloc_entries = alloc_entries;
+    }
+  return &pcat_entries[pcat_n_entries++];
+}
+
+
+static int
+pcat_load (void)
+// read the catalogue once; it is shared by all ROMs of a run
+{
+  char fname[FILENAME_MAX];
+  struct stat fstate;
+  unsigned int size, pos;
+
+  if (pcat_loaded)
+    return 0;
+  pcat_fname (fname);
+  if (stat (fname, &fstate) != 0)
+    {
+      pcat_loaded = 1;                          // no catalogue yet
+      return 0;
+    }
+
+  size = (unsigned int) fsizeof (fname);
+  if ((pcat_data = (unsigned char *) malloc (size ? size : 1)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], size);
+      return -1;
+    }
+  if (ucon64_fread (pcat_data, 0, size, fname) != size)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], fname);
+      return -1;
+    }
+  if (size < PCAT_MAGIC_LEN || memcmp (pcat_data, PCAT_MAGIC, PCAT_MAGIC_LEN))
+    {
+      fprintf (stderr, "ERROR: %s is not a patch catalogue\n", fname);
+      return -1;
+    }
+
+  for (pos = PCAT_MAGIC_LEN; pos < size; )
+    {
+      st_pcat_entry_t *entry;
+      const unsigned char *ptr = pcat_data + pos, *end;
+      unsigned int entry_len, name_len, i;
+
+      if (size - pos < PCAT_ENTRY_HEADER_LEN ||
+          (entry_len = get_le32 (ptr)) > size - pos - 4 ||
+          entry_len < PCAT_ENTRY_HEADER_LEN - 4)
+        break;
+      end = ptr + 4 + entry_len;
+      entry = pcat_new_entry ();
+      entry->org_crc = get_le32 (ptr + 4);
+      entry->org_size = get_le32 (ptr + 8);
+      entry->mod_crc = get_le32 (ptr + 12);
+      entry->mod_size = get_le32 (ptr + 16);
+      entry->patch_size = get_le32 (ptr + 20);
+      entry->patch_mtime = get_le32 (ptr + 24);
+      entry->n_records = get_le32 (ptr + 28);
+      name_len = get_le32 (ptr + 32);
+      ptr += PCAT_ENTRY_HEADER_LEN;
+      if (name_len >= FILENAME_MAX || name_len > (unsigned int) (end - ptr))
+        break;
+      memcpy (entry->name, ptr, name_len);
+      entry->name[name_len] = '\0';
+      ptr += name_len;
+      entry->records = ptr;
+      entry->records_len = (unsigned int) (end - ptr);
+
+      // check the records now, so that pcat_apply() can trust them
+      for (i = 0; i < entry->n_records; i++)
+        {
+          unsigned int len;
+
+          if (end - ptr < 8 || (len = get_le32 (ptr + 4)) > (unsigned int) (end - ptr - 8) ||
+              len > entry->mod_size || get_le32 (ptr) > entry->mod_size - len)
+            break;
+          ptr += 8 + len;
+        }
+      if (i < entry->n_records || ptr != end)
+        break;
+      pos += 4 + entry_len;
+    }
+  if (pos < size)
+    {
+      fprintf (stderr, "ERROR: Patch catalogue %s is corrupt\n", fname);
+      pcat_n_entries = 0;
+      return -1;
+    }
+  pcat_loaded = 1;
+  return 0;
+}
+
+
+static int
+pcat_save (void)
+{
+  st_patch_t cat;
+  unsigned int i;
+  int result;
+
+  memset (&cat, 0, sizeof (st_patch_t));
+  pcat_fname (cat.fname);
+  patch_append (&cat, PCAT_MAGIC, PCAT_MAGIC_LEN);
+  for (i = 0; i < pcat_n_entries; i++)
+    {
+      st_pcat_entry_t *entry = &pcat_entries[i];
+      unsigned int name_len = (unsigned int) strlen (entry->name);
+
+      append_le32 (&cat, PCAT_ENTRY_HEADER_LEN - 4 + name_len + entry->records_len);
+      append_le32 (&cat, entry->org_crc);
+      append_le32 (&cat, entry->org_size);
+      append_le32 (&cat, entry->mod_crc);
+      append_le32 (&cat, entry->mod_size);
+      append_le32 (&cat, entry->patch_size);
+      append_le32 (&cat, entry->patch_mtime);
+      append_le32 (&cat, entry->n_records);
+      append_le32 (&cat, name_len);
+      patch_append (&cat, entry->name, name_len);
+      patch_append (&cat, entry->records, entry->records_len);
+    }
+  result = patch_write (&cat);
+  patch_close (&cat);
+  return result;
+}
+
+
+int
+pcat_add (const char *romname, const char *patchname)
+{
+  st_patch_t patch, records;
+  st_pcat_entry_t *entry = NULL;
+  struct stat fstate;
+  char fullname[FILENAME_MAX];
+  unsigned int org_crc, org_size, i, n;
+
+  if (pcat_load () == -1)
+    return -1;
+  if (!realpath2 (patchname, fullname) || stat (fullname, &fstate) != 0)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], patchname);
+      return -1;
+    }
+
+  memset (&patch, 0, sizeof (st_patch_t));
+  if (patch_load_image (&patch, romname) == -1)
+    {
+      patch_close (&patch);
+      return -1;
+    }
+  org_crc = crc32 (0, patch.data, patch.size);
+  org_size = patch.size;
+  patch.track_changes = 1;
+  if (patch_apply_file (&patch, fullname) == -1)
+    {
+      patch_close (&patch);
+      return -1;
+    }
+
+  patch_merge_changes (&patch);
+  memset (&records, 0, sizeof (st_patch_t));
+  for (i = n = 0; i < patch.n_changes; i += 2)
+    {
+      unsigned int offset = patch.changes[i], end = offset + patch.changes[i + 1];
+
+      if (end > patch.size)                     // patch truncated the file
+        end = patch.size;
+      if (offset >= end)
+        continue;
+      append_le32 (&records, offset);
+      append_le32 (&records, end - offset);
+      patch_append (&records, patch.data + offset, end - offset);
+      n++;
+    }
+
+  // a patch replaces an earlier version of itself for the same ROM
+  for (i = 0; i < pcat_n_entries; i++)
+    if (pcat_entries[i].org_crc == org_crc && pcat_entries[i].org_size == org_size &&
+        !strcmp (basename2 (pcat_entries[i].name), basename2 (fullname)))
+      {
+        entry = &pcat_entries[i];
+        break;
+      }
+  if (!entry)
+    entry = pcat_new_entry ();
+  entry->org_crc = org_crc;
+  entry->org_size = org_size;
+  entry->mod_crc = crc32 (0, patch.data, patch.size);
+  entry->mod_size = patch.size;
+  entry->patch_size = (unsigned int) fstate.st_size;
+  entry->patch_mtime = (unsigned int) fstate.st_mtime;
+  entry->n_records = n;
+  strcpy (entry->name, fullname);
+  entry->records = records.data;                // records.data is kept until exit
+  entry->records_len = records.size;
+  patch_close (&patch);
+
+  if (pcat_save () == -1)
+    return -1;
+  printf ("Added %s to the patch catalogue (ROM CRC32: 0x%08x, %u records)\n",
+          fullname, org_crc, n);
+  return 0;
+}
+
+
+int
+pcat_apply (const char *romname, const char *patchname)
+{
+  st_patch_t patch;
+  st_pcat_entry_t *entry = NULL;
+  struct stat fstate;
+  const unsigned char *ptr;
+  unsigned int size, crc, i, n_matches = 0;
+
+  if (pcat_load () == -1)
+    return -1;
+
+  // reject ROMs of the wrong size without reading them
+  size = (unsigned int) fsizeof (romname);
+  for (i = 0; i < pcat_n_entries; i++)
+    if (pcat_entries[i].org_size == size)
+      break;
+  if (i == pcat_n_entries)
+    {
+      fprintf (stderr, "ERROR: The patch catalogue contains no patch for %s\n", romname);
+      return -1;
+    }
+
+  memset (&patch, 0, sizeof (st_patch_t));
+  if (patch_load_image (&patch, romname) == -1)
+    {
+      patch_close (&patch);
+      return -1;
+    }
+  crc = crc32 (0, patch.data, patch.size);
+  if (patchname && !*patchname)
+    patchname = NULL;
+  for (i = 0; i < pcat_n_entries; i++)
+    if (pcat_entries[i].org_crc == crc && pcat_entries[i].org_size == size &&
+        (!patchname || !strcmp (basename2 (pcat_entries[i].name), basename2 (patchname))) &&
+        n_matches++ == 0)
+      entry = &pcat_entries[i];
+  if (n_matches != 1)
+    {
+      if (n_matches == 0)
+        fprintf (stderr, "ERROR: The patch catalogue contains no patch for %s\n", romname);
+      else
+        {
+          fputs ("ERROR: Several patches match this ROM. Choose one with " OPTION_LONG_S "patch:\n",
+                 stderr);
+          for (i = 0; i < pcat_n_entries; i++)
+            if (pcat_entries[i].org_crc == crc && pcat_entries[i].org_size == size)
+              fprintf (stderr, "  %s\n", pcat_entries[i].name);
+        }
+      patch_close (&patch);
+      return -1;
+    }
+
+  if (stat (entry->name, &fstate) == 0 &&
+      ((unsigned int) fstate.st_size != entry->patch_size ||
+       (unsigned int) fstate.st_mtime != entry->patch_mtime))
+    {
+      fprintf (stderr, "ERROR: %s has changed since it was added to the patch catalogue\n"
+                       "       Add it again with " OPTION_LONG_S "pcatadd\n", entry->name);
+      patch_close (&patch);
+      return -1;
+    }
+
+  printf ("Applying %s from the patch catalogue...\n", entry->name);
+  for (i = 0, ptr = entry->records; i < entry->n_records; i++)
+    {
+      unsigned int len = get_le32 (ptr + 4);
+
+      patch_copy (&patch, get_le32 (ptr), ptr + 8, len);
+      ptr += 8 + len;
+    }
+  patch_resize (&patch, entry->mod_size);
+  if (crc32 (0, patch.data, patch.size) != entry->mod_crc)
+    {
+      fputs ("ERROR: The patched ROM does not have the expected checksum\n", stderr);
+      patch_close (&patch);
+      return -1;
+    }
+
+  strcpy (patch.fname, romname);
+  ucon64_file_handler (patch.fname, NULL, 0);
+  if (patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      return -1;
+    }
+  patch_close (&patch);
+
+  printf (ucon64_msg[WROTE], patch.fname);
+  return 0;
+}
@@ -0,0 +1,40 @@
+/*
+pcat.h - patch catalogue for uCON64
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifndef PCAT_H
+#define PCAT_H
+
+#include "misc/getopt2.h"                       // st_getopt2_t
+
+
+extern const st_getopt2_t pcat_usage[];
+
+/*
+  pcat_add()   add the changes that patchname makes to romname to the patch
+                 catalogue; romname should be the unpatched ROM
+  pcat_apply() find the patch for romname in the patch catalogue by CRC32 and
+                 size and apply it without reading the patch file; if several
+                 patches match patchname selects one of them (by file name),
+                 otherwise it may be NULL
+*/
+extern int pcat_add (const char *romname, const char *patchname);
+extern int pcat_apply (const char *romname, const char *patchname);
+
+#endif
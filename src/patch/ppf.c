@@ -40,10 +40,16 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "misc/string.h"                        // MEMCMP2_CASE
 #include "ucon64.h"
 #include "ucon64_misc.h"
+#include "patch/patch.h"
 #include "patch/ppf.h"
 
 
 #define MAX_ID_SIZE 3072
+#define PPF_BLOCK_BIN 0x9320                    // position of the identification block
+#define PPF_BLOCK_GI 0x80a0
+#define PPF3_HEADER_LEN 60
+#define PPF3_IMAGE_BIN 0
+#define PPF3_IMAGE_GI 1
 #define DIFF_FSIZE
 /*
   I (dbjh) couldn't tell from the specification below if it is required that
@@ -62,12 +68,24 @@ const st_getopt2_t ppf_usage[] =
   {
     {
       "ppf", 0, 0, UCON64_PPF,
-      NULL, "apply PPF PATCH to IMAGE (PPF<=v2.0); ROM should be an IMAGE",
+      NULL, "apply PPF PATCH to IMAGE (PPF<=v3.0); ROM should be an IMAGE",
+      &ppf_obj[0]
+    },
+    {
+      "uppf", 0, 0, UCON64_UPPF,
+      NULL, "undo PPF PATCH (PPF v3.0 with undo data); ROM should be the\n"
+            "patched IMAGE",
       &ppf_obj[0]
     },
     {
       "mkppf", 1, 0, UCON64_MKPPF,
-      "ORG_IMG", "create PPF patch; ROM should be the modified IMAGE",
+      "ORG_IMG", "create PPF patch (PPF v2.0); ROM should be the modified IMAGE",
+      &ppf_obj[0]
+    },
+    {
+      "mkppf3", 1, 0, UCON64_MKPPF3,
+      "ORG_IMG", "create PPF patch with undo data (PPF v3.0); ROM should be the\n"
+                 "modified IMAGE",
       &ppf_obj[0]
     },
     {
@@ -77,7 +95,7 @@ const st_getopt2_t ppf_usage[] =
     },
     {
       "idppf", 1, 0, UCON64_IDPPF,
-      "FILE_ID.DIZ", "change FILE_ID.DIZ of PPF PATCH (PPF v2.0)",
+      "FILE_ID.DIZ", "change FILE_ID.DIZ of PPF PATCH (PPF v2.0 and v3.0)",
       NULL
     },
     {NULL, 0, 0, 0, NULL, NULL, NULL}
@@ -163,54 +181,105 @@ If you do a PPF 2.0 applier be sure to check for an existing FILE_ID
 AREA, because it is located after the patch data!
 
 @END_FILEID
+
+
+PPF 3.0 (encoding method #2) differs from PPF 2.0 in the following ways:
+
+- The header is "PPF30", encoding method ($02), the description (50 bytes),
+  image type (1 byte; $00 = BIN, $01 = GI), block check (1 byte; $01 if the
+  header is followed by the 1024 byte identification block), undo data
+  (1 byte; $01 if present) and an unused byte (60 bytes in total). There is no
+  file size. The identification block is taken from $9320 for BIN and from
+  $80A0 for GI.
+- The file offset of each record is 8 bytes long. If undo data is present the
+  new data of a record is followed by the same number of bytes of the original
+  file.
+- The length of the FILE_ID.DIZ after @END_FILE_ID.DIZ is 2 bytes long.
 */
 
 
-// based on source code of ApplyPPF v2.0 for Linux/UNIX by Icarus/Paradox
-int
-ppf_apply (const char *mod, const char *ppfname)
+static int
+ppf_show_diz (st_patch_t *patch, unsigned int len_size, unsigned int *bytes_to_skip)
+// len_size is the size of the length field after @END_FILE_ID.DIZ
 {
-  FILE *modfile, *ppffile;
-  char desc[50 + 1], buffer[1024], modname[FILENAME_MAX];
-  int x, method, dizlen = 0, ppfsize, bytes_to_skip = 0, n_changes;
-  unsigned int pos;
+  unsigned int ppfsize = patch->patch_size, dizlen;
+  const unsigned char *ptr = patch->patch + ppfsize - len_size;
+  char diz[MAX_ID_SIZE + 1];
 
-  strcpy (modname, mod);
-  ucon64_file_handler (modname, NULL, 0);
-  fcopy (mod, 0, fsizeof (mod), modname, "wb"); // no copy if one file
+  // Is there a file id?
+  if (memcmp (".DIZ", ptr - 4, 4))
+    {
+      puts ("FILE_ID.DIZ     : No\n");
+      return 0;
+    }
 
-  if ((modfile = fopen (modname, "r+b")) == NULL)
+  puts ("FILE_ID.DIZ     : Yes, showing...");
+  // FILE_ID.DIZ size is in little-endian format
+  dizlen = ptr[0] + (ptr[1] << 8);
+  if (len_size == 4)
+    dizlen += (ptr[2] << 16) + ((unsigned int) ptr[3] << 24);
+  if (dizlen > ppfsize - (16 + len_size))
     {
-      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], modname);
-      exit (1);
+      fputs ("ERROR: Unexpected end of patch file\n", stderr);
+      return -1;
     }
-  if ((ppffile = fopen (ppfname, "rb")) == NULL)
+  ptr = patch->patch + ppfsize - dizlen - (16 + len_size);
+  *bytes_to_skip = dizlen + 18 + 16 + len_size;
+  if (dizlen > MAX_ID_SIZE)
+    dizlen = MAX_ID_SIZE;                       // do this after setting bytes_to_skip!
+  memcpy (diz, ptr, dizlen);
+  diz[dizlen] = '\0';                           // terminate string
+  puts (diz);
+  return 0;
+}
+
+
+static int
+ppf_check_block (st_patch_t *patch, unsigned int block_pos)
+// compare the 1024 byte block at 60 in the patch with the image at block_pos
+{
+  unsigned char buffer[1024];
+
+  memset (buffer, 0, 1024);                     // one little hack that makes PPF
+  if (patch->size > block_pos)                  //  suitable for small files
+    memcpy (buffer, patch->data + block_pos, MIN (patch->size - block_pos, 1024));
+  if (memcmp (patch->patch + 60, buffer, 1024))
     {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ppfname);
-      exit (1);
+      fputs ("ERROR: This patch does not belong to this image\n", stderr);
+      return -1;
     }
+  return 0;
+}
 
-  ppfsize = (int) fsizeof (ppfname);
+
+// based on source code of ApplyPPF v2.0 for Linux/UNIX by Icarus/Paradox
+static int
+ppf_patch_image (st_patch_t *patch, const char *ppfname, int undo)
+{
+  const unsigned char *ptr;
+  char desc[50 + 1];
+  int method, has_undo = 0;
+  unsigned int ppfsize, bytes_to_skip = 0, offset_size = 4;
+
+  ppfsize = patch->patch_size;
 
   // Is it a PPF File?
-  if (ppfsize < 56 || !fread (buffer, 3, 1, ppffile) || memcmp ("PPF", buffer, 3))
+  if (ppfsize < 56 || memcmp ("PPF", patch->patch, 3))
     {
       fprintf (stderr, "ERROR: %s is not a valid PPF file\n", ppfname);
-      exit (1);
+      return -1;
     }
 
-  // What encoding method? PPF 1.0 or PPF 2.0?
-  fseek (ppffile, 5, SEEK_SET);
-  method = fgetc (ppffile);
-  if (method != 0 && method != 1)
+  // What encoding method? PPF 1.0, PPF 2.0 or PPF 3.0?
+  method = patch->patch[5];
+  if (method != 0 && method != 1 && method != 2)
     {
       fputs ("ERROR: Unknown encoding method\n", stderr);
-      exit (1);
+      return -1;
     }
 
   // Show PPF information
-  fseek (ppffile, 6, SEEK_SET);                 // Read description line
-  fread_checked (desc, 50, 1, ppffile);
+  memcpy (desc, patch->patch + 6, 50);          // Read description line
   desc[50] = '\0';                              // terminate string
   printf ("\n"                                  // print a newline between
           "Filename        : %s\n", ppfname);   //  backup message and PPF info
@@ -220,110 +289,180 @@ ppf_apply (const char *mod, const char *ppfname)
   if (method == 0)                              // PPF 1.0
     {
       puts ("FILE_ID.DIZ     : No\n");
-      x = 56;                                   // file pointer is at right position (56)
+      patch->pos = 56;
     }
-  else // method == 1                           // PPF 2.0
+  else if (method == 1)                         // PPF 2.0
     {
-      char ppfblock[1024];
-      int modlen;
-
-      fseek (ppffile, ppfsize - 8, SEEK_SET);
-      fread_checked (buffer, 4, 1, ppffile);
+      unsigned int modlen;
 
-      // Is there a file id?
-      if (memcmp (".DIZ", buffer, 4))
-        puts ("FILE_ID.DIZ     : No\n");
-      else
+      if (ppfsize < 1084)
         {
-          char diz[MAX_ID_SIZE + 1];
-
-          puts ("FILE_ID.DIZ     : Yes, showing...");
-          fread_checked (&dizlen, 4, 1, ppffile);
-#ifdef  WORDS_BIGENDIAN
-          dizlen = bswap_32 (dizlen);           // FILE_ID.DIZ size is in little-endian format
-#endif
-          fseek (ppffile, ppfsize - dizlen - (16 + 4), SEEK_SET);
-          bytes_to_skip = dizlen + 18 + 16 + 4; // +4 for FILE_ID.DIZ size integer
-          if (dizlen > MAX_ID_SIZE)
-            dizlen = MAX_ID_SIZE;               // do this after setting bytes_to_skip!
-          fread_checked (diz, dizlen, 1, ppffile);
-          diz[dizlen] = '\0';                   // terminate string
-          puts (diz);
+          fputs ("ERROR: Unexpected end of patch file\n", stderr);
+          return -1;
         }
+      if (ppf_show_diz (patch, 4, &bytes_to_skip) == -1)
+        return -1;
 
       // Do the file size check
-      fseek (ppffile, 56, SEEK_SET);
-      fread_checked (&x, 4, 1, ppffile);
-#ifdef  WORDS_BIGENDIAN
-      x = bswap_32 (x);                         // file size is stored in little-endian format
-#endif
-      modlen = (int) fsizeof (modname);
-      if (x != modlen)
+      memcpy (&modlen, patch->patch + 56, 4);
+      modlen = le2me_32 (modlen);               // file size is stored in little-endian format
+      if (modlen != patch->size)
         {
-          fprintf (stderr, "ERROR: The size of %s is not %d bytes\n", modname, x);
-          exit (1);
+          fprintf (stderr, "ERROR: The size of %s is not %d bytes\n", patch->fname,
+                   (int) modlen);
+          return -1;
         }
 
       // Do the binary block check
-      fseek (ppffile, 60, SEEK_SET);
-      fread_checked (ppfblock, 1024, 1, ppffile);
-      fseek (modfile, 0x9320, SEEK_SET);
-      memset (buffer, 0, 1024);                 // one little hack that makes PPF
-      fread_checked2 (buffer, 1024, 1, modfile);//  suitable for files < 38688 bytes
-      if (memcmp (ppfblock, buffer, 1024))
+      if (ppf_check_block (patch, PPF_BLOCK_BIN) == -1)
+        return -1;
+
+      patch->pos = 1084;
+    }
+  else // method == 2                           // PPF 3.0
+    {
+      int image_type, block_check;
+
+      if (ppfsize < PPF3_HEADER_LEN)
         {
-          fputs ("ERROR: This patch does not belong to this image\n", stderr);
-          exit (1);
+          fputs ("ERROR: Unexpected end of patch file\n", stderr);
+          return -1;
         }
+      image_type = patch->patch[56];
+      block_check = patch->patch[57];
+      has_undo = patch->patch[58];
+      printf ("Image type      : %s\n", image_type == PPF3_IMAGE_GI ? "GI" : "BIN");
+      printf ("Undo data       : %s\n", has_undo ? "Yes" : "No");
+      if (ppf_show_diz (patch, 2, &bytes_to_skip) == -1)
+        return -1;
+
+      patch->pos = PPF3_HEADER_LEN;
+      if (block_check)
+        {
+          if (ppfsize < PPF3_HEADER_LEN + 1024)
+            {
+              fputs ("ERROR: Unexpected end of patch file\n", stderr);
+              return -1;
+            }
+          // a patch can change the block, so it is only checked when patching
+          if (!undo &&
+              ppf_check_block (patch, image_type == PPF3_IMAGE_GI ?
+                                        PPF_BLOCK_GI : PPF_BLOCK_BIN) == -1)
+            return -1;
+          patch->pos += 1024;
+        }
+      offset_size = 8;
+    }
 
-      fseek (ppffile, 1084, SEEK_SET);
-      x = 1084;
+  if (undo && !has_undo)
+    {
+      fprintf (stderr, "ERROR: %s does not contain undo data\n", ppfname);
+      return -1;
     }
 
   // Patch the image
-  puts ("Patching...");
-  for (; x < ppfsize - bytes_to_skip; x += 4 + 1 + n_changes)
+  puts (undo ? "Undoing patch..." : "Patching...");
+  if (bytes_to_skip > ppfsize)
+    bytes_to_skip = ppfsize;
+  while (patch->pos < ppfsize - bytes_to_skip)
     {
-      fread_checked2 (&pos, 4, 1, ppffile);     // Get position for modfile
-#ifdef  WORDS_BIGENDIAN
-      pos = bswap_32 (pos);
-#endif
-      n_changes = fgetc (ppffile);              // How many bytes do we have to write?
-      if (n_changes == EOF)
+      unsigned int pos, n_changes = 0;
+      const unsigned char *undo_data = NULL;
+
+      if ((ptr = patch_read (patch, offset_size + 1)) != NULL)
+        {
+          memcpy (&pos, ptr, 4);                // Get position for modfile
+          pos = le2me_32 (pos);
+          if (offset_size == 8 && (ptr[4] | ptr[5] | ptr[6] | ptr[7]))
+            {
+              fputs ("ERROR: Patching files larger than 4 GB is not supported\n", stderr);
+              return -1;
+            }
+          n_changes = ptr[offset_size];         // How many bytes do we have to write?
+          ptr = patch_read (patch, n_changes);  // And this is what we have to write
+          if (ptr && has_undo && (undo_data = patch_read (patch, n_changes)) == NULL)
+            ptr = NULL;
+        }
+      if (ptr == NULL)
         {
           fputs ("ERROR: Unexpected end of patch file\n", stderr);
-          fclose (ppffile);
-          fclose (modfile);
-
-          printf ("Removing %s\n", modname);
-          remove (modname);
           return -1;
         }
-      fread_checked (buffer, n_changes, 1, ppffile); // And this is what we have to write
-      fseek (modfile, pos, SEEK_SET);           // Go to the right position in the modfile
-      fwrite (buffer, n_changes, 1, modfile);   // Write n_changes bytes to that pos
+      if (undo)
+        {
+          // only undo a patch that has been applied to the image
+          if (pos + n_changes > patch->size || memcmp (patch->data + pos, ptr, n_changes))
+            {
+              fputs ("ERROR: This patch has not been applied to this image\n", stderr);
+              return -1;
+            }
+          patch_copy (patch, pos, undo_data, n_changes);
+        }
+      else
+        patch_copy (patch, pos, ptr, n_changes);
     }
 
-  puts ("Done");
-  fclose (ppffile);
-  fclose (modfile);
+  return 0;
+}
+
+
+int
+ppf_patch (st_patch_t *patch, const char *ppfname)
+{
+  return ppf_patch_image (patch, ppfname, 0);
+}
 
-  printf (ucon64_msg[WROTE], modname);
+
+static int
+ppf_apply_file (const char *mod, const char *ppfname, int undo)
+{
+  st_patch_t patch;
+
+  if (patch_load (&patch, ppfname) == -1)
+    exit (1);
+  if (patch_open (&patch, mod) == -1 ||
+      ppf_patch_image (&patch, ppfname, undo) == -1 ||
+      patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_close (&patch);
+
+  puts ("Done");
+  printf (ucon64_msg[WROTE], patch.fname);
   return 0;
 }
 
 
-// based on sourcecode of MakePPF v2.0 Linux/UNIX by Icarus/Paradox
 int
-ppf_create (const char *orgname, const char *modname)
+ppf_apply (const char *mod, const char *ppfname)
 {
-  FILE *orgfile, *modfile, *ppffile;
-  char ppfname[FILENAME_MAX], buffer[MAX_ID_SIZE], obuf[512], mbuf[512];
+  return ppf_apply_file (mod, ppfname, 0);
+}
+
+
+int
+ppf_undo (const char *mod, const char *ppfname)
+{
+  return ppf_apply_file (mod, ppfname, 1);
+}
+
+
+// based on sourcecode of MakePPF v2.0 Linux/UNIX by Icarus/Paradox
+static int
+ppf_make (const char *orgname, const char *modname, int ppf3)
+{
+  FILE *ppffile;
+  st_patch_diff_t diff;
+  const unsigned char *ptr;
+  unsigned char undo_zero[255];
+  char ppfname[FILENAME_MAX], buffer[MAX_ID_SIZE];
 #if 0
   char *fidname = "FILE_ID.DIZ";
 #endif
-  unsigned int x, osize, msize, blocksize, n_changes, total_changes = 0,
-               seekpos = 0, pos;
+  unsigned int x, osize, msize, n_changes, total_changes = 0, pos, len,
+               block_pos = PPF_BLOCK_BIN;
 
   osize = (unsigned int) fsizeof (orgname);
   msize = (unsigned int) fsizeof (modname);
@@ -335,16 +474,8 @@ ppf_create (const char *orgname, const char *modname)
     }
 #endif
 
-  if ((orgfile = fopen (orgname, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], orgname);
-      exit (1);
-    }
-  if ((modfile = fopen (modname, "rb")) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], modname);
-      exit (1);
-    }
+  if (patch_diff_open (&diff, orgname, modname, 0, 0) == -1)
+    exit (1);
   strcpy (ppfname, modname);
   set_suffix (ppfname, ".ppf");
   ucon64_file_handler (ppfname, NULL, 0);
@@ -354,89 +485,85 @@ ppf_create (const char *orgname, const char *modname)
       exit (1);
     }
 
-  // creating PPF 2.0 header
-  fwrite ("PPF20", 5, 1, ppffile);              // magic
-  fputc (1, ppffile);                           // encoding method
   memset (buffer, ' ', 50);
-  fwrite (buffer, 50, 1, ppffile);              // description line
-#ifdef  WORDS_BIGENDIAN
-  x = bswap_32 (osize);
-  fwrite (&x, 4, 1, ppffile);
-#else
-  fwrite (&osize, 4, 1, ppffile);               // orgfile size
-#endif
-  fseek (orgfile, 0x9320, SEEK_SET);
-  memset (buffer, 0, 1024);                     // one little hack that makes PPF
-  fread_checked2 (buffer, 1024, 1, orgfile);    //  suitable for files < 38688 bytes
-  fwrite (buffer, 1024, 1, ppffile);            // 1024 byte block
-
-  puts ("Writing patch data, please wait...");
-  // finding changes
-  fseek (orgfile, 0, SEEK_SET);
-  fseek (modfile, 0, SEEK_SET);
-  while ((blocksize = (unsigned int) fread (obuf, 1, 255, orgfile)) != 0)
+  if (ppf3)
     {
-      blocksize = (unsigned int) fread (mbuf, 1, blocksize, modfile);
-#ifdef  DIFF_FSIZE
-      if (blocksize == 0)
-        break;
-#endif
-      pos = seekpos;
-      x = 0;
-      while (x != blocksize)
+      int image_type = stricmp (get_suffix (orgname), ".gi") ?
+                         PPF3_IMAGE_BIN : PPF3_IMAGE_GI,
+          block_check;
+
+      if (image_type == PPF3_IMAGE_GI)
+        block_pos = PPF_BLOCK_GI;
+      block_check = osize >= block_pos + 1024;
+
+      // creating PPF 3.0 header
+      fwrite ("PPF30", 5, 1, ppffile);          // magic
+      fputc (2, ppffile);                       // encoding method
+      fwrite (buffer, 50, 1, ppffile);          // description line
+      fputc (image_type, ppffile);
+      fputc (block_check, ppffile);
+      fputc (1, ppffile);                       // undo data is present
+      fputc (0, ppffile);                       // unused
+      if (block_check)
         {
-          if (obuf[x] != mbuf[x])
-            {
-              pos = seekpos + x;
-              n_changes = 0;
-              do
-                {
-                  buffer[n_changes] = mbuf[x];
-                  n_changes++;
-                  x++;
-                }
-              while (x != blocksize && obuf[x] != mbuf[x]);
-              total_changes += n_changes;
-#ifdef  WORDS_BIGENDIAN
-              pos = bswap_32 (pos);
-#endif
-              fwrite (&pos, 4, 1, ppffile);
-              fputc (n_changes, ppffile);
-              fwrite (buffer, n_changes, 1, ppffile);
-            }
-          else
-            x++;
+          ucon64_fread (buffer, block_pos, 1024, orgname);
+          fwrite (buffer, 1024, 1, ppffile);    // 1024 byte block
         }
-      seekpos += blocksize;
+    }
+  else
+    {
+      // creating PPF 2.0 header
+      fwrite ("PPF20", 5, 1, ppffile);          // magic
+      fputc (1, ppffile);                       // encoding method
+      fwrite (buffer, 50, 1, ppffile);          // description line
+      x = me2le_32 (osize);
+      fwrite (&x, 4, 1, ppffile);               // orgfile size
+      memset (buffer, 0, 1024);                 // one little hack that makes PPF
+      if (osize > block_pos)                    //  suitable for files < 38688 bytes
+        ucon64_fread (buffer, block_pos, MIN (osize - block_pos, 1024), orgname);
+      fwrite (buffer, 1024, 1, ppffile);        // 1024 byte block
     }
 
-#ifdef  DIFF_FSIZE
-  if (msize > osize)
+  puts ("Writing patch data, please wait...");
+  memset (undo_zero, 0, sizeof undo_zero);
+  // finding changes; a record can hold at most 255 bytes
+  while ((ptr = patch_diff_next (&diff, &pos, &len)) != NULL)
     {
-      pos = seekpos;
-      while ((blocksize = (unsigned int) fread (buffer, 1, 255, modfile)) != 0)
+      // a range is either completely inside orgname or completely past its end
+      const unsigned char *org = pos < osize ? patch_diff_org (&diff, pos) : NULL;
+
+      total_changes += len;
+      for (; len; len -= n_changes)
         {
-          total_changes += blocksize;
-#ifdef  WORDS_BIGENDIAN
-          x = bswap_32 (pos);
+          n_changes = MIN (len, 255);
+          x = me2le_32 (pos);
           fwrite (&x, 4, 1, ppffile);
-#else
-          fwrite (&pos, 4, 1, ppffile);
-#endif
-          fputc (blocksize, ppffile);
-          fwrite (buffer, blocksize, 1, ppffile);
-          pos += blocksize;
+          if (ppf3)
+            {
+              x = 0;                            // high 32 bits of the offset
+              fwrite (&x, 4, 1, ppffile);
+            }
+          fputc (n_changes, ppffile);
+          fwrite (ptr, n_changes, 1, ppffile);
+          if (ppf3)
+            {
+              fwrite (org ? org : undo_zero, n_changes, 1, ppffile);
+              if (org)
+                org += n_changes;
+            }
+          ptr += n_changes;
+          pos += n_changes;
         }
     }
-  else if (msize < osize)
+  patch_diff_close (&diff);
+
+#ifdef  DIFF_FSIZE
+  if (msize < osize)
     printf ("WARNING: %s is smaller than %s\n"
             "         PPF cannot store information about that fact\n",
             modname, orgname);
 #endif
 
-  fclose (orgfile);
-  fclose (modfile);
-
   if (total_changes == 0)
     {
       printf ("%s and %s are identical\n"
@@ -470,6 +597,20 @@ ppf_create (const char *orgname, const char *modname)
 }
 
 
+int
+ppf_create (const char *orgname, const char *modname)
+{
+  return ppf_make (orgname, modname, 0);
+}
+
+
+int
+ppf3_create (const char *orgname, const char *modname)
+{
+  return ppf_make (orgname, modname, 1);
+}
+
+
 int
 ppf_set_desc (const char *ppf, const char *description)
 {
@@ -492,13 +633,16 @@ ppf_set_desc (const char *ppf, const char *description)
 int
 ppf_set_fid (const char *ppf, const char *fidname)
 {
-  int fidsize, ppfsize, pos;
+  int fidsize, ppfsize, pos, len_size;
+  unsigned char method = 0;
   char ppfname[FILENAME_MAX],
        fidbuf[MAX_ID_SIZE + 34 + 1] = "@BEGIN_FILE_ID.DIZ"; // +1 for string terminator
 
   strcpy (ppfname, ppf);
   ucon64_file_handler (ppfname, NULL, 0);
   fcopy (ppf, 0, fsizeof (ppf), ppfname, "wb"); // no copy if one file
+  ucon64_fread (&method, 5, 1, ppfname);
+  len_size = method == 2 ? 2 : 4;               // PPF 3.0 stores the size in 2 bytes
 
   printf ("Adding FILE_ID.DIZ (%s)...\n", fidname);
   fidsize = (int) ucon64_fread (fidbuf + 18, 0, MAX_ID_SIZE, fidname);
@@ -512,11 +656,9 @@ ppf_set_fid (const char *ppf, const char *fidname)
 
   ucon64_fwrite (fidbuf, pos, fidsize + 18 + 16, ppfname, "r+b");
   pos += fidsize + 18 + 16;
-#ifdef  WORDS_BIGENDIAN
-  fidsize = bswap_32 (fidsize);                 // Write file size in little-endian format
-#endif
-  ucon64_fwrite (&fidsize, pos, 4, ppfname, "r+b");
-  pos += 4;
+  fidsize = me2le_32 (fidsize);                 // Write file size in little-endian format
+  ucon64_fwrite (&fidsize, pos, len_size, ppfname, "r+b");
+  pos += len_size;
   if (ppfsize > pos && truncate (ppfname, pos))
     fprintf (stderr, "ERROR: Truncating \"%s\" failed", ppfname);
 
@@ -23,12 +23,16 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define PPF_H
 
 #include "misc/getopt2.h"                       // st_getopt2_t
+#include "patch/patch.h"                        // st_patch_t
 
 
 extern const st_getopt2_t ppf_usage[];
 
 extern int ppf_apply (const char *modname, const char *ppfname);
+extern int ppf_patch (st_patch_t *patch, const char *ppfname);
+extern int ppf_undo (const char *modname, const char *ppfname);
 extern int ppf_create (const char *orgname, const char *modname);
+extern int ppf3_create (const char *orgname, const char *modname);
 extern int ppf_set_desc (const char *ppfname, const char *description);
 extern int ppf_set_fid (const char *ppfname, const char *fidname);
 
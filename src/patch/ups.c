@@ -0,0 +1,291 @@
+/*
+ups.c - UPS (Universal Patching System) support for uCON64
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4668) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+#endif
+#include <stdlib.h>
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+#include <string.h>
+#include "misc/archive.h"
+#include "misc/bswap.h"
+#include "misc/chksum.h"
+#include "misc/file.h"
+#include "ucon64.h"
+#include "ucon64_misc.h"
+#include "patch/patch.h"
+#include "patch/ups.h"
+
+
+/*
+  UPS file format:
+  "UPS1"
+  number   size of the original file
+  number   size of the modified file
+  records until 12 bytes before the end of the file:
+    number   number of bytes to skip
+    bytes    XOR values for the bytes that follow, terminated by 0
+  uint32   CRC32 of the original file
+  uint32   CRC32 of the modified file
+  uint32   CRC32 of the patch file itself (excluding this field)
+  Numbers are stored in the variable-length encoding of patch_read_number().
+  The CRC32 values are little-endian. Bytes past the end of a file count as 0.
+  Because XOR is symmetric, a UPS patch can also undo itself.
+*/
+#define UPS_MAGIC "UPS1"
+#define UPS_FOOTER_LEN 12
+
+
+static st_ucon64_obj_t ups_obj[] =
+  {
+    {0, WF_STOP}
+  };
+
+const st_getopt2_t ups_usage[] =
+  {
+    {
+      "ups", 0, 0, UCON64_UPS,
+      NULL, "apply UPS PATCH to ROM (also reverts a patched ROM)",
+      &ups_obj[0]
+    },
+    {
+      "mkups", 1, 0, UCON64_MKUPS,
+      "ORG_ROM", "create UPS patch; ROM should be the modified ROM",
+      &ups_obj[0]
+    },
+    {NULL, 0, 0, 0, NULL, NULL, NULL}
+  };
+
+
+static unsigned int
+get_le32 (const unsigned char *ptr)
+{
+  unsigned int value;
+
+  memcpy (&value, ptr, 4);
+  return le2me_32 (value);
+}
+
+
+static void
+append_le32 (st_patch_t *patch, unsigned int value)
+{
+  value = me2le_32 (value);
+  patch_append (patch, &value, 4);
+}
+
+
+int
+ups_apply (const char *mod, const char *upsname)
+{
+  st_patch_t patch;
+  const unsigned char *ptr;
+  unsigned int org_size, mod_size, org_crc, mod_crc, crc, end, pos = 0;
+
+  if (patch_load (&patch, upsname) == -1)
+    exit (1);
+  if (patch.patch_size < 4 + 2 + UPS_FOOTER_LEN ||
+      memcmp (patch.patch, UPS_MAGIC, 4))
+    {
+      fprintf (stderr, "ERROR: %s is not a valid UPS file\n", upsname);
+      patch_close (&patch);
+      exit (1);
+    }
+  end = patch.patch_size - UPS_FOOTER_LEN;
+  if (crc32 (0, patch.patch, end + 8) != get_le32 (patch.patch + end + 8))
+    {
+      fprintf (stderr, "ERROR: %s is corrupt (checksum mismatch)\n", upsname);
+      patch_close (&patch);
+      exit (1);
+    }
+  org_crc = get_le32 (patch.patch + end);
+  mod_crc = get_le32 (patch.patch + end + 4);
+  patch.pos = 4;
+  if (patch_read_number (&patch, &org_size) == -1 ||
+      patch_read_number (&patch, &mod_size) == -1)
+    {
+      fputs ("ERROR: Unexpected end of patch file\n", stderr);
+      patch_close (&patch);
+      exit (1);
+    }
+
+  if (patch_open (&patch, mod) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  crc = crc32 (0, patch.data, patch.size);
+  if (patch.size != org_size || crc != org_crc)
+    {
+      if (patch.size == mod_size && crc == mod_crc)
+        {                                       // undo the patch
+          unsigned int tmp = org_size;
+          org_size = mod_size;
+          mod_size = tmp;
+          mod_crc = org_crc;
+          puts ("Image is already patched, reverting the patch");
+        }
+      else
+        {
+          fputs ("ERROR: This patch does not belong to this image\n", stderr);
+          patch_close (&patch);
+          exit (1);
+        }
+    }
+
+  puts ("Applying UPS patch...");
+  patch_resize (&patch, MAX (org_size, mod_size)); // XOR with 0 past the end
+  while (patch.pos < end)
+    {
+      unsigned int skip;
+
+      if (patch_read_number (&patch, &skip) == -1 || skip > patch.size - pos)
+        break;
+      pos += skip;
+      while ((ptr = patch_read (&patch, 1)) != NULL && patch.pos <= end)
+        {
+          if (pos < patch.size)
+            patch.data[pos] ^= *ptr;
+          pos++;
+          if (*ptr == 0)
+            break;
+        }
+      if (ptr == NULL || patch.pos > end)
+        break;
+    }
+  if (patch.pos != end)
+    {
+      fprintf (stderr, "ERROR: %s is corrupt\n", upsname);
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_resize (&patch, mod_size);
+
+  if (crc32 (0, patch.data, patch.size) != mod_crc)
+    {
+      fputs ("ERROR: The checksum of the patched image is wrong\n", stderr);
+      patch_close (&patch);
+      exit (1);
+    }
+  if (patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_close (&patch);
+
+  puts ("Patching complete\n");
+  printf (ucon64_msg[WROTE], patch.fname);
+  return 0;
+}
+
+
+int
+ups_create (const char *orgname, const char *modname)
+{
+  st_patch_t patch;
+  st_patch_diff_t diff;
+  const unsigned char *ptr;
+  unsigned int offset, len, org_size, mod_size, pos = 0, org_crc = 0,
+               mod_crc = 0, total_changes = 0;
+  int in_record = 0;
+
+  // bytes past the end of orgname are XOR'ed with 0
+  if (patch_diff_open (&diff, orgname, modname, 0, 1) == -1)
+    exit (1);
+  memset (&patch, 0, sizeof (st_patch_t));
+  strcpy (patch.fname, modname);
+  set_suffix (patch.fname, ".ups");
+  org_size = diff.org_size;
+  mod_size = diff.mod_size;
+
+  ucon64_chksum (NULL, NULL, NULL, &org_crc, orgname, org_size, 0,
+                 ucon64_settings.chksum_flags);
+  ucon64_chksum (NULL, NULL, NULL, &mod_crc, modname, mod_size, 0,
+                 ucon64_settings.chksum_flags);
+
+  patch_append (&patch, UPS_MAGIC, 4);
+  patch_append_number (&patch, org_size);
+  patch_append_number (&patch, mod_size);
+
+  puts ("Writing patch data, please wait...");
+  while ((ptr = patch_diff_next (&diff, &offset, &len)) != NULL)
+    {
+      const unsigned char *org = patch_diff_org (&diff, offset);
+      unsigned char buffer[1024];
+      unsigned int i;
+
+      if (!in_record || offset != pos)
+        {
+          if (in_record)
+            {
+              patch_append (&patch, "", 1);     // terminate the previous record
+              pos++;
+            }
+          patch_append_number (&patch, offset - pos);
+          pos = offset;
+          in_record = 1;
+        }
+      total_changes += len;
+      pos += len;
+      while (len)
+        {
+          unsigned int n = MIN (len, sizeof buffer);
+
+          for (i = 0; i < n; i++)
+            buffer[i] = ptr[i] ^ org[i];
+          patch_append (&patch, buffer, n);
+          ptr += n;
+          org += n;
+          len -= n;
+        }
+    }
+  if (in_record)
+    patch_append (&patch, "", 1);
+  patch_diff_close (&diff);
+
+  if (total_changes == 0 && org_size == mod_size)
+    {
+      printf ("%s and %s are identical\n", orgname, modname);
+      patch_close (&patch);
+      return -1;
+    }
+
+  append_le32 (&patch, org_crc);
+  append_le32 (&patch, mod_crc);
+  append_le32 (&patch, crc32 (0, patch.data, patch.size));
+
+  ucon64_file_handler (patch.fname, NULL, 0);
+  if (patch_write (&patch) == -1)
+    {
+      patch_close (&patch);
+      exit (1);
+    }
+  patch_close (&patch);
+
+  printf (ucon64_msg[WROTE], patch.fname);
+  return 0;
+}
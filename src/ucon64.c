@@ -46,6 +46,11 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifdef  HAVE_SCHED_SETSCHEDULER
 #include <sched.h>
 #endif
+#ifdef  HAVE_FORK
+#include <limits.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
 #ifdef  _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
@@ -78,10 +83,12 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #endif
 #endif
 #include "misc/archive.h"
+#include "misc/chksum.h"
 #include "misc/file.h"
 #include "misc/misc.h"
 #include "misc/property.h"
 #include "misc/term.h"
+#include "ucon64_cache.h"
 #include "ucon64_dat.h"
 #include "ucon64_misc.h"
 #include "ucon64_opts.h"
@@ -130,22 +137,35 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "backup/swc.h"
 #include "backup/ufosd.h"
 #include "patch/aps.h"
+#include "patch/bps.h"
 #include "patch/bsl.h"
 #include "patch/gg.h"
 #include "patch/ips.h"
 #include "patch/patch.h"
+#include "patch/pcat.h"
 #include "patch/ppf.h"
+#include "patch/ups.h"
 
 
 static void ucon64_exit (void);
 static int ucon64_execute_options (void);
-static void ucon64_rom_nfo (const st_ucon64_nfo_t *nfo);
-static st_ucon64_nfo_t *ucon64_probe (st_ucon64_nfo_t *nfo);
-static int ucon64_rom_handling (void);
-static int ucon64_process_rom (const char *fname);
+static void ucon64_rom_nfo (st_ucon64_t *p, const st_ucon64_nfo_t *nfo);
+static st_ucon64_nfo_t *ucon64_probe (st_ucon64_t *p, st_ucon64_nfo_t *nfo);
+static int ucon64_rom_handling (st_ucon64_t *p);
+static int ucon64_rom_handling_file (st_ucon64_t *p);
+static int ucon64_process_rom (const char *fname,
+                               const st_getopt2_stat_t *fstate);
+static void ucon64_scan_cache_open (void);
+#ifdef  HAVE_FORK
+static int ucon64_jobs_possible (void);
+static int ucon64_jobs_add_rom (const char *fname,
+                                const st_getopt2_stat_t *fstate);
+static void ucon64_jobs_process_roms (void);
+#endif
 
 
 st_ucon64_t ucon64;                             // contains ptr to image, dat and nfo
+st_ucon64_settings_t ucon64_settings;
 
 #ifdef  AMIGA
 unsigned long __stacksize = 102400;             // doesn't work on PPC? is StormC specific?
@@ -169,6 +189,7 @@ typedef struct
 #endif
 
 static st_args_t arg[UCON64_MAX_ARGS];
+static int first_file = 1;                      // no file has been processed yet
 
 static st_getopt2_t options[UCON64_MAX_ARGS];
 static const st_getopt2_t lf[] =
@@ -189,7 +210,10 @@ static const st_getopt2_t lf[] =
     ips_usage,
     aps_usage,
     ppf_usage,
+    bps_usage,
+    ups_usage,
     gg_usage,
+    pcat_usage,
     lf,
 #ifdef  USE_DISCMAGE
     discmage_usage,
@@ -320,6 +344,138 @@ typedef struct
 } st_ucon64_test_t;
 
 
+static void
+ucon64_test_context (st_ucon64_t *p, const char *fname)
+{
+  // the members that ucon64_execute_options() resets for every file
+  p->fname = fname;
+  p->dat = NULL;
+  p->nfo = NULL;
+  p->fsize = 0;
+  p->crc32 = p->fcrc32 = 0;
+  p->console = UCON64_UNKNOWN;
+  p->split = UCON64_UNKNOWN;
+}
+
+
+static int
+ucon64_test_write_snes (const char *fname, unsigned int hirom, const char *name)
+{
+  unsigned int size = 4 * MBIT, header = SNES_HEADER_START + hirom, sum = 0, x;
+  unsigned char *buffer = (unsigned char *) malloc (size);
+  FILE *file;
+
+  if (!buffer)
+    return -1;
+  for (x = 0; x < size; x++)
+    buffer[x] = (unsigned char) (x * 7 + (x >> 8) + (hirom ? 13 : 0));
+  memcpy (buffer + header, "01", 2);            // maker code
+  memset (buffer + header + 16, ' ', 21);
+  memcpy (buffer + header + 16, name, strlen (name));
+  buffer[header + 37] = hirom ? 0x21 : 0x20;    // map type
+  buffer[header + 38] = 0;                      // ROM type
+  buffer[header + 39] = 9;                      // ROM size (4 Mbit)
+  buffer[header + 40] = 0;                      // SRAM size
+  buffer[header + 41] = 1;                      // country
+  buffer[header + 42] = 1;                      // maker
+  buffer[header + 43] = 0;                      // version
+  buffer[header + 44] = buffer[header + 45] = 0xff; // inverse checksum
+  buffer[header + 46] = buffer[header + 47] = 0; // checksum
+  buffer[header + 0x4c] = 0;                    // reset vector (0x8000)
+  buffer[header + 0x4d] = 0x80;
+  for (x = 0; x < size; x++)
+    sum += buffer[x];
+  buffer[header + 44] = (unsigned char) ~sum;
+  buffer[header + 45] = (unsigned char) (~sum >> 8);
+  buffer[header + 46] = (unsigned char) sum;
+  buffer[header + 47] = (unsigned char) (sum >> 8);
+
+  if ((file = fopen (fname, "wb")) == NULL)
+    {
+      free (buffer);
+      return -1;
+    }
+  x = (unsigned int) fwrite (buffer, 1, size, file);
+  fclose (file);
+  free (buffer);
+  return x == size ? 0 : -1;
+}
+
+
+/*
+  Probe a LoROM and a HiROM SNES ROM through two contexts alternately. Every
+  context has its own console state, so probing the ROM of one context must
+  not change what was found for the other.
+*/
+static void
+ucon64_test_contexts (void)
+{
+  static const struct
+  {
+    const char *fname;
+    const char *name;
+    unsigned int hirom;
+  } roms[2] =
+    {
+      {"/tmp/ucon64_test_lorom.sfc", "UCON64 TEST LOROM", 0},
+      {"/tmp/ucon64_test_hirom.sfc", "UCON64 TEST HIROM", SNES_HIROM}
+    };
+  static const int order[] = { 0, 1, 0, 1, 1, 0 };
+  st_ucon64_t ctx[2];
+  uint32_t crc[2] = { 0, 0 };
+  int n, x, errors = 0;
+
+  for (x = 0; x < 2; x++)
+    {
+      if (ucon64_test_write_snes (roms[x].fname, roms[x].hirom, roms[x].name))
+        {
+          fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], roms[x].fname);
+          return;
+        }
+      memset (&ctx[x], 0, sizeof (st_ucon64_t));
+      ctx[x].settings = &ucon64_settings;
+      ctx[x].file = ctx[x].mapr = ctx[x].comment = "";
+      ctx[x].backup_header_len = ctx[x].battery = ctx[x].bs_dump =
+        ctx[x].controller = ctx[x].controller2 = ctx[x].do_not_calc_crc =
+        ctx[x].id = ctx[x].interleaved = ctx[x].mirror = ctx[x].org_console =
+        ctx[x].org_split = ctx[x].part_size = ctx[x].range_start =
+        ctx[x].region = ctx[x].snes_header_base = ctx[x].snes_hirom =
+        ctx[x].tv_standard = ctx[x].use_dump_info = ctx[x].vram =
+        UCON64_UNKNOWN;
+      ctx[x].range_length = (size_t) UCON64_UNKNOWN;
+      ctx[x].flags = WF_INIT | WF_PROBE;
+    }
+
+  for (n = 0; n < (int) (sizeof order / sizeof order[0]); n++)
+    {
+      st_ucon64_t *p = &ctx[order[n]];
+
+      ucon64_test_context (p, roms[order[n]].fname);
+      if (ucon64_rom_handling (p) < 0)
+        errors++;
+      if (!crc[order[n]])
+        crc[order[n]] = p->crc32;
+
+      // check both contexts, the one that was not used must be unchanged
+      for (x = 0; x <= n && x < 2; x++)
+        if (ctx[x].console != UCON64_SNES || !ctx[x].nfo ||
+            strncmp (ctx[x].nfo->name, roms[x].name, strlen (roms[x].name)) ||
+            snes_get_snes_hirom (&ctx[x]) != roms[x].hirom ||
+            ctx[x].crc32 != crc[x])
+          errors++;
+    }
+
+  printf ("%-16s %s (0x%08x, 0x%08x)\n", "contexts", errors ? "MISMATCH" : "OK",
+          crc[0], crc[1]);
+
+  for (x = 0; x < 2; x++)
+    {
+      ucon64_console_data_free (&ctx[x]);
+      remove (roms[x].fname);
+    }
+}
+
+
 void
 ucon64_test (void)
 {
@@ -351,6 +507,7 @@ ucon64_test (void)
       {UCON64_BOT,	"ucon64 -bot=test.bot /tmp/test/test.v64;"
                         "ucon64 -crc test.bot;"
                         "rm test.bot", 1},
+      {UCON64_BPS,	"ucon64 -bps", TEST_TODO},
       {UCON64_BS,	"ucon64 -bs /tmp/test/test.smc", 0x18910ac6},
       {UCON64_C,	"ucon64 -c /tmp/test/test.txt /tmp/test/12345678.abc", 0x2284888d},
 #if 0
@@ -394,6 +551,7 @@ ucon64_test (void)
       {UCON64_FIND,	"ucon64 -find \"abcd\" /tmp/test/test.txt", 0xd7aed3fd},
       {UCON64_FINDI,	"ucon64 -findi \"ABcD\" /tmp/test/test.txt", 0x10e913cd},
       {UCON64_FINDR,	"ucon64 -findr \"1234\" /tmp/test/test.txt", 0x1b1284d8},
+      {UCON64_FINDRL,	"ucon64 -findrl list.txt /tmp/test/test.txt", TEST_TODO},
       {UCON64_GB,	"ucon64 -gb /tmp/test/test.1mb", 0xf050caa1},
       {UCON64_GBA,	"ucon64 -gba /tmp/test/test.1mb", 0x5253861d},
       {UCON64_GBX,	"ucon64 -gbx", TEST_TODO},
@@ -445,18 +603,22 @@ ucon64_test (void)
       {UCON64_MGH,	"ucon64 -mgh", TEST_TODO},
       {UCON64_MIRR,	"ucon64 -mirr", TEST_TODO},
       {UCON64_MKA,	"ucon64 -mka", TEST_TODO},
+      {UCON64_MKBPS,	"ucon64 -mkbps", TEST_TODO},
       {UCON64_MKDAT,	"ucon64 -mkdat", TEST_TODO},
       {UCON64_MKI,	"ucon64 -mki=/tmp/test/test.txt /tmp/test/test2.txt;"
                         "ucon64 -crc test2.ips;"
                         "rm test2.ips", 0xe2b26d35},
       {UCON64_MKIP,	"ucon64 -mkip", TEST_TODO},
       {UCON64_MKPPF,	"ucon64 -mkppf", TEST_TODO},
+      {UCON64_MKPPF3,	"ucon64 -mkppf3", TEST_TODO},
+      {UCON64_MKUPS,	"ucon64 -mkups", TEST_TODO},
       {UCON64_MSG,	"ucon64 -msg", TEST_TODO},
       {UCON64_MULTI,	"ucon64 -multi", TEST_TODO},
       {UCON64_N,	"ucon64 -n", TEST_TODO},
       {UCON64_N2,	"ucon64 -n2", TEST_TODO},
       {UCON64_N2GB,	"ucon64 -n2gb", TEST_TODO},
       {UCON64_N64,	"ucon64 -n64 /tmp/test/test.1mb", 0x5eedaf08},
+      {UCON64_N64LE,	"ucon64 -n64le", TEST_TODO},
       {UCON64_NA,	"ucon64 -na", TEST_TODO},
       {UCON64_NBAT,	"ucon64 -nbat", TEST_TODO},
       {UCON64_NBS,	"ucon64 -nbs", TEST_TODO},
@@ -480,7 +642,10 @@ ucon64_test (void)
       {UCON64_PARSE,	"ucon64 -parse", TEST_TODO},
       {UCON64_PASOFAMI,	"ucon64 -pasofami", TEST_TODO},
       {UCON64_PATCH,	"ucon64 -patch", TEST_TODO},
+      {UCON64_PATCH_CHAIN,	"ucon64 -patch-chain", TEST_TODO},
       {UCON64_PATTERN,	"ucon64 -pattern", TEST_TODO},
+      {UCON64_PCAT,	"ucon64 -pcat", TEST_TODO},
+      {UCON64_PCATADD,	"ucon64 -pcatadd", TEST_TODO},
       {UCON64_PCE,	"ucon64 -pce", TEST_TODO},
       {UCON64_POKE,	"ucon64 -poke", TEST_TODO},
       {UCON64_PPF,	"ucon64 -ppf", TEST_TODO},
@@ -513,6 +678,7 @@ ucon64_test (void)
       {UCON64_SCR,	"ucon64 -scr", TEST_TODO},
       {UCON64_SGB,	"ucon64 -sgb", TEST_TODO},
       {UCON64_SHA1,	"ucon64 -sha1 /tmp/test/test.txt", 0x65608105},
+      {UCON64_SHA256,	"ucon64 -sha256 /tmp/test/test.txt", TEST_TODO},
       {UCON64_SMC,	"ucon64 -smc", TEST_TODO},
       {UCON64_SMD,	"ucon64 -smd", TEST_TODO},
       {UCON64_SMDS,	"ucon64 -smds", TEST_TODO},
@@ -551,6 +717,8 @@ ucon64_test (void)
       {UCON64_UFOSDS,	"ucon64 -ufosds", TEST_TODO},
       {UCON64_UNIF,	"ucon64 -unif /tmp/test/test.nes", TEST_BUG},
       {UCON64_UNSCR,	"ucon64 -unscr", TEST_TODO},
+      {UCON64_UPPF,	"ucon64 -uppf", TEST_TODO},
+      {UCON64_UPS,	"ucon64 -ups", TEST_TODO},
       {UCON64_USMS,	"ucon64 -usms", TEST_TODO},
       {UCON64_V64,	"ucon64 -v64 /tmp/test/test.z64;"
                         "ucon64 test.v64;"
@@ -566,6 +734,8 @@ TEST_BREAK
       {UCON64_Q,	"ucon64 -q", 0},        // NO TEST: quiet switch
       {UCON64_HELP,	"ucon64 -help", 0},     // NO TEST: usage changes always
       {UCON64_R,	"ucon64 -r", 0},        // NO TEST: recursion
+      {UCON64_JOBS,	"ucon64 -jobs", 0},     // NO TEST: parallel processing
+      {UCON64_RESCAN,	"ucon64 -rescan", 0},   // NO TEST: scan cache
       {UCON64_O,        "ucon64 -o", 0},        // NO TEST: output
       {UCON64_NBAK,	"ucon64 -nbak", 0},     // NO TEST: no backup
 
@@ -880,11 +1050,19 @@ static void
 ucon64_exit (void)
 {
 #ifdef  USE_DISCMAGE
-  if (ucon64.discmage_enabled && ucon64.image)
+  if (ucon64_settings.discmage_enabled && ucon64.image)
     dm_close ((dm_image_t *) ucon64.image);
 #endif
 
   handle_registered_funcs ();
+#if     defined DEBUG && defined USE_ZLIB
+  archive_cache_stats (stderr);
+#endif
+#ifdef  USE_ZLIB
+  archive_cache_flush ();
+#endif
+  ucon64_cache_close ();
+  ucon64_console_data_free (&ucon64);
   fflush (stdout);
 }
 
@@ -899,7 +1077,14 @@ main (int argc, char **argv)
 
 #ifdef  TEST
   if (argc == 1)
-    ucon64_test ();
+    {
+#ifndef USE_ZLIB
+      crc32_benchmark ();
+#endif
+      xform_benchmark ();
+      ucon64_test_contexts ();
+      ucon64_test ();
+    }
 #else
   puts ("uCON64 " UCON64_VERSION_S " " CURRENT_OS_S " 1999-2021\n"
         "Uses code from various people. See 'developers.html' for more!\n"
@@ -916,8 +1101,10 @@ main (int argc, char **argv)
       exit (1);
     }
 
-  // flush st_ucon64_t
+  // flush st_ucon64_t and st_ucon64_settings_t
   memset (&ucon64, 0, sizeof (st_ucon64_t));
+  memset (&ucon64_settings, 0, sizeof (st_ucon64_settings_t));
+  ucon64.settings = &ucon64_settings;
 
   // these members of ucon64 (except fname and fname_arch) don't change per file
   ucon64.argc = argc;
@@ -930,8 +1117,10 @@ main (int argc, char **argv)
 
   ucon64.fname_arch[0] = '\0';
 
-  ucon64.recursive =
-  ucon64.parport_needed =
+  ucon64_settings.recursive =
+  ucon64_settings.jobs =
+  ucon64_settings.rescan =
+  ucon64_settings.parport_needed =
   ucon64.io_mode = 0;
 
   ucon64.backup_header_len =
@@ -979,24 +1168,24 @@ main (int argc, char **argv)
 #endif
 
   // configfile handling
-  realpath2 (PROPERTY_HOME_RC ("ucon64"), ucon64.configfile);
+  realpath2 (PROPERTY_HOME_RC ("ucon64"), ucon64_settings.configfile);
 
   {
     char org_configfile[FILENAME_MAX];
-    size_t len = strnlen (ucon64.configfile, sizeof org_configfile - 1);
+    size_t len = strnlen (ucon64_settings.configfile, sizeof org_configfile - 1);
     int result = 0;
 
 #if     defined __GNUC__ && __GNUC__ >= 8
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstringop-truncation"
 #endif
-    strncpy (org_configfile, ucon64.configfile, len)[len] = '\0';
+    strncpy (org_configfile, ucon64_settings.configfile, len)[len] = '\0';
 #if     defined __GNUC__ && __GNUC__ >= 8
 #pragma GCC diagnostic pop
 #endif
     result = property_check (org_configfile, UCON64_CONFIG_VERSION, 1);
     if (result == 1)                            // update needed
-      result = ucon64_set_property_array (strcmp (ucon64.configfile, org_configfile) ?
+      result = ucon64_set_property_array (strcmp (ucon64_settings.configfile, org_configfile) ?
                                             org_configfile : "");
     if (result == -1)                           // property_check() or update failed
       return -1;
@@ -1004,14 +1193,14 @@ main (int argc, char **argv)
 
 #ifdef  USE_ANSI_COLOR
   // ANSI colors?
-  ucon64.ansi_color = get_property_int (ucon64.configfile, "ansi_color");
+  ucon64_settings.ansi_color = get_property_int (ucon64_settings.configfile, "ansi_color");
   // the conditional call to ansi_init() has to be done *after* the check for
   //  the switch --ncol
 #endif
 
   // parallel port?
 #if     defined USE_PPDEV || defined AMIGA
-  p = get_property (ucon64.configfile, "parport_dev", PROPERTY_MODE_FILENAME);
+  p = get_property (ucon64_settings.configfile, "parport_dev", PROPERTY_MODE_FILENAME);
   if (!p)
 #ifdef  USE_PPDEV
     p = "/dev/parport0";
@@ -1019,76 +1208,76 @@ main (int argc, char **argv)
     p = "parallel.device";
 #endif
   {
-    size_t len = strnlen (p, sizeof ucon64.parport_dev - 1);
+    size_t len = strnlen (p, sizeof ucon64_settings.parport_dev - 1);
 
-    strncpy (ucon64.parport_dev, p, len)[len] = '\0';
+    strncpy (ucon64_settings.parport_dev, p, len)[len] = '\0';
   }
 #endif
 
-  p = get_property (ucon64.configfile, "parport", PROPERTY_MODE_TEXT);
+  p = get_property (ucon64_settings.configfile, "parport", PROPERTY_MODE_TEXT);
   if (p)
-    sscanf (p, "%hx", &ucon64.parport);
+    sscanf (p, "%hx", &ucon64_settings.parport);
   else
     // use PARPORT_UNKNOWN (UCON64_UNKNOWN) to force probing if the config file
     //  doesn't contain a parport line
-    ucon64.parport = (uint16_t) UCON64_UNKNOWN; // PARPORT_UNKNOWN depends on USE_PARALLEL
+    ucon64_settings.parport = (uint16_t) UCON64_UNKNOWN; // PARPORT_UNKNOWN depends on USE_PARALLEL
 
   // Make backups?
-  ucon64.backup = get_property_int (ucon64.configfile, "backups");
+  ucon64_settings.backup = get_property_int (ucon64_settings.configfile, "backups");
 
   // $HOME/.ucon64/ ?
-  p = get_property (ucon64.configfile, "ucon64_configdir", PROPERTY_MODE_FILENAME);
+  p = get_property (ucon64_settings.configfile, "ucon64_configdir", PROPERTY_MODE_FILENAME);
   if (p)
     {
-      size_t len = strnlen (p, sizeof ucon64.configdir - 1);
+      size_t len = strnlen (p, sizeof ucon64_settings.configdir - 1);
 
-      strncpy (ucon64.configdir, p, len)[len] = '\0';
+      strncpy (ucon64_settings.configdir, p, len)[len] = '\0';
     }
   else
-    *ucon64.configdir = '\0';
+    *ucon64_settings.configdir = '\0';
 
   // DAT file handling
-  ucon64.dat_enabled = 0;
-  p = get_property (ucon64.configfile, "ucon64_datdir", PROPERTY_MODE_FILENAME);
+  ucon64_settings.dat_enabled = 0;
+  p = get_property (ucon64_settings.configfile, "ucon64_datdir", PROPERTY_MODE_FILENAME);
   if (p)
     {
-      size_t len = strnlen (p, sizeof ucon64.datdir - 1);
+      size_t len = strnlen (p, sizeof ucon64_settings.datdir - 1);
 
-      strncpy (ucon64.datdir, p, len)[len] = '\0';
+      strncpy (ucon64_settings.datdir, p, len)[len] = '\0';
     }
   else
-    *ucon64.datdir = '\0';
+    *ucon64_settings.datdir = '\0';
 
-  // we use ucon64.datdir as path to the DAT files
-  if (!access (ucon64.datdir,
+  // we use ucon64_settings.datdir as path to the DAT files
+  if (!access (ucon64_settings.datdir,
   // !W_OK doesn't mean that files can't be written to dir for Win32 exe's
 #if     !defined __CYGWIN__ && !defined _WIN32
                               W_OK |
 #endif
                               R_OK | X_OK) &&
-      !stat (ucon64.datdir, &fstate) && S_ISDIR (fstate.st_mode))
-    ucon64.dat_enabled = 1;
+      !stat (ucon64_settings.datdir, &fstate) && S_ISDIR (fstate.st_mode))
+    ucon64_settings.dat_enabled = 1;
 
-  if (!ucon64.dat_enabled && !access (ucon64.configdir,
+  if (!ucon64_settings.dat_enabled && !access (ucon64_settings.configdir,
 #if     !defined __CYGWIN__ && !defined _WIN32
                                                         W_OK |
 #endif
                                                         R_OK | X_OK) &&
-      !stat (ucon64.configdir, &fstate) && S_ISDIR (fstate.st_mode))
+      !stat (ucon64_settings.configdir, &fstate) && S_ISDIR (fstate.st_mode))
     {
 //      fprintf (stderr, "Please move your DAT files from %s to %s\n",
-//               ucon64.configdir, ucon64.datdir);
-      strcpy (ucon64.datdir, ucon64.configdir); // use .ucon64/ instead of .ucon64/dat/
-      ucon64.dat_enabled = 1;
+//               ucon64_settings.configdir, ucon64_settings.datdir);
+      strcpy (ucon64_settings.datdir, ucon64_settings.configdir); // use .ucon64/ instead of .ucon64/dat/
+      ucon64_settings.dat_enabled = 1;
     }
 
   // Calculate CRC32 value of N64 ROM in Doctor V64 or Mr. Backup Z64 format?
-  ucon64.n64_dat_v64 = get_property_int (ucon64.configfile, "n64_dat_v64");
+  ucon64_settings.n64_dat_v64 = get_property_int (ucon64_settings.configfile, "n64_dat_v64");
 
 #ifdef  USE_DISCMAGE
   // load libdiscmage (should be done before handling the switches (--ver), but
   //  ucon64_usage() has a dependency as well)
-  ucon64.discmage_enabled = ucon64_load_discmage ();
+  ucon64_settings.discmage_enabled = ucon64_load_discmage ();
 #endif
 
   if (argc < 2)
@@ -1147,7 +1336,7 @@ main (int argc, char **argv)
 
   // switches
 #ifdef  USE_PARALLEL
-  ucon64.parport_mode = UCON64_UNKNOWN;
+  ucon64_settings.parport_mode = UCON64_UNKNOWN;
 #endif
   for (x = 0; arg[x].val; x++)
     {
@@ -1161,11 +1350,28 @@ main (int argc, char **argv)
 
 //      if (ucon64.flags & WF_SWITCH)
         ucon64_switches (&ucon64);
+
+      switch (arg[x].val)
+        {
+        case UCON64_CRC:
+        case UCON64_CRCHD:
+          ucon64_settings.chksum_flags |= CHKSUM_CRC32;
+          break;
+        case UCON64_MD5:
+          ucon64_settings.chksum_flags |= CHKSUM_MD5;
+          break;
+        case UCON64_SHA1:
+          ucon64_settings.chksum_flags |= CHKSUM_SHA1;
+          break;
+        case UCON64_SHA256:
+          ucon64_settings.chksum_flags |= CHKSUM_SHA256;
+          break;
+        }
     }
 
 #ifdef  USE_ANSI_COLOR
-  if (ucon64.ansi_color)
-    ucon64.ansi_color = ansi_init ();
+  if (ucon64_settings.ansi_color)
+    ucon64_settings.ansi_color = ansi_init ();
 #endif
 
   /*
@@ -1173,11 +1379,13 @@ main (int argc, char **argv)
     ansi_init() so that the progress bar is displayed correctly (color/no
     color).
   */
-  if (ucon64.dat_enabled)
+  if (ucon64_settings.dat_enabled)
     ucon64_dat_indexer ();              // update cache (index) files if necessary
 
+  ucon64_scan_cache_open ();
+
 #if     defined HAVE_SCHED_SETSCHEDULER || defined _WIN32
-  if (get_property_int (ucon64.configfile, "gd6_send_byte_delay"))
+  if (get_property_int (ucon64_settings.configfile, "gd6_send_byte_delay"))
     {
       // Cygwin has sched_setscheduler() but it fails for SCHED_FIFO, even when
       //  running as Administrator.
@@ -1234,18 +1442,18 @@ main (int argc, char **argv)
     ucon64.flags & WF_PAR to detect whether a (parallel port) copier option has
     been specified, because another switch might've been specified after -port.
   */
-  if (ucon64.parport_needed == 1)
+  if (ucon64_settings.parport_needed == 1)
     {
 #if     defined __unix__ && !(defined __MSDOS__ || defined __CYGWIN__ || defined USE_PPDEV)
       regain_privileges ();
 #endif
-      ucon64.parport = parport_open (ucon64.parport);
+      ucon64_settings.parport = parport_open (ucon64_settings.parport);
       if (register_func (parport_close) == -1)
         {
           fputs ("ERROR: Could not register function with register_func()\n", stderr);
           exit (1);
         }
-      ucon64.parport_mode = parport_setup (ucon64.parport, ucon64.parport_mode);
+      ucon64_settings.parport_mode = parport_setup (ucon64_settings.parport, ucon64_settings.parport_mode);
     }
 #endif // USE_PARALLEL
 #if     defined __unix__ && !defined __MSDOS__
@@ -1259,9 +1467,9 @@ main (int argc, char **argv)
     to run uCON64 as root (not setuid root), but we want to be user friendly.
     Besides, doing things as root is bad anyway (from a security viewpoint).
   */
-  if (ucon64.parport_needed == 2
+  if (ucon64_settings.parport_needed == 2
 #ifdef  USE_USB
-      || ucon64.usbport
+      || ucon64_settings.usbport
 #endif
      )
     drop_privileges_temp ();
@@ -1275,7 +1483,7 @@ main (int argc, char **argv)
     {
       int flags = GETOPT2_FILE_FILES_ONLY;
 
-      if (ucon64.recursive)
+      if (ucon64_settings.recursive)
         flags |= GETOPT2_FILE_RECURSIVE;
       else
         {
@@ -1311,7 +1519,15 @@ main (int argc, char **argv)
                 }
             }
         }
-      getopt2_file (argc, argv, ucon64_process_rom, flags);
+#ifdef  HAVE_FORK
+      if (ucon64_settings.jobs > 1 && ucon64_jobs_possible ())
+        {
+          getopt2_file (argc, argv, ucon64_jobs_add_rom, flags);
+          ucon64_jobs_process_roms ();
+        }
+      else
+#endif
+        getopt2_file (argc, argv, ucon64_process_rom, flags);
     }
 
   return 0;
@@ -1319,27 +1535,20 @@ main (int argc, char **argv)
 
 
 static int
-ucon64_process_rom (const char *fname)
+ucon64_process_rom (const char *fname, const st_getopt2_stat_t *fstate)
 {
+  int result = 0;
 #ifdef  USE_ZLIB
   ZPOS64_T n_entries;
 #endif
 
-  // Try to get file status information only if the file exists. We have to
-  //  accept non-existing files for the dump options.
-  if (access (fname, F_OK) == 0)
-    {
-#ifdef  _WIN32
-      struct _stati64 fstate;
-      if (_stati64 (fname, &fstate))
-#else
-      struct stat fstate;
-      if (stat (fname, &fstate))
-#endif
-        return 0;
-      if (!S_ISREG (fstate.st_mode))
-        return 0;
-    }
+  // fstate is NULL if the file does not exist. We have to accept non-existing
+  //  files for the dump options.
+  if (fstate && !S_ISREG (fstate->st_mode))
+    return 0;
+  // ucon64_rom_handling() doesn't have to get the status of the file again
+  ucon64.fstate_fname = fname;
+  ucon64.fstate = fstate;
 
 #ifdef  USE_ZLIB
   n_entries = unzip_get_number_entries (fname);
@@ -1371,7 +1580,7 @@ ucon64_process_rom (const char *fname)
       ucon64.fname_arch[0] = '\0';
 
       if (ucon64.flags & WF_STOP)
-        return 1;
+        result = 1;
     }
   else
 #endif
@@ -1380,13 +1589,281 @@ ucon64_process_rom (const char *fname)
 
       ucon64_execute_options ();
       if (ucon64.flags & WF_STOP)
-        return 1;
+        result = 1;
+    }
+
+  ucon64.fstate = NULL;
+  return result;
+}
+
+
+static void
+ucon64_scan_cache_open (void)
+/*
+  Serve the scan results of unchanged files from the cache in the config
+  directory. Only options that don't modify files are supported, because the
+  cache is keyed by the identity of the file. The settings hash must cover
+  everything that changes the scan result besides the file itself.
+*/
+{
+  char fname[FILENAME_MAX];
+  uint32_t settings;
+  int x, values[4];
+
+  if (!ucon64_settings.configdir[0])
+    return;
+  for (x = 0; arg[x].val; x++)
+    if (!(arg[x].flags & WF_SWITCH) &&
+        arg[x].val != UCON64_LS && arg[x].val != UCON64_LSV &&
+        arg[x].val != UCON64_LSD && arg[x].val != UCON64_SCAN &&
+        arg[x].val != UCON64_RDAT && arg[x].val != UCON64_RROM)
+      return;
+
+  settings = crc32 (0, (const unsigned char *) UCON64_VERSION_S,
+                    sizeof UCON64_VERSION_S);
+  for (x = 0; arg[x].val; x++)
+    if ((arg[x].flags & WF_SWITCH) && arg[x].val != UCON64_RESCAN &&
+        arg[x].val != UCON64_JOBS && arg[x].val != UCON64_R &&
+        arg[x].val != UCON64_O)
+      {
+        settings = crc32 (settings, (const unsigned char *) &arg[x].val,
+                          sizeof arg[x].val);
+        if (arg[x].optarg)
+          settings = crc32 (settings, (const unsigned char *) arg[x].optarg,
+                            (unsigned int) strlen (arg[x].optarg) + 1);
+      }
+  values[0] = ucon64_settings.n64_dat_v64;
+  values[1] = ucon64_settings.quiet;
+  values[2] = ucon64.do_not_calc_crc;
+#ifdef  USE_ANSI_COLOR
+  values[3] = ucon64_settings.ansi_color;
+#else
+  values[3] = 0;
+#endif
+  settings = crc32 (settings, (const unsigned char *) values, sizeof values);
+
+  snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "scan.cache",
+            ucon64_settings.configdir);
+  fname[FILENAME_MAX - 1] = '\0';
+  ucon64_cache_open (fname, settings, ucon64_settings.rescan);
+}
+
+
+#ifdef  HAVE_FORK
+/*
+  --jobs: file n is processed by worker process n % n_workers. Every worker has
+  its own copy of ucon64 and writes the output of its files to a temporary
+  file. After each file it sends the end position of that output to the parent
+  through a pipe. The parent copies the output of the files to stdout in the
+  order in which they were specified, so that the result is the same as
+  without --jobs. Only options that don't modify files and don't depend on the
+  files before the current one can be used.
+*/
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  pid_t pid;
+  int control;                                  // read end of pipe with output positions
+  FILE *output;                                 // read handle of temporary file
+  long pos;                                     // output copied so far
+} st_ucon64_worker_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+static char **jobs_fnames = NULL;
+static st_getopt2_stat_t *jobs_fstates = NULL;  // st_mode == 0 => no file
+#define JOBS_FSTATE(n) (jobs_fstates[n].st_mode ? &jobs_fstates[n] : NULL)
+static int jobs_n_fnames = 0, jobs_max_fnames = 0;
+
+
+static int
+ucon64_jobs_possible (void)
+{
+  int x;
+
+  for (x = 0; arg[x].val; x++)
+    if (!(arg[x].flags & WF_SWITCH) &&
+        arg[x].val != UCON64_LS && arg[x].val != UCON64_LSV &&
+        arg[x].val != UCON64_LSD && arg[x].val != UCON64_CRC &&
+        arg[x].val != UCON64_CRCHD && arg[x].val != UCON64_MD5 &&
+        arg[x].val != UCON64_SHA1 && arg[x].val != UCON64_SHA256)
+      return 0;
+  return 1;
+}
+
+
+static int
+ucon64_jobs_add_rom (const char *fname, const st_getopt2_stat_t *fstate)
+{
+  if (jobs_n_fnames == jobs_max_fnames)
+    {
+      char **p = (char **) realloc (jobs_fnames, (jobs_max_fnames + 1024) *
+                                                   sizeof (char *));
+      st_getopt2_stat_t *q;
+
+      if (!p)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                   (jobs_max_fnames + 1024) * sizeof (char *));
+          exit (1);
+        }
+      jobs_fnames = p;
+      if ((q = (st_getopt2_stat_t *)
+             realloc (jobs_fstates, (jobs_max_fnames + 1024) *
+                                      sizeof (st_getopt2_stat_t))) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                   (jobs_max_fnames + 1024) * sizeof (st_getopt2_stat_t));
+          exit (1);
+        }
+      jobs_fstates = q;
+      jobs_max_fnames += 1024;
+    }
+  if (fstate)
+    jobs_fstates[jobs_n_fnames] = *fstate;
+  else
+    jobs_fstates[jobs_n_fnames].st_mode = 0;
+  if ((jobs_fnames[jobs_n_fnames] = strdup (fname)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], strlen (fname) + 1);
+      exit (1);
     }
+  jobs_n_fnames++;
 
   return 0;
 }
 
 
+static void
+ucon64_jobs_worker (int worker, int n_workers, int control)
+{
+  int n;
+
+  if (worker > 0)
+    {
+      // make the state the same as after processing the files before ours
+      first_file = 0;
+      for (n = 0; arg[n].val; n++)
+        if (arg[n].val == UCON64_LS)
+          ucon64.newline_before_rom = 0;
+    }
+
+  for (n = worker; n < jobs_n_fnames; n += n_workers)
+    {
+      long pos;
+
+      ucon64_process_rom (jobs_fnames[n], JOBS_FSTATE (n));
+      fflush (stdout);
+      pos = (long) lseek (STDOUT_FILENO, 0, SEEK_CUR);
+      if (write (control, &pos, sizeof pos) != sizeof pos)
+        break;
+    }
+  ucon64_cache_close ();
+  fflush (stderr);
+  _exit (0);                                    // the parent does the clean-up
+}
+
+
+static void
+ucon64_jobs_process_roms (void)
+{
+  st_ucon64_worker_t *workers;
+  int n_workers = MIN (ucon64_settings.jobs, jobs_n_fnames), n, failed = 0;
+  char buf[MAXBUFSIZE];
+
+  if (n_workers <= 1)
+    {
+      for (n = 0; n < jobs_n_fnames; n++)
+        if (ucon64_process_rom (jobs_fnames[n], JOBS_FSTATE (n)))
+          break;
+      return;
+    }
+
+  if ((workers = (st_ucon64_worker_t *)
+         calloc (n_workers, sizeof (st_ucon64_worker_t))) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+               n_workers * sizeof (st_ucon64_worker_t));
+      exit (1);
+    }
+
+  fflush (stdout);
+  fflush (stderr);
+  for (n = 0; n < n_workers; n++)
+    {
+      st_ucon64_worker_t *w = &workers[n];
+      char fname[FILENAME_MAX];
+      FILE *output;
+      int control[2];
+
+      tmpnam2 (fname, NULL);
+      if ((output = fopen (fname, "wb")) == NULL ||
+          (w->output = fopen (fname, "rb")) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], fname);
+          exit (1);
+        }
+      remove (fname);                           // it's gone when the handles are closed
+      if (pipe (control) || (w->pid = fork ()) == -1)
+        {
+          fputs ("ERROR: Could not start worker process\n", stderr);
+          exit (1);
+        }
+      if (w->pid == 0)
+        {
+          close (control[0]);
+          dup2 (fileno (output), STDOUT_FILENO);
+          fclose (output);
+          ucon64_jobs_worker (n, n_workers, control[1]);
+        }
+      fclose (output);
+      close (control[1]);
+      w->control = control[0];
+    }
+
+  for (n = 0; n < jobs_n_fnames && !failed; n++)
+    {
+      st_ucon64_worker_t *w = &workers[n % n_workers];
+      long pos;
+
+      if (read (w->control, &pos, sizeof pos) != sizeof pos)
+        {
+          failed = 1;                           // the worker stopped (exit(1))
+          pos = LONG_MAX;
+        }
+      while (w->pos < pos)
+        {
+          size_t len = (size_t) MIN (pos - w->pos, MAXBUFSIZE);
+
+          if ((len = fread (buf, 1, len, w->output)) == 0)
+            break;
+          fwrite (buf, 1, len, stdout);
+          w->pos += len;
+        }
+      fflush (stdout);
+    }
+
+  for (n = 0; n < n_workers; n++)
+    {
+      int status;
+
+      if (failed)
+        kill (workers[n].pid, SIGTERM);
+      waitpid (workers[n].pid, &status, 0);
+      close (workers[n].control);
+      fclose (workers[n].output);
+    }
+  free (workers);
+  if (failed)
+    exit (1);
+}
+#endif // HAVE_FORK
+
+
 static int
 ucon64_execute_options (void)
 /*
@@ -1397,7 +1874,6 @@ ucon64_execute_options (void)
 */
 {
   int x = 0, opts = 0;
-  static int first_file = 1;
 
   // these members of ucon64 can change per file
   ucon64.dat = NULL;
@@ -1407,6 +1883,7 @@ ucon64_execute_options (void)
   ucon64.nfo = NULL;
   ucon64.fsize = 0;
   ucon64.crc32 = ucon64.fcrc32 = 0;
+  ucon64_chksum_flush ();
 
   ucon64.console = ucon64.org_console;
   ucon64.split = ucon64.org_split;
@@ -1427,7 +1904,7 @@ ucon64_execute_options (void)
         first_file = 0;
         {
           // WF_NO_SPLIT, WF_INIT, WF_PROBE, CRC32, DATabase and WF_NFO
-          int result = ucon64_rom_handling ();
+          int result = ucon64_rom_handling (&ucon64);
 
           if (result < 0)
             return -1;
@@ -1447,6 +1924,11 @@ ucon64_execute_options (void)
                      opt ? opt : "uCON64");
             return -1;
           }
+        // any option other than the checksum options may have changed the file
+        if (ucon64.option != UCON64_CRC && ucon64.option != UCON64_CRCHD &&
+            ucon64.option != UCON64_MD5 && ucon64.option != UCON64_SHA1 &&
+            ucon64.option != UCON64_SHA256)
+          ucon64_chksum_flush ();
 
         /*
           "stop" options:
@@ -1463,11 +1945,11 @@ ucon64_execute_options (void)
   if (!opts) // no options => just display ROM info
     {
       ucon64.flags = WF_DEFAULT;
-      if (!first_file && ucon64.quiet < 1)
+      if (!first_file && ucon64_settings.quiet < 1)
         fputc ('\n', stdout);
       first_file = 0;
       // WF_NO_SPLIT, WF_INIT, WF_PROBE, CRC32, DATabase and WF_NFO
-      if (ucon64_rom_handling () < 0)
+      if (ucon64_rom_handling (&ucon64) < 0)
         return -1;
     }
 
@@ -1478,7 +1960,7 @@ ucon64_execute_options (void)
 
 
 static int
-ucon64_rom_handling (void)
+ucon64_rom_handling (st_ucon64_t *p)
 {
   int no_rom = 0;
 #ifdef  _WIN32
@@ -1488,17 +1970,22 @@ ucon64_rom_handling (void)
 #endif
 
   // a ROM (file)?
-  if (!ucon64.fname[0])
+  if (!p->fname[0])
     no_rom = 1;
-  else if (access (ucon64.fname, F_OK | R_OK) && (!(ucon64.flags & WF_NO_ROM)))
+  else if (access (p->fname, F_OK | R_OK) && (!(p->flags & WF_NO_ROM)))
     {
-      fprintf (stderr, "ERROR: Could not open %s\n", ucon64.fname);
+      fprintf (stderr, "ERROR: Could not open %s\n", p->fname);
       no_rom = 1;
     }
+  else if (p->fstate && p->fstate_fname == p->fname)
+    {
+      if (S_ISREG (p->fstate->st_mode) != TRUE)
+        no_rom = 1;
+    }
 #ifdef  _WIN32
-  else if (_stati64 (ucon64.fname, &fstate))
+  else if (_stati64 (p->fname, &fstate))
 #else
-  else if (stat (ucon64.fname, &fstate))
+  else if (stat (p->fname, &fstate))
 #endif
     no_rom = 1;
   else if (S_ISREG (fstate.st_mode) != TRUE)
@@ -1511,7 +1998,7 @@ ucon64_rom_handling (void)
 
   if (no_rom)
     {
-      if (!(ucon64.flags & WF_NO_ROM))
+      if (!(p->flags & WF_NO_ROM))
         {
           fputs ("ERROR: This option requires a file argument (ROM/image/SRAM file/directory)\n",
                  stderr);
@@ -1520,56 +2007,82 @@ ucon64_rom_handling (void)
       return 0;
     }
 
-  // setting ucon64.fsize is important and should be done as soon as possible
+  {
+    int result;
+    st_quick_io_stats_t stats;
+
+    // read the ROM through one file handle instead of reopening it for every
+    //  ucon64_fread() and ucon64_fgetc()
+    quick_io_ctx_open (&p->io_ctx, p->fname);
+    result = ucon64_rom_handling_file (p);
+    quick_io_ctx_close (&p->io_ctx, &stats);
+#ifdef  DEBUG
+    printf ("DEBUG: %s: %lu reads, %lu opens, %lu seeks, %u bytes read\n",
+            p->fname, stats.calls, stats.opens, stats.seeks,
+            (unsigned int) stats.bytes_read);
+#else
+    (void) stats;
+#endif
+    return result;
+  }
+}
+
+
+static int
+ucon64_rom_handling_file (st_ucon64_t *p)
+{
+  // a file in the scan cache doesn't have to be read at all (fsizeof() reads
+  //  all data of a gzip file)
+  int cached = (p->flags & WF_INIT) ? ucon64_cache_lookup (p) : 0;
+
+  // setting p->fsize is important and should be done as soon as possible
   //  (and sensible) in this function
-  if ((int64_t) (ucon64.fsize = fsizeof (ucon64.fname)) < 0)
+  if (!cached && (int64_t) (p->fsize = fsizeof (p->fname)) < 0)
     {
-      fprintf (stderr, "ERROR: Could not determine size of %s\n", ucon64.fname);
+      fprintf (stderr, "ERROR: Could not determine size of %s\n", p->fname);
       return -1;
     }
   // we have to do this here, because we don't know the file size until now
-  if (UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) &&
-      ucon64.backup_header_len >= ucon64.fsize)
+  if (UCON64_ISSET2 (p->backup_header_len, unsigned int) &&
+      p->backup_header_len >= p->fsize)
     {
       fprintf (stderr,
                "ERROR: A backup unit header length was specified that is larger than or equal\n"
-               "       to the file size (%u >= %u)\n", ucon64.backup_header_len,
-               (unsigned int) ucon64.fsize);
+               "       to the file size (%u >= %u)\n", p->backup_header_len,
+               (unsigned int) p->fsize);
       return -1;
     }
 
-  if (!(ucon64.flags & WF_INIT))
+  if (!(p->flags & WF_INIT))
     return 0;
 
   // try to find the correct console by analyzing the ROM
-  if (ucon64.flags & WF_PROBE)
+  if ((p->flags & WF_PROBE) && !cached)
     {
-      static st_ucon64_nfo_t nfo;
-
-      ucon64.nfo = ucon64_probe (&nfo);         // determines console type
+      p->nfo = ucon64_probe (p, &p->nfo_data); // determines console type
 
 #ifdef  USE_DISCMAGE
       // check for disc image only if ucon64_probe() failed or --disc was used
-      if (ucon64.discmage_enabled && ucon64.force_disc)
-        ucon64.image = dm_reopen (ucon64.fname, 0, (dm_image_t *) ucon64.image);
+      if (p->settings->discmage_enabled && p->force_disc)
+        p->image = dm_reopen (p->fname, 0, (dm_image_t *) p->image);
 #endif
     }
   // end of WF_PROBE
 
   // Does the option allow split ROMs?
-  if (ucon64.flags & WF_NO_SPLIT)
+  if (p->flags & WF_NO_SPLIT)
     /*
       Test for split files only if the console type knows about split files at
       all. However we only know the console type after probing.
     */
-    if ((ucon64.console == UCON64_NES ||
-         (ucon64.console == UCON64_SNES && snes_get_copier_type () != IC2) ||
-         ucon64.console == UCON64_GEN || ucon64.console == UCON64_NG) &&
-        (UCON64_ISSET (ucon64.split) ?
-           ucon64.split : ucon64_testsplit (ucon64.fname, NULL, NULL)))
+    if ((p->console == UCON64_NES ||
+         (p->console == UCON64_SNES && snes_get_copier_type (p) != IC2) ||
+         p->console == UCON64_GEN || p->console == UCON64_NG) &&
+        (UCON64_ISSET (p->split) ?
+           p->split : ucon64_testsplit (p->fname, NULL, NULL)))
       {
         fprintf (stderr, "ERROR: %s seems to be split. You have to join it first\n",
-                 basename2 (ucon64.fname));
+                 basename2 (p->fname));
         return -1;
       }
 
@@ -1585,32 +2098,34 @@ ucon64_rom_handling (void)
     corresponding initialization functions calculate the CRC32 checksum of
     the data in the format of which the checksum is stored in the DAT
     files. For these "problematic" files, their "real" checksum is stored
-    in ucon64.fcrc32.
+    in p->fcrc32.
   */
-  if (ucon64.crc32 == 0 && !ucon64.force_disc && // NOT for disc images
-      !(ucon64.flags & WF_NO_CRC32) && ucon64.fsize <= MAXROMSIZE)
-    ucon64_chksum (NULL, NULL, &ucon64.crc32, ucon64.fname, ucon64.fsize,
-                   ucon64.nfo ? ucon64.nfo->backup_header_len : 0);
+  if (p->crc32 == 0 && !p->force_disc && // NOT for disc images
+      !(p->flags & WF_NO_CRC32) && p->fsize <= MAXROMSIZE)
+    ucon64_chksum (NULL, NULL, NULL, &p->crc32, p->fname, p->fsize,
+                   p->nfo ? p->nfo->backup_header_len : 0, p->settings->chksum_flags);
+  if (!cached)
+    ucon64_cache_store (p);
 
   // DATabase
-  ucon64.dat = NULL;
-  if (ucon64.crc32 != 0 && ucon64.dat_enabled)
+  p->dat = NULL;
+  if (p->crc32 != 0 && p->settings->dat_enabled)
     {
-      ucon64.dat = ucon64_dat_search (ucon64.crc32);
-      if (ucon64.dat)
+      p->dat = ucon64_dat_search (p->crc32, p->console);
+      if (p->dat)
         {
           // detected file size must match DAT file size
-          int size = (int) (ucon64.nfo ?
-                       UCON64_ISSET2 (ucon64.nfo->data_size, uint64_t) ?
-                         ucon64.nfo->data_size :
-                         ucon64.fsize - ucon64.nfo->backup_header_len :
-                       ucon64.fsize);
-          if ((int) (((st_ucon64_dat_t *) ucon64.dat)->fsize) != size)
-            ucon64.dat = NULL;
+          int size = (int) (p->nfo ?
+                       UCON64_ISSET2 (p->nfo->data_size, uint64_t) ?
+                         p->nfo->data_size :
+                         p->fsize - p->nfo->backup_header_len :
+                       p->fsize);
+          if ((int) (((st_ucon64_dat_t *) p->dat)->fsize) != size)
+            p->dat = NULL;
         }
 
-      if (ucon64.dat)
-        switch (ucon64.console)
+      if (p->dat)
+        switch (p->console)
           {
           case UCON64_SNES:
           case UCON64_GEN:
@@ -1621,29 +2136,29 @@ ucon64_rom_handling (void)
             break;
 
           default:
-            if (ucon64.nfo)
+            if (p->nfo)
               {
-                if (!ucon64.nfo->name[0])
-                  strcpy (ucon64.nfo->name, ((st_ucon64_dat_t *) ucon64.dat)->name);
-                else if (ucon64.console == UCON64_NES)
+                if (!p->nfo->name[0])
+                  strcpy (p->nfo->name, ((st_ucon64_dat_t *) p->dat)->name);
+                else if (p->console == UCON64_NES)
                   { // override the three-character FDS or FAM name
-                    nes_file_t type = nes_get_file_type ();
+                    nes_file_t type = nes_get_file_type (p);
 
                     if (type == FDS || type == FAM)
-                      strcpy (ucon64.nfo->name, ((st_ucon64_dat_t *) ucon64.dat)->name);
+                      strcpy (p->nfo->name, ((st_ucon64_dat_t *) p->dat)->name);
                   }
 
-                if (!ucon64.nfo->country)
-                  ucon64.nfo->country = NULL_TO_EMPTY (((st_ucon64_dat_t *) ucon64.dat)->country);
+                if (!p->nfo->country)
+                  p->nfo->country = NULL_TO_EMPTY (((st_ucon64_dat_t *) p->dat)->country);
               }
             break;
           }
     }
 
   // display info
-  if ((ucon64.flags & WF_NFO) && ucon64.quiet < 1)
+  if ((p->flags & WF_NFO) && p->settings->quiet < 1)
     {
-      ucon64_nfo ();
+      ucon64_nfo (p);
       return 1;
     }
 
@@ -1652,7 +2167,7 @@ ucon64_rom_handling (void)
 
 
 static st_ucon64_nfo_t *
-ucon64_probe (st_ucon64_nfo_t *nfo)
+ucon64_probe (st_ucon64_t *p, st_ucon64_nfo_t *nfo)
 {
 #ifdef  _MSC_VER
 #pragma warning(push)
@@ -1661,7 +2176,7 @@ ucon64_probe (st_ucon64_nfo_t *nfo)
   typedef struct
     {
       int console;
-      int (*init) (st_ucon64_nfo_t *);
+      int (*init) (st_ucon64_t *, st_ucon64_nfo_t *);
       uint32_t flags;
     } st_probe_t;
 #ifdef  _MSC_VER
@@ -1712,31 +2227,31 @@ ucon64_probe (st_ucon64_nfo_t *nfo)
       {0, NULL, 0}
     };
 
-  if (ucon64.console != UCON64_UNKNOWN)         // force recognition option was used
+  if (p->console != UCON64_UNKNOWN)             // force recognition option was used
     {
       for (x = 0; probe[x].console != 0; x++)
-        if (probe[x].console == ucon64.console)
+        if (probe[x].console == p->console)
           {
             ucon64_clear_nfo (nfo);
 
-            probe[x].init (nfo);
+            probe[x].init (p, nfo);
             return nfo;
           }
     }
-  else if (ucon64.fsize <= MAXROMSIZE)          // give auto recognition a try
+  else if (p->fsize <= MAXROMSIZE)              // give auto recognition a try
     {
       for (x = 0; probe[x].console != 0; x++)
         if (probe[x].flags & AUTO)
           {
             ucon64_clear_nfo (nfo);
 
-            if (!probe[x].init (nfo))
+            if (!probe[x].init (p, nfo))
               {
-                ucon64.console = probe[x].console;
+                p->console = probe[x].console;
                 return nfo;
               }
 
-            ucon64.split = ucon64.org_split;
+            p->split = p->org_split;
           }
     }
 
@@ -1745,46 +2260,46 @@ ucon64_probe (st_ucon64_nfo_t *nfo)
 
 
 int
-ucon64_nfo (void)
+ucon64_nfo (st_ucon64_t *p)
 {
-  puts (ucon64.fname);
-  if (ucon64.fname_arch[0])
-    printf ("  (%s)\n", ucon64.fname_arch);
+  puts (p->fname);
+  if (p->fname_arch[0])
+    printf ("  (%s)\n", p->fname_arch);
   fputc ('\n', stdout);
 #ifdef  USE_DISCMAGE
-  if (ucon64.console == UCON64_UNKNOWN && !ucon64.image)
+  if (p->console == UCON64_UNKNOWN && !p->image)
 #else
-  if (ucon64.console == UCON64_UNKNOWN)
+  if (p->console == UCON64_UNKNOWN)
 #endif
     fputs (ucon64_msg[CONSOLE_WARNING], stderr);
 
-  if (ucon64.nfo && ucon64.console != UCON64_UNKNOWN && !ucon64.force_disc)
-    ucon64_rom_nfo (ucon64.nfo);
+  if (p->nfo && p->console != UCON64_UNKNOWN && !p->force_disc)
+    ucon64_rom_nfo (p, p->nfo);
 
 #ifdef  USE_DISCMAGE
-  if (ucon64.discmage_enabled && ucon64.image)
+  if (p->settings->discmage_enabled && p->image)
     {
-      dm_nfo ((dm_image_t *) ucon64.image, ucon64.quiet < 0 ? 1 : 0,
+      dm_nfo ((dm_image_t *) p->image, p->settings->quiet < 0 ? 1 : 0,
 #ifdef  USE_ANSI_COLOR
-              ucon64.ansi_color ? 1 :
+              p->settings->ansi_color ? 1 :
 #endif
                                   0);
 
       return 0; // no crc calc. for disc images and therefore no DAT entry either
     }
 #endif
-  // Use ucon64.fcrc32 for SNES, Genesis & SMS interleaved/N64 non-interleaved
-  if (ucon64.fcrc32 && ucon64.crc32)
+  // Use p->fcrc32 for SNES, Genesis & SMS interleaved/N64 non-interleaved
+  if (p->fcrc32 && p->crc32)
     printf ("Search checksum (CRC32): 0x%08x\n"
-            "Data checksum (CRC32): 0x%08x\n", ucon64.crc32, ucon64.fcrc32);
-  else if (ucon64.fcrc32 || ucon64.crc32)
-    printf ("Checksum (CRC32): 0x%08x\n", ucon64.fcrc32 ? ucon64.fcrc32 : ucon64.crc32);
+            "Data checksum (CRC32): 0x%08x\n", p->crc32, p->fcrc32);
+  else if (p->fcrc32 || p->crc32)
+    printf ("Checksum (CRC32): 0x%08x\n", p->fcrc32 ? p->fcrc32 : p->crc32);
 
   // The check for the size of the file is made, so that uCON64 won't display a
   //  (nonsense) DAT info line when dumping a ROM (file doesn't exist, so
-  //  ucon64.fsize is 0).
-  if (ucon64.fsize > 0 && ucon64.dat_enabled && ucon64.dat)
-    ucon64_dat_nfo ((st_ucon64_dat_t *) ucon64.dat, 1);
+  //  p->fsize is 0).
+  if (p->fsize > 0 && p->settings->dat_enabled && p->dat)
+    ucon64_dat_nfo ((st_ucon64_dat_t *) p->dat, 1);
 
   return 0;
 }
@@ -1811,7 +2326,7 @@ nfo_toprint (char c)
   // characters that also work with printf()
 #ifdef  USE_ANSI_COLOR
   if (c == '\x1b')
-    return ucon64.ansi_color ? c : '.';
+    return ucon64_settings.ansi_color ? c : '.';
 #endif
 
   return strchr ("\t\n\r", c) ? c : '.';
@@ -1819,13 +2334,13 @@ nfo_toprint (char c)
 
 
 static void
-ucon64_rom_nfo (const st_ucon64_nfo_t *nfo)
+ucon64_rom_nfo (st_ucon64_t *p, const st_ucon64_nfo_t *nfo)
 {
-  unsigned int intro = ucon64.fsize - nfo->backup_header_len > MBIT ?
-                         (ucon64.fsize - nfo->backup_header_len) % MBIT : 0;
-  int padded = (int) ucon64_testpad (ucon64.fname), x,
-               split = UCON64_ISSET (ucon64.split) ?
-                 ucon64.split : ucon64_testsplit (ucon64.fname, NULL, NULL);
+  unsigned int intro = p->fsize - nfo->backup_header_len > MBIT ?
+                         (p->fsize - nfo->backup_header_len) % MBIT : 0;
+  int padded = (int) ucon64_cache_testpad (p->fname), x,
+               split = UCON64_ISSET (p->split) ?
+                 p->split : ucon64_testsplit (p->fname, NULL, NULL);
   char buf[MAXBUFSIZE];
 
   // backup unit header
@@ -1837,9 +2352,9 @@ ucon64_rom_nfo (const st_ucon64_nfo_t *nfo)
       fputc ('\n', stdout);
     }
   else
-    if (nfo->backup_header_len && ucon64.quiet < 0)
+    if (nfo->backup_header_len && p->settings->quiet < 0)
       {
-        ucon64_dump (stdout, ucon64.fname, nfo->backup_header_start,
+        ucon64_dump (stdout, p->fname, nfo->backup_header_start,
                      nfo->backup_header_len, DUMPER_HEX);
         fputc ('\n', stdout);
       }
@@ -1870,7 +2385,7 @@ ucon64_rom_nfo (const st_ucon64_nfo_t *nfo)
     if (!isprint ((int) buf[x]))
       buf[x] = '.';
   x = (int) (UCON64_ISSET2 (nfo->data_size, uint64_t) ?
-        nfo->data_size : ucon64.fsize - nfo->backup_header_len);
+        nfo->data_size : p->fsize - nfo->backup_header_len);
   printf ("%s\n%s\n%s\n%d Bytes (%.4f Mb)\n\n",
           buf,
           NULL_TO_EMPTY (nfo->maker),
@@ -1887,7 +2402,7 @@ ucon64_rom_nfo (const st_ucon64_nfo_t *nfo)
 
   // intro, trainer?
   // nes.c determines itself whether or not there is a trainer
-  if (intro && ucon64.console != UCON64_NES)
+  if (intro && p->console != UCON64_NES)
     printf ("Intro/Trainer: Maybe, %u Byte%s\n", intro, intro != 1 ? "s" : "");
 
   // interleaved?
@@ -1917,8 +2432,8 @@ ucon64_rom_nfo (const st_ucon64_nfo_t *nfo)
         so there is no need to join the files. Likewise, snes.c calculates the
         correct checksum for files in SMC IC2 format.
       */
-      if (ucon64.console != UCON64_NES &&
-          !(ucon64.console == UCON64_SNES && snes_get_copier_type () == IC2))
+      if (p->console != UCON64_NES &&
+          !(p->console == UCON64_SNES && snes_get_copier_type (p) == IC2))
         puts ("NOTE: To get the correct checksum the ROM parts must be joined");
     }
 
@@ -1935,12 +2450,12 @@ ucon64_rom_nfo (const st_ucon64_nfo_t *nfo)
       // the internal checksum of GBA ROMs stores only the checksum of the
       //  internal header
       sprintf (buf, "%s: %%s, 0x%%0%ux (calculated) %%c= 0x%%0%ux (internal)\n",
-               ucon64.console != UCON64_GBA ? "Checksum" : "Header checksum",
+               p->console != UCON64_GBA ? "Checksum" : "Header checksum",
                nfo->internal_crc_len * 2, nfo->internal_crc_len * 2);
       printf (buf, nfo->current_internal_crc == nfo->internal_crc ?
 #ifdef  USE_ANSI_COLOR
-                ucon64.ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
-                ucon64.ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
+                p->settings->ansi_color ? "\x1b[01;32mOK\x1b[0m" : "OK" :
+                p->settings->ansi_color ? "\x1b[01;31mBad\x1b[0m" : "Bad",
 #else
                 "OK" : "Bad",
 #endif
@@ -2003,6 +2518,32 @@ ucon64_fname_arch (const char *fname)
 #endif
 
 
+void *
+ucon64_console_data (st_ucon64_t *p, int console, size_t size)
+{
+  if (!p->console_data[console] &&
+      (p->console_data[console] = calloc (1, size)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], (unsigned int) size);
+      exit (1);
+    }
+  return p->console_data[console];
+}
+
+
+void
+ucon64_console_data_free (st_ucon64_t *p)
+{
+  int console;
+
+  for (console = 0; console < UCON64_CONSOLES; console++)
+    {
+      free (p->console_data[console]);
+      p->console_data[console] = NULL;
+    }
+}
+
+
 void
 ucon64_usage (int argc, char *argv[], int view)
 {
@@ -2052,7 +2593,10 @@ ucon64_usage (int argc, char *argv[], int view)
         getopt2_usage (bsl_usage);
         getopt2_usage (ips_usage);
         getopt2_usage (aps_usage);
+        getopt2_usage (pcat_usage);
         getopt2_usage (ppf_usage);
+        getopt2_usage (bps_usage);
+        getopt2_usage (ups_usage);
         getopt2_usage (gg_usage);
         break;
 
@@ -2109,12 +2653,12 @@ ucon64_usage (int argc, char *argv[], int view)
   fputc ('\n', stdout);
 
   printf ("DATabase: %u known ROMs (DAT files: %s)\n\n",
-          ucon64_dat_total_entries (), ucon64.datdir);
+          ucon64_dat_total_entries (), ucon64_settings.datdir);
 
 #ifdef  USE_DISCMAGE
   name_discmage =
 #ifdef  DLOPEN
-    ucon64.discmage_path;
+    ucon64_settings.discmage_path;
 #else
 #ifdef  __MSDOS__
     "discmage.dxe";
@@ -2129,7 +2673,7 @@ ucon64_usage (int argc, char *argv[], int view)
 #endif
 #endif
 
-  if (!ucon64.discmage_enabled)
+  if (!ucon64_settings.discmage_enabled)
     {
       printf (ucon64_msg[NO_LIB], name_discmage);
       fputc ('\n', stdout);
@@ -37,6 +37,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
+#include "misc/file.h"                          // st_quick_io_ctx_t
 #include "misc/itypes.h"
 #include "misc/parallel.h"
 #include "ucon64_defines.h"                     // MAXBUFSIZE, etc..
@@ -50,8 +51,14 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
   st_ucon64_nfo_t this struct contains very specific informations only
                     <console>_init() can supply after the correct console
                     type was identified.
+  st_ucon64_settings_t this struct contains the settings of a run, taken from
+                    the config file and the switches. They don't change per
+                    file
   st_ucon64_t     this struct contains st_ucon64_nfo_t and unspecific
                     informations and some workflow stuff
+                    <console>_init() and the functions that probe a file
+                    get the st_ucon64_t of that file as argument and don't
+                    use the global ucon64
   st_ucon64_obj_t ucon64 object for use in st_getopt2_t
 */
 #ifdef  _MSC_VER
@@ -91,26 +98,10 @@ typedef struct
 
 typedef struct
 {
-  int argc;
-  char **argv;
-
-  int option;                                   // current option (UCON64_HEX, UCON64_FIND, ...)
-  const char *optarg;                           // ptr to current options optarg
-  char *temp_file;                              // global temp_file
-
-  const char *fname;                            // ROM (cmdline) with path
   int recursive;
-
-  char fname_arch[FILENAME_MAX];                // filename in archive (currently only for zip)
-  uint64_t fsize;                               // (uncompressed) ROM file size (NOT console specific)
-  unsigned int crc32;                           // CRC32 value of ROM (used for DAT files) (NOT console specific)
-  unsigned int fcrc32;                          // if non-zero: CRC32 of ROM as it is on disk (NOT console specific)
-
-  // if console == UCON64_UNKNOWN or st_ucon64_nfo_t == NULL ucon64_rom_nfo() won't be shown
-  int console;                                  // the detected console system
-  int org_console;                              // the value of console before processing the first file
-
-  const char *file;                             // FILE (cmdline) with path
+  int jobs;                                     // number of files processed in parallel
+  int rescan;                                   // --rescan was used
+  unsigned int chksum_flags;                    // CHKSUM_* of the checksum options (calculated in one pass)
 
   char configfile[FILENAME_MAX];                // path and name of the config file
   char configdir[FILENAME_MAX];                 // directory for config
@@ -144,6 +135,36 @@ typedef struct
   int dat_enabled;                              // flag if DAT file(s) are usable/enabled
   int n64_dat_v64;                              // base .crc32 on ROM in V64 (1) or Z64 (0) format
   int quiet;                                    // quiet == -1 means verbose + 1
+} st_ucon64_settings_t;
+
+typedef struct
+{
+  const st_ucon64_settings_t *settings;         // settings of this run (shared by all files)
+
+  int argc;
+  char **argv;
+
+  int option;                                   // current option (UCON64_HEX, UCON64_FIND, ...)
+  const char *optarg;                           // ptr to current options optarg
+  char *temp_file;                              // global temp_file
+
+  const char *fname;                            // ROM (cmdline) with path
+  const char *fstate_fname;                     // fname that fstate belongs to
+#ifdef  _WIN32
+  const struct _stati64 *fstate;
+#else
+  const struct stat *fstate;                    // status of fstate_fname or NULL
+#endif
+  char fname_arch[FILENAME_MAX];                // filename in archive (currently only for zip)
+  uint64_t fsize;                               // (uncompressed) ROM file size (NOT console specific)
+  unsigned int crc32;                           // CRC32 value of ROM (used for DAT files) (NOT console specific)
+  unsigned int fcrc32;                          // if non-zero: CRC32 of ROM as it is on disk (NOT console specific)
+
+  // if console == UCON64_UNKNOWN or st_ucon64_nfo_t == NULL ucon64_rom_nfo() won't be shown
+  int console;                                  // the detected console system
+  int org_console;                              // the value of console before processing the first file
+
+  const char *file;                             // FILE (cmdline) with path
 
   int force_disc;                               // --disc was used
   uint32_t flags;                               // detect and init ROM info
@@ -190,6 +211,10 @@ typedef struct
 #endif
   void *dat;                                    // info from DATabase (st_ucon64_dat_t *)
   st_ucon64_nfo_t *nfo;                         // info from <console>_init() (st_ucon64_nfo_t *)
+  st_ucon64_nfo_t nfo_data;                     // storage for nfo
+  st_quick_io_ctx_t io_ctx;                     // open file while the file is handled
+  void *console_data[UCON64_CONSOLES];          // state of <console>.c for this file, see
+                                                //  ucon64_console_data()
 } st_ucon64_t;
 #ifdef  _MSC_VER
 #pragma warning(pop)
@@ -207,11 +232,16 @@ typedef struct
                           dm_image_t
   ucon64_usage()        print usage
   ucon64_fname_arch()
+  ucon64_console_data() returns the state that <console>.c keeps for the file of
+                          p. It is allocated (and zeroed) on first use
+  ucon64_console_data_free() free all console states of p
 
   ucon64                global (st_ucon64_t *)
+  ucon64_settings       global (st_ucon64_settings_t *), ucon64.settings points
+                          to it
 */
 extern int ucon64_init (void);
-extern int ucon64_nfo (void);
+extern int ucon64_nfo (st_ucon64_t *p);
 enum
 {
   USAGE_VIEW_SHORT = 0,
@@ -226,7 +256,10 @@ extern void ucon64_usage (int argc, char *argv[], int view);
 #ifdef  USE_ZLIB
 extern void ucon64_fname_arch (const char *fname);
 #endif
+extern void *ucon64_console_data (st_ucon64_t *p, int console, size_t size);
+extern void ucon64_console_data_free (st_ucon64_t *p);
 
 extern st_ucon64_t ucon64;
+extern st_ucon64_settings_t ucon64_settings;
 
 #endif // UCON64_H
@@ -0,0 +1,699 @@
+/*
+ucon64_cache.c - persistent cache of ROM scan results
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+#include <sys/stat.h>
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+#include "misc/archive.h"
+#include "misc/chksum.h"
+#include "misc/file.h"
+#include "ucon64.h"
+#include "ucon64_cache.h"
+#include "ucon64_misc.h"
+
+
+#define CACHE_MAGIC "uCON64SC"
+#define CACHE_VERSION 1
+#define CACHE_HEADER_LEN 16                     // magic, version & byte order
+#define CACHE_FRAME_LEN 8                       // record length & CRC32
+#define CACHE_KEY_LEN 40
+#define CACHE_MAX_RECORD_LEN (4 * MAXBUFSIZE)
+#define CACHE_HAS_NFO 1
+#define CACHE_HAS_PADDED 2
+
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  uint64_t dev;
+  uint64_t ino;
+  int64_t size;
+  int64_t mtime;
+  uint32_t entry_nr;                            // entry in ZIP file
+  uint32_t settings;                            // switches, console, option flags
+} st_cache_key_t;
+
+typedef struct
+{
+  st_cache_key_t key;
+  int64_t pos;                                  // position of the record in the file
+  uint32_t len;                                 // 0 == unused slot
+} st_cache_entry_t;
+
+typedef struct
+{
+  const unsigned char *p;
+  const unsigned char *end;
+} st_cache_reader_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+static char cache_fname[FILENAME_MAX];
+static FILE *cache_file = NULL;                 // opened on first use, see cache_fh()
+static int cache_enabled = 0, cache_rescan = 0;
+static uint32_t cache_settings = 0;
+static st_cache_entry_t *cache_entries = NULL;
+static size_t cache_n_entries = 0, cache_mask = 0;
+
+// the record of the current file (frame followed by the record itself)
+static unsigned char *record = NULL;
+static size_t record_len = 0, record_size = 0;
+static int record_valid = 0, record_pending = 0;
+static st_cache_key_t current_key;
+static int current_valid = 0;
+static char current_fname[FILENAME_MAX];
+
+
+static uint32_t
+cache_hash (const st_cache_key_t *key)
+{
+  uint64_t h = key->ino * 0x9e3779b97f4a7c15ULL;
+
+  h ^= key->dev + (h << 6) + (h >> 2);
+  h ^= ((uint64_t) key->entry_nr << 32 | key->settings) + (h << 6) + (h >> 2);
+  return (uint32_t) (h ^ (h >> 32));
+}
+
+
+static int
+cache_same_file (const st_cache_key_t *a, const st_cache_key_t *b)
+{
+  return a->dev == b->dev && a->ino == b->ino && a->entry_nr == b->entry_nr &&
+         a->settings == b->settings;
+}
+
+
+static st_cache_entry_t *
+cache_find (const st_cache_key_t *key)
+// return the entry for key or the free slot where it should be stored
+{
+  size_t i = cache_hash (key) & cache_mask;
+
+  while (cache_entries[i].len && !cache_same_file (&cache_entries[i].key, key))
+    i = (i + 1) & cache_mask;
+  return &cache_entries[i];
+}
+
+
+static int
+cache_insert (const st_cache_key_t *key, int64_t pos, uint32_t len)
+// returns 1 if an older record of the same file was replaced, otherwise 0
+{
+  st_cache_entry_t *entry;
+
+  if (cache_n_entries + 1 > (cache_mask + 1) / 2)
+    {
+      size_t n = cache_mask + 1, i;
+      st_cache_entry_t *old = cache_entries;
+
+      if ((cache_entries = (st_cache_entry_t *)
+             calloc (n * 2, sizeof (st_cache_entry_t))) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], n * 2 * sizeof (st_cache_entry_t));
+          exit (1);
+        }
+      cache_mask = n * 2 - 1;
+      for (i = 0; i < n; i++)
+        if (old[i].len)
+          *cache_find (&old[i].key) = old[i];
+      free (old);
+    }
+
+  entry = cache_find (key);
+  if (entry->len)
+    {
+      entry->key = *key;
+      entry->pos = pos;
+      entry->len = len;
+      return 1;
+    }
+  entry->key = *key;
+  entry->pos = pos;
+  entry->len = len;
+  cache_n_entries++;
+  return 0;
+}
+
+
+static void
+record_reserve (size_t len)
+{
+  if (record_len + len > record_size)
+    {
+      size_t size = record_size ? record_size * 2 : MAXBUFSIZE;
+      unsigned char *p;
+
+      while (size < record_len + len)
+        size *= 2;
+      if ((p = (unsigned char *) realloc (record, size)) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], size);
+          exit (1);
+        }
+      record = p;
+      record_size = size;
+    }
+}
+
+
+static void
+record_put (const void *data, size_t len)
+{
+  record_reserve (len);
+  memcpy (record + record_len, data, len);
+  record_len += len;
+}
+
+
+static void
+record_put32 (uint32_t value)
+{
+  record_put (&value, 4);
+}
+
+
+static void
+record_put64 (uint64_t value)
+{
+  record_put (&value, 8);
+}
+
+
+static void
+record_put_bytes (const void *data, uint32_t len)
+// NULL is stored as length 0xffffffff
+{
+  record_put32 (data ? len : 0xffffffff);
+  if (data)
+    record_put (data, len);
+}
+
+
+static void
+record_put_str (const char *s)
+{
+  record_put_bytes (s, s ? (uint32_t) strlen (s) + 1 : 0);
+}
+
+
+static void
+record_seal (void)
+// fill in the frame of the record
+{
+  uint32_t len = (uint32_t) (record_len - CACHE_FRAME_LEN),
+           crc = crc32 (0, record + CACHE_FRAME_LEN, (unsigned int) len);
+
+  memcpy (record, &len, 4);
+  memcpy (record + 4, &crc, 4);
+}
+
+
+static int
+get (st_cache_reader_t *r, void *data, size_t len)
+{
+  if ((size_t) (r->end - r->p) < len)
+    return -1;
+  memcpy (data, r->p, len);
+  r->p += len;
+  return 0;
+}
+
+
+static int
+get_int (st_cache_reader_t *r, int *value)
+{
+  int32_t x;
+
+  if (get (r, &x, 4))
+    return -1;
+  *value = x;
+  return 0;
+}
+
+
+static int
+get_uint (st_cache_reader_t *r, unsigned int *value)
+{
+  uint32_t x;
+
+  if (get (r, &x, 4))
+    return -1;
+  *value = x;
+  return 0;
+}
+
+
+static int
+get_bytes (st_cache_reader_t *r, const void **data, uint32_t *len)
+{
+  if (get (r, len, 4))
+    return -1;
+  if (*len == 0xffffffff)
+    {
+      *data = NULL;
+      *len = 0;
+      return 0;
+    }
+  if ((size_t) (r->end - r->p) < *len)
+    return -1;
+  *data = r->p;
+  r->p += *len;
+  return 0;
+}
+
+
+static int
+get_str (st_cache_reader_t *r, const char **s)
+{
+  const void *data;
+  uint32_t len;
+
+  if (get_bytes (r, &data, &len) ||
+      (data && (len == 0 || ((const char *) data)[len - 1] != '\0')))
+    return -1;
+  *s = (const char *) data;
+  return 0;
+}
+
+
+static int
+get_str_copy (st_cache_reader_t *r, char *dest, size_t size)
+{
+  const char *s;
+
+  if (get_str (r, &s) || !s || strlen (s) >= size)
+    return -1;
+  strcpy (dest, s);
+  return 0;
+}
+
+
+static FILE *
+cache_fh (void)
+{
+  if (!cache_file && cache_enabled)
+    {
+      if ((cache_file = fopen (cache_fname, "a+b")) == NULL)
+        cache_enabled = 0;                      // read-only configdir?
+      else
+        // every record has to be written with one write() for --jobs
+        setvbuf (cache_file, NULL, _IONBF, 0);
+    }
+  return cache_file;
+}
+
+
+static int
+cache_read_record (FILE *file, int64_t pos, uint32_t len)
+// read the record at pos into record and verify it
+{
+  uint32_t frame[2];
+
+  record_len = 0;
+  record_reserve (len + CACHE_FRAME_LEN);
+  if (fseeko2 (file, pos, SEEK_SET) ||
+      fread (record, 1, len + CACHE_FRAME_LEN, file) != len + CACHE_FRAME_LEN)
+    return -1;
+  memcpy (frame, record, CACHE_FRAME_LEN);
+  if (frame[0] != len || frame[1] != crc32 (0, record + CACHE_FRAME_LEN, (unsigned int) len))
+    return -1;
+  record_len = len + CACHE_FRAME_LEN;
+  return 0;
+}
+
+
+static void
+cache_header (unsigned char *header)
+{
+  uint32_t x = CACHE_VERSION;
+
+  memcpy (header, CACHE_MAGIC, 8);
+  memcpy (header + 8, &x, 4);
+  x = 0x01020304;                               // byte order
+  memcpy (header + 12, &x, 4);
+}
+
+
+static void
+cache_compact (void)
+// rewrite the cache file with only the current record of each file
+{
+  char tmp_fname[FILENAME_MAX];
+  unsigned char header[CACHE_HEADER_LEN];
+  FILE *src, *dest;
+  int64_t pos = CACHE_HEADER_LEN;
+  size_t i;
+
+  snprintf (tmp_fname, FILENAME_MAX, "%s.tmp", cache_fname);
+  tmp_fname[FILENAME_MAX - 1] = '\0';
+  if ((dest = fopen (tmp_fname, "wb")) == NULL)
+    {
+      cache_enabled = 0;
+      return;
+    }
+  cache_header (header);
+  fwrite (header, 1, CACHE_HEADER_LEN, dest);
+  src = fopen (cache_fname, "rb");
+  for (i = 0; i <= cache_mask; i++)
+    {
+      st_cache_entry_t *entry = &cache_entries[i];
+
+      if (!entry->len)
+        continue;
+      // a record that can't be copied becomes a cache miss, because
+      //  cache_read_record() won't find it at entry->pos anymore
+      if (!src || cache_read_record (src, entry->pos, entry->len) ||
+          fwrite (record, 1, record_len, dest) != record_len)
+        continue;
+      entry->pos = pos;
+      pos += record_len;
+    }
+  if (src)
+    fclose (src);
+  fclose (dest);
+  record_len = 0;
+  if (rename2 (tmp_fname, cache_fname))
+    {
+      remove (tmp_fname);
+      cache_enabled = 0;
+    }
+}
+
+
+void
+ucon64_cache_open (const char *fname, uint32_t settings, int rescan)
+{
+  FILE *file;
+  int64_t pos = CACHE_HEADER_LEN;
+  size_t n_dead = 0;
+  int rewrite = 1;
+
+  strncpy (cache_fname, fname, FILENAME_MAX - 1)[FILENAME_MAX - 1] = '\0';
+  cache_settings = settings;
+  cache_rescan = rescan;
+  cache_enabled = 1;
+  cache_mask = 1023;
+  if ((cache_entries = (st_cache_entry_t *)
+         calloc (cache_mask + 1, sizeof (st_cache_entry_t))) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+               (cache_mask + 1) * sizeof (st_cache_entry_t));
+      exit (1);
+    }
+
+  if ((file = fopen (fname, "rb")) != NULL)
+    {
+      unsigned char header[CACHE_HEADER_LEN], expected[CACHE_HEADER_LEN];
+
+      cache_header (expected);
+      if (fread (header, 1, CACHE_HEADER_LEN, file) == CACHE_HEADER_LEN &&
+          !memcmp (header, expected, CACHE_HEADER_LEN))
+        for (rewrite = 0;;)
+          {
+            uint32_t frame[2];
+            size_t n = fread (frame, 1, CACHE_FRAME_LEN, file);
+
+            if (n == 0)
+              break;
+            record_len = 0;
+            if (n != CACHE_FRAME_LEN || frame[0] < CACHE_KEY_LEN ||
+                frame[0] > CACHE_MAX_RECORD_LEN)
+              {
+                rewrite = 1;                    // remove the damaged tail
+                break;
+              }
+            record_reserve (frame[0]);
+            if (fread (record, 1, frame[0], file) != frame[0] ||
+                crc32 (0, record, frame[0]) != frame[1])
+              {
+                rewrite = 1;
+                break;
+              }
+            {
+              st_cache_key_t key;
+
+              memcpy (&key, record, CACHE_KEY_LEN);
+              n_dead += cache_insert (&key, pos, frame[0]);
+            }
+            pos += CACHE_FRAME_LEN + frame[0];
+          }
+      fclose (file);
+    }
+  record_len = 0;
+
+  // rewrite the file if it's new, damaged or contains more old records than
+  //  current ones
+  if (rewrite || (n_dead > 1024 && n_dead > cache_n_entries))
+    cache_compact ();
+}
+
+
+static void
+cache_flush (void)
+{
+  FILE *file;
+
+  if (record_pending && (file = cache_fh ()) != NULL)
+    {
+      int64_t pos;
+
+      fseeko2 (file, 0, SEEK_END);
+      pos = ftello2 (file);
+      record_seal ();
+      // fopen() mode "a" makes the write append to the file, even if another
+      //  process appended to it after the ftello2()
+      if (fwrite (record, 1, record_len, file) == record_len)
+        cache_insert (&current_key, pos, (uint32_t) (record_len - CACHE_FRAME_LEN));
+    }
+  record_pending = 0;
+}
+
+
+void
+ucon64_cache_close (void)
+{
+  cache_flush ();
+  if (cache_file)
+    {
+      fclose (cache_file);
+      cache_file = NULL;
+    }
+  current_valid = record_valid = 0;
+}
+
+
+int
+ucon64_cache_lookup (st_ucon64_t *p)
+{
+#ifdef  _WIN32
+  struct _stati64 buf;
+  const struct _stati64 *fstate = &buf;
+#else
+  struct stat buf;
+  const struct stat *fstate = &buf;
+#endif
+  st_cache_entry_t *entry;
+  st_cache_reader_t r;
+  st_ucon64_nfo_t *nfo = &p->nfo_data;
+  uint32_t settings[4], len;
+  int64_t padded;
+  uint64_t fsize;
+  unsigned int flags, crc, fcrc;
+  int console, split;
+
+  cache_flush ();
+  current_valid = record_valid = 0;
+  if (!cache_enabled || p->force_disc)
+    return 0;
+  if (p->fstate && p->fstate_fname == p->fname)
+    fstate = p->fstate;                         // status from getopt2_file()
+#ifdef  _WIN32
+  else if (_stati64 (p->fname, &buf))
+#else
+  else if (stat (p->fname, &buf))
+#endif
+    return 0;
+  if (fstate->st_ino == 0)                      // no inode numbers => no cache
+    return 0;
+  // the parts of split files can change without the first part changing
+  if (ucon64_testsplit (p->fname, NULL, NULL))
+    return 0;
+
+  memset (&current_key, 0, sizeof current_key);
+  current_key.dev = (uint64_t) fstate->st_dev;
+  current_key.ino = (uint64_t) fstate->st_ino;
+  current_key.size = (int64_t) fstate->st_size;
+  current_key.mtime = (int64_t) fstate->st_mtime;
+#ifdef  USE_ZLIB
+  current_key.entry_nr = (uint32_t) unzip_current_file_nr;
+#endif
+  settings[0] = cache_settings;
+  settings[1] = (uint32_t) p->console;
+  settings[2] = (uint32_t) p->split;
+  settings[3] = p->flags & (WF_PROBE | WF_NO_CRC32);
+  current_key.settings = crc32 (0, (unsigned char *) settings, sizeof settings);
+  strncpy (current_fname, p->fname, FILENAME_MAX - 1)[FILENAME_MAX - 1] = '\0';
+  current_valid = 1;
+
+  if (cache_rescan)
+    return 0;
+  entry = cache_find (&current_key);
+  if (!entry->len || entry->key.size != current_key.size ||
+      entry->key.mtime != current_key.mtime || !cache_fh () ||
+      cache_read_record (cache_file, entry->pos, entry->len) ||
+      memcmp (record + CACHE_FRAME_LEN, &current_key, CACHE_KEY_LEN))
+    return 0;
+
+  r.p = record + CACHE_FRAME_LEN + CACHE_KEY_LEN;
+  r.end = record + record_len;
+  if (get (&r, &padded, 8) || get_uint (&r, &flags) || get (&r, &fsize, 8) ||
+      get_int (&r, &console) || get_int (&r, &split) || get_uint (&r, &crc) ||
+      get_uint (&r, &fcrc))
+    return 0;
+  if (flags & CACHE_HAS_NFO)
+    {
+      if (get_int (&r, &nfo->interleaved) || get (&r, &nfo->data_size, 8) ||
+          get_int (&r, &nfo->backup_header_start) ||
+          get_uint (&r, &nfo->backup_header_len) ||
+          get_int (&r, &nfo->header_start) || get_uint (&r, &nfo->header_len) ||
+          get_int (&r, &nfo->has_internal_crc) ||
+          get_uint (&r, &nfo->current_internal_crc) ||
+          get_uint (&r, &nfo->internal_crc) ||
+          get_int (&r, &nfo->internal_crc_start) ||
+          get_uint (&r, &nfo->internal_crc_len) ||
+          get_str (&r, &nfo->console_usage) || get_str (&r, &nfo->backup_usage) ||
+          get_str (&r, &nfo->maker) || get_str (&r, &nfo->country) ||
+          get_str_copy (&r, nfo->name, sizeof nfo->name) ||
+          get_str_copy (&r, nfo->misc, sizeof nfo->misc) ||
+          get_str_copy (&r, nfo->internal_crc2, sizeof nfo->internal_crc2) ||
+          get_bytes (&r, &nfo->backup_header, &len) ||
+          get_bytes (&r, &nfo->header, &len))
+        return 0;
+      // the strings and headers point into record, which stays valid until
+      //  the next file is looked up
+      p->nfo = nfo;
+    }
+  else
+    p->nfo = NULL;
+  p->fsize = fsize;
+  p->console = console;
+  p->split = split;
+  p->crc32 = crc;
+  p->fcrc32 = fcrc;
+  record_valid = 1;
+  return 1;
+}
+
+
+void
+ucon64_cache_store (const st_ucon64_t *p)
+{
+  const st_ucon64_nfo_t *nfo = p->nfo;
+
+  if (!current_valid || strcmp (p->fname, current_fname) ||
+      // nes_init() keeps state that is used after probing (nes_get_file_type())
+      p->console == UCON64_NES ||
+#ifdef  USE_DISCMAGE
+      p->image ||
+#endif
+      (UCON64_ISSET (p->split) && p->split) ||
+      (nfo && ((nfo->backup_header && nfo->backup_header_len > MAXBUFSIZE) ||
+               (nfo->header && nfo->header_len > MAXBUFSIZE))))
+    return;
+
+  record_len = 0;
+  record_reserve (CACHE_FRAME_LEN);
+  record_len = CACHE_FRAME_LEN;
+  record_put (&current_key, CACHE_KEY_LEN);
+  record_put64 ((uint64_t) UCON64_UNKNOWN);     // padded
+  record_put32 (nfo ? CACHE_HAS_NFO : 0);
+  record_put64 (p->fsize);
+  record_put32 ((uint32_t) p->console);
+  record_put32 ((uint32_t) p->split);
+  record_put32 (p->crc32);
+  record_put32 (p->fcrc32);
+  if (nfo)
+    {
+      record_put32 ((uint32_t) nfo->interleaved);
+      record_put64 (nfo->data_size);
+      record_put32 ((uint32_t) nfo->backup_header_start);
+      record_put32 (nfo->backup_header_len);
+      record_put32 ((uint32_t) nfo->header_start);
+      record_put32 (nfo->header_len);
+      record_put32 ((uint32_t) nfo->has_internal_crc);
+      record_put32 (nfo->current_internal_crc);
+      record_put32 (nfo->internal_crc);
+      record_put32 ((uint32_t) nfo->internal_crc_start);
+      record_put32 (nfo->internal_crc_len);
+      record_put_str (nfo->console_usage);
+      record_put_str (nfo->backup_usage);
+      record_put_str (nfo->maker);
+      record_put_str (nfo->country);
+      record_put_str (nfo->name);
+      record_put_str (nfo->misc);
+      record_put_str (nfo->internal_crc2);
+      record_put_bytes (nfo->backup_header, nfo->backup_header_len);
+      record_put_bytes (nfo->header, nfo->header_len);
+    }
+  if (record_len - CACHE_FRAME_LEN > CACHE_MAX_RECORD_LEN)
+    {
+      record_len = 0;
+      return;
+    }
+  record_valid = record_pending = 1;
+}
+
+
+int64_t
+ucon64_cache_testpad (const char *fname)
+{
+  unsigned char *p = record + CACHE_FRAME_LEN + CACHE_KEY_LEN;
+  int64_t padded;
+  uint32_t flags;
+
+  if (!record_valid || strcmp (fname, current_fname))
+    return ucon64_testpad (fname);
+
+  memcpy (&flags, p + 8, 4);
+  if (flags & CACHE_HAS_PADDED)
+    {
+      memcpy (&padded, p, 8);
+      return padded;
+    }
+  padded = ucon64_testpad (fname);
+  flags |= CACHE_HAS_PADDED;
+  memcpy (p, &padded, 8);
+  memcpy (p + 8, &flags, 4);
+  record_pending = 1;                           // (re)write the record
+  return padded;
+}
@@ -0,0 +1,63 @@
+/*
+ucon64_cache.h - persistent cache of ROM scan results
+
+Copyright (c) 2026 uCON64 developers
+
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+#ifndef UCON64_CACHE_H
+#define UCON64_CACHE_H
+
+#ifdef  HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "misc/itypes.h"
+#include "ucon64.h"
+
+
+/*
+  The scan cache stores what ucon64_rom_handling() found out about a file
+  (console type, CRC32 values and the contents of st_ucon64_nfo_t) under the
+  identity of the file: device, inode, size and modification time. A file that
+  has not changed since it was last scanned with the same switches is served
+  from the cache, so that it doesn't have to be read again. The DAT lookup is
+  not cached, because it is cheap and the DAT files may have changed.
+
+  The cache file is an append-only log of records. New and updated records are
+  appended with one write each, so that the worker processes of --jobs can
+  share the file. Superseded records are removed when the file is rewritten
+  by ucon64_cache_close().
+
+  ucon64_cache_open()    enable the cache stored in fname; settings is a hash
+                           of everything besides the file that influences the
+                           scan result; if rescan is non-zero no file is served
+                           from the cache, but the results are still stored
+  ucon64_cache_close()   write pending data and compact the cache file if
+                           that is worthwhile
+  ucon64_cache_lookup()  fill in p (console, split, crc32, fcrc32, nfo) from
+                           the cache and return 1 if p->fname is in the cache,
+                           otherwise return 0
+  ucon64_cache_store()   store the scan result in p as the result for p->fname
+  ucon64_cache_testpad() ucon64_testpad() for the current file; the result is
+                           stored in or served from its cache entry
+*/
+extern void ucon64_cache_open (const char *fname, uint32_t settings, int rescan);
+extern void ucon64_cache_close (void);
+extern int ucon64_cache_lookup (st_ucon64_t *p);
+extern void ucon64_cache_store (const st_ucon64_t *p);
+extern int64_t ucon64_cache_testpad (const char *fname);
+
+#endif // UCON64_CACHE_H
@@ -32,6 +32,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include <io.h>
 #pragma warning(pop)
 #endif
+#include <ctype.h>
 #include <stdlib.h>
 #ifdef  HAVE_UNISTD_H
 #include <unistd.h>
@@ -56,6 +57,9 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
+#if     defined HAVE_MMAP && defined HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include "misc/archive.h"
 #include "misc/file.h"
 #include "misc/misc.h"
@@ -87,7 +91,10 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #define MAX_FIELDS_IN_DAT 32
 #define DAT_FIELD_SEPARATOR (0xac)
 #define DAT_FIELD_SEPARATOR_S "\xac"
-#define MAX_GAMES_FOR_CONSOLE 50000             // TODO?: dynamic size
+#define MAX_GAMES_FOR_CONSOLE 50000             // TODO?: dynamic size (-mkdat)
+#define DAT_FORMAT_ROMCENTER 0
+#define DAT_FORMAT_LOGIQX 1
+#define DAT_FORMAT_CLRMAMEPRO 2
 
 #ifdef  _MSC_VER
 #pragma warning(push)
@@ -120,6 +127,50 @@ typedef struct
   uint32_t crc32;
   char *fname;
 } st_mkdat_entry_t;
+
+typedef struct
+{
+  char *fname;                                  // DAT file with path
+  int8_t console;                               // console according to fname
+  st_ucon64_dat_t *header;                      // author, version etc. (read on first use)
+} st_dat_index_file_t;
+
+typedef struct
+{
+  uint32_t crc32;                               // 0 => empty slot
+  int dat;                                      // index in dat_index.files
+  long filepos;
+} st_dat_index_entry_t;
+
+typedef struct
+{
+  int built;
+  int n_files;
+  st_dat_index_file_t *files;
+  uint32_t mask;                                // number of slots - 1
+  st_dat_index_entry_t *entries;
+} st_dat_index_t;
+
+typedef struct
+{
+  char fname[FILENAME_MAX];                     // DAT file with path
+  int format;                                   // DAT_FORMAT_*
+  const char *data;                             // image of a Logiqx XML or ClrMamePro DAT file
+  size_t size;
+  int mapped;                                   // data was created by mmap()
+  size_t pos;                                   // parse position
+  size_t game;                                  // start of the current game
+  size_t game_end;                              // end of the current game (0 => not in a game)
+  char game_name[256];
+} st_dat_text_t;
+
+typedef struct
+{
+  size_t game;                                  // file position of the game
+  char name[FILENAME_MAX];                      // file name of the ROM
+  uint32_t crc32;
+  uint32_t size;
+} st_dat_rom_t;
 #ifdef  _MSC_VER
 #pragma warning(pop)
 #endif
@@ -130,10 +181,12 @@ static DIR *ddat = NULL;
 static HANDLE ddat = NULL;
 #endif
 static FILE *fdat = NULL;
-static int ucon64_n_files = 0, filepos_line = 0;
+static int ucon64_n_files = 0;
 static FILE *ucon64_datfile;
 static char ucon64_dat_fname[FILENAME_MAX];
 static st_mkdat_entry_t *ucon64_mkdat_entries = NULL;
+static st_dat_index_t dat_index = { 0, 0, NULL, 0, NULL };
+static st_dat_text_t dat_text;
 
 
 static st_ucon64_obj_t ucon64_dat_obj[] =
@@ -281,16 +334,16 @@ get_next_file (char *fname)
 #ifndef _WIN32
   struct dirent *ep;
 
-  if (!ddat && !(ddat = opendir(ucon64.datdir)))
+  if (!ddat && !(ddat = opendir(ucon64_settings.datdir)))
     {
-      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ucon64.datdir);
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ucon64_settings.datdir);
       return NULL;
     }
   while ((ep = readdir (ddat)) != NULL)
     if (!stricmp (get_suffix (ep->d_name), ".dat"))
       {
         snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s",
-                  ucon64.datdir, ep->d_name);
+                  ucon64_settings.datdir, ep->d_name);
         fname[FILENAME_MAX - 1] = '\0';
         return fname;
       }
@@ -303,28 +356,28 @@ get_next_file (char *fname)
 
       // NOTE: FindFirstFile() & FindNextFile() are case insensitive.
       snprintf (search_pattern, FILENAME_MAX, "%s" DIR_SEPARATOR_S "*.dat",
-                ucon64.datdir);
+                ucon64_settings.datdir);
       search_pattern[FILENAME_MAX - 1] = '\0';
       if ((ddat = FindFirstFile (search_pattern, &find_data)) == INVALID_HANDLE_VALUE)
         {
           // Not being able to find a DAT file is not a real error.
           if (GetLastError () != ERROR_FILE_NOT_FOUND)
             {
-              fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ucon64.datdir);
+              fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], ucon64_settings.datdir);
               return NULL;
             }
         }
       else
         {
           snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s",
-                    ucon64.datdir, find_data.cFileName);
+                    ucon64_settings.datdir, find_data.cFileName);
           fname[FILENAME_MAX - 1] = '\0';
           return fname;
         }
     }
   else if (FindNextFile (ddat, &find_data))
     {
-      snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64.datdir,
+      snprintf (fname, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s", ucon64_settings.datdir,
                 find_data.cFileName);
       fname[FILENAME_MAX - 1] = '\0';
       return fname;
@@ -335,12 +388,22 @@ get_next_file (char *fname)
 }
 
 
+static int dat_text_open (const char *fname);
+static void dat_text_header (st_ucon64_dat_t *dat);
+
+
 static st_ucon64_dat_t *
 get_dat_header (char *fname, st_ucon64_dat_t *dat)
 {
   const char *p;
   size_t len;
 
+  if (dat_text_open (fname) != DAT_FORMAT_ROMCENTER)
+    {
+      dat_text_header (dat);
+      return dat;
+    }
+
   p = get_property (fname, "author", PROPERTY_MODE_TEXT);
   if (!p)
     p = "Unknown";
@@ -432,6 +495,23 @@ fname_to_console (const char *fname, st_ucon64_dat_t *dat, int warning)
       {"CDi", custom_stristr, UCON64_CDI, cdi_usage},
       {"Xbox", custom_stristr, UCON64_XBOX, xbox_usage},
       {"CD32", custom_stristr, UCON64_CD32, cd32_usage},
+      // No-Intro style names (e.g., "Nintendo - Super Nintendo Entertainment System")
+      {"Super Nintendo", custom_stristr, UCON64_SNES, snes_usage},
+      {"Disk System", custom_stristr, UCON64_NES, nes_usage},
+      {"Nintendo Entertainment System", custom_stristr, UCON64_NES, nes_usage},
+      {"Game Boy Advance", custom_stristr, UCON64_GBA, gba_usage},
+      {"Game Boy", custom_stristr, UCON64_GB, gb_usage},
+      {"Nintendo 64", custom_stristr, UCON64_N64, n64_usage},
+      {"Virtual Boy", custom_stristr, UCON64_VBOY, vboy_usage},
+      {"Mega Drive", custom_stristr, UCON64_GEN, genesis_usage},
+      {"Genesis", custom_stristr, UCON64_GEN, genesis_usage},
+      {"Master System", custom_stristr, UCON64_SMS, sms_usage},
+      {"Game Gear", custom_stristr, UCON64_SMS, sms_usage},
+      {"PC Engine", custom_stristr, UCON64_PCE, pce_usage},
+      {"Neo Geo Pocket", custom_stristr, UCON64_NGP, ngp_usage},
+      {"Jaguar", custom_stristr, UCON64_JAG, jaguar_usage},
+      {"Lynx", custom_stristr, UCON64_LYNX, lynx_usage},
+      {"Atari - ", custom_strnicmp, UCON64_ATA, atari_usage},
 /* TODO:
       {"psx", custom_stristr, UCON64_PSX, psx_usage},
       {"ps1", custom_stristr, UCON64_PSX, psx_usage},
@@ -498,8 +578,8 @@ reset_dat (st_ucon64_dat_t *dat)
 
 
 static st_ucon64_dat_t *
-line_to_dat (const char *fname, const char *dat_entry, st_ucon64_dat_t *dat)
-// parse a dat entry into st_ucon64_dat_t
+set_dat_info (st_ucon64_dat_t *dat)
+// set the fields of dat that are derived from its name and DAT file name
 {
   static const char *dat_country[28][2] =
     {
@@ -539,38 +619,7 @@ line_to_dat (const char *fname, const char *dat_entry, st_ucon64_dat_t *dat)
       {"(F)", "France"},
       {NULL, NULL}
     };
-  char *dat_field[MAX_FIELDS_IN_DAT + 2] = { NULL }, buf[MAXBUFSIZE], *p = NULL;
-
-  if ((unsigned char) dat_entry[0] != DAT_FIELD_SEPARATOR)
-    return NULL;
-
-  strcpy (buf, dat_entry);
-  strarg (dat_field, buf, DAT_FIELD_SEPARATOR_S, MAX_FIELDS_IN_DAT);
-  reset_dat (dat);
-  strcpy (dat->datfile, basename2 (fname));
-
-  if (dat_field[3])
-    {
-      size_t len = strnlen (dat_field[3], sizeof dat->name - 1);
-
-      strncpy (dat->name, dat_field[3], len)[len] = '\0';
-    }
-
-  if (dat_field[4])
-    {
-      size_t len = strnlen (dat_field[4], sizeof dat->fname - 1);
-
-      strncpy (dat->fname, dat_field[4], len)[len] = '\0';
-    }
-
-  if (dat_field[5])
-    sscanf (dat_field[5], "%x", &dat->crc32);
-
-  if (dat_field[6][0] == 'N' && dat_field[7][0] == 'O')
-    // e.g. GoodSNES bad crc & Nintendo FDS DAT
-    sscanf (dat_field[8], "%d", (int *) &dat->fsize);
-  else
-    sscanf (dat_field[6], "%d", (int *) &dat->fsize);
+  char buf[MAXBUFSIZE], *p = NULL;
 
   *buf = '\0';
   {
@@ -623,6 +672,47 @@ line_to_dat (const char *fname, const char *dat_entry, st_ucon64_dat_t *dat)
 }
 
 
+static st_ucon64_dat_t *
+line_to_dat (const char *fname, const char *dat_entry, st_ucon64_dat_t *dat)
+// parse a dat entry into st_ucon64_dat_t
+{
+  char *dat_field[MAX_FIELDS_IN_DAT + 2] = { NULL }, buf[MAXBUFSIZE];
+
+  if ((unsigned char) dat_entry[0] != DAT_FIELD_SEPARATOR)
+    return NULL;
+
+  strcpy (buf, dat_entry);
+  strarg (dat_field, buf, DAT_FIELD_SEPARATOR_S, MAX_FIELDS_IN_DAT);
+  reset_dat (dat);
+  strcpy (dat->datfile, basename2 (fname));
+
+  if (dat_field[3])
+    {
+      size_t len = strnlen (dat_field[3], sizeof dat->name - 1);
+
+      strncpy (dat->name, dat_field[3], len)[len] = '\0';
+    }
+
+  if (dat_field[4])
+    {
+      size_t len = strnlen (dat_field[4], sizeof dat->fname - 1);
+
+      strncpy (dat->fname, dat_field[4], len)[len] = '\0';
+    }
+
+  if (dat_field[5])
+    sscanf (dat_field[5], "%x", &dat->crc32);
+
+  if (dat_field[6][0] == 'N' && dat_field[7][0] == 'O')
+    // e.g. GoodSNES bad crc & Nintendo FDS DAT
+    sscanf (dat_field[8], "%d", (int *) &dat->fsize);
+  else
+    sscanf (dat_field[6], "%d", (int *) &dat->fsize);
+
+  return set_dat_info (dat);
+}
+
+
 uint32_t
 line_to_crc (const char *dat_entry)
 // get CRC32 value of current line
@@ -644,11 +734,587 @@ line_to_crc (const char *dat_entry)
 }
 
 
+/*
+  Logiqx XML and ClrMamePro DAT files
+  These are parsed directly from an image of the file (mapped into memory if
+  possible), without building a tree. Their entries are games that can contain
+  several ROMs. Every ROM is an entry of the index, with the file position of
+  the game it belongs to.
+*/
+static void
+dat_text_close (void)
+{
+  if (dat_text.data)
+    {
+#if     defined HAVE_MMAP && defined HAVE_SYS_MMAN_H
+      if (dat_text.mapped)
+        munmap ((void *) dat_text.data, dat_text.size);
+      else
+#endif
+        free ((void *) dat_text.data);
+    }
+  memset (&dat_text, 0, sizeof dat_text);
+}
+
+
+static int
+dat_text_open (const char *fname)
+// returns the format of DAT file fname (DAT_FORMAT_*) and for Logiqx XML and
+//  ClrMamePro DAT files makes it the file that the dat_text functions work on
+{
+  static int registered = 0;
+  char buf[512];
+  const char *p;
+  FILE *file;
+  size_t n;
+
+  if (dat_text.fname[0] && !strcmp (dat_text.fname, fname))
+    return dat_text.format;
+
+  dat_text_close ();
+  if (!registered)
+    registered = !register_func (dat_text_close);
+  if ((file = fopen (fname, "rb")) == NULL)
+    return DAT_FORMAT_ROMCENTER;                // let get_dat_entry() report it
+  n = fread (buf, 1, sizeof buf - 1, file);
+  buf[n] = '\0';
+
+  p = buf;
+  if (!memcmp (p, "\xef\xbb\xbf", 3))           // UTF-8 BOM
+    p += 3;
+  while (isspace ((int) *p))
+    p++;
+  if (*p == '<')
+    dat_text.format = DAT_FORMAT_LOGIQX;
+  else if (!strnicmp (p, "clrmamepro", 10))
+    dat_text.format = DAT_FORMAT_CLRMAMEPRO;
+  else
+    dat_text.format = DAT_FORMAT_ROMCENTER;
+  strcpy (dat_text.fname, fname);
+
+  if (dat_text.format != DAT_FORMAT_ROMCENTER)
+    {
+      struct stat fstate;
+
+      if (fstat (fileno (file), &fstate) || fstate.st_size <= 0 ||
+          (uint64_t) fstate.st_size >= (size_t) -1)
+        dat_text.format = DAT_FORMAT_ROMCENTER;
+      else
+        {
+          dat_text.size = (size_t) fstate.st_size;
+#if     defined HAVE_MMAP && defined HAVE_SYS_MMAN_H
+          {
+            void *data = mmap (NULL, dat_text.size, PROT_READ, MAP_PRIVATE,
+                               fileno (file), 0);
+            if (data != MAP_FAILED)
+              {
+                dat_text.data = (const char *) data;
+                dat_text.mapped = 1;
+              }
+          }
+#endif
+          if (!dat_text.data)
+            {
+              char *data = (char *) malloc (dat_text.size);
+
+              if (!data)
+                fprintf (stderr, ucon64_msg[BUFFER_ERROR], dat_text.size);
+              else if (fseek (file, 0, SEEK_SET) ||
+                       fread (data, 1, dat_text.size, file) != dat_text.size)
+                {
+                  fprintf (stderr, ucon64_msg[READ_ERROR], fname);
+                  free (data);
+                }
+              else
+                dat_text.data = data;
+            }
+          if (!dat_text.data)
+            dat_text.size = 0;                  // no entries
+        }
+    }
+  fclose (file);
+
+  return dat_text.format;
+}
+
+
+static void
+dat_text_copy (char *dest, size_t dest_size, const char *p, const char *end,
+               int xml)
+// copy the text between p and end to dest, decoding XML entities if xml != 0
+{
+  static const char *entities[][2] =
+    {
+      {"&amp;", "&"}, {"&lt;", "<"}, {"&gt;", ">"}, {"&quot;", "\""},
+      {"&apos;", "'"}, {NULL, NULL}
+    };
+  size_t n = 0;
+
+  while (p < end && n < dest_size - 1)
+    {
+      if (xml && *p == '&')
+        {
+          int i;
+
+          for (i = 0; entities[i][0]; i++)
+            {
+              size_t len = strlen (entities[i][0]);
+
+              if ((size_t) (end - p) >= len && !memcmp (p, entities[i][0], len))
+                {
+                  dest[n++] = *entities[i][1];
+                  p += len;
+                  break;
+                }
+            }
+          if (entities[i][0])
+            continue;
+          if (p[1] == '#' && end - p > 3)
+            {
+              const char *q = p + 2;
+              unsigned long c = *q == 'x' ? strtoul (q + 1, (char **) &q, 16) :
+                                              strtoul (q, (char **) &q, 10);
+
+              if (q < end && *q == ';' && c > 0 && c < 256)
+                {
+                  dest[n++] = (char) c;
+                  p = q + 1;
+                  continue;
+                }
+            }
+        }
+      dest[n++] = *p++;
+    }
+  dest[n] = '\0';
+}
+
+
+static int
+dat_xml_is_tag (const char *p, const char *end, const char *name)
+// returns 1 if the tag whose '<' precedes p is called name
+{
+  size_t len = strlen (name);
+
+  return (size_t) (end - p) > len && !memcmp (p, name, len) &&
+         (isspace ((int) p[len]) || p[len] == '>' || p[len] == '/');
+}
+
+
+static const char *
+dat_xml_tag (const char *p, const char *end, const char *name)
+// returns the start of the next tag <name (or </name if name starts with '/')
+{
+  while ((p = (const char *) memchr (p, '<', end - p)) != NULL)
+    if (dat_xml_is_tag (++p, end, name))
+      return p - 1;
+  return NULL;
+}
+
+
+static const char *
+dat_xml_game (const char *p, const char *end, int *is_machine)
+// returns the start of the next <game or <machine tag
+{
+  while ((p = (const char *) memchr (p, '<', end - p)) != NULL)
+    {
+      p++;
+      if ((*is_machine = dat_xml_is_tag (p, end, "machine")) != 0 ||
+          dat_xml_is_tag (p, end, "game"))
+        return p - 1;
+    }
+  return NULL;
+}
+
+
+static const char *
+dat_xml_tag_end (const char *p, const char *end)
+// returns the position of the '>' that ends the tag that starts at p
+{
+  char quote = 0;
+
+  for (; p < end; p++)
+    if (quote)
+      {
+        if (*p == quote)
+          quote = 0;
+      }
+    else if (*p == '"' || *p == '\'')
+      quote = *p;
+    else if (*p == '>')
+      return p;
+  return end;
+}
+
+
+static int
+dat_xml_attr (const char *tag, const char *tag_end, const char *name,
+              char *dest, size_t dest_size)
+// get the value of attribute name of the tag that starts at tag
+{
+  size_t len = strlen (name);
+  const char *p = tag + 1;
+
+  while (p < tag_end && !isspace ((int) *p))    // skip tag name
+    p++;
+  while (p < tag_end)
+    {
+      const char *attr, *value;
+      char quote;
+
+      while (p < tag_end && isspace ((int) *p))
+        p++;
+      attr = p;
+      while (p < tag_end && *p != '=' && !isspace ((int) *p))
+        p++;
+      while (p < tag_end && (isspace ((int) *p) || *p == '='))
+        p++;
+      if (p >= tag_end || (*p != '"' && *p != '\''))
+        break;
+      quote = *p++;
+      value = p;
+      while (p < tag_end && *p != quote)
+        p++;
+      if (!strncmp (attr, name, len) &&
+          (attr[len] == '=' || isspace ((int) attr[len])))
+        {
+          dat_text_copy (dest, dest_size, value, p, 1);
+          return 0;
+        }
+      p++;
+    }
+  *dest = '\0';
+  return -1;
+}
+
+
+static const char *
+dat_cmp_token (const char *p, const char *end, const char **token, size_t *len)
+/*
+  Returns the position after the next token of a ClrMamePro DAT file. token is
+  set to NULL if there are no more tokens. Parentheses are tokens on their own
+  and the quotes of quoted strings are not part of the token.
+*/
+{
+  while (p < end && isspace ((int) *p))
+    p++;
+  if (p >= end)
+    {
+      *token = NULL;
+      *len = 0;
+      return end;
+    }
+  if (*p == '"')
+    {
+      *token = ++p;
+      while (p < end && *p != '"')
+        p++;
+      *len = p - *token;
+      return p < end ? p + 1 : end;
+    }
+  *token = p;
+  if (*p == '(' || *p == ')')
+    p++;
+  else
+    while (p < end && !isspace ((int) *p) && *p != '(' && *p != ')')
+      p++;
+  *len = p - *token;
+  return p;
+}
+
+
+#define DAT_CMP_IS(t, l, s) ((l) == sizeof (s) - 1 && !strnicmp ((t), (s), (l)))
+
+
+static const char *
+dat_cmp_block_end (const char *p, const char *end)
+// returns the position of the ')' that closes the block whose '(' precedes p
+{
+  int depth = 1;
+
+  while (p < end)
+    {
+      const char *token;
+      size_t len;
+      const char *next = dat_cmp_token (p, end, &token, &len);
+
+      if (!token)
+        break;
+      if (len == 1 && *token == '(' && token[-1] != '"')
+        depth++;
+      else if (len == 1 && *token == ')' && token[-1] != '"' && --depth == 0)
+        return token;
+      p = next;
+    }
+  return end;
+}
+
+
+static void
+dat_cmp_value (const char *p, const char *end, const char *key, char *dest,
+               size_t dest_size)
+// get the value of key in the block between p and end (not in nested blocks)
+{
+  int depth = 0;
+
+  *dest = '\0';
+  while (p < end)
+    {
+      const char *token, *value;
+      size_t len, value_len;
+
+      p = dat_cmp_token (p, end, &token, &len);
+      if (!token)
+        break;
+      if (len == 1 && (*token == '(' || *token == ')') && token[-1] != '"')
+        {
+          depth += *token == '(' ? 1 : -1;
+          continue;
+        }
+      if (depth || len != strlen (key) || strnicmp (token, key, len))
+        continue;
+      dat_cmp_token (p, end, &value, &value_len);
+      if (value)
+        dat_text_copy (dest, dest_size, value, value + value_len, 0);
+      return;
+    }
+}
+
+
+static int
+dat_text_next_rom (st_dat_rom_t *rom)
+// get the next ROM of the DAT file opened by dat_text_open(); returns 0 at the end
+{
+  const char *data = dat_text.data, *end = data + dat_text.size;
+  char buf[32];
+
+  if (!data)
+    return 0;
+  for (;;)
+    {
+      const char *p = data + dat_text.pos;
+
+      if (!dat_text.game_end)                   // find the next game
+        {
+          if (dat_text.format == DAT_FORMAT_LOGIQX)
+            {
+              int is_machine;
+              const char *game = dat_xml_game (p, end, &is_machine), *tag_end,
+                         *game_end;
+
+              if (!game)
+                return 0;
+              tag_end = dat_xml_tag_end (game, end);
+              dat_xml_attr (game, tag_end, "name", dat_text.game_name,
+                            sizeof dat_text.game_name);
+              if (tag_end < end && tag_end[-1] == '/') // <game ... />
+                game_end = tag_end;
+              else if ((game_end = dat_xml_tag (tag_end, end,
+                                                is_machine ? "/machine" : "/game")) == NULL)
+                game_end = end;
+              dat_text.game = game - data;
+              dat_text.game_end = game_end - data;
+              dat_text.pos = (tag_end < end ? tag_end + 1 : end) - data;
+            }
+          else
+            {
+              const char *token, *paren;
+              size_t len, paren_len;
+
+              p = dat_cmp_token (p, end, &token, &len);
+              if (!token)
+                return 0;
+              p = dat_cmp_token (p, end, &paren, &paren_len);
+              if (!paren || paren_len != 1 || *paren != '(')
+                {
+                  dat_text.pos = (paren ? paren : end) - data;
+                  continue;
+                }
+              dat_text.pos = dat_cmp_block_end (p, end) - data;
+              if (!DAT_CMP_IS (token, len, "game") &&
+                  !DAT_CMP_IS (token, len, "machine") &&
+                  !DAT_CMP_IS (token, len, "resource"))
+                {
+                  if (dat_text.pos < dat_text.size)
+                    dat_text.pos++;             // skip the ')'
+                  continue;
+                }
+              dat_text.game = token - data;
+              dat_text.game_end = dat_text.pos;
+              dat_text.pos = p - data;
+              dat_cmp_value (p, data + dat_text.game_end, "name",
+                             dat_text.game_name, sizeof dat_text.game_name);
+            }
+          continue;
+        }
+
+      // find the next ROM of the current game
+      if (dat_text.format == DAT_FORMAT_LOGIQX)
+        {
+          const char *game_end = data + dat_text.game_end,
+                     *tag = dat_xml_tag (p, game_end, "rom"), *tag_end;
+
+          if (!tag)
+            {
+              dat_text.pos = dat_text.game_end;
+              dat_text.game_end = 0;
+              continue;
+            }
+          tag_end = dat_xml_tag_end (tag, game_end);
+          dat_text.pos = tag_end - data;
+          if (dat_xml_attr (tag, tag_end, "crc", buf, sizeof buf))
+            continue;                           // "nodump" ROMs have no CRC32
+          rom->crc32 = (uint32_t) strtoul (buf, NULL, 16);
+          dat_xml_attr (tag, tag_end, "size", buf, sizeof buf);
+          rom->size = (uint32_t) strtoul (buf, NULL, 10);
+          dat_xml_attr (tag, tag_end, "name", rom->name, sizeof rom->name);
+        }
+      else
+        {
+          const char *game_end = data + dat_text.game_end, *token, *paren,
+                     *rom_end;
+          size_t len, paren_len;
+
+          p = dat_cmp_token (p, game_end, &token, &len);
+          if (!token)
+            {
+              dat_text.pos = dat_text.game_end < dat_text.size ?
+                               dat_text.game_end + 1 : dat_text.size;
+              dat_text.game_end = 0;
+              continue;
+            }
+          dat_text.pos = p - data;
+          if (!DAT_CMP_IS (token, len, "rom"))
+            {
+              if (len == 1 && *token == '(')    // skip other blocks
+                dat_text.pos = dat_cmp_block_end (p, game_end) + 1 - data;
+              continue;
+            }
+          p = dat_cmp_token (p, game_end, &paren, &paren_len);
+          if (!paren || paren_len != 1 || *paren != '(')
+            continue;
+          rom_end = dat_cmp_block_end (p, game_end);
+          dat_text.pos = (rom_end < game_end ? rom_end + 1 : game_end) - data;
+          dat_cmp_value (p, rom_end, "crc", buf, sizeof buf);
+          if (!buf[0])
+            continue;
+          rom->crc32 = (uint32_t) strtoul (buf, NULL, 16);
+          dat_cmp_value (p, rom_end, "size", buf, sizeof buf);
+          rom->size = (uint32_t) strtoul (buf, NULL, 10);
+          dat_cmp_value (p, rom_end, "name", rom->name, sizeof rom->name);
+        }
+      rom->game = dat_text.game;
+      return 1;
+    }
+}
+
+
+static st_ucon64_dat_t *
+rom_to_dat (const char *fname, const st_dat_rom_t *rom, st_ucon64_dat_t *dat)
+{
+  reset_dat (dat);
+  strcpy (dat->datfile, basename2 (fname));
+  strcpy (dat->name, dat_text.game_name);       // same sizes
+  strcpy (dat->fname, rom->name);
+  dat->crc32 = rom->crc32;
+  dat->fsize = rom->size;
+
+  return set_dat_info (dat);
+}
+
+
+static void
+dat_text_header (st_ucon64_dat_t *dat)
+// get the header of the DAT file opened by dat_text_open()
+{
+  static const char *fields[][2] =
+    {
+      {"author", "Unknown"}, {"version", "?"}, {"name", ""}, {"comment", ""},
+      {"date", "?"}, {NULL, NULL}
+    };
+  char *dest[5];
+  size_t dest_size[5];
+  const char *p = dat_text.data, *end = p + dat_text.size;
+  int i;
+
+  dest[0] = dat->author;
+  dest_size[0] = sizeof dat->author;
+  dest[1] = dat->version;
+  dest_size[1] = sizeof dat->version;
+  dest[2] = dat->refname;
+  dest_size[2] = sizeof dat->refname;
+  dest[3] = dat->comment;
+  dest_size[3] = sizeof dat->comment;
+  dest[4] = dat->date;
+  dest_size[4] = sizeof dat->date;
+
+  if (p && dat_text.format == DAT_FORMAT_LOGIQX)
+    {
+      const char *header = dat_xml_tag (p, end, "header"), *header_end;
+
+      if (header && (header_end = dat_xml_tag (header, end, "/header")) != NULL)
+        {
+          p = header;
+          end = header_end;
+        }
+      else
+        p = NULL;
+    }
+  else if (p)
+    {
+      const char *token;
+      size_t len;
+
+      p = dat_cmp_token (p, end, &token, &len);       // "clrmamepro"
+      p = dat_cmp_token (p, end, &token, &len);       // '('
+      end = dat_cmp_block_end (p, end);
+    }
+
+  for (i = 0; fields[i][0]; i++)
+    {
+      *dest[i] = '\0';
+      if (p && dat_text.format == DAT_FORMAT_LOGIQX)
+        {
+          char tag_name[16];
+          const char *tag = dat_xml_tag (p, end, fields[i][0]), *text;
+
+          if (tag && *(text = dat_xml_tag_end (tag, end)) == '>' &&
+              text[-1] != '/')
+            {
+              const char *text_end;
+
+              sprintf (tag_name, "/%s", fields[i][0]);
+              if ((text_end = dat_xml_tag (text, end, tag_name)) != NULL)
+                dat_text_copy (dest[i], dest_size[i], text + 1, text_end, 1);
+            }
+        }
+      else if (p)
+        dat_cmp_value (p, end, fields[i][0], dest[i], dest_size[i]);
+      if (!*dest[i])
+        strcpy (dest[i], fields[i][1]);
+    }
+}
+
+
 static st_ucon64_dat_t *
 get_dat_entry (char *fname, st_ucon64_dat_t *dat, uint32_t crc32, long start)
 {
   char buf[MAXBUFSIZE];
 
+  if (dat_text_open (fname) != DAT_FORMAT_ROMCENTER)
+    {
+      st_dat_rom_t rom;
+
+      if (start >= 0)
+        {
+          dat_text.pos = (size_t) start;
+          dat_text.game_end = 0;
+        }
+      while (dat_text_next_rom (&rom))
+        if (!crc32 || rom.crc32 == crc32)
+          return rom_to_dat (fname, &rom, dat);
+      return NULL;
+    }
+
   if (!fdat && (fdat = fopen (fname, "rb")) == NULL)
     {
       fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], fname);
@@ -663,14 +1329,12 @@ get_dat_entry (char *fname, st_ucon64_dat_t *dat, uint32_t crc32, long start)
   if (start >= 0)
     fseek (fdat, start, SEEK_SET);
 
-  filepos_line = ftell (fdat);
   while (fgets (buf, MAXBUFSIZE, fdat) != NULL)
     {
       if ((unsigned char) buf[0] == DAT_FIELD_SEPARATOR &&
           (!crc32 || line_to_crc (buf) == crc32) &&
           line_to_dat (fname, buf, dat))
         return dat;
-      filepos_line = ftell (fdat);
     }
 
   fclose_fdat ();
@@ -867,7 +1531,7 @@ ucon64_dat_total_entries (void)
   uint32_t entries = 0;
   char fname[FILENAME_MAX];
 
-  if (!ucon64.dat_enabled)
+  if (!ucon64_settings.dat_enabled)
     return 0;
 
   while (get_next_file (fname))
@@ -897,92 +1561,263 @@ idx_compare (const void *key, const void *found)
 }
 
 
-st_ucon64_dat_t *
-ucon64_dat_search (uint32_t crc32)
+static void
+dat_index_free (void)
 {
-  char fname_dat[FILENAME_MAX];
-  static st_ucon64_dat_t dat;
+  int n;
 
-  if (!crc32)
-    return NULL;
+  for (n = 0; n < dat_index.n_files; n++)
+    {
+      free (dat_index.files[n].fname);
+      free (dat_index.files[n].header);
+    }
+  free (dat_index.files);
+  free (dat_index.entries);
+  memset (&dat_index, 0, sizeof dat_index);
+}
 
-  reset_dat (&dat);
+
+static void
+dat_index_build (void)
+/*
+  Merge the index files of all DAT files into one hash table (open addressing
+  with linear probing), so that ucon64_dat_search() doesn't have to read every
+  index file again for every ROM. An entry for a CRC32 value that is present in
+  several DAT files is stored after those of DAT files that were found earlier,
+  so that lookups give the same result as a search through the DAT files in
+  directory order.
+*/
+{
+  char fname_dat[FILENAME_MAX];
+  size_t n_slots = 1024, n_entries = 0;
+  int n;
+
+  dat_index.built = 1;
+  register_func (dat_index_free);
 
   while (get_next_file (fname_dat))
     {
       char fname_index[FILENAME_MAX];
-      unsigned char *p;
-      size_t fsize;
-      st_idx_entry_t *idx_entry, key;
-      const char *fname = basename2 (fname_dat);
-
-      if (ucon64.console != UCON64_UNKNOWN &&
-          fname_to_console (fname, &dat, 0) != ucon64.console)
-        continue;
+      st_dat_index_file_t *file;
+      st_ucon64_dat_t dat;
 
       strcpy (fname_index, fname_dat);
       set_suffix (fname_index, ".idx");
       if (access (fname_index, F_OK) != 0)      // for a "bad" DAT file
         continue;
-      fsize = (size_t) fsizeof (fname_index);
 
-      if ((p = (unsigned char *) malloc (fsize)) == NULL)
+      if (!(dat_index.n_files & 63))
         {
-          fprintf (stderr, ucon64_msg[BUFFER_ERROR], fsize);
-          closedir_ddat ();
-          return NULL;
+          st_dat_index_file_t *files = (st_dat_index_file_t *)
+            realloc (dat_index.files,
+                     (dat_index.n_files + 64) * sizeof (st_dat_index_file_t));
+          if (!files)
+            {
+              fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                       (dat_index.n_files + 64) * sizeof (st_dat_index_file_t));
+              closedir_ddat ();
+              return;
+            }
+          dat_index.files = files;
         }
+      file = &dat_index.files[dat_index.n_files++];
+      file->fname = strdup (fname_dat);
+      file->console = (int8_t) fname_to_console (basename2 (fname_dat), &dat, 0);
+      file->header = NULL;
+      n_entries += (size_t) fsizeof (fname_index) / sizeof (st_idx_entry_t);
+    }
 
-      // load the index for the current dat file
-      if (ucon64_fread (p, 0, fsize, fname_index) != fsize)
+  while (n_slots < 2 * n_entries)               // keep the load factor <= 0.5
+    n_slots <<= 1;
+  if ((dat_index.entries = (st_dat_index_entry_t *)
+         calloc (n_slots, sizeof (st_dat_index_entry_t))) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+               n_slots * sizeof (st_dat_index_entry_t));
+      return;
+    }
+  dat_index.mask = (uint32_t) (n_slots - 1);
+
+  for (n = 0; n < dat_index.n_files; n++)
+    {
+      char fname_index[FILENAME_MAX];
+      st_idx_entry_t *idx_entries;
+      size_t fsize, i;
+
+      strcpy (fname_index, dat_index.files[n].fname);
+      set_suffix (fname_index, ".idx");
+      fsize = (size_t) fsizeof (fname_index);
+      if ((idx_entries = (st_idx_entry_t *) malloc (fsize)) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], fsize);
+          continue;
+        }
+      if (ucon64_fread (idx_entries, 0, fsize, fname_index) != fsize)
         {
           fprintf (stderr, ucon64_msg[READ_ERROR], fname_index);
-          closedir_ddat ();
-          free (p);
-          return NULL;
+          free (idx_entries);
+          continue;
         }
 
-      // search index for CRC32 value
-      key.crc32 = crc32;
-      idx_entry = (st_idx_entry_t *) bsearch (&key, p, fsize / sizeof (st_idx_entry_t),
-                                              sizeof (st_idx_entry_t), idx_compare);
-      if (idx_entry)                            // CRC32 value found
+      for (i = 0; i < fsize / sizeof (st_idx_entry_t); i++)
+        {
+          uint32_t slot = idx_entries[i].crc32 & dat_index.mask;
+
+          if (!idx_entries[i].crc32)            // never searched for
+            continue;
+          while (dat_index.entries[slot].crc32)
+            slot = (slot + 1) & dat_index.mask;
+          dat_index.entries[slot].crc32 = idx_entries[i].crc32;
+          dat_index.entries[slot].dat = n;
+          dat_index.entries[slot].filepos = idx_entries[i].filepos;
+        }
+      free (idx_entries);
+    }
+}
+
+
+st_ucon64_dat_t *
+ucon64_dat_search (uint32_t crc32, int console)
+{
+  static st_ucon64_dat_t dat;
+  uint32_t slot;
+
+  if (!crc32)
+    return NULL;
+
+  if (!dat_index.built)
+    dat_index_build ();
+  if (!dat_index.entries)
+    return NULL;
+
+  reset_dat (&dat);
+
+  for (slot = crc32 & dat_index.mask; dat_index.entries[slot].crc32;
+       slot = (slot + 1) & dat_index.mask)
+    {
+      st_dat_index_entry_t *idx_entry = &dat_index.entries[slot];
+      st_dat_index_file_t *file = &dat_index.files[idx_entry->dat];
+
+      if (idx_entry->crc32 != crc32 ||
+          (console != UCON64_UNKNOWN && file->console != console))
+        continue;
+
+      // open dat file and read entry
+      if (get_dat_entry (file->fname, &dat, crc32, idx_entry->filepos) &&
+          crc32 == dat.crc32)
         {
-          // open dat file and read entry
-          if (get_dat_entry (fname_dat, &dat, crc32, idx_entry->filepos) &&
-              crc32 == dat.crc32)
+          fclose_fdat ();
+          if (!file->header &&
+              (file->header = (st_ucon64_dat_t *) malloc (sizeof (st_ucon64_dat_t))) != NULL)
+            get_dat_header (file->fname, file->header);
+          if (file->header)
             {
-              strcpy (dat.datfile, basename2 (fname_dat));
-              get_dat_header (fname_dat, &dat);
-              closedir_ddat ();
-              fclose_fdat ();
-              free (p);
-              update_fname_field (&dat);
-              return &dat;
+              strcpy (dat.author, file->header->author);
+              strcpy (dat.version, file->header->version);
+              strcpy (dat.refname, file->header->refname);
+              strcpy (dat.comment, file->header->comment);
+              strcpy (dat.date, file->header->date);
             }
-          fclose_fdat ();
+          update_fname_field (&dat);
+          return &dat;
         }
-      free (p);
+      fclose_fdat ();
     }
 
   return NULL;
 }
 
 
+static int
+idx_set_add (int **set, uint32_t *mask, const st_idx_entry_t *entries, int pos)
+/*
+  Hash set of the CRC32 values in entries (open addressing with linear
+  probing). The slots hold positions in entries plus 1 (0 means empty).
+  Returns the position of an earlier entry with the same CRC32 value as
+  entries[pos] or -1 if entries[pos] was added. The set grows so that it stays
+  at most half full.
+*/
+{
+  uint32_t slot;
+
+  if (!*set || (uint32_t) pos >= (*mask + 1) / 2)
+    {
+      uint32_t n_slots = *set ? (*mask + 1) * 2 : 1024;
+      int *new_set = (int *) calloc (n_slots, sizeof (int)), n;
+
+      if (!new_set)
+        {
+          fprintf (stderr, ucon64_msg[BUFFER_ERROR], n_slots * sizeof (int));
+          exit (1);
+        }
+      free (*set);
+      *set = new_set;
+      *mask = n_slots - 1;
+      for (n = 0; n < pos; n++)
+        {
+          for (slot = entries[n].crc32 & *mask; (*set)[slot];
+               slot = (slot + 1) & *mask)
+            ;
+          (*set)[slot] = n + 1;
+        }
+    }
+
+  for (slot = entries[pos].crc32 & *mask; (*set)[slot]; slot = (slot + 1) & *mask)
+    if (entries[(*set)[slot] - 1].crc32 == entries[pos].crc32)
+      return (*set)[slot] - 1;
+  (*set)[slot] = pos + 1;
+  return -1;
+}
+
+
+static int
+dat_next_crc (st_idx_entry_t *entry)
+/*
+  Get the CRC32 value and file position of the next entry of the DAT file that
+  is read by the indexer (fdat for RomCenter DAT files, otherwise the file
+  opened by dat_text_open()). Returns 0 at the end of the file.
+*/
+{
+  if (dat_text.format == DAT_FORMAT_ROMCENTER)
+    {
+      char buf[MAXBUFSIZE];
+      long filepos = ftell (fdat);
+
+      while (fgets (buf, MAXBUFSIZE, fdat) != NULL)
+        {
+          if ((unsigned char) buf[0] == DAT_FIELD_SEPARATOR)
+            {
+              entry->crc32 = line_to_crc (buf);
+              entry->filepos = filepos;
+              return 1;
+            }
+          filepos = ftell (fdat);
+        }
+    }
+  else
+    {
+      st_dat_rom_t rom;
+
+      if (dat_text_next_rom (&rom))
+        {
+          entry->crc32 = rom.crc32;
+          entry->filepos = (long) rom.game;
+          return 1;
+        }
+    }
+  return 0;
+}
+
+
 int
 ucon64_dat_indexer (void)
 // create or update index of DAT file
 {
   char fname_dat[FILENAME_MAX];
-  st_idx_entry_t *idx_entries;
-
-  if ((idx_entries = (st_idx_entry_t *)
-         malloc (MAX_GAMES_FOR_CONSOLE * sizeof (st_idx_entry_t))) == NULL)
-    {
-      fprintf (stderr, ucon64_msg[BUFFER_ERROR],
-               MAX_GAMES_FOR_CONSOLE * sizeof (st_idx_entry_t));
-      exit (1);
-    }
+  st_idx_entry_t *idx_entries = NULL, idx_entry,
+                 *duplicates = NULL;            // pairs of entries
+  int *idx_set = NULL, idx_entries_max = 0, n_duplicates_max = 0;
+  uint32_t idx_set_mask = 0;
 
   while (get_next_file (fname_dat))
     {
@@ -991,7 +1826,7 @@ ucon64_dat_indexer (void)
       st_ucon64_dat_t dat;
       FILE *errorfile = NULL;
       time_t start_time;
-      int update = 0, n_duplicates = 0, pos = 0;
+      int update = 0, n_duplicates = 0, pos = 0, n;
       size_t fsize;
       const char *fname = basename2 (fname_dat);
 
@@ -1012,68 +1847,104 @@ ucon64_dat_indexer (void)
       fsize = (size_t) fsizeof (fname_dat);
 
       printf ("%s: %s\n", (update ? "Update" : "Create"), basename2 (fname_index));
-      while (get_dat_entry (fname_dat, &dat, 0, -1))
+      if (dat_text_open (fname_dat) != DAT_FORMAT_ROMCENTER)
         {
-          int n;
-          st_idx_entry_t *idx_entry = NULL;
+          dat_text.pos = 0;
+          dat_text.game_end = 0;
+        }
+      else if ((fdat = fopen (fname_dat, "rb")) == NULL)
+        {
+          fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], fname_dat);
+          continue;
+        }
 
-          if (pos == MAX_GAMES_FOR_CONSOLE)
+      /*
+        Only the CRC32 value of each entry is needed, so don't parse complete
+        entries with get_dat_entry(). Duplicate CRC32 values are looked up in a
+        hash set. They are reported after the DAT file has been read.
+      */
+      while (dat_next_crc (&idx_entry))
+        {
+          int first;
+
+          if (pos == idx_entries_max)
             {
-              fprintf (stderr,
-                       "\n"
-                       "INTERNAL ERROR: MAX_GAMES_FOR_CONSOLE is too small (%d)\n",
-                       MAX_GAMES_FOR_CONSOLE);
-              break;
+              st_idx_entry_t *p = (st_idx_entry_t *)
+                realloc (idx_entries, (idx_entries_max ? idx_entries_max * 2 : 4096) *
+                                        sizeof (st_idx_entry_t));
+              if (!p)
+                {
+                  fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                           idx_entries_max * 2 * sizeof (st_idx_entry_t));
+                  exit (1);
+                }
+              idx_entries = p;
+              idx_entries_max = idx_entries_max ? idx_entries_max * 2 : 4096;
             }
+          idx_entries[pos] = idx_entry;
 
-          /*
-            Doing a linear search removes the need of using the slow qsort()
-            function inside the loop. Doing a binary search doesn't improve the
-            speed much, but is much more efficient of course. Using qsort()
-            inside the loop slows it down with a factor greater than 10.
-          */
-          for (n = 0; n < pos; n++)
-            if (idx_entries[n].crc32 == dat.crc32)
-              idx_entry = &idx_entries[n];
-          if (idx_entry)
+          if ((first = idx_set_add (&idx_set, &idx_set_mask, idx_entries, pos)) >= 0)
             {
-              // This really makes one lose trust in the DAT files...
-              char current_name[2 * 80];
-              long current_filepos = ftell (fdat);
-
-              if (!errorfile)
+              if (n_duplicates == n_duplicates_max)
                 {
-                  strcpy (errorfname, fname_index);
-                  set_suffix (errorfname, ".err");
-                  if ((errorfile = fopen (errorfname, "w")) == NULL) // text file for WinDOS
+                  st_idx_entry_t *p = (st_idx_entry_t *)
+                    realloc (duplicates, (n_duplicates_max + 256) * 2 *
+                                           sizeof (st_idx_entry_t));
+                  if (!p)
                     {
-                      fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], errorfname);
-                      continue;
+                      fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                               (n_duplicates_max + 256) * 2 * sizeof (st_idx_entry_t));
+                      exit (1);
                     }
+                  duplicates = p;
+                  n_duplicates_max += 256;
                 }
-
-              strcpy (current_name, dat.name);
-              get_dat_entry (fname_dat, &dat, 0, idx_entry->filepos);
-              fprintf (errorfile,
-                       "\n"
-                       "WARNING: DAT file contains a duplicate CRC32 value (0x%x)!\n"
-                       "  First game with this CRC32 value: \"%s\"\n"
-                       "  Ignoring game:                    \"%s\"\n",
-                       dat.crc32, dat.name, current_name);
-
+              duplicates[n_duplicates * 2] = idx_entries[first];
+              duplicates[n_duplicates * 2 + 1] = idx_entry;
               n_duplicates++;
-              fseek (fdat, current_filepos, SEEK_SET);
-              continue;
             }
+          else
+            {
+              if (!(pos % 20))
+                ucon64_gauge (start_time, dat_text.format == DAT_FORMAT_ROMCENTER ?
+                                ftell (fdat) : (long) dat_text.pos, fsize);
+              pos++;
+            }
+        }
 
-          idx_entries[pos].crc32 = dat.crc32;
-          idx_entries[pos].filepos = filepos_line;
+      // This really makes one lose trust in the DAT files...
+      for (n = 0; n < n_duplicates; n++)
+        {
+          char current_name[sizeof dat.name];
+
+          if (!errorfile)
+            {
+              strcpy (errorfname, fname_index);
+              set_suffix (errorfname, ".err");
+              if ((errorfile = fopen (errorfname, "w")) == NULL) // text file for WinDOS
+                {
+                  fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], errorfname);
+                  break;
+                }
+            }
 
-          if (!(pos % 20))
-            ucon64_gauge (start_time, ftell (fdat), fsize);
-          pos++;
+          if (!get_dat_entry (fname_dat, &dat, duplicates[n * 2 + 1].crc32,
+                              duplicates[n * 2 + 1].filepos))
+            continue;
+          strcpy (current_name, dat.name);
+          if (!get_dat_entry (fname_dat, &dat, duplicates[n * 2].crc32,
+                              duplicates[n * 2].filepos))
+            continue;
+          fprintf (errorfile,
+                   "\n"
+                   "WARNING: DAT file contains a duplicate CRC32 value (0x%x)!\n"
+                   "  First game with this CRC32 value: \"%s\"\n"
+                   "  Ignoring game:                    \"%s\"\n",
+                   dat.crc32, dat.name, current_name);
         }
       fclose_fdat ();
+      if (idx_set)
+        memset (idx_set, 0, (idx_set_mask + 1) * sizeof (int));
 
       if (pos > 0)
         {
@@ -1101,6 +1972,8 @@ ucon64_dat_indexer (void)
       fputs ("\n\n", stdout);
     }
   free (idx_entries);
+  free (idx_set);
+  free (duplicates);
 
   return 0;
 }
@@ -1352,7 +2225,7 @@ ucon64_create_dat (const char *dat_file_name, const char *filename,
   n = 0;
   if (ucon64.console != console)
     {
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         printf ("WARNING: Skipping (!%s) ", console_name);
       else
         return -1;
@@ -1368,7 +2241,7 @@ ucon64_create_dat (const char *dat_file_name, const char *filename,
           break;
       if (n != ucon64_n_files)
         {
-          if (ucon64.quiet < 1)                 // better print this by default
+          if (ucon64_settings.quiet < 1)        // better print this by default
             fputs ("WARNING: Skipping (duplicate) ", stdout);
           else
             return -1;
@@ -1376,15 +2249,15 @@ ucon64_create_dat (const char *dat_file_name, const char *filename,
     }
 
   fputs (filename, stdout);
-  if (ucon64.quiet < 0 && ucon64.fname_arch[0]) // -v was specified
+  if (ucon64_settings.quiet < 0 && ucon64.fname_arch[0]) // -v was specified
     printf (" (%s)", ucon64.fname_arch);
   fputc ('\n', stdout);
 
-  if (ucon64.console != console)                // ucon64.quiet < 0 (-1)
+  if (ucon64.console != console)                // ucon64_settings.quiet < 0 (-1)
     return -1;
   if (n != ucon64_n_files)
     {
-      if (ucon64.quiet < 1)                     // better print this by default
+      if (ucon64_settings.quiet < 1)            // better print this by default
         printf ("         First file with this CRC32 value (0x%x) is:\n"
                 "         \"%s\"\n", ucon64.crc32, ucon64_mkdat_entries[n].fname);
       return -1;
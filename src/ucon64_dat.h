@@ -62,13 +62,15 @@ typedef struct
 #endif
 
 /*
-  ucon64_dat_search()         search DAT files for crc and return ucon64_dat_t
+  ucon64_dat_search()         search DAT files for crc and return ucon64_dat_t;
+                                only DAT files of console are searched, unless
+                                console is UCON64_UNKNOWN
   ucon64_dat_total_entries()  return # of ROMs in all DATs
   ucon64_dat_view()           display the complete DAT collection
   ucon64_dat_indexer()        create or update index file for DATs
   ucon64_dat_nfo()            view contents of ucon64_dat_t
 */
-extern st_ucon64_dat_t *ucon64_dat_search (uint32_t crc32);
+extern st_ucon64_dat_t *ucon64_dat_search (uint32_t crc32, int console);
 extern uint32_t ucon64_dat_total_entries (void);
 extern int ucon64_dat_view (int console, int verbose);
 extern int ucon64_dat_indexer (void);
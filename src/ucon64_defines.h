@@ -106,6 +106,8 @@ enum
   UCON64_VEC,
   UCON64_XBOX
 };
+// number of console values (for arrays indexed by console), keep it after the last one
+#define UCON64_CONSOLES (UCON64_XBOX + 1)
 
 
 // option strings (consoles)
@@ -156,6 +158,7 @@ enum
   UCON64_BIOS,
   UCON64_BIT,
   UCON64_BOT,
+  UCON64_BPS,
   UCON64_BS,
   UCON64_C,
   UCON64_CHK,
@@ -190,6 +193,7 @@ enum
   UCON64_FIND,
   UCON64_FINDI,
   UCON64_FINDR,
+  UCON64_FINDRL,
   UCON64_FRONTEND,
   UCON64_GBX,
   UCON64_GD3,
@@ -219,6 +223,7 @@ enum
   UCON64_INT2,
   UCON64_ISPAD,
   UCON64_J,
+  UCON64_JOBS,
   UCON64_K,
   UCON64_L,
   UCON64_LNX,
@@ -235,17 +240,21 @@ enum
   UCON64_MGH,
   UCON64_MIRR,
   UCON64_MKA,
+  UCON64_MKBPS,
   UCON64_MKDAT,
   UCON64_MKI,
   UCON64_MKIP,
   UCON64_MKPPF,
+  UCON64_MKPPF3,
   UCON64_MKSRM,
+  UCON64_MKUPS,
   UCON64_MSG,
   UCON64_MULTI,
 //  UCON64_MVS,
   UCON64_N,
   UCON64_N2,
   UCON64_N2GB,
+  UCON64_N64LE,
   UCON64_NA,
   UCON64_NBAK,
   UCON64_NBAT,
@@ -269,7 +278,10 @@ enum
   UCON64_PARSE,
   UCON64_PASOFAMI,
   UCON64_PATCH,
+  UCON64_PATCH_CHAIN,
   UCON64_PATTERN,
+  UCON64_PCAT,
+  UCON64_PCATADD,
   UCON64_POKE,
   UCON64_PORT,
   UCON64_PPF,
@@ -281,6 +293,7 @@ enum
   UCON64_RANGE,
   UCON64_RDAT,
   UCON64_REGION,
+  UCON64_RESCAN,
   UCON64_RJOLIET,
   UCON64_RROM,
   UCON64_RL,
@@ -295,6 +308,7 @@ enum
   UCON64_SCR,
   UCON64_SGB,
   UCON64_SHA1,
+  UCON64_SHA256,
   UCON64_SMC,
   UCON64_SMD,
   UCON64_SMDS,
@@ -320,6 +334,8 @@ enum
   UCON64_UFOSDS,
   UCON64_UNIF,
   UCON64_UNSCR,
+  UCON64_UPPF,
+  UCON64_UPS,
   UCON64_USMS,
   UCON64_V,
   UCON64_V64,
@@ -399,7 +415,7 @@ enum
   UCON64_GUI,
 
   // Keep these (libdiscmage) options separate
-  UCON64_DISC = UCON64_OPTION + 250,
+  UCON64_DISC = UCON64_OPTION + 500,
   UCON64_MKCUE,
   UCON64_MKSHEET,
   UCON64_MKTOC,
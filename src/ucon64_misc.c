@@ -45,13 +45,13 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #pragma warning(pop)
 #endif
 #include "misc/archive.h"
-#include "misc/bswap.h"
 #include "misc/chksum.h"
 #include "misc/file.h"
 #include "misc/misc.h"
 #include "misc/property.h"
 #include "misc/string.h"
 #include "misc/term.h"
+#include "misc/xform.h"
 #include "ucon64.h"
 #include "ucon64_dat.h"
 #include "ucon64_misc.h"
@@ -222,6 +222,21 @@ const st_getopt2_t ucon64_options_usage[] =
       NULL, "process subdirectories recursively",
       &ucon64_option_obj[0]
     },
+#ifdef  HAVE_FORK
+    {
+      "jobs", 1, 0, UCON64_JOBS,
+      "N", "process N files in parallel; only for " OPTION_LONG_S "ls, " OPTION_LONG_S "lsv,\n"
+      OPTION_LONG_S "crc, " OPTION_LONG_S "md5, " OPTION_LONG_S "sha1, " OPTION_LONG_S "sha256 and (DAT) ROM info;\n"
+      "output is shown in the same order as without " OPTION_LONG_S "jobs",
+      &ucon64_option_obj[0]
+    },
+#endif
+    {
+      "rescan", 0, 0, UCON64_RESCAN,
+      NULL, "scan all files again instead of using the scan cache of\n"
+      OPTION_LONG_S "ls, " OPTION_LONG_S "lsv, " OPTION_LONG_S "scan, " OPTION_LONG_S "rdat, " OPTION_LONG_S "rrom and ROM info",
+      &ucon64_option_obj[0]
+    },
     {
       "nbak", 0, 0, UCON64_NBAK,
       NULL, "prevents backup files (*.BAK)",
@@ -310,6 +325,11 @@ const st_getopt2_t ucon64_options_usage[] =
       NULL, "show SHA1 value of ROM",
       &ucon64_option_obj[9]
     },
+    {
+      "sha256", 0, 0, UCON64_SHA256,
+      NULL, "show SHA-256 value of ROM",
+      &ucon64_option_obj[9]
+    },
     {
       "md5", 0, 0, UCON64_MD5,
       NULL, "show MD5 value of ROM",
@@ -363,6 +383,13 @@ const st_getopt2_t ucon64_options_usage[] =
              "(no wildcard supported)",
       &ucon64_option_obj[6]
     },
+    {
+      "findrl", 1, 0, UCON64_FINDRL,
+      "FILE", "like " OPTION_LONG_S "findr but searches for all strings in FILE (one per\n"
+              "line) in one pass and shows the character table offset of\n"
+              "each match",
+      &ucon64_option_obj[6]
+    },
     {
       "hfind", 1, 0, UCON64_HFIND,
       "HEX", "find HEX codes in ROM; use quotation " OPTION_LONG_S "hfind" OPTARG_S "\"75 ? 4f 4e\"\n"
@@ -580,18 +607,18 @@ ucon64_load_discmage (void)
 {
   uint32_t version;
 #ifdef  DLOPEN
-  const char *p = get_property (ucon64.configfile, "discmage_path", PROPERTY_MODE_FILENAME);
+  const char *p = get_property (ucon64_settings.configfile, "discmage_path", PROPERTY_MODE_FILENAME);
   if (p)
-    strcpy (ucon64.discmage_path, p);
+    strcpy (ucon64_settings.discmage_path, p);
   else
-    *ucon64.discmage_path = '\0';
+    *ucon64_settings.discmage_path = '\0';
 
-  // if ucon64.discmage_path points to an existing file then load it
-  if (!access (ucon64.discmage_path, F_OK))
+  // if ucon64_settings.discmage_path points to an existing file then load it
+  if (!access (ucon64_settings.discmage_path, F_OK))
     {
       u_func_ptr_t sym;
 
-      libdm = open_module (ucon64.discmage_path);
+      libdm = open_module (ucon64_settings.discmage_path);
 
       sym.void_ptr = get_symbol (libdm, "dm_get_version");
       dm_get_version_ptr = (uint32_t (*) (void)) sym.func_ptr;
@@ -881,14 +908,14 @@ ucon64_file_handler (char *dest, char *src, unsigned int flags)
 
       if (src == NULL)
         {
-          if (ucon64.backup)
+          if (ucon64_settings.backup)
             printf ("Wrote backup to %s\n", mkbak (dest, BAK_DUPE));
           return 1;
         }
 
       if (one_file (src, dest))
         {                                       // case 1
-          if (ucon64.backup)
+          if (ucon64_settings.backup)
             {                                   // case 1a
               strcpy (src, mkbak (dest, BAK_DUPE));
               printf ("Wrote backup to %s\n", src);
@@ -901,7 +928,7 @@ ucon64_file_handler (char *dest, char *src, unsigned int flags)
         }
       else
         {                                       // case 2
-          if (ucon64.backup)                    // case 2a
+          if (ucon64_settings.backup)           // case 2a
             printf ("Wrote backup to %s\n", mkbak (dest, BAK_DUPE));
         }
       return 1;
@@ -945,15 +972,15 @@ ucon64_output_fname (char *requested_fname, unsigned int flags)
 
       len = strnlen (requested_fname_base, FILENAME_MAX - 1);
       strncpy (fname, requested_fname_base, len)[len] = '\0';
-      len += strnlen (ucon64.output_path, FILENAME_MAX - 1 - len);
-      snprintf (requested_fname, len + 1, "%s%s", ucon64.output_path, fname);
+      len += strnlen (ucon64_settings.output_path, FILENAME_MAX - 1 - len);
+      snprintf (requested_fname, len + 1, "%s%s", ucon64_settings.output_path, fname);
     }
   else                                          // an archive (for now: zip file)
     {
       p = basename2 (ucon64.fname_arch);
-      len = strnlen (ucon64.output_path, FILENAME_MAX - 1);
+      len = strnlen (ucon64_settings.output_path, FILENAME_MAX - 1);
       len += strnlen (p, FILENAME_MAX - 1 - len);
-      snprintf (requested_fname, len + 1, "%s%s", ucon64.output_path, p);
+      snprintf (requested_fname, len + 1, "%s%s", ucon64_settings.output_path, p);
     }
   requested_fname[len] = '\0';
 
@@ -1073,7 +1100,7 @@ ucon64_gauge (time_t start_time, size_t pos, size_t size)
 
   percentage = misc_percent (pos, size);
 
-  if (ucon64.frontend)
+  if (ucon64_settings.frontend)
     {
       printf ("%u\n", percentage);
       fflush (stdout);
@@ -1084,7 +1111,7 @@ ucon64_gauge (time_t start_time, size_t pos, size_t size)
   printf ("\r%10u Bytes [", (unsigned) pos);
 
 #ifdef  USE_ANSI_COLOR
-  if (ucon64.ansi_color)
+  if (ucon64_settings.ansi_color)
     {
       col1 = 1;
       col2 = 2;
@@ -1293,7 +1320,7 @@ ucon64_set_property_array (const char *org_configfile)
   ucon64_set_property (&props[i++], org_configfile, "emulate_" UCON64_XBOX_S, "", NULL);
   ucon64_set_property (&props[i++], org_configfile, NULL, NULL, NULL);
 
-  result = set_property_array (ucon64.configfile, props);
+  result = set_property_array (ucon64_settings.configfile, props);
 
   for (i -= 2; i >= 0; i--)
     free ((char *) props[i].value_s);
@@ -1506,8 +1533,8 @@ ucon64_rename (int mode)
       if (!good_name)
         printf ("  Target filename is \"%s\"\n", p2);
       printf ("  A file with the same name, but possibly different contents exists in the\n"
-              "  output directory (\"%s\")\n", ucon64.output_path[0] ?
-                ucon64.output_path : "." DIR_SEPARATOR_S);
+              "  output directory (\"%s\")\n", ucon64_settings.output_path[0] ?
+                ucon64_settings.output_path : "." DIR_SEPARATOR_S);
       return 0;
     }
 
@@ -1589,19 +1616,19 @@ ucon64_e (void)
       {0,               NULL}
     };
 
-  if (access (ucon64.configfile, F_OK) != 0)
+  if (access (ucon64_settings.configfile, F_OK) != 0)
     {
-      fprintf (stderr, "ERROR: %s does not exist\n", ucon64.configfile);
+      fprintf (stderr, "ERROR: %s does not exist\n", ucon64_settings.configfile);
       return -1;
     }
 
   sprintf (name, "emulate_%08x", ucon64.crc32); // look for emulate_<crc32>
-  value_p = get_property (ucon64.configfile, name, PROPERTY_MODE_TEXT);
+  value_p = get_property (ucon64_settings.configfile, name, PROPERTY_MODE_TEXT);
 
   if (value_p == NULL)
     {
       sprintf (name, "emulate_0x%08x", ucon64.crc32); // look for emulate_0x<crc32>
-      value_p = get_property (ucon64.configfile, name, PROPERTY_MODE_TEXT);
+      value_p = get_property (ucon64_settings.configfile, name, PROPERTY_MODE_TEXT);
     }
 
   if (value_p == NULL)
@@ -1611,7 +1638,7 @@ ucon64_e (void)
       for (x = 0; s[x].s; x++)
         if (s[x].id == ucon64.console)
           {
-            value_p = get_property (ucon64.configfile, s[x].s, PROPERTY_MODE_TEXT);
+            value_p = get_property (ucon64_settings.configfile, s[x].s, PROPERTY_MODE_TEXT);
             break;
           }
     }
@@ -1622,7 +1649,7 @@ ucon64_e (void)
                "       %s\n"
                "TIP:   If the wrong console was detected you might try to force recognition\n"
                "       For example, the force recognition switch for SNES is " OPTION_LONG_S "snes\n",
-               name, ucon64.configfile);
+               name, ucon64_settings.configfile);
       return -1;
     }
 
@@ -1666,13 +1693,14 @@ ucon64_pattern (const char *pattern_fname)
   unsigned int n_found = 0;
   uint64_t totalbytesread = 0;
   st_cm_pattern_t *patterns = NULL;
+  st_cm_automaton_t automaton;
 
   realpath2 (pattern_fname, src_name);
   // first try the current directory, then the configuration directory
   if (access (src_name, F_OK | R_OK) == -1)
     {
       snprintf (src_name, FILENAME_MAX, "%s" DIR_SEPARATOR_S "%s",
-                ucon64.configdir, basename2 (pattern_fname));
+                ucon64_settings.configdir, basename2 (pattern_fname));
       src_name[FILENAME_MAX - 1] = '\0';
     }
   n_patterns = build_cm_patterns (&patterns, src_name);
@@ -1719,6 +1747,8 @@ ucon64_pattern (const char *pattern_fname)
                 n + 1);
     }
   overlap--;
+  memset (&automaton, 0, sizeof (st_cm_automaton_t));
+  add_cm_patterns (&automaton, patterns, n_patterns);
 
   printf ("Searching for patterns in %s...\n", ucon64.fname);
 
@@ -1728,36 +1758,61 @@ ucon64_pattern (const char *pattern_fname)
   if ((srcfile = fopen (src_name, "rb")) == NULL)
     {
       fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], src_name);
+      cleanup_cm_automaton (&automaton);
+      cleanup_cm_patterns (&patterns, n_patterns);
       return -1;
     }
   if ((destfile = fopen (dest_name, "wb")) == NULL)
     {
       fprintf (stderr, ucon64_msg[OPEN_WRITE_ERROR], dest_name);
       fclose (srcfile);
+      cleanup_cm_automaton (&automaton);
+      cleanup_cm_patterns (&patterns, n_patterns);
       return -1;
     }
 
   while ((bytesread = fread (buffer + effective_overlap, 1,
                              PATTERN_BUFSIZE - effective_overlap, srcfile)) != 0)
     {
+      /*
+        Search for all patterns in one pass. Only the patterns that occur in
+        buffer have to be searched for separately with change_mem2(), in the
+        part of buffer that belongs to them. A pattern that changes buffer may
+        create or destroy matches of the patterns after it, so then search
+        buffer again for those.
+      */
+      find_cm_patterns (&automaton, buffer, bytesread + effective_overlap, 0);
       for (n = 0; n < n_patterns; n++)
         {
           size_t search_overlap = patterns[n].search_size - 1,
                  buffer_size = bytesread + (totalbytesread > 0 ? search_overlap : 0);
           char *buffer_start = buffer + (totalbytesread > 0 ? overlap - search_overlap : 0);
 
-          if (ucon64.quiet < 0)
+          if (ucon64_settings.quiet < 0)
             printf ("Scanning offset 0x%08llx-0x%08llx (%u bytes) for pattern %d\n",
                     (long long unsigned int) (totalbytesread - effective_overlap +
                       (buffer_start - buffer)),
                     (long long unsigned int) (totalbytesread - effective_overlap +
                       (buffer_start - buffer) + buffer_size - 1),
                     (unsigned int) buffer_size, n + 1);
-          n_found += change_mem2 (buffer_start, buffer_size, patterns[n].search,
-                                  patterns[n].search_size, patterns[n].wildcard,
-                                  patterns[n].escape, patterns[n].replace,
-                                  patterns[n].replace_size, patterns[n].offset,
-                                  patterns[n].sets);
+          if (automaton.matched[n])
+            {
+              int n_matches = change_mem2 (buffer_start, buffer_size,
+                                           patterns[n].search,
+                                           patterns[n].search_size,
+                                           patterns[n].wildcard,
+                                           patterns[n].escape,
+                                           patterns[n].replace,
+                                           patterns[n].replace_size,
+                                           patterns[n].offset,
+                                           patterns[n].sets);
+
+              automaton.n_found[n] += n_matches;
+              n_found += n_matches;
+              if (n_matches && n + 1 < n_patterns)
+                find_cm_patterns (&automaton, buffer, bytesread + effective_overlap,
+                                  n + 1);
+            }
         }
       fwrite (buffer, 1, bytesread + effective_overlap - overlap, destfile);
 
@@ -1768,15 +1823,20 @@ ucon64_pattern (const char *pattern_fname)
         fwrite (buffer + effective_overlap - overlap + bytesread, 1, overlap, destfile);
       effective_overlap = overlap;
 
-      if (ucon64.quiet < 0)
+      if (ucon64_settings.quiet < 0)
         fputc ('\n', stdout);
     }
 
   fclose (srcfile);
   fclose (destfile);
-  cleanup_cm_patterns (&patterns, n_patterns);
 
   printf ("Found %u pattern%s\n", n_found, n_found != 1 ? "s" : "");
+  for (n = 0; n < n_patterns; n++)
+    if (automaton.n_found[n])
+      printf ("  Pattern %d: %u match%s\n", n + 1, automaton.n_found[n],
+              automaton.n_found[n] != 1 ? "es" : "");
+  cleanup_cm_automaton (&automaton);
+  cleanup_cm_patterns (&patterns, n_patterns);
   printf (ucon64_msg[WROTE], dest_name);
   remove_temp_file ();
   return n_found;
@@ -1788,13 +1848,9 @@ size_t
 ucon64_bswap16_n (void *buffer, size_t n)
 // bswap_16() n bytes of buffer
 {
-  uint16_t *w = (uint16_t *) buffer;
-
-  n >>= 1;                                      // # words = # bytes / 2
-  for (; (size_t) (w - (uint16_t *) buffer) < n; w++)
-    *w = bswap_16 (*w);
-
-  return n << 1;                                // return # of bytes swapped
+  n &= ~(size_t) 1;                             // # words = # bytes / 2
+  mem_bswap16 (buffer, n);
+  return n;                                     // return # of bytes swapped
 }
 
 
@@ -1812,13 +1868,9 @@ ucon64_fwswap32_func (void *buffer, size_t n, void *object)
 // wswap_32() n/2 words of buffer
 {
   (void) object;
-  uint32_t *d = (uint32_t *) buffer;
-
-  n >>= 2;                                      // # double words = # bytes / 4
-  for (; (size_t) (d - (uint32_t *) buffer) < n; d++)
-    *d = wswap_32 (*d);
-
-  return n << 2;                                // return # of bytes swapped
+  n &= ~(size_t) 3;                             // # double words = # bytes / 4
+  mem_wswap32 (buffer, n);
+  return n;                                     // return # of bytes swapped
 }
 
 
@@ -1836,6 +1888,24 @@ ucon64_fwswap32 (const char *fname, uint64_t start, uint64_t len)
 }
 
 
+unsigned int
+ucon64_view_crc32 (unsigned int crc, const st_block_view_t *view, size_t len)
+{
+  unsigned char scratch[MAXBUFSIZE];
+  size_t pos, n;
+
+  for (pos = 0; pos < len; pos += n)
+    {
+      const unsigned char *p;
+
+      n = len - pos;
+      p = block_view_data (view, pos, &n, scratch, sizeof scratch);
+      crc = crc32 (crc, p, (unsigned int) n);
+    }
+  return crc;
+}
+
+
 #ifdef  _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
@@ -1893,6 +1963,7 @@ typedef struct
   FILE *file;
   char *buf;
   size_t bufsize;
+  const st_memmem2_t *searcher;                 // prepared once per search
 } st_ucon64_find_t;
 #ifdef  _MSC_VER
 #pragma warning(pop)
@@ -1929,7 +2000,7 @@ ucon64_find_func (void *buffer, size_t n, void *object)
 
       memcpy (compare, match + m++, matchlen);
       memcpy (compare + matchlen, ptr1, len);
-      if (memcmp2 (compare, o->search, o->searchlen, o->flags) == 0)
+      if (memcmp2 (compare, o->search, o->searchlen, o->searcher->flags) == 0)
         {
           o->found = o->pos - matchlen;
           if (!(o->flags & UCON64_FIND_QUIET))
@@ -1961,8 +2032,7 @@ ucon64_find_func (void *buffer, size_t n, void *object)
 
   while ((size_t) (ptr1 - ptr0) < n)
     {
-      ptr1 = (char *) memmem2 (ptr1, n - (ptr1 - ptr0), o->search, o->searchlen,
-                               o->flags);
+      ptr1 = (char *) memmem2_find (o->searcher, ptr1, n - (ptr1 - ptr0));
       if (ptr1)
         {
           o->found = o->pos + (size_t) (ptr1 - ptr0);
@@ -1992,7 +2062,7 @@ ucon64_find_func (void *buffer, size_t n, void *object)
 
           ptr1 = ptr0 + n - len;
           for (m = 1; m < len; m++)
-            if (memcmp2 (ptr1 + m, o->search, len - m, o->flags) == 0)
+            if (memcmp2 (ptr1 + m, o->search, len - m, o->searcher->flags) == 0)
               {
                 memcpy (match, ptr1 + m, len - m);
                 matchlen = len - m;
@@ -2107,7 +2177,8 @@ ucon64_find (const char *filename, uint64_t start, uint64_t len,
              const char *search, size_t searchlen, unsigned int flags)
 {
   // o.found == -2 signifies a new find operation (usually for a new file)
-  st_ucon64_find_t o = { NULL, 0, 0, 0, -2, NULL, 0, NULL, NULL, 0 };
+  st_ucon64_find_t o = { NULL, 0, 0, 0, -2, NULL, 0, NULL, NULL, 0, NULL };
+  st_memmem2_t searcher;
   o.search = search;
   o.searchlen = searchlen;
   o.flags = flags;
@@ -2130,6 +2201,8 @@ ucon64_find (const char *filename, uint64_t start, uint64_t len,
                MAXBUFSIZE);
       exit (1);                                 // see ucon64_find_func() for why
     }
+  memmem2_init (&searcher, search, searchlen, flags);
+  o.searcher = &searcher;
 
   return ucon64_find_helper (filename, start, len, &o);
 }
@@ -2143,7 +2216,8 @@ ucon64_replace (const char *filename, uint64_t start, uint64_t len,
   int64_t result;
   char src_name[FILENAME_MAX], dest_name[FILENAME_MAX];
   // o.found == -2 signifies a new find operation (usually for a new file)
-  st_ucon64_find_t o = { NULL, 0, 0, 0, -2, NULL, 0, NULL, NULL, 0 };
+  st_ucon64_find_t o = { NULL, 0, 0, 0, -2, NULL, 0, NULL, NULL, 0, NULL };
+  st_memmem2_t searcher;
   o.search = search;
   o.searchlen = searchlen;
   o.flags = flags | UCON64_FIND_REPLACE;
@@ -2194,6 +2268,8 @@ ucon64_replace (const char *filename, uint64_t start, uint64_t len,
       exit (1);
     }
 
+  memmem2_init (&searcher, search, searchlen, flags);
+  o.searcher = &searcher;
   result = ucon64_find_helper (src_name, start, len, &o);
 
   if (o.bufsize)
@@ -2208,77 +2284,315 @@ ucon64_replace (const char *filename, uint64_t start, uint64_t len,
 }
 
 
+#define FINDR_LIST_MIN_LEN 3
+
+
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
 typedef struct
 {
-  s_sha1_ctx_t *sha1_ctx;
-  s_md5_ctx_t *md5_ctx;
-//  uint16_t *crc16;
-  unsigned int *crc32;
-} st_ucon64_chksum_t;
+  const unsigned char *str;
+  size_t len;
+  unsigned char *deltas;                        // len - 1 differences
+  int next;                                     // next string with same key
+} st_ucon64_findr_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
 
 
-static inline size_t
-ucon64_chksum_func (void *buffer, size_t n, void *object)
+static unsigned int
+ucon64_findr_list_read (const char *listname, st_ucon64_findr_t **strings,
+                        char **data, size_t *maxlen)
 {
-  st_ucon64_chksum_t *o = (st_ucon64_chksum_t *) object;
-
-  if (o->sha1_ctx)
-    sha1 (o->sha1_ctx, (const unsigned char *) buffer, (unsigned int) n);
+  FILE *file;
+  char line[MAXBUFSIZE];
+  size_t size = 0, alloc_size = 0;
+  unsigned int n = 0, alloc_n = 0, i;
 
-  if (o->md5_ctx)
-    md5_update (o->md5_ctx, (unsigned char *) buffer, (unsigned int) n);
+  if ((file = fopen (listname, "r")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], listname);
+      exit (1);
+    }
+  *data = NULL;
+  *strings = NULL;
+  *maxlen = 0;
+  while (fgets (line, MAXBUFSIZE, file))
+    {
+      size_t len = strcspn (line, "\r\n");
 
-//  if (o->crc16)
-//    *(o->crc16) = crc16 (*(o->crc16), (const unsigned char *) buffer, (unsigned int) n);
+      if (len == 0)
+        continue;
+      if (len < FINDR_LIST_MIN_LEN)
+        {
+          line[len] = '\0';
+          printf ("WARNING: Skipping \"%s\"; strings must be at least %d characters long\n",
+                  line, FINDR_LIST_MIN_LEN);
+          continue;
+        }
+      if (size + 2 * len > alloc_size)
+        {
+          alloc_size = (size + 2 * len) * 2;
+          if ((*data = (char *) realloc (*data, alloc_size)) == NULL)
+            {
+              fprintf (stderr, ucon64_msg[BUFFER_ERROR], alloc_size);
+              exit (1);
+            }
+        }
+      if (n == alloc_n)
+        {
+          alloc_n = alloc_n ? alloc_n * 2 : 64;
+          if ((*strings = (st_ucon64_findr_t *)
+                 realloc (*strings, alloc_n * sizeof (st_ucon64_findr_t))) == NULL)
+            {
+              fprintf (stderr, ucon64_msg[BUFFER_ERROR],
+                       alloc_n * sizeof (st_ucon64_findr_t));
+              exit (1);
+            }
+        }
+      // store the string and its differences; pointers are set below
+      memcpy (*data + size, line, len);
+      for (i = 0; i < len - 1; i++)
+        (*data)[size + len + i] = (char) (line[i] - line[i + 1]);
+      (*strings)[n].str = (const unsigned char *) size;
+      (*strings)[n].len = len;
+      size += 2 * len;
+      if (len > *maxlen)
+        *maxlen = len;
+      n++;
+    }
+  fclose (file);
 
-  if (o->crc32)
-    *(o->crc32) = crc32 (*(o->crc32), (const unsigned char *) buffer, (unsigned int) n);
+  for (i = 0; i < n; i++)
+    {
+      size_t offset = (size_t) (*strings)[i].str;
 
+      (*strings)[i].str = (const unsigned char *) *data + offset;
+      (*strings)[i].deltas = (unsigned char *) *data + offset + (*strings)[i].len;
+    }
   return n;
 }
 
 
-void
-ucon64_chksum (char *sha1_s, char *md5_s, unsigned int *crc32_i, // uint16_t *crc16_i,
-               const char *filename, uint64_t file_size, uint64_t start)
+int64_t
+ucon64_findr_list (const char *filename, uint64_t start, uint64_t len,
+                   const char *listname)
+/*
+  Relative search for all strings in listname in one pass. The differences
+  between neighbouring bytes of each block of the file are computed once. The
+  first two differences of every position are used as key in a table of the
+  strings, so the time needed hardly depends on the number of strings. The
+  table offset shown for a match is the value that has to be added to a
+  character of the string to get the byte in the file.
+*/
 {
-  int i = 0;
-  s_sha1_ctx_t sha1_ctx;
-  s_md5_ctx_t md5_ctx;
-  st_ucon64_chksum_t o;
+  st_ucon64_findr_t *strings;
+  FILE *file;
+  char *data;
+  unsigned char *buf, *deltas;
+  int *table;
+  size_t maxlen, keep = 0;
+  uint64_t pos = start;
+  int64_t found = -1;
+  unsigned int n_strings, i;
+
+  n_strings = ucon64_findr_list_read (listname, &strings, &data, &maxlen);
+  if (n_strings == 0)
+    {
+      fprintf (stderr, "ERROR: %s contains no search strings\n", listname);
+      exit (1);
+    }
 
-  memset (&o, 0, sizeof (st_ucon64_chksum_t));
+  if ((table = (int *) malloc (65536 * sizeof (int))) == NULL ||
+      (buf = (unsigned char *) malloc (MAXBUFSIZE + maxlen)) == NULL ||
+      (deltas = (unsigned char *) malloc (MAXBUFSIZE + maxlen)) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[BUFFER_ERROR], 65536 * sizeof (int));
+      exit (1);
+    }
+  for (i = 0; i < 65536; i++)
+    table[i] = -1;
+  for (i = n_strings; i-- > 0; )                // keep the order of listname
+    {
+      unsigned int key = (strings[i].deltas[0] << 8) | strings[i].deltas[1];
 
-  if (sha1_s)
-    sha1_begin (o.sha1_ctx = &sha1_ctx);
+      strings[i].next = table[key];
+      table[key] = (int) i;
+    }
 
-  if (md5_s)
-    md5_init (o.md5_ctx = &md5_ctx, 0);
+  if ((file = fopen (filename, "rb")) == NULL)
+    {
+      fprintf (stderr, ucon64_msg[OPEN_READ_ERROR], filename);
+      exit (1);
+    }
+  fseek (file, (long) start, SEEK_SET);
 
-//  if (crc16_i)
-//    o.crc16 = crc16_i;
+  fputs (filename, stdout);
+  if (ucon64.fname_arch[0])
+    printf (" (%s)\n", ucon64.fname_arch);
+  else
+    fputc ('\n', stdout);
+  printf ("Relative searching for %u strings from %s\n\n", n_strings, listname);
 
-  if (crc32_i)
-    o.crc32 = crc32_i;
+  for (;;)
+    {
+      size_t n = (size_t) MIN ((uint64_t) MAXBUFSIZE, start + len - pos - keep),
+             buflen, last, j;
+      int eof;
 
-  quick_io_func (ucon64_chksum_func, MAXBUFSIZE, &o, start, file_size - start,
-                 filename, "rb");
+      n = fread (buf + keep, 1, n, file);
+      buflen = keep + n;
+      eof = n == 0 || pos + buflen >= start + len;
+      /*
+        Positions up to last are checked now. Unless this is the end of the
+        file, a match starting after last may continue in the next block.
+      */
+      if (eof)
+        last = buflen >= FINDR_LIST_MIN_LEN ? buflen - FINDR_LIST_MIN_LEN + 1 : 0;
+      else
+        last = buflen >= maxlen ? buflen - maxlen + 1 : 0;
 
-  if (sha1_s)
-    {
-      unsigned char buf[MAXBUFSIZE];
+      for (j = 0; j + 1 < buflen; j++)            // no dependencies, can be vectorized
+        deltas[j] = (unsigned char) (buf[j] - buf[j + 1]);
 
-      sha1_end (buf, &sha1_ctx);
-      for (i = 0; i < 20; i++, sha1_s = strchr (sha1_s, 0))
-        sprintf (sha1_s, "%02x", buf[i]);
+      for (j = 0; j < last; j++)
+        {
+          int k = table[(deltas[j] << 8) | deltas[j + 1]];
+
+          for (; k != -1; k = strings[k].next)
+            {
+              st_ucon64_findr_t *s = &strings[k];
+
+              // compare the differences modulo 256 first, then exactly
+              if (j + s->len > buflen ||
+                  memcmp (deltas + j + 2, s->deltas + 2, s->len - 3) ||
+                  memcmp2 (buf + j, s->str, s->len, MEMCMP2_REL))
+                continue;
+              found = (int64_t) (pos + j);
+              printf ("%08llx  \"%.*s\"  table offset: %+d",
+                      (long long unsigned int) found, (int) s->len, s->str,
+                      buf[j] - s->str[0]);
+              if (isprint (s->str[0]))
+                printf (" ('%c' = 0x%02x)", s->str[0], buf[j]);
+              fputc ('\n', stdout);
+            }
+        }
+
+      if (eof)
+        break;
+      keep = buflen - last;
+      memmove (buf, buf + last, keep);
+      pos += last;
     }
 
-  if (md5_s)
+  fclose (file);
+  free (deltas);
+  free (buf);
+  free (table);
+  free (strings);
+  free (data);
+  return found;                                 // return last occurrence or -1
+}
+
+
+#ifdef  _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4820) // 'bytes' bytes padding added after construct 'member_name'
+#endif
+typedef struct
+{
+  char fname[FILENAME_MAX];
+  uint64_t file_size;
+  uint64_t start;
+  s_chksum_ctx_t ctx;                           // ctx.flags == 0 => empty
+} st_ucon64_chksum_t;
+#ifdef  _MSC_VER
+#pragma warning(pop)
+#endif
+
+static st_ucon64_chksum_t ucon64_chksum_cache;
+
+
+static inline size_t
+ucon64_chksum_func (void *buffer, size_t n, void *object)
+{
+  chksum_update ((s_chksum_ctx_t *) object, buffer, n);
+  return n;
+}
+
+
+void
+ucon64_chksum_flush (void)
+{
+  ucon64_chksum_cache.ctx.flags = 0;
+}
+
+
+void
+ucon64_chksum (char *sha1_s, char *md5_s, char *sha256_s,
+               unsigned int *crc32_i, // uint16_t *crc16_i,
+               const char *filename, uint64_t file_size, uint64_t start,
+               unsigned int chksum_flags)
+{
+  int i = 0;
+  unsigned int flags = (sha1_s ? CHKSUM_SHA1 : 0) | (md5_s ? CHKSUM_MD5 : 0) |
+                       (sha256_s ? CHKSUM_SHA256 : 0) |
+                       (crc32_i ? CHKSUM_CRC32 : 0);
+  st_ucon64_chksum_t *cache = &ucon64_chksum_cache;
+  // the cache only holds CRC32 values that were calculated starting from 0
+  int cacheable = !(crc32_i && *crc32_i);
+  s_chksum_ctx_t ctx, *o = cacheable ? &cache->ctx : &ctx;
+
+  if (!cacheable || (cache->ctx.flags & flags) != flags ||
+      cache->start != start || cache->file_size != file_size ||
+      strcmp (cache->fname, filename))
     {
-      md5_final (&md5_ctx);
-      for (i = 0; i < 16; i++, md5_s = strchr (md5_s, 0))
-        sprintf (md5_s, "%02x", md5_ctx.digest[i]);
+      const unsigned char *image;
+      uint64_t image_size;
+
+      /*
+        Calculate every checksum that was asked for on the command line in the
+        same pass, so that the file is read only once for -crc -sha1 -md5 etc.
+      */
+      chksum_begin (o, cacheable ? flags | chksum_flags : flags);
+      if (crc32_i)
+        o->crc32 = *crc32_i;
+      if ((image = quick_io_ctx_data (filename, &image_size)) != NULL)
+        {
+          if (start < MIN (file_size, image_size))
+            chksum_update (o, image + start,
+                           (size_t) (MIN (file_size, image_size) - start));
+        }
+      else
+        quick_io_func (ucon64_chksum_func, MAXBUFSIZE, o, start,
+                       file_size - start, filename, "rb");
+      chksum_end (o);
+
+      if (cacheable)
+        {
+          strncpy (cache->fname, filename, FILENAME_MAX - 1)[FILENAME_MAX - 1] = '\0';
+          cache->file_size = file_size;
+          cache->start = start;
+        }
     }
+
+  if (crc32_i)
+    *crc32_i = o->crc32;
+
+  if (sha1_s)
+    for (i = 0; i < 20; i++, sha1_s = strchr (sha1_s, 0))
+      sprintf (sha1_s, "%02x", o->sha1_digest[i]);
+
+  if (md5_s)
+    for (i = 0; i < 16; i++, md5_s = strchr (md5_s, 0))
+      sprintf (md5_s, "%02x", o->md5.digest[i]);
+
+  if (sha256_s)
+    for (i = 0; i < 32; i++, sha256_s = strchr (sha256_s, 0))
+      sprintf (sha256_s, "%02x", o->sha256_digest[i]);
 }
 
 
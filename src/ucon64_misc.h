@@ -37,6 +37,7 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #endif
 #include "misc/getopt2.h"                       // st_getopt2_t
 #include "misc/itypes.h"
+#include "misc/xform.h"                        // st_block_view_t
 
 
 /*
@@ -138,11 +139,19 @@ extern int ucon64_pattern (const char *pattern_fname);
   ucon64_bswap16_n() bswap16() n bytes of buffer
   ucon64_fbswap16() bswap16() len bytes of file from start
   ucon64_fwswap32() wswap32() len bytes of file from start
+  ucon64_view_crc32() crc32() the first len bytes of view, continuing from crc
   ucon64_dump()     file oriented wrapper for memdump() (uses the same flags)
   ucon64_find()     file oriented wrapper for memsearch() (uses the same flags)
+  ucon64_findr_list() relative search for all strings (one per line) in listname
+                      in one pass
   ucon64_replace()  like ucon64_find(), but copies replacement string to every match
   ucon64_chksum()   file oriented wrapper for chksum()
                       if (!sha1) {sha1 won't be calculated!}
+                      the results stay cached (together with those of the
+                      checksums in chksum_flags, the CHKSUM_* of the checksum
+                      options of the caller's context) until
+                      ucon64_chksum_flush() is called
+  ucon64_chksum_flush() forget the cached checksums
   ucon64_filefile() compare file with ucon64.fname for similarities or differences
   ucon64_split()    split file
 */
@@ -154,6 +163,8 @@ extern int ucon64_pattern (const char *pattern_fname);
 extern size_t ucon64_bswap16_n (void *buffer, size_t n);
 extern void ucon64_fbswap16 (const char *fname, uint64_t start, uint64_t len);
 extern void ucon64_fwswap32 (const char *fname, uint64_t start, uint64_t len);
+extern unsigned int ucon64_view_crc32 (unsigned int crc,
+                                       const st_block_view_t *view, size_t len);
 extern void ucon64_dump (FILE *output, const char *filename, uint64_t start,
                          uint64_t len, unsigned int flags);
 // be sure the following constants don't conflict with the MEMCMP2_* constants
@@ -162,13 +173,17 @@ extern void ucon64_dump (FILE *output, const char *filename, uint64_t start,
 extern int64_t ucon64_find (const char *filename, uint64_t start, uint64_t len,
                             const char *search, size_t searchlen,
                             unsigned int flags);
+extern int64_t ucon64_findr_list (const char *filename, uint64_t start,
+                                  uint64_t len, const char *listname);
 extern int64_t ucon64_replace (const char *filename, uint64_t start, uint64_t len,
                                const char *search, size_t searchlen,
                                const char *replace, size_t replacelen,
                                unsigned int flags);
-extern void ucon64_chksum (char *sha1, char *md5, unsigned int *crc32, // uint16_t *crc16,
+extern void ucon64_chksum (char *sha1, char *md5, char *sha256,
+                           unsigned int *crc32, // uint16_t *crc16,
                            const char *filename, uint64_t file_size,
-                           uint64_t start);
+                           uint64_t start, unsigned int chksum_flags);
+extern void ucon64_chksum_flush (void);
 extern void ucon64_filefile (const char *filename1, uint64_t start1,
                              uint64_t start2, int similar);
 extern int ucon64_split (uint64_t part_size);
@@ -97,10 +97,14 @@ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "backup/swc.h"
 #include "backup/ufosd.h"
 #include "patch/aps.h"
+#include "patch/bps.h"
 #include "patch/bsl.h"
 #include "patch/gg.h"
 #include "patch/ips.h"
+#include "patch/patch.h"
+#include "patch/pcat.h"
 #include "patch/ppf.h"
+#include "patch/ups.h"
 
 
 static int
@@ -205,14 +209,14 @@ ucon64_switches (st_ucon64_t *p)
 
       printf ("configuration file %s  %s\n",
               // display the existence only for the config file (really helps solving problems)
-              access (ucon64.configfile, F_OK) ? "(not present):" : "(present):    ",
-              ucon64.configfile);
+              access (ucon64_settings.configfile, F_OK) ? "(not present):" : "(present):    ",
+              ucon64_settings.configfile);
 
 #ifdef  USE_DISCMAGE
       fputs ("discmage DLL:                      ", stdout);
 
 #ifdef  DLOPEN
-      puts (ucon64.discmage_path);
+      puts (ucon64_settings.discmage_path);
 #else
 #if     defined __MSDOS__
       fputs ("discmage.dxe", stdout);
@@ -228,7 +232,7 @@ ucon64_switches (st_ucon64_t *p)
       puts (", dynamically linked");
 #endif // DLOPEN
 
-      if (ucon64.discmage_enabled)
+      if (ucon64_settings.discmage_enabled)
         {
           x = dm_get_version ();
           printf ("discmage enabled:                  yes, %d.%d.%d (%s)\n",
@@ -243,28 +247,36 @@ ucon64_switches (st_ucon64_t *p)
               "DAT file directory:                %s\n"
               "entries in DATabase:               %u\n"
               "DATabase enabled:                  %s\n",
-              ucon64.configdir,
-              ucon64.datdir,
+              ucon64_settings.configdir,
+              ucon64_settings.datdir,
               ucon64_dat_total_entries (),
-              ucon64.dat_enabled ? "yes" : "no");
+              ucon64_settings.dat_enabled ? "yes" : "no");
       exit (0);
       break;
 
     case UCON64_FRONTEND:
-      ucon64.frontend = 1;                      // used by (for example) ucon64_gauge()
+      ucon64_settings.frontend = 1;             // used by (for example) ucon64_gauge()
       break;
 
     case UCON64_NBAK:
-      ucon64.backup = 0;
+      ucon64_settings.backup = 0;
       break;
 
     case UCON64_R:
-      ucon64.recursive = 1;
+      ucon64_settings.recursive = 1;
+      break;
+
+    case UCON64_JOBS:
+      ucon64_settings.jobs = strtol (option_arg, NULL, 10);
+      break;
+
+    case UCON64_RESCAN:
+      ucon64_settings.rescan = 1;
       break;
 
 #ifdef  USE_ANSI_COLOR
     case UCON64_NCOL:
-      ucon64.ansi_color = 0;
+      ucon64_settings.ansi_color = 0;
       break;
 #endif
 
@@ -315,20 +327,20 @@ ucon64_switches (st_ucon64_t *p)
       if (!strnicmp (option_arg, "usb", 3))
         {
           if (strlen (option_arg) >= 4)
-            ucon64.usbport = strtol (option_arg + 3, NULL, 10) + 1; // usb0 => ucon64.usbport = 1
+            ucon64_settings.usbport = strtol (option_arg + 3, NULL, 10) + 1; // usb0 => ucon64_settings.usbport = 1
           else                                  // we automatically detect the
-            ucon64.usbport = 1;                 //  USB port in the F2A & Quickdev16 code
+            ucon64_settings.usbport = 1;        //  USB port in the F2A & Quickdev16 code
 
           /*
             We don't want to make uCON64 behave differently if --port=USB{n} is
             specified *after* a transfer option (instead of before one), so we
-            have to reset ucon64.parport_needed here.
+            have to reset ucon64_settings.parport_needed here.
           */
-          ucon64.parport_needed = 0;
+          ucon64_settings.parport_needed = 0;
         }
       else
 #endif
-        ucon64.parport = (uint16_t) strtol (option_arg, NULL, 16);
+        ucon64_settings.parport = (uint16_t) strtol (option_arg, NULL, 16);
       break;
 
 #ifdef  USE_PARALLEL
@@ -356,8 +368,8 @@ ucon64_switches (st_ucon64_t *p)
     case UCON64_XSWCR:
     case UCON64_XSWCS:
     case UCON64_XV64:
-      if (!UCON64_ISSET2 (ucon64.parport_mode, parport_mode_t))
-        ucon64.parport_mode = PPMODE_SPP;
+      if (!UCON64_ISSET2 (ucon64_settings.parport_mode, parport_mode_t))
+        ucon64_settings.parport_mode = PPMODE_SPP;
     case UCON64_XCMC:
     case UCON64_XCMCT:
     case UCON64_XGD3:
@@ -368,8 +380,8 @@ ucon64_switches (st_ucon64_t *p)
     case UCON64_XGD6S:
     case UCON64_XMCCL:
     case UCON64_XMCD:
-      if (!UCON64_ISSET2 (ucon64.parport_mode, parport_mode_t))
-        ucon64.parport_mode = PPMODE_SPP_BIDIR;
+      if (!UCON64_ISSET2 (ucon64_settings.parport_mode, parport_mode_t))
+        ucon64_settings.parport_mode = PPMODE_SPP_BIDIR;
     case UCON64_XDJR:
     case UCON64_XF2A:                           // could be for USB version
     case UCON64_XF2AMULTI:                      // idem
@@ -395,12 +407,12 @@ ucon64_switches (st_ucon64_t *p)
     case UCON64_XPLI:
     case UCON64_XSF:
     case UCON64_XSFS:
-      if (!UCON64_ISSET2 (ucon64.parport_mode, parport_mode_t))
-        ucon64.parport_mode = PPMODE_EPP;
+      if (!UCON64_ISSET2 (ucon64_settings.parport_mode, parport_mode_t))
+        ucon64_settings.parport_mode = PPMODE_EPP;
 #ifdef  USE_USB
-      if (!ucon64.usbport)                      // no pport I/O if F2A option and USB F2A
+      if (!ucon64_settings.usbport)             // no pport I/O if F2A option and USB F2A
 #endif
-      ucon64.parport_needed = 1;
+      ucon64_settings.parport_needed = 1;
       break;
 #endif // USE_PARALLEL
 
@@ -413,12 +425,12 @@ ucon64_switches (st_ucon64_t *p)
     case UCON64_XCD64M:
     case UCON64_XCD64S:
 #ifdef  USE_PARALLEL
-      if (!UCON64_ISSET2 (ucon64.parport_mode, parport_mode_t))
-        ucon64.parport_mode = PPMODE_SPP_BIDIR;
+      if (!UCON64_ISSET2 (ucon64_settings.parport_mode, parport_mode_t))
+        ucon64_settings.parport_mode = PPMODE_SPP_BIDIR;
 #endif
       // We don't really need the parallel port. We just have to make sure that
       //  privileges aren't dropped.
-      ucon64.parport_needed = 2;
+      ucon64_settings.parport_needed = 2;
       break;
 
     case UCON64_XCD64P:
@@ -434,7 +446,7 @@ ucon64_switches (st_ucon64_t *p)
     case UCON64_XFALM:
     case UCON64_XGBXM:
     case UCON64_XPLM:
-      ucon64.parport_mode = PPMODE_SPP_BIDIR;
+      ucon64_settings.parport_mode = PPMODE_SPP_BIDIR;
       break;
 
     case UCON64_XSWC_IO:
@@ -496,11 +508,11 @@ ucon64_switches (st_ucon64_t *p)
         any configuration root privileges are required. By default uCON64 will
         be installed setuid root (on UNIX), so we just have to make sure
         privileges will not be dropped. One way to do that is assigning 2 to
-        ucon64.parport_needed. A more appropriate way for USB devices is using
-        ucon64.usbport.
+        ucon64_settings.parport_needed. A more appropriate way for USB devices is using
+        ucon64_settings.usbport.
       */
-      if (!ucon64.usbport)
-        ucon64.usbport = 1;
+      if (!ucon64_settings.usbport)
+        ucon64_settings.usbport = 1;
       break;
 #endif // USE_USB
 
@@ -516,6 +528,10 @@ ucon64_switches (st_ucon64_t *p)
     case UCON64_PPF:
     case UCON64_NPPF:
     case UCON64_IDPPF:
+    case UCON64_UPPF:
+    case UCON64_BPS:
+    case UCON64_UPS:
+    case UCON64_PCATADD:
       if (!ucon64.file || !ucon64.file[0])
         ucon64.file = ucon64.argv[ucon64.argc - 1];
       break;
@@ -548,10 +564,10 @@ ucon64_switches (st_ucon64_t *p)
               {
                 // dirname2() strips trailing slashes and/or backslashes (if not
                 //  the root directory of a drive).
-                snprintf (ucon64.output_path, FILENAME_MAX, "%s%s", dir_name,
+                snprintf (ucon64_settings.output_path, FILENAME_MAX, "%s%s", dir_name,
                           dir_name[strlen (dir_name) - 1] != DIR_SEPARATOR ?
                             DIR_SEPARATOR_S : "");
-                ucon64.output_path[FILENAME_MAX - 1] = '\0';
+                ucon64_settings.output_path[FILENAME_MAX - 1] = '\0';
                 dir = 1;
               }
           }
@@ -688,12 +704,12 @@ ucon64_switches (st_ucon64_t *p)
 
     case UCON64_Q:
     case UCON64_QQ:                             // for now -qq is equivalent to -q
-      ucon64.quiet = 1;
+      ucon64_settings.quiet = 1;
       cm_verbose = 0;
       break;
 
     case UCON64_V:
-      ucon64.quiet = -1;
+      ucon64_settings.quiet = -1;
       cm_verbose = 1;
       break;
 
@@ -895,7 +911,8 @@ ucon64_options (st_ucon64_t *p)
       else
         fputc ('\n', stdout);
       checksum = 0;
-      ucon64_chksum (NULL, NULL, &checksum, ucon64.fname, ucon64.fsize, value);
+      ucon64_chksum (NULL, NULL, NULL, &checksum, ucon64.fname,
+                     ucon64.fsize, value, ucon64_settings.chksum_flags);
       printf ("Checksum (CRC32): 0x%08x\n", checksum);
       break;
 
@@ -908,7 +925,8 @@ ucon64_options (st_ucon64_t *p)
         printf (" (%s)\n", ucon64.fname_arch);
       else
         fputc ('\n', stdout);
-      ucon64_chksum (buf, NULL, NULL, ucon64.fname, ucon64.fsize, value);
+      ucon64_chksum (buf, NULL, NULL, NULL, ucon64.fname,
+                     ucon64.fsize, value, ucon64_settings.chksum_flags);
       printf ("Checksum (SHA1): 0x%s\n", buf);
       break;
 
@@ -921,10 +939,25 @@ ucon64_options (st_ucon64_t *p)
         printf (" (%s)\n", ucon64.fname_arch);
       else
         fputc ('\n', stdout);
-      ucon64_chksum (NULL, buf, NULL, ucon64.fname, ucon64.fsize, value);
+      ucon64_chksum (NULL, buf, NULL, NULL, ucon64.fname,
+                     ucon64.fsize, value, ucon64_settings.chksum_flags);
       printf ("Checksum (MD5): 0x%s\n", buf);
       break;
 
+    case UCON64_SHA256:
+      value = ucon64.nfo ? ucon64.nfo->backup_header_len :
+                UCON64_ISSET2 (ucon64.backup_header_len, unsigned int) ?
+                  ucon64.backup_header_len : 0;
+      fputs (ucon64.fname, stdout);
+      if (ucon64.fname_arch[0])
+        printf (" (%s)\n", ucon64.fname_arch);
+      else
+        fputc ('\n', stdout);
+      ucon64_chksum (NULL, NULL, buf, NULL, ucon64.fname,
+                     ucon64.fsize, value, ucon64_settings.chksum_flags);
+      printf ("Checksum (SHA-256): 0x%s\n", buf);
+      break;
+
     case UCON64_HEX:
       {
         uint64_t start, len;
@@ -975,6 +1008,10 @@ ucon64_options (st_ucon64_t *p)
                    strlen (option_arg), MEMCMP2_REL);
       break;
 
+    case UCON64_FINDRL:
+      ucon64_findr_list (ucon64.fname, 0, ucon64.fsize, option_arg);
+      break;
+
     case UCON64_FINDI:
       ucon64_find (ucon64.fname, 0, ucon64.fsize, option_arg,
                    strlen (option_arg), MEMCMP2_WCARD ('?') | MEMCMP2_CASE);
@@ -1204,6 +1241,28 @@ ucon64_options (st_ucon64_t *p)
       ppf_apply (ucon64.fname, ucon64.file);
       break;
 
+    case UCON64_UPPF:
+      ppf_undo (ucon64.fname, ucon64.file);
+      break;
+
+    case UCON64_BPS:
+      bps_apply (ucon64.fname, ucon64.file);
+      break;
+
+    case UCON64_UPS:
+      ups_apply (ucon64.fname, ucon64.file);
+      break;
+
+    case UCON64_PCAT:
+      if (pcat_apply (ucon64.fname, ucon64.file) == -1)
+        exit (1);
+      break;
+
+    case UCON64_PCATADD:
+      if (pcat_add (ucon64.fname, ucon64.file) == -1)
+        exit (1);
+      break;
+
     case UCON64_MKA:
       aps_create (option_arg, ucon64.fname);    // original, modified
       break;
@@ -1216,6 +1275,18 @@ ucon64_options (st_ucon64_t *p)
       ppf_create (option_arg, ucon64.fname);    // original, modified
       break;
 
+    case UCON64_MKPPF3:
+      ppf3_create (option_arg, ucon64.fname);   // original, modified
+      break;
+
+    case UCON64_MKBPS:
+      bps_create (option_arg, ucon64.fname);    // original, modified
+      break;
+
+    case UCON64_MKUPS:
+      ups_create (option_arg, ucon64.fname);    // original, modified
+      break;
+
     case UCON64_NA:
       aps_set_desc (ucon64.fname, option_arg);
       break;
@@ -1230,7 +1301,7 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_SCAN:
     case UCON64_LSD:
-      if (ucon64.dat_enabled)
+      if (ucon64_settings.dat_enabled)
         {
           if (ucon64.crc32)
             {
@@ -1251,7 +1322,7 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_LSV:
       if (ucon64.nfo)
-        ucon64_nfo ();
+        ucon64_nfo (&ucon64);
       break;
 
     case UCON64_LS:
@@ -1319,7 +1390,7 @@ ucon64_options (st_ucon64_t *p)
     case UCON64_ISOFIX:
     case UCON64_RIP:
     case UCON64_CDMAGE:
-      if (ucon64.discmage_enabled)
+      if (ucon64_settings.discmage_enabled)
         {
           uint32_t flags = 0;
 
@@ -1354,13 +1425,13 @@ ucon64_options (st_ucon64_t *p)
             }
         }
       else
-        printf (ucon64_msg[NO_LIB], ucon64.discmage_path);
+        printf (ucon64_msg[NO_LIB], ucon64_settings.discmage_path);
       break;
 
     case UCON64_MKTOC:
     case UCON64_MKCUE:
     case UCON64_MKSHEET:
-      if (ucon64.discmage_enabled && ucon64.image)
+      if (ucon64_settings.discmage_enabled && ucon64.image)
         {
           char fname[FILENAME_MAX];
           strcpy (fname, ((dm_image_t *) ucon64.image)->fname);
@@ -1388,11 +1459,11 @@ ucon64_options (st_ucon64_t *p)
             }
         }
       else
-        printf (ucon64_msg[NO_LIB], ucon64.discmage_path);
+        printf (ucon64_msg[NO_LIB], ucon64_settings.discmage_path);
       break;
 
     case UCON64_XCDRW:
-      if (ucon64.discmage_enabled)
+      if (ucon64_settings.discmage_enabled)
         {
 //          dm_set_gauge (&discmage_gauge);
           if (!access (ucon64.fname, F_OK))
@@ -1401,14 +1472,14 @@ ucon64_options (st_ucon64_t *p)
             dm_disc_read ((dm_image_t *) ucon64.image);
         }
       else
-        printf (ucon64_msg[NO_LIB], ucon64.discmage_path);
+        printf (ucon64_msg[NO_LIB], ucon64_settings.discmage_path);
       break;
 #endif // USE_DISCMAGE
 
     case UCON64_DB:
-      if (ucon64.quiet > -1)
+      if (ucon64_settings.quiet > -1)
         {
-          if (ucon64.dat_enabled)
+          if (ucon64_settings.dat_enabled)
             {
               ucon64_dat_view (ucon64.console, 0);
               printf ("TIP: %s " OPTION_LONG_S "db " OPTION_LONG_S "nes"
@@ -1421,7 +1492,7 @@ ucon64_options (st_ucon64_t *p)
         }
 
     case UCON64_DBV:
-      if (ucon64.dat_enabled)
+      if (ucon64_settings.dat_enabled)
         {
           ucon64_dat_view (ucon64.console, 1);
           printf ("TIP: %s " OPTION_LONG_S "dbv " OPTION_LONG_S "nes"
@@ -1433,16 +1504,16 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_DBS:
-      if (ucon64.dat_enabled)
+      if (ucon64_settings.dat_enabled)
         {
           ucon64.crc32 = 0;
           sscanf (option_arg, "%x", &ucon64.crc32);
 
-          if ((ucon64.dat = ucon64_dat_search (ucon64.crc32)) == NULL)
+          if ((ucon64.dat = ucon64_dat_search (ucon64.crc32, ucon64.console)) == NULL)
             {
               printf (ucon64_msg[DAT_NOT_FOUND], ucon64.crc32);
               printf ("TIP: Be sure to install the right DAT files in %s\n",
-                      ucon64.datdir);
+                      ucon64_settings.datdir);
             }
           else
             {
@@ -1627,7 +1698,7 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_FDSL:
-      nes_fdsl (ucon64.nfo, NULL);
+      nes_fdsl (&ucon64, ucon64.nfo, NULL);
       break;
 
     case UCON64_FFE:
@@ -1655,31 +1726,9 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_GG:
-      switch (ucon64.console)
-        {
-        case UCON64_GB:
-        case UCON64_GEN:
-        case UCON64_NES:
-        case UCON64_SMS:
-        case UCON64_SNES:
-          // ROM images for SNES (GD3) and Genesis (SMD) can be interleaved
-          if (ucon64.nfo->interleaved)
-            fputs ("ERROR: This ROM seems to be interleaved, but uCON64 will only apply a Game\n"
-                   "       Genie patch to non-interleaved ROMs. Convert to a non-interleaved\n"
-                   "       format\n", stderr);
-          else if (ucon64.console == UCON64_NES &&
-                   nes_get_file_type () != INES && nes_get_file_type () != FFE)
-            fputs ("ERROR: This NES ROM is in a format that uCON64 cannot apply a Game Genie patch\n"
-                   "       to. Convert to iNES\n", stderr);
-          else
-            gg_apply (ucon64.nfo, option_arg);
-          break;
-        default:
-          fputs ("ERROR: Cannot apply Game Genie code for this ROM/console\n", stderr);
-// the next msg has already been printed
-//          fputs (ucon64_msg[CONSOLE_ERROR], stderr);
-          return -1;
-        }
+      if (gg_check (ucon64.nfo) == -1)
+        return -1;
+      gg_apply (ucon64.nfo, option_arg);
       break;
 
     case UCON64_GGD:
@@ -1721,7 +1770,7 @@ ucon64_options (st_ucon64_t *p)
           genesis_j (ucon64.nfo);
           break;
         case UCON64_NES:
-          nes_j (NULL);
+          nes_j (&ucon64, NULL);
           break;
         case UCON64_SNES:
           snes_j (ucon64.nfo);
@@ -1870,6 +1919,10 @@ ucon64_options (st_ucon64_t *p)
       gb_n2gb (ucon64.nfo, option_arg);
       break;
 
+    case UCON64_N64LE:
+      n64_n64le (ucon64.nfo);
+      break;
+
     case UCON64_NROT:
       lynx_nrot (ucon64.nfo);
       break;
@@ -1882,6 +1935,11 @@ ucon64_options (st_ucon64_t *p)
       ucon64_pattern (option_arg);
       break;
 
+    case UCON64_PATCH_CHAIN:
+      if (patch_chain (ucon64.nfo, option_arg) == -1)
+        exit (1);
+      break;
+
     case UCON64_POKE:
       {
         size_t len = strnlen (option_arg, sizeof buf - 1);
@@ -2107,7 +2165,7 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_XCD64C:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
       cd64_read_rom (ucon64.fname, strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
@@ -2155,30 +2213,30 @@ ucon64_options (st_ucon64_t *p)
     case UCON64_XRESET:
       parport_print_info ();
       fputs ("Resetting parallel port...", stdout);
-      outportb (ucon64.parport + PARPORT_DATA, 0);
+      outportb (ucon64_settings.parport + PARPORT_DATA, 0);
       // Strobe, Auto Linefeed and Select Printer are hardware inverted, so we
       //  have to write a 1 to bring the associated pins in a low state (0V).
-      outportb (ucon64.parport + PARPORT_CONTROL,
-                (inportb (ucon64.parport + PARPORT_CONTROL) & 0xf0) | 0x0b);
+      outportb (ucon64_settings.parport + PARPORT_CONTROL,
+                (inportb (ucon64_settings.parport + PARPORT_CONTROL) & 0xf0) | 0x0b);
       puts ("done");
       break;
 
     case UCON64_XCMC:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
-      cmc_read_rom (ucon64.fname, ucon64.parport, ucon64.io_mode); // ucon64.io_mode contains speed value
+      cmc_read_rom (ucon64.fname, ucon64_settings.parport, ucon64.io_mode); // ucon64.io_mode contains speed value
       fputc ('\n', stdout);
       break;
 
     case UCON64_XCMCT:
-      cmc_test (strtol (option_arg, NULL, 10), ucon64.parport, ucon64.io_mode);
+      cmc_test (strtol (option_arg, NULL, 10), ucon64_settings.parport, ucon64.io_mode);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XDJR:
       if (access (ucon64.fname, F_OK) != 0)
         {
-          doctor64jr_read (ucon64.fname, ucon64.parport);
+          doctor64jr_read (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       else
@@ -2189,7 +2247,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else
             {
-              doctor64jr_write (ucon64.fname, ucon64.parport);
+              doctor64jr_write (ucon64.fname, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2197,9 +2255,9 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XFAL:
       if (access (ucon64.fname, F_OK) != 0)
-        fal_read_rom (ucon64.fname, ucon64.parport, 32);
+        fal_read_rom (ucon64.fname, ucon64_settings.parport, 32);
       else
-        fal_write_rom (ucon64.fname, ucon64.parport);
+        fal_write_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
@@ -2209,17 +2267,17 @@ ucon64_options (st_ucon64_t *p)
       register_func (remove_temp_file);
       // gba_multi() calls ucon64_file_handler() so the directory part will be
       //  stripped from src_name. The directory should be used though.
-      if (!ucon64.output_path[0])
+      if (!ucon64_settings.output_path[0])
         {
-          dirname2 (src_name, ucon64.output_path);
-          if (ucon64.output_path[strlen (ucon64.output_path) - 1] != DIR_SEPARATOR)
-            strcat (ucon64.output_path, DIR_SEPARATOR_S);
+          dirname2 (src_name, ucon64_settings.output_path);
+          if (ucon64_settings.output_path[strlen (ucon64_settings.output_path) - 1] != DIR_SEPARATOR)
+            strcat (ucon64_settings.output_path, DIR_SEPARATOR_S);
         }
       if (gba_multi (strtol (option_arg, NULL, 10) * MBIT, src_name) == 0)
         { // don't try to start a transfer if there was a problem
           fputc ('\n', stdout);
           ucon64.fsize = fsizeof (src_name);
-          fal_write_rom (src_name, ucon64.parport);
+          fal_write_rom (src_name, ucon64_settings.parport);
         }
 
       unregister_func (remove_temp_file);
@@ -2228,27 +2286,27 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_XFALC:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
-      fal_read_rom (ucon64.fname, ucon64.parport,
+      fal_read_rom (ucon64.fname, ucon64_settings.parport,
                     strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
       break;
 
     case UCON64_XFALS:
       if (access (ucon64.fname, F_OK) != 0)
-        fal_read_sram (ucon64.fname, ucon64.parport, UCON64_UNKNOWN);
+        fal_read_sram (ucon64.fname, ucon64_settings.parport, UCON64_UNKNOWN);
       else
-        fal_write_sram (ucon64.fname, ucon64.parport, UCON64_UNKNOWN);
+        fal_write_sram (ucon64.fname, ucon64_settings.parport, UCON64_UNKNOWN);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XFALB:
       if (access (ucon64.fname, F_OK) != 0)
-        fal_read_sram (ucon64.fname, ucon64.parport,
+        fal_read_sram (ucon64.fname, ucon64_settings.parport,
                        strtol (option_arg, NULL, 10));
       else
-        fal_write_sram (ucon64.fname, ucon64.parport,
+        fal_write_sram (ucon64.fname, ucon64_settings.parport,
                         strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
       break;
@@ -2256,7 +2314,7 @@ ucon64_options (st_ucon64_t *p)
     case UCON64_XFIG:
       if (access (ucon64.fname, F_OK) != 0)       // file does not exist => dump cartridge
         {
-          fig_read_rom (ucon64.fname, ucon64.parport);
+          fig_read_rom (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       else
@@ -2270,7 +2328,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else // file exists => send it to the copier
             {
-              fig_write_rom (ucon64.fname, ucon64.parport);
+              fig_write_rom (ucon64.fname, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2278,42 +2336,42 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XFIGS:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        fig_read_sram (ucon64.fname, ucon64.parport);
+        fig_read_sram (ucon64.fname, ucon64_settings.parport);
       else                                      // file exists => restore SRAM
-        fig_write_sram (ucon64.fname, ucon64.parport);
+        fig_write_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XFIGC:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump cart SRAM contents
-        fig_read_cart_sram (ucon64.fname, ucon64.parport);
+        fig_read_cart_sram (ucon64.fname, ucon64_settings.parport);
       else                                      // file exists => restore SRAM
-        fig_write_cart_sram (ucon64.fname, ucon64.parport);
+        fig_write_cart_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGBX:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump cartridge/flash card
-        gbx_read_rom (ucon64.fname, ucon64.parport);
+        gbx_read_rom (ucon64.fname, ucon64_settings.parport);
       else                                      // file exists => send it to the programmer
-        gbx_write_rom (ucon64.fname, ucon64.parport);
+        gbx_write_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGBXS:
       if (access (ucon64.fname, F_OK) != 0)
-        gbx_read_sram (ucon64.fname, ucon64.parport, -1);
+        gbx_read_sram (ucon64.fname, ucon64_settings.parport, -1);
       else
-        gbx_write_sram (ucon64.fname, ucon64.parport, -1);
+        gbx_write_sram (ucon64.fname, ucon64_settings.parport, -1);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGBXB:
       if (access (ucon64.fname, F_OK) != 0)
-        gbx_read_sram (ucon64.fname, ucon64.parport,
+        gbx_read_sram (ucon64.fname, ucon64_settings.parport,
                        strtol (option_arg, NULL, 10));
       else
-        gbx_write_sram (ucon64.fname, ucon64.parport,
+        gbx_write_sram (ucon64.fname, ucon64_settings.parport,
                         strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
       break;
@@ -2321,7 +2379,7 @@ ucon64_options (st_ucon64_t *p)
     case UCON64_XGD3:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump cartridge
         {
-          gd3_read_rom (ucon64.fname, ucon64.parport); // dumping is not yet supported
+          gd3_read_rom (ucon64.fname, ucon64_settings.parport); // dumping is not yet supported
           fputc ('\n', stdout);
         }
       else
@@ -2331,7 +2389,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else                                  // file exists => send it to the copier
             {
-              gd3_write_rom (ucon64.fname, ucon64.parport, ucon64.nfo);
+              gd3_write_rom (ucon64.fname, ucon64_settings.parport, ucon64.nfo);
               fputc ('\n', stdout);
             }
         }
@@ -2339,24 +2397,24 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XGD3S:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        gd3_read_sram (ucon64.fname, ucon64.parport); // dumping is not yet supported
+        gd3_read_sram (ucon64.fname, ucon64_settings.parport); // dumping is not yet supported
       else                                      // file exists => restore SRAM
-        gd3_write_sram (ucon64.fname, ucon64.parport);
+        gd3_write_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGD3R:
       if (access (ucon64.fname, F_OK) != 0)
-        gd3_read_saver (ucon64.fname, ucon64.parport);
+        gd3_read_saver (ucon64.fname, ucon64_settings.parport);
       else
-        gd3_write_saver (ucon64.fname, ucon64.parport);
+        gd3_write_saver (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGD6:
       if (access (ucon64.fname, F_OK) != 0)
         {
-          gd6_read_rom (ucon64.fname, ucon64.parport);
+          gd6_read_rom (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       else
@@ -2366,7 +2424,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else
             {
-              gd6_write_rom (ucon64.fname, ucon64.parport, ucon64.nfo);
+              gd6_write_rom (ucon64.fname, ucon64_settings.parport, ucon64.nfo);
               fputc ('\n', stdout);
             }
         }
@@ -2374,24 +2432,24 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XGD6S:
       if (access (ucon64.fname, F_OK) != 0)
-        gd6_read_sram (ucon64.fname, ucon64.parport);
+        gd6_read_sram (ucon64.fname, ucon64_settings.parport);
       else
-        gd6_write_sram (ucon64.fname, ucon64.parport);
+        gd6_write_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGD6R:
       if (access (ucon64.fname, F_OK) != 0)
-        gd6_read_saver (ucon64.fname, ucon64.parport);
+        gd6_read_saver (ucon64.fname, ucon64_settings.parport);
       else
-        gd6_write_saver (ucon64.fname, ucon64.parport);
+        gd6_write_saver (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGG:
       if (access (ucon64.fname, F_OK) != 0)
         {
-          smsgg_read_rom (ucon64.fname, ucon64.parport, 32 * MBIT);
+          smsgg_read_rom (ucon64.fname, ucon64_settings.parport, 32 * MBIT);
           fputc ('\n', stdout);
         }
       else
@@ -2405,7 +2463,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else
             {
-              smsgg_write_rom (ucon64.fname, ucon64.parport);
+              smsgg_write_rom (ucon64.fname, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2413,50 +2471,50 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XGGS:
       if (access (ucon64.fname, F_OK) != 0)
-        smsgg_read_sram (ucon64.fname, ucon64.parport, -1);
+        smsgg_read_sram (ucon64.fname, ucon64_settings.parport, -1);
       else
-        smsgg_write_sram (ucon64.fname, ucon64.parport, -1);
+        smsgg_write_sram (ucon64.fname, ucon64_settings.parport, -1);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XGGB:
       if (access (ucon64.fname, F_OK) != 0)
-        smsgg_read_sram (ucon64.fname, ucon64.parport,
+        smsgg_read_sram (ucon64.fname, ucon64_settings.parport,
                          strtol (option_arg, NULL, 10));
       else
-        smsgg_write_sram (ucon64.fname, ucon64.parport,
+        smsgg_write_sram (ucon64.fname, ucon64_settings.parport,
                           strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
       break;
 
     case UCON64_XIC2:
-      smcic2_write_rom (ucon64.fname, ucon64.parport);
+      smcic2_write_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XLIT:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
-      lynxit_read_rom (ucon64.fname, ucon64.parport);
+      lynxit_read_rom (ucon64.fname, ucon64_settings.parport);
       break;
 
     case UCON64_XMCCL:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
-      mccl_read (ucon64.fname, ucon64.parport);
+      mccl_read (ucon64.fname, ucon64_settings.parport);
       break;
 
     case UCON64_XMCD:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
-      mcd_read_rom (ucon64.fname, ucon64.parport);
+      mcd_read_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XMD:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump flash card
         {
-          md_read_rom (ucon64.fname, ucon64.parport, 64 * MBIT); // reads 32 Mbit if Sharp card
+          md_read_rom (ucon64.fname, ucon64_settings.parport, 64 * MBIT); // reads 32 Mbit if Sharp card
           fputc ('\n', stdout);
         }
       else                                      // file exists => send it to the MD-PRO
@@ -2464,13 +2522,13 @@ ucon64_options (st_ucon64_t *p)
           if (ucon64.nfo->backup_header_len)    // binary with header is possible
             fputs ("ERROR: This ROM has a header. Remove it with " OPTION_LONG_S "stp or " OPTION_LONG_S "bin\n",
                    stderr);
-          else if (genesis_get_copier_type () != BIN)
+          else if (genesis_get_copier_type (&ucon64) != BIN)
             fputs ("ERROR: This ROM is not in binary/BIN/RAW format. uCON64 only supports sending\n"
                    "       binary files to the MD-PRO. Convert ROM with " OPTION_LONG_S "bin\n",
                    stderr);
           else
             {
-              md_write_rom (ucon64.fname, ucon64.parport);
+              md_write_rom (ucon64.fname, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2478,18 +2536,18 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XMDS:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        md_read_sram (ucon64.fname, ucon64.parport, -1);
+        md_read_sram (ucon64.fname, ucon64_settings.parport, -1);
       else                                      // file exists => restore SRAM
-        md_write_sram (ucon64.fname, ucon64.parport, -1);
+        md_write_sram (ucon64.fname, ucon64_settings.parport, -1);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XMDB:
       if (access (ucon64.fname, F_OK) != 0)
-        md_read_sram (ucon64.fname, ucon64.parport,
+        md_read_sram (ucon64.fname, ucon64_settings.parport,
                       strtol (option_arg, NULL, 10));
       else
-        md_write_sram (ucon64.fname, ucon64.parport,
+        md_write_sram (ucon64.fname, ucon64_settings.parport,
                        strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
       break;
@@ -2497,7 +2555,7 @@ ucon64_options (st_ucon64_t *p)
     case UCON64_XMSG:
       if (access (ucon64.fname, F_OK) != 0)
         {
-          msg_read_rom (ucon64.fname, ucon64.parport);
+          msg_read_rom (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       else
@@ -2511,7 +2569,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else
             {
-              msg_write_rom (ucon64.fname, ucon64.parport);
+              msg_write_rom (ucon64.fname, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2519,38 +2577,38 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XPCE:
       if (access (ucon64.fname, F_OK) != 0)
-        pce_read_rom (ucon64.fname, ucon64.parport, 32 * MBIT);
+        pce_read_rom (ucon64.fname, ucon64_settings.parport, 32 * MBIT);
       else
-        pce_write_rom (ucon64.fname, ucon64.parport);
+        pce_write_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XPL:
       if (access (ucon64.fname, F_OK) != 0)
-        pl_read_rom (ucon64.fname, ucon64.parport);
+        pl_read_rom (ucon64.fname, ucon64_settings.parport);
       else
-        pl_write_rom (ucon64.fname, ucon64.parport);
+        pl_write_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XPLI:
-      pl_info (ucon64.parport);
+      pl_info (ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XSF:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump flash card
-        sf_read_rom (ucon64.fname, ucon64.parport, 64 * MBIT);
+        sf_read_rom (ucon64.fname, ucon64_settings.parport, 64 * MBIT);
       else                                      // file exists => send it to the Super Flash
-        sf_write_rom (ucon64.fname, ucon64.parport);
+        sf_write_rom (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XSFS:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        sf_read_sram (ucon64.fname, ucon64.parport);
+        sf_read_sram (ucon64.fname, ucon64_settings.parport);
       else                                      // file exists => restore SRAM
-        sf_write_sram (ucon64.fname, ucon64.parport);
+        sf_write_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
@@ -2560,23 +2618,23 @@ ucon64_options (st_ucon64_t *p)
                stderr);
       else
         {
-          smc_write_rom (ucon64.fname, ucon64.parport);
+          smc_write_rom (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       break;
 
     case UCON64_XSMCR:
       if (access (ucon64.fname, F_OK) != 0)
-        smc_read_rts (ucon64.fname, ucon64.parport);
+        smc_read_rts (ucon64.fname, ucon64_settings.parport);
       else
-        smc_write_rts (ucon64.fname, ucon64.parport);
+        smc_write_rts (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XSMD:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump cartridge
         {
-          smd_read_rom (ucon64.fname, ucon64.parport);
+          smd_read_rom (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       else                                      // file exists => send it to the copier
@@ -2590,7 +2648,7 @@ ucon64_options (st_ucon64_t *p)
                    stderr);
           else
             {
-              smd_write_rom (ucon64.fname, ucon64.parport);
+              smd_write_rom (ucon64.fname, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2598,9 +2656,9 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XSMDS:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        smd_read_sram (ucon64.fname, ucon64.parport);
+        smd_read_sram (ucon64.fname, ucon64_settings.parport);
       else                                      // file exists => restore SRAM
-        smd_write_sram (ucon64.fname, ucon64.parport);
+        smd_write_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
@@ -2609,7 +2667,7 @@ ucon64_options (st_ucon64_t *p)
     case UCON64_XSWC2:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump cartridge
         {
-          swc_read_rom (ucon64.fname, ucon64.parport, ucon64.io_mode);
+          swc_read_rom (ucon64.fname, ucon64_settings.parport, ucon64.io_mode);
           fputc ('\n', stdout);
         }
       else
@@ -2626,7 +2684,7 @@ ucon64_options (st_ucon64_t *p)
               if (enableRTS != 0)
                 enableRTS = 1;
               // file exists => send it to the copier
-              swc_write_rom (ucon64.fname, ucon64.parport, enableRTS);
+              swc_write_rom (ucon64.fname, ucon64_settings.parport, enableRTS);
               fputc ('\n', stdout);
             }
         }
@@ -2634,32 +2692,32 @@ ucon64_options (st_ucon64_t *p)
 
     case UCON64_XSWCS:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        swc_read_sram (ucon64.fname, ucon64.parport);
+        swc_read_sram (ucon64.fname, ucon64_settings.parport);
       else                                      // file exists => restore SRAM
-        swc_write_sram (ucon64.fname, ucon64.parport);
+        swc_write_sram (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XSWCC:
       if (access (ucon64.fname, F_OK) != 0)     // file does not exist => dump SRAM contents
-        swc_read_cart_sram (ucon64.fname, ucon64.parport, ucon64.io_mode);
+        swc_read_cart_sram (ucon64.fname, ucon64_settings.parport, ucon64.io_mode);
       else                                      // file exists => restore SRAM
-        swc_write_cart_sram (ucon64.fname, ucon64.parport, ucon64.io_mode);
+        swc_write_cart_sram (ucon64.fname, ucon64_settings.parport, ucon64.io_mode);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XSWCR:
       if (access (ucon64.fname, F_OK) != 0)
-        swc_read_rts (ucon64.fname, ucon64.parport);
+        swc_read_rts (ucon64.fname, ucon64_settings.parport);
       else
-        swc_write_rts (ucon64.fname, ucon64.parport);
+        swc_write_rts (ucon64.fname, ucon64_settings.parport);
       fputc ('\n', stdout);
       break;
 
     case UCON64_XV64:
       if (access (ucon64.fname, F_OK) != 0)
         {
-          doctor64_read (ucon64.fname, ucon64.parport);
+          doctor64_read (ucon64.fname, ucon64_settings.parport);
           fputc ('\n', stdout);
         }
       else
@@ -2671,7 +2729,7 @@ ucon64_options (st_ucon64_t *p)
           else
             {
               doctor64_write (ucon64.fname, ucon64.nfo->backup_header_len,
-                              (int) ucon64.fsize, ucon64.parport);
+                              (int) ucon64.fsize, ucon64_settings.parport);
               fputc ('\n', stdout);
             }
         }
@@ -2693,7 +2751,7 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_XF2AC:
-      if (!access (ucon64.fname, F_OK) && ucon64.backup)
+      if (!access (ucon64.fname, F_OK) && ucon64_settings.backup)
         printf ("Wrote backup to %s\n", mkbak (ucon64.fname, BAK_MOVE));
       f2a_read_rom (ucon64.fname, strtol (option_arg, NULL, 10));
       fputc ('\n', stdout);
@@ -2730,7 +2788,7 @@ ucon64_options (st_ucon64_t *p)
       break;
 
     case UCON64_XUFOSD:
-      if (snes_get_copier_type () != UFOSD)
+      if (snes_get_copier_type (&ucon64) != UFOSD)
         fputs ("ERROR: This ROM is not in Super UFO Pro 8 SD format. Convert with " OPTION_LONG_S "ufosd\n",
                stderr);
       else if (ucon64.nfo->interleaved)